@@ -36,6 +36,22 @@ extern "C" {
 #define PD_SCK_FRONT 17
 #define DOUT_FRONT 18
 
+// IMU (MPU-9250, I2C)
+#define PIN_IMU_SDA             1
+#define PIN_IMU_SCL             2
+#define PIN_IMU_INT             5   // Data-ready interrupt (push-pull, active high)
+
+// GPS (NEO-M8N, UART1)
+#define PIN_GPS_TX              6   // ESP32 TX -> GPS RX
+#define PIN_GPS_RX              7   // ESP32 RX <- GPS TX
+#define PIN_GPS_PPS             15  // Timepulse, rising edge = UTC second
+
+// LTE Modem (SimCom A7682S, UART2)
+#define PIN_MODEM_TX            39  // ESP32 TX -> Modem RXD
+#define PIN_MODEM_RX            40  // ESP32 RX <- Modem TXD
+#define PIN_MODEM_DTR           41  // High = modem may sleep (AT+CSCLK=1)
+#define PIN_MODEM_RI            42  // Ring indicator, pulses low on incoming data
+
 // ==========================================================
 // 2. POWER SYSTEM (2S LiPo)
 #define BATTERY_MAX_V   8.4f  ///< Fully charged (4.2V/cell × 2)
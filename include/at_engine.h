@@ -0,0 +1,302 @@
+/**
+ * @file at_engine.h
+ * @brief Non-blocking AT Command Engine (pure, host-testable)
+ * @details
+ * - RX bytes land in a ring buffer (the UART driver reads straight into
+ *   the ring's free space; see at_engine_rx_reserve()).
+ * - Incremental tokenizer: lines are handed out as spans pointing into the
+ *   ring (at most 2 pieces when wrapping), never copied.
+ * - Command queue: one command in flight, per-command timeout, optional
+ *   response prefix matcher, optional completion prefix for commands that
+ *   report their real result asynchronously after OK (e.g. +CMQTTPUB: 0,0).
+ * - Data prompt ('>') handling for commands that carry a payload.
+ * - Resync after a timeout: the modem may still answer the timed-out
+ *   command, so AT_SYNC_CMD goes out before the next command and every
+ *   final result (OK / ERROR) is dropped until its AT_SYNC_REPLY + OK
+ *   arrive (echo is off, there is no echo to line up on).
+ * - URC dispatch by prefix, and raw mode for length-prefixed binary blocks
+ *   (+CMQTTRXTOPIC / +CMQTTRXPAYLOAD / +HTTPREAD).
+ *
+ * The engine is single-threaded: all calls come from the modem task.
+ * Time is passed in by the caller, nothing here blocks or sleeps.
+ * tools/modem_sim.c runs it against a scripted fake modem.
+ */
+
+#ifndef AT_ENGINE_H
+#define AT_ENGINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define AT_RX_RING_SIZE         2048        // Must be a power of 2
+#define AT_CMD_QUEUE_LEN        8
+#define AT_CMD_MAX_LEN          128         // Command text incl. parameters
+#define AT_MAX_URC_HANDLERS     12
+#define AT_DEFAULT_TIMEOUT_MS   1000
+#define AT_SYNC_CMD             "ATS3?"     // Resync marker (V.250: line terminator code)
+#define AT_SYNC_REPLY           "013"       // Its information line
+#define AT_SYNC_TIMEOUT_MS      500         // No reply: send the marker again
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Zero-copy view of bytes in the RX ring (2 pieces if wrapped)
+ */
+typedef struct {
+    const uint8_t *p[2];
+    uint16_t n[2];
+} at_span_t;
+
+/**
+ * @brief Command outcome
+ */
+typedef enum {
+    AT_RESULT_OK = 0,
+    AT_RESULT_ERROR,            // ERROR / +CME ERROR / +CMS ERROR
+    AT_RESULT_TIMEOUT,
+    AT_RESULT_FLUSHED,          // Dropped by at_engine_flush()
+} at_result_t;
+
+/**
+ * @brief Line callback (command response or URC)
+ * @param line Line contents without CR/LF (valid only during the call)
+ * @param ctx  User context
+ */
+typedef void (*at_line_cb_t)(const at_span_t *line, void *ctx);
+
+/**
+ * @brief Command completion callback
+ * @param result Outcome
+ * @param ctx    User context
+ */
+typedef void (*at_done_cb_t)(at_result_t result, void *ctx);
+
+/**
+ * @brief Raw block callback (called once per contiguous chunk)
+ * @param data   Chunk inside the ring
+ * @param len    Chunk length
+ * @param offset Offset of chunk in the block
+ * @param total  Block length
+ * @param ctx    User context
+ */
+typedef void (*at_raw_cb_t)(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx);
+
+/**
+ * @brief UART write hook
+ * @return Number of bytes accepted
+ */
+typedef size_t (*at_write_fn_t)(const uint8_t *data, size_t len, void *io_ctx);
+
+/**
+ * @brief Command descriptor (copied into the queue on submit)
+ */
+typedef struct {
+    char cmd[AT_CMD_MAX_LEN];   // Command without terminator (e.g. "AT+CSQ")
+    const uint8_t *data;        // Payload sent after the '>' prompt (NULL = none), must outlive the command
+    uint16_t data_len;
+    const char *match;          // Response prefix passed to on_line (NULL = none)
+    const char *done_prefix;    // Line that completes the command after OK (NULL = OK completes)
+    uint32_t timeout_ms;        // 0 = AT_DEFAULT_TIMEOUT_MS
+    at_line_cb_t on_line;
+    at_done_cb_t on_done;
+    void *ctx;
+} at_cmd_t;
+
+/**
+ * @brief URC handler table entry
+ */
+typedef struct {
+    const char *prefix;
+    at_line_cb_t cb;
+    void *ctx;
+} at_urc_handler_t;
+
+/**
+ * @brief Engine statistics
+ */
+typedef struct {
+    uint32_t rx_bytes;
+    uint32_t lines;
+    uint32_t urcs;
+    uint32_t unhandled;         // Lines nobody claimed
+    uint32_t rx_overflows;      // Bytes dropped (ring full)
+    uint32_t cmds_ok;
+    uint32_t cmds_error;
+    uint32_t cmds_timeout;
+    uint32_t queue_full;        // Rejected submits
+    uint32_t resyncs;           // Sync markers sent
+    uint32_t stale_results;     // Late OK / ERROR dropped while resyncing
+    uint32_t latency_last_us;   // Command sent -> completed
+    uint32_t latency_max_us;
+    uint64_t latency_total_us;
+} at_stats_t;
+
+/**
+ * @brief Engine state
+ */
+typedef struct {
+    // RX ring (free-running indices, masked on access)
+    uint8_t ring[AT_RX_RING_SIZE];
+    uint32_t head;              // Write position
+    uint32_t tail;              // Start of the unconsumed line
+    uint32_t scan;              // Tokenizer position (tail <= scan <= head)
+
+    // Raw block mode
+    at_raw_cb_t raw_cb;
+    void *raw_ctx;
+    uint32_t raw_total;
+    uint32_t raw_done;
+
+    // Command queue
+    at_cmd_t queue[AT_CMD_QUEUE_LEN];
+    uint8_t q_head;
+    uint8_t q_count;
+    bool cmd_active;            // queue[q_head] has been sent
+    bool cmd_got_ok;
+    bool cmd_data_sent;
+    int64_t cmd_sent_us;
+    int64_t cmd_deadline_us;
+
+    // Resync after a timeout
+    bool resync;                // Late results possible: sync before the next command
+    bool sync_active;           // AT_SYNC_CMD sent
+    bool sync_seen;             // AT_SYNC_REPLY received
+    int64_t sync_deadline_us;
+
+    // URC handlers
+    at_urc_handler_t urc[AT_MAX_URC_HANDLERS];
+    uint8_t urc_count;
+
+    // IO
+    at_write_fn_t write;
+    void *io_ctx;
+
+    at_stats_t stats;
+} at_engine_t;
+
+/*----------------------------------------
+            SPAN HELPERS
+  ----------------------------------------*/
+
+/**
+ * @brief Total span length
+ */
+uint16_t at_span_len(const at_span_t *s);
+
+/**
+ * @brief Compare span start with a C string
+ */
+bool at_span_starts_with(const at_span_t *s, const char *prefix);
+
+/**
+ * @brief Compare span with a C string
+ */
+bool at_span_equals(const at_span_t *s, const char *str);
+
+/**
+ * @brief Copy (part of) a span into a NUL-terminated string
+ * @return Number of characters copied
+ */
+size_t at_span_copy(const at_span_t *s, uint16_t offset, char *out, size_t out_size);
+
+/**
+ * @brief Parse the n-th comma separated integer after the ':' (0-based)
+ * @details "+CMQTTRXSTART: 0,12,40" with field 2 -> 40
+ * @return false if the field does not exist or is not a number
+ */
+bool at_span_get_int(const at_span_t *s, uint8_t field, int32_t *out);
+
+/*----------------------------------------
+            ENGINE API
+  ----------------------------------------*/
+
+/**
+ * @brief Reset engine state
+ * @param eng    Engine
+ * @param write  UART write hook
+ * @param io_ctx Write hook context
+ */
+void at_engine_init(at_engine_t *eng, at_write_fn_t write, void *io_ctx);
+
+/**
+ * @brief Contiguous free space in the RX ring (for zero-copy reads)
+ * @param eng Engine
+ * @param buf Output pointer to free space
+ * @return Number of bytes that may be written at *buf
+ */
+size_t at_engine_rx_reserve(at_engine_t *eng, uint8_t **buf);
+
+/**
+ * @brief Publish bytes written into the reserved space
+ * @param eng Engine
+ * @param len Number of bytes written (<= reserved)
+ */
+void at_engine_rx_commit(at_engine_t *eng, size_t len);
+
+/**
+ * @brief Copy bytes into the RX ring (drops and counts on overflow)
+ * @param eng  Engine
+ * @param data Received bytes
+ * @param len  Number of bytes
+ */
+void at_engine_feed(at_engine_t *eng, const uint8_t *data, size_t len);
+
+/**
+ * @brief Tokenize pending RX, dispatch lines, handle timeouts, send next command
+ * @param eng    Engine
+ * @param now_us Current time (us)
+ */
+void at_engine_poll(at_engine_t *eng, int64_t now_us);
+
+/**
+ * @brief Queue a command
+ * @param eng Engine
+ * @param cmd Command (copied)
+ * @return false if the queue is full
+ */
+bool at_engine_submit(at_engine_t *eng, const at_cmd_t *cmd);
+
+/**
+ * @brief Register a URC handler (matched by prefix, first match wins)
+ * @return false if the table is full
+ */
+bool at_engine_register_urc(at_engine_t *eng, const char *prefix, at_line_cb_t cb, void *ctx);
+
+/**
+ * @brief Treat the next `len` RX bytes as a raw block
+ * @details Call from a URC/line callback that announces a binary block.
+ * @param eng Engine
+ * @param len Block length
+ * @param cb  Chunk callback
+ * @param ctx Callback context
+ */
+void at_engine_expect_raw(at_engine_t *eng, size_t len, at_raw_cb_t cb, void *ctx);
+
+/**
+ * @brief Drop all queued commands (their on_done gets AT_RESULT_FLUSHED)
+ * @param eng Engine
+ */
+void at_engine_flush(at_engine_t *eng);
+
+/**
+ * @brief Check whether the engine has work in flight
+ * @return true if a command is queued or active, or a resync is running
+ */
+bool at_engine_busy(const at_engine_t *eng);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // AT_ENGINE_H
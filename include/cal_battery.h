@@ -27,11 +27,10 @@ extern "C" {
 // Voltage Divider Config (Measured values)
 #define R1_VAL          22300.0f           // 22kΩ
 #define R2_VAL          3340.0f            // 3.3kΩ
-#define VOLT_DIV_RATIO  7.6766f            // (R1+R2)/R2
+// Divider ratio (R1+R2)/R2: runtime parameter batt_div_ratio (sys_param.h)
 
-// EMA Filter Coefficient
+// EMA Filter Coefficient: runtime parameter batt_ema_alpha (sys_param.h)
 // Tác dụng: Loại bỏ nhiễu sụt áp khi động cơ tăng tốc đột ngột.
-#define EMA_ALPHA       0.05f
 
 
 /**
@@ -44,6 +43,14 @@ extern "C" {
  */
 void battery_init(void);
 
+/**
+ * @brief Release the ADC unit and calibration scheme
+ * 
+ * Powers the SAR ADC down (or lets the ULP claim it in standby).
+ * battery_init() brings it back; the EMA filter state is kept.
+ */
+void battery_deinit(void);
+
 /**
  * @brief Read battery voltage with noise filtering
  * 
@@ -58,6 +65,14 @@ void battery_init(void);
  */
 float battery_get_voltage(void);
 
+/**
+ * @brief Get the time of the last successful voltage reading
+ * 
+ * @return systime_now_us() at the middle of the oversampling window,
+ *         0 if no reading succeeded yet
+ */
+int64_t battery_get_sample_time_us(void);
+
 /**
  * @brief Calculate battery percentage from voltage
  * 
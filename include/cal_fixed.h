@@ -0,0 +1,96 @@
+/**
+ * @file cal_fixed.h
+ * @brief Fixed-Point (Q-format) Sensor Conversion Helpers
+ * @details
+ * Integer-only conversion and filtering for the load-cell and battery
+ * paths, so they can run where the FPU is off limits (ISRs) and avoid the
+ * slow float divide on the ESP32-S3:
+ *
+ * - Division by a calibration constant becomes a multiply by its
+ *   reciprocal, prepared once as mul / 2^shift with mul in [2^30, 2^31)
+ *   rounded up (31 significant bits, relative error < 2^-30).
+ * - Gains and EMA weights are Q16 (value * 65536).
+ *
+ * Setup functions (fx_*_init, fx_q16_from_float) use float and belong in
+ * task context; the others are integer only and placed in IRAM.
+ *
+ * SENSOR_FIXED_POINT selects the path used by loadcell_get_weight() and
+ * battery_get_voltage() at build time. It defaults to the float reference
+ * until the fixed path has been timed on target (tools/fixed_bench.c only
+ * measures the host); build with -DSENSOR_FIXED_POINT=1 to use it.
+ */
+
+#ifndef CAL_FIXED_H
+#define CAL_FIXED_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#ifndef SENSOR_FIXED_POINT
+#define SENSOR_FIXED_POINT      0           // 1 = Q-format sensor conversions, 0 = float
+#endif
+
+#define FX_Q16_SHIFT            16
+#define FX_Q16_ONE              (1 << FX_Q16_SHIFT)
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Reciprocal of a constant: x / d == (x * mul) >> shift
+ */
+typedef struct {
+    int32_t mul;                // Signed, |mul| in [2^30, 2^31)
+    uint8_t shift;              // 0 = not initialized (apply returns 0)
+} fx_recip_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Prepare the reciprocal of a divisor (task context)
+ * @param r Output
+ * @param divisor Non-zero, |divisor| in [2^-30, 2^30]
+ * @return false if the divisor is out of range (r cleared)
+ */
+bool fx_recip_init(fx_recip_t *r, float divisor);
+
+/**
+ * @brief x / divisor, truncated toward zero like the (int32_t) float cast
+ * @note Exact for integer divisors and |x| < 2^30; otherwise within one
+ *       unit of the true quotient (only when it lies within 2^-30 of an integer).
+ */
+int32_t fx_recip_apply(const fx_recip_t *r, int32_t x);
+
+/**
+ * @brief Round a float to Q16 (task context), saturating to the int32 range
+ */
+int32_t fx_q16_from_float(float x);
+
+/**
+ * @brief x * k, with k in Q16, rounded to nearest (ties away from zero)
+ */
+int32_t fx_mul_q16(int32_t x, int32_t k_q16);
+
+/**
+ * @brief One EMA step: y + alpha * (x - y), alpha in Q16, rounded to nearest
+ * @note The filter stops short of a constant input by less than
+ *       FX_Q16_ONE / (2 * alpha_q16) units (rounding dead band).
+ */
+int32_t fx_ema_q16(int32_t y, int32_t x, int32_t alpha_q16);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAL_FIXED_H
@@ -0,0 +1,147 @@
+/**
+ * @file cal_magnetometer.h
+ * @brief Magnetometer Calibration & Motor EMI Compensation
+ * @details
+ * - Online hard/soft-iron ellipsoid fit (general quadric, trace-normalized).
+ *   Each sample only updates the normal equations (constant cost, static
+ *   memory); the 9x9 solve runs every MAGCAL_SOLVE_EVERY samples.
+ * - Throttle-indexed compensation table: learns the field offset induced by
+ *   ESC/motor current as a function of the left/right commands sent through
+ *   motor_set_speed(), and subtracts it (bilinear interpolation) in real time.
+ * - Tilt-compensated heading using the gravity vector.
+ *
+ * Pipeline: raw (uT) -> hard/soft iron -> throttle offset -> heading
+ *
+ * tools/magcal_sim.c reports the residual heading error on synthetic
+ * distorted data.
+ */
+
+#ifndef CAL_MAGNETOMETER_H
+#define CAL_MAGNETOMETER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// Ellipsoid fit
+#define MAGCAL_NORM_UT          50.0f       // Samples scaled by this before fitting (conditioning)
+#define MAGCAL_MIN_SAMPLES      200         // Samples required before first solve
+#define MAGCAL_SOLVE_EVERY      100         // Re-solve period (samples)
+#define MAGCAL_WINDOW           5000        // Accumulators halved when reached (slow forgetting)
+#define MAGCAL_FIELD_MIN_UT     15.0f       // Plausible Earth field range
+#define MAGCAL_FIELD_MAX_UT     100.0f
+#define MAGCAL_MAX_AXIS_RATIO   3.0f        // Reject fits with extreme soft-iron distortion
+#define MAGCAL_MIN_SPREAD_UT    7.0f        // Min sample std along any direction (~+-25 deg of roll/pitch)
+
+// Throttle compensation table
+// Bins span |command - MOTOR_IDLE_RAW| = 0 .. 5000 for each motor.
+// ESC supply current flows the same way in forward and reverse, so only the magnitude is used.
+#define MAGCAL_THR_BINS         5
+#define MAGCAL_THR_LEARN_ALPHA  0.05f       // EMA rate when learning offsets
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Calibration state
+ * @note ~1.2KB, intended as a static/global object.
+ */
+typedef struct {
+    // Normal equations of the quadric fit (upper triangle of D'D, packed) and D'r (r = -z^2)
+    double ata[45];
+    double atb[9];
+    uint32_t sample_count;          // Samples in accumulators
+    uint32_t since_solve;           // Samples since last solve
+
+    // Hard/Soft iron result: m_cal = soft * (m_raw - offset)
+    float offset[3];                // Hard iron (uT)
+    float soft[3][3];               // Soft iron correction (symmetric)
+    float field_ut;                 // Fitted field strength (uT)
+    bool is_valid;                  // true once a plausible fit exists
+
+    // Throttle compensation: field offset (uT) at each (left, right) bin
+    float thr_offset[MAGCAL_THR_BINS][MAGCAL_THR_BINS][3];
+    uint16_t thr_hits[MAGCAL_THR_BINS][MAGCAL_THR_BINS];
+} magcal_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Reset to identity calibration and empty throttle table
+ * @param cal Pointer to calibration object
+ */
+void magcal_init(magcal_t *cal);
+
+/**
+ * @brief Feed one raw sample to the ellipsoid fit
+ * @details Updates the normal equations (~55 MACs). Triggers a solve every
+ * MAGCAL_SOLVE_EVERY samples once MAGCAL_MIN_SAMPLES are collected.
+ * Should only be fed while motors are idle (throttle offsets would bias the fit).
+ * @param cal Pointer to calibration object
+ * @param raw Raw field (uT), chip frame
+ * @return true if a new fit was accepted during this call
+ */
+bool magcal_add_sample(magcal_t *cal, const float raw[3]);
+
+/**
+ * @brief Solve the ellipsoid fit from accumulated samples
+ * @param cal Pointer to calibration object
+ * @return true if the fit is plausible and was applied (false also while the
+ *         samples do not cover MAGCAL_MIN_SPREAD_UT in every direction)
+ */
+bool magcal_solve(magcal_t *cal);
+
+/**
+ * @brief Apply hard/soft iron correction only
+ * @param cal Pointer to calibration object
+ * @param raw Raw field (uT)
+ * @param out Corrected field (uT)
+ */
+void magcal_apply_iron(const magcal_t *cal, const float raw[3], float out[3]);
+
+/**
+ * @brief Learn the motor-induced offset at the given commands
+ * @param cal       Pointer to calibration object
+ * @param corrected Iron-corrected field measured with motors running
+ * @param reference Expected field in body frame without motor influence
+ *                  (e.g. snapshot at idle on the bench, or AHRS-predicted field)
+ * @param left_raw  Left command (0 - 10000)
+ * @param right_raw Right command (0 - 10000)
+ */
+void magcal_learn_throttle(magcal_t *cal, const float corrected[3], const float reference[3],
+                           uint16_t left_raw, uint16_t right_raw);
+
+/**
+ * @brief Full correction: iron calibration + throttle offset
+ * @param cal       Pointer to calibration object
+ * @param raw       Raw field (uT)
+ * @param left_raw  Left command (0 - 10000)
+ * @param right_raw Right command (0 - 10000)
+ * @param out       Corrected field (uT)
+ */
+void magcal_correct(const magcal_t *cal, const float raw[3],
+                    uint16_t left_raw, uint16_t right_raw, float out[3]);
+
+/**
+ * @brief Tilt-compensated magnetic heading
+ * @param mag   Corrected field (body frame)
+ * @param accel Gravity reaction vector (body frame, points Up at rest)
+ * @return Heading in degrees clockwise from magnetic North, 0..360
+ */
+float magcal_heading_deg(const float mag[3], const float accel[3]);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CAL_MAGNETOMETER_H
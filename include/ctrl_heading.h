@@ -0,0 +1,232 @@
+/**
+ * @file ctrl_heading.h
+ * @brief Heading-Hold & Speed Controller (differential thrust)
+ * @details
+ * - Runs at a fixed period paced by a hardware timer (GPTimer alarm ISR
+ *   notifies a high-priority task), not by vTaskDelay() tick rounding.
+ * - Heading PID: gains scheduled by measured speed (linear interpolation
+ *   in a small table), derivative on measurement through a 1st order
+ *   low-pass, conditional integration anti-windup.
+ * - Speed PI sets the common (base) throttle, heading PID sets the
+ *   differential: left = base + u, right = base - u (0-10000 raw scale).
+ * - Reports execution time, period jitter and missed periods.
+ * - Registered with the deadline monitor (sys_deadline.h): on repeated
+ *   misses both motors are held at MOTOR_IDLE_RAW (safe hold) until the
+ *   loop is back on time; the law keeps running meanwhile.
+ *
+ * Conventions: heading in degrees clockwise from North (compass, same as
+ * ahrs_get_euler()), positive differential turns the craft clockwise.
+ *
+ * tools/ctrl_sim.c runs the law in closed loop against a Nomoto yaw model.
+ */
+
+#ifndef CTRL_HEADING_H
+#define CTRL_HEADING_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// Loop timing
+#define CTRL_PERIOD_US          20000   // 50Hz (= ESC PWM frame rate, faster gains nothing)
+#define CTRL_TIMER_RES_HZ       1000000 // GPTimer resolution (1 tick = 1us)
+#define CTRL_BUDGET_US          5000    // Execution budget per period (deadline monitor)
+
+// Task
+#define CTRL_TASK_STACK         4096
+#define CTRL_TASK_PRIORITY      20      // Above IMU (12) / GPS (10)
+#define CTRL_TASK_CORE          1
+
+// Heading loop
+#define CTRL_SCHED_POINTS       4       // Gain schedule breakpoints
+#define CTRL_HDG_D_TAU_S        0.1f    // Derivative low-pass time constant (s)
+#define CTRL_HDG_I_MAX          1500.0f // Integrator clamp (raw units)
+#define CTRL_HDG_I_BAND_DEG     10.0f   // Integrate only when |error| is below this
+#define CTRL_DIFF_MAX_RAW       3000    // Max |left - right| / 2 (raw units)
+
+// Speed loop
+#define CTRL_SPD_KP             800.0f  // raw per (m/s)
+#define CTRL_SPD_KI             200.0f  // raw per (m/s * s)
+#define CTRL_SPD_FF             600.0f  // Feed-forward raw per (m/s) setpoint
+#define CTRL_BASE_MAX_RAW       9000    // Common throttle ceiling (leave room for differential)
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Gain schedule breakpoint
+ */
+typedef struct {
+    float speed_m_s;            // Breakpoint (ascending)
+    float kp;                   // raw per deg
+    float ki;                   // raw per (deg * s)
+    float kd;                   // raw per (deg/s)
+} ctrl_gains_t;
+
+/**
+ * @brief Controller inputs sampled once per period
+ */
+typedef struct {
+    float heading_deg;          // Compass heading (0..360)
+    float speed_m_s;            // Speed over ground
+    bool is_valid;              // false = sensors unavailable (outputs go idle)
+} ctrl_measurement_t;
+
+/**
+ * @brief Setpoints
+ */
+typedef struct {
+    float heading_deg;          // Desired compass heading
+    float speed_m_s;            // Desired speed (0 = hold position: idle thrust, no steering)
+    bool enabled;               // false = outputs held at MOTOR_IDLE_RAW
+} ctrl_setpoint_t;
+
+/**
+ * @brief Controller state (pure control law, no hardware)
+ */
+typedef struct {
+    ctrl_gains_t sched[CTRL_SCHED_POINTS];
+
+    // Heading PID
+    float hdg_i;                // Integrator (raw)
+    float hdg_d_filt;           // Filtered heading rate (deg/s)
+    float prev_heading;
+    bool has_prev;
+    bool hdg_sat;               // Last output hit the differential limit
+
+    // Speed PI
+    float spd_i;
+    bool spd_sat;
+
+    // Last outputs (for telemetry)
+    float u_diff;
+    float u_base;
+} ctrl_law_t;
+
+/**
+ * @brief Measurement callback (runs in the control task)
+ * @param out Measurement to fill
+ * @param ctx User context
+ */
+typedef void (*ctrl_measure_cb_t)(ctrl_measurement_t *out, void *ctx);
+
+/**
+ * @brief Loop timing statistics
+ */
+typedef struct {
+    uint32_t cycles;            // Control periods executed
+    uint32_t missed;            // Timer alarms that found the task still busy
+    uint32_t exec_last_us;      // Measure + law + motor update
+    uint32_t exec_max_us;
+    uint32_t wake_max_us;       // ISR -> task start latency
+    int32_t jitter_min_us;      // Actual period - nominal
+    int32_t jitter_max_us;
+    bool safe_hold;             // Deadline monitor escalation: motors held idle
+} ctrl_stats_t;
+
+/*----------------------------------------
+            PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Reset control law state and load the default gain schedule
+ * @param law Controller state
+ */
+void ctrl_law_init(ctrl_law_t *law);
+
+/**
+ * @brief Clear integrators / derivative memory (keeps gains)
+ * @param law Controller state
+ */
+void ctrl_law_reset(ctrl_law_t *law);
+
+/**
+ * @brief Heading gains interpolated at the given speed
+ * @param law       Controller state
+ * @param speed_m_s Measured speed
+ * @param out       Output gains
+ */
+void ctrl_law_gains_at(const ctrl_law_t *law, float speed_m_s, ctrl_gains_t *out);
+
+/**
+ * @brief Run one control period
+ * @param law       Controller state
+ * @param meas      Measurement
+ * @param sp        Setpoint
+ * @param dt        Period (s)
+ * @param left_raw  Output left motor command (0-10000)
+ * @param right_raw Output right motor command (0-10000)
+ */
+void ctrl_law_step(ctrl_law_t *law, const ctrl_measurement_t *meas, const ctrl_setpoint_t *sp,
+                   float dt, uint16_t *left_raw, uint16_t *right_raw);
+
+/**
+ * @brief Signed shortest angle difference a - b
+ * @return Difference in degrees (-180..180]
+ */
+float ctrl_wrap_deg(float a_minus_b);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Create the control task and period timer (not started)
+ * @param measure Measurement callback
+ * @param ctx     Callback context
+ * @return ESP_OK on success
+ */
+esp_err_t ctrl_heading_init(ctrl_measure_cb_t measure, void *ctx);
+
+/**
+ * @brief Start the fixed-rate loop (integrators cleared)
+ * @details On a timer error the loop stays stopped and the PM lock is released.
+ * @return ESP_OK on success or if already running, GPTimer error otherwise
+ */
+esp_err_t ctrl_heading_start(void);
+
+/**
+ * @brief Stop the loop and set both motors to MOTOR_IDLE_RAW
+ * @details No control step writes the motors after this returns. Safe to
+ * call from several tasks: only the caller that stops the loop tears it down.
+ * @return ESP_OK on success or if already stopped
+ */
+esp_err_t ctrl_heading_stop(void);
+
+/**
+ * @brief Update setpoints (thread safe, applied at the next period)
+ * @param sp New setpoints
+ */
+void ctrl_heading_set_target(const ctrl_setpoint_t *sp);
+
+/**
+ * @brief Replace the gain schedule (thread safe)
+ * @param sched Table of CTRL_SCHED_POINTS entries, ascending speed
+ */
+void ctrl_heading_set_schedule(const ctrl_gains_t sched[CTRL_SCHED_POINTS]);
+
+/**
+ * @brief Copy loop timing statistics
+ * @param out Output statistics
+ */
+void ctrl_heading_get_stats(ctrl_stats_t *out);
+
+/**
+ * @brief Print loop timing statistics to console
+ */
+void ctrl_heading_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CTRL_HEADING_H
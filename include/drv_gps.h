@@ -0,0 +1,257 @@
+/**
+ * @file drv_gps.h
+ * @brief NEO-M8N GPS Driver (UBX NAV-PVT @ 10Hz, NMEA fallback)
+ * @details
+ * - UART RX bytes are parsed straight out of the driver's read buffer by a
+ *   byte-wise state machine: no sentence copies, no sscanf/strtod.
+ * - Receiver is configured for 115200 baud, UBX-only output, NAV-PVT at 10Hz.
+ * - If the receiver ignores the configuration, GGA/RMC sentences are decoded
+ *   with integer-only field parsing.
+ * - Every fix carries the local timestamp of its last byte so consumers can
+ *   measure/compensate latency.
+ * tools/gps_parser_sim.c replays a canned NMEA stream through the parser.
+ */
+
+#ifndef DRV_GPS_H
+#define DRV_GPS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// UART
+#define GPS_UART_PORT           1
+#define GPS_BAUD_DEFAULT        9600        // NEO-M8N factory baud rate
+#define GPS_BAUD_RUN            115200      // Baud rate after configuration
+#define GPS_UART_RX_BUF         2048        // Driver ring buffer (>= 2 NAV-PVT bursts)
+#define GPS_READ_CHUNK          256         // Bytes parsed per read
+#define GPS_RX_FULL_THRESH      100         // UART FIFO bytes before ISR (fewer interrupts)
+#define GPS_RX_TIMEOUT_SYMBOLS  10          // Idle symbols before ISR flushes FIFO
+
+// Navigation
+#define GPS_MEAS_RATE_MS        100         // 10Hz solution rate
+
+// Task
+#define GPS_TASK_STACK          4096
+#define GPS_TASK_PRIORITY       10
+#define GPS_TASK_CORE           0
+
+// Parser
+#define GPS_UBX_MAX_PAYLOAD     100         // NAV-PVT is 92 bytes; longer lengths are treated as false syncs
+#define GPS_NMEA_MAX_FRAC       7           // Decimal digits kept per NMEA number (rest ignored)
+
+// UBX identifiers
+#define UBX_SYNC1               0xB5
+#define UBX_SYNC2               0x62
+#define UBX_CLASS_NAV           0x01
+#define UBX_CLASS_ACK           0x05
+#define UBX_CLASS_CFG           0x06
+#define UBX_NAV_PVT             0x07
+#define UBX_NAV_PVT_LEN         92
+#define UBX_ACK_NAK             0x00
+#define UBX_ACK_ACK             0x01
+#define UBX_CFG_PRT             0x00
+#define UBX_CFG_MSG             0x01
+#define UBX_CFG_RATE            0x08
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Fix type (UBX gnssFixType / NMEA quality mapped)
+ */
+typedef enum {
+    GPS_FIX_NONE = 0,
+    GPS_FIX_DEAD_RECKONING = 1,
+    GPS_FIX_2D = 2,
+    GPS_FIX_3D = 3,
+} gps_fix_type_t;
+
+/**
+ * @brief Navigation solution
+ * @note Integer units as delivered by the receiver (no float conversion in the parser).
+ */
+typedef struct {
+    int64_t rx_time_us;         // Local time when the last byte of the message arrived (systime_now_us)
+    uint32_t itow_ms;           // GPS time of week (UBX only)
+
+    int32_t lat_e7;             // Latitude (deg * 1e7)
+    int32_t lon_e7;             // Longitude (deg * 1e7)
+    int32_t height_msl_mm;      // Height above mean sea level (mm)
+
+    int32_t vel_n_mm_s;         // NED velocity (mm/s), UBX only
+    int32_t vel_e_mm_s;
+    int32_t vel_d_mm_s;
+    int32_t ground_speed_mm_s;  // Ground speed (mm/s)
+    int32_t course_e5;          // Course over ground (deg * 1e5)
+
+    uint32_t h_acc_mm;          // Horizontal accuracy estimate (mm), 0 = unknown
+    uint32_t s_acc_mm_s;        // Speed accuracy estimate (mm/s), 0 = unknown
+
+    uint16_t year;              // UTC date/time
+    uint8_t month, day, hour, min, sec;
+    int32_t nano;               // Fraction of second (ns, may be negative in UBX)
+
+    gps_fix_type_t fix_type;
+    uint8_t num_sv;
+    bool time_valid;            // UTC date & time fully resolved
+    bool from_ubx;              // true = NAV-PVT, false = NMEA fallback
+} gps_fix_t;
+
+/**
+ * @brief Fix callback
+ * @param fix Decoded solution (valid only during the call)
+ * @param ctx User context
+ */
+typedef void (*gps_fix_cb_t)(const gps_fix_t *fix, void *ctx);
+
+/**
+ * @brief Parser counters
+ */
+typedef struct {
+    uint32_t bytes;
+    uint32_t ubx_frames;
+    uint32_t nmea_sentences;
+    uint32_t checksum_errors;
+    uint32_t ubx_resyncs;       // UBX headers rejected for length (false 0xB5 0x62 sync)
+    uint32_t fixes;
+    uint32_t acks;
+    uint32_t naks;
+} gps_parser_stats_t;
+
+/**
+ * @brief Streaming parser state
+ */
+typedef struct {
+    // Framing
+    uint8_t state;
+    uint8_t ubx_class;
+    uint8_t ubx_id;
+    uint16_t ubx_len;
+    uint16_t ubx_pos;
+    uint8_t ck_a, ck_b;
+    uint8_t payload[GPS_UBX_MAX_PAYLOAD];
+
+    // NMEA
+    uint8_t nmea_type;          // Sentence being decoded
+    uint8_t nmea_field;         // Current field index
+    uint8_t nmea_xor;           // Running checksum
+    uint8_t nmea_ck_rx;         // Received checksum
+    uint8_t nmea_ck_digits;
+    uint8_t nmea_id_len;
+    char nmea_id[6];
+    int64_t field_int;          // Digits accumulated as integer
+    uint8_t field_frac_digits;  // Digits after the decimal point
+    bool field_in_frac;
+    bool field_neg;
+    bool field_empty;
+    char field_char;            // First character (N/S/E/W/A/V)
+    gps_fix_t nmea_fix;         // Last checksum-verified GGA + RMC data
+    gps_fix_t nmea_work;        // Fields of the sentence being decoded
+
+    // Output
+    gps_fix_cb_t on_fix;
+    void *cb_ctx;
+    uint8_t last_ack_class;     // Last ACK-ACK / ACK-NAK target
+    uint8_t last_ack_id;
+    bool last_ack_ok;
+
+    gps_parser_stats_t stats;
+} gps_parser_t;
+
+/**
+ * @brief Driver statistics
+ */
+typedef struct {
+    gps_parser_stats_t parser;
+    uint32_t uart_overflows;
+    uint32_t latency_last_us;   // Last byte received -> fix published
+    uint32_t latency_max_us;
+} gps_stats_t;
+
+/*----------------------------------------
+            PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Reset parser state
+ * @param p      Parser object
+ * @param on_fix Callback for decoded fixes (may be NULL)
+ * @param ctx    Callback context
+ */
+void gps_parser_init(gps_parser_t *p, gps_fix_cb_t on_fix, void *ctx);
+
+/**
+ * @brief Feed received bytes to the parser
+ * @param p          Parser object
+ * @param data       Received bytes (parsed in place)
+ * @param len        Number of bytes
+ * @param rx_time_us Local time the chunk was received (stamped on fixes)
+ */
+void gps_parser_feed(gps_parser_t *p, const uint8_t *data, size_t len, int64_t rx_time_us);
+
+/**
+ * @brief Build a UBX frame (sync + header + payload + checksum)
+ * @param cls      Message class
+ * @param id       Message id
+ * @param payload  Payload bytes (may be NULL if len = 0)
+ * @param len      Payload length
+ * @param out      Output buffer
+ * @param out_size Output buffer size
+ * @return Frame length, 0 if buffer too small
+ */
+size_t gps_ubx_build(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len,
+                     uint8_t *out, size_t out_size);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Initialize UART, configure receiver (UBX, 10Hz) and start GPS task
+ * @note **BLOCKING FUNCTION**: up to ~1s while waiting for configuration ACKs.
+ * A receiver that never ACKs is still usable through the NMEA fallback.
+ * @return ESP_OK on success, UART error otherwise
+ */
+esp_err_t gps_init(void);
+
+/**
+ * @brief Register a fix callback (runs in the GPS task)
+ * @param cb  Callback (NULL to unregister)
+ * @param ctx User context
+ */
+void gps_register_callback(gps_fix_cb_t cb, void *ctx);
+
+/**
+ * @brief Copy the latest fix
+ * @param out Output fix
+ * @return true if at least one fix has been received
+ */
+bool gps_get_fix(gps_fix_t *out);
+
+/**
+ * @brief Copy driver statistics
+ * @param out Output statistics
+ */
+void gps_get_stats(gps_stats_t *out);
+
+/**
+ * @brief Print throughput / latency statistics to console
+ */
+void gps_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRV_GPS_H
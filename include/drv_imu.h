@@ -0,0 +1,192 @@
+/**
+ * @file drv_imu.h
+ * @brief MPU-9250 IMU Driver (FIFO + Data-Ready Interrupt)
+ * @details
+ * - Accel + Gyro captured at 1kHz into the sensor's internal 512-byte FIFO.
+ * - AK8963 magnetometer polled by the MPU's auxiliary I2C master (100Hz),
+ *   result read from EXT_SENS_DATA registers.
+ * - Data-ready interrupt only timestamps samples; the FIFO is drained in
+ *   one burst transaction every IMU_DRAIN_EVERY samples.
+ * - Packet parser and scaling are pure functions (no ESP-IDF dependency),
+ *   tested on canned byte streams by tools/imu_fifo_sim.c.
+ *
+ * Output frame is the chip frame (X/Y as printed on the MPU, Z up when
+ * the chip lies face-up). Magnetometer axes are remapped to the same frame.
+ */
+
+#ifndef DRV_IMU_H
+#define DRV_IMU_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// Bus
+#define IMU_I2C_PORT            0
+#define IMU_I2C_FREQ_HZ         400000      // Fast mode (MPU-9250 max)
+#define IMU_I2C_ADDR            0x68        // AD0 = GND
+#define IMU_I2C_TIMEOUT_MS      10
+
+// Sampling
+#define IMU_SAMPLE_RATE_HZ      1000        // Gyro/Accel output rate (SMPLRT_DIV = 0)
+#define IMU_SAMPLE_PERIOD_US    (1000000 / IMU_SAMPLE_RATE_HZ)
+#define IMU_DRAIN_EVERY         10          // Drain FIFO every N samples (100Hz)
+#define IMU_MAG_DIVIDER         10          // Mag read every N samples (100Hz)
+#define IMU_ACCEL_FS_G          8           // Full scale: 2, 4, 8, 16 g
+#define IMU_GYRO_FS_DPS         1000        // Full scale: 250, 500, 1000, 2000 dps
+
+// FIFO
+#define IMU_FIFO_SIZE           512         // Hardware FIFO size (bytes)
+#define IMU_FIFO_PACKET_SIZE    12          // Accel XYZ + Gyro XYZ, 16-bit big-endian
+#define IMU_FIFO_MAX_PACKETS    (IMU_FIFO_SIZE / IMU_FIFO_PACKET_SIZE)
+#define IMU_MAG_RAW_SIZE        7           // HXL..HZH + ST2
+
+// Task
+#define IMU_TASK_STACK          4096
+#define IMU_TASK_PRIORITY       12
+#define IMU_TASK_CORE           1
+
+// Physical constants
+#define IMU_GRAVITY_MS2         9.80665f
+#define IMU_DEG_TO_RAD          0.017453293f
+#define IMU_MAG_UT_PER_LSB      0.15f       // AK8963 16-bit output
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief One scaled Accel + Gyro sample
+ */
+typedef struct {
+    int64_t timestamp_us;       // Time of data-ready edge for this sample (systime_now_us)
+    float ax, ay, az;           // Acceleration (m/s^2)
+    float gx, gy, gz;           // Angular rate (rad/s)
+} imu_sample_t;
+
+/**
+ * @brief One scaled magnetometer sample
+ */
+typedef struct {
+    int64_t timestamp_us;       // Time the registers were read (systime_now_us)
+    float mx, my, mz;           // Magnetic field (uT), chip frame
+    bool overflow;              // Magnetic sensor overflow (HOFL)
+} imu_mag_sample_t;
+
+/**
+ * @brief Conversion factors from raw LSB to SI units
+ */
+typedef struct {
+    float accel_scale;          // LSB -> m/s^2
+    float gyro_scale;           // LSB -> rad/s
+    float mag_scale[3];         // LSB -> uT, includes factory sensitivity adjustment
+} imu_scale_t;
+
+/**
+ * @brief Driver statistics (for CPU/bus budget checks)
+ */
+typedef struct {
+    uint32_t drains;            // FIFO drain transactions
+    uint32_t samples;           // Accel/Gyro samples delivered
+    uint32_t mag_samples;       // Mag samples delivered
+    uint32_t fifo_overflows;    // FIFO overflow events (data lost)
+    uint32_t bus_errors;        // I2C transaction failures
+    uint32_t bus_time_last_us;  // Bus time of last drain (all transactions)
+    uint32_t bus_time_max_us;   // Worst case bus time per drain
+    uint64_t bus_time_total_us; // Total bus time (for utilisation)
+} imu_stats_t;
+
+/**
+ * @brief Consumer callback, runs in the IMU task after each FIFO drain
+ * @param samples Scaled, timestamped samples (oldest first)
+ * @param count   Number of samples
+ * @param mag     New mag sample, or NULL if none this drain
+ * @param ctx     User context
+ */
+typedef void (*imu_data_cb_t)(const imu_sample_t *samples, size_t count,
+                              const imu_mag_sample_t *mag, void *ctx);
+
+/*----------------------------------------
+            PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Compute scale factors for the configured full scale ranges
+ * @param scale    Output scale factors
+ * @param accel_fs_g  Accel full scale (g)
+ * @param gyro_fs_dps Gyro full scale (dps)
+ * @param asa      AK8963 ASAX/ASAY/ASAZ fuse values (NULL = no adjustment)
+ */
+void imu_scale_init(imu_scale_t *scale, uint8_t accel_fs_g, uint16_t gyro_fs_dps, const uint8_t asa[3]);
+
+/**
+ * @brief Parse a burst of FIFO bytes into scaled samples
+ * @details Only whole packets are parsed; a trailing partial packet is left
+ * out. Timestamps are back-dated from the newest whole packet using the
+ * nominal sample period. If there are more than max_out packets, the oldest
+ * max_out are returned with their own timestamps.
+ * @param buf        FIFO bytes
+ * @param len        Number of bytes
+ * @param scale      Scale factors
+ * @param t_newest_us Timestamp of the last whole packet in the buffer
+ * @param period_us  Sample period
+ * @param out        Output array
+ * @param max_out    Capacity of output array
+ * @return Number of samples written
+ */
+size_t imu_fifo_parse(const uint8_t *buf, size_t len, const imu_scale_t *scale,
+                      int64_t t_newest_us, uint32_t period_us,
+                      imu_sample_t *out, size_t max_out);
+
+/**
+ * @brief Parse the AK8963 data block (HXL..HZH, ST2)
+ * @param raw   7 bytes as read from EXT_SENS_DATA_00
+ * @param scale Scale factors
+ * @param out   Output sample (timestamp left untouched)
+ * @return true if the sample is valid (no overflow)
+ */
+bool imu_mag_parse(const uint8_t raw[IMU_MAG_RAW_SIZE], const imu_scale_t *scale, imu_mag_sample_t *out);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Initialize I2C bus, MPU-9250, AK8963, interrupt and IMU task
+ * @note **BLOCKING FUNCTION**: ~150ms for device reset and mag setup.
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if WHO_AM_I mismatch, or I2C error
+ */
+esp_err_t imu_init(void);
+
+/**
+ * @brief Register the data consumer (e.g. AHRS)
+ * @param cb  Callback (NULL to unregister)
+ * @param ctx User context passed to callback
+ */
+void imu_register_callback(imu_data_cb_t cb, void *ctx);
+
+/**
+ * @brief Copy driver statistics
+ * @param out Output statistics
+ */
+void imu_get_stats(imu_stats_t *out);
+
+/**
+ * @brief Print driver statistics (bus utilisation, overflows) to console
+ */
+void imu_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRV_IMU_H
@@ -7,6 +7,9 @@
  * - Ring Buffer Moving Average (Low-pass filter)
  * - Hysteresis logic for Human Detection (Debounce)
  * - Impact detection algorithm for Collision Sensing
+ * - IMU heave compensation for faster human confirmation at sea
+ * - N-cell array engine (structure of arrays): per-cell thresholds,
+ *   total weight and centre of load for boarding assessment
  */
 
 #ifndef DRV_LOADCELL_H
@@ -19,6 +22,9 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "fusion_heave.h"
+#include "cal_fixed.h"
+#include "sys_health.h"
 
 /*----------------------------------------
         CONFIGURATION CONSTANT
@@ -33,15 +39,30 @@ extern "C" {
 
 //  Signal Processing
 #define FILTER_BUFFER_SIZE      10              // Size of Ring Buffer (Moving Average)
+#define LC_FAST_WINDOW          3               // Heave-compensated samples averaged by the fast path
 
-// Logic Thresholds 
-// Human detection uses Hysteresis 
-#define THRESH_HUMAN_TRIGGER    8000            // Upper bound: Trigger "Human Detected"
-#define THRESH_HUMAN_RELEASE    6000            // Lower bound: Release "Human Detected"
-#define THRESH_COLLISION_DELTA  3000            // Delta change required to trigger collision
+// Per-sensor ring buffer for loadcell_get_smooth_weight(). Detection runs on
+// lc_array_t; build with -DLOADCELL_LEGACY_SMOOTH=1 for the old per-sensor API.
+#ifndef LOADCELL_LEGACY_SMOOTH
+#define LOADCELL_LEGACY_SMOOTH  0
+#endif
+
+// Cell array
+#define LC_ARRAY_MAX            8               // Cells per lc_array_t
+#define LC_SIDE_ARM_M           0.30f           // Side cells' distance from the centreline (m), logic_detect_human()
+
+// Logic Thresholds: runtime parameters (sys_param.h)
+// Human detection uses Hysteresis
+//   lc_human_trig   Upper bound: Trigger "Human Detected"
+//   lc_human_rel    Lower bound: Release "Human Detected"
+//   lc_collision    Delta change required to trigger collision
+//   lc_detect_req   Consecutive samples required to confirm human presence
+// Heave compensation (fusion_heave.h)
+//   lc_heave_comp   1 = use the IMU heave factor when it covers the conversion
+//   lc_deadload     Load tared away at rest (platform), same unit as the weight
+//   lc_detect_fast  Consecutive compensated samples required to confirm
 
 // Logic Timing
-#define COUNTER_DETECT_REQ      5               // Consecutive samples required to confirm human presence
 #define COLLISION_COOLDOWN_MS   500             // Cooldown after collision detection (prevent retriggering)
 
 /*----------------------------------------
@@ -51,24 +72,31 @@ extern "C" {
 /**
  * @brief Loadcell object structure
  * * Contains hardware config, calibration data, and runtime buffers.
- * User only needs to initialize `pin_sck`, `pin_dout`, and `scale_factor`.
+ * User only needs to initialize `pin_sck`, `pin_dout`, and `scale_factor`;
+ * the health channel is given to loadcell_init(). After loadcell_init(),
+ * change the scale with loadcell_set_scale().
  */
 typedef struct {
     // User Configuration
     int pin_sck;                // GPIO number for Serial Clock (Output)
     int pin_dout;               // GPIO number for Data Out (Input)
     float scale_factor;         // Calibration factor (Raw / Scale = Weight)
+    uint8_t health_ch;          // health_channel_t fed by loadcell_get_weight(), set by loadcell_init()
 
     // Calibration Data 
     int32_t offset;             // Zero point value (Tare value)
+    fx_recip_t inv_scale;       // 1 / scale_factor (shift 0 = no valid scale yet)
     bool is_initialized;        // Flag indicating if GPIO/Driver is ready
+    int64_t sample_time_us;     // systime_now_us() of the last conversion read
 
+#if LOADCELL_LEGACY_SMOOTH
     // Ring Buffer (Moving Average Filter) 
     int32_t filter_buffer[FILTER_BUFFER_SIZE];  // Circular buffer for raw data
     uint8_t buffer_head;                        // Current write index
     bool is_buffer_full;                        // Flag: true if buffer has wrapped around
+#endif
 
-    // Human Detection Logic 
+    // Human Detection Logic (mirrored from the cell's lc_array_t)
     uint8_t stable_counter;     // Counter for debouncing human presence
     bool is_human_detected;     // Output flag: True if human is confirmed
 
@@ -79,13 +107,106 @@ typedef struct {
     int64_t last_collision_time_us; // Timestamp of last collision (for cooldown)
 } loadcell_t;
 
+/**
+ * @brief Per-cell configuration of an array
+ */
+typedef struct {
+    int32_t trig;               // Human detection thresholds (weight units, hysteresis)
+    int32_t rel;
+    int32_t deadload;           // Load tared away at rest, for the heave compensation
+    float x_m;                  // Cell position in the body frame (X forward, Y left)
+    float y_m;
+} lc_cell_cfg_t;
+
+/**
+ * @brief Human detection over N cells, structure of arrays
+ * * Every per-cell quantity is an array indexed by cell, and the filter
+ * histories are one row per tick with all cells contiguous, so a tick is
+ * a single pass over short contiguous arrays. The moving average keeps a
+ * running sum instead of re-adding its window.
+ */
+typedef struct {
+    uint8_t count;                              // Cells in use (1..LC_ARRAY_MAX)
+    uint8_t detect_req;                         // Confirmations on the moving average
+    uint8_t detect_fast;                        // Confirmations on the compensated mean
+
+    // Per-cell configuration
+    int32_t trig[LC_ARRAY_MAX];
+    int32_t rel[LC_ARRAY_MAX];
+    int32_t deadload[LC_ARRAY_MAX];
+    int32_t pos_x_mm[LC_ARRAY_MAX];             // Integer so the centre-of-load sums stay exact
+    int32_t pos_y_mm[LC_ARRAY_MAX];
+
+    // Moving average (FILTER_BUFFER_SIZE ticks)
+    int32_t hist[FILTER_BUFFER_SIZE][LC_ARRAY_MAX];
+    int32_t hist_sum[LC_ARRAY_MAX];
+    uint8_t hist_fill[LC_ARRAY_MAX];
+    uint8_t hist_head;
+
+    // Heave-compensated mean (LC_FAST_WINDOW ticks)
+    int32_t comp[LC_FAST_WINDOW][LC_ARRAY_MAX];
+    uint8_t comp_fill[LC_ARRAY_MAX];            // Consecutive compensated samples (capped)
+    uint8_t comp_head;
+
+    // Detection state
+    int32_t level[LC_ARRAY_MAX];                // Last detection input per cell
+    uint8_t stable[LC_ARRAY_MAX];               // Debounce counters
+    uint32_t detected_mask;                     // Bit i: human confirmed on cell i
+
+    // Combined (last tick, over cells with a positive level)
+    int32_t total;                              // Sum of cell levels
+    float col_x_m;                              // Centre of load (0 when total is 0)
+    float col_y_m;
+} lc_array_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Clear an array of `count` cells
+ * * Cells never trigger until configured with lc_array_set_cell().
+ * @param arr Array
+ * @param count Number of cells (clamped to 1..LC_ARRAY_MAX)
+ */
+void lc_array_init(lc_array_t *arr, uint8_t count);
+
+/**
+ * @brief Configure one cell (history and detection state are kept)
+ */
+void lc_array_set_cell(lc_array_t *arr, uint8_t i, const lc_cell_cfg_t *cfg);
+
+/**
+ * @brief Clear history and detection state of one cell (e.g. after power-up)
+ */
+void lc_array_reset_cell(lc_array_t *arr, uint8_t i);
+
+/**
+ * @brief Process one tick of all cells in a single pass
+ * * Per cell, like the two-cell logic it replaces: the detection input is
+ * the mean of the last LC_FAST_WINDOW compensated weights once that many
+ * consecutive samples had a heave factor (needs `detect_fast`
+ * confirmations), else the moving average (needs `detect_req`).
+ * An LC_ERROR_CODE sample repeats the cell's previous one in the moving
+ * average, restarts the compensated window and leaves detection unchanged.
+ * @param arr Array
+ * @param weights `count` tared weights (LC_ERROR_CODE for a failed read)
+ * @param k `count` heave factors (0 = none), or NULL without compensation
+ */
+void lc_array_update(lc_array_t *arr, const int32_t *weights, const float *k);
+
 /**
  * @brief Initialize Loadcell Driver
  * * Configures GPIO, resets buffers, and clears internal states.
  * @param sensor Pointer to loadcell_t struct
+ * @param health_ch Health channel fed by this cell (HEALTH_CH_LC_*), or
+ *        HEALTH_CH_COUNT if the cell is not monitored
+ * @note `scale_factor` may be 0 (uncalibrated): the cell can be tared and
+ *       read raw, and loadcell_get_weight() returns LC_ERROR_CODE until
+ *       loadcell_set_scale() is given a valid scale.
  * @return ESP_OK on success, ESP_FAIL on GPIO error
  */
-esp_err_t loadcell_init(loadcell_t *sensor);
+esp_err_t loadcell_init(loadcell_t *sensor, health_channel_t health_ch);
 
 /**
  * @brief Read Raw Data from HX711 (Bit-banging)
@@ -104,14 +225,28 @@ int32_t loadcell_read_raw(loadcell_t const *sensor);
  */
 esp_err_t loadcell_read_average_raw(loadcell_t *sensor, uint8_t times);
 
+/**
+ * @brief Change the calibration scale (also updates the fixed-point reciprocal)
+ * @param sensor Pointer to loadcell_t struct
+ * @param scale_factor Raw counts per weight unit (non-zero)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if the scale is 0 or out of range
+ */
+esp_err_t loadcell_set_scale(loadcell_t *sensor, float scale_factor);
+
 /**
  * @brief Calculate real weight based on offset and scale
  * * Formula: (Raw - Offset) / Scale
+ * With SENSOR_FIXED_POINT the division is a multiply by the precomputed
+ * reciprocal (integer only, same truncation as the float path).
+ * Stamps `sample_time_us` on success and feeds the raw value (or the
+ * timeout) to the sensor health channel `health_ch`.
  * @param sensor Pointer to loadcell_t struct
- * @return Weight in grams (int32_t)
+ * @return Weight in grams (int32_t), LC_ERROR_CODE on timeout or while
+ *         no valid scale is set
  */
 int32_t loadcell_get_weight(loadcell_t *sensor);
 
+#if LOADCELL_LEGACY_SMOOTH
 /**
  * @brief Apply Ring Buffer Filter to get smooth weight
  * * Adds new weight to buffer and returns the moving average.
@@ -120,16 +255,66 @@ int32_t loadcell_get_weight(loadcell_t *sensor);
  * @return Smoothed weight value
  */
 int32_t loadcell_get_smooth_weight(loadcell_t *sensor, int32_t new_weight);
+#endif
+
+/**
+ * @brief Put the HX711 into power-down (PD_SCK held high, < 1uA)
+ * * The SCK level is latched so it survives light sleep.
+ * @param sensor Pointer to loadcell_t struct
+ */
+void loadcell_power_down(loadcell_t *sensor);
+
+/**
+ * @brief Wake the HX711 and restart the detection logic
+ * * Calibration (offset, scale) is kept; filter and detection state are
+ * cleared because they describe the load before the power-down.
+ * The first conversion is ready ~400 ms later (loadcell_read_raw waits).
+ * @param sensor Pointer to loadcell_t struct
+ */
+void loadcell_power_up(loadcell_t *sensor);
+
+/**
+ * @brief Select the heave estimator used by logic_detect_human()
+ * * The estimator is fed by the IMU consumer (heave_add_batch).
+ * @param heave Estimator, NULL to disable the compensation
+ */
+void loadcell_set_heave(const heave_t *heave);
+
+/**
+ * @brief Fill a cell configuration from the runtime parameters
+ * * `lc_human_trig`, `lc_human_rel` and `lc_deadload`, at the given position.
+ */
+void loadcell_cell_defaults(lc_cell_cfg_t *cfg, float x_m, float y_m);
+
+/**
+ * @brief Logic: Detect Human on an array of cells
+ * * Reads every cell once, looks up its heave factor (with `lc_heave_comp`
+ * and IMU data covering the conversion) and runs lc_array_update() with
+ * `lc_detect_req` / `lc_detect_fast`. Mirrors each cell's result into its
+ * `is_human_detected` / `stable_counter`.
+ * @param arr Array, configured with `arr->count` cells
+ * @param cells The loadcells, in array order
+ */
+void logic_detect_human_array(lc_array_t *arr, loadcell_t *const *cells);
 
 /**
  * @brief Logic: Detect Human on Side Sensors
- * * Uses Hysteresis and Persistence Counter to filter wave noise.
+ * * Two-cell array (left at +LC_SIDE_ARM_M, right at -LC_SIDE_ARM_M)
+ * refreshed from the runtime parameters on every call; see
+ * logic_detect_human_array(). Uses Hysteresis and Persistence Counter to
+ * filter wave noise.
  * Updates `is_human_detected` flag in the struct.
  * * @param left_sensor Pointer to Left Loadcell
  * @param right_sensor Pointer to Right Loadcell
  */
 void logic_detect_human(loadcell_t *left_sensor, loadcell_t *right_sensor);
 
+/**
+ * @brief Combined result of the side pair (total weight, centre of load)
+ * @return Array used by logic_detect_human(), NULL before its first call
+ */
+const lc_array_t *logic_side_array(void);
+
 /**
  * @brief Logic: Detect Collision on Front Sensor
  * * Uses Derivative (Delta) check to detect sudden impacts.
@@ -0,0 +1,267 @@
+/**
+ * @file drv_modem.h
+ * @brief SimCom A7682S LTE Modem Driver (AT engine + MQTT)
+ * @details
+ * - A dedicated modem task owns the UART and the AT engine (at_engine.h).
+ *   UART bytes are read straight into the engine's ring buffer.
+ * - Other tasks only post messages to the modem task: every public call
+ *   here returns immediately and never waits for the modem.
+ * - Command/URC callbacks run in the modem task.
+ * - MQTT helpers wrap the A7682S CMQTT command set (TLS optional).
+ * - HTTP range GET wraps the HTTP(S) client, for firmware patches (sys_ota.h).
+ */
+
+#ifndef DRV_MODEM_H
+#define DRV_MODEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "at_engine.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// UART
+#define MODEM_UART_PORT         2
+#define MODEM_BAUD              115200
+#define MODEM_UART_RX_BUF       2048        // Driver RX buffer
+#define MODEM_UART_TX_BUF       2048        // Driver TX buffer (writes never block below this)
+#define MODEM_RX_FULL_THRESH    64          // UART FIFO bytes before ISR
+#define MODEM_RX_TIMEOUT_SYMBOLS 4          // Idle symbols before ISR flushes FIFO
+
+// Task
+#define MODEM_TASK_STACK        4096
+#define MODEM_TASK_PRIORITY     8           // Below GPS (10), IMU (12) and control (20)
+#define MODEM_TASK_CORE         0
+#define MODEM_POLL_MS           10          // Timeout / message poll period
+#define MODEM_MSG_QUEUE_LEN     8
+
+// MQTT
+#define MODEM_MQTT_TOPIC_MAX    64
+#define MODEM_MQTT_PAYLOAD_MAX  1024        // Per publish
+#define MODEM_MQTT_PUB_SLOTS    2           // Publishes in flight
+#define MODEM_MQTT_RX_MAX       512         // Largest received payload kept
+#define MODEM_MQTT_MAX_SUBS     4
+#define MODEM_MQTT_KEEPALIVE_S  60
+#define MODEM_MQTT_CONNECT_TIMEOUT_MS 30000
+#define MODEM_MQTT_PUB_TIMEOUT_MS     10000
+
+// HTTP
+#define MODEM_HTTP_URL_MAX      96          // Fits AT+HTTPPARA="URL" in AT_CMD_MAX_LEN
+#define MODEM_HTTP_READ_MAX     1024        // Bytes per AT+HTTPREAD
+#define MODEM_HTTP_ACTION_TIMEOUT_MS 60000  // Request sent -> +HTTPACTION
+#define MODEM_HTTP_READ_TIMEOUT_MS   10000
+
+// Sleep (STANDBY)
+#define MODEM_DTR_WAKE_MS       50          // DTR low -> modem accepts UART again
+#define MODEM_EDRX_CYCLE        "0010"      // 20.48 s paging cycle, bounds WAKE latency
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Modem events
+ */
+typedef enum {
+    MODEM_EVT_MQTT_CONNECTED = 0,
+    MODEM_EVT_MQTT_LOST,
+    MODEM_EVT_MQTT_PUB_FAILED,
+} modem_event_t;
+
+/**
+ * @brief Event callback (runs in the modem task)
+ */
+typedef void (*modem_event_cb_t)(modem_event_t event, void *ctx);
+
+/**
+ * @brief MQTT message callback (runs in the modem task)
+ * @param topic   NUL-terminated topic
+ * @param payload Payload bytes (valid only during the call)
+ * @param len     Payload length (truncated to MODEM_MQTT_RX_MAX)
+ * @param ctx     User context
+ */
+typedef void (*modem_mqtt_rx_cb_t)(const char *topic, const uint8_t *payload, size_t len, void *ctx);
+
+/**
+ * @brief Publish completion (runs in the modem task)
+ * @param ok  true once "+CMQTTPUB: 0,0" arrived (QoS 1/2: broker acknowledged)
+ * @param ctx User context
+ */
+typedef void (*modem_pub_done_cb_t)(bool ok, void *ctx);
+
+/**
+ * @brief HTTP body callback (runs in the modem task)
+ * @param data   Chunk (valid only during the call)
+ * @param len    Chunk length
+ * @param offset Offset of the chunk in the requested range
+ * @param ctx    User context
+ */
+typedef void (*modem_http_data_cb_t)(const uint8_t *data, size_t len, size_t offset, void *ctx);
+
+/**
+ * @brief HTTP request completion (runs in the modem task)
+ * @param status HTTP status (200 / 206 on success), -1 if the AT sequence failed
+ * @param len    Body bytes delivered
+ * @param ctx    User context
+ */
+typedef void (*modem_http_done_cb_t)(int32_t status, size_t len, void *ctx);
+
+/**
+ * @brief Driver statistics
+ */
+typedef struct {
+    at_stats_t at;
+    uint32_t uart_overflows;
+    uint32_t msg_queue_full;    // Posts rejected (modem task backlog)
+    uint32_t mqtt_pub_ok;
+    uint32_t mqtt_pub_failed;
+    uint32_t mqtt_rx;
+    uint32_t mqtt_rx_truncated;
+    uint32_t http_requests;
+    uint32_t http_failed;
+    uint32_t http_bytes;
+} modem_stats_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Initialize UART and start the modem task
+ * @return ESP_OK on success
+ */
+esp_err_t modem_init(void);
+
+/**
+ * @brief Post a raw AT command (non-blocking)
+ * @param cmd Command descriptor (copied; data must stay valid until on_done)
+ * @return false if the modem task backlog is full
+ */
+bool modem_submit(const at_cmd_t *cmd);
+
+/**
+ * @brief Register a URC handler (non-blocking, applied by the modem task)
+ * @param prefix URC prefix (string must stay valid)
+ * @param cb     Line callback
+ * @param ctx    User context
+ * @return false if the modem task backlog is full
+ */
+bool modem_register_urc(const char *prefix, at_line_cb_t cb, void *ctx);
+
+/**
+ * @brief Set event callback
+ */
+void modem_set_event_callback(modem_event_cb_t cb, void *ctx);
+
+/**
+ * @brief Start the MQTT client and connect (non-blocking)
+ * @param broker_uri "tcp://host:port"
+ * @param client_id  Client identifier
+ * @param use_tls    Use TLS 1.2 (SSL context 0)
+ * @return false if the request could not be queued
+ */
+bool modem_mqtt_connect(const char *broker_uri, const char *client_id, bool use_tls);
+
+/**
+ * @brief Publish a message (payload copied, non-blocking)
+ * @param topic   Topic
+ * @param payload Payload bytes
+ * @param len     Payload length (<= MODEM_MQTT_PAYLOAD_MAX)
+ * @param qos     0, 1 or 2
+ * @return false if not connected, too large or no publish slot free
+ */
+bool modem_mqtt_publish(const char *topic, const uint8_t *payload, size_t len, uint8_t qos);
+
+/**
+ * @brief Publish and report the outcome
+ * @param done Called exactly once if this returns true (error, timeout and
+ *             flush included), never if it returns false
+ * @param ctx  Callback context
+ * @return Same as modem_mqtt_publish()
+ */
+bool modem_mqtt_publish_cb(const char *topic, const uint8_t *payload, size_t len, uint8_t qos,
+                           modem_pub_done_cb_t done, void *ctx);
+
+/**
+ * @brief Subscribe (re-applied automatically after reconnect)
+ * @param topic Topic filter
+ * @param qos   0, 1 or 2
+ * @return false if the subscription table is full
+ */
+bool modem_mqtt_subscribe(const char *topic, uint8_t qos);
+
+/**
+ * @brief Set the callback for received MQTT messages
+ */
+void modem_mqtt_set_rx_callback(modem_mqtt_rx_cb_t cb, void *ctx);
+
+/**
+ * @brief Arrival time of the message being delivered
+ * @details Valid inside the RX callback: time the +CMQTTRXSTART line was
+ * tokenized, i.e. before topic and payload were transferred.
+ * @return esp_timer time (us)
+ */
+int64_t modem_mqtt_rx_time_us(void);
+
+/**
+ * @brief MQTT connection state
+ * @return true if connected to the broker
+ */
+bool modem_mqtt_is_connected(void);
+
+/**
+ * @brief Fetch a byte range of a URL (non-blocking, one request at a time)
+ * @details AT+HTTPACTION with a "Range: bytes=" header, then AT+HTTPREAD in
+ * MODEM_HTTP_READ_MAX blocks; the body is handed to on_data as it arrives,
+ * nothing is buffered here. A server that ignores Range is only accepted
+ * for offset 0 (the first len bytes are delivered).
+ * @param url     http:// or https:// URL (shorter than MODEM_HTTP_URL_MAX)
+ * @param offset  First byte
+ * @param len     Number of bytes (> 0)
+ * @param on_data Body callback
+ * @param on_done Completion callback (always called once the request is accepted)
+ * @param ctx     User context
+ * @return false if a request is in progress, the URL is too long or the backlog is full
+ */
+bool modem_http_get_range(const char *url, uint32_t offset, uint32_t len,
+                          modem_http_data_cb_t on_data, modem_http_done_cb_t on_done, void *ctx);
+
+/**
+ * @brief Enable / disable modem low-power mode (non-blocking)
+ * @details Enable: AT+CSCLK=1 (sleep while DTR is high) and eDRX with
+ * MODEM_EDRX_CYCLE. The MQTT session stays up; incoming messages pulse RI.
+ * PSM is not used: the modem would be unreachable for the WAKE command.
+ * @return false if the modem task backlog is full
+ */
+bool modem_set_low_power(bool enable);
+
+/**
+ * @brief Drive DTR: let the modem sleep, or wake it
+ * @param sleep true = DTR high; false = DTR low and wait MODEM_DTR_WAKE_MS
+ */
+void modem_sleep(bool sleep);
+
+/**
+ * @brief Copy driver statistics
+ * @param out Output statistics
+ */
+void modem_get_stats(modem_stats_t *out);
+
+/**
+ * @brief Print throughput / latency statistics to console
+ */
+void modem_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DRV_MODEM_H
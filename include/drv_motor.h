@@ -42,6 +42,14 @@ void motor_init(void);
  */
 void motor_set_speed(uint16_t left_raw, uint16_t right_raw);
 
+/**
+ * @brief Get the last commanded speed (after clamping)
+ * @details Used by consumers that depend on motor load (e.g. compass EMI compensation).
+ * @param left_raw  Output: Left Motor command (may be NULL)
+ * @param right_raw Output: Right Motor command (may be NULL)
+ */
+void motor_get_speed(uint16_t *left_raw, uint16_t *right_raw);
+
 /**
  * @brief Emergency Stop (Safety Cutoff)
  * @details Immediately sets PWM duty to 0 for both motors.
@@ -49,6 +57,13 @@ void motor_set_speed(uint16_t left_raw, uint16_t right_raw);
  */
 void motor_stop_all(void);
 
+/**
+ * @brief Stop the PWM output (pins held low)
+ * @details ESCs see no signal and stay disarmed (used in STANDBY).
+ * motor_set_speed() / motor_stop_all() restart the output.
+ */
+void motor_disarm(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -17,18 +17,13 @@ extern "C" {
 #include "esp_err.h"
 
 /**
- * @brief Spike Rejection Threshold (Chống nhiễu gai)
- * @note If the new value jumps more than this amount (mm) compared to the 
- * last valid value, it is considered a potential "spike" (noise).
+ * @brief Spike Rejection (Chống nhiễu gai)
+ * @note Runtime parameters (sys_param.h):
+ * - us_spike_mm: a jump larger than this (mm) from the last valid value
+ *   is a potential "spike" (noise).
+ * - us_spike_tol: consecutive "spikes" needed to confirm a real movement
+ *   (3 samples ~ 200ms delay: good balance between stability and response).
  */
-#define FILTER_SPIKE_THRESHOLD_MM   500    // Max allowed jump in mm (50cm)
-
-/**
- * @brief Spike Persistence Tolerance
- * @note How many consecutive "spikes" are needed to confirm a real movement.
- * - 3 samples ~ 200ms delay: Good balance between stability and response.
- */
-#define FILTER_SPIKE_TOLERANCE      5      // Consecutive spikes before accepting
 
 /**
  * @brief Sensor Error Limit (Failsafe)
@@ -96,6 +91,16 @@ esp_err_t ultrasonic_init(void);
  */
 uint16_t ultrasonic_measure(gpio_num_t trig_pin, gpio_num_t echo_pin);
 
+/**
+ * @brief Measure raw distance and stamp the sample
+ * @param trig_pin GPIO number of Trigger pin
+ * @param echo_pin GPIO number of Echo pin
+ * @param sample_time_us Output: systime_now_us() at the moment of reflection
+ *        (middle of the echo pulse). Untouched on error. May be NULL.
+ * @return Distance in millimeters (mm), or US_ERROR_CODE
+ */
+uint16_t ultrasonic_measure_stamped(gpio_num_t trig_pin, gpio_num_t echo_pin, int64_t *sample_time_us);
+
 /**
  * @brief Apply Advanced Filter (Blind Zone + Jump Rejection)
  * @details
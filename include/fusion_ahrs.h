@@ -0,0 +1,171 @@
+/**
+ * @file fusion_ahrs.h
+ * @brief Attitude & Heading Reference System (Madgwick / Mahony)
+ * @details
+ * - Quaternion attitude estimation from Gyro + Accel (+ optional Mag).
+ * - Float path uses only add/mul/madd (no divide, no libm sqrt) to suit
+ *   the ESP32-S3 single-precision FPU.
+ * - Batch path processes a burst of IMU samples (e.g. one FIFO drain)
+ *   while keeping the filter state in registers.
+ * - Self-measures its cost in CPU cycles per update.
+ *
+ * Conventions (same as Madgwick's reference implementation):
+ * - Earth frame: X North, Y West, Z Up. Body frame: X forward, Y left, Z up.
+ * - Accel reads +1g on Z when level and at rest.
+ * - Gyro in rad/s. Accel and Mag in any consistent unit (normalized inside).
+ * - A magnetometer vector of (0, 0, 0) selects the 6-DOF (IMU only) update.
+ *
+ * tools/ahrs_sim.c checks the attitude error on synthetic IMU data.
+ */
+
+#ifndef FUSION_AHRS_H
+#define FUSION_AHRS_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define AHRS_DEFAULT_RATE_HZ        500.0f  // Nominal update rate
+#define AHRS_MADGWICK_BETA          0.1f    // Gradient descent gain (higher = trust accel/mag more)
+#define AHRS_MAHONY_KP              1.0f    // Proportional feedback gain
+#define AHRS_MAHONY_KI              0.0f    // Integral feedback gain (gyro bias estimation)
+
+#define AHRS_RAD_TO_DEG             57.29577951f
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Fusion algorithm selection
+ */
+typedef enum {
+    AHRS_ALGO_MADGWICK = 0,     // Gradient descent (default)
+    AHRS_ALGO_MAHONY,           // Complementary PI feedback
+} ahrs_algo_t;
+
+/**
+ * @brief One IMU sample for the batch path
+ * @note Set mx = my = mz = 0 for gyro/accel only samples.
+ */
+typedef struct {
+    float gx, gy, gz;           // Angular rate (rad/s)
+    float ax, ay, az;           // Acceleration (any unit)
+    float mx, my, mz;           // Magnetic field (any unit, 0 = not available)
+} ahrs_sample_t;
+
+/**
+ * @brief Execution cost statistics (CPU cycles)
+ */
+typedef struct {
+    uint32_t update_count;      // Number of samples processed
+    uint32_t last_cycles;       // Cycles spent in the last call (per sample)
+    uint32_t max_cycles;        // Worst case cycles per sample
+    uint64_t total_cycles;      // Sum for average computation
+} ahrs_stats_t;
+
+/**
+ * @brief AHRS filter object
+ */
+typedef struct {
+    ahrs_algo_t algo;
+
+    // Gains
+    float beta;                 // Madgwick
+    float two_kp;               // Mahony (2 * Kp)
+    float two_ki;               // Mahony (2 * Ki)
+
+    // Attitude quaternion (body -> earth)
+    float q0, q1, q2, q3;
+
+    // Mahony integral feedback terms
+    float integral_fb_x, integral_fb_y, integral_fb_z;
+
+    ahrs_stats_t stats;
+} ahrs_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Initialize filter with default gains and identity attitude
+ * @param ahrs Pointer to filter object
+ * @param algo Fusion algorithm
+ */
+void ahrs_init(ahrs_t *ahrs, ahrs_algo_t algo);
+
+/**
+ * @brief Reset attitude to identity and clear integrators / statistics
+ * @param ahrs Pointer to filter object
+ */
+void ahrs_reset(ahrs_t *ahrs);
+
+/**
+ * @brief Seed the attitude directly from a static Accel (+ Mag) reading
+ * @details Avoids the slow convergence of the filter at power-up.
+ * @param ahrs Pointer to filter object
+ * @param ax,ay,az Accelerometer reading (vehicle at rest)
+ * @param mx,my,mz Magnetometer reading (all 0 = heading set to 0)
+ */
+void ahrs_align(ahrs_t *ahrs, float ax, float ay, float az,
+                float mx, float my, float mz);
+
+/**
+ * @brief Process one IMU sample
+ * @param ahrs Pointer to filter object
+ * @param s    IMU sample (mag = 0 selects 6-DOF update)
+ * @param dt   Time since previous sample (seconds)
+ */
+void ahrs_update(ahrs_t *ahrs, const ahrs_sample_t *s, float dt);
+
+/**
+ * @brief Process a burst of equally spaced IMU samples
+ * @details Intended for FIFO drains: keeps the quaternion in registers
+ * across samples and records the per-sample cost.
+ * @param ahrs    Pointer to filter object
+ * @param samples Array of samples (oldest first)
+ * @param count   Number of samples
+ * @param dt      Sample period (seconds)
+ */
+void ahrs_update_batch(ahrs_t *ahrs, const ahrs_sample_t *samples, size_t count, float dt);
+
+/**
+ * @brief Get Euler angles (ZYX / aerospace sequence)
+ * @param ahrs Pointer to filter object
+ * @param roll  Output roll in degrees (may be NULL)
+ * @param pitch Output pitch in degrees (may be NULL)
+ * @param yaw   Output compass heading in degrees, clockwise from North, 0..360 (may be NULL)
+ */
+void ahrs_get_euler(const ahrs_t *ahrs, float *roll, float *pitch, float *yaw);
+
+/**
+ * @brief Rotate a body-frame vector into the earth (NWU) frame
+ * @param ahrs Pointer to filter object
+ * @param body Input vector [3]
+ * @param earth Output vector [3]
+ */
+void ahrs_body_to_earth(const ahrs_t *ahrs, const float body[3], float earth[3]);
+
+/**
+ * @brief Average CPU load of the filter at a given update rate
+ * @param ahrs    Pointer to filter object
+ * @param rate_hz Update rate (Hz)
+ * @param cpu_mhz CPU clock (MHz)
+ * @return Fraction of one core in percent (0.0 if no samples yet)
+ */
+float ahrs_get_cpu_load_pct(const ahrs_t *ahrs, float rate_hz, uint32_t cpu_mhz);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSION_AHRS_H
@@ -0,0 +1,201 @@
+/**
+ * @file fusion_ekf.h
+ * @brief GPS/IMU Error-State Kalman Filter (horizontal position & velocity)
+ * @details
+ * - Nominal state: East/North position, velocity and accelerometer bias,
+ *   propagated with earth-frame acceleration (IMU rotated by the AHRS).
+ * - Error state per axis: [dp, dv, db]. With attitude supplied by the AHRS
+ *   the East and North axes decouple, so the 6x6 covariance is stored as
+ *   two symmetric 3x3 blocks (6 floats each) and updated in closed form.
+ * - GPS position/velocity are applied as sequential scalar updates
+ *   (no matrix inversion), each gated on its normalized innovation.
+ * - Fixed-size state, no dynamic allocation, self-measured cost in cycles.
+ *
+ * Frames: local ENU tangent plane (see nav_geo.h), axis 0 = East, 1 = North.
+ * tools/ekf_sim.c flies simulated trajectories with GPS dropouts through it.
+ */
+
+#ifndef FUSION_EKF_H
+#define FUSION_EKF_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "fusion_ahrs.h"
+#include "drv_gps.h"
+#include "nav_geo.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// Process noise
+#define EKF_ACCEL_NOISE         0.5f    // Accel white noise incl. attitude error (m/s^2)
+#define EKF_BIAS_NOISE          0.01f   // Accel bias random walk (m/s^2/sqrt(s))
+
+// Initial uncertainty
+#define EKF_INIT_POS_STD        10.0f   // m
+#define EKF_INIT_VEL_STD        1.0f    // m/s
+#define EKF_INIT_BIAS_STD       0.2f    // m/s^2
+
+// Measurements
+#define EKF_GPS_POS_STD_MIN     1.0f    // Floor on receiver hAcc (m)
+#define EKF_GPS_POS_STD_NMEA    5.0f    // Used when hAcc is unknown (m)
+#define EKF_GPS_VEL_STD_MIN     0.1f    // Floor on receiver sAcc (m/s)
+#define EKF_GPS_VEL_STD_NMEA    0.5f    // Used when sAcc is unknown (m/s)
+#define EKF_GATE_SIGMA          5.0f    // Reject innovations beyond N sigma
+#define EKF_MAX_REJECTS         10      // Consecutive rejects before re-seeding from GPS
+
+#define EKF_GPS_TIMEOUT_US      2000000 // No accepted GPS for 2s -> dead reckoning
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Symmetric 3x3 covariance (upper triangle of [pos, vel, bias])
+ */
+typedef struct {
+    float pp, pv, pb, vv, vb, bb;
+} ekf_cov3_t;
+
+/**
+ * @brief One horizontal axis (nominal state + error covariance)
+ */
+typedef struct {
+    float pos;                  // m
+    float vel;                  // m/s
+    float bias;                 // m/s^2
+    ekf_cov3_t P;
+} ekf_axis_t;
+
+/**
+ * @brief Execution cost statistics (CPU cycles)
+ */
+typedef struct {
+    uint32_t predict_count;
+    uint32_t predict_last_cycles;
+    uint32_t predict_max_cycles;
+    uint32_t update_count;
+    uint32_t update_last_cycles;
+    uint32_t update_max_cycles;
+    uint32_t gps_rejects;       // Innovations outside the gate
+    uint32_t gps_reseeds;       // State re-seeded after persistent rejects
+} ekf_stats_t;
+
+/**
+ * @brief Filter object
+ */
+typedef struct {
+    ekf_axis_t axis[2];         // 0 = East, 1 = North
+    float q_accel;              // Accel noise variance (m/s^2)^2
+    float q_bias;               // Bias random walk variance per second
+    nav_origin_t origin;        // Local frame origin (set on first GPS fix)
+    int64_t last_gps_us;        // Time of last accepted GPS update
+    uint8_t reject_run;         // Consecutive rejected GPS updates
+    bool is_initialized;        // State seeded from GPS
+    ekf_stats_t stats;
+} ekf_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Initialize filter (unseeded, default noise parameters)
+ * @param ekf Pointer to filter object
+ */
+void ekf_init(ekf_t *ekf);
+
+/**
+ * @brief Seed nominal state and reset covariance to initial uncertainty
+ * @param ekf     Pointer to filter object
+ * @param east_m  East position (m)
+ * @param north_m North position (m)
+ * @param ve      East velocity (m/s)
+ * @param vn      North velocity (m/s)
+ */
+void ekf_reset(ekf_t *ekf, float east_m, float north_m, float ve, float vn);
+
+/**
+ * @brief Time update with earth-frame horizontal acceleration
+ * @param ekf Pointer to filter object
+ * @param ae  East acceleration (m/s^2)
+ * @param an  North acceleration (m/s^2)
+ * @param dt  Time step (s)
+ */
+void ekf_predict(ekf_t *ekf, float ae, float an, float dt);
+
+/**
+ * @brief Time update from a body-frame accelerometer reading
+ * @details Rotates the specific force with the AHRS attitude (NWU) and
+ * keeps the horizontal components. Residual tilt error shows up as a
+ * slowly varying horizontal acceleration and is absorbed by the bias state.
+ * @param ekf   Pointer to filter object
+ * @param ahrs  Attitude source
+ * @param accel Body-frame acceleration [3] (m/s^2)
+ * @param dt    Time step (s)
+ */
+void ekf_predict_body(ekf_t *ekf, const ahrs_t *ahrs, const float accel[3], float dt);
+
+/**
+ * @brief Measurement update with a local position
+ * @param ekf     Pointer to filter object
+ * @param east_m  East (m)
+ * @param north_m North (m)
+ * @param std_m   Measurement standard deviation (m)
+ * @return true if both axes passed the innovation gate
+ */
+bool ekf_update_position(ekf_t *ekf, float east_m, float north_m, float std_m);
+
+/**
+ * @brief Measurement update with a velocity
+ * @param ekf     Pointer to filter object
+ * @param ve      East velocity (m/s)
+ * @param vn      North velocity (m/s)
+ * @param std_m_s Measurement standard deviation (m/s)
+ * @return true if both axes passed the innovation gate
+ */
+bool ekf_update_velocity(ekf_t *ekf, float ve, float vn, float std_m_s);
+
+/**
+ * @brief Apply a GPS fix (position + velocity)
+ * @details The first 2D/3D fix sets the local origin and seeds the state.
+ * NMEA fixes without NED velocity use ground speed and course.
+ * @param ekf Pointer to filter object
+ * @param fix GPS solution
+ * @return true if the fix was accepted
+ */
+bool ekf_update_gps(ekf_t *ekf, const gps_fix_t *fix);
+
+/**
+ * @brief Read the current estimate
+ * @param ekf Pointer to filter object
+ * @param east_m,north_m Output position (m, may be NULL)
+ * @param ve,vn          Output velocity (m/s, may be NULL)
+ */
+void ekf_get_state(const ekf_t *ekf, float *east_m, float *north_m, float *ve, float *vn);
+
+/**
+ * @brief 1-sigma horizontal position uncertainty
+ * @param ekf Pointer to filter object
+ * @return sqrt(P_ee + P_nn) in metres
+ */
+float ekf_get_pos_std(const ekf_t *ekf);
+
+/**
+ * @brief Check GPS aiding status
+ * @param ekf    Pointer to filter object
+ * @param now_us Current time (esp_timer_get_time())
+ * @return true if a GPS update was accepted within EKF_GPS_TIMEOUT_US
+ */
+bool ekf_is_gps_aided(const ekf_t *ekf, int64_t now_us);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSION_EKF_H
@@ -0,0 +1,115 @@
+/**
+ * @file fusion_heave.h
+ * @brief Wave-Motion (Heave) Compensation of Load-Cell Readings
+ * @details
+ * In a seaway the deck accelerates up and down, and every load cell reads
+ * its load times the specific force along the hull Z axis:
+ *
+ *   w_meas = (D + m) * k - D,    k = f_z / g
+ *
+ * where D is the dead load tared away at rest (platform, sling) and m the
+ * load on top of it. The IMU measures f_z directly (accel Z, +1g at rest),
+ * roll and pitch included, so no attitude estimate is needed:
+ *
+ *   m = (w_meas + D) / k - D
+ *
+ * The HX711 averages over its whole conversion (100 ms at 10 SPS), so k is
+ * the mean of f_z over the same window. The IMU stream is reduced to 10 ms
+ * slot means in a small ring; a load-cell read looks up the slots covering
+ * its conversion.
+ *
+ * Concurrency: one writer (the IMU consumer) and any number of readers
+ * (load-cell task) without a lock. Each slot carries its slot number,
+ * invalidated while it is rewritten; a reader only uses slots whose
+ * number it sees unchanged before and after reading the value.
+ */
+
+#ifndef FUSION_HEAVE_H
+#define FUSION_HEAVE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "drv_imu.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define HEAVE_SLOT_US           10000       // Ring resolution (10 IMU samples at 1 kHz)
+#define HEAVE_SLOTS             32          // 320 ms of history
+#define HEAVE_LC_WINDOW_US      100000      // HX711 conversion at 10 SPS
+#define HEAVE_MIN_COVERAGE      0.7f        // Fraction of window slots that must be present
+#define HEAVE_K_MIN             0.3f        // Plausible f_z / g range; outside it the hull is
+#define HEAVE_K_MAX             2.5f        //   airborne or the IMU saturates and no factor is given
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Heave estimator state
+ */
+typedef struct {
+    // Slot ring (written by the IMU consumer)
+    float slot_fz[HEAVE_SLOTS];         // Mean f_z of the slot (m/s^2)
+    int32_t slot_id[HEAVE_SLOTS];       // Slot number (t / HEAVE_SLOT_US), -1 = empty or being written
+
+    // Slot being accumulated
+    int32_t cur_id;
+    float cur_sum;
+    uint16_t cur_n;
+
+    uint32_t samples;                   // IMU samples fed
+} heave_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Clear the history
+ */
+void heave_init(heave_t *h);
+
+/**
+ * @brief Feed one specific-force sample along the hull Z axis
+ * @param t_us  Sample time (systime_now_us)
+ * @param fz    Accel Z (m/s^2, +g at rest)
+ * @note A slot becomes visible to readers when the first sample of the next one arrives.
+ */
+void heave_add(heave_t *h, int64_t t_us, float fz);
+
+/**
+ * @brief Feed a burst of IMU samples (call from the IMU data callback)
+ */
+void heave_add_batch(heave_t *h, const imu_sample_t *samples, size_t count);
+
+/**
+ * @brief Mean f_z / g over a time window
+ * @param from_us Window start (systime_now_us)
+ * @param to_us   Window end
+ * @param k       Output factor
+ * @return false if the history does not cover the window (IMU stalled or
+ *         not fed yet) or the factor is outside HEAVE_K_MIN..HEAVE_K_MAX
+ */
+bool heave_factor(const heave_t *h, int64_t from_us, int64_t to_us, float *k);
+
+/**
+ * @brief Remove the heave from a tared load-cell weight
+ * @param weight    Measured weight (tared)
+ * @param k         Factor from heave_factor()
+ * @param deadload  Load tared away at rest, same unit as weight
+ * @return Weight the cell would read at 1g
+ */
+int32_t heave_compensate(int32_t weight, float k, int32_t deadload);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FUSION_HEAVE_H
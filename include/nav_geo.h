@@ -0,0 +1,70 @@
+/**
+ * @file nav_geo.h
+ * @brief Local Tangent Plane (ENU) Projection
+ * @details
+ * Converts GPS coordinates (deg * 1e7) to metres East/North of a fixed
+ * origin. The WGS84 radii of curvature are evaluated once at the origin,
+ * so each projection afterwards is two integer subtractions and two float
+ * multiplies. Distance error vs the WGS84 geodesic: <0.05% within 2km of
+ * the origin, ~0.2% at 10km (tools/nav_sim.c).
+ */
+
+#ifndef NAV_GEO_H
+#define NAV_GEO_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define NAV_WGS84_A             6378137.0       // Semi-major axis (m)
+#define NAV_WGS84_E2            6.69437999014e-3 // First eccentricity squared
+
+/**
+ * @brief Projection origin
+ */
+typedef struct {
+    int32_t lat0_e7;            // Origin latitude (deg * 1e7)
+    int32_t lon0_e7;            // Origin longitude (deg * 1e7)
+    float m_per_e7_lat;         // Metres per 1e-7 deg of latitude
+    float m_per_e7_lon;         // Metres per 1e-7 deg of longitude (at origin latitude)
+    bool is_valid;
+} nav_origin_t;
+
+/**
+ * @brief Set origin and precompute scale factors (uses double trig once)
+ * @param origin Output origin
+ * @param lat_e7 Origin latitude (deg * 1e7)
+ * @param lon_e7 Origin longitude (deg * 1e7)
+ */
+void nav_geo_set_origin(nav_origin_t *origin, int32_t lat_e7, int32_t lon_e7);
+
+/**
+ * @brief Project geodetic coordinates to local East/North
+ * @param origin  Projection origin
+ * @param lat_e7  Latitude (deg * 1e7)
+ * @param lon_e7  Longitude (deg * 1e7)
+ * @param east_m  Output East (m)
+ * @param north_m Output North (m)
+ */
+void nav_geo_project(const nav_origin_t *origin, int32_t lat_e7, int32_t lon_e7,
+                     float *east_m, float *north_m);
+
+/**
+ * @brief Inverse projection: local East/North to geodetic coordinates
+ * @param origin  Projection origin
+ * @param east_m  East (m)
+ * @param north_m North (m)
+ * @param lat_e7  Output latitude (deg * 1e7)
+ * @param lon_e7  Output longitude (deg * 1e7)
+ */
+void nav_geo_unproject(const nav_origin_t *origin, float east_m, float north_m,
+                       int32_t *lat_e7, int32_t *lon_e7);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NAV_GEO_H
@@ -0,0 +1,187 @@
+/**
+ * @file nav_waypoint.h
+ * @brief Waypoint Navigator & Geofence (local ENU frame)
+ * @details
+ * - Home, waypoints and fence vertices are projected into the local ENU
+ *   frame once, when the mission is loaded (nav_geo.h, origin = home).
+ * - A leg table stores each leg's unit vector, length and bearing, so the
+ *   per-tick update is a projection + dot/cross products + one atan2f.
+ * - Geofence: the polygon's bounding box is split into a grid of cells
+ *   classified IN / OUT / EDGE at load time; only positions in EDGE cells
+ *   need the full point-in-polygon test.
+ *
+ * Bearings are compass degrees (clockwise from North, 0..360), matching
+ * ctrl_heading.h and ahrs_get_euler().
+ * tools/nav_sim.c checks it against WGS84 geodesics and benchmarks the
+ * per-tick cost against a naive haversine navigator.
+ */
+
+#ifndef NAV_WAYPOINT_H
+#define NAV_WAYPOINT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "nav_geo.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define NAV_MAX_WAYPOINTS       16
+#define NAV_MAX_FENCE_VERTS     16
+#define NAV_FENCE_GRID          16          // Grid cells per side (16x16 = 256 bytes)
+#define NAV_ACCEPT_RADIUS_M     5.0f        // Waypoint reached radius
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Point in the local frame
+ */
+typedef struct {
+    float e;                    // East (m)
+    float n;                    // North (m)
+} nav_enu_t;
+
+/**
+ * @brief Precomputed leg (from -> to)
+ */
+typedef struct {
+    nav_enu_t from;
+    nav_enu_t to;
+    float ue, un;               // Unit direction vector
+    float length_m;
+    float bearing_deg;
+} nav_leg_t;
+
+/**
+ * @brief Fence grid cell class
+ */
+typedef enum {
+    NAV_CELL_OUT = 0,
+    NAV_CELL_IN,
+    NAV_CELL_EDGE,              // Crossed by a polygon edge: exact test needed
+} nav_cell_t;
+
+/**
+ * @brief Geofence polygon with spatial index
+ */
+typedef struct {
+    nav_enu_t verts[NAV_MAX_FENCE_VERTS];
+    uint8_t count;
+    float min_e, min_n;         // Bounding box origin
+    float inv_cell_e;           // 1 / cell width
+    float inv_cell_n;           // 1 / cell height
+    uint8_t cells[NAV_FENCE_GRID * NAV_FENCE_GRID];
+} nav_fence_t;
+
+/**
+ * @brief Mission (all geometry in the local frame)
+ */
+typedef struct {
+    nav_origin_t origin;        // = home
+    nav_enu_t home;             // Always (0, 0), kept for readability
+    nav_leg_t legs[NAV_MAX_WAYPOINTS];
+    uint8_t leg_count;
+    uint8_t active_leg;
+    float accept_radius_m;
+    nav_fence_t fence;
+    bool has_fence;
+} nav_mission_t;
+
+/**
+ * @brief Per-tick navigation output
+ */
+typedef struct {
+    float dist_to_wp_m;         // Straight-line distance to active waypoint
+    float bearing_to_wp_deg;    // Bearing to active waypoint
+    float leg_bearing_deg;      // Bearing of the active leg
+    float cross_track_m;        // Signed distance from leg line (+ = right of track)
+    float along_track_m;        // Progress along leg from its start
+    uint8_t leg;                // Active leg index
+    bool wp_reached;            // Active waypoint reached this tick (leg advanced)
+    bool mission_done;          // Last waypoint reached
+    bool inside_fence;          // true if no fence is set
+} nav_status_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Start a new mission with home as local origin
+ * @param m       Mission object
+ * @param lat_e7  Home latitude (deg * 1e7)
+ * @param lon_e7  Home longitude (deg * 1e7)
+ */
+void nav_mission_init(nav_mission_t *m, int32_t lat_e7, int32_t lon_e7);
+
+/**
+ * @brief Append a waypoint (leg from previous waypoint, or from home)
+ * @param m      Mission object
+ * @param lat_e7 Latitude (deg * 1e7)
+ * @param lon_e7 Longitude (deg * 1e7)
+ * @return false if the table is full
+ */
+bool nav_mission_add_waypoint(nav_mission_t *m, int32_t lat_e7, int32_t lon_e7);
+
+/**
+ * @brief Set the geofence polygon and build its grid index
+ * @param m       Mission object
+ * @param lat_e7  Vertex latitudes
+ * @param lon_e7  Vertex longitudes
+ * @param count   Number of vertices (3..NAV_MAX_FENCE_VERTS)
+ * @return false if the vertex count is out of range
+ */
+bool nav_mission_set_fence(nav_mission_t *m, const int32_t *lat_e7, const int32_t *lon_e7, uint8_t count);
+
+/**
+ * @brief Replace the remaining route by a single leg to home
+ * @param m   Mission object
+ * @param pos Current position (local frame)
+ */
+void nav_mission_return_home(nav_mission_t *m, nav_enu_t pos);
+
+/**
+ * @brief Project a GPS position into the mission frame
+ * @param m      Mission object
+ * @param lat_e7 Latitude (deg * 1e7)
+ * @param lon_e7 Longitude (deg * 1e7)
+ * @return Local position
+ */
+nav_enu_t nav_mission_project(const nav_mission_t *m, int32_t lat_e7, int32_t lon_e7);
+
+/**
+ * @brief Per-tick update: guidance quantities and leg sequencing
+ * @param m   Mission object
+ * @param pos Current position (local frame)
+ * @param out Output status
+ */
+void nav_update(nav_mission_t *m, nav_enu_t pos, nav_status_t *out);
+
+/**
+ * @brief Geofence test
+ * @param fence Fence (built by nav_mission_set_fence)
+ * @param p     Position (local frame)
+ * @return true if inside the polygon
+ */
+bool nav_fence_contains(const nav_fence_t *fence, nav_enu_t p);
+
+/**
+ * @brief Compass bearing of a local vector
+ * @param de East component
+ * @param dn North component
+ * @return Degrees clockwise from North (0..360)
+ */
+float nav_bearing_deg(float de, float dn);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NAV_WAYPOINT_H
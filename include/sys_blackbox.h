@@ -0,0 +1,248 @@
+/**
+ * @file sys_blackbox.h
+ * @brief Black-Box Flight Recorder (RAM ring -> flash blocks, RTC pre-trigger)
+ * @details
+ * Data path:
+ *
+ *   bbox_record()  ->  RAM ring (lock-free, 1 producer)  ->  bbox task  ->  "bbox" partition
+ *        |
+ *        +-> RTC ring (last BBOX_RTC_SLOTS frames, survives panic/WDT reset)
+ *
+ * - bbox_record() copies one frame and returns; it never waits. If the
+ *   RAM ring is full the frame is dropped and counted.
+ * - The bbox task (priority 1) packs frames into BBOX_BLOCK_BYTES blocks
+ *   and writes each block with one aligned flash write. Sectors are
+ *   erased as the ring of blocks wraps. A partial block is written after
+ *   BBOX_BLOCK_MAX_AGE_MS or on bbox_flush().
+ * - Frames still in RAM are lost on a crash. The RTC ring holds the same
+ *   frames and is not initialized at boot: after a panic, WDT or
+ *   brownout reset, its content is written to flash as PRETRIG frames
+ *   ahead of the new session. A brownout deep enough to lose RTC memory
+ *   leaves an invalid ring, which is ignored.
+ *
+ * Records (little-endian, tag decides the layout, never split across blocks):
+ *
+ *   FRAME / PRETRIG := tag mask time_ms(u32) channel data for each bit in mask
+ *   SESSION         := tag reset_reason mask rate_hz pretrig_count(u32)
+ *
+ *   block := magic(u32) seq(u32) used(u16) crc16(u16) record...
+ *
+ * Channels and rate are runtime parameters (bbox_channels, bbox_rate_hz).
+ * The 64 KB partition holds ~18 s at 100 Hz with all channels (~37 s at
+ * 50 Hz, longer with fewer channels).
+ */
+
+#ifndef SYS_BLACKBOX_H
+#define SYS_BLACKBOX_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "sys_flashlog.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define BBOX_PARTITION_LABEL    "bbox"
+#define BBOX_MAGIC              0x58424242  // "BBBX"
+#define BBOX_SECTOR_SIZE        4096
+#define BBOX_BLOCK_BYTES        1024        // One flash write (4 pages)
+#define BBOX_BLOCK_HDR_BYTES    12
+#define BBOX_BLOCK_MAX_AGE_MS   2000        // Write a partial block after this long
+
+#define BBOX_RAM_BYTES          8192        // RAM ring (power of 2): ~2.5 s at 100 Hz
+#define BBOX_RTC_SLOTS          64          // Pre-trigger frames kept in RTC memory
+#define BBOX_MAX_RATE_HZ        100         // Upper limit of bbox_rate_hz (sys_param.h)
+
+#define BBOX_TASK_STACK         3072
+#define BBOX_TASK_PRIORITY      1
+#define BBOX_TASK_CORE          0
+#define BBOX_POLL_MS            50
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Record tags
+ */
+typedef enum {
+    BBOX_TAG_FRAME   = 'F',
+    BBOX_TAG_PRETRIG = 'P',         // Frame recovered from RTC memory (previous boot)
+    BBOX_TAG_SESSION = 'S',
+} bbox_tag_t;
+
+/**
+ * @brief Channel groups (bbox_channels bits, data in this order)
+ */
+typedef enum {
+    BBOX_CH_MOTOR   = 1 << 0,       // motor_left, motor_right         4 bytes
+    BBOX_CH_DIST    = 1 << 1,       // dist_mm[3] (filtered)           6 bytes
+    BBOX_CH_LOAD    = 1 << 2,       // load[3], flags                 14 bytes
+    BBOX_CH_BATT    = 1 << 3,       // batt_mv                         2 bytes
+    BBOX_CH_MISSION = 1 << 4,       // mission                         1 byte
+    BBOX_CH_ALL     = 0x1F,
+} bbox_channel_t;
+
+#define BBOX_FRAME_HDR_BYTES    6
+#define BBOX_FRAME_MAX          (BBOX_FRAME_HDR_BYTES + 4 + 6 + 14 + 2 + 1)
+
+/**
+ * @brief One recorder sample (filled by the caller)
+ */
+typedef struct {
+    uint16_t motor_left;        // LEDC duty (raw)
+    uint16_t motor_right;
+    uint16_t dist_mm[3];        // Front, left, right (filtered)
+    int32_t load[3];            // Front, left, right (weight units)
+    uint16_t flags;             // TLM_FLAG_* bits
+    uint16_t batt_mv;
+    uint8_t mission;            // mission_state_t
+} bbox_frame_t;
+
+/**
+ * @brief Single-producer / single-consumer byte ring ([len][record] items)
+ */
+typedef struct {
+    uint8_t *buf;
+    uint32_t size;              // Power of 2
+    uint32_t head;              // Written by the producer only
+    uint32_t tail;              // Written by the consumer only
+} bbox_ring_t;
+
+/**
+ * @brief Block store state
+ */
+typedef struct {
+    flog_flash_t flash;
+    uint32_t block_count;
+    uint32_t next_block;        // Index of the next block to write
+    uint32_t next_seq;
+    uint8_t block[BBOX_BLOCK_BYTES];
+    uint16_t used;              // Bytes in block (including header)
+    uint32_t erases;
+    uint32_t flash_errors;
+} bbox_store_t;
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    uint32_t recorded;          // Frames accepted by bbox_record()
+    uint32_t dropped;           // RAM ring full
+    uint32_t blocks;            // Blocks written
+    uint32_t erases;
+    uint32_t flash_errors;
+    uint32_t pretrig;           // Frames recovered from RTC at boot
+    uint32_t record_cycles_max; // bbox_record() cost
+    uint32_t record_cycles_avg;
+    uint64_t flash_busy_us;     // Time spent in flash writes/erases
+    uint32_t ring_peak;         // RAM ring high-water mark (bytes)
+} bbox_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Bytes of a FRAME record for a channel mask
+ */
+size_t bbox_frame_size(uint8_t mask);
+
+/**
+ * @brief Encode a FRAME/PRETRIG record
+ * @param out Output (BBOX_FRAME_MAX bytes)
+ * @return Record length
+ */
+size_t bbox_pack(uint8_t tag, uint8_t mask, uint32_t time_ms, const bbox_frame_t *f, uint8_t *out);
+
+/**
+ * @brief Bytes of the record starting with this tag/second byte, 0 if unknown
+ */
+size_t bbox_record_size(const uint8_t *rec);
+
+/**
+ * @brief Initialize a ring over a buffer (size must be a power of 2)
+ */
+void bbox_ring_init(bbox_ring_t *r, uint8_t *buf, uint32_t size);
+
+/**
+ * @brief Producer: append one record (all or nothing)
+ * @return false if there is no room
+ */
+bool bbox_ring_put(bbox_ring_t *r, const uint8_t *rec, size_t len);
+
+/**
+ * @brief Consumer: take the oldest record
+ * @param out Output (BBOX_FRAME_MAX bytes)
+ * @return Record length, 0 if empty
+ */
+size_t bbox_ring_get(bbox_ring_t *r, uint8_t *out);
+
+/**
+ * @brief Bytes currently queued
+ */
+uint32_t bbox_ring_used(const bbox_ring_t *r);
+
+/**
+ * @brief Find the newest block and continue at the next sector boundary
+ * @return false on flash error or bad geometry
+ */
+bool bbox_store_mount(bbox_store_t *st, const flog_flash_t *flash);
+
+/**
+ * @brief Add a record to the current block (writes the block when full)
+ * @return false on flash error
+ */
+bool bbox_store_add(bbox_store_t *st, const uint8_t *rec, size_t len);
+
+/**
+ * @brief Write the current block if it holds any record
+ * @return false on flash error
+ */
+bool bbox_store_flush(bbox_store_t *st);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Mount the "bbox" partition, save the RTC pre-trigger frames of a
+ *        crashed previous boot, write the SESSION record and start the task
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the partition is missing
+ */
+esp_err_t bbox_init(void);
+
+/**
+ * @brief Record a sample (rate-limited to bbox_rate_hz, never blocks)
+ * @note Single producer: call from one task only (the control/application loop).
+ * @return true if the frame was queued
+ */
+bool bbox_record(const bbox_frame_t *f);
+
+/**
+ * @brief Ask the task to write the current partial block (e.g. at mission end)
+ */
+void bbox_flush(void);
+
+/**
+ * @brief Copy statistics
+ */
+void bbox_get_stats(bbox_stats_t *out);
+
+/**
+ * @brief Print recorder statistics to console
+ */
+void bbox_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_BLACKBOX_H
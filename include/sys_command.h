@@ -0,0 +1,169 @@
+/**
+ * @file sys_command.h
+ * @brief Remote Command Channel & Link-Loss Watchdog
+ * @details
+ * Commands arrive as MQTT messages on CMD_TOPIC, one text command each:
+ *
+ *   STOP                    Cut thrust now (mission state unchanged)
+ *   ABORT                   Cut thrust now and end the mission (-> STANDBY)
+ *   WAKE                    Leave STANDBY (handled by the application)
+ *   RTH                     Return to home
+ *   HB                      Heartbeat (keeps the link watchdog fed)
+ *   WP lat,lon;lat,lon;...  Replace the route (deg * 1e7 integers)
+ *   PARAM GET|SET|RESET ... Parameter access (see sys_param.h)
+ *   OTA <url>               Firmware update from a patch URL (see sys_ota.h)
+ *
+ * - STOP/ABORT are matched first and executed in the modem task itself:
+ *   controller stopped, motor_stop_all(), no queue in between.
+ * - PARAM commands are also handled in the modem task; the reply is
+ *   published on SYSPARAM_REPLY_TOPIC. OTA is started from there too,
+ *   accepted or refused on OTA_STATUS_TOPIC.
+ * - Other commands go to a queue read by the application (RTH/WAKE are
+ *   put in front of waypoint updates).
+ * - Any valid command feeds the watchdog. No command for
+ *   CMD_LINK_TIMEOUT_MS while a mission is underway -> MISSION_RTH
+ *   (README failsafe "Signal Loss > 30s").
+ *
+ * tools/stop_sim.c measures the STOP latency through a fake broker.
+ */
+
+#ifndef SYS_COMMAND_H
+#define SYS_COMMAND_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define CMD_TOPIC               "frd/cmd"
+#define CMD_MAX_WAYPOINTS       16          // = NAV_MAX_WAYPOINTS
+#define CMD_QUEUE_LEN           4
+#define CMD_LINK_TIMEOUT_MS     30000       // README failsafe
+#define CMD_WATCHDOG_PERIOD_MS  1000
+#define CMD_URL_MAX             96          // = OTA_URL_MAX
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Command types
+ */
+typedef enum {
+    CMD_NONE = 0,
+    CMD_STOP,
+    CMD_ABORT,
+    CMD_WAKE,
+    CMD_RTH,
+    CMD_HEARTBEAT,
+    CMD_WAYPOINTS,
+    CMD_PARAM_GET,
+    CMD_PARAM_SET,
+    CMD_PARAM_RESET,
+    CMD_OTA,
+} cmd_type_t;
+
+/**
+ * @brief Parsed command
+ */
+typedef struct {
+    cmd_type_t type;
+    uint8_t wp_count;
+    int32_t lat_e7[CMD_MAX_WAYPOINTS];
+    int32_t lon_e7[CMD_MAX_WAYPOINTS];
+    uint8_t param_id;           // sysparam_id_t, SYSPARAM_COUNT = all (GET)
+    float param_value;          // SET
+    char url[CMD_URL_MAX];      // OTA (NUL-terminated)
+    int64_t rx_time_us;         // Start of the message on the modem UART (+CMQTTRXSTART)
+} cmd_t;
+
+/**
+ * @brief Link state change callback (runs in the esp_timer task)
+ * @param link_up false when the watchdog expired, true on the next command
+ */
+typedef void (*cmd_link_cb_t)(bool link_up, void *ctx);
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    uint32_t received;
+    uint32_t parse_errors;
+    uint32_t emergency;         // STOP / ABORT executed
+    uint32_t queue_full;
+    uint32_t link_losses;
+    uint32_t stop_latency_last_us;  // +CMQTTRXSTART received -> motors idle
+    uint32_t stop_latency_max_us;
+} cmd_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Parse one command message
+ * @param data Message payload (not NUL-terminated)
+ * @param len  Payload length
+ * @param out  Output command (rx_time_us untouched)
+ * @return false if the message is not a valid command
+ */
+bool cmd_parse(const uint8_t *data, size_t len, cmd_t *out);
+
+/**
+ * @brief Check whether a command must bypass the queue
+ */
+bool cmd_is_emergency(cmd_type_t type);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Subscribe to CMD_TOPIC and start the link watchdog
+ * @note Call after modem_init(). Takes over the modem MQTT RX callback.
+ * @return ESP_OK on success
+ */
+esp_err_t cmd_init(void);
+
+/**
+ * @brief Get the next queued (non-emergency) command
+ * @param out     Output command
+ * @param wait_ms Time to wait (0 = poll)
+ * @return true if a command was returned
+ */
+bool cmd_receive(cmd_t *out, uint32_t wait_ms);
+
+/**
+ * @brief Set link state callback
+ */
+void cmd_set_link_callback(cmd_link_cb_t cb, void *ctx);
+
+/**
+ * @brief Check link state
+ * @return false while the watchdog is expired
+ */
+bool cmd_link_is_up(void);
+
+/**
+ * @brief Copy statistics
+ */
+void cmd_get_stats(cmd_stats_t *out);
+
+/**
+ * @brief Print command statistics to console
+ */
+void cmd_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_COMMAND_H
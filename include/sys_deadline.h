@@ -0,0 +1,200 @@
+/**
+ * @file sys_deadline.h
+ * @brief Deadline Monitor for Periodic Tasks (overruns, WCET, escalation)
+ * @details
+ * A periodic task registers its period and execution budget, then brackets
+ * every iteration with dl_begin() / dl_end(). Per iteration:
+ * - release: the nominal start, advanced by one period per iteration (a
+ *   start more than a period late skips whole periods, counted);
+ * - overrun: execution time above the budget;
+ * - deadline miss: end after release + period (late start or long run);
+ * - WCET: longest execution time seen since dl_start().
+ * Repeated misses (DL_ESCALATE_CONSECUTIVE in a row, or DL_WINDOW_MISSES in
+ * the last DL_WINDOW iterations) escalate the task: its callback puts the
+ * outputs it owns in a safe state (ctrl_heading: both motors idle). For
+ * tasks with a callback, an iteration that never ends is caught by a poll
+ * timer after DL_HUNG_PERIODS. DL_RECOVER_CLEAN on-time iterations in a row clear the
+ * escalation (callback again with escalated = false).
+ *
+ * Blocking sensor reads (loadcell_read_raw() up to 100 ms,
+ * ultrasonic_measure() up to 55 ms) inside a registered loop show up here
+ * as overruns against its budget.
+ *
+ * Cost: two esp_timer_get_time() reads and a short critical section per
+ * iteration (dl_measure_cost()). tools/deadline_sim.c replays synthetic
+ * overruns through the tracker.
+ */
+
+#ifndef SYS_DEADLINE_H
+#define SYS_DEADLINE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define DL_MAX_TASKS            8
+#define DL_ESCALATE_CONSECUTIVE 3           // Misses in a row -> escalate
+#define DL_WINDOW               50          // Iterations in the miss-rate window (<= 64)
+#define DL_WINDOW_MISSES        5           // Misses in the window -> escalate
+#define DL_RECOVER_CLEAN        50          // On-time iterations in a row -> recover
+#define DL_HUNG_PERIODS         5           // Iteration open this long -> escalate (poll)
+#define DL_POLL_PERIOD_MS       20          // Hung-iteration poll (only while a task with a callback runs)
+#define DL_BENCH_CALLS          1000        // Begin/end pairs per cost measurement
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+typedef uint8_t dl_id_t;
+
+/**
+ * @brief Escalation callback
+ * @param id        Task
+ * @param escalated true = force the safe state, false = recovered
+ * @param ctx       User context
+ * @note Runs in the monitored task (dl_end) or in the esp_timer task (hung).
+ */
+typedef void (*dl_escalate_cb_t)(dl_id_t id, bool escalated, void *ctx);
+
+/**
+ * @brief Task registration
+ */
+typedef struct {
+    const char *name;
+    uint32_t period_us;
+    uint32_t budget_us;         // Execution budget per iteration (<= period_us)
+    dl_escalate_cb_t on_escalate;   // NULL = count only (no hung poll)
+    void *ctx;
+} dl_config_t;
+
+/**
+ * @brief Per-task statistics
+ */
+typedef struct {
+    uint32_t iterations;
+    uint32_t overruns;          // Execution time > budget
+    uint32_t misses;            // End > release + period
+    uint32_t skipped;           // Whole periods lost to late starts
+    uint32_t exec_last_us;
+    uint32_t exec_max_us;       // WCET since dl_start()
+    uint32_t start_late_max_us; // Start - release (release jitter)
+    uint32_t escalations;
+    uint32_t hung;              // Escalations by the poll (iteration never ended)
+    uint8_t consecutive;        // Current run of misses
+    uint8_t window_misses;      // Misses in the last DL_WINDOW iterations
+    bool escalated;
+} dl_stats_t;
+
+/**
+ * @brief Tracker state (pure, timestamps in us, wrap-safe)
+ */
+typedef struct {
+    dl_config_t cfg;
+    dl_stats_t stats;
+    uint32_t release_us;
+    uint32_t start_us;
+    uint64_t history;           // Bit i = miss i iterations ago
+    uint8_t clean;              // On-time iterations in a row (while escalated)
+    bool has_release;
+    bool in_iteration;
+} dl_track_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Reset a tracker with its configuration (statistics cleared)
+ */
+void dl_track_init(dl_track_t *t, const dl_config_t *cfg);
+
+/**
+ * @brief Loop restarted: forget the release phase and clear the counters
+ * @note The escalation state (and its recovery count) is kept.
+ */
+void dl_track_restart(dl_track_t *t);
+
+/**
+ * @brief Iteration start
+ */
+void dl_track_begin(dl_track_t *t, uint32_t now_us);
+
+/**
+ * @brief Iteration end: overrun / miss accounting and escalation
+ * @return true if the escalation state changed (see stats.escalated)
+ */
+bool dl_track_end(dl_track_t *t, uint32_t now_us);
+
+/**
+ * @brief Hung-iteration check (an open iteration older than DL_HUNG_PERIODS)
+ * @return true if this call escalated the task
+ */
+bool dl_track_poll(dl_track_t *t, uint32_t now_us);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Register a periodic task (init time)
+ * @param cfg Configuration (copied; name must stay valid)
+ * @param out Task id for the other calls
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_NO_MEM (DL_MAX_TASKS)
+ */
+esp_err_t dl_register(const dl_config_t *cfg, dl_id_t *out);
+
+/**
+ * @brief Loop (re)started: new release phase, WCET and counters cleared
+ * @note An escalation is kept until DL_RECOVER_CLEAN on-time iterations.
+ */
+void dl_start(dl_id_t id);
+
+/**
+ * @brief Loop paused: no accounting, no hung check until dl_start()
+ */
+void dl_stop(dl_id_t id);
+
+/**
+ * @brief Iteration start (call first thing after the task wakes for its period)
+ */
+void dl_begin(dl_id_t id);
+
+/**
+ * @brief Iteration end (calls the escalation callback on a change)
+ */
+void dl_end(dl_id_t id);
+
+/**
+ * @brief Check whether a task is escalated
+ */
+bool dl_is_escalated(dl_id_t id);
+
+/**
+ * @brief Copy statistics of one task
+ */
+void dl_get_stats(dl_id_t id, dl_stats_t *out);
+
+/**
+ * @brief Measure the cost of one dl_begin() + dl_end() pair
+ * @return CPU cycles per pair (on a scratch tracker)
+ */
+uint32_t dl_measure_cost(void);
+
+/**
+ * @brief Print per-task deadline statistics to console
+ */
+void dl_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_DEADLINE_H
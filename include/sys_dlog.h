@@ -0,0 +1,230 @@
+/**
+ * @file sys_dlog.h
+ * @brief Deferred Binary Logging (format ID + raw arguments, decoded on the host)
+ * @details
+ * DLOGI(TAG, "Status: %.2fV (%.1f%%)", v, pct) does no formatting on the
+ * target. The call site stores the address of its format string (in
+ * flash .rodata), the TAG address, a timestamp and the raw argument
+ * words in the ring of the calling core, then returns. The dlog task
+ * sends the entries as binary frames to the sink (console by default).
+ * tools/dlog_decode.py reads the format strings back from the firmware
+ * ELF and prints the text.
+ *
+ * Entry (32-bit words):
+ *
+ *   fmt_addr  tag_addr  time_us(low 32)  meta  arg words...
+ *   meta := types(16, 2 bits per arg) | nargs(4) << 16 | level(4) << 20 | dropped(8) << 24
+ *
+ * Argument types are chosen at compile time with _Generic:
+ * - integers up to 32 bits: 1 word; 64-bit integers: 2 words;
+ * - float and double: 1 word (stored as float);
+ * - char pointers: 1 word (address). Only use %s with strings that live
+ *   in flash (literals, constant name tables); other pointers decode
+ *   as "<0x...>".
+ * At most DLOG_MAX_ARGS arguments.
+ *
+ * Each core has its own ring, so producers never share a lock across
+ * cores. The reservation masks interrupts on the local core for a few
+ * instructions, so tasks and ISRs on the same core can log too. If the
+ * ring is full the entry is dropped; the next entry carries the count.
+ *
+ * Frame on the sink: DLOG_SYNC0 DLOG_SYNC1 core(u8) nwords(u8) words(LE) xor8
+ */
+
+#ifndef SYS_DLOG_H
+#define SYS_DLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define DLOG_RING_WORDS         1024        // Per core (power of 2): 4KB
+#define DLOG_MAX_ARGS           6
+#define DLOG_HDR_WORDS          4
+#define DLOG_ENTRY_MAX_WORDS    (DLOG_HDR_WORDS + 2 * DLOG_MAX_ARGS)
+#define DLOG_CORES              2
+#define DLOG_SYNC0              0x1E
+#define DLOG_SYNC1              0xD1
+#define DLOG_FRAME_MAX          (4 + 4 * DLOG_ENTRY_MAX_WORDS + 1)
+
+#define DLOG_DRAIN_MS           20
+#define DLOG_TASK_STACK         2560
+#define DLOG_TASK_PRIORITY      2
+#define DLOG_TASK_CORE          0
+
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL              DLOG_INFO   // Compile-time threshold
+#endif
+
+#define DLOG_ERROR              1
+#define DLOG_WARN               2
+#define DLOG_INFO               3
+#define DLOG_DEBUG              4
+
+/**
+ * @brief Argument type codes (2 bits each in meta)
+ */
+#define DLOG_T_INT              0           // <= 32-bit integer
+#define DLOG_T_FLOAT            1           // float / double, stored as float
+#define DLOG_T_STR              2           // char pointer (address)
+#define DLOG_T_INT64            3           // 64-bit integer, 2 words (low first)
+
+/*----------------------------------------
+            CALL-SITE MACROS
+  ----------------------------------------*/
+
+#define DLOG_TYPE(x) _Generic((x),                                  \
+    float: DLOG_T_FLOAT, double: DLOG_T_FLOAT,                      \
+    char *: DLOG_T_STR, const char *: DLOG_T_STR,                   \
+    long long: DLOG_T_INT64, unsigned long long: DLOG_T_INT64,      \
+    default: DLOG_T_INT)
+
+#define DLOG_NARGS(...)         DLOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, N, ...) N
+
+#define DLOG_CAT(a, b)          DLOG_CAT_(a, b)
+#define DLOG_CAT_(a, b)         a##b
+#define DLOG_TYPES(...)         DLOG_CAT(DLOG_TYPES_, DLOG_NARGS(__VA_ARGS__))(0, ##__VA_ARGS__)
+#define DLOG_TYPES_0(i)                     0
+#define DLOG_TYPES_1(i, a)                  (DLOG_TYPE(a) << (2 * (i)))
+#define DLOG_TYPES_2(i, a, ...)             (DLOG_TYPE(a) << (2 * (i))) | DLOG_TYPES_1(i + 1, __VA_ARGS__)
+#define DLOG_TYPES_3(i, a, ...)             (DLOG_TYPE(a) << (2 * (i))) | DLOG_TYPES_2(i + 1, __VA_ARGS__)
+#define DLOG_TYPES_4(i, a, ...)             (DLOG_TYPE(a) << (2 * (i))) | DLOG_TYPES_3(i + 1, __VA_ARGS__)
+#define DLOG_TYPES_5(i, a, ...)             (DLOG_TYPE(a) << (2 * (i))) | DLOG_TYPES_4(i + 1, __VA_ARGS__)
+#define DLOG_TYPES_6(i, a, ...)             (DLOG_TYPE(a) << (2 * (i))) | DLOG_TYPES_5(i + 1, __VA_ARGS__)
+
+#define DLOG_META(level, ...) \
+    ((uint32_t)(DLOG_TYPES(__VA_ARGS__)) | ((uint32_t)DLOG_NARGS(__VA_ARGS__) << 16) | ((uint32_t)(level) << 20))
+
+#define DLOG_AT(level, tag, fmt, ...) do {                                          \
+    _Static_assert(DLOG_NARGS(__VA_ARGS__) <= DLOG_MAX_ARGS, "too many DLOG args"); \
+    if ((level) <= DLOG_LEVEL) dlog_write(DLOG_META(level, ##__VA_ARGS__), (tag), (fmt), ##__VA_ARGS__); \
+} while (0)
+
+#define DLOGE(tag, fmt, ...)    DLOG_AT(DLOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...)    DLOG_AT(DLOG_WARN,  tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...)    DLOG_AT(DLOG_INFO,  tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...)    DLOG_AT(DLOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Word ring (one per core)
+ */
+typedef struct {
+    uint32_t *buf;
+    uint32_t size;              // Words, power of 2
+    uint32_t head;              // Producers (same core, interrupts masked)
+    uint32_t tail;              // dlog task
+    uint32_t dropped;           // Since the last stored entry
+} dlog_ring_t;
+
+/**
+ * @brief Output sink for encoded frames (runs in the dlog task)
+ */
+typedef void (*dlog_sink_fn_t)(const uint8_t *frame, size_t len, void *ctx);
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    uint32_t written[DLOG_CORES];
+    uint32_t dropped[DLOG_CORES];
+    uint32_t frames;                // Frames sent to the sink
+    uint32_t ring_peak[DLOG_CORES]; // Words
+    uint32_t dlog_cycles;           // dlog_measure_cost(): one DLOGI call
+    uint32_t esplog_cycles;         // ... the same message through ESP_LOGI
+} dlog_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Build an entry from the call-site arguments
+ * @param w    Output (DLOG_ENTRY_MAX_WORDS)
+ * @param meta DLOG_META() (dropped bits ignored)
+ * @return Entry length in words
+ */
+size_t dlog_encode(uint32_t *w, uint32_t meta, const char *tag, const char *fmt, uint32_t time_us, va_list ap);
+
+/**
+ * @brief Initialize a ring over a word buffer
+ */
+void dlog_ring_init(dlog_ring_t *r, uint32_t *buf, uint32_t size_words);
+
+/**
+ * @brief Store an entry (caller excludes other producers of this ring)
+ * @return false if full (counted in r->dropped, reported with the next entry)
+ */
+bool dlog_ring_put(dlog_ring_t *r, uint32_t *w, size_t n);
+
+/**
+ * @brief Take the oldest entry
+ * @param w Output (DLOG_ENTRY_MAX_WORDS)
+ * @return Entry length in words, 0 if empty
+ */
+size_t dlog_ring_get(dlog_ring_t *r, uint32_t *w);
+
+/**
+ * @brief Encode an entry as a sink frame
+ * @param out Output (DLOG_FRAME_MAX bytes)
+ * @return Frame length
+ */
+size_t dlog_frame(uint8_t core, const uint32_t *w, size_t n, uint8_t *out);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Call-site entry point (use the DLOGx macros)
+ * @note Safe from tasks and ISRs on either core; never blocks. Entries made
+ *       before dlog_init() wait in the ring.
+ */
+void dlog_write(uint32_t meta, const char *tag, const char *fmt, ...);
+
+/**
+ * @brief Start the dlog task
+ * @return ESP_OK on success
+ */
+esp_err_t dlog_init(void);
+
+/**
+ * @brief Replace the sink (default: binary frames on the console)
+ */
+void dlog_set_sink(dlog_sink_fn_t sink, void *ctx);
+
+/**
+ * @brief Time one DLOGI and one ESP_LOGI call with the same message (cycles)
+ * @note Prints two console lines through ESP_LOGI (warm-up and timed).
+ */
+void dlog_measure_cost(void);
+
+/**
+ * @brief Copy statistics
+ */
+void dlog_get_stats(dlog_stats_t *out);
+
+/**
+ * @brief Print statistics to console
+ */
+void dlog_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_DLOG_H
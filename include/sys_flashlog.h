@@ -0,0 +1,186 @@
+/**
+ * @file sys_flashlog.h
+ * @brief Store-and-Forward Record Log in Flash (partition "tlmlog")
+ * @details
+ * Ring of 4KB sectors, each starting with {magic, seq}. Records are
+ * appended as {len, crc16, state} + payload (4-byte aligned) and never
+ * span sectors.
+ *
+ * - Crash safety: header is programmed before the payload, so a torn write
+ *   fails the CRC; mount seals such a sector and carries on in the next.
+ * - Consumption: a drained record's state byte is programmed 0xFF -> 0x00
+ *   (no erase). A sector is erased only when fully drained, or when the
+ *   ring is full and the oldest sector is dropped: every sector is erased
+ *   at most once per pass around the ring (uniform wear).
+ * - Producers never touch flash: records go through a RAM staging ring
+ *   to the flashlog task, which also drains at FLOG_DRAIN_INTERVAL_MS,
+ *   one record in flight, consumed only once delivery is confirmed.
+ *
+ * Capacity (128 KB partition): ~275 telemetry batches, about 12 min of
+ * outage at 10 Hz; longer outages keep the newest 12 min.
+ */
+
+#ifndef SYS_FLASHLOG_H
+#define SYS_FLASHLOG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define FLOG_PARTITION_LABEL    "tlmlog"
+#define FLOG_SECTOR_SIZE        4096
+#define FLOG_MAGIC              0x474F4C54  // "TLOG"
+#define FLOG_SECTOR_HDR_BYTES   8
+#define FLOG_RECORD_HDR_BYTES   8
+#define FLOG_MAX_RECORD         1024        // Largest payload
+
+#define FLOG_STAGING_BYTES      4096        // RAM staging ring (producers -> task)
+#define FLOG_DRAIN_INTERVAL_MS  200         // One record per interval (5 records/s)
+#define FLOG_ACK_TIMEOUT_MS     30000       // No flashlog_drain_done(): offer the record again
+#define FLOG_TASK_STACK         3072
+#define FLOG_TASK_PRIORITY      2
+#define FLOG_TASK_CORE          0
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Flash access (esp_partition on target, a file on the host)
+ * @note Addresses are partition-relative. Return false on error.
+ */
+typedef struct {
+    bool (*read)(void *ctx, uint32_t addr, void *buf, size_t len);
+    bool (*write)(void *ctx, uint32_t addr, const void *buf, size_t len);
+    bool (*erase)(void *ctx, uint32_t addr, size_t len);
+    void *ctx;
+    uint32_t size;              // Partition size (multiple of FLOG_SECTOR_SIZE)
+} flog_flash_t;
+
+/**
+ * @brief Log statistics
+ */
+typedef struct {
+    uint32_t appended;
+    uint32_t consumed;
+    uint32_t dropped;           // Oldest records lost to overwrite (ring full)
+    uint32_t corrupt;           // Records failing CRC (torn writes)
+    uint32_t erases;
+    uint32_t flash_errors;
+    uint32_t reads;             // Flash read calls
+} flog_stats_t;
+
+/**
+ * @brief Log state
+ */
+typedef struct {
+    flog_flash_t flash;
+    uint16_t sector_count;
+    uint16_t head_sector;       // Sector being written
+    uint32_t head_off;          // Next write offset in head sector
+    uint16_t tail_sector;       // Oldest sector with pending records
+    uint32_t tail_off;          // Next record to drain in tail sector
+    uint32_t next_seq;
+    uint32_t pending;           // Records not yet consumed
+    uint16_t peek_len;          // Record returned by flog_peek (0 = none)
+    flog_stats_t stats;
+} flog_t;
+
+/**
+ * @brief Drain hook: start forwarding one record
+ * @details The record stays pending until the sender confirms delivery with
+ *          flashlog_drain_done(true) (e.g. MQTT PUBACK); a failure or no
+ *          answer within FLOG_ACK_TIMEOUT_MS offers it again.
+ * @return true if the send started, false to retry later
+ */
+typedef bool (*flog_send_fn_t)(const uint8_t *data, size_t len, void *ctx);
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Recover log state from flash (erases foreign/torn sector headers)
+ * @param log   Log object
+ * @param flash Flash access (copied)
+ * @return false on flash error or bad geometry
+ */
+bool flog_mount(flog_t *log, const flog_flash_t *flash);
+
+/**
+ * @brief Append a record (drops the oldest sector if the ring is full)
+ * @return false on flash error or bad length
+ */
+bool flog_append(flog_t *log, const void *data, size_t len);
+
+/**
+ * @brief Read the oldest pending record
+ * @param log Log object
+ * @param buf Output buffer (FLOG_MAX_RECORD bytes)
+ * @param cap Buffer size
+ * @return Record length, 0 if the log is empty
+ */
+size_t flog_peek(flog_t *log, void *buf, size_t cap);
+
+/**
+ * @brief Mark the record returned by flog_peek() as consumed
+ */
+void flog_consume(flog_t *log);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Mount the "tlmlog" partition and start the flashlog task
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the partition is missing
+ */
+esp_err_t flashlog_init(void);
+
+/**
+ * @brief Queue a record for flash (copied, never blocks)
+ * @return false if not initialized or the staging ring is full
+ */
+bool flashlog_push(const void *data, size_t len);
+
+/**
+ * @brief Set the drain hook (called from the flashlog task)
+ */
+void flashlog_set_drain(flog_send_fn_t send, void *ctx);
+
+/**
+ * @brief Outcome of the record handed to the drain hook (any task)
+ * @param ok true = delivered (record consumed), false = retry it
+ */
+void flashlog_drain_done(bool ok);
+
+/**
+ * @brief Check for stored records not yet forwarded
+ * @return true if records are staged or pending in flash
+ */
+bool flashlog_has_backlog(void);
+
+/**
+ * @brief Copy statistics
+ */
+void flashlog_get_stats(flog_stats_t *out, uint32_t *pending);
+
+/**
+ * @brief Print log statistics to console
+ */
+void flashlog_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_FLASHLOG_H
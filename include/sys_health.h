@@ -0,0 +1,228 @@
+/**
+ * @file sys_health.h
+ * @brief Online Sensor Health Engine (per-channel running statistics, OK/DEGRADED/FAILED)
+ * @details
+ * Each sensor channel is fed every sample (or every failed read) by its
+ * driver and keeps a fixed amount of state:
+ *
+ * - Welford mean/variance over blocks of HEALTH_BLOCK_LEN samples. The
+ *   variance of the last full block is checked against a noise floor
+ *   (a live HX711 or echo always jitters) and a noise ceiling (loose
+ *   connector, interference).
+ * - Stuck value: run of consecutive samples within stuck_eps of the
+ *   previous one.
+ * - Rate of change: |dx/dt| above max_rate, tracked as an EMA fraction
+ *   of samples.
+ * - Dropout: failed reads (timeout, LC/US error code, ADC error) as an
+ *   EMA fraction of attempts.
+ *
+ * The channel status is the worst detector level. EMA detectors leave the
+ * DEGRADED level at half of their entry threshold, so a channel does not
+ * flap around it. A zero threshold disables that detector.
+ *
+ * Mission logic reads health_get_status() / health_worst(); telemetry
+ * carries health_pack() (2 bits per channel) in the "health" field.
+ */
+
+#ifndef SYS_HEALTH_H
+#define SYS_HEALTH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define HEALTH_BLOCK_LEN        32          // Welford block (samples)
+#define HEALTH_EMA_SHIFT        5           // EMA weight 1/32 for rate and dropout fractions
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Channel status (2 bits, part of the telemetry schema)
+ */
+typedef enum {
+    HEALTH_OK       = 0,
+    HEALTH_DEGRADED = 1,
+    HEALTH_FAILED   = 2,
+} health_status_t;
+
+/**
+ * @brief Monitored channels (order is part of the telemetry schema)
+ * @note HEALTH_CH_COUNT means "not monitored" to the drivers; samples fed
+ * to it are ignored.
+ */
+typedef enum {
+    HEALTH_CH_LC_FRONT = 0,     // HX711 raw counts
+    HEALTH_CH_LC_LEFT,
+    HEALTH_CH_LC_RIGHT,
+    HEALTH_CH_US_FRONT,         // JSN-SR04T raw mm
+    HEALTH_CH_US_LEFT,
+    HEALTH_CH_US_RIGHT,
+    HEALTH_CH_BATT,             // Instant pack voltage (V)
+    HEALTH_CH_COUNT
+} health_channel_t;
+
+#define HEALTH_MASK_LOADCELL    ((1u << HEALTH_CH_LC_FRONT) | (1u << HEALTH_CH_LC_LEFT) | (1u << HEALTH_CH_LC_RIGHT))
+#define HEALTH_MASK_ULTRASONIC  ((1u << HEALTH_CH_US_FRONT) | (1u << HEALTH_CH_US_LEFT) | (1u << HEALTH_CH_US_RIGHT))
+#define HEALTH_MASK_ALL         ((1u << HEALTH_CH_COUNT) - 1)
+
+/**
+ * @brief Detector bits (health_chan_t.cause)
+ */
+typedef enum {
+    HEALTH_CAUSE_STUCK   = 1 << 0,
+    HEALTH_CAUSE_FLAT    = 1 << 1,      // Block variance below the noise floor
+    HEALTH_CAUSE_NOISY   = 1 << 2,      // Block variance above the ceiling
+    HEALTH_CAUSE_RATE    = 1 << 3,
+    HEALTH_CAUSE_DROPOUT = 1 << 4,
+} health_cause_t;
+
+/**
+ * @brief Detector thresholds of a channel (0 disables a detector)
+ */
+typedef struct {
+    float stuck_eps;            // |x - prev| <= eps counts as "unchanged"
+    uint16_t stuck_degraded;    // Unchanged run length for DEGRADED
+    uint16_t stuck_failed;      // ... for FAILED
+    float var_min;              // Block variance floor (DEGRADED below)
+    float var_max;              // Block variance ceiling (DEGRADED above)
+    float max_rate;             // Units per second
+    float rate_degraded;        // Fraction of samples over max_rate
+    float rate_failed;
+    float drop_degraded;        // Fraction of failed reads
+    float drop_failed;
+} health_cfg_t;
+
+/**
+ * @brief Channel state (constant size)
+ */
+typedef struct {
+    // Welford accumulator of the current block
+    uint16_t n;
+    float mean;
+    float m2;
+
+    // Last full block
+    float block_mean;
+    float block_var;
+    bool block_valid;
+
+    float prev;
+    int64_t prev_us;
+    bool has_prev;
+    uint16_t stuck_run;
+    float rate_ema;
+    float drop_ema;
+
+    uint8_t status;             // health_status_t
+    uint8_t cause;              // health_cause_t bits currently active
+
+    uint32_t samples;
+    uint32_t dropouts;
+    uint32_t rate_faults;
+} health_chan_t;
+
+/**
+ * @brief Per-channel statistics snapshot
+ */
+typedef struct {
+    health_chan_t chan;
+    uint32_t transitions;       // Status changes
+    uint32_t update_cycles_max;
+    uint32_t update_cycles_avg;
+} health_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Default thresholds per sensor type (HX711 raw counts, JSN-SR04T mm, pack V)
+ */
+extern const health_cfg_t health_cfg_loadcell;
+extern const health_cfg_t health_cfg_ultrasonic;
+extern const health_cfg_t health_cfg_battery;
+
+/**
+ * @brief Clear a channel (status OK, no history)
+ */
+void health_chan_reset(health_chan_t *c);
+
+/**
+ * @brief Feed one valid sample
+ * @param t_us Sample time (any monotonic microsecond clock)
+ * @return New status
+ */
+health_status_t health_chan_sample(health_chan_t *c, const health_cfg_t *cfg, float x, int64_t t_us);
+
+/**
+ * @brief Feed one failed read
+ * @return New status
+ */
+health_status_t health_chan_dropout(health_chan_t *c, const health_cfg_t *cfg);
+
+/**
+ * @brief Standard deviation of the last full block (0 before the first one)
+ */
+float health_chan_stddev(const health_chan_t *c);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Reset all channels with their default thresholds
+ * @note Channels work without it (static defaults); call again to clear history.
+ */
+esp_err_t health_init(void);
+
+/**
+ * @brief Feed a valid sample (called by the sensor driver)
+ * @note One producer task per channel. A few dozen cycles.
+ */
+void health_sample(health_channel_t ch, float x, int64_t t_us);
+
+/**
+ * @brief Feed a failed read (called by the sensor driver)
+ */
+void health_dropout(health_channel_t ch);
+
+/**
+ * @brief Current status of a channel (any task)
+ */
+health_status_t health_get_status(health_channel_t ch);
+
+/**
+ * @brief Worst status among the channels in a mask (HEALTH_MASK_*)
+ */
+health_status_t health_worst(uint32_t mask);
+
+/**
+ * @brief All statuses, 2 bits per channel (channel i at bits 2i..2i+1)
+ */
+uint16_t health_pack(void);
+
+/**
+ * @brief Copy a channel's statistics (values may be one sample apart)
+ */
+void health_get_stats(health_channel_t ch, health_stats_t *out);
+
+/**
+ * @brief Print per-channel health to console
+ */
+void health_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_HEALTH_H
@@ -0,0 +1,156 @@
+/**
+ * @file sys_ident.h
+ * @brief System Identification Mode (propulsion & yaw plant)
+ * @details
+ * - Plays a scripted excitation (step or linear chirp) through
+ *   motor_set_speed(), either common-mode (thrust) or differential (yaw).
+ * - Captures command, yaw rate and thrust at a fixed rate into a static
+ *   packed buffer (no allocation while running).
+ * - Reports achieved sample rate and dropped slots. The capture is dumped
+ *   as text over the console and fitted on the host (tools/sysid_fit.py).
+ *
+ * @warning Drives the motors directly: stop the heading controller first
+ * and only run with the craft tethered or in open water.
+ */
+
+#ifndef SYS_IDENT_H
+#define SYS_IDENT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define SYSID_RATE_HZ           200         // Capture rate (IMU delivers 100Hz batches of 1kHz data)
+#define SYSID_PERIOD_US         (1000000 / SYSID_RATE_HZ)
+#define SYSID_MAX_SAMPLES       4096        // 20s @ 200Hz, 10 bytes each (40KB .bss)
+#define SYSID_MAX_DURATION_S    ((float)SYSID_MAX_SAMPLES / SYSID_RATE_HZ)
+#define SYSID_MAX_AMPLITUDE_RAW 3000        // Safety clamp on excitation amplitude
+
+#define SYSID_YAW_UNIT_DPS      0.1f        // Stored yaw rate resolution (deg/s per LSB)
+#define SYSID_THRUST_UNIT_G     1.0f        // Stored thrust resolution (g per LSB)
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Excitation waveform
+ */
+typedef enum {
+    SYSID_SIGNAL_STEP = 0,      // Step up at settle_s, back to base at mid-excitation
+    SYSID_SIGNAL_CHIRP,         // Linear sine sweep f0 -> f1
+} sysid_signal_t;
+
+/**
+ * @brief Which plant input is excited
+ */
+typedef enum {
+    SYSID_AXIS_THRUST = 0,      // left = right = base + e(t)
+    SYSID_AXIS_YAW,             // left = base + e(t), right = base - e(t)
+} sysid_axis_t;
+
+/**
+ * @brief Test script
+ */
+typedef struct {
+    sysid_signal_t signal;
+    sysid_axis_t axis;
+    uint16_t base_raw;          // Operating point (0-10000, MOTOR_IDLE_RAW = stop)
+    uint16_t amplitude_raw;     // Excitation amplitude (raw units)
+    float settle_s;             // Time at base before the excitation starts
+    float duration_s;           // Total capture time (<= SYSID_MAX_DURATION_S)
+    float f0_hz;                // Chirp start frequency
+    float f1_hz;                // Chirp end frequency
+} sysid_script_t;
+
+/**
+ * @brief Signal sources, sampled every capture period
+ * @note Must return immediately (latest cached value), never block on a bus.
+ */
+typedef struct {
+    float (*yaw_rate_dps)(void *ctx);   // Body yaw rate (deg/s, clockwise positive)
+    float (*thrust_g)(void *ctx);       // Load-cell thrust (g)
+    void *ctx;
+} sysid_sources_t;
+
+/**
+ * @brief One captured sample (packed, 10 bytes)
+ */
+typedef struct __attribute__((packed)) {
+    uint16_t slot;              // Sample index since start (gaps = dropped slots)
+    uint16_t left_raw;          // Commanded left motor
+    uint16_t right_raw;         // Commanded right motor
+    int16_t yaw_rate;           // SYSID_YAW_UNIT_DPS per LSB
+    int16_t thrust;             // SYSID_THRUST_UNIT_G per LSB
+} sysid_sample_t;
+
+/**
+ * @brief Capture statistics
+ */
+typedef struct {
+    uint32_t samples;           // Samples stored
+    uint32_t dropped;           // Capture slots missed (callback ran late)
+    uint32_t interval_max_us;   // Worst gap between two captures
+    float achieved_rate_hz;     // samples / elapsed
+    bool is_running;
+} sysid_stats_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Excitation command at time t (pure, host-testable)
+ * @param script    Test script
+ * @param t_s       Time since start (s)
+ * @param left_raw  Output left command
+ * @param right_raw Output right command
+ */
+void sysid_excitation(const sysid_script_t *script, float t_s, uint16_t *left_raw, uint16_t *right_raw);
+
+/**
+ * @brief Start a capture run
+ * @param script  Test script (copied)
+ * @param sources Signal sources (copied)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG on a bad script, ESP_ERR_INVALID_STATE if running
+ */
+esp_err_t sysid_start(const sysid_script_t *script, const sysid_sources_t *sources);
+
+/**
+ * @brief Abort a running capture (motors back to MOTOR_IDLE_RAW)
+ */
+void sysid_abort(void);
+
+/**
+ * @brief Copy capture statistics
+ * @param out Output statistics
+ */
+void sysid_get_stats(sysid_stats_t *out);
+
+/**
+ * @brief Access the capture buffer (valid once the run has finished)
+ * @param count Output number of samples
+ * @return Pointer to samples, NULL while running
+ */
+const sysid_sample_t *sysid_get_samples(uint32_t *count);
+
+/**
+ * @brief Print the capture as text for tools/sysid_fit.py
+ * @details Format: one "#SYSID ..." header line with the script, then
+ * "slot,left,right,yaw_dps,thrust_g" rows, then "#END".
+ */
+void sysid_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_IDENT_H
@@ -0,0 +1,255 @@
+/**
+ * @file sys_mem.h
+ * @brief Static Memory Budget (per-subsystem arenas, fixed-block pools, heap lock)
+ * @details
+ * The runtime does not use the heap after init:
+ * - Arenas: one static region, split at boot into one arena per subsystem
+ *   (MEM_BUDGET_TABLE). Task stacks, TCBs, queue storage and pools are
+ *   carved from the owner's arena (bump allocation, never freed); a
+ *   subsystem that outgrows its budget fails its init with ESP_ERR_NO_MEM
+ *   instead of eating into everyone's heap. Modules _Static_assert their
+ *   worst case against their budget, so most overruns fail the build.
+ * - Pools: fixed-size blocks with an O(1) free list for buffers that come
+ *   and go at runtime (MQTT publishes). No fragmentation, bounded count.
+ * - Heap lock: after mem_heap_lock() every heap allocation is counted and
+ *   the first few are kept (size, task) for mem_log_report(), except in
+ *   tasks that declared an exemption (OTA: mbedtls, esp_ota). Needs
+ *   CONFIG_HEAP_USE_HOOKS; without it only the free-heap drift is checked.
+ *
+ * tools/mem_stress.c prints the budget table and compares pools against a
+ * general-purpose heap over a long synthetic standby.
+ */
+
+#ifndef SYS_MEM_H
+#define SYS_MEM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define MEM_ALIGN               16          // Arena allocations and pool blocks
+#define MEM_TASK_OVERHEAD       512         // >= sizeof(StaticTask_t) (checked in sys_mem.c)
+#define MEM_QUEUE_OVERHEAD      96          // >= sizeof(StaticQueue_t)
+#define MEM_POOL_OVERHEAD       64          // >= sizeof(mem_pool_t)
+#define MEM_MAX_POOLS           8           // Registered for the report
+#define MEM_MAX_EXEMPT          4           // Tasks allowed to allocate while locked
+#define MEM_HEAP_LOG_MAX        8           // Locked-heap allocations kept for the report
+
+#define MEM_ALIGN_UP(n)         (((n) + MEM_ALIGN - 1) & ~(size_t)(MEM_ALIGN - 1))
+#define MEM_TASK_BYTES(stack)   (MEM_ALIGN_UP(stack) + MEM_ALIGN_UP(MEM_TASK_OVERHEAD))
+#define MEM_QUEUE_BYTES(len, item)  (MEM_ALIGN_UP((len) * (item)) + MEM_ALIGN_UP(MEM_QUEUE_OVERHEAD))
+#define MEM_POOL_BYTES(block, count)    (MEM_ALIGN_UP(block) * (count) + MEM_ALIGN_UP(MEM_POOL_OVERHEAD))
+
+/**
+ * @brief Subsystem budgets: X(id, name, bytes)
+ * @note Each owner asserts its worst case fits (e.g. drv_imu.c).
+ */
+#define MEM_BUDGET_TABLE(X) \
+    X(IMU,      "imu",          4608)   /* imu_task */ \
+    X(GPS,      "gps",          4608)   /* gps_task */ \
+    X(CTRL,     "ctrl",         4608)   /* ctrl_task */ \
+    X(DLOG,     "dlog",         3072)   /* dlog_task */ \
+    X(BBOX,     "blackbox",     3584)   /* bbox_task */ \
+    X(FLOG,     "flashlog",     7936)   /* flashlog_task, staging ring */ \
+    X(TLM,      "telemetry",    3584)   /* tlm_task */ \
+    X(MODEM,    "modem",        8704)   /* modem_task, message queue, publish pool */ \
+    X(CMD,      "command",      1280)   /* command queue */ \
+    X(OTA,      "ota",          6656)   /* ota_task */
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Subsystem (arena owner)
+ */
+typedef enum {
+#define MEM_SUB_ENUM(id, name, bytes) MEM_SUB_##id,
+    MEM_BUDGET_TABLE(MEM_SUB_ENUM)
+#undef MEM_SUB_ENUM
+    MEM_SUB_COUNT
+} mem_sub_t;
+
+/**
+ * @brief Budget constants (MEM_BUDGET_IMU, ...) and the total region
+ */
+enum {
+#define MEM_BUDGET_ENUM(id, name, bytes) MEM_BUDGET_##id = MEM_ALIGN_UP(bytes),
+    MEM_BUDGET_TABLE(MEM_BUDGET_ENUM)
+#undef MEM_BUDGET_ENUM
+#define MEM_BUDGET_SUM(id, name, bytes) + MEM_ALIGN_UP(bytes)
+    MEM_REGION_BYTES = 0 MEM_BUDGET_TABLE(MEM_BUDGET_SUM)
+#undef MEM_BUDGET_SUM
+};
+
+/**
+ * @brief Bump arena (carved once, never freed)
+ */
+typedef struct {
+    uint8_t *base;
+    uint32_t size;
+    uint32_t used;
+    uint32_t failed;            // Requests that did not fit
+} mem_arena_t;
+
+/**
+ * @brief Fixed-block pool (blocks carved from an arena)
+ */
+typedef struct {
+    const char *name;
+    uint8_t *mem;
+    void *free_list;            // Next free block (link stored in the block)
+    uint32_t block_size;        // Rounded up to MEM_ALIGN
+    uint16_t count;
+    uint16_t in_use;
+    uint16_t peak;
+    uint32_t failed;            // Empty pool on take
+    uint32_t bad_give;          // Pointer not a block of this pool
+} mem_pool_t;
+
+/**
+ * @brief Heap lock event (allocation after mem_heap_lock())
+ */
+typedef struct {
+    uint32_t size;
+    uint32_t caps;
+    const void *task;           // TaskHandle_t of the caller
+    int64_t time_us;
+} mem_heap_event_t;
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    mem_arena_t arenas[MEM_SUB_COUNT];
+    uint8_t pool_count;
+    bool heap_locked;
+    uint32_t heap_at_lock;      // Free heap when locked
+    uint32_t locked_allocs;     // Allocations after the lock (exempt tasks excluded)
+    uint32_t locked_bytes;
+    uint32_t exempt_allocs;
+} mem_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Subsystem name ("imu", ...), "?" if out of range
+ */
+const char *mem_sub_name(mem_sub_t sub);
+
+/**
+ * @brief Budget of a subsystem in bytes (0 if out of range)
+ */
+uint32_t mem_sub_budget(mem_sub_t sub);
+
+void mem_arena_init(mem_arena_t *a, void *base, size_t size);
+
+/**
+ * @brief Bump-allocate (MEM_ALIGN aligned)
+ * @return Zeroed memory, NULL if the arena is exhausted
+ */
+void *mem_arena_alloc(mem_arena_t *a, size_t size);
+
+/**
+ * @brief Set up a pool over caller storage
+ * @param storage MEM_ALIGN aligned, block_size rounded up * count bytes
+ * @return false if block_size is 0 or count is 0
+ */
+bool mem_pool_init(mem_pool_t *p, const char *name, void *storage, size_t block_size, uint16_t count);
+
+/**
+ * @brief Take a block (O(1), not locked: see mem_pool_alloc())
+ * @return Block, NULL if the pool is empty
+ */
+void *mem_pool_take(mem_pool_t *p);
+
+/**
+ * @brief Return a block (O(1), not locked: see mem_pool_free())
+ * @return false if ptr is not a block of this pool (ignored, counted)
+ */
+bool mem_pool_give(mem_pool_t *p, void *ptr);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Split the static region into the subsystem arenas
+ * @note Idempotent; the creation helpers below call it on first use.
+ */
+void mem_init(void);
+
+/**
+ * @brief Allocate raw memory from a subsystem arena (init only)
+ */
+void *mem_alloc(mem_sub_t sub, size_t size);
+
+/**
+ * @brief xTaskCreateStaticPinnedToCore() with stack and TCB from the arena
+ * @return TaskHandle_t, NULL if the budget is exhausted
+ */
+void *mem_task_create(mem_sub_t sub, void (*fn)(void *), const char *name, uint32_t stack_bytes,
+                      void *arg, uint32_t priority, int core);
+
+/**
+ * @brief xQueueCreateStatic() with storage from the arena
+ * @return QueueHandle_t, NULL if the budget is exhausted
+ */
+void *mem_queue_create(mem_sub_t sub, uint32_t len, uint32_t item_size);
+
+/**
+ * @brief Create a block pool in the arena and register it for the report
+ * @return Pool, NULL if the budget is exhausted
+ */
+mem_pool_t *mem_pool_create(mem_sub_t sub, const char *name, size_t block_size, uint16_t count);
+
+/**
+ * @brief mem_pool_take() under a spinlock (tasks and ISRs)
+ */
+void *mem_pool_alloc(mem_pool_t *p);
+
+/**
+ * @brief mem_pool_give() under a spinlock (tasks and ISRs)
+ */
+void mem_pool_free(mem_pool_t *p, void *ptr);
+
+/**
+ * @brief End of init: from now on heap allocations are flagged
+ * @note Call once every module is initialised.
+ */
+void mem_heap_lock(void);
+
+/**
+ * @brief Allow or forbid heap use by the calling task while locked
+ * @details For work that needs IDF/mbedtls allocations by design (OTA);
+ *          counted as exempt, not flagged.
+ * @return ESP_OK, ESP_ERR_NO_MEM if MEM_MAX_EXEMPT tasks are exempt already
+ */
+esp_err_t mem_heap_exempt(bool exempt);
+
+/**
+ * @brief Copy statistics
+ */
+void mem_get_stats(mem_stats_t *out);
+
+/**
+ * @brief Print budgets, arena use, pools, heap fragmentation and lock violations
+ */
+void mem_log_report(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_MEM_H
@@ -0,0 +1,61 @@
+/**
+ * @file sys_mission.h
+ * @brief Mission State (FSM state shared between modules)
+ * @details
+ * Holds the current state of the mission FSM described in README §3.
+ * The FSM logic lives with the application; this module only stores the
+ * state so telemetry, commands and failsafes can read/change it safely
+ * from any task.
+ */
+
+#ifndef SYS_MISSION_H
+#define SYS_MISSION_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Mission FSM states (values are part of the telemetry schema)
+ */
+typedef enum {
+    MISSION_STANDBY = 0,        // Low power, waiting for WAKE
+    MISSION_DISPATCH,           // GPS lock, course plotted
+    MISSION_COURSE_LOCK,        // Long range, GPS course over ground
+    MISSION_FINE_APPROACH,      // Short range, compass/gyro + ultrasonic
+    MISSION_RESCUE,             // Victim on board, motors cut
+    MISSION_RTH,                // Return to home
+    MISSION_STATE_COUNT
+} mission_state_t;
+
+/*----------------------------------------
+            PUBLIC API
+  ----------------------------------------*/
+
+/**
+ * @brief Get current mission state
+ */
+mission_state_t mission_get_state(void);
+
+/**
+ * @brief Set mission state (logged on change)
+ * @param state New state
+ */
+void mission_set_state(mission_state_t state);
+
+/**
+ * @brief State name for logs
+ */
+const char *mission_state_name(mission_state_t state);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_MISSION_H
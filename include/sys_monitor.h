@@ -2,6 +2,7 @@
  * @file sys_monitor.h
  * @brief System Health Monitoring Module
  * @details Handles memory (RAM) statistics, task stack usage, and system diagnostics.
+ *          Budgets and heap-lock violations come from sys_mem.h.
  */
 
 #ifndef SYS_MONITOR_H
@@ -0,0 +1,310 @@
+/**
+ * @file sys_ota.h
+ * @brief Delta Firmware Update over LTE (signed patches, ota_0 / ota_1, rollback)
+ * @details
+ * An update is a patch against the running image. It is fetched with HTTP
+ * range requests and applied straight into the inactive OTA slot:
+ *
+ *   modem HTTP range -> range buffer -> ota_patch_feed() -> sector buffer -> esp_ota_write()
+ *                                              ^ source bytes read from the running slot
+ *
+ * - Patch: header + op stream. The header holds the SHA-256 of the source
+ *   image, of the target image and of the op stream, and an ECDSA P-256
+ *   signature over those. The signature is checked before anything is
+ *   written, the source hash before the first op; the op stream and target
+ *   hashes are computed while streaming and checked before the slot is
+ *   made bootable (esp_ota_end() then validates the image format).
+ * - RAM: one range buffer and one output sector, both static. Nothing is
+ *   kept per byte of image.
+ * - Only in STANDBY; a mission start aborts the update. The craft reboots
+ *   into the new image, which runs on probation (bootloader rollback): it
+ *   must pass the self-test (ota_check_t) within OTA_SELFTEST_TIMEOUT_MS or
+ *   it is marked invalid and the previous image boots again.
+ *
+ * Op stream (pos = source cursor, starts at 0):
+ *
+ *   0x00                          END (last byte of the stream)
+ *   0x01 len:uvar delta:svar      COPY  pos += delta; out = src[pos, pos+len); pos += len
+ *   0x02 len:uvar delta:svar d[]  ADD   pos += delta; out = src[pos+i] + d[i];  pos += len
+ *   0x03 len:uvar data[]          DATA  out = data
+ *
+ * uvar = LEB128, svar = zigzag LEB128. A full image is a patch with
+ * src_size 0 and DATA ops only. Patches are made by tools/ota_mkpatch.py.
+ *
+ * Remote use: "OTA <url>" on CMD_TOPIC (sys_command.h), progress and
+ * result on OTA_STATUS_TOPIC.
+ */
+
+#ifndef SYS_OTA_H
+#define SYS_OTA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+// Patch format
+#define OTA_PATCH_MAGIC         0x50445246  // "FRDP"
+#define OTA_PATCH_FORMAT        1
+#define OTA_HASH_BYTES          32          // SHA-256
+#define OTA_SIG_BYTES           64          // ECDSA P-256 r || s
+#define OTA_HDR_SIGNED_BYTES    116         // Header bytes covered by the signature
+#define OTA_HDR_BYTES           (OTA_HDR_SIGNED_BYTES + OTA_SIG_BYTES)
+#define OTA_PUBKEY_BYTES        65          // Uncompressed P-256 point (0x04 || X || Y)
+
+#if defined(__has_include)
+#if __has_include("sys_ota_key.h")
+#include "sys_ota_key.h"                    // Written by "ota_mkpatch.py keygen --header"
+#endif
+#endif
+
+#ifndef OTA_SIGN_PUBKEY
+#define OTA_SIGN_PUBKEY         { 0 }       // All zero = every patch refused
+#endif
+
+// Streaming buffers
+#define OTA_OUT_BYTES           4096        // Output sector buffer (one esp_ota_write)
+#define OTA_RANGE_BYTES         8192        // HTTP range per request
+
+// Transfer
+#define OTA_URL_MAX             96          // = MODEM_HTTP_URL_MAX
+#define OTA_RANGE_TIMEOUT_MS    120000      // One range request, incl. HTTPACTION
+#define OTA_RANGE_RETRIES       3           // Per range, then the update fails
+#define OTA_REBOOT_DELAY_MS     3000        // Result published -> restart
+
+// Self-test of a new image (probation)
+#define OTA_SELFTEST_TIMEOUT_MS 180000      // Boot -> all checks passed, else rollback
+#define OTA_SELFTEST_PERIOD_MS  1000
+
+#define OTA_STATUS_TOPIC        "frd/ota"
+#define OTA_TASK_STACK          6144        // ECDSA verify
+#define OTA_TASK_PRIORITY       2
+#define OTA_TASK_CORE           0
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Incremental SHA-256
+ */
+typedef struct {
+    uint32_t h[8];
+    uint64_t bytes;
+    uint8_t block[64];
+    uint8_t fill;
+} ota_sha256_t;
+
+/**
+ * @brief Patch header (little-endian on the wire, OTA_HDR_BYTES)
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t format;
+    uint16_t reserved;
+    uint32_t src_size;          // Bytes of the running image the patch applies to (0 = full image)
+    uint32_t dst_size;          // Bytes of the new image
+    uint32_t body_size;         // Bytes of the op stream
+    uint8_t src_hash[OTA_HASH_BYTES];
+    uint8_t dst_hash[OTA_HASH_BYTES];
+    uint8_t body_hash[OTA_HASH_BYTES];
+    uint8_t sig[OTA_SIG_BYTES]; // Over SHA-256 of the first OTA_HDR_SIGNED_BYTES
+} ota_patch_hdr_t;
+
+/**
+ * @brief Patch outcome
+ */
+typedef enum {
+    OTA_PATCH_BUSY = 0,         // More input expected
+    OTA_PATCH_DONE,             // Target written and verified
+    OTA_PATCH_ERR_HEADER,       // Bad magic / format / sizes
+    OTA_PATCH_ERR_SIGNATURE,
+    OTA_PATCH_ERR_SOURCE,       // Running image does not match src_hash
+    OTA_PATCH_ERR_FORMAT,       // Bad op, out-of-range copy, data after END
+    OTA_PATCH_ERR_IO,           // Source read or target write failed
+    OTA_PATCH_ERR_BODY_HASH,
+    OTA_PATCH_ERR_IMAGE_HASH,
+    OTA_PATCH_ERR_ABORTED,      // Set by the caller (link, mission)
+} ota_patch_result_t;
+
+/**
+ * @brief Patch I/O (esp_partition / esp_ota on target, files on the host)
+ * @note Return false on error.
+ */
+typedef struct {
+    bool (*read_src)(void *ctx, uint32_t addr, void *buf, size_t len);
+    bool (*write_dst)(void *ctx, const void *buf, size_t len);     // Sequential
+    bool (*verify_sig)(void *ctx, const uint8_t digest[OTA_HASH_BYTES], const uint8_t sig[OTA_SIG_BYTES]);   // NULL = not checked
+    void *ctx;
+    uint32_t src_limit;         // Size of the running slot
+    uint32_t dst_limit;         // Size of the target slot
+} ota_patch_io_t;
+
+/**
+ * @brief Op counters
+ */
+typedef struct {
+    uint32_t ops;
+    uint32_t copy_bytes;
+    uint32_t add_bytes;
+    uint32_t data_bytes;
+    uint32_t src_reads;         // read_src calls
+    uint32_t writes;            // write_dst calls
+} ota_patch_stats_t;
+
+/**
+ * @brief Streaming patch state (constant size)
+ */
+typedef struct {
+    ota_patch_io_t io;
+    ota_patch_hdr_t hdr;
+    uint8_t hdr_raw[OTA_HDR_BYTES];
+    uint16_t hdr_fill;
+
+    uint8_t state;              // Parser state (private)
+    uint8_t op;
+    uint8_t var_shift;
+    uint32_t var;
+    uint32_t op_len;            // Bytes left in the current op
+    uint32_t src_pos;
+
+    uint32_t body_done;
+    uint32_t out_done;          // Target bytes produced
+    uint16_t out_fill;
+    uint8_t out[OTA_OUT_BYTES];
+    ota_sha256_t body_sha;
+    ota_sha256_t dst_sha;
+
+    ota_patch_result_t result;
+    ota_patch_stats_t stats;
+} ota_patch_t;
+
+/**
+ * @brief Update state
+ */
+typedef enum {
+    OTA_STATE_IDLE = 0,
+    OTA_STATE_DOWNLOADING,      // Fetching and applying
+    OTA_STATE_REBOOTING,        // New image verified and selected
+    OTA_STATE_FAILED,           // Last update failed (slot not selected)
+    OTA_STATE_PROBATION,        // Running a new image, self-test pending
+} ota_state_t;
+
+/**
+ * @brief Self-test checks of a new image
+ */
+typedef enum {
+    OTA_CHECK_MOTOR   = 1 << 0, // Reported by the application once motor_init() (ESC arming) returned
+    OTA_CHECK_SENSORS = 1 << 1, // Polled here: every health channel sampled, none FAILED
+    OTA_CHECK_LINK    = 1 << 2, // Polled here: MQTT broker connected (the next update can reach the craft)
+} ota_check_t;
+
+#define OTA_CHECKS_REQUIRED     (OTA_CHECK_MOTOR | OTA_CHECK_SENSORS | OTA_CHECK_LINK)
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    ota_state_t state;
+    ota_patch_result_t last_result;
+    uint32_t patch_bytes;       // Downloaded (last update)
+    uint32_t image_bytes;       // Written (last update)
+    uint32_t ranges;
+    uint32_t retries;
+    uint32_t duration_ms;       // Start -> verified
+    uint32_t flash_ms;          // Time spent in ota_patch_feed() (source reads, hashing, writes)
+    uint32_t checks_passed;     // ota_check_t bits (probation)
+} ota_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+void ota_sha256_init(ota_sha256_t *s);
+void ota_sha256_update(ota_sha256_t *s, const void *data, size_t len);
+void ota_sha256_final(ota_sha256_t *s, uint8_t out[OTA_HASH_BYTES]);
+
+/**
+ * @brief Decode a header (no checks beyond the byte layout)
+ */
+void ota_patch_parse_header(const uint8_t raw[OTA_HDR_BYTES], ota_patch_hdr_t *out);
+
+/**
+ * @brief Reset the streaming state
+ * @param p  Patch state
+ * @param io I/O hooks (copied)
+ */
+void ota_patch_init(ota_patch_t *p, const ota_patch_io_t *io);
+
+/**
+ * @brief Consume patch bytes (any split), applying ops as they complete
+ * @details When the header is complete: checks sizes, signature and the
+ * source hash (reads src_size bytes). After END: flushes the output and
+ * checks both hashes and sizes.
+ * @return OTA_PATCH_BUSY until END, then DONE or the first error (sticky)
+ */
+ota_patch_result_t ota_patch_feed(ota_patch_t *p, const uint8_t *data, size_t len);
+
+/**
+ * @brief Check whether the header has been accepted (p->hdr valid)
+ */
+bool ota_patch_header_ok(const ota_patch_t *p);
+
+/**
+ * @brief Short name of a result ("DONE", "ERR_SOURCE", ...)
+ */
+const char *ota_patch_result_name(ota_patch_result_t r);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Start the OTA task; on a probation boot start the self-test
+ * @note Call after modem_init() and health_init().
+ * @return ESP_OK, ESP_ERR_NOT_FOUND if the partition table has no OTA slots
+ */
+esp_err_t ota_init(void);
+
+/**
+ * @brief Start an update from a patch URL (non-blocking)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (URL), ESP_ERR_INVALID_STATE (busy,
+ *         on probation or not in STANDBY)
+ */
+esp_err_t ota_start(const char *url);
+
+/**
+ * @brief Report a self-test check (probation boot; ignored otherwise)
+ * @param check  Check
+ * @param passed false rolls back at once (motors disarmed, previous image)
+ */
+void ota_selftest_report(ota_check_t check, bool passed);
+
+/**
+ * @brief Current state
+ */
+ota_state_t ota_get_state(void);
+
+/**
+ * @brief Copy statistics
+ */
+void ota_get_stats(ota_stats_t *out);
+
+/**
+ * @brief Print update statistics to console
+ */
+void ota_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_OTA_H
@@ -0,0 +1,199 @@
+/**
+ * @file sys_param.h
+ * @brief Runtime-Tunable Parameter Registry (NVS-backed)
+ * @details
+ * Field-tunable thresholds are listed once in SYSPARAM_TABLE. The table
+ * generates:
+ * - `sysparam`, the struct the hot paths read directly
+ *   (`sysparam.us_spike_mm`: one load, no lookup, no lock);
+ * - the descriptor table (name, type, default, range) used by get/set.
+ *
+ * Only sysparam_set() writes, from one task (the command handler). Every
+ * field is an aligned 32-bit word, so readers on either core see the old
+ * or the new value, never half of each. A value takes effect on the next
+ * sample of the filter that reads it.
+ *
+ * Values are stored in NVS namespace SYSPARAM_NVS_NAMESPACE, one key per
+ * parameter (the parameter name). A missing or out-of-range stored value
+ * falls back to the default, so adding, removing or re-ranging a row needs
+ * no migration.
+ *
+ * Remote access via sys_command (replies on SYSPARAM_REPLY_TOPIC):
+ *   PARAM GET                 All parameters, one "name=value" per line
+ *   PARAM GET name            One parameter
+ *   PARAM SET name value      Range-checked, applied and saved
+ *   PARAM RESET               All defaults, NVS entries erased
+ */
+
+#ifndef SYS_PARAM_H
+#define SYS_PARAM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define SYSPARAM_NVS_NAMESPACE  "frd_param"
+#define SYSPARAM_REPLY_TOPIC    "frd/param"
+#define SYSPARAM_NAME_MAX       16          // NVS key limit (15) + NUL
+#define SYSPARAM_TEXT_MAX       24          // Longest formatted "name=value"
+
+/**
+ * @brief Parameter table: X(id, name, type, default, min, max)
+ * @note name is also the NVS key (<= 15 chars).
+ *       lc_human_rel must stay below lc_human_trig (hysteresis); not enforced.
+ */
+#define SYSPARAM_TABLE(X) \
+    /* Load cells (raw weight units, samples) */ \
+    X(LC_HUMAN_TRIG,    lc_human_trig,  I32,    8000,       0,      1000000) \
+    X(LC_HUMAN_REL,     lc_human_rel,   I32,    6000,       0,      1000000) \
+    X(LC_COLLISION,     lc_collision,   I32,    3000,       0,      1000000) \
+    X(LC_DETECT_REQ,    lc_detect_req,  I32,    5,          1,      100) \
+    /* Heave compensation (on/off, load tared at rest, samples) */ \
+    X(LC_HEAVE_COMP,    lc_heave_comp,  I32,    1,          0,      1) \
+    X(LC_DEADLOAD,      lc_deadload,    I32,    3000,       0,      1000000) \
+    X(LC_DETECT_FAST,   lc_detect_fast, I32,    2,          1,      100) \
+    /* Ultrasonic spike filter (mm, samples) */ \
+    X(US_SPIKE_MM,      us_spike_mm,    I32,    500,        50,     6000) \
+    X(US_SPIKE_TOL,     us_spike_tol,   I32,    5,          1,      50) \
+    /* Battery (EMA weight, divider (R1+R2)/R2) */ \
+    X(BATT_EMA_ALPHA,   batt_ema_alpha, F32,    0.05f,      0.001f, 1.0f) \
+    X(BATT_DIV_RATIO,   batt_div_ratio, F32,    7.6766f,    1.0f,   20.0f) \
+    /* Black-box recorder (Hz, BBOX_CH_* mask) */ \
+    X(BBOX_RATE_HZ,     bbox_rate_hz,   I32,    50,         1,      100) \
+    X(BBOX_CHANNELS,    bbox_channels,  I32,    31,         1,      31)
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+#define SYSPARAM_CTYPE_I32      int32_t
+#define SYSPARAM_CTYPE_F32      float
+
+/**
+ * @brief Parameter IDs
+ */
+typedef enum {
+#define SYSPARAM_X_ID(id, name, type, def, min, max)    SYSPARAM_##id,
+    SYSPARAM_TABLE(SYSPARAM_X_ID)
+#undef SYSPARAM_X_ID
+    SYSPARAM_COUNT,
+} sysparam_id_t;
+
+/**
+ * @brief Current values (read directly on the hot paths)
+ */
+typedef struct {
+#define SYSPARAM_X_FIELD(id, name, type, def, min, max) SYSPARAM_CTYPE_##type name;
+    SYSPARAM_TABLE(SYSPARAM_X_FIELD)
+#undef SYSPARAM_X_FIELD
+} sysparam_values_t;
+
+/**
+ * @brief Value types
+ */
+typedef enum {
+    SYSPARAM_TYPE_I32 = 0,
+    SYSPARAM_TYPE_F32,
+} sysparam_type_t;
+
+/**
+ * @brief Parameter descriptor
+ */
+typedef struct {
+    const char *name;
+    sysparam_type_t type;
+    size_t offset;              // Into sysparam_values_t
+    float def;                  // Exact for the I32 ranges used here (< 2^24)
+    float min;
+    float max;
+} sysparam_desc_t;
+
+extern sysparam_values_t sysparam;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Load every default into sysparam
+ */
+void sysparam_reset_defaults(void);
+
+/**
+ * @brief Descriptor of a parameter
+ * @return NULL for an invalid ID
+ */
+const sysparam_desc_t *sysparam_desc(sysparam_id_t id);
+
+/**
+ * @brief Look up a parameter by name
+ * @return ID, or SYSPARAM_COUNT if unknown
+ */
+sysparam_id_t sysparam_find(const char *name, size_t len);
+
+/**
+ * @brief Range-check a value and store it in sysparam (I32 is rounded)
+ * @return false if out of range (sysparam unchanged)
+ */
+bool sysparam_apply(sysparam_id_t id, float value);
+
+/**
+ * @brief Current value as float
+ */
+float sysparam_value(sysparam_id_t id);
+
+/**
+ * @brief Parse a decimal value for a parameter (integer for I32)
+ * @return false on syntax error
+ */
+bool sysparam_parse(sysparam_id_t id, const char *text, size_t len, float *out);
+
+/**
+ * @brief Format "name=value"
+ * @return Characters written (excluding NUL), 0 if it did not fit
+ */
+size_t sysparam_format(sysparam_id_t id, char *buf, size_t size);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Load defaults, then the values saved in NVS
+ * @note Initializes the NVS partition if nobody has yet. Call before the
+ *       sensor tasks start.
+ * @return ESP_OK on success (defaults stay in effect on NVS errors)
+ */
+esp_err_t sysparam_init(void);
+
+/**
+ * @brief Set a parameter and save it to NVS
+ * @return ESP_OK, ESP_ERR_INVALID_ARG (unknown / out of range), NVS errors
+ *         (the value is applied even if saving fails)
+ */
+esp_err_t sysparam_set(sysparam_id_t id, float value);
+
+/**
+ * @brief Restore all defaults and erase the saved values
+ */
+esp_err_t sysparam_reset(void);
+
+/**
+ * @brief Print all parameters to console
+ */
+void sysparam_log(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_PARAM_H
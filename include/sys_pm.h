@@ -0,0 +1,132 @@
+/**
+ * @file sys_pm.h
+ * @brief Dynamic Frequency Scaling per Mission State, Subsystem PM Locks
+ * @details
+ * Each mission state has a DFS profile (max/min CPU MHz). Between the two
+ * the clock is decided by the locks held:
+ *
+ *   Lock                 Type            Held while
+ *   SYSPM_LOCK_CTRL      CPU_FREQ_MAX    heading controller running
+ *   SYSPM_LOCK_MODEM     APB_FREQ_MAX    AT command queued / in flight
+ *   SYSPM_LOCK_ULTRASONIC CPU_FREQ_MAX   one echo measurement (busy-wait)
+ *   SYSPM_LOCK_LOADCELL  CPU_FREQ_MAX    one HX711 bit-bang read
+ *
+ * Clocks that must not follow DFS run from XTAL instead of APB: LEDC (ESC
+ * pulse width), GPS and modem UARTs (baud rate). esp_timer (all sample
+ * stamps) is SYSTIMER/XTAL and is not affected either.
+ *
+ * Time is accounted per mission state and per level (profile max, APB
+ * 80 MHz, profile min) as requested by these locks; IDF drivers may hold
+ * their own locks on top (gptimer, I2C).
+ */
+
+#ifndef SYS_PM_H
+#define SYS_PM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include "esp_err.h"
+#include "sys_mission.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define SYSPM_STANDBY_MAX_MHZ   80          // Waiting for WAKE: nothing compute-heavy
+#define SYSPM_STANDBY_MIN_MHZ   40          // XTAL
+#define SYSPM_ACTIVE_MAX_MHZ    240         // Fusion + control at full rate
+#define SYSPM_ACTIVE_MIN_MHZ    80
+#define SYSPM_RESCUE_MAX_MHZ    160         // Motors cut, sensing + telemetry only
+#define SYSPM_RESCUE_MIN_MHZ    40
+#define SYSPM_APB_MHZ           80
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Subsystem locks
+ */
+typedef enum {
+    SYSPM_LOCK_CTRL = 0,
+    SYSPM_LOCK_MODEM,
+    SYSPM_LOCK_ULTRASONIC,
+    SYSPM_LOCK_LOADCELL,
+    SYSPM_LOCK_COUNT,
+} syspm_lock_t;
+
+/**
+ * @brief Requested clock level
+ */
+typedef enum {
+    SYSPM_LEVEL_MAX = 0,        // Profile max (a CPU_FREQ_MAX lock is held)
+    SYSPM_LEVEL_APB,            // 80 MHz (APB_FREQ_MAX lock only)
+    SYSPM_LEVEL_MIN,            // Profile min (no lock)
+    SYSPM_LEVEL_COUNT,
+} syspm_level_t;
+
+/**
+ * @brief Per-lock statistics
+ */
+typedef struct {
+    uint32_t acquires;
+    uint32_t held_max_us;
+    uint64_t held_us;
+} syspm_lock_stats_t;
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    uint64_t time_us[MISSION_STATE_COUNT][SYSPM_LEVEL_COUNT];
+    syspm_lock_stats_t locks[SYSPM_LOCK_COUNT];
+    uint32_t freq_checks;       // CPU_FREQ_MAX acquisitions checked
+    uint32_t freq_misses;       // ... where the CPU was not at the profile max afterwards
+    uint32_t profile_errors;    // esp_pm_configure failures
+} syspm_stats_t;
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Create the locks and apply the profile of the current mission state
+ * @note Requires CONFIG_PM_ENABLE. Until this is called, acquire/release are no-ops.
+ * @return ESP_OK on success
+ */
+esp_err_t syspm_init(void);
+
+/**
+ * @brief Acquire a subsystem lock (counting, task context)
+ */
+void syspm_acquire(syspm_lock_t lock);
+
+/**
+ * @brief Release a subsystem lock
+ */
+void syspm_release(syspm_lock_t lock);
+
+/**
+ * @brief Apply the DFS profile of a mission state
+ * @note Called by mission_set_state().
+ */
+void syspm_on_mission_state(mission_state_t state);
+
+/**
+ * @brief Copy statistics (time counters include the current interval)
+ */
+void syspm_get_stats(syspm_stats_t *out);
+
+/**
+ * @brief Print time per frequency level per mission state and lock usage
+ */
+void syspm_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_PM_H
@@ -0,0 +1,139 @@
+/**
+ * @file sys_standby.h
+ * @brief Low-Power STANDBY (light sleep, ULP battery watch, modem sleep)
+ * @details
+ * README STANDBY: "low power, waits for MQTT WAKE". Light sleep is used
+ * instead of deep sleep so RAM (calibration, MQTT session, flash log
+ * position) survives and wake-up is a return from a function call.
+ *
+ * Typical use in the application loop:
+ *
+ *   standby_enter();                                // Once, on entering STANDBY
+ *   while (mission_get_state() == MISSION_STANDBY) {
+ *       standby_sleep(STANDBY_POLL_MS);             // Light sleep until RI / timer / ULP
+ *       cmd_t c;                                    // Modem usable again here
+ *       if (cmd_receive(&c, STANDBY_LISTEN_MS) && c.type == CMD_WAKE) break;
+ *   }
+ *   standby_exit();                                 // Sensors back, motors at idle
+ *
+ * In STANDBY:
+ * - Motors: PWM stopped (pins low), ESCs see no signal and stay disarmed.
+ * - Load cells: HX711 power-down (PD_SCK held high), calibration kept.
+ * - Ultrasonic: TRIG held low, no measurements.
+ * - Battery: the ADC is handed to the ULP FSM, which samples it every
+ *   STANDBY_ULP_PERIOD_MS and wakes the CPU below BATTERY_MIN_V, then once
+ *   more below BATTERY_CRIT_V.
+ * - Modem: AT+CSCLK=1 + eDRX; it sleeps while DTR is high and pulses RI
+ *   (PIN_MODEM_RI) when a message arrives, which wakes the ESP32.
+ * - A timer wake every poll period is the fallback if RI is missed.
+ */
+
+#ifndef SYS_STANDBY_H
+#define SYS_STANDBY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "drv_loadcell.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define STANDBY_POLL_MS         30000       // Timer wake (fallback for a missed RI)
+#define STANDBY_LISTEN_MS       300         // Suggested awake window after each wake
+#define STANDBY_ULP_PERIOD_MS   1000        // Battery sample period in standby
+#define STANDBY_MAX_LOADCELLS   3
+#define STANDBY_RI_RELEASE_MS   200         // Wait for RI to go high before sleeping again
+#define STANDBY_LC_SETTLE_MS    500         // HX711 first conversion after power-up (10 SPS)
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Why standby_sleep() returned
+ */
+typedef enum {
+    STANDBY_WAKE_TIMER = 0,
+    STANDBY_WAKE_MODEM,         // Ring indicator: a message is waiting
+    STANDBY_WAKE_BATTERY,       // ULP: battery crossed a threshold
+    STANDBY_WAKE_OTHER,
+} standby_wake_t;
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    uint32_t sleeps;
+    uint32_t wakes_timer;
+    uint32_t wakes_modem;
+    uint32_t wakes_battery;
+    uint64_t asleep_us;             // Total time in light sleep
+    uint64_t standby_us;            // Total time between enter and exit
+    uint32_t wake_latency_last_us;  // Sleep return -> modem UART usable
+    uint32_t wake_latency_max_us;
+    uint32_t wake_to_ready_last_us; // Last sleep return -> standby_exit() done
+    uint32_t wake_to_ready_max_us;
+    uint16_t battery_raw;           // Last ULP sample (ADC counts)
+} standby_stats_t;
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Configure the RI wake pin and remember the load cells to power down
+ * @param loadcells Load cells (pointers kept)
+ * @param count     Number of load cells (<= STANDBY_MAX_LOADCELLS)
+ * @return ESP_OK, ESP_ERR_INVALID_ARG
+ */
+esp_err_t standby_init(loadcell_t *const *loadcells, size_t count);
+
+/**
+ * @brief Put the craft into STANDBY (motors disarmed, sensors down, ULP on)
+ * @note Stops the heading controller. Call from the application task.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if already in standby
+ */
+esp_err_t standby_enter(void);
+
+/**
+ * @brief One light-sleep cycle
+ * @param max_ms Timer wake after this long
+ * @return Wake reason; the modem UART is usable again when this returns
+ */
+standby_wake_t standby_sleep(uint32_t max_ms);
+
+/**
+ * @brief Leave STANDBY: battery ADC, load cells, ultrasonic and motors (idle) back
+ * @note Blocks until the first HX711 conversions are available (~0.5 s).
+ *       ESCs re-arm on the idle signal; allow their arming time before thrust.
+ * @return ESP_OK, ESP_ERR_INVALID_STATE if not in standby
+ */
+esp_err_t standby_exit(void);
+
+/**
+ * @brief Battery voltage seen by the ULP (mV, uncalibrated)
+ * @return 0 before the first ULP sample
+ */
+uint32_t standby_battery_mv(void);
+
+/**
+ * @brief Copy statistics
+ */
+void standby_get_stats(standby_stats_t *out);
+
+/**
+ * @brief Print standby statistics to console
+ */
+void standby_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_STANDBY_H
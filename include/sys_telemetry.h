@@ -0,0 +1,185 @@
+/**
+ * @file sys_telemetry.h
+ * @brief Compact Binary Telemetry (delta + varint, batched per MQTT publish)
+ * @details
+ * Wire format (schema TLM_SCHEMA_VERSION, little-endian varints):
+ *
+ *   batch := magic(0xA7) version(u8) count(u8) frame[count]
+ *   frame := varint(mask) { varint(zigzag(value[i] - prev[i])) for each bit i in mask }
+ *
+ * - Field order is TLM_FIELDS below; adding a field = appending to the list
+ *   and bumping TLM_SCHEMA_VERSION (tools/telemetry_decode.py mirrors it).
+ * - The first frame of every batch is a keyframe (prev = all zero), so each
+ *   MQTT message decodes on its own even if earlier ones were lost.
+ * - Fields whose value did not change are left out of the mask.
+ *
+ * tools/telemetry_sim.c measures bytes/s on a simulated 10 min cruise.
+ */
+
+#ifndef SYS_TELEMETRY_H
+#define SYS_TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define TLM_MAGIC               0xA7
+#define TLM_SCHEMA_VERSION      2
+#define TLM_BATCH_HEADER_BYTES  3
+#define TLM_BATCH_MAX_BYTES     512         // Must fit MODEM_MQTT_PAYLOAD_MAX
+#define TLM_BATCH_MAX_FRAMES    50
+#define TLM_BATCH_MAX_AGE_MS    5000        // Publish at least this often
+#define TLM_TOPIC               "frd/tlm"
+
+#define TLM_TASK_STACK          3072
+#define TLM_TASK_PRIORITY       3
+#define TLM_TASK_CORE           0
+
+/**
+ * @brief Telemetry fields: X(name, type, unit)
+ * @note Order is the wire order. Append only.
+ */
+#define TLM_FIELDS(X)                                   \
+    X(time_ms,        uint32_t, "ms since boot")        \
+    X(mission,        uint8_t,  "mission_state_t")      \
+    X(flags,          uint16_t, "TLM_FLAG_*")           \
+    X(batt_mv,        uint16_t, "mV")                   \
+    X(batt_soc,       uint8_t,  "%")                    \
+    X(load_front_g,   int32_t,  "g")                    \
+    X(load_left_g,    int32_t,  "g")                    \
+    X(load_right_g,   int32_t,  "g")                    \
+    X(dist_front_cm,  uint16_t, "cm, 0xFFFF = invalid") \
+    X(dist_left_cm,   uint16_t, "cm, 0xFFFF = invalid") \
+    X(dist_right_cm,  uint16_t, "cm, 0xFFFF = invalid") \
+    X(lat_e7,         int32_t,  "deg * 1e7")            \
+    X(lon_e7,         int32_t,  "deg * 1e7")            \
+    X(heading_cdeg,   uint16_t, "deg * 100")            \
+    X(speed_cm_s,     uint16_t, "cm/s")                 \
+    X(health,         uint16_t, "health_pack()")
+
+#define TLM_COUNT_FIELD(name, type, unit) +1
+#define TLM_FIELD_COUNT         (0 TLM_FIELDS(TLM_COUNT_FIELD))
+#define TLM_FRAME_MAX_BYTES     (3 + 5 * TLM_FIELD_COUNT)   // Mask + worst-case varints
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Status flag bits (tlm_state_t.flags)
+ */
+typedef enum {
+    TLM_FLAG_HUMAN_LEFT     = 1 << 0,
+    TLM_FLAG_HUMAN_RIGHT    = 1 << 1,
+    TLM_FLAG_COLLISION      = 1 << 2,
+    TLM_FLAG_GPS_FIX        = 1 << 3,
+    TLM_FLAG_GPS_AIDED      = 1 << 4,   // EKF received GPS recently
+    TLM_FLAG_IN_FENCE       = 1 << 5,
+    TLM_FLAG_BATT_LOW       = 1 << 6,
+    TLM_FLAG_CTRL_RUNNING   = 1 << 7,
+} tlm_flag_t;
+
+/**
+ * @brief One telemetry sample (fixed-point, see TLM_FIELDS units)
+ */
+typedef struct {
+#define TLM_DECLARE_FIELD(name, type, unit) type name;
+    TLM_FIELDS(TLM_DECLARE_FIELD)
+#undef TLM_DECLARE_FIELD
+} tlm_state_t;
+
+/**
+ * @brief Batch encoder
+ */
+typedef struct {
+    int32_t prev[TLM_FIELD_COUNT];  // Previous frame (zero = next frame is a keyframe)
+    uint8_t buf[TLM_BATCH_MAX_BYTES];
+    size_t len;
+    uint8_t count;
+    uint32_t first_ms;              // time_ms of the batch keyframe
+} tlm_encoder_t;
+
+/**
+ * @brief Fill callback: sensor fields of the sample
+ * @note Runs in the telemetry task; must only read cached values.
+ *       time_ms, mission and health are filled by the module.
+ */
+typedef void (*tlm_fill_cb_t)(tlm_state_t *out, void *ctx);
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    uint32_t frames;
+    uint32_t batches;           // Published live
+    uint32_t stored_batches;    // Sent to the flash log (link down / backlog)
+    uint32_t replayed_batches;  // Published from the flash log
+    uint32_t bytes;             // Payload bytes handed to MQTT
+    uint32_t dropped_batches;   // Neither published nor stored
+    uint32_t last_batch_bytes;
+    uint8_t last_batch_frames;
+} tlm_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Start an empty batch (next frame is a keyframe)
+ */
+void tlm_encoder_reset(tlm_encoder_t *enc);
+
+/**
+ * @brief Append a frame to the batch
+ * @param enc Encoder
+ * @param s   Sample
+ * @return false if the batch is full (flush, reset, then add again)
+ */
+bool tlm_encoder_add(tlm_encoder_t *enc, const tlm_state_t *s);
+
+/**
+ * @brief Encoded batch
+ * @param enc Encoder
+ * @param len Output length (0 if the batch is empty)
+ * @return Pointer to the batch bytes
+ */
+const uint8_t *tlm_encoder_data(const tlm_encoder_t *enc, size_t *len);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Start periodic telemetry
+ * @param rate_hz Sample rate (1..50)
+ * @param fill    Fill callback
+ * @param ctx     Callback context
+ * @return ESP_OK, ESP_ERR_INVALID_ARG, ESP_ERR_INVALID_STATE if running
+ */
+esp_err_t tlm_start(uint16_t rate_hz, tlm_fill_cb_t fill, void *ctx);
+
+/**
+ * @brief Copy statistics
+ * @param out Output statistics
+ */
+void tlm_get_stats(tlm_stats_t *out);
+
+/**
+ * @brief Print telemetry statistics to console
+ */
+void tlm_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_TELEMETRY_H
@@ -0,0 +1,203 @@
+/**
+ * @file sys_time.h
+ * @brief Unified Monotonic Timebase, Disciplined to GPS PPS / UTC
+ * @details
+ * Every sample in the system is stamped with systime_now_us(): the local
+ * monotonic clock in microseconds since boot (64-bit, never wraps, same
+ * value on both cores). UTC is a mapping on top of it:
+ *
+ *   utc(L) = anchor_utc + (L - anchor_local) * (1 + drift) + slew(L)
+ *
+ * - The GPS PPS rising edge (PIN_GPS_PPS) is captured in an IRAM ISR.
+ * - The NAV-PVT solution of the same second tells which UTC second that
+ *   edge was (forward fixes with systime_on_gps_fix()).
+ * - A PI servo estimates the local oscillator drift (ppb) and slews the
+ *   phase error out over the next second, so the mapping stays monotonic;
+ *   errors above SYSTIME_STEP_THRESHOLD_US are stepped instead.
+ * - Without PPS the last drift keeps running (holdover); samples stamped
+ *   before the first lock can still be converted once it is reached.
+ *
+ * tools/systime_sim.c runs the servo against a simulated crystal.
+ */
+
+#ifndef SYS_TIME_H
+#define SYS_TIME_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+#include "drv_gps.h"
+
+/*----------------------------------------
+        CONFIGURATION CONSTANT
+  ----------------------------------------*/
+
+#define SYSTIME_SERVO_KP            0.7f        // Phase gain (1 Hz update)
+#define SYSTIME_SERVO_KI            0.3f        // Drift gain
+#define SYSTIME_MAX_DRIFT_PPB       500000      // Clamp (crystal spec is +-40 ppm)
+#define SYSTIME_STEP_THRESHOLD_US   1000        // Larger error -> step, not slew
+#define SYSTIME_LOCK_THRESHOLD_NS   20000       // |error| below this = synced
+#define SYSTIME_LOCK_COUNT          3           // Consecutive good edges to report synced
+#define SYSTIME_PPS_TOLERANCE_US    500         // Edge interval vs whole seconds
+#define SYSTIME_HOLDOVER_S          3           // No PPS for this long -> holdover
+#define SYSTIME_MAX_REJECTS         3           // Consecutive bad edges -> resync
+
+#define SYSTIME_PAIR_WINDOW_US      900000      // Fix must arrive this soon after its edge
+#define SYSTIME_PAIR_FRACTION_US    1000        // Fix epoch must be this close to a whole second
+
+#define SYSTIME_BENCH_CALLS         1000        // Calls per read-cost measurement
+
+/*----------------------------------------
+            DATA STRUCTURES
+  ----------------------------------------*/
+
+/**
+ * @brief Servo state
+ */
+typedef enum {
+    SYSTIME_UNSYNCED = 0,       // No UTC mapping
+    SYSTIME_FREQ_EST,           // One edge seen, waiting for the second to measure drift
+    SYSTIME_TRACKING,           // PI loop running, error not yet below the lock threshold
+    SYSTIME_LOCKED,
+    SYSTIME_HOLDOVER,           // PPS lost, mapping runs on the last drift
+} systime_state_t;
+
+/**
+ * @brief PI clock servo
+ */
+typedef struct {
+    systime_state_t state;
+    int64_t anchor_local_us;    // Last accepted PPS edge (local clock)
+    int64_t anchor_utc_ns;      // UTC of the mapping at anchor_local_us
+    int64_t pps_utc_ns;         // UTC the last edge really was
+    int32_t drift_ppb;          // Local clock slow (+) / fast (-) vs GPS
+    int32_t slew_ns;            // Phase correction spread over the next second
+    int32_t error_ns;           // Mapping - PPS at the last edge
+    uint8_t good_count;
+    uint8_t reject_count;
+
+    uint32_t updates;
+    uint32_t steps;
+    uint32_t rejected;
+} systime_servo_t;
+
+/**
+ * @brief Statistics
+ */
+typedef struct {
+    systime_state_t state;
+    uint32_t pps_edges;         // ISR count
+    uint32_t pairs;             // Edges matched to a UTC second
+    uint32_t steps;
+    uint32_t rejected;
+    int32_t error_ns;           // Last servo error
+    int32_t error_max_ns;       // Worst |error| while locked
+    int32_t drift_ppb;
+    uint32_t ccount_cycles;     // esp_cpu_get_cycle_count() cost, for reference
+    uint32_t read_cycles;       // systime_now_us() cost (systime_measure_read_cost)
+    uint32_t utc_cycles;        // systime_to_utc_us() cost
+} systime_stats_t;
+
+/*----------------------------------------
+     PURE HELPERS (host-testable)
+  ----------------------------------------*/
+
+/**
+ * @brief Reset servo to SYSTIME_UNSYNCED
+ */
+void systime_servo_reset(systime_servo_t *s);
+
+/**
+ * @brief Feed one PPS edge
+ * @param s        Servo
+ * @param local_us Local time of the edge
+ * @param utc_s    UTC second (Unix time) the edge marks
+ * @return false if the edge was rejected (glitch / mispaired second)
+ */
+bool systime_servo_update(systime_servo_t *s, int64_t local_us, int64_t utc_s);
+
+/**
+ * @brief Advance state without an edge (holdover detection)
+ * @param s        Servo
+ * @param local_us Current local time
+ */
+void systime_servo_check(systime_servo_t *s, int64_t local_us);
+
+/**
+ * @brief Map a local timestamp to UTC
+ * @param s        Servo
+ * @param local_us Local time (any time since boot, before or after the anchor)
+ * @param utc_us   Output UTC (Unix time, us)
+ * @return false if there is no mapping yet
+ */
+bool systime_servo_to_utc(const systime_servo_t *s, int64_t local_us, int64_t *utc_us);
+
+/**
+ * @brief Civil UTC date/time to Unix seconds
+ */
+int64_t systime_civil_to_unix(uint16_t year, uint8_t month, uint8_t day,
+                              uint8_t hour, uint8_t min, uint8_t sec);
+
+/*----------------------------------------
+            DRIVER API
+  ----------------------------------------*/
+
+/**
+ * @brief Configure the PPS input and start capturing edges
+ * @note Shares the GPIO ISR service with drv_imu (either may install it).
+ * @return ESP_OK on success
+ */
+esp_err_t systime_init(void);
+
+/**
+ * @brief Local monotonic time (us since boot)
+ * @note IRAM, safe from ISRs. This is the stamp for every sample.
+ */
+int64_t systime_now_us(void);
+
+/**
+ * @brief Convert a local stamp to UTC
+ * @param local_us Stamp from systime_now_us()
+ * @param utc_us   Output UTC (Unix time, us)
+ * @return false before the first PPS/UTC pair
+ */
+bool systime_to_utc_us(int64_t local_us, int64_t *utc_us);
+
+/**
+ * @brief Feed a GPS solution (call from the gps_register_callback() handler)
+ * @details Solutions whose epoch is a whole UTC second name the PPS edge
+ *          captured just before them; everything else is ignored.
+ */
+void systime_on_gps_fix(const gps_fix_t *fix);
+
+/**
+ * @brief Check whether UTC is locked to PPS
+ */
+bool systime_is_synced(void);
+
+/**
+ * @brief Measure the cost of systime_now_us() / systime_to_utc_us()
+ * @details Times SYSTIME_BENCH_CALLS calls of each with the CPU cycle counter;
+ *          results land in the statistics. Blocks for a few ms.
+ */
+void systime_measure_read_cost(void);
+
+/**
+ * @brief Copy statistics
+ */
+void systime_get_stats(systime_stats_t *out);
+
+/**
+ * @brief Print timebase statistics to console
+ */
+void systime_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SYS_TIME_H
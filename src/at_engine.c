@@ -0,0 +1,404 @@
+/**
+ * @file at_engine.c
+ * @brief Non-blocking AT Command Engine Implementation
+ */
+
+#include <string.h>
+#include "at_engine.h"
+
+#define RING_MASK   (AT_RX_RING_SIZE - 1)
+
+_Static_assert((AT_RX_RING_SIZE & RING_MASK) == 0, "AT_RX_RING_SIZE must be a power of 2");
+
+// --- HELPER FUNCTIONS ---
+
+static inline uint8_t span_at(const at_span_t *s, uint16_t i) {
+    return (i < s->n[0]) ? s->p[0][i] : s->p[1][i - s->n[0]];
+}
+
+static at_span_t make_span(const at_engine_t *eng, uint32_t start, uint32_t len) {
+    at_span_t s;
+    uint32_t off = start & RING_MASK;
+    uint32_t first = AT_RX_RING_SIZE - off;
+
+    s.p[0] = &eng->ring[off];
+    if (len <= first) {
+        s.n[0] = (uint16_t)len;
+        s.p[1] = NULL;
+        s.n[1] = 0;
+    } else {
+        s.n[0] = (uint16_t)first;
+        s.p[1] = &eng->ring[0];
+        s.n[1] = (uint16_t)(len - first);
+    }
+    return s;
+}
+
+static inline at_cmd_t *active_cmd(at_engine_t *eng) {
+    return &eng->queue[eng->q_head];
+}
+
+static void complete(at_engine_t *eng, at_result_t result, int64_t now_us) {
+    at_cmd_t *cmd = active_cmd(eng);
+    at_done_cb_t done = cmd->on_done;
+    void *ctx = cmd->ctx;
+
+    uint32_t latency = (uint32_t)(now_us - eng->cmd_sent_us);
+    eng->stats.latency_last_us = latency;
+    eng->stats.latency_total_us += latency;
+    if (latency > eng->stats.latency_max_us) eng->stats.latency_max_us = latency;
+
+    switch (result) {
+        case AT_RESULT_OK:      eng->stats.cmds_ok++; break;
+        case AT_RESULT_ERROR:   eng->stats.cmds_error++; break;
+        case AT_RESULT_TIMEOUT: eng->stats.cmds_timeout++; break;
+        default: break;
+    }
+
+    // Pop before the callback so it may submit a follow-up command
+    eng->q_head = (uint8_t)((eng->q_head + 1) % AT_CMD_QUEUE_LEN);
+    eng->q_count--;
+    eng->cmd_active = false;
+
+    if (done != NULL) done(result, ctx);
+}
+
+static void start_sync(at_engine_t *eng, int64_t now_us) {
+    eng->write((const uint8_t *)AT_SYNC_CMD "\r", sizeof(AT_SYNC_CMD), eng->io_ctx);
+    eng->sync_active = true;
+    eng->sync_seen = false;
+    eng->sync_deadline_us = now_us + (int64_t)AT_SYNC_TIMEOUT_MS * 1000;
+    eng->stats.resyncs++;
+}
+
+static void start_next(at_engine_t *eng, int64_t now_us) {
+    if (eng->cmd_active || eng->sync_active) return;
+    if (eng->resync) {
+        start_sync(eng, now_us);
+        return;
+    }
+    if (eng->q_count == 0) return;
+
+    at_cmd_t *cmd = active_cmd(eng);
+    size_t len = strnlen(cmd->cmd, AT_CMD_MAX_LEN);
+    eng->write((const uint8_t *)cmd->cmd, len, eng->io_ctx);
+    eng->write((const uint8_t *)"\r", 1, eng->io_ctx);
+
+    uint32_t timeout_ms = cmd->timeout_ms ? cmd->timeout_ms : AT_DEFAULT_TIMEOUT_MS;
+    eng->cmd_active = true;
+    eng->cmd_got_ok = false;
+    eng->cmd_data_sent = false;
+    eng->cmd_sent_us = now_us;
+    eng->cmd_deadline_us = now_us + (int64_t)timeout_ms * 1000;
+}
+
+static bool is_blank(const at_span_t *line) {
+    uint16_t len = at_span_len(line);
+    for (uint16_t i = 0; i < len; i++) {
+        if (span_at(line, i) != ' ') return false;
+    }
+    return true;
+}
+
+static bool is_error(const at_span_t *line) {
+    return at_span_equals(line, "ERROR") || at_span_starts_with(line, "+CME ERROR") ||
+           at_span_starts_with(line, "+CMS ERROR");
+}
+
+/**
+ * @brief Resync in progress: the sync reply followed by OK ends it, any
+ *        other final result belongs to a timed-out command
+ * @return true if the line was consumed
+ */
+static bool sync_line(at_engine_t *eng, const at_span_t *line) {
+    if (at_span_equals(line, AT_SYNC_REPLY)) {
+        eng->sync_seen = true;
+        return true;
+    }
+    if (eng->sync_seen && at_span_equals(line, "OK")) {
+        eng->sync_active = false;
+        eng->resync = false;
+        return true;
+    }
+    if (at_span_equals(line, "OK") || is_error(line)) {
+        eng->stats.stale_results++;
+        return true;
+    }
+    return at_span_equals(line, AT_SYNC_CMD);          // Echo (ATE1)
+}
+
+static void dispatch_line(at_engine_t *eng, const at_span_t *line, int64_t now_us) {
+    if (is_blank(line)) return;
+    eng->stats.lines++;
+
+    if (eng->sync_active && sync_line(eng, line)) return;
+
+    if (eng->cmd_active) {
+        at_cmd_t *cmd = active_cmd(eng);
+
+        if (at_span_equals(line, "OK")) {
+            if (cmd->done_prefix != NULL) {
+                eng->cmd_got_ok = true;
+            } else {
+                complete(eng, AT_RESULT_OK, now_us);
+            }
+            return;
+        }
+        if (is_error(line)) {
+            complete(eng, AT_RESULT_ERROR, now_us);
+            return;
+        }
+        if (cmd->done_prefix != NULL && at_span_starts_with(line, cmd->done_prefix)) {
+            if (cmd->on_line != NULL) cmd->on_line(line, cmd->ctx);
+            complete(eng, AT_RESULT_OK, now_us);
+            return;
+        }
+        if (cmd->match != NULL && at_span_starts_with(line, cmd->match)) {
+            if (cmd->on_line != NULL) cmd->on_line(line, cmd->ctx);
+            return;
+        }
+        if (at_span_equals(line, cmd->cmd)) return;     // Echo (ATE1)
+    }
+
+    for (uint8_t i = 0; i < eng->urc_count; i++) {
+        if (at_span_starts_with(line, eng->urc[i].prefix)) {
+            eng->stats.urcs++;
+            eng->urc[i].cb(line, eng->urc[i].ctx);
+            return;
+        }
+    }
+    eng->stats.unhandled++;
+}
+
+static void deliver_raw(at_engine_t *eng) {
+    uint32_t avail = eng->head - eng->tail;
+    uint32_t n = eng->raw_total - eng->raw_done;
+    if (n > avail) n = avail;
+    if (n == 0) return;
+
+    at_span_t s = make_span(eng, eng->tail, n);
+    at_raw_cb_t cb = eng->raw_cb;
+
+    for (int k = 0; k < 2 && s.n[k] > 0; k++) {
+        cb(s.p[k], s.n[k], eng->raw_done, eng->raw_total, eng->raw_ctx);
+        eng->raw_done += s.n[k];
+    }
+    eng->tail += n;
+    eng->scan = eng->tail;
+
+    if (eng->raw_done >= eng->raw_total) eng->raw_cb = NULL;
+}
+
+static void process_rx(at_engine_t *eng, int64_t now_us) {
+    while (eng->tail != eng->head) {
+        if (eng->raw_cb != NULL) {
+            deliver_raw(eng);
+            continue;
+        }
+
+        // Data prompt "> " (not newline terminated)
+        if (eng->cmd_active && !eng->cmd_data_sent && active_cmd(eng)->data != NULL &&
+            eng->ring[eng->tail & RING_MASK] == '>') {
+            at_cmd_t *cmd = active_cmd(eng);
+            eng->write(cmd->data, cmd->data_len, eng->io_ctx);
+            eng->cmd_data_sent = true;
+            eng->tail++;
+            eng->scan = eng->tail;
+            continue;
+        }
+
+        while (eng->scan != eng->head && eng->ring[eng->scan & RING_MASK] != '\n') {
+            eng->scan++;
+        }
+
+        if (eng->scan == eng->head) {
+            // No terminator and no room left: line can never complete
+            if (eng->head - eng->tail >= AT_RX_RING_SIZE) {
+                eng->stats.rx_overflows += eng->head - eng->tail;
+                eng->tail = eng->head;
+                eng->scan = eng->head;
+            }
+            return;
+        }
+
+        uint32_t len = eng->scan - eng->tail;
+        if (len > 0 && eng->ring[(eng->scan - 1) & RING_MASK] == '\r') len--;
+
+        at_span_t line = make_span(eng, eng->tail, len);
+        eng->scan++;
+        eng->tail = eng->scan;          // Callbacks may switch to raw mode from here
+        dispatch_line(eng, &line, now_us);
+    }
+}
+
+// --- SPAN HELPERS ---
+
+uint16_t at_span_len(const at_span_t *s) {
+    return (uint16_t)(s->n[0] + s->n[1]);
+}
+
+bool at_span_starts_with(const at_span_t *s, const char *prefix) {
+    uint16_t len = at_span_len(s);
+    uint16_t i = 0;
+    for (; prefix[i] != '\0'; i++) {
+        if (i >= len || span_at(s, i) != (uint8_t)prefix[i]) return false;
+    }
+    return true;
+}
+
+bool at_span_equals(const at_span_t *s, const char *str) {
+    return at_span_starts_with(s, str) && strlen(str) == at_span_len(s);
+}
+
+size_t at_span_copy(const at_span_t *s, uint16_t offset, char *out, size_t out_size) {
+    if (out_size == 0) return 0;
+
+    uint16_t len = at_span_len(s);
+    size_t n = 0;
+    for (uint16_t i = offset; i < len && n + 1 < out_size; i++) {
+        out[n++] = (char)span_at(s, i);
+    }
+    out[n] = '\0';
+    return n;
+}
+
+bool at_span_get_int(const at_span_t *s, uint8_t field, int32_t *out) {
+    uint16_t len = at_span_len(s);
+    uint16_t i = 0;
+
+    // Fields start after "+XXX:" (or at 0 for bare responses)
+    while (i < len && span_at(s, i) != ':') i++;
+    i = (i < len) ? i + 1 : 0;
+
+    for (uint8_t f = 0; f < field; f++) {
+        while (i < len && span_at(s, i) != ',') i++;
+        if (i >= len) return false;
+        i++;
+    }
+
+    while (i < len && span_at(s, i) == ' ') i++;
+    bool neg = false;
+    if (i < len && span_at(s, i) == '-') {
+        neg = true;
+        i++;
+    }
+
+    int32_t v = 0;
+    bool any = false;
+    while (i < len && span_at(s, i) >= '0' && span_at(s, i) <= '9') {
+        v = v * 10 + (span_at(s, i) - '0');
+        any = true;
+        i++;
+    }
+    if (!any) return false;
+
+    *out = neg ? -v : v;
+    return true;
+}
+
+// --- ENGINE API ---
+
+void at_engine_init(at_engine_t *eng, at_write_fn_t write, void *io_ctx) {
+    memset(eng, 0, sizeof(*eng));
+    eng->write = write;
+    eng->io_ctx = io_ctx;
+}
+
+size_t at_engine_rx_reserve(at_engine_t *eng, uint8_t **buf) {
+    uint32_t used = eng->head - eng->tail;
+    uint32_t off = eng->head & RING_MASK;
+    uint32_t free_total = AT_RX_RING_SIZE - used;
+    uint32_t contiguous = AT_RX_RING_SIZE - off;
+
+    *buf = &eng->ring[off];
+    return (free_total < contiguous) ? free_total : contiguous;
+}
+
+void at_engine_rx_commit(at_engine_t *eng, size_t len) {
+    eng->head += (uint32_t)len;
+    eng->stats.rx_bytes += (uint32_t)len;
+}
+
+void at_engine_feed(at_engine_t *eng, const uint8_t *data, size_t len) {
+    while (len > 0) {
+        uint8_t *dst;
+        size_t room = at_engine_rx_reserve(eng, &dst);
+        if (room == 0) {
+            eng->stats.rx_overflows += (uint32_t)len;
+            return;
+        }
+        size_t n = (len < room) ? len : room;
+        memcpy(dst, data, n);
+        at_engine_rx_commit(eng, n);
+        data += n;
+        len -= n;
+    }
+}
+
+void at_engine_poll(at_engine_t *eng, int64_t now_us) {
+    process_rx(eng, now_us);
+
+    if (eng->cmd_active && now_us >= eng->cmd_deadline_us) {
+        eng->resync = true;             // Its OK / ERROR may still come
+        complete(eng, AT_RESULT_TIMEOUT, now_us);
+    }
+    if (eng->sync_active && now_us >= eng->sync_deadline_us) {
+        eng->sync_active = false;       // Marker lost: start_next() sends another
+    }
+
+    start_next(eng, now_us);
+}
+
+bool at_engine_submit(at_engine_t *eng, const at_cmd_t *cmd) {
+    if (eng->q_count >= AT_CMD_QUEUE_LEN) {
+        eng->stats.queue_full++;
+        return false;
+    }
+
+    uint8_t idx = (uint8_t)((eng->q_head + eng->q_count) % AT_CMD_QUEUE_LEN);
+    eng->queue[idx] = *cmd;
+    eng->queue[idx].cmd[AT_CMD_MAX_LEN - 1] = '\0';
+    eng->q_count++;
+    return true;
+}
+
+bool at_engine_register_urc(at_engine_t *eng, const char *prefix, at_line_cb_t cb, void *ctx) {
+    if (eng->urc_count >= AT_MAX_URC_HANDLERS) return false;
+
+    at_urc_handler_t *h = &eng->urc[eng->urc_count++];
+    h->prefix = prefix;
+    h->cb = cb;
+    h->ctx = ctx;
+    return true;
+}
+
+void at_engine_expect_raw(at_engine_t *eng, size_t len, at_raw_cb_t cb, void *ctx) {
+    if (len == 0 || cb == NULL) return;
+    eng->raw_cb = cb;
+    eng->raw_ctx = ctx;
+    eng->raw_total = (uint32_t)len;
+    eng->raw_done = 0;
+}
+
+void at_engine_flush(at_engine_t *eng) {
+    at_done_cb_t done[AT_CMD_QUEUE_LEN];
+    void *ctx[AT_CMD_QUEUE_LEN];
+    uint8_t n = eng->q_count;
+
+    for (uint8_t i = 0; i < n; i++) {
+        at_cmd_t *cmd = &eng->queue[(eng->q_head + i) % AT_CMD_QUEUE_LEN];
+        done[i] = cmd->on_done;
+        ctx[i] = cmd->ctx;
+    }
+    eng->q_head = 0;
+    eng->q_count = 0;
+    eng->cmd_active = false;
+
+    for (uint8_t i = 0; i < n; i++) {
+        if (done[i] != NULL) done[i](AT_RESULT_FLUSHED, ctx[i]);
+    }
+}
+
+bool at_engine_busy(const at_engine_t *eng) {
+    return eng->q_count > 0 || eng->resync;
+}
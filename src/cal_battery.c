@@ -7,10 +7,13 @@
  * - Hardware Calibration (Curve/Line Fitting)
  * - Software Filter (EMA - Exponential Moving Average)
  * - Safety Health Check & Alerts
+ * - SENSOR_FIXED_POINT: divider and EMA in integer microvolts with Q16
+ *   gains (cal_fixed.h); the float result is only formed on return
  */
 
 #include "cal_battery.h"
 #include <stdint.h>
+#include <string.h>
 #include "esp_log.h"
 #include "esp_adc/adc_oneshot.h"
 #include "esp_adc/adc_cali.h"
@@ -19,6 +22,11 @@
 #include "freertos/task.h"
 #include "esp_check.h"
 #include "app_config.h"
+#include "sys_time.h"
+#include "sys_param.h"
+#include "sys_dlog.h"
+#include "sys_health.h"
+#include "cal_fixed.h"
 
 // PRIVATE CONFIGURATION
 static const char *TAG = "CAL_BATTERY";
@@ -27,7 +35,16 @@ static const char *TAG = "CAL_BATTERY";
 // PRIVATE STATIC VARIABLES
 static adc_oneshot_unit_handle_t adc_handle = NULL;
 static adc_cali_handle_t cali_handle = NULL;
+#if SENSOR_FIXED_POINT
+static int32_t voltage_filter_uv = 0;      // Filtered result state (uV)
+static int32_t ratio_uv_q16 = 0;           // batt_div_ratio * 1000 (mV -> uV), Q16
+static int32_t alpha_q16 = 0;              // batt_ema_alpha, Q16
+static uint32_t ratio_bits = 0;            // sysparam values the gains were made from
+static uint32_t alpha_bits = 0;
+#else
 static float voltage_filter_val = 0.0f;    // Filtered result state
+#endif
+static int64_t sample_time_us = 0;         // Stamp of voltage_filter_val
 static bool is_initialized = false;
 static bool is_calibrated = false;
 
@@ -127,6 +144,39 @@ static esp_err_t raw_to_gpio_voltage(int raw_adc, int *out_mv) {
     }
 }
 
+#if SENSOR_FIXED_POINT
+static uint32_t float_bits(float x) {
+    uint32_t bits;
+    memcpy(&bits, &x, sizeof(bits));
+    return bits;
+}
+
+/**
+ * @brief Rebuild the Q16 gains when the runtime parameters changed
+ */
+static void refresh_gains(void) {
+    float ratio = sysparam.batt_div_ratio;
+    float alpha = sysparam.batt_ema_alpha;
+
+    if (float_bits(ratio) != ratio_bits) {
+        ratio_bits = float_bits(ratio);
+        ratio_uv_q16 = fx_q16_from_float(ratio * 1000.0f);
+    }
+    if (float_bits(alpha) != alpha_bits) {
+        alpha_bits = float_bits(alpha);
+        alpha_q16 = fx_q16_from_float(alpha);
+    }
+}
+
+static float filtered_voltage(void) {
+    return (float)voltage_filter_uv * 1e-6f;
+}
+#else
+static float filtered_voltage(void) {
+    return voltage_filter_val;
+}
+#endif
+
 // PUBLIC API IMPLEMENTATION 
 
 void battery_init(void) {
@@ -158,6 +208,23 @@ void battery_init(void) {
     is_initialized = true;
 }
 
+void battery_deinit(void) {
+    if (!is_initialized) return;
+    is_initialized = false;
+
+    if (cali_handle != NULL) {
+#if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_curve_fitting(cali_handle);
+#elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+        adc_cali_delete_scheme_line_fitting(cali_handle);
+#endif
+        cali_handle = NULL;
+    }
+    adc_oneshot_del_unit(adc_handle);
+    adc_handle = NULL;
+    is_calibrated = false;
+}
+
 float battery_get_voltage(void) {
     if (!is_initialized) return 0.0f;
 
@@ -166,23 +233,43 @@ float battery_get_voltage(void) {
     int voltage_gpio_mv = 0;
 
     // Read raw
+    int64_t t_start = systime_now_us();
     if(read_adc_averaged(&adc_raw_avg) != ESP_OK) {
         error_count++;
+        health_dropout(HEALTH_CH_BATT);
         if(error_count >= MAX_ERROR_COUNT) ESP_LOGE(TAG, "Sensor Failure: Read Error");
-        return voltage_filter_val; // Keep previous value (Fail-safe)
+        return filtered_voltage(); // Keep previous value (Fail-safe)
     }
 
     // Convert to Voltage 
     if(raw_to_gpio_voltage(adc_raw_avg, &voltage_gpio_mv) != ESP_OK) {
         error_count++;
+        health_dropout(HEALTH_CH_BATT);
         if(error_count >= MAX_ERROR_COUNT) ESP_LOGE(TAG, "Sensor Failure: Convert Error");
-        return voltage_filter_val;
+        return filtered_voltage();
     }
 
     error_count = 0; // Reset error on success
+    sample_time_us = t_start + (systime_now_us() - t_start) / 2;
 
+#if SENSOR_FIXED_POINT
+    // Calculate Real Voltage (uV)
+    refresh_gains();
+    int32_t instant_uv = fx_mul_q16(voltage_gpio_mv, ratio_uv_q16);
+    health_sample(HEALTH_CH_BATT, (float)instant_uv * 1e-6f, sample_time_us);
+
+    // EMA Filter (cold start: take the first reading as is)
+    if (voltage_filter_uv == 0) {
+        voltage_filter_uv = instant_uv;
+    } else {
+        voltage_filter_uv = fx_ema_q16(voltage_filter_uv, instant_uv, alpha_q16);
+    }
+
+    return filtered_voltage();
+#else
     // Calculate Real Voltage
-    float instant_voltage = (float)voltage_gpio_mv * VOLT_DIV_RATIO / 1000.0f;
+    float instant_voltage = (float)voltage_gpio_mv * sysparam.batt_div_ratio / 1000.0f;
+    health_sample(HEALTH_CH_BATT, instant_voltage, sample_time_us);
 
     // EMA Filter
     if (voltage_filter_val == 0.0f ){
@@ -190,10 +277,16 @@ float battery_get_voltage(void) {
         voltage_filter_val = instant_voltage; 
     } else {
         // Y[n] = alpha*X[n] + (1-alpha)*Y[n-1]
-        voltage_filter_val = (EMA_ALPHA * instant_voltage) + ((1.0f - EMA_ALPHA) * voltage_filter_val);
+        float alpha = sysparam.batt_ema_alpha;
+        voltage_filter_val = (alpha * instant_voltage) + ((1.0f - alpha) * voltage_filter_val);
     }
     
     return voltage_filter_val;
+#endif
+}
+
+int64_t battery_get_sample_time_us(void) {
+    return sample_time_us;
 }
 
 float battery_get_percentage(void) {
@@ -207,25 +300,25 @@ float battery_get_percentage(void) {
 
 void battery_check_health(void) {
     // Observability Logs
-    ESP_LOGI(TAG, "--- Health Check ---"); 
+    DLOGI(TAG, "--- Health Check ---"); 
     
     float voltage = battery_get_voltage();
     float percentage = battery_get_percentage();
     
-    ESP_LOGI(TAG, "Status: %.2fV (%.1f%%)", voltage, percentage);
+    DLOGI(TAG, "Status: %.2fV (%.1f%%)", voltage, percentage);
 
     if (voltage < BATTERY_CRIT_V) {
         // Critical: Pin < 6.0V. Nguy cơ hỏng pin
-        ESP_LOGE(TAG, ">> CRITICAL: %.2fV - FORCE RETURN! <<", voltage);
+        DLOGE(TAG, ">> CRITICAL: %.2fV - FORCE RETURN! <<", voltage);
         // TODO: Trigger Event -> Force Return Home
         
     } else if (voltage < BATTERY_MIN_V) {
         // Warning: Pin yếu, nên cân nhắc quay về
-        ESP_LOGW(TAG, ">> WARNING: Low Battery - Consider Landing");
+        DLOGW(TAG, ">> WARNING: Low Battery - Consider Landing");
         
     } else if (voltage < 4.0f || voltage > 9.0f) { 
         // Abnormal: Sai mức điện áp của pin 2S 
-        ESP_LOGE(TAG, ">> ABNORMAL: Voltage out of 2S range");   
+        DLOGE(TAG, ">> ABNORMAL: Voltage out of 2S range");   
     }
 }
 
@@ -0,0 +1,78 @@
+/**
+ * @file cal_fixed.c
+ * @brief Fixed-Point Conversion Helpers Implementation (pure C)
+ * @details
+ * The 32x32 -> 64 bit products map to MULL + MULSH on the ESP32-S3, so a
+ * reciprocal multiply costs a few cycles where a float divide takes tens.
+ * Rounding is symmetric around zero so the error does not drift with sign.
+ */
+
+#include "cal_fixed.h"
+#include <math.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#define FX_HOT              IRAM_ATTR
+#else
+#define FX_HOT
+#endif
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief (p + half) >> shift on |p|, sign restored (ties away from zero)
+ */
+static inline int32_t round_shift(int64_t p, uint8_t shift) {
+    int64_t half = (int64_t)1 << (shift - 1);
+    return (int32_t)(p >= 0 ? (p + half) >> shift : -((-p + half) >> shift));
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+bool fx_recip_init(fx_recip_t *r, float divisor) {
+    r->mul = 0;
+    r->shift = 0;
+
+    double d = fabs((double)divisor);
+    if (!(d >= 0x1p-30 && d <= 0x1p30)) return false;
+
+    // Smallest shift that puts 2^shift / d in [2^30, 2^31)
+    double inv = 1.0 / d;
+    int shift = 0;
+    while (inv * ldexp(1.0, shift) < 0x1p30) shift++;
+    while (inv * ldexp(1.0, shift) >= 0x1p31) shift--;
+
+    // Rounded up: then (x * mul) >> shift == x / d exactly for integer d and |x| < 2^30
+    int64_t mul = (int64_t)ceil(inv * ldexp(1.0, shift));
+    if (mul >= ((int64_t)1 << 31)) {
+        mul >>= 1;
+        shift--;
+    }
+    if (shift < 1 || shift > 62) return false;
+
+    r->mul = (int32_t)(divisor < 0.0f ? -mul : mul);
+    r->shift = (uint8_t)shift;
+    return true;
+}
+
+FX_HOT int32_t fx_recip_apply(const fx_recip_t *r, int32_t x) {
+    if (r->shift == 0) return 0;
+
+    int64_t p = (int64_t)x * r->mul;
+    return (int32_t)(p >= 0 ? p >> r->shift : -((-p) >> r->shift));
+}
+
+int32_t fx_q16_from_float(float x) {
+    double q = nearbyint((double)x * FX_Q16_ONE);
+    if (q > INT32_MAX) return INT32_MAX;
+    if (q < INT32_MIN) return INT32_MIN;
+    return (int32_t)q;
+}
+
+FX_HOT int32_t fx_mul_q16(int32_t x, int32_t k_q16) {
+    return round_shift((int64_t)x * k_q16, FX_Q16_SHIFT);
+}
+
+FX_HOT int32_t fx_ema_q16(int32_t y, int32_t x, int32_t alpha_q16) {
+    return y + round_shift(((int64_t)x - y) * alpha_q16, FX_Q16_SHIFT);
+}
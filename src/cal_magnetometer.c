@@ -0,0 +1,393 @@
+/**
+ * @file cal_magnetometer.c
+ * @brief Magnetometer Calibration & Motor EMI Compensation
+ * @details
+ * Ellipsoid model (normalized units, x = m / MAGCAL_NORM_UT):
+ *   a*x^2 + b*y^2 + c*z^2 + 2d*xy + 2e*xz + 2f*yz + 2g*x + 2h*y + 2i*z + k = 0
+ * normalized by a + b + c = 1 (c eliminated, 9 unknowns). The trace of A
+ * does not change under translation, so the fit does not degrade when the
+ * hard-iron offset is comparable to the Earth field (a "= 1" right-hand
+ * side becomes singular when the origin lies near the ellipsoid surface).
+ * Least squares via normal equations, accumulated per sample in double
+ * (the S3 has no double FPU, but ~55 soft-float MACs at 100Hz is <1% CPU).
+ * Solve: 9x9 Cholesky, then centre + symmetric square root of the shape
+ * matrix (3x3 Jacobi) gives hard-iron offset and soft-iron correction.
+ */
+
+#include "cal_magnetometer.h"
+#include <math.h>
+#include <string.h>
+#include "app_config.h"
+#include "drv_motor.h"
+
+#define QUADRIC_PARAMS      9
+#define JACOBI_MAX_SWEEPS   10
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief Solve M p = r for symmetric positive definite M (in place Cholesky)
+ */
+static bool cholesky_solve(double m[QUADRIC_PARAMS][QUADRIC_PARAMS], double r[QUADRIC_PARAMS],
+                           double p[QUADRIC_PARAMS]) {
+    // Decompose M = L L' (L stored in lower triangle)
+    for (int j = 0; j < QUADRIC_PARAMS; j++) {
+        double sum = m[j][j];
+        for (int k = 0; k < j; k++) sum -= m[j][k] * m[j][k];
+        if (sum <= 1e-12) return false;     // Not enough excitation on some axis
+        double ljj = sqrt(sum);
+        m[j][j] = ljj;
+
+        for (int i = j + 1; i < QUADRIC_PARAMS; i++) {
+            double s = m[i][j];
+            for (int k = 0; k < j; k++) s -= m[i][k] * m[j][k];
+            m[i][j] = s / ljj;
+        }
+    }
+
+    // Forward: L y = r
+    for (int i = 0; i < QUADRIC_PARAMS; i++) {
+        double s = r[i];
+        for (int k = 0; k < i; k++) s -= m[i][k] * p[k];
+        p[i] = s / m[i][i];
+    }
+
+    // Backward: L' p = y
+    for (int i = QUADRIC_PARAMS - 1; i >= 0; i--) {
+        double s = p[i];
+        for (int k = i + 1; k < QUADRIC_PARAMS; k++) s -= m[k][i] * p[k];
+        p[i] = s / m[i][i];
+    }
+    return true;
+}
+
+/**
+ * @brief Eigen decomposition of a symmetric 3x3 matrix (cyclic Jacobi)
+ * @param a   Input matrix (destroyed: diagonal holds eigenvalues)
+ * @param v   Output eigenvectors (columns)
+ */
+static void jacobi_eigen3(double a[3][3], double v[3][3]) {
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) v[i][j] = (i == j) ? 1.0 : 0.0;
+    }
+
+    for (int sweep = 0; sweep < JACOBI_MAX_SWEEPS; sweep++) {
+        double off = fabs(a[0][1]) + fabs(a[0][2]) + fabs(a[1][2]);
+        if (off < 1e-15) break;
+
+        for (int p = 0; p < 2; p++) {
+            for (int q = p + 1; q < 3; q++) {
+                if (fabs(a[p][q]) < 1e-18) continue;
+
+                double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                double t = ((theta >= 0.0) ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1.0));
+                double c = 1.0 / sqrt(t * t + 1.0);
+                double s = t * c;
+
+                // A = J' A J
+                for (int k = 0; k < 3; k++) {
+                    double akp = a[k][p], akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double apk = a[p][k], aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < 3; k++) {
+                    double vkp = v[k][p], vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Index of element (i, j), i <= j, in the packed upper triangle of ata
+ */
+static inline int packed(int i, int j) {
+    return i * QUADRIC_PARAMS - i * (i - 1) / 2 + (j - i);
+}
+
+/**
+ * @brief Smallest standard deviation of the samples along any direction (uT)
+ * @details The linear and constant columns of D make the first and second
+ * moments of the data part of D'D, so the excitation check needs no extra
+ * accumulators.
+ */
+static double min_spread_ut(const magcal_t *cal) {
+    double n = cal->ata[packed(8, 8)];
+    double mean[3], cov[3][3], v[3][3];
+    for (int i = 0; i < 3; i++) mean[i] = cal->ata[packed(5 + i, 8)] / (2.0 * n);
+    for (int i = 0; i < 3; i++) {
+        for (int j = i; j < 3; j++) {
+            cov[i][j] = cal->ata[packed(5 + i, 5 + j)] / (4.0 * n) - mean[i] * mean[j];
+            cov[j][i] = cov[i][j];
+        }
+    }
+
+    jacobi_eigen3(cov, v);
+    double lo = cov[0][0];
+    if (cov[1][1] < lo) lo = cov[1][1];
+    if (cov[2][2] < lo) lo = cov[2][2];
+    return (lo > 0.0) ? sqrt(lo) * MAGCAL_NORM_UT : 0.0;
+}
+
+/**
+ * @brief Bilinear coordinates of a command pair in the throttle table
+ */
+static void throttle_weights(uint16_t left_raw, uint16_t right_raw, int idx[2][2], float w[2][2]) {
+    const float bin_width = (float)(MOTOR_SPEED_MAX_RAW - MOTOR_IDLE_RAW) / (MAGCAL_THR_BINS - 1);
+    float f[2];
+    int i0[2], i1[2];
+    uint16_t cmd[2] = { left_raw, right_raw };
+
+    for (int m = 0; m < 2; m++) {
+        int32_t mag = (int32_t)cmd[m] - MOTOR_IDLE_RAW;
+        if (mag < 0) mag = -mag;
+
+        float pos = (float)mag / bin_width;
+        if (pos > (float)(MAGCAL_THR_BINS - 1)) pos = (float)(MAGCAL_THR_BINS - 1);
+
+        i0[m] = (int)pos;
+        i1[m] = (i0[m] < MAGCAL_THR_BINS - 1) ? i0[m] + 1 : i0[m];
+        f[m] = pos - (float)i0[m];
+    }
+
+    idx[0][0] = i0[0]; idx[0][1] = i1[0];     // Left bins
+    idx[1][0] = i0[1]; idx[1][1] = i1[1];     // Right bins
+    w[0][0] = (1.0f - f[0]) * (1.0f - f[1]);
+    w[0][1] = (1.0f - f[0]) * f[1];
+    w[1][0] = f[0] * (1.0f - f[1]);
+    w[1][1] = f[0] * f[1];
+}
+
+static void throttle_offset(const magcal_t *cal, uint16_t left_raw, uint16_t right_raw, float out[3]) {
+    int idx[2][2];
+    float w[2][2];
+    throttle_weights(left_raw, right_raw, idx, w);
+
+    out[0] = out[1] = out[2] = 0.0f;
+    for (int a = 0; a < 2; a++) {
+        for (int b = 0; b < 2; b++) {
+            const float *cell = cal->thr_offset[idx[0][a]][idx[1][b]];
+            out[0] += w[a][b] * cell[0];
+            out[1] += w[a][b] * cell[1];
+            out[2] += w[a][b] * cell[2];
+        }
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void magcal_init(magcal_t *cal) {
+    memset(cal, 0, sizeof(*cal));
+    cal->soft[0][0] = 1.0f;
+    cal->soft[1][1] = 1.0f;
+    cal->soft[2][2] = 1.0f;
+}
+
+bool magcal_add_sample(magcal_t *cal, const float raw[3]) {
+    double x = (double)(raw[0] / MAGCAL_NORM_UT);
+    double y = (double)(raw[1] / MAGCAL_NORM_UT);
+    double z = (double)(raw[2] / MAGCAL_NORM_UT);
+    double zz = z * z;
+    double d[QUADRIC_PARAMS] = {
+        x * x - zz, y * y - zz, 2.0 * x * y, 2.0 * x * z, 2.0 * y * z, 2.0 * x, 2.0 * y, 2.0 * z, 1.0
+    };
+
+    // Forgetting: halve all sums so old orientation coverage fades out slowly
+    if (cal->sample_count >= MAGCAL_WINDOW) {
+        for (int k = 0; k < 45; k++) cal->ata[k] *= 0.5;
+        for (int i = 0; i < QUADRIC_PARAMS; i++) cal->atb[i] *= 0.5;
+        cal->sample_count /= 2;
+    }
+
+    int k = 0;
+    for (int i = 0; i < QUADRIC_PARAMS; i++) {
+        cal->atb[i] -= d[i] * zz;         // Right-hand side: -z^2
+        for (int j = i; j < QUADRIC_PARAMS; j++) {
+            cal->ata[k++] += d[i] * d[j];
+        }
+    }
+    cal->sample_count++;
+    cal->since_solve++;
+
+    if (cal->sample_count >= MAGCAL_MIN_SAMPLES && cal->since_solve >= MAGCAL_SOLVE_EVERY) {
+        cal->since_solve = 0;
+        return magcal_solve(cal);
+    }
+    return false;
+}
+
+bool magcal_solve(magcal_t *cal) {
+    if (cal->sample_count < MAGCAL_MIN_SAMPLES) return false;
+    if (min_spread_ut(cal) < MAGCAL_MIN_SPREAD_UT) return false;   // Too little tilt to observe Z
+
+    // 1. Unpack normal equations and solve for quadric parameters
+    double m[QUADRIC_PARAMS][QUADRIC_PARAMS];
+    double r[QUADRIC_PARAMS];
+    double p[QUADRIC_PARAMS];
+    int k = 0;
+    for (int i = 0; i < QUADRIC_PARAMS; i++) {
+        r[i] = cal->atb[i];
+        for (int j = i; j < QUADRIC_PARAMS; j++) {
+            m[i][j] = cal->ata[k];
+            m[j][i] = cal->ata[k];
+            k++;
+        }
+    }
+    if (!cholesky_solve(m, r, p)) return false;
+
+    double a[3][3] = {
+        { p[0], p[2], p[3] },
+        { p[2], p[1], p[4] },
+        { p[3], p[4], 1.0 - p[0] - p[1] },
+    };
+    double b[3] = { p[5], p[6], p[7] };
+
+    // 2. Centre: c = -A^-1 b (adjugate inverse)
+    double det = a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+               - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+               + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    if (det <= 0.0) return false;      // Not an ellipsoid
+
+    double inv[3][3];
+    inv[0][0] = (a[1][1] * a[2][2] - a[1][2] * a[2][1]) / det;
+    inv[0][1] = (a[0][2] * a[2][1] - a[0][1] * a[2][2]) / det;
+    inv[0][2] = (a[0][1] * a[1][2] - a[0][2] * a[1][1]) / det;
+    inv[1][0] = inv[0][1];
+    inv[1][1] = (a[0][0] * a[2][2] - a[0][2] * a[2][0]) / det;
+    inv[1][2] = (a[0][2] * a[1][0] - a[0][0] * a[1][2]) / det;
+    inv[2][0] = inv[0][2];
+    inv[2][1] = inv[1][2];
+    inv[2][2] = (a[0][0] * a[1][1] - a[0][1] * a[1][0]) / det;
+
+    double c[3];
+    for (int i = 0; i < 3; i++) {
+        c[i] = -(inv[i][0] * b[0] + inv[i][1] * b[1] + inv[i][2] * b[2]);
+    }
+
+    // 3. Shape: (x-c)' A (x-c) = c' A c - k
+    double scale = -p[8];
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) scale += c[i] * a[i][j] * c[j];
+    }
+    if (scale <= 0.0) return false;
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) a[i][j] /= scale;
+    }
+
+    // 4. Symmetric square root of the shape matrix
+    double v[3][3];
+    jacobi_eigen3(a, v);
+    double eig[3] = { a[0][0], a[1][1], a[2][2] };
+    if (eig[0] <= 0.0 || eig[1] <= 0.0 || eig[2] <= 0.0) return false;
+
+    double radius[3], r_min = 1e9, r_max = 0.0;
+    for (int i = 0; i < 3; i++) {
+        radius[i] = 1.0 / sqrt(eig[i]);
+        if (radius[i] < r_min) r_min = radius[i];
+        if (radius[i] > r_max) r_max = radius[i];
+    }
+    if (r_max / r_min > MAGCAL_MAX_AXIS_RATIO) return false;
+
+    // Keep the volume-equivalent sphere radius as output magnitude
+    double r_mean = cbrt(radius[0] * radius[1] * radius[2]);
+    float field = (float)(r_mean * MAGCAL_NORM_UT);
+    if (field < MAGCAL_FIELD_MIN_UT || field > MAGCAL_FIELD_MAX_UT) return false;
+
+    // 5. Apply: soft = r_mean * V diag(sqrt(eig)) V'
+    for (int i = 0; i < 3; i++) {
+        for (int j = 0; j < 3; j++) {
+            double s = 0.0;
+            for (int e = 0; e < 3; e++) s += v[i][e] * sqrt(eig[e]) * v[j][e];
+            cal->soft[i][j] = (float)(r_mean * s);
+        }
+        cal->offset[i] = (float)(c[i] * MAGCAL_NORM_UT);
+    }
+    cal->field_ut = field;
+    cal->is_valid = true;
+    return true;
+}
+
+void magcal_apply_iron(const magcal_t *cal, const float raw[3], float out[3]) {
+    float d0 = raw[0] - cal->offset[0];
+    float d1 = raw[1] - cal->offset[1];
+    float d2 = raw[2] - cal->offset[2];
+
+    out[0] = cal->soft[0][0] * d0 + cal->soft[0][1] * d1 + cal->soft[0][2] * d2;
+    out[1] = cal->soft[1][0] * d0 + cal->soft[1][1] * d1 + cal->soft[1][2] * d2;
+    out[2] = cal->soft[2][0] * d0 + cal->soft[2][1] * d1 + cal->soft[2][2] * d2;
+}
+
+void magcal_learn_throttle(magcal_t *cal, const float corrected[3], const float reference[3],
+                           uint16_t left_raw, uint16_t right_raw) {
+    int idx[2][2];
+    float w[2][2];
+    throttle_weights(left_raw, right_raw, idx, w);
+
+    // LMS on the interpolated table: error between observed and predicted offset
+    float predicted[3];
+    throttle_offset(cal, left_raw, right_raw, predicted);
+
+    float err[3];
+    for (int i = 0; i < 3; i++) {
+        err[i] = (corrected[i] - reference[i]) - predicted[i];
+    }
+
+    float w_best = -1.0f;
+    int best_l = 0, best_r = 0;
+    for (int a = 0; a < 2; a++) {
+        for (int b = 0; b < 2; b++) {
+            int li = idx[0][a], ri = idx[1][b];
+            if (li == 0 && ri == 0) continue;   // Idle cell is zero by definition
+
+            float gain = MAGCAL_THR_LEARN_ALPHA * w[a][b];
+            cal->thr_offset[li][ri][0] += gain * err[0];
+            cal->thr_offset[li][ri][1] += gain * err[1];
+            cal->thr_offset[li][ri][2] += gain * err[2];
+
+            if (w[a][b] > w_best) {
+                w_best = w[a][b];
+                best_l = li;
+                best_r = ri;
+            }
+        }
+    }
+    if (w_best >= 0.0f && cal->thr_hits[best_l][best_r] < UINT16_MAX) {
+        cal->thr_hits[best_l][best_r]++;
+    }
+}
+
+void magcal_correct(const magcal_t *cal, const float raw[3],
+                    uint16_t left_raw, uint16_t right_raw, float out[3]) {
+    float emi[3];
+    magcal_apply_iron(cal, raw, out);
+    throttle_offset(cal, left_raw, right_raw, emi);
+    out[0] -= emi[0];
+    out[1] -= emi[1];
+    out[2] -= emi[2];
+}
+
+float magcal_heading_deg(const float mag[3], const float accel[3]) {
+    // Up axis in body frame
+    float a_norm = sqrtf(accel[0] * accel[0] + accel[1] * accel[1] + accel[2] * accel[2]);
+    if (a_norm <= 0.0f) return 0.0f;
+    float ux = accel[0] / a_norm, uy = accel[1] / a_norm, uz = accel[2] / a_norm;
+
+    // Horizontal (North) component of the field
+    float dot = mag[0] * ux + mag[1] * uy + mag[2] * uz;
+    float nx = mag[0] - dot * ux;
+    float ny = mag[1] - dot * uy;
+    float nz = mag[2] - dot * uz;
+
+    // West = Up x North; heading is the angle of body X from North, clockwise
+    float wx = uy * nz - uz * ny;
+    float heading = atan2f(-wx, nx) * 57.29577951f;
+    if (heading < 0.0f) heading += 360.0f;
+    return heading;
+}
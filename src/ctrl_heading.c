@@ -0,0 +1,288 @@
+/**
+ * @file ctrl_heading.c
+ * @brief Heading Controller Task (GPTimer paced)
+ * @details
+ * The GPTimer alarm auto-reloads every CTRL_PERIOD_US in hardware, so the
+ * period does not accumulate task scheduling error. The ISR only timestamps
+ * the alarm and notifies the control task.
+ *
+ * Motor writes from the task and from ctrl_heading_stop() (other core, modem
+ * or standby task) go through motor_lock with the is_running check inside
+ * it: once stop has written idle, no step can overwrite it. Start and stop
+ * run their whole transition (flag, PM lock, deadline track, timer) under
+ * motor_lock, so concurrent callers see one transition and the rest return
+ * ESP_OK without touching the timer.
+ */
+
+#include "ctrl_heading.h"
+#include "sys_mem.h"
+#include "drv_motor.h"
+#include "sys_pm.h"
+#include "sys_deadline.h"
+#include "driver/gptimer.h"
+#include "esp_timer.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "app_config.h"
+
+static const char *TAG = "CTRL_HDG";
+
+_Static_assert(MEM_TASK_BYTES(CTRL_TASK_STACK) <= MEM_BUDGET_CTRL,
+               "ctrl_task over the MEM_BUDGET_TABLE entry");
+
+// PRIVATE STATIC VARIABLES
+static gptimer_handle_t timer = NULL;
+static TaskHandle_t ctrl_task_handle = NULL;
+static volatile bool is_running = false;     // Set and cleared under motor_lock
+static SemaphoreHandle_t motor_lock = NULL;
+static StaticSemaphore_t motor_lock_buf;
+static volatile bool safe_hold = false;     // Set by the deadline monitor, under motor_lock
+static dl_id_t dl_id;
+
+static ctrl_measure_cb_t measure_cb = NULL;
+static void *measure_ctx = NULL;
+
+static portMUX_TYPE ctrl_mux = portMUX_INITIALIZER_UNLOCKED;
+static ctrl_law_t law;                      // Owned by ctrl_task
+static ctrl_setpoint_t setpoint = { 0 };
+static ctrl_gains_t pending_sched[CTRL_SCHED_POINTS];
+static bool sched_pending = false;
+static bool reset_pending = false;
+static ctrl_stats_t stats;
+
+static volatile int64_t isr_time_us = 0;
+
+// --- HELPER FUNCTIONS ---
+
+static bool IRAM_ATTR on_alarm(gptimer_handle_t t, const gptimer_alarm_event_data_t *edata, void *ctx) {
+    BaseType_t woken = pdFALSE;
+    isr_time_us = esp_timer_get_time();
+    vTaskNotifyGiveFromISR(ctrl_task_handle, &woken);
+    return woken == pdTRUE;
+}
+
+/**
+ * @brief Deadline monitor escalation (ctrl_task, or esp_timer task if hung)
+ */
+static void on_deadline(dl_id_t id, bool escalated, void *ctx) {
+    // Same lock as the step: a step past its safe_hold check cannot overwrite idle
+    xSemaphoreTake(motor_lock, portMAX_DELAY);
+    safe_hold = escalated;
+    if (escalated) motor_set_speed(MOTOR_IDLE_RAW, MOTOR_IDLE_RAW);
+    xSemaphoreGive(motor_lock);
+
+    if (!escalated) {
+        // Integrators wound up against idle motors: start clean
+        portENTER_CRITICAL(&ctrl_mux);
+        reset_pending = true;
+        portEXIT_CRITICAL(&ctrl_mux);
+    }
+}
+
+static void reset_stats(void) {
+    stats.cycles = 0;
+    stats.missed = 0;
+    stats.exec_last_us = 0;
+    stats.exec_max_us = 0;
+    stats.wake_max_us = 0;
+    stats.jitter_min_us = INT32_MAX;
+    stats.jitter_max_us = INT32_MIN;
+}
+
+static void ctrl_task(void *arg) {
+    int64_t prev_tick_us = 0;
+
+    while (1) {
+        // >1 pending notifications = the previous period overran
+        uint32_t pending = ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        int64_t start_us = esp_timer_get_time();
+        int64_t tick_us = isr_time_us;
+
+        if (!is_running) continue;
+        dl_begin(dl_id);
+
+        ctrl_measurement_t meas = { .is_valid = false };
+        if (measure_cb != NULL) measure_cb(&meas, measure_ctx);
+
+        // Pick up changes requested by other tasks
+        ctrl_setpoint_t sp;
+        uint16_t left, right;
+        portENTER_CRITICAL(&ctrl_mux);
+        sp = setpoint;
+        if (sched_pending) {
+            for (int i = 0; i < CTRL_SCHED_POINTS; i++) law.sched[i] = pending_sched[i];
+            sched_pending = false;
+        }
+        if (reset_pending) {
+            ctrl_law_reset(&law);
+            prev_tick_us = 0;
+            reset_pending = false;
+        }
+        portEXIT_CRITICAL(&ctrl_mux);
+
+        ctrl_law_step(&law, &meas, &sp, CTRL_PERIOD_US * 1e-6f, &left, &right);
+        xSemaphoreTake(motor_lock, portMAX_DELAY);
+        if (is_running && !safe_hold) motor_set_speed(left, right);
+        xSemaphoreGive(motor_lock);
+        dl_end(dl_id);
+
+        // Timing statistics
+        uint32_t exec_us = (uint32_t)(esp_timer_get_time() - start_us);
+        uint32_t wake_us = (uint32_t)(start_us - tick_us);
+
+        portENTER_CRITICAL(&ctrl_mux);
+        stats.cycles++;
+        if (pending > 1) stats.missed += pending - 1;
+        stats.exec_last_us = exec_us;
+        stats.safe_hold = safe_hold;
+        if (exec_us > stats.exec_max_us) stats.exec_max_us = exec_us;
+        if (wake_us > stats.wake_max_us) stats.wake_max_us = wake_us;
+        if (prev_tick_us != 0 && pending == 1) {
+            int32_t jitter = (int32_t)(tick_us - prev_tick_us) - CTRL_PERIOD_US;
+            if (jitter < stats.jitter_min_us) stats.jitter_min_us = jitter;
+            if (jitter > stats.jitter_max_us) stats.jitter_max_us = jitter;
+        }
+        portEXIT_CRITICAL(&ctrl_mux);
+
+        prev_tick_us = tick_us;
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t ctrl_heading_init(ctrl_measure_cb_t measure, void *ctx) {
+    if (timer != NULL) return ESP_OK;
+    esp_err_t err;
+
+    measure_cb = measure;
+    measure_ctx = ctx;
+    ctrl_law_init(&law);
+    reset_stats();
+    motor_lock = xSemaphoreCreateMutexStatic(&motor_lock_buf);
+
+    const dl_config_t dl_cfg = {
+        .name = "ctrl",
+        .period_us = CTRL_PERIOD_US,
+        .budget_us = CTRL_BUDGET_US,
+        .on_escalate = on_deadline,
+    };
+    err = dl_register(&dl_cfg, &dl_id);
+    if (err != ESP_OK) return err;
+
+    ctrl_task_handle = mem_task_create(MEM_SUB_CTRL, ctrl_task, "ctrl_task", CTRL_TASK_STACK, NULL,
+                                       CTRL_TASK_PRIORITY, CTRL_TASK_CORE);
+    if (ctrl_task_handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    gptimer_config_t timer_conf = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = CTRL_TIMER_RES_HZ,
+    };
+    err = gptimer_new_timer(&timer_conf, &timer);
+    if (err != ESP_OK) return err;
+
+    gptimer_event_callbacks_t cbs = { .on_alarm = on_alarm };
+    err = gptimer_register_event_callbacks(timer, &cbs, NULL);
+    if (err != ESP_OK) return err;
+
+    gptimer_alarm_config_t alarm_conf = {
+        .alarm_count = (uint64_t)CTRL_PERIOD_US * CTRL_TIMER_RES_HZ / 1000000,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    err = gptimer_set_alarm_action(timer, &alarm_conf);
+    if (err != ESP_OK) return err;
+
+    err = gptimer_enable(timer);
+    if (err != ESP_OK) return err;
+
+    ESP_LOGI(TAG, "Heading controller ready (%d Hz)", 1000000 / CTRL_PERIOD_US);
+    return ESP_OK;
+}
+
+esp_err_t ctrl_heading_start(void) {
+    if (timer == NULL) return ESP_ERR_INVALID_STATE;
+
+    xSemaphoreTake(motor_lock, portMAX_DELAY);
+    if (is_running) {
+        xSemaphoreGive(motor_lock);
+        return ESP_OK;
+    }
+
+    portENTER_CRITICAL(&ctrl_mux);
+    reset_pending = true;
+    reset_stats();
+    portEXIT_CRITICAL(&ctrl_mux);
+
+    syspm_acquire(SYSPM_LOCK_CTRL);     // Full clock for the whole run
+    dl_start(dl_id);
+    is_running = true;
+    esp_err_t err = gptimer_set_raw_count(timer, 0);
+    if (err == ESP_OK) err = gptimer_start(timer);
+    if (err != ESP_OK) {
+        is_running = false;
+        dl_stop(dl_id);
+        syspm_release(SYSPM_LOCK_CTRL);
+    }
+    xSemaphoreGive(motor_lock);
+    return err;
+}
+
+esp_err_t ctrl_heading_stop(void) {
+    if (timer == NULL) return ESP_ERR_INVALID_STATE;
+
+    // A step past its own is_running check finishes its write before this one
+    xSemaphoreTake(motor_lock, portMAX_DELAY);
+    if (!is_running) {
+        xSemaphoreGive(motor_lock);
+        return ESP_OK;
+    }
+    is_running = false;
+    motor_set_speed(MOTOR_IDLE_RAW, MOTOR_IDLE_RAW);
+
+    dl_stop(dl_id);
+    esp_err_t err = gptimer_stop(timer);
+    syspm_release(SYSPM_LOCK_CTRL);
+    xSemaphoreGive(motor_lock);
+    return err;
+}
+
+void ctrl_heading_set_target(const ctrl_setpoint_t *sp) {
+    portENTER_CRITICAL(&ctrl_mux);
+    setpoint = *sp;
+    portEXIT_CRITICAL(&ctrl_mux);
+}
+
+void ctrl_heading_set_schedule(const ctrl_gains_t sched[CTRL_SCHED_POINTS]) {
+    portENTER_CRITICAL(&ctrl_mux);
+    for (int i = 0; i < CTRL_SCHED_POINTS; i++) {
+        pending_sched[i] = sched[i];
+    }
+    sched_pending = true;
+    portEXIT_CRITICAL(&ctrl_mux);
+}
+
+void ctrl_heading_get_stats(ctrl_stats_t *out) {
+    if (out == NULL) return;
+    portENTER_CRITICAL(&ctrl_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&ctrl_mux);
+}
+
+void ctrl_heading_log_stats(void) {
+    ctrl_stats_t s;
+    ctrl_heading_get_stats(&s);
+    if (s.cycles == 0) return;
+
+    ESP_LOGI(TAG, "Cycles: %lu | Missed: %lu | Exec: last %lu us, max %lu us",
+             (unsigned long)s.cycles, (unsigned long)s.missed,
+             (unsigned long)s.exec_last_us, (unsigned long)s.exec_max_us);
+    ESP_LOGI(TAG, "Period jitter: %ld..%ld us | Wake latency max: %lu us",
+             (long)s.jitter_min_us, (long)s.jitter_max_us, (unsigned long)s.wake_max_us);
+    if (s.safe_hold) ESP_LOGW(TAG, "Safe hold: deadline misses, motors held idle");
+}
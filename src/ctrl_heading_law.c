@@ -0,0 +1,145 @@
+/**
+ * @file ctrl_heading_law.c
+ * @brief Heading / Speed Control Law (pure, no hardware access)
+ */
+
+#include <string.h>
+#include "ctrl_heading.h"
+#include "drv_motor.h"
+#include "app_config.h"
+
+// Default heading schedule: rudder authority of differential thrust grows
+// with speed (hull yaw damping + dynamic pressure), so gains fall off.
+static const ctrl_gains_t default_sched[CTRL_SCHED_POINTS] = {
+    { 0.0f, 40.0f, 4.0f, 20.0f },
+    { 1.0f, 30.0f, 3.0f, 15.0f },
+    { 3.0f, 18.0f, 2.0f,  9.0f },
+    { 6.0f, 10.0f, 1.0f,  5.0f },
+};
+
+// --- HELPER FUNCTIONS ---
+
+static inline float clampf(float x, float lo, float hi) {
+    return (x < lo) ? lo : ((x > hi) ? hi : x);
+}
+
+/**
+ * @brief Conditional integration
+ * @details Integrate unless the last output was saturated AND the error
+ * would push further into saturation. Avoids windup without back-calculation
+ * gains to tune.
+ */
+static inline float integrate(float i, float ki_err_dt, bool sat, float u_last, float i_max) {
+    if (sat && ((u_last > 0.0f) == (ki_err_dt > 0.0f))) return i;
+    return clampf(i + ki_err_dt, -i_max, i_max);
+}
+
+static float speed_step(ctrl_law_t *law, const ctrl_measurement_t *meas, const ctrl_setpoint_t *sp, float dt) {
+    const float base_lo = (float)MOTOR_IDLE_RAW;
+    const float base_hi = (float)CTRL_BASE_MAX_RAW;
+
+    float err = sp->speed_m_s - meas->speed_m_s;
+    law->spd_i = integrate(law->spd_i, CTRL_SPD_KI * err * dt, law->spd_sat,
+                           law->u_base - base_lo, base_hi - base_lo);
+
+    float u = base_lo + CTRL_SPD_FF * sp->speed_m_s + CTRL_SPD_KP * err + law->spd_i;
+    float u_sat = clampf(u, base_lo, base_hi);
+    law->spd_sat = (u != u_sat);
+    return u_sat;
+}
+
+static float heading_step(ctrl_law_t *law, const ctrl_measurement_t *meas, const ctrl_setpoint_t *sp, float dt) {
+    ctrl_gains_t g;
+    ctrl_law_gains_at(law, meas->speed_m_s, &g);
+
+    float err = ctrl_wrap_deg(sp->heading_deg - meas->heading_deg);
+
+    // Derivative on measurement: no kick on setpoint steps, 1st order LPF
+    if (law->has_prev) {
+        float rate = ctrl_wrap_deg(meas->heading_deg - law->prev_heading) / dt;
+        law->hdg_d_filt += (dt / (CTRL_HDG_D_TAU_S + dt)) * (rate - law->hdg_d_filt);
+    }
+    law->prev_heading = meas->heading_deg;
+    law->has_prev = true;
+
+    // Integrate only near the setpoint: large turns are handled by P/D alone
+    if (err < CTRL_HDG_I_BAND_DEG && err > -CTRL_HDG_I_BAND_DEG) {
+        law->hdg_i = integrate(law->hdg_i, g.ki * err * dt, law->hdg_sat, law->u_diff, CTRL_HDG_I_MAX);
+    }
+
+    float u = g.kp * err + law->hdg_i - g.kd * law->hdg_d_filt;
+    float u_sat = clampf(u, -(float)CTRL_DIFF_MAX_RAW, (float)CTRL_DIFF_MAX_RAW);
+    law->hdg_sat = (u != u_sat);
+    return u_sat;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+float ctrl_wrap_deg(float a_minus_b) {
+    while (a_minus_b > 180.0f) a_minus_b -= 360.0f;
+    while (a_minus_b <= -180.0f) a_minus_b += 360.0f;
+    return a_minus_b;
+}
+
+void ctrl_law_init(ctrl_law_t *law) {
+    memcpy(law->sched, default_sched, sizeof(default_sched));
+    ctrl_law_reset(law);
+}
+
+void ctrl_law_reset(ctrl_law_t *law) {
+    law->hdg_i = 0.0f;
+    law->hdg_d_filt = 0.0f;
+    law->prev_heading = 0.0f;
+    law->has_prev = false;
+    law->hdg_sat = false;
+    law->spd_i = 0.0f;
+    law->spd_sat = false;
+    law->u_diff = 0.0f;
+    law->u_base = (float)MOTOR_IDLE_RAW;
+}
+
+void ctrl_law_gains_at(const ctrl_law_t *law, float speed_m_s, ctrl_gains_t *out) {
+    const ctrl_gains_t *s = law->sched;
+
+    if (speed_m_s <= s[0].speed_m_s) {
+        *out = s[0];
+        return;
+    }
+    for (int i = 1; i < CTRL_SCHED_POINTS; i++) {
+        if (speed_m_s < s[i].speed_m_s) {
+            float t = (speed_m_s - s[i - 1].speed_m_s) / (s[i].speed_m_s - s[i - 1].speed_m_s);
+            out->speed_m_s = speed_m_s;
+            out->kp = s[i - 1].kp + t * (s[i].kp - s[i - 1].kp);
+            out->ki = s[i - 1].ki + t * (s[i].ki - s[i - 1].ki);
+            out->kd = s[i - 1].kd + t * (s[i].kd - s[i - 1].kd);
+            return;
+        }
+    }
+    *out = s[CTRL_SCHED_POINTS - 1];
+}
+
+void ctrl_law_step(ctrl_law_t *law, const ctrl_measurement_t *meas, const ctrl_setpoint_t *sp,
+                   float dt, uint16_t *left_raw, uint16_t *right_raw) {
+    // Speed 0 = hold position: no steering either (at idle base, a differential
+    // only reverses one motor and spins the craft on the spot)
+    if (!sp->enabled || !meas->is_valid || sp->speed_m_s <= 0.0f || dt <= 0.0f) {
+        ctrl_law_reset(law);
+        *left_raw = MOTOR_IDLE_RAW;
+        *right_raw = MOTOR_IDLE_RAW;
+        return;
+    }
+
+    float base = speed_step(law, meas, sp, dt);
+    float diff = heading_step(law, meas, sp, dt);
+
+    // Steering has priority: lower the common throttle so the differential fits
+    float headroom = (float)MOTOR_SPEED_MAX_RAW - base;
+    float mag = (diff < 0.0f) ? -diff : diff;
+    if (mag > headroom) base = (float)MOTOR_SPEED_MAX_RAW - mag;
+
+    law->u_base = base;
+    law->u_diff = diff;
+
+    *left_raw = (uint16_t)clampf(base + diff + 0.5f, 0.0f, (float)MOTOR_SPEED_MAX_RAW);
+    *right_raw = (uint16_t)clampf(base - diff + 0.5f, 0.0f, (float)MOTOR_SPEED_MAX_RAW);
+}
@@ -0,0 +1,270 @@
+/**
+ * @file drv_gps.c
+ * @brief NEO-M8N GPS Driver Implementation
+ * @details
+ * RX path: UART ISR moves FIFO bytes into the driver ring buffer only when
+ * GPS_RX_FULL_THRESH bytes are pending or the line goes idle, so a 100-byte
+ * NAV-PVT costs ~1-2 interrupts. The GPS task reads the ring buffer in
+ * chunks and parses them in place.
+ */
+
+#include <string.h>
+#include "drv_gps.h"
+#include "sys_mem.h"
+#include "driver/uart.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "app_config.h"
+#include "sys_time.h"
+
+static const char *TAG = "DRV_GPS";
+
+_Static_assert(MEM_TASK_BYTES(GPS_TASK_STACK) <= MEM_BUDGET_GPS,
+               "gps_task over the MEM_BUDGET_TABLE entry");
+
+// PRIVATE CONFIGURATION
+#define GPS_EVENT_QUEUE_LEN     16
+#define GPS_ACK_TIMEOUT_MS      300
+#define GPS_UBX_PORT_UART1      1           // Receiver-side port id
+
+// PRIVATE STATIC VARIABLES
+static QueueHandle_t uart_queue = NULL;
+static gps_parser_t parser;
+static uint8_t rx_chunk[GPS_READ_CHUNK];
+static bool is_initialized = false;
+
+static portMUX_TYPE fix_mux = portMUX_INITIALIZER_UNLOCKED;
+static gps_fix_t latest_fix;
+static bool has_fix = false;
+static gps_fix_cb_t user_cb = NULL;
+static void *user_ctx = NULL;
+
+static uint32_t uart_overflows = 0;
+static uint32_t latency_last_us = 0;
+static uint32_t latency_max_us = 0;
+static int64_t start_time_us = 0;
+
+// --- HELPER FUNCTIONS ---
+
+static void put_u16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void put_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)((v >> 8) & 0xFF);
+    p[2] = (uint8_t)((v >> 16) & 0xFF);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+static esp_err_t send_ubx(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
+    uint8_t frame[GPS_UBX_MAX_PAYLOAD + 8];
+    size_t n = gps_ubx_build(cls, id, payload, len, frame, sizeof(frame));
+    if (n == 0) return ESP_ERR_INVALID_SIZE;
+
+    parser.last_ack_class = 0;
+    parser.last_ack_id = 0;
+    if (uart_write_bytes(GPS_UART_PORT, frame, n) != (int)n) return ESP_FAIL;
+    return uart_wait_tx_done(GPS_UART_PORT, pdMS_TO_TICKS(100));
+}
+
+/**
+ * @brief Parse incoming bytes until the receiver ACKs/NAKs a CFG message
+ */
+static bool wait_ack(uint8_t cls, uint8_t id) {
+    int64_t deadline = esp_timer_get_time() + GPS_ACK_TIMEOUT_MS * 1000LL;
+
+    while (esp_timer_get_time() < deadline) {
+        int n = uart_read_bytes(GPS_UART_PORT, rx_chunk, sizeof(rx_chunk), pdMS_TO_TICKS(20));
+        if (n > 0) {
+            gps_parser_feed(&parser, rx_chunk, (size_t)n, systime_now_us());
+        }
+        if (parser.last_ack_class == cls && parser.last_ack_id == id) {
+            return parser.last_ack_ok;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Switch receiver UART1 to GPS_BAUD_RUN, UBX in+NMEA in, UBX out only
+ */
+static void cfg_port(void) {
+    uint8_t pl[20] = {0};
+    pl[0] = GPS_UBX_PORT_UART1;
+    put_u32(&pl[4], 0x000008D0);        // 8N1
+    put_u32(&pl[8], GPS_BAUD_RUN);
+    put_u16(&pl[12], 0x0003);           // inProtoMask: UBX | NMEA
+    put_u16(&pl[14], 0x0001);           // outProtoMask: UBX
+    send_ubx(UBX_CLASS_CFG, UBX_CFG_PRT, pl, sizeof(pl));
+}
+
+static bool cfg_rate(void) {
+    uint8_t pl[6];
+    put_u16(&pl[0], GPS_MEAS_RATE_MS);
+    put_u16(&pl[2], 1);                 // One solution per measurement
+    put_u16(&pl[4], 1);                 // Time reference: GPS
+    if (send_ubx(UBX_CLASS_CFG, UBX_CFG_RATE, pl, sizeof(pl)) != ESP_OK) return false;
+    return wait_ack(UBX_CLASS_CFG, UBX_CFG_RATE);
+}
+
+static bool cfg_nav_pvt(void) {
+    uint8_t pl[3] = { UBX_CLASS_NAV, UBX_NAV_PVT, 1 };    // Every solution, current port
+    if (send_ubx(UBX_CLASS_CFG, UBX_CFG_MSG, pl, sizeof(pl)) != ESP_OK) return false;
+    return wait_ack(UBX_CLASS_CFG, UBX_CFG_MSG);
+}
+
+static void on_parser_fix(const gps_fix_t *fix, void *ctx) {
+    portENTER_CRITICAL(&fix_mux);
+    latest_fix = *fix;
+    has_fix = true;
+    portEXIT_CRITICAL(&fix_mux);
+
+    if (user_cb != NULL) {
+        user_cb(fix, user_ctx);
+    }
+
+    // Latency: last byte read from UART -> fix delivered to consumer
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - fix->rx_time_us);
+    latency_last_us = latency;
+    if (latency > latency_max_us) latency_max_us = latency;
+}
+
+static void gps_task(void *arg) {
+    uart_event_t event;
+
+    while (1) {
+        if (xQueueReceive(uart_queue, &event, portMAX_DELAY) != pdTRUE) continue;
+
+        switch (event.type) {
+            case UART_DATA: {
+                int n;
+                while ((n = uart_read_bytes(GPS_UART_PORT, rx_chunk, sizeof(rx_chunk), 0)) > 0) {
+                    gps_parser_feed(&parser, rx_chunk, (size_t)n, systime_now_us());
+                }
+                break;
+            }
+
+            case UART_FIFO_OVF:
+            case UART_BUFFER_FULL:
+                // Stream is broken: drop everything and resync on next frame start
+                uart_overflows++;
+                uart_flush_input(GPS_UART_PORT);
+                xQueueReset(uart_queue);
+                parser.state = 0;
+                ESP_LOGW(TAG, "UART overflow, input flushed");
+                break;
+
+            default:
+                break;
+        }
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t gps_init(void) {
+    if (is_initialized) return ESP_OK;
+    esp_err_t err;
+
+    gps_parser_init(&parser, on_parser_fix, NULL);
+
+    // 1. UART at factory baud
+    uart_config_t uart_conf = {
+        .baud_rate = GPS_BAUD_DEFAULT,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_XTAL,        // Baud rate independent of DFS
+    };
+    err = uart_driver_install(GPS_UART_PORT, GPS_UART_RX_BUF, 0, GPS_EVENT_QUEUE_LEN, &uart_queue, 0);
+    if (err != ESP_OK) return err;
+    err = uart_param_config(GPS_UART_PORT, &uart_conf);
+    if (err != ESP_OK) return err;
+    err = uart_set_pin(GPS_UART_PORT, PIN_GPS_TX, PIN_GPS_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (err != ESP_OK) return err;
+
+    // Batch RX interrupts
+    uart_set_rx_full_threshold(GPS_UART_PORT, GPS_RX_FULL_THRESH);
+    uart_set_rx_timeout(GPS_UART_PORT, GPS_RX_TIMEOUT_SYMBOLS);
+
+    // 2. Switch receiver to UBX @ GPS_BAUD_RUN.
+    // Sent at both baud rates: the receiver may keep a previous config in BBR.
+    cfg_port();
+    vTaskDelay(pdMS_TO_TICKS(100));
+    err = uart_set_baudrate(GPS_UART_PORT, GPS_BAUD_RUN);
+    if (err != ESP_OK) return err;
+    cfg_port();
+    vTaskDelay(pdMS_TO_TICKS(100));
+    uart_flush_input(GPS_UART_PORT);
+
+    // 3. 10Hz NAV-PVT
+    bool rate_ok = cfg_rate();
+    bool msg_ok = cfg_nav_pvt();
+    if (rate_ok && msg_ok) {
+        ESP_LOGI(TAG, "Receiver configured: UBX NAV-PVT @ %d Hz, %d baud", 1000 / GPS_MEAS_RATE_MS, GPS_BAUD_RUN);
+    } else {
+        ESP_LOGW(TAG, "Receiver did not ACK config (rate=%d, msg=%d) - NMEA fallback", rate_ok, msg_ok);
+    }
+
+    // 4. Reader task
+    xQueueReset(uart_queue);
+    if (mem_task_create(MEM_SUB_GPS, gps_task, "gps_task", GPS_TASK_STACK, NULL,
+                        GPS_TASK_PRIORITY, GPS_TASK_CORE) == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    start_time_us = esp_timer_get_time();
+    is_initialized = true;
+    return ESP_OK;
+}
+
+void gps_register_callback(gps_fix_cb_t cb, void *ctx) {
+    portENTER_CRITICAL(&fix_mux);
+    user_ctx = ctx;
+    user_cb = cb;
+    portEXIT_CRITICAL(&fix_mux);
+}
+
+bool gps_get_fix(gps_fix_t *out) {
+    if (out == NULL) return false;
+
+    portENTER_CRITICAL(&fix_mux);
+    bool valid = has_fix;
+    if (valid) *out = latest_fix;
+    portEXIT_CRITICAL(&fix_mux);
+
+    return valid;
+}
+
+void gps_get_stats(gps_stats_t *out) {
+    if (out == NULL) return;
+    out->parser = parser.stats;
+    out->uart_overflows = uart_overflows;
+    out->latency_last_us = latency_last_us;
+    out->latency_max_us = latency_max_us;
+}
+
+void gps_log_stats(void) {
+    gps_stats_t s;
+    gps_get_stats(&s);
+
+    int64_t elapsed_us = esp_timer_get_time() - start_time_us;
+    if (elapsed_us <= 0) return;
+
+    float bytes_per_s = (float)s.parser.bytes * 1e6f / (float)elapsed_us;
+    float fix_rate = (float)s.parser.fixes * 1e6f / (float)elapsed_us;
+
+    ESP_LOGI(TAG, "RX: %.0f B/s | Fixes: %lu (%.1f Hz) | UBX: %lu | NMEA: %lu",
+             bytes_per_s, (unsigned long)s.parser.fixes, fix_rate,
+             (unsigned long)s.parser.ubx_frames, (unsigned long)s.parser.nmea_sentences);
+    ESP_LOGI(TAG, "Latency: last %lu us, max %lu us | CK errors: %lu | Resyncs: %lu | Overflows: %lu",
+             (unsigned long)s.latency_last_us, (unsigned long)s.latency_max_us,
+             (unsigned long)s.parser.checksum_errors, (unsigned long)s.parser.ubx_resyncs,
+             (unsigned long)s.uart_overflows);
+}
@@ -0,0 +1,498 @@
+/**
+ * @file drv_gps_parser.c
+ * @brief Streaming UBX / NMEA Parser
+ * @details
+ * Single pass, one byte at a time, directly over the UART read buffer.
+ * - UBX: only payloads of decoded messages (NAV-PVT, ACK) are retained,
+ *   everything else is checksummed and skipped. A length above
+ *   GPS_UBX_MAX_PAYLOAD is taken as a false sync (0xB5 0x62 inside NMEA
+ *   or noise) and the header bytes are rescanned, so at most 6 bytes are
+ *   lost instead of up to 64 KB.
+ * - NMEA: GGA/RMC numeric fields are accumulated as integers while the
+ *   characters stream past; results are committed only if the XOR checksum
+ *   matches. Other sentences are skipped without field decoding.
+ * No dependency on ESP-IDF (host-testable).
+ */
+
+#include "drv_gps.h"
+#include <string.h>
+
+// PRIVATE CONFIGURATION
+enum {
+    ST_IDLE = 0,
+    ST_UBX_SYNC2,
+    ST_UBX_CLASS,
+    ST_UBX_ID,
+    ST_UBX_LEN1,
+    ST_UBX_LEN2,
+    ST_UBX_PAYLOAD,
+    ST_UBX_CKA,
+    ST_UBX_CKB,
+    ST_NMEA_ID,
+    ST_NMEA_FIELDS,
+    ST_NMEA_CK,
+    ST_NMEA_SKIP,
+};
+
+enum {
+    NMEA_NONE = 0,
+    NMEA_GGA,
+    NMEA_RMC,
+};
+
+static const int64_t POW10[GPS_NMEA_MAX_FRAC + 1] = {
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000
+};
+
+// --- HELPER FUNCTIONS ---
+
+static inline uint16_t rd_u16(const uint8_t *p) {
+    return (uint16_t)(p[0] | ((uint16_t)p[1] << 8));
+}
+
+static inline uint32_t rd_u32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static inline int32_t rd_i32(const uint8_t *p) {
+    return (int32_t)rd_u32(p);
+}
+
+static inline int hex_value(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+static void publish(gps_parser_t *p, gps_fix_t *fix, int64_t rx_time_us) {
+    fix->rx_time_us = rx_time_us;
+    p->stats.fixes++;
+    if (p->on_fix != NULL) {
+        p->on_fix(fix, p->cb_ctx);
+    }
+}
+
+// UBX
+
+static void ubx_decode_nav_pvt(gps_parser_t *p, int64_t rx_time_us) {
+    const uint8_t *pl = p->payload;
+    gps_fix_t fix;
+    memset(&fix, 0, sizeof(fix));
+
+    fix.itow_ms = rd_u32(&pl[0]);
+    fix.year = rd_u16(&pl[4]);
+    fix.month = pl[6];
+    fix.day = pl[7];
+    fix.hour = pl[8];
+    fix.min = pl[9];
+    fix.sec = pl[10];
+    fix.time_valid = (pl[11] & 0x07) == 0x07;     // validDate | validTime | fullyResolved
+    fix.nano = rd_i32(&pl[16]);
+
+    uint8_t fix_type = pl[20];
+    bool gnss_fix_ok = (pl[21] & 0x01) != 0;
+    if (!gnss_fix_ok || fix_type == 0 || fix_type == 5) {
+        fix.fix_type = GPS_FIX_NONE;
+    } else if (fix_type >= 3) {
+        fix.fix_type = GPS_FIX_3D;              // 3D or GNSS + dead reckoning
+    } else {
+        fix.fix_type = (gps_fix_type_t)fix_type;
+    }
+    fix.num_sv = pl[23];
+
+    fix.lon_e7 = rd_i32(&pl[24]);
+    fix.lat_e7 = rd_i32(&pl[28]);
+    fix.height_msl_mm = rd_i32(&pl[36]);
+    fix.h_acc_mm = rd_u32(&pl[40]);
+    fix.vel_n_mm_s = rd_i32(&pl[48]);
+    fix.vel_e_mm_s = rd_i32(&pl[52]);
+    fix.vel_d_mm_s = rd_i32(&pl[56]);
+    fix.ground_speed_mm_s = rd_i32(&pl[60]);
+    fix.course_e5 = rd_i32(&pl[64]);
+    fix.s_acc_mm_s = rd_u32(&pl[68]);
+    fix.from_ubx = true;
+
+    publish(p, &fix, rx_time_us);
+}
+
+static void ubx_dispatch(gps_parser_t *p, int64_t rx_time_us) {
+    p->stats.ubx_frames++;
+
+    if (p->ubx_class == UBX_CLASS_NAV && p->ubx_id == UBX_NAV_PVT && p->ubx_len == UBX_NAV_PVT_LEN) {
+        ubx_decode_nav_pvt(p, rx_time_us);
+    } else if (p->ubx_class == UBX_CLASS_ACK && p->ubx_len == 2) {
+        p->last_ack_class = p->payload[0];
+        p->last_ack_id = p->payload[1];
+        p->last_ack_ok = (p->ubx_id == UBX_ACK_ACK);
+        if (p->last_ack_ok) {
+            p->stats.acks++;
+        } else {
+            p->stats.naks++;
+        }
+    }
+}
+
+// NMEA
+
+static void field_reset(gps_parser_t *p) {
+    p->field_int = 0;
+    p->field_frac_digits = 0;
+    p->field_in_frac = false;
+    p->field_neg = false;
+    p->field_empty = true;
+    p->field_char = 0;
+}
+
+/**
+ * @brief Convert ddmm.mmmm (accumulated as integer) to degrees * 1e7
+ */
+static int32_t nmea_coord_e7(const gps_parser_t *p) {
+    int64_t scale = POW10[p->field_frac_digits];
+    int64_t deg = p->field_int / (100 * scale);
+    int64_t min_scaled = p->field_int - deg * 100 * scale;
+    return (int32_t)(deg * 10000000LL + (min_scaled * 10000000LL) / (60 * scale));
+}
+
+/**
+ * @brief Field value scaled to a fixed number of decimals (e.g. 3 -> milli)
+ */
+static int64_t nmea_fixed(const gps_parser_t *p, uint8_t decimals) {
+    int64_t v = p->field_int;
+    uint8_t frac = p->field_frac_digits;
+
+    while (frac < decimals) {
+        v *= 10;
+        frac++;
+    }
+    while (frac > decimals) {
+        v /= 10;
+        frac--;
+    }
+    return p->field_neg ? -v : v;
+}
+
+static void nmea_time(gps_parser_t *p, gps_fix_t *fix) {
+    int64_t scale = POW10[p->field_frac_digits];
+    int64_t hms = p->field_int / scale;
+    fix->hour = (uint8_t)(hms / 10000);
+    fix->min = (uint8_t)((hms / 100) % 100);
+    fix->sec = (uint8_t)(hms % 100);
+    fix->nano = (int32_t)((p->field_int % scale) * (1000000000LL / scale));
+}
+
+static void nmea_commit_field(gps_parser_t *p) {
+    gps_fix_t *w = &p->nmea_work;
+
+    if (p->field_empty) {
+        // Empty position field means no fix
+        if ((p->nmea_type == NMEA_GGA && p->nmea_field == 6) ||
+            (p->nmea_type == NMEA_RMC && p->nmea_field == 2)) {
+            w->fix_type = GPS_FIX_NONE;
+        }
+        return;
+    }
+
+    if (p->nmea_type == NMEA_GGA) {
+        switch (p->nmea_field) {
+            case 1: nmea_time(p, w); break;
+            case 2: w->lat_e7 = nmea_coord_e7(p); break;
+            case 3: if (p->field_char == 'S') w->lat_e7 = -w->lat_e7; break;
+            case 4: w->lon_e7 = nmea_coord_e7(p); break;
+            case 5: if (p->field_char == 'W') w->lon_e7 = -w->lon_e7; break;
+            case 6:
+                if (p->field_int == 0) w->fix_type = GPS_FIX_NONE;
+                else if (p->field_int == 6) w->fix_type = GPS_FIX_DEAD_RECKONING;
+                else w->fix_type = GPS_FIX_3D;
+                break;
+            case 7: w->num_sv = (uint8_t)p->field_int; break;
+            case 9: w->height_msl_mm = (int32_t)nmea_fixed(p, 3); break;
+            default: break;
+        }
+    } else if (p->nmea_type == NMEA_RMC) {
+        switch (p->nmea_field) {
+            case 1: nmea_time(p, w); break;
+            case 2: if (p->field_char != 'A') w->fix_type = GPS_FIX_NONE; break;
+            case 3: w->lat_e7 = nmea_coord_e7(p); break;
+            case 4: if (p->field_char == 'S') w->lat_e7 = -w->lat_e7; break;
+            case 5: w->lon_e7 = nmea_coord_e7(p); break;
+            case 6: if (p->field_char == 'W') w->lon_e7 = -w->lon_e7; break;
+            case 7: w->ground_speed_mm_s = (int32_t)(nmea_fixed(p, 3) * 514444 / 1000000); break;  // knots
+            case 8: w->course_e5 = (int32_t)nmea_fixed(p, 5); break;
+            case 9: {
+                int64_t dmy = p->field_int / POW10[p->field_frac_digits];
+                w->day = (uint8_t)(dmy / 10000);
+                w->month = (uint8_t)((dmy / 100) % 100);
+                w->year = (uint16_t)(2000 + dmy % 100);
+                w->time_valid = true;
+                break;
+            }
+            default: break;
+        }
+    }
+}
+
+static void nmea_finish(gps_parser_t *p, int64_t rx_time_us) {
+    if (p->nmea_xor != p->nmea_ck_rx) {
+        p->stats.checksum_errors++;
+        return;
+    }
+    p->stats.nmea_sentences++;
+
+    // Sentence verified: accept its fields
+    p->nmea_fix = p->nmea_work;
+
+    // RMC closes the epoch (GGA precedes it in the NEO-M8N output order)
+    if (p->nmea_type == NMEA_RMC) {
+        p->nmea_fix.from_ubx = false;
+        p->nmea_fix.h_acc_mm = 0;
+        p->nmea_fix.s_acc_mm_s = 0;
+        publish(p, &p->nmea_fix, rx_time_us);
+    }
+}
+
+static void nmea_begin(gps_parser_t *p) {
+    p->nmea_xor = 0;
+    p->nmea_id_len = 0;
+    p->state = ST_NMEA_ID;
+}
+
+static void nmea_start_fields(gps_parser_t *p) {
+    p->nmea_type = NMEA_NONE;
+    if (p->nmea_id_len == 5) {
+        if (p->nmea_id[2] == 'G' && p->nmea_id[3] == 'G' && p->nmea_id[4] == 'A') {
+            p->nmea_type = NMEA_GGA;
+        } else if (p->nmea_id[2] == 'R' && p->nmea_id[3] == 'M' && p->nmea_id[4] == 'C') {
+            p->nmea_type = NMEA_RMC;
+        }
+    }
+
+    if (p->nmea_type == NMEA_NONE) {
+        p->state = ST_NMEA_SKIP;
+        return;
+    }
+
+    // Start from the previous epoch so GGA-only fields persist into RMC
+    p->nmea_work = p->nmea_fix;
+    if (p->nmea_type == NMEA_RMC) {
+        p->nmea_work.fix_type = (p->nmea_fix.fix_type == GPS_FIX_NONE) ? GPS_FIX_2D : p->nmea_fix.fix_type;
+    }
+    p->nmea_field = 1;
+    field_reset(p);
+    p->state = ST_NMEA_FIELDS;
+}
+
+static void nmea_field_char(gps_parser_t *p, uint8_t c) {
+    if (c >= '0' && c <= '9') {
+        if (p->field_in_frac) {
+            if (p->field_frac_digits >= GPS_NMEA_MAX_FRAC) return;  // Ignore excess precision
+            p->field_frac_digits++;
+        }
+        p->field_int = p->field_int * 10 + (c - '0');
+    } else if (c == '.') {
+        p->field_in_frac = true;
+    } else if (c == '-') {
+        p->field_neg = true;
+    } else if (p->field_char == 0) {
+        p->field_char = (char)c;
+    }
+    p->field_empty = false;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void gps_parser_init(gps_parser_t *p, gps_fix_cb_t on_fix, void *ctx) {
+    memset(p, 0, sizeof(*p));
+    p->state = ST_IDLE;
+    p->on_fix = on_fix;
+    p->cb_ctx = ctx;
+}
+
+void gps_parser_feed(gps_parser_t *p, const uint8_t *data, size_t len, int64_t rx_time_us) {
+    p->stats.bytes += (uint32_t)len;
+
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = data[i];
+
+        switch (p->state) {
+            case ST_IDLE:
+                if (c == UBX_SYNC1) {
+                    p->state = ST_UBX_SYNC2;
+                } else if (c == '$') {
+                    nmea_begin(p);
+                }
+                break;
+
+            // --- UBX ---
+            case ST_UBX_SYNC2:
+                if (c == UBX_SYNC2) {
+                    p->state = ST_UBX_CLASS;
+                } else if (c == '$') {
+                    nmea_begin(p);
+                } else if (c != UBX_SYNC1) {
+                    p->state = ST_IDLE;
+                }
+                break;
+
+            case ST_UBX_CLASS:
+                p->ubx_class = c;
+                p->ck_a = c;
+                p->ck_b = c;
+                p->state = ST_UBX_ID;
+                break;
+
+            case ST_UBX_ID:
+                p->ubx_id = c;
+                p->ck_a += c;
+                p->ck_b += p->ck_a;
+                p->state = ST_UBX_LEN1;
+                break;
+
+            case ST_UBX_LEN1:
+                p->ubx_len = c;
+                p->ck_a += c;
+                p->ck_b += p->ck_a;
+                p->state = ST_UBX_LEN2;
+                break;
+
+            case ST_UBX_LEN2:
+                p->ubx_len |= (uint16_t)c << 8;
+                if (p->ubx_len > GPS_UBX_MAX_PAYLOAD) {
+                    // False sync: rescan class, id and length (may hold '$' or a real sync)
+                    uint8_t hdr[4] = { p->ubx_class, p->ubx_id, (uint8_t)(p->ubx_len & 0xFF), c };
+                    p->stats.ubx_resyncs++;
+                    p->state = ST_IDLE;
+                    gps_parser_feed(p, hdr, sizeof(hdr), rx_time_us);
+                    p->stats.bytes -= (uint32_t)sizeof(hdr);
+                    break;
+                }
+                p->ck_a += c;
+                p->ck_b += p->ck_a;
+                p->ubx_pos = 0;
+                p->state = (p->ubx_len == 0) ? ST_UBX_CKA : ST_UBX_PAYLOAD;
+                break;
+
+            case ST_UBX_PAYLOAD:
+                p->payload[p->ubx_pos++] = c;
+                p->ck_a += c;
+                p->ck_b += p->ck_a;
+                if (p->ubx_pos >= p->ubx_len) p->state = ST_UBX_CKA;
+                break;
+
+            case ST_UBX_CKA:
+                if (c == p->ck_a) {
+                    p->state = ST_UBX_CKB;
+                } else {
+                    p->stats.checksum_errors++;
+                    p->state = ST_IDLE;
+                }
+                break;
+
+            case ST_UBX_CKB:
+                if (c == p->ck_b) {
+                    ubx_dispatch(p, rx_time_us);
+                } else {
+                    p->stats.checksum_errors++;
+                }
+                p->state = ST_IDLE;
+                break;
+
+            // --- NMEA ---
+            case ST_NMEA_ID:
+                if (c == ',') {
+                    p->nmea_xor ^= c;
+                    nmea_start_fields(p);
+                } else if (c == '$') {
+                    nmea_begin(p);          // Truncated sentence, '$' starts the next one
+                } else if (c < 0x20 || c == '*') {
+                    p->state = ST_IDLE;
+                } else {
+                    p->nmea_xor ^= c;
+                    if (p->nmea_id_len < sizeof(p->nmea_id) - 1) {
+                        p->nmea_id[p->nmea_id_len++] = (char)c;
+                    }
+                }
+                break;
+
+            case ST_NMEA_FIELDS:
+                if (c == ',') {
+                    p->nmea_xor ^= c;
+                    nmea_commit_field(p);
+                    p->nmea_field++;
+                    field_reset(p);
+                } else if (c == '*') {
+                    nmea_commit_field(p);
+                    p->nmea_ck_rx = 0;
+                    p->nmea_ck_digits = 0;
+                    p->state = ST_NMEA_CK;
+                } else if (c == '$') {
+                    nmea_begin(p);          // Truncated sentence
+                } else if (c < 0x20) {
+                    p->state = ST_IDLE;
+                } else {
+                    p->nmea_xor ^= c;
+                    nmea_field_char(p, c);
+                }
+                break;
+
+            case ST_NMEA_CK: {
+                int v = hex_value(c);
+                if (c == '$') {
+                    nmea_begin(p);
+                    break;
+                }
+                if (v < 0) {
+                    p->stats.checksum_errors++;
+                    p->state = ST_IDLE;
+                    break;
+                }
+                p->nmea_ck_rx = (uint8_t)((p->nmea_ck_rx << 4) | v);
+                if (++p->nmea_ck_digits == 2) {
+                    nmea_finish(p, rx_time_us);
+                    p->state = ST_IDLE;
+                }
+                break;
+            }
+
+            case ST_NMEA_SKIP:
+                if (c == '\n') {
+                    p->state = ST_IDLE;
+                } else if (c == UBX_SYNC1) {
+                    p->state = ST_UBX_SYNC2;
+                } else if (c == '$') {
+                    nmea_begin(p);
+                }
+                break;
+
+            default:
+                p->state = ST_IDLE;
+                break;
+        }
+    }
+}
+
+size_t gps_ubx_build(uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len,
+                     uint8_t *out, size_t out_size) {
+    size_t total = (size_t)len + 8;
+    if (out == NULL || out_size < total) return 0;
+
+    out[0] = UBX_SYNC1;
+    out[1] = UBX_SYNC2;
+    out[2] = cls;
+    out[3] = id;
+    out[4] = (uint8_t)(len & 0xFF);
+    out[5] = (uint8_t)(len >> 8);
+    if (len > 0 && payload != NULL) {
+        memcpy(&out[6], payload, len);
+    }
+
+    // 8-bit Fletcher over class .. payload
+    uint8_t ck_a = 0, ck_b = 0;
+    for (size_t i = 2; i < 6 + (size_t)len; i++) {
+        ck_a += out[i];
+        ck_b += ck_a;
+    }
+    out[6 + len] = ck_a;
+    out[7 + len] = ck_b;
+    return total;
+}
@@ -0,0 +1,484 @@
+/**
+ * @file drv_imu.c
+ * @brief MPU-9250 IMU Driver Implementation
+ * @details
+ * Data path:
+ *   DRDY edge (1kHz) -> ISR stores timestamp, notifies task every N edges
+ *   -> task reads FIFO_COUNT, bursts FIFO_R_W and EXT_SENS_DATA
+ *   -> parse/scale -> consumer callback.
+ *
+ * The ESP32-S3 I2C controller has no DMA; the driver's interrupt-driven
+ * transfers already let the IMU task sleep while a burst is on the bus,
+ * so CPU cost per drain is a handful of register writes plus parsing.
+ */
+
+#include <string.h>
+#include "drv_imu.h"
+#include "sys_mem.h"
+#include "driver/i2c_master.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "app_config.h"
+#include "sys_time.h"
+
+static const char *TAG = "DRV_IMU";
+
+_Static_assert(MEM_TASK_BYTES(IMU_TASK_STACK) <= MEM_BUDGET_IMU,
+               "imu_task over the MEM_BUDGET_TABLE entry");
+
+// MPU-9250 REGISTER MAP
+#define REG_SMPLRT_DIV          0x19
+#define REG_CONFIG              0x1A
+#define REG_GYRO_CONFIG         0x1B
+#define REG_ACCEL_CONFIG        0x1C
+#define REG_ACCEL_CONFIG2       0x1D
+#define REG_FIFO_EN             0x23
+#define REG_I2C_MST_CTRL        0x24
+#define REG_I2C_SLV0_ADDR       0x25
+#define REG_I2C_SLV0_REG        0x26
+#define REG_I2C_SLV0_CTRL       0x27
+#define REG_I2C_SLV4_CTRL       0x34
+#define REG_INT_PIN_CFG         0x37
+#define REG_INT_ENABLE          0x38
+#define REG_EXT_SENS_DATA_00    0x49
+#define REG_I2C_SLV0_DO         0x63
+#define REG_I2C_MST_DELAY_CTRL  0x67
+#define REG_USER_CTRL           0x6A
+#define REG_PWR_MGMT_1          0x6B
+#define REG_PWR_MGMT_2          0x6C
+#define REG_FIFO_COUNTH         0x72
+#define REG_FIFO_R_W            0x74
+#define REG_WHO_AM_I            0x75
+
+#define WHO_AM_I_MPU9250        0x71
+#define WHO_AM_I_MPU9255        0x73
+
+#define USER_CTRL_FIFO_EN       0x40
+#define USER_CTRL_I2C_MST_EN    0x20
+#define USER_CTRL_FIFO_RST      0x04
+
+#define FIFO_EN_ACCEL_GYRO      0x78    // GYRO_X/Y/Z + ACCEL
+#define CONFIG_FIFO_MODE_STOP   0x40    // Stop writing when full (keeps packet alignment)
+#define CONFIG_DLPF_184HZ       0x01
+#define ACCEL_DLPF_218HZ        0x01
+#define INT_PIN_ANYRD_CLEAR     0x10    // Active high, push-pull, 50us pulse
+#define INT_EN_RAW_RDY          0x01
+#define I2C_MST_CLK_400KHZ      0x0D
+
+// AK8963 (behind the MPU's auxiliary I2C master)
+#define AK8963_ADDR             0x0C
+#define AK8963_READ_FLAG        0x80
+#define AK8963_WIA              0x00
+#define AK8963_HXL              0x03
+#define AK8963_CNTL1            0x0A
+#define AK8963_CNTL2            0x0B
+#define AK8963_ASAX             0x10
+#define AK8963_WIA_VALUE        0x48
+#define AK8963_MODE_POWERDOWN   0x00
+#define AK8963_MODE_FUSE_ROM    0x0F
+#define AK8963_MODE_CONT2_16BIT 0x16    // 100Hz, 16-bit
+#define AK8963_SOFT_RESET       0x01
+
+// PRIVATE STATIC VARIABLES
+static i2c_master_bus_handle_t bus_handle = NULL;
+static i2c_master_dev_handle_t dev_handle = NULL;
+static TaskHandle_t imu_task_handle = NULL;
+static imu_scale_t scale;
+static bool is_initialized = false;
+
+// Data-ready bookkeeping (written by ISR)
+static portMUX_TYPE drdy_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint32_t drdy_count = 0;
+static volatile int64_t drdy_last_us = 0;
+static uint32_t packets_consumed = 0;   // Packets read since last FIFO reset, in DRDY units
+
+// Consumer
+static imu_data_cb_t data_cb = NULL;
+static void *data_ctx = NULL;
+
+// Statistics
+static portMUX_TYPE stats_mux = portMUX_INITIALIZER_UNLOCKED;
+static imu_stats_t stats;
+static int64_t start_time_us = 0;
+
+// Static buffers (no runtime allocation)
+static uint8_t fifo_buf[IMU_FIFO_MAX_PACKETS * IMU_FIFO_PACKET_SIZE];
+static imu_sample_t sample_buf[IMU_FIFO_MAX_PACKETS];
+
+// --- HELPER FUNCTIONS ---
+
+static esp_err_t write_reg(uint8_t reg, uint8_t val) {
+    uint8_t buf[2] = { reg, val };
+    return i2c_master_transmit(dev_handle, buf, sizeof(buf), IMU_I2C_TIMEOUT_MS);
+}
+
+static esp_err_t read_regs(uint8_t reg, uint8_t *buf, size_t len) {
+    return i2c_master_transmit_receive(dev_handle, &reg, 1, buf, len, IMU_I2C_TIMEOUT_MS);
+}
+
+/**
+ * @brief Write one AK8963 register through SLV0 (init only)
+ */
+static esp_err_t mag_write(uint8_t reg, uint8_t val) {
+    esp_err_t err;
+    err = write_reg(REG_I2C_SLV0_ADDR, AK8963_ADDR);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_REG, reg);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_DO, val);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_CTRL, 0x80 | 1);
+    if (err != ESP_OK) return err;
+
+    // Aux master runs once per sample cycle, give it a few
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return ESP_OK;
+}
+
+/**
+ * @brief Read AK8963 registers through SLV0 into EXT_SENS_DATA (init only)
+ */
+static esp_err_t mag_read(uint8_t reg, uint8_t *buf, uint8_t len) {
+    esp_err_t err;
+    err = write_reg(REG_I2C_SLV0_ADDR, AK8963_READ_FLAG | AK8963_ADDR);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_REG, reg);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_CTRL, 0x80 | len);
+    if (err != ESP_OK) return err;
+
+    vTaskDelay(pdMS_TO_TICKS(10));
+    return read_regs(REG_EXT_SENS_DATA_00, buf, len);
+}
+
+static esp_err_t fifo_reset(void) {
+    esp_err_t err = write_reg(REG_USER_CTRL, USER_CTRL_FIFO_EN | USER_CTRL_I2C_MST_EN | USER_CTRL_FIFO_RST);
+
+    // Re-align packet counter with the DRDY counter
+    portENTER_CRITICAL(&drdy_mux);
+    packets_consumed = drdy_count;
+    portEXIT_CRITICAL(&drdy_mux);
+
+    return err;
+}
+
+static uint8_t gyro_fs_bits(uint16_t dps) {
+    switch (dps) {
+        case 250:  return 0x00;
+        case 500:  return 0x08;
+        case 1000: return 0x10;
+        default:   return 0x18;   // 2000 dps
+    }
+}
+
+static uint8_t accel_fs_bits(uint8_t g) {
+    switch (g) {
+        case 2:  return 0x00;
+        case 4:  return 0x08;
+        case 8:  return 0x10;
+        default: return 0x18;     // 16 g
+    }
+}
+
+static esp_err_t mag_init(uint8_t asa[3]) {
+    esp_err_t err;
+    uint8_t wia = 0;
+
+    // Enable the auxiliary I2C master at 400kHz
+    err = write_reg(REG_USER_CTRL, USER_CTRL_I2C_MST_EN);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_MST_CTRL, I2C_MST_CLK_400KHZ);
+    if (err != ESP_OK) return err;
+
+    err = mag_write(AK8963_CNTL2, AK8963_SOFT_RESET);
+    if (err != ESP_OK) return err;
+
+    err = mag_read(AK8963_WIA, &wia, 1);
+    if (err != ESP_OK) return err;
+    if (wia != AK8963_WIA_VALUE) {
+        ESP_LOGE(TAG, "AK8963 not found (WIA=0x%02X)", wia);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    // Read factory sensitivity adjustment
+    err = mag_write(AK8963_CNTL1, AK8963_MODE_POWERDOWN);
+    if (err != ESP_OK) return err;
+    err = mag_write(AK8963_CNTL1, AK8963_MODE_FUSE_ROM);
+    if (err != ESP_OK) return err;
+    err = mag_read(AK8963_ASAX, asa, 3);
+    if (err != ESP_OK) return err;
+    err = mag_write(AK8963_CNTL1, AK8963_MODE_POWERDOWN);
+    if (err != ESP_OK) return err;
+    err = mag_write(AK8963_CNTL1, AK8963_MODE_CONT2_16BIT);
+    if (err != ESP_OK) return err;
+
+    // Continuous read of HXL..ST2 into EXT_SENS_DATA_00, every IMU_MAG_DIVIDER samples.
+    // Reading ST2 each time is required to unlatch the next measurement.
+    err = write_reg(REG_I2C_SLV0_ADDR, AK8963_READ_FLAG | AK8963_ADDR);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_REG, AK8963_HXL);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV0_CTRL, 0x80 | IMU_MAG_RAW_SIZE);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_I2C_SLV4_CTRL, (IMU_MAG_DIVIDER - 1) & 0x1F);
+    if (err != ESP_OK) return err;
+    return write_reg(REG_I2C_MST_DELAY_CTRL, 0x01);   // I2C_SLV0_DLY_EN
+}
+
+static void IRAM_ATTR drdy_isr_handler(void *arg) {
+    int64_t now = systime_now_us();
+    BaseType_t higher_prio_woken = pdFALSE;
+
+    portENTER_CRITICAL_ISR(&drdy_mux);
+    drdy_last_us = now;
+    uint32_t count = ++drdy_count;
+    portEXIT_CRITICAL_ISR(&drdy_mux);
+
+    if ((count % IMU_DRAIN_EVERY) == 0) {
+        vTaskNotifyGiveFromISR(imu_task_handle, &higher_prio_woken);
+        portYIELD_FROM_ISR(higher_prio_woken);
+    }
+}
+
+static void record_bus_time(uint32_t bus_us, uint32_t samples, bool got_mag) {
+    portENTER_CRITICAL(&stats_mux);
+    stats.drains++;
+    stats.samples += samples;
+    if (got_mag) stats.mag_samples++;
+    stats.bus_time_last_us = bus_us;
+    stats.bus_time_total_us += bus_us;
+    if (bus_us > stats.bus_time_max_us) stats.bus_time_max_us = bus_us;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+static void count_error(uint32_t *counter) {
+    portENTER_CRITICAL(&stats_mux);
+    (*counter)++;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+/**
+ * @brief Drain FIFO + mag registers and deliver to consumer
+ */
+static void imu_drain(void) {
+    static uint32_t drain_index = 0;
+    uint8_t count_buf[2];
+    uint8_t mag_raw[IMU_MAG_RAW_SIZE];
+
+    // Snapshot DRDY state before looking at the FIFO
+    portENTER_CRITICAL(&drdy_mux);
+    uint32_t irq_snap = drdy_count;
+    int64_t t_snap = drdy_last_us;
+    portEXIT_CRITICAL(&drdy_mux);
+
+    int64_t t_bus_start = systime_now_us();
+
+    if (read_regs(REG_FIFO_COUNTH, count_buf, sizeof(count_buf)) != ESP_OK) {
+        count_error(&stats.bus_errors);
+        return;
+    }
+    uint16_t fifo_bytes = (uint16_t)(((count_buf[0] & 0x1F) << 8) | count_buf[1]);
+
+    // Stop-when-full mode: a (nearly) full FIFO means samples were dropped
+    if (fifo_bytes > IMU_FIFO_MAX_PACKETS * IMU_FIFO_PACKET_SIZE) {
+        ESP_LOGW(TAG, "FIFO overflow (%u bytes), resetting", fifo_bytes);
+        count_error(&stats.fifo_overflows);
+        fifo_reset();
+        return;
+    }
+
+    size_t packets = fifo_bytes / IMU_FIFO_PACKET_SIZE;
+    if (packets > 0) {
+        if (read_regs(REG_FIFO_R_W, fifo_buf, packets * IMU_FIFO_PACKET_SIZE) != ESP_OK) {
+            count_error(&stats.bus_errors);
+            fifo_reset();
+            return;
+        }
+    }
+
+    // Mag registers are refreshed by the aux master at IMU_MAG_DIVIDER samples
+    bool got_mag = false;
+    uint32_t mag_every = (IMU_MAG_DIVIDER > IMU_DRAIN_EVERY) ? (IMU_MAG_DIVIDER / IMU_DRAIN_EVERY) : 1;
+    if ((drain_index++ % mag_every) == 0) {
+        if (read_regs(REG_EXT_SENS_DATA_00, mag_raw, sizeof(mag_raw)) == ESP_OK) {
+            got_mag = true;
+        } else {
+            count_error(&stats.bus_errors);
+        }
+    }
+
+    int64_t t_bus_end = systime_now_us();
+
+    // Newest packet timestamp: match packets to DRDY edges.
+    // expected = edges seen but not yet consumed at snapshot time.
+    uint32_t expected = irq_snap - packets_consumed;
+    int64_t t_newest = t_snap;
+    if (packets > expected) {
+        // Samples landed between snapshot and FIFO_COUNT read
+        t_newest += (int64_t)(packets - expected) * IMU_SAMPLE_PERIOD_US;
+    } else if (packets < expected) {
+        t_newest -= (int64_t)(expected - packets) * IMU_SAMPLE_PERIOD_US;
+    }
+    packets_consumed += (uint32_t)packets;
+
+    size_t n = imu_fifo_parse(fifo_buf, packets * IMU_FIFO_PACKET_SIZE, &scale,
+                              t_newest, IMU_SAMPLE_PERIOD_US, sample_buf, IMU_FIFO_MAX_PACKETS);
+
+    imu_mag_sample_t mag;
+    if (got_mag) {
+        imu_mag_parse(mag_raw, &scale, &mag);
+        mag.timestamp_us = t_bus_end;
+    }
+
+    record_bus_time((uint32_t)(t_bus_end - t_bus_start), (uint32_t)n, got_mag);
+
+    if (data_cb != NULL && (n > 0 || got_mag)) {
+        data_cb(sample_buf, n, got_mag ? &mag : NULL, data_ctx);
+    }
+}
+
+static void imu_task(void *arg) {
+    while (1) {
+        // Timeout covers a missed DRDY edge (FIFO keeps the data)
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+        imu_drain();
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t imu_init(void) {
+    if (is_initialized) return ESP_OK;
+    esp_err_t err;
+
+    // 1. I2C Bus
+    i2c_master_bus_config_t bus_conf = {
+        .i2c_port = IMU_I2C_PORT,
+        .sda_io_num = PIN_IMU_SDA,
+        .scl_io_num = PIN_IMU_SCL,
+        .clk_source = I2C_CLK_SRC_DEFAULT,
+        .glitch_ignore_cnt = 7,
+        .flags.enable_internal_pullup = true,
+    };
+    err = i2c_new_master_bus(&bus_conf, &bus_handle);
+    if (err != ESP_OK) return err;
+
+    i2c_device_config_t dev_conf = {
+        .dev_addr_length = I2C_ADDR_BIT_LEN_7,
+        .device_address = IMU_I2C_ADDR,
+        .scl_speed_hz = IMU_I2C_FREQ_HZ,
+    };
+    err = i2c_master_bus_add_device(bus_handle, &dev_conf, &dev_handle);
+    if (err != ESP_OK) return err;
+
+    // 2. Identify & Reset
+    uint8_t who = 0;
+    err = read_regs(REG_WHO_AM_I, &who, 1);
+    if (err != ESP_OK) return err;
+    if (who != WHO_AM_I_MPU9250 && who != WHO_AM_I_MPU9255) {
+        ESP_LOGE(TAG, "MPU-9250 not found (WHO_AM_I=0x%02X)", who);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    err = write_reg(REG_PWR_MGMT_1, 0x80);
+    if (err != ESP_OK) return err;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    err = write_reg(REG_PWR_MGMT_1, 0x01);      // Clock: PLL with gyro reference
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_PWR_MGMT_2, 0x00);      // All axes on
+    if (err != ESP_OK) return err;
+
+    // 3. Sampling: 1kHz, DLPF ~200Hz
+    err = write_reg(REG_CONFIG, CONFIG_FIFO_MODE_STOP | CONFIG_DLPF_184HZ);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_SMPLRT_DIV, (1000 / IMU_SAMPLE_RATE_HZ) - 1);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_GYRO_CONFIG, gyro_fs_bits(IMU_GYRO_FS_DPS));
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_ACCEL_CONFIG, accel_fs_bits(IMU_ACCEL_FS_G));
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_ACCEL_CONFIG2, ACCEL_DLPF_218HZ);
+    if (err != ESP_OK) return err;
+
+    // 4. Magnetometer
+    uint8_t asa[3] = { 128, 128, 128 };
+    err = mag_init(asa);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Magnetometer init failed, continuing without mag");
+    }
+    imu_scale_init(&scale, IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS, asa);
+
+    // 5. Task (must exist before the ISR can notify it)
+    imu_task_handle = mem_task_create(MEM_SUB_IMU, imu_task, "imu_task", IMU_TASK_STACK, NULL,
+                                      IMU_TASK_PRIORITY, IMU_TASK_CORE);
+    if (imu_task_handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    // 6. Data-ready interrupt
+    gpio_config_t conf_int = {
+        .pin_bit_mask = (1ULL << PIN_IMU_INT),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    err = gpio_config(&conf_int);
+    if (err != ESP_OK) return err;
+
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;   // Already installed is fine
+    err = gpio_isr_handler_add(PIN_IMU_INT, drdy_isr_handler, NULL);
+    if (err != ESP_OK) return err;
+
+    err = write_reg(REG_INT_PIN_CFG, INT_PIN_ANYRD_CLEAR);
+    if (err != ESP_OK) return err;
+    err = write_reg(REG_INT_ENABLE, INT_EN_RAW_RDY);
+    if (err != ESP_OK) return err;
+
+    // 7. FIFO: Accel + Gyro only
+    err = write_reg(REG_FIFO_EN, FIFO_EN_ACCEL_GYRO);
+    if (err != ESP_OK) return err;
+    err = fifo_reset();
+    if (err != ESP_OK) return err;
+
+    start_time_us = esp_timer_get_time();
+    is_initialized = true;
+    ESP_LOGI(TAG, "MPU-9250 ready: %dHz, drain every %d samples", IMU_SAMPLE_RATE_HZ, IMU_DRAIN_EVERY);
+    return ESP_OK;
+}
+
+void imu_register_callback(imu_data_cb_t cb, void *ctx) {
+    portENTER_CRITICAL(&stats_mux);
+    data_ctx = ctx;
+    data_cb = cb;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void imu_get_stats(imu_stats_t *out) {
+    if (out == NULL) return;
+    portENTER_CRITICAL(&stats_mux);
+    *out = stats;
+    portEXIT_CRITICAL(&stats_mux);
+}
+
+void imu_log_stats(void) {
+    imu_stats_t s;
+    imu_get_stats(&s);
+
+    int64_t elapsed_us = esp_timer_get_time() - start_time_us;
+    if (elapsed_us <= 0) return;
+
+    float rate_hz = (float)s.samples * 1e6f / (float)elapsed_us;
+    float bus_pct = (float)s.bus_time_total_us * 100.0f / (float)elapsed_us;
+
+    ESP_LOGI(TAG, "Samples: %lu (%.1f Hz) | Mag: %lu | Drains: %lu",
+             (unsigned long)s.samples, rate_hz, (unsigned long)s.mag_samples, (unsigned long)s.drains);
+    ESP_LOGI(TAG, "Bus: %.1f%% | Last %lu us | Max %lu us | Overflows: %lu | Errors: %lu",
+             bus_pct, (unsigned long)s.bus_time_last_us, (unsigned long)s.bus_time_max_us,
+             (unsigned long)s.fifo_overflows, (unsigned long)s.bus_errors);
+}
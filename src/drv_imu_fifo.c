@@ -0,0 +1,82 @@
+/**
+ * @file drv_imu_fifo.c
+ * @brief MPU-9250 FIFO Packet Parser & Scaling
+ * @details
+ * Pure functions (no hardware access) so they can be fed canned byte
+ * streams on the host.
+ */
+
+#include "drv_imu.h"
+
+// --- HELPER FUNCTIONS ---
+
+static inline int16_t be16(const uint8_t *p) {
+    return (int16_t)(((uint16_t)p[0] << 8) | p[1]);
+}
+
+static inline int16_t le16(const uint8_t *p) {
+    return (int16_t)(((uint16_t)p[1] << 8) | p[0]);
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void imu_scale_init(imu_scale_t *scale, uint8_t accel_fs_g, uint16_t gyro_fs_dps, const uint8_t asa[3]) {
+    // 16-bit signed output: full scale maps to 32768 LSB
+    scale->accel_scale = (float)accel_fs_g * IMU_GRAVITY_MS2 / 32768.0f;
+    scale->gyro_scale = (float)gyro_fs_dps * IMU_DEG_TO_RAD / 32768.0f;
+
+    for (int i = 0; i < 3; i++) {
+        // Datasheet: Hadj = H * ((ASA - 128) * 0.5 / 128 + 1)
+        float adj = 1.0f;
+        if (asa != NULL) {
+            adj = ((float)asa[i] - 128.0f) * 0.5f / 128.0f + 1.0f;
+        }
+        scale->mag_scale[i] = IMU_MAG_UT_PER_LSB * adj;
+    }
+}
+
+size_t imu_fifo_parse(const uint8_t *buf, size_t len, const imu_scale_t *scale,
+                      int64_t t_newest_us, uint32_t period_us,
+                      imu_sample_t *out, size_t max_out) {
+    if (buf == NULL || out == NULL || scale == NULL) return 0;
+
+    // Back-date from the newest whole packet, before clamping to max_out
+    size_t whole = len / IMU_FIFO_PACKET_SIZE;
+    size_t count = (whole > max_out) ? max_out : whole;
+
+    float a_s = scale->accel_scale;
+    float g_s = scale->gyro_scale;
+    int64_t t = t_newest_us - (int64_t)(whole > 0 ? whole - 1 : 0) * period_us;
+
+    for (size_t i = 0; i < count; i++) {
+        const uint8_t *p = &buf[i * IMU_FIFO_PACKET_SIZE];
+
+        // FIFO order follows register map: ACCEL_XOUT_H .. GYRO_ZOUT_L
+        out[i].ax = (float)be16(&p[0]) * a_s;
+        out[i].ay = (float)be16(&p[2]) * a_s;
+        out[i].az = (float)be16(&p[4]) * a_s;
+        out[i].gx = (float)be16(&p[6]) * g_s;
+        out[i].gy = (float)be16(&p[8]) * g_s;
+        out[i].gz = (float)be16(&p[10]) * g_s;
+        out[i].timestamp_us = t;
+        t += period_us;
+    }
+
+    return count;
+}
+
+bool imu_mag_parse(const uint8_t raw[IMU_MAG_RAW_SIZE], const imu_scale_t *scale, imu_mag_sample_t *out) {
+    // AK8963 data is little-endian, ST2 follows HZH
+    float hx = (float)le16(&raw[0]) * scale->mag_scale[0];
+    float hy = (float)le16(&raw[2]) * scale->mag_scale[1];
+    float hz = (float)le16(&raw[4]) * scale->mag_scale[2];
+    uint8_t st2 = raw[6];
+
+    // Remap AK8963 axes to the accel/gyro frame: X <-> Y swapped, Z inverted
+    out->mx = hy;
+    out->my = hx;
+    out->mz = -hz;
+    out->overflow = (st2 & 0x08) != 0;    // HOFL
+
+    return !out->overflow;
+}
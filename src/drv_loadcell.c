@@ -5,7 +5,6 @@
 
 #include <stdint.h>
 #include <stdlib.h>
-#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "rom/ets_sys.h"
 #include "esp_log.h"
@@ -13,12 +12,28 @@
 #include "freertos/task.h"
 #include "app_config.h"
 #include "drv_loadcell.h"
+#include "sys_time.h"
+#include "sys_pm.h"
+#include "sys_param.h"
+#include "sys_health.h"
+#include "fusion_heave.h"
+
+// PRIVATE STATIC VARIABLES
+static const heave_t *heave_src = NULL;
+static lc_array_t side_array;                   // logic_detect_human() pair
+static loadcell_t *side_cells[2] = { NULL, NULL };
 
 // DRIVER IMPLEMENTATION
 
-esp_err_t loadcell_init(loadcell_t *sensor) {
+esp_err_t loadcell_init(loadcell_t *sensor, health_channel_t health_ch) {
     esp_err_t err;
 
+    // An uncalibrated cell (scale 0) still comes up for tare and calibration;
+    // inv_scale stays cleared and loadcell_get_weight() reports an error
+    // until loadcell_set_scale() succeeds
+    fx_recip_init(&sensor->inv_scale, sensor->scale_factor);
+    sensor->health_ch = (uint8_t)health_ch;
+
     //  Configure SCK (Output)
     gpio_config_t conf_sck = {
         .intr_type = GPIO_INTR_DISABLE,
@@ -44,12 +59,14 @@ esp_err_t loadcell_init(loadcell_t *sensor) {
     // Set Idle State
     gpio_set_level(sensor->pin_sck, 0);
 
+#if LOADCELL_LEGACY_SMOOTH
     // Clean Memory (CRITICAL for Logic)
     for(int i = 0; i < FILTER_BUFFER_SIZE; i++) {
         sensor->filter_buffer[i] = 0; 
     }
     sensor->buffer_head = 0;
     sensor->is_buffer_full = false;
+#endif
     
     // Reset Logic States
     sensor->stable_counter = 0;
@@ -58,6 +75,7 @@ esp_err_t loadcell_init(loadcell_t *sensor) {
     sensor->last_raw_weight = 0;
     sensor->is_collision_detected = false;
     sensor->last_collision_time_us = 0;
+    sensor->sample_time_us = 0;
 
     sensor->is_initialized = true;
     return ESP_OK;
@@ -76,6 +94,9 @@ int32_t loadcell_read_raw(loadcell_t const *sensor) {
         if (timeout > LC_READ_TIMEOUT) return LC_ERROR_CODE;
     }
 
+    // Fixed clock for the ets_delay_us() pulse timing (switch happens before interrupts go off)
+    syspm_acquire(SYSPM_LOCK_LOADCELL);
+
     // Critical Section: Bit-banging
     portDISABLE_INTERRUPTS(); 
     
@@ -101,6 +122,7 @@ int32_t loadcell_read_raw(loadcell_t const *sensor) {
     ets_delay_us(1);
     
     portENABLE_INTERRUPTS();
+    syspm_release(SYSPM_LOCK_LOADCELL);
 
     // Handle 24-bit Sign Extension
     if (raw & (1 << 23)) {
@@ -132,20 +154,77 @@ esp_err_t loadcell_read_average_raw(loadcell_t *sensor, uint8_t times) {
     return ESP_OK;
 }
 
+esp_err_t loadcell_set_scale(loadcell_t *sensor, float scale_factor) {
+    fx_recip_t inv;
+    if (!fx_recip_init(&inv, scale_factor)) return ESP_ERR_INVALID_ARG;
+
+    sensor->scale_factor = scale_factor;
+    sensor->inv_scale = inv;
+    return ESP_OK;
+}
+
 int32_t loadcell_get_weight(loadcell_t *sensor) {
     int32_t raw = loadcell_read_raw(sensor);
     
-    if (raw == LC_ERROR_CODE) return LC_ERROR_CODE;
+    if (raw == LC_ERROR_CODE) {
+        health_dropout((health_channel_t)sensor->health_ch);
+        return LC_ERROR_CODE;
+    }
+    sensor->sample_time_us = systime_now_us();
+    health_sample((health_channel_t)sensor->health_ch, (float)raw, sensor->sample_time_us);
+
+    // No valid scale yet (shift 0 = cleared reciprocal)
+    if (sensor->inv_scale.shift == 0) return LC_ERROR_CODE;
 
     // Weight = (Raw - Tare) / Scale
+#if SENSOR_FIXED_POINT
+    // Multiply by the reciprocal prepared in loadcell_init() / loadcell_set_scale()
+    return fx_recip_apply(&sensor->inv_scale, raw - sensor->offset);
+#else
     // Cast to float for proper division, then back to int32_t
     return (int32_t)((float)(raw - sensor->offset) / sensor->scale_factor);
+#endif
+}
+
+
+void loadcell_power_down(loadcell_t *sensor) {
+    if (!sensor->is_initialized) return;
+
+    // PD_SCK high for > 60us enters power-down
+    gpio_set_level(sensor->pin_sck, 1);
+    ets_delay_us(80);
+    gpio_hold_en(sensor->pin_sck);
+}
+
+void loadcell_power_up(loadcell_t *sensor) {
+    if (!sensor->is_initialized) return;
+
+    gpio_hold_dis(sensor->pin_sck);
+    gpio_set_level(sensor->pin_sck, 0);     // Resets to channel A, gain 128
+
+#if LOADCELL_LEGACY_SMOOTH
+    for (int i = 0; i < FILTER_BUFFER_SIZE; i++) {
+        sensor->filter_buffer[i] = 0;
+    }
+    sensor->buffer_head = 0;
+    sensor->is_buffer_full = false;
+#endif
+    sensor->stable_counter = 0;
+    sensor->is_human_detected = false;
+    sensor->last_raw_weight = 0;
+    sensor->is_collision_detected = false;
+
+    // The side pair's history describes the load before the power-down too
+    for (uint8_t i = 0; i < 2; i++) {
+        if (side_cells[i] == sensor) lc_array_reset_cell(&side_array, i);
+    }
 }
 
 
 // LOGIC IMPLEMENTATION
 
 
+#if LOADCELL_LEGACY_SMOOTH
 int32_t loadcell_get_smooth_weight(loadcell_t *sensor, int32_t new_weight) {
     // Returns last known average instead of corrupting the filter
     if (new_weight == LC_ERROR_CODE) {
@@ -183,61 +262,72 @@ int32_t loadcell_get_smooth_weight(loadcell_t *sensor, int32_t new_weight) {
     
     return (int32_t)(sum / count);
 }
+#endif
 
-void logic_detect_human(loadcell_t *left_sensor, loadcell_t *right_sensor) {
-    // Acquire Data (smooth_weight handles LC_ERROR_CODE internally)
-    int32_t raw_left = loadcell_get_weight(left_sensor);
-    int32_t smooth_left = loadcell_get_smooth_weight(left_sensor, raw_left);
+void loadcell_set_heave(const heave_t *heave) {
+    heave_src = heave;
+}
 
-    int32_t raw_right = loadcell_get_weight(right_sensor);
-    int32_t smooth_right = loadcell_get_smooth_weight(right_sensor, raw_right);
-    
-    // Skip processing if sensor errors (smooth returns last known or 0)
-    bool left_valid = (raw_left != LC_ERROR_CODE);
-    bool right_valid = (raw_right != LC_ERROR_CODE);
-
-    // Process LEFT Sensor
-    if (left_valid) {
-        if (smooth_left >= THRESH_HUMAN_TRIGGER) {
-            // Accumulate confidence
-            left_sensor->stable_counter++;
-            
-            // Saturation logic: Cap the counter to prevent overflow
-            if (left_sensor->stable_counter > COUNTER_DETECT_REQ) left_sensor->stable_counter = COUNTER_DETECT_REQ;
-
-            // Trigger condition
-            if (left_sensor->stable_counter >= COUNTER_DETECT_REQ) {
-                left_sensor->is_human_detected = true;
-            }
-        } 
-        else if (smooth_left <= THRESH_HUMAN_RELEASE) { 
-            if (left_sensor->stable_counter > 0) left_sensor->stable_counter--;
-            
-            // Release condition
-            if (left_sensor->stable_counter == 0) {
-                left_sensor->is_human_detected = false;
-            }
-        }
+void loadcell_cell_defaults(lc_cell_cfg_t *cfg, float x_m, float y_m) {
+    cfg->trig = sysparam.lc_human_trig;
+    cfg->rel = sysparam.lc_human_rel;
+    cfg->deadload = sysparam.lc_deadload;
+    cfg->x_m = x_m;
+    cfg->y_m = y_m;
+}
+
+/**
+ * @brief Heave factor of the cell's last conversion (0 = none)
+ */
+static float heave_factor_of(const loadcell_t *sensor, int32_t weight) {
+    const heave_t *heave = heave_src;
+    float k;
+
+    if (!sysparam.lc_heave_comp || heave == NULL || weight == LC_ERROR_CODE) return 0.0f;
+    if (!heave_factor(heave, sensor->sample_time_us - HEAVE_LC_WINDOW_US, sensor->sample_time_us, &k)) return 0.0f;
+    return k;
+}
+
+void logic_detect_human_array(lc_array_t *arr, loadcell_t *const *cells) {
+    int32_t weights[LC_ARRAY_MAX];
+    float k[LC_ARRAY_MAX];
+
+    // Acquire Data (the array handles LC_ERROR_CODE internally)
+    for (uint8_t i = 0; i < arr->count; i++) {
+        weights[i] = loadcell_get_weight(cells[i]);
+        k[i] = heave_factor_of(cells[i], weights[i]);
     }
 
-    // Process RIGHT Sensor
-    if (right_valid) {
-        if (smooth_right >= THRESH_HUMAN_TRIGGER) {
-            right_sensor->stable_counter++;
-            if (right_sensor->stable_counter > COUNTER_DETECT_REQ) right_sensor->stable_counter = COUNTER_DETECT_REQ;
-
-            if (right_sensor->stable_counter >= COUNTER_DETECT_REQ) {
-                right_sensor->is_human_detected = true;
-            }
-        } 
-        else if (smooth_right <= THRESH_HUMAN_RELEASE) {
-            if (right_sensor->stable_counter > 0) right_sensor->stable_counter--;
-            
-            if (right_sensor->stable_counter == 0) {
-                right_sensor->is_human_detected = false;
-            }
-        }
+    arr->detect_req = (uint8_t)sysparam.lc_detect_req;
+    arr->detect_fast = (uint8_t)sysparam.lc_detect_fast;
+    lc_array_update(arr, weights, k);
+
+    for (uint8_t i = 0; i < arr->count; i++) {
+        cells[i]->stable_counter = arr->stable[i];
+        cells[i]->is_human_detected = (arr->detected_mask >> i) & 1u;
+    }
+}
+
+void logic_detect_human(loadcell_t *left_sensor, loadcell_t *right_sensor) {
+    // (Re)build the pair when the sensors change
+    if (side_cells[0] != left_sensor || side_cells[1] != right_sensor) {
+        lc_array_init(&side_array, 2);
+        side_cells[0] = left_sensor;
+        side_cells[1] = right_sensor;
     }
+
+    // Thresholds follow the runtime parameters
+    lc_cell_cfg_t cfg;
+    loadcell_cell_defaults(&cfg, 0.0f, LC_SIDE_ARM_M);
+    lc_array_set_cell(&side_array, 0, &cfg);
+    loadcell_cell_defaults(&cfg, 0.0f, -LC_SIDE_ARM_M);
+    lc_array_set_cell(&side_array, 1, &cfg);
+
+    logic_detect_human_array(&side_array, side_cells);
+}
+
+const lc_array_t *logic_side_array(void) {
+    return side_cells[0] != NULL ? &side_array : NULL;
 }
 
 void logic_detect_collision(loadcell_t *front_sensor) {
@@ -256,13 +346,13 @@ void logic_detect_collision(loadcell_t *front_sensor) {
     // Calculate Delta 
     int32_t delta = abs(raw - front_sensor->last_raw_weight);
 
-    // Get current time for cooldown check
-    int64_t now_us = esp_timer_get_time();
+    // Sample time for cooldown check
+    int64_t now_us = front_sensor->sample_time_us;
     int64_t cooldown_us = COLLISION_COOLDOWN_MS * 1000LL;
 
     // Collision detection with cooldown
     // Cooldown prevents multiple triggers from post-impact oscillations
-    if (delta > THRESH_COLLISION_DELTA) {
+    if (delta > sysparam.lc_collision) {
         // Only trigger if cooldown has passed
         if ((now_us - front_sensor->last_collision_time_us) > cooldown_us) {
             front_sensor->is_collision_detected = true;
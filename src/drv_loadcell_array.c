@@ -0,0 +1,138 @@
+/**
+ * @file drv_loadcell_array.c
+ * @brief Load-Cell Array Engine (pure C, no IDF dependencies)
+ * @details
+ * One loop over the cells per tick. The moving-average row is written for
+ * every cell on every tick (all cells share one write index), which keeps
+ * its running sums exact: a failed read repeats the previous sample. The
+ * compensated window is short, so it is summed when full instead; a
+ * sample without a heave factor restarts it.
+ */
+
+#include <string.h>
+#include "drv_loadcell.h"
+
+// --- PUBLIC FUNCTIONS ---
+
+void lc_array_init(lc_array_t *arr, uint8_t count) {
+    memset(arr, 0, sizeof(*arr));
+    if (count < 1) count = 1;
+    if (count > LC_ARRAY_MAX) count = LC_ARRAY_MAX;
+    arr->count = count;
+    arr->detect_req = 1;
+    arr->detect_fast = 1;
+
+    for (int i = 0; i < LC_ARRAY_MAX; i++) {
+        arr->trig[i] = INT32_MAX;
+        arr->rel[i] = 0;
+    }
+}
+
+void lc_array_set_cell(lc_array_t *arr, uint8_t i, const lc_cell_cfg_t *cfg) {
+    if (i >= arr->count) return;
+
+    arr->trig[i] = cfg->trig;
+    arr->rel[i] = cfg->rel;
+    arr->deadload[i] = cfg->deadload;
+    arr->pos_x_mm[i] = (int32_t)(cfg->x_m * 1000.0f);
+    arr->pos_y_mm[i] = (int32_t)(cfg->y_m * 1000.0f);
+}
+
+void lc_array_reset_cell(lc_array_t *arr, uint8_t i) {
+    if (i >= arr->count) return;
+
+    for (int r = 0; r < FILTER_BUFFER_SIZE; r++) arr->hist[r][i] = 0;
+    for (int r = 0; r < LC_FAST_WINDOW; r++) arr->comp[r][i] = 0;
+    arr->hist_sum[i] = 0;
+    arr->hist_fill[i] = 0;
+    arr->comp_fill[i] = 0;
+    arr->level[i] = 0;
+    arr->stable[i] = 0;
+    arr->detected_mask &= ~(1u << i);
+}
+
+void lc_array_update(lc_array_t *arr, const int32_t *weights, const float *k) {
+    const uint8_t n = arr->count;
+    const uint8_t h = arr->hist_head;
+    const uint8_t h_prev = h ? h - 1 : FILTER_BUFFER_SIZE - 1;
+    const uint8_t c = arr->comp_head;
+
+    int32_t *row = arr->hist[h];
+    const int32_t *row_prev = arr->hist[h_prev];
+    int32_t *comp_row = arr->comp[c];
+    uint32_t mask = arr->detected_mask;
+    int64_t total = 0, mx = 0, my = 0;
+
+    for (uint8_t i = 0; i < n; i++) {
+        int32_t w = weights[i];
+        bool valid = (w != LC_ERROR_CODE);
+        uint8_t fill = arr->hist_fill[i];
+
+        // Moving average: a failed read repeats the previous sample (none yet: stays empty)
+        int32_t x = valid ? w : (fill > 0 ? row_prev[i] : 0);
+        arr->hist_sum[i] += x - row[i];
+        row[i] = x;
+        if ((valid || fill > 0) && fill < FILTER_BUFFER_SIZE) arr->hist_fill[i] = ++fill;
+
+        // Compensated window: only consecutive samples with a factor count
+        float ki = (k != NULL && valid) ? k[i] : 0.0f;
+        uint8_t comp_fill = 0;
+        if (ki > 0.0f) {
+            comp_row[i] = heave_compensate(w, ki, arr->deadload[i]);
+            comp_fill = arr->comp_fill[i] + (arr->comp_fill[i] < LC_FAST_WINDOW);
+            arr->comp_fill[i] = comp_fill;
+        } else if (arr->comp_fill[i] != 0) {
+            arr->comp_fill[i] = 0;
+        }
+
+        if (fill == 0) continue;
+
+        // Constant divisors in the steady state (multiply instead of divide)
+        int32_t level, required;
+        if (comp_fill == LC_FAST_WINDOW) {
+            int32_t sum = 0;
+            for (int r = 0; r < LC_FAST_WINDOW; r++) sum += arr->comp[r][i];
+            level = sum / LC_FAST_WINDOW;
+            required = arr->detect_fast;
+        } else {
+            level = (fill == FILTER_BUFFER_SIZE) ? arr->hist_sum[i] / FILTER_BUFFER_SIZE
+                                                 : arr->hist_sum[i] / fill;
+            required = arr->detect_req;
+        }
+        arr->level[i] = level;
+
+        // Hysteresis on valid samples only
+        if (valid) {
+            uint32_t bit = 1u << i;
+            int32_t stable = arr->stable[i];
+            if (level >= arr->trig[i]) {
+                stable = (stable < required) ? stable + 1 : required;
+                if (stable >= required) mask |= bit;
+            } else if (level <= arr->rel[i]) {
+                if (stable > 0) stable--;
+                if (stable == 0) mask &= ~bit;
+            }
+            arr->stable[i] = (uint8_t)stable;
+        }
+
+        if (level > 0) {
+            total += level;
+            mx += (int64_t)level * arr->pos_x_mm[i];
+            my += (int64_t)level * arr->pos_y_mm[i];
+        }
+    }
+
+    arr->hist_head = (h + 1 < FILTER_BUFFER_SIZE) ? h + 1 : 0;
+    arr->comp_head = (c + 1 < LC_FAST_WINDOW) ? c + 1 : 0;
+    arr->detected_mask = mask;
+
+    arr->total = total > INT32_MAX ? INT32_MAX : (int32_t)total;
+    if (total > 0) {
+        float inv = 0.001f / (float)total;
+        arr->col_x_m = (float)mx * inv;
+        arr->col_y_m = (float)my * inv;
+    } else {
+        arr->col_x_m = 0.0f;
+        arr->col_y_m = 0.0f;
+    }
+}
@@ -0,0 +1,808 @@
+/**
+ * @file drv_modem.c
+ * @brief SimCom A7682S LTE Modem Driver Implementation
+ * @details
+ * The IDF UART driver has no RX DMA mode, so the closest zero-copy path is
+ * used: the modem task reads the driver buffer straight into the free
+ * space of the AT engine ring (at_engine_rx_reserve), and the tokenizer
+ * works on that ring in place. Writes go to the driver TX ring buffer and
+ * return immediately.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "drv_modem.h"
+#include "sys_mem.h"
+#include "sys_pm.h"
+#include "driver/uart.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "app_config.h"
+
+static const char *TAG = "DRV_MODEM";
+
+// PRIVATE CONFIGURATION
+#define MODEM_EVENT_QUEUE_LEN   16
+#define MODEM_PUB_CMDS          3           // TOPIC + PAYLOAD + PUB
+#define MODEM_SUB_CMDS          2           // SUBTOPIC + SUB
+#define MODEM_CONNECT_CMDS      5           // START + ACCQ + 2x SSL + CONNECT
+#define MODEM_HTTP_CMDS         4           // INIT + URL + USERDATA + ACTION
+
+typedef struct {
+    char topic[MODEM_MQTT_TOPIC_MAX];
+    uint8_t payload[MODEM_MQTT_PAYLOAD_MAX];
+    uint16_t len;
+    uint8_t qos;
+    modem_pub_done_cb_t done;
+    void *done_ctx;
+} pub_slot_t;
+
+/**
+ * @brief Message posted to the modem task
+ */
+typedef enum {
+    MSG_CMD = 0,
+    MSG_URC,
+    MSG_PUB,
+    MSG_SUB,
+    MSG_CONNECT,
+    MSG_HTTP,
+} msg_type_t;
+
+typedef struct {
+    msg_type_t type;
+    union {
+        at_cmd_t cmd;
+        at_urc_handler_t urc;
+        pub_slot_t *pub;
+        uint8_t slot;
+    };
+} modem_msg_t;
+
+typedef struct {
+    char topic[MODEM_MQTT_TOPIC_MAX];
+    uint8_t qos;
+} sub_entry_t;
+
+_Static_assert(MEM_TASK_BYTES(MODEM_TASK_STACK) + MEM_QUEUE_BYTES(MODEM_MSG_QUEUE_LEN, sizeof(modem_msg_t)) +
+               MEM_POOL_BYTES(sizeof(pub_slot_t), MODEM_MQTT_PUB_SLOTS) <= MEM_BUDGET_MODEM,
+               "modem_task, queue and publish pool over the MEM_BUDGET_TABLE entry");
+
+/**
+ * @brief Next AT step of the HTTP request (queued from drain_messages)
+ */
+typedef enum {
+    HTTP_STEP_NONE = 0,
+    HTTP_STEP_READ,
+    HTTP_STEP_TERM,
+} http_step_t;
+
+typedef struct {
+    char url[MODEM_HTTP_URL_MAX];
+    uint32_t offset;
+    uint32_t len;
+    modem_http_data_cb_t on_data;
+    modem_http_done_cb_t on_done;
+    void *ctx;
+    int32_t status;
+    uint32_t body_len;          // Bytes to read (announced by +HTTPACTION, capped to len)
+    uint32_t read_pos;          // Next AT+HTTPREAD offset
+    uint32_t read_len;          // Size of the AT+HTTPREAD in flight
+    uint32_t delivered;
+    uint8_t step;               // http_step_t
+    volatile bool busy;
+} http_req_t;
+
+// PRIVATE STATIC VARIABLES
+static QueueHandle_t uart_queue = NULL;
+static QueueHandle_t msg_queue = NULL;
+static at_engine_t engine;
+static bool is_initialized = false;
+
+static portMUX_TYPE modem_mux = portMUX_INITIALIZER_UNLOCKED;
+static modem_event_cb_t event_cb = NULL;
+static void *event_ctx = NULL;
+static modem_mqtt_rx_cb_t rx_cb = NULL;
+static void *rx_ctx = NULL;
+
+// MQTT state (written by the modem task only, except the publish pool)
+static volatile bool mqtt_connected = false;
+static mem_pool_t *pub_pool = NULL;      // pub_slot_t blocks, MODEM_MQTT_PUB_SLOTS
+static sub_entry_t subs[MODEM_MQTT_MAX_SUBS];
+static uint8_t sub_count = 0;
+static uint8_t resub_next = MODEM_MQTT_MAX_SUBS;    // Resubscribe cursor after CONNECT
+
+// Connection parameters
+static char broker_uri[96];
+static char client_id[32];
+static bool broker_tls = false;
+
+// Incoming message reassembly
+static char rx_topic[MODEM_MQTT_TOPIC_MAX];
+static uint8_t rx_payload[MODEM_MQTT_RX_MAX];
+static size_t rx_payload_len = 0;
+static bool rx_truncated = false;
+static int64_t rx_start_us = 0;
+
+// HTTP request (modem task, except the busy flag)
+static http_req_t http;
+
+static uint32_t uart_overflows = 0;
+static uint32_t msg_queue_full = 0;
+static uint32_t pub_ok = 0;
+static uint32_t pub_failed = 0;
+static uint32_t mqtt_rx_count = 0;
+static uint32_t mqtt_rx_truncated = 0;
+static uint32_t http_requests = 0;
+static uint32_t http_failed = 0;
+static uint32_t http_bytes = 0;
+
+// --- HELPER FUNCTIONS ---
+
+static size_t uart_write(const uint8_t *data, size_t len, void *io_ctx) {
+    int n = uart_write_bytes(MODEM_UART_PORT, data, len);
+    return (n > 0) ? (size_t)n : 0;
+}
+
+static void emit_event(modem_event_t evt) {
+    modem_event_cb_t cb = event_cb;
+    if (cb != NULL) cb(evt, event_ctx);
+}
+
+static bool post_msg(const modem_msg_t *msg) {
+    if (msg_queue == NULL || xQueueSend(msg_queue, msg, 0) != pdTRUE) {
+        msg_queue_full++;
+        return false;
+    }
+    return true;
+}
+
+static void submit_simple(const char *text, const char *done_prefix, uint32_t timeout_ms) {
+    at_cmd_t c = {0};
+    strncpy(c.cmd, text, sizeof(c.cmd) - 1);
+    c.done_prefix = done_prefix;
+    c.timeout_ms = timeout_ms;
+    at_engine_submit(&engine, &c);
+}
+
+/**
+ * @brief "+CMQTTPUB: 0,<err>" -> err == 0 means broker accepted
+ */
+static void on_pub_line(const at_span_t *line, void *ctx) {
+    int32_t err;
+    pub_slot_t *slot = (pub_slot_t *)ctx;
+    if (at_span_get_int(line, 1, &err) && err != 0) {
+        slot->qos = 0xFF;   // Mark failed for on_pub_done
+    }
+}
+
+static void on_pub_done(at_result_t result, void *ctx) {
+    pub_slot_t *slot = (pub_slot_t *)ctx;
+    bool ok = (result == AT_RESULT_OK) && (slot->qos != 0xFF);
+    modem_pub_done_cb_t done = slot->done;
+    void *done_ctx = slot->done_ctx;
+
+    mem_pool_free(pub_pool, slot);
+    if (ok) {
+        pub_ok++;
+    } else {
+        pub_failed++;
+        emit_event(MODEM_EVT_MQTT_PUB_FAILED);
+    }
+    if (done != NULL) done(ok, done_ctx);
+}
+
+static void queue_publish(pub_slot_t *slot) {
+    at_cmd_t c = {0};
+
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMQTTTOPIC=0,%u", (unsigned)strlen(slot->topic));
+    c.data = (const uint8_t *)slot->topic;
+    c.data_len = (uint16_t)strlen(slot->topic);
+    at_engine_submit(&engine, &c);
+
+    memset(&c, 0, sizeof(c));
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMQTTPAYLOAD=0,%u", (unsigned)slot->len);
+    c.data = slot->payload;
+    c.data_len = slot->len;
+    at_engine_submit(&engine, &c);
+
+    memset(&c, 0, sizeof(c));
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMQTTPUB=0,%u,60", (unsigned)slot->qos);
+    c.match = "+CMQTTPUB:";
+    c.done_prefix = "+CMQTTPUB:";
+    c.timeout_ms = MODEM_MQTT_PUB_TIMEOUT_MS;
+    c.on_line = on_pub_line;
+    c.on_done = on_pub_done;
+    c.ctx = slot;
+    at_engine_submit(&engine, &c);
+}
+
+static void queue_subscribe(const sub_entry_t *s) {
+    at_cmd_t c = {0};
+
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMQTTSUBTOPIC=0,%u,%u", (unsigned)strlen(s->topic), (unsigned)s->qos);
+    c.data = (const uint8_t *)s->topic;
+    c.data_len = (uint16_t)strlen(s->topic);
+    at_engine_submit(&engine, &c);
+
+    memset(&c, 0, sizeof(c));
+    strncpy(c.cmd, "AT+CMQTTSUB=0", sizeof(c.cmd) - 1);
+    c.done_prefix = "+CMQTTSUB:";
+    c.timeout_ms = MODEM_MQTT_PUB_TIMEOUT_MS;
+    at_engine_submit(&engine, &c);
+}
+
+/**
+ * @brief "+CMQTTCONNECT: 0,<err>"
+ */
+static void on_connect_line(const at_span_t *line, void *ctx) {
+    int32_t err;
+    if (!at_span_get_int(line, 1, &err)) return;
+
+    if (err == 0) {
+        mqtt_connected = true;
+        resub_next = 0;         // Re-applied by drain_messages() as the queue has room
+        ESP_LOGI(TAG, "MQTT connected");
+        emit_event(MODEM_EVT_MQTT_CONNECTED);
+    } else {
+        ESP_LOGW(TAG, "MQTT connect failed (%ld)", (long)err);
+    }
+}
+
+static void queue_connect(void) {
+    submit_simple("AT+CMQTTSTART", "+CMQTTSTART:", 12000);
+
+    at_cmd_t c = {0};
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMQTTACCQ=0,\"%s\",%d", client_id, broker_tls ? 1 : 0);
+    at_engine_submit(&engine, &c);
+
+    if (broker_tls) {
+        submit_simple("AT+CSSLCFG=\"sslversion\",0,3", NULL, 0);   // TLS 1.2
+        submit_simple("AT+CMQTTSSLCFG=0,0", NULL, 0);
+    }
+
+    memset(&c, 0, sizeof(c));
+    snprintf(c.cmd, sizeof(c.cmd), "AT+CMQTTCONNECT=0,\"%s\",%d,1",
+             broker_uri, MODEM_MQTT_KEEPALIVE_S);
+    c.match = "+CMQTTCONNECT:";
+    c.done_prefix = "+CMQTTCONNECT:";
+    c.timeout_ms = MODEM_MQTT_CONNECT_TIMEOUT_MS;
+    c.on_line = on_connect_line;
+    at_engine_submit(&engine, &c);
+}
+
+static void on_conn_lost(const at_span_t *line, void *ctx) {
+    mqtt_connected = false;
+    ESP_LOGW(TAG, "MQTT connection lost");
+    emit_event(MODEM_EVT_MQTT_LOST);
+}
+
+static void on_rx_topic_chunk(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx) {
+    if (offset >= sizeof(rx_topic) - 1) return;
+    size_t n = len;
+    if (offset + n > sizeof(rx_topic) - 1) n = sizeof(rx_topic) - 1 - offset;
+    memcpy(&rx_topic[offset], data, n);
+    rx_topic[offset + n] = '\0';
+}
+
+static void on_rx_payload_chunk(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx) {
+    size_t base = rx_payload_len;
+    if (base >= sizeof(rx_payload)) {
+        rx_truncated = true;
+        return;
+    }
+    size_t n = len;
+    if (base + n > sizeof(rx_payload)) {
+        n = sizeof(rx_payload) - base;
+        rx_truncated = true;
+    }
+    memcpy(&rx_payload[base], data, n);
+    rx_payload_len += n;
+}
+
+static void on_rx_start(const at_span_t *line, void *ctx) {
+    rx_start_us = esp_timer_get_time();
+    rx_topic[0] = '\0';
+    rx_payload_len = 0;
+    rx_truncated = false;
+}
+
+/**
+ * @brief "+CMQTTRXTOPIC: 0,<len>" / "+CMQTTRXPAYLOAD: 0,<len>" announce a raw block
+ */
+static void on_rx_topic(const at_span_t *line, void *ctx) {
+    int32_t len;
+    if (at_span_get_int(line, 1, &len) && len > 0) {
+        at_engine_expect_raw(&engine, (size_t)len, on_rx_topic_chunk, NULL);
+    }
+}
+
+static void on_rx_payload(const at_span_t *line, void *ctx) {
+    int32_t len;
+    if (at_span_get_int(line, 1, &len) && len > 0) {
+        at_engine_expect_raw(&engine, (size_t)len, on_rx_payload_chunk, NULL);
+    }
+}
+
+static void on_rx_end(const at_span_t *line, void *ctx) {
+    mqtt_rx_count++;
+    if (rx_truncated) mqtt_rx_truncated++;
+
+    modem_mqtt_rx_cb_t cb = rx_cb;
+    if (cb != NULL) cb(rx_topic, rx_payload, rx_payload_len, rx_ctx);
+}
+
+/**
+ * @brief End the HTTP request: report, then release the client (AT+HTTPTERM)
+ */
+static void http_finish(bool ok) {
+    int32_t status = ok ? http.status : -1;
+    size_t len = http.delivered;
+    modem_http_done_cb_t cb = http.on_done;
+    void *ctx = http.ctx;
+
+    if (!ok) http_failed++;
+    http.step = HTTP_STEP_TERM;
+    http.busy = false;          // on_done may post the next request (queued after HTTPTERM)
+    if (cb != NULL) cb(status, len, ctx);
+}
+
+static void on_http_chunk(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx) {
+    // Bytes beyond the requested range (200 reply ignoring Range) are dropped
+    size_t n = len;
+    if (http.delivered + n > http.body_len) n = http.body_len - http.delivered;
+    if (n == 0) return;
+    if (http.on_data != NULL) http.on_data(data, n, http.delivered, http.ctx);
+    http.delivered += n;
+    http_bytes += n;
+}
+
+/**
+ * @brief "+HTTPREAD: <len>" announces a raw block, "+HTTPREAD: 0" ends the read
+ */
+static void on_http_read_line(const at_span_t *line, void *ctx) {
+    int32_t len;
+    if (at_span_get_int(line, 0, &len) && len > 0) {
+        at_engine_expect_raw(&engine, (size_t)len, on_http_chunk, NULL);
+    }
+}
+
+static void on_http_read_done(at_result_t result, void *ctx) {
+    if (result != AT_RESULT_OK) {
+        http_finish(false);
+        return;
+    }
+    http.read_pos += http.read_len;
+    if (http.delivered >= http.body_len) {
+        http_finish(true);
+    } else if (http.read_pos >= http.body_len) {
+        http_finish(false);     // Module delivered less than it announced
+    } else {
+        http.step = HTTP_STEP_READ;
+    }
+}
+
+/**
+ * @brief "+HTTPACTION: 0,<status>,<len>"
+ */
+static void on_http_action_line(const at_span_t *line, void *ctx) {
+    int32_t status, len;
+    if (!at_span_get_int(line, 1, &status) || !at_span_get_int(line, 2, &len)) return;
+    http.status = status;
+    http.body_len = (len > 0) ? (uint32_t)len : 0;
+}
+
+static void on_http_action_done(at_result_t result, void *ctx) {
+    bool ranged = (http.status == 206) || (http.status == 200 && http.offset == 0);
+    if (result != AT_RESULT_OK || !ranged || http.body_len == 0) {
+        ESP_LOGW(TAG, "HTTP GET failed (status %ld)", (long)http.status);
+        http_finish(false);
+        return;
+    }
+    if (http.body_len > http.len) http.body_len = http.len;
+    http.step = HTTP_STEP_READ;
+}
+
+static void queue_http_request(void) {
+    submit_simple("AT+HTTPINIT", NULL, 0);      // ERROR if still open: harmless
+
+    at_cmd_t c = {0};
+    snprintf(c.cmd, sizeof(c.cmd), "AT+HTTPPARA=\"URL\",\"%s\"", http.url);
+    at_engine_submit(&engine, &c);
+
+    memset(&c, 0, sizeof(c));
+    snprintf(c.cmd, sizeof(c.cmd), "AT+HTTPPARA=\"USERDATA\",\"Range: bytes=%lu-%lu\"",
+             (unsigned long)http.offset, (unsigned long)(http.offset + http.len - 1));
+    at_engine_submit(&engine, &c);
+
+    memset(&c, 0, sizeof(c));
+    strncpy(c.cmd, "AT+HTTPACTION=0", sizeof(c.cmd) - 1);
+    c.match = "+HTTPACTION:";
+    c.done_prefix = "+HTTPACTION:";
+    c.timeout_ms = MODEM_HTTP_ACTION_TIMEOUT_MS;
+    c.on_line = on_http_action_line;
+    c.on_done = on_http_action_done;
+    at_engine_submit(&engine, &c);
+}
+
+/**
+ * @brief Queue the pending HTTP step (needs one free command slot)
+ */
+static void queue_http_step(void) {
+    at_cmd_t c = {0};
+
+    if (http.step == HTTP_STEP_TERM) {
+        strncpy(c.cmd, "AT+HTTPTERM", sizeof(c.cmd) - 1);
+    } else {
+        uint32_t n = http.body_len - http.read_pos;
+        if (n > MODEM_HTTP_READ_MAX) n = MODEM_HTTP_READ_MAX;
+        http.read_len = n;
+        snprintf(c.cmd, sizeof(c.cmd), "AT+HTTPREAD=%lu,%lu", (unsigned long)http.read_pos, (unsigned long)n);
+        c.match = "+HTTPREAD:";
+        c.done_prefix = "+HTTPREAD: 0";
+        c.timeout_ms = MODEM_HTTP_READ_TIMEOUT_MS;
+        c.on_line = on_http_read_line;
+        c.on_done = on_http_read_done;
+    }
+    http.step = HTTP_STEP_NONE;
+    at_engine_submit(&engine, &c);
+}
+
+/**
+ * @brief Move posted messages into the engine while it has room
+ */
+static void drain_messages(void) {
+    modem_msg_t msg;
+
+    while (resub_next < sub_count && AT_CMD_QUEUE_LEN - engine.q_count >= MODEM_SUB_CMDS) {
+        queue_subscribe(&subs[resub_next++]);
+    }
+    if (http.step != HTTP_STEP_NONE && engine.q_count < AT_CMD_QUEUE_LEN) {
+        queue_http_step();
+    }
+
+    while (xQueuePeek(msg_queue, &msg, 0) == pdTRUE) {
+        uint8_t room = AT_CMD_QUEUE_LEN - engine.q_count;
+        uint8_t needed = 1;
+        if (msg.type == MSG_PUB) needed = MODEM_PUB_CMDS;
+        else if (msg.type == MSG_SUB) needed = MODEM_SUB_CMDS;
+        else if (msg.type == MSG_CONNECT) needed = MODEM_CONNECT_CMDS;
+        else if (msg.type == MSG_HTTP) needed = MODEM_HTTP_CMDS + 1;    // + HTTPTERM of the last request
+        if (msg.type != MSG_URC && room < needed) break;
+
+        xQueueReceive(msg_queue, &msg, 0);
+        switch (msg.type) {
+            case MSG_CMD:
+                at_engine_submit(&engine, &msg.cmd);
+                break;
+            case MSG_URC:
+                if (!at_engine_register_urc(&engine, msg.urc.prefix, msg.urc.cb, msg.urc.ctx)) {
+                    ESP_LOGE(TAG, "URC table full (%s)", msg.urc.prefix);
+                }
+                break;
+            case MSG_PUB:
+                queue_publish(msg.pub);
+                break;
+            case MSG_SUB:
+                if (mqtt_connected) queue_subscribe(&subs[msg.slot]);
+                break;
+            case MSG_CONNECT:
+                queue_connect();
+                break;
+            case MSG_HTTP:
+                if (http.step == HTTP_STEP_TERM) queue_http_step();
+                queue_http_request();
+                break;
+        }
+    }
+}
+
+static void read_uart(void) {
+    uint8_t *buf;
+    size_t room;
+
+    while (1) {
+        room = at_engine_rx_reserve(&engine, &buf);
+        if (room == 0) {
+            // Ring full: consume complete lines first
+            at_engine_poll(&engine, esp_timer_get_time());
+            room = at_engine_rx_reserve(&engine, &buf);
+            if (room == 0) break;
+        }
+        int n = uart_read_bytes(MODEM_UART_PORT, buf, room, 0);
+        if (n <= 0) break;
+        at_engine_rx_commit(&engine, (size_t)n);
+    }
+}
+
+static void modem_task(void *arg) {
+    uart_event_t event;
+    bool pm_held = false;
+
+    while (1) {
+        if (xQueueReceive(uart_queue, &event, pdMS_TO_TICKS(MODEM_POLL_MS)) == pdTRUE) {
+            switch (event.type) {
+                case UART_DATA:
+                    read_uart();
+                    break;
+
+                case UART_FIFO_OVF:
+                case UART_BUFFER_FULL:
+                    uart_overflows++;
+                    uart_flush_input(MODEM_UART_PORT);
+                    xQueueReset(uart_queue);
+                    ESP_LOGW(TAG, "UART overflow, input flushed");
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        drain_messages();
+        at_engine_poll(&engine, esp_timer_get_time());
+
+        // APB lock only while a command is queued or in flight
+        bool busy = at_engine_busy(&engine);
+        if (busy != pm_held) {
+            if (busy) syspm_acquire(SYSPM_LOCK_MODEM);
+            else syspm_release(SYSPM_LOCK_MODEM);
+            pm_held = busy;
+        }
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t modem_init(void) {
+    if (is_initialized) return ESP_OK;
+    esp_err_t err;
+
+    at_engine_init(&engine, uart_write, NULL);
+
+    uart_config_t uart_conf = {
+        .baud_rate = MODEM_BAUD,
+        .data_bits = UART_DATA_8_BITS,
+        .parity = UART_PARITY_DISABLE,
+        .stop_bits = UART_STOP_BITS_1,
+        .flow_ctrl = UART_HW_FLOWCTRL_DISABLE,
+        .source_clk = UART_SCLK_XTAL,        // Baud rate independent of DFS
+    };
+    err = uart_driver_install(MODEM_UART_PORT, MODEM_UART_RX_BUF, MODEM_UART_TX_BUF,
+                              MODEM_EVENT_QUEUE_LEN, &uart_queue, 0);
+    if (err != ESP_OK) return err;
+    err = uart_param_config(MODEM_UART_PORT, &uart_conf);
+    if (err != ESP_OK) return err;
+    err = uart_set_pin(MODEM_UART_PORT, PIN_MODEM_TX, PIN_MODEM_RX, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    if (err != ESP_OK) return err;
+
+    // DTR low = awake (CSCLK=0 ignores it anyway)
+    gpio_config_t conf_dtr = {
+        .pin_bit_mask = (1ULL << PIN_MODEM_DTR),
+        .mode = GPIO_MODE_OUTPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    err = gpio_config(&conf_dtr);
+    if (err != ESP_OK) return err;
+    gpio_set_level(PIN_MODEM_DTR, 0);
+
+    uart_set_rx_full_threshold(MODEM_UART_PORT, MODEM_RX_FULL_THRESH);
+    uart_set_rx_timeout(MODEM_UART_PORT, MODEM_RX_TIMEOUT_SYMBOLS);
+
+    msg_queue = mem_queue_create(MEM_SUB_MODEM, MODEM_MSG_QUEUE_LEN, sizeof(modem_msg_t));
+    pub_pool = mem_pool_create(MEM_SUB_MODEM, "mqtt_pub", sizeof(pub_slot_t), MODEM_MQTT_PUB_SLOTS);
+    if (msg_queue == NULL || pub_pool == NULL) return ESP_ERR_NO_MEM;
+
+    // MQTT URCs
+    at_engine_register_urc(&engine, "+CMQTTCONNLOST:", on_conn_lost, NULL);
+    at_engine_register_urc(&engine, "+CMQTTRXSTART:", on_rx_start, NULL);
+    at_engine_register_urc(&engine, "+CMQTTRXTOPIC:", on_rx_topic, NULL);
+    at_engine_register_urc(&engine, "+CMQTTRXPAYLOAD:", on_rx_payload, NULL);
+    at_engine_register_urc(&engine, "+CMQTTRXEND:", on_rx_end, NULL);
+
+    // Echo off, numeric error codes
+    submit_simple("ATE0", NULL, 0);
+    submit_simple("AT+CMEE=1", NULL, 0);
+
+    if (mem_task_create(MEM_SUB_MODEM, modem_task, "modem_task", MODEM_TASK_STACK, NULL,
+                        MODEM_TASK_PRIORITY, MODEM_TASK_CORE) == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    is_initialized = true;
+    ESP_LOGI(TAG, "Modem UART%d @ %d baud", MODEM_UART_PORT, MODEM_BAUD);
+    return ESP_OK;
+}
+
+bool modem_submit(const at_cmd_t *cmd) {
+    if (cmd == NULL) return false;
+    modem_msg_t msg = { .type = MSG_CMD, .cmd = *cmd };
+    return post_msg(&msg);
+}
+
+bool modem_http_get_range(const char *url, uint32_t offset, uint32_t len,
+                          modem_http_data_cb_t on_data, modem_http_done_cb_t on_done, void *ctx) {
+    if (url == NULL || len == 0 || strlen(url) >= sizeof(http.url)) return false;
+
+    portENTER_CRITICAL(&modem_mux);
+    bool busy = http.busy;
+    http.busy = true;
+    portEXIT_CRITICAL(&modem_mux);
+    if (busy) return false;
+
+    // Request fields are read by the modem task once MSG_HTTP is received
+    strcpy(http.url, url);
+    http.offset = offset;
+    http.len = len;
+    http.on_data = on_data;
+    http.on_done = on_done;
+    http.ctx = ctx;
+    http.status = -1;
+    http.body_len = 0;
+    http.read_pos = 0;
+    http.read_len = 0;
+    http.delivered = 0;
+
+    modem_msg_t msg = { .type = MSG_HTTP };
+    if (!post_msg(&msg)) {
+        http.busy = false;
+        return false;
+    }
+    http_requests++;
+    return true;
+}
+
+bool modem_set_low_power(bool enable) {
+    modem_msg_t sclk = { .type = MSG_CMD };
+    modem_msg_t edrx = { .type = MSG_CMD };
+
+    snprintf(sclk.cmd.cmd, sizeof(sclk.cmd.cmd), "AT+CSCLK=%d", enable ? 1 : 0);
+    if (enable) {
+        snprintf(edrx.cmd.cmd, sizeof(edrx.cmd.cmd), "AT+CEDRXS=1,4,\"%s\"", MODEM_EDRX_CYCLE);
+    } else {
+        snprintf(edrx.cmd.cmd, sizeof(edrx.cmd.cmd), "AT+CEDRXS=0");
+    }
+    // eDRX is network dependent: an ERROR only means the default DRX stays
+    return post_msg(&edrx) && post_msg(&sclk);
+}
+
+void modem_sleep(bool sleep) {
+    gpio_set_level(PIN_MODEM_DTR, sleep ? 1 : 0);
+    if (!sleep) vTaskDelay(pdMS_TO_TICKS(MODEM_DTR_WAKE_MS));
+}
+
+bool modem_register_urc(const char *prefix, at_line_cb_t cb, void *ctx) {
+    if (prefix == NULL || cb == NULL) return false;
+    modem_msg_t msg = { .type = MSG_URC, .urc = { .prefix = prefix, .cb = cb, .ctx = ctx } };
+    return post_msg(&msg);
+}
+
+void modem_set_event_callback(modem_event_cb_t cb, void *ctx) {
+    portENTER_CRITICAL(&modem_mux);
+    event_ctx = ctx;
+    event_cb = cb;
+    portEXIT_CRITICAL(&modem_mux);
+}
+
+bool modem_mqtt_connect(const char *uri, const char *id, bool use_tls) {
+    if (uri == NULL || id == NULL) return false;
+    if (strlen(uri) >= sizeof(broker_uri) || strlen(id) >= sizeof(client_id)) return false;
+
+    // Connection parameters are read by the modem task when the commands are built
+    portENTER_CRITICAL(&modem_mux);
+    strcpy(broker_uri, uri);
+    strcpy(client_id, id);
+    broker_tls = use_tls;
+    portEXIT_CRITICAL(&modem_mux);
+
+    modem_msg_t msg = { .type = MSG_CONNECT };
+    return post_msg(&msg);
+}
+
+bool modem_mqtt_publish(const char *topic, const uint8_t *payload, size_t len, uint8_t qos) {
+    return modem_mqtt_publish_cb(topic, payload, len, qos, NULL, NULL);
+}
+
+bool modem_mqtt_publish_cb(const char *topic, const uint8_t *payload, size_t len, uint8_t qos,
+                           modem_pub_done_cb_t done, void *ctx) {
+    if (!mqtt_connected || topic == NULL || len > MODEM_MQTT_PAYLOAD_MAX || qos > 2) return false;
+    if (strlen(topic) >= MODEM_MQTT_TOPIC_MAX) return false;
+
+    pub_slot_t *s = mem_pool_alloc(pub_pool);
+    if (s == NULL) return false;
+
+    strcpy(s->topic, topic);
+    if (len > 0) memcpy(s->payload, payload, len);
+    s->len = (uint16_t)len;
+    s->qos = qos;
+    s->done = done;
+    s->done_ctx = ctx;
+
+    modem_msg_t msg = { .type = MSG_PUB, .pub = s };
+    if (!post_msg(&msg)) {
+        mem_pool_free(pub_pool, s);
+        return false;
+    }
+    return true;
+}
+
+bool modem_mqtt_subscribe(const char *topic, uint8_t qos) {
+    if (topic == NULL || strlen(topic) >= MODEM_MQTT_TOPIC_MAX || qos > 2) return false;
+
+    portENTER_CRITICAL(&modem_mux);
+    if (sub_count >= MODEM_MQTT_MAX_SUBS) {
+        portEXIT_CRITICAL(&modem_mux);
+        return false;
+    }
+    uint8_t idx = sub_count;
+    strcpy(subs[idx].topic, topic);
+    subs[idx].qos = qos;
+    sub_count++;
+    portEXIT_CRITICAL(&modem_mux);
+
+    // Applied now if connected, otherwise on the next CONNECT
+    modem_msg_t msg = { .type = MSG_SUB, .slot = idx };
+    post_msg(&msg);
+    return true;
+}
+
+void modem_mqtt_set_rx_callback(modem_mqtt_rx_cb_t cb, void *ctx) {
+    portENTER_CRITICAL(&modem_mux);
+    rx_ctx = ctx;
+    rx_cb = cb;
+    portEXIT_CRITICAL(&modem_mux);
+}
+
+int64_t modem_mqtt_rx_time_us(void) {
+    return rx_start_us;
+}
+
+bool modem_mqtt_is_connected(void) {
+    return mqtt_connected;
+}
+
+void modem_get_stats(modem_stats_t *out) {
+    if (out == NULL) return;
+    out->at = engine.stats;
+    out->uart_overflows = uart_overflows;
+    out->msg_queue_full = msg_queue_full;
+    out->mqtt_pub_ok = pub_ok;
+    out->mqtt_pub_failed = pub_failed;
+    out->mqtt_rx = mqtt_rx_count;
+    out->mqtt_rx_truncated = mqtt_rx_truncated;
+    out->http_requests = http_requests;
+    out->http_failed = http_failed;
+    out->http_bytes = http_bytes;
+}
+
+void modem_log_stats(void) {
+    modem_stats_t s;
+    modem_get_stats(&s);
+
+    uint32_t done = s.at.cmds_ok + s.at.cmds_error + s.at.cmds_timeout;
+    uint32_t avg_us = done ? (uint32_t)(s.at.latency_total_us / done) : 0;
+
+    ESP_LOGI(TAG, "AT: ok=%lu err=%lu timeout=%lu qfull=%lu | lat avg=%lu max=%lu us",
+             (unsigned long)s.at.cmds_ok, (unsigned long)s.at.cmds_error,
+             (unsigned long)s.at.cmds_timeout, (unsigned long)s.at.queue_full,
+             (unsigned long)avg_us, (unsigned long)s.at.latency_max_us);
+    ESP_LOGI(TAG, "RX: %lu bytes, %lu lines, %lu URCs, %lu unhandled, ring ovf=%lu, uart ovf=%lu",
+             (unsigned long)s.at.rx_bytes, (unsigned long)s.at.lines, (unsigned long)s.at.urcs,
+             (unsigned long)s.at.unhandled, (unsigned long)s.at.rx_overflows,
+             (unsigned long)s.uart_overflows);
+    ESP_LOGI(TAG, "MQTT: %s pub ok=%lu fail=%lu rx=%lu (trunc %lu) backlog_full=%lu",
+             mqtt_connected ? "up" : "down",
+             (unsigned long)s.mqtt_pub_ok, (unsigned long)s.mqtt_pub_failed,
+             (unsigned long)s.mqtt_rx, (unsigned long)s.mqtt_rx_truncated,
+             (unsigned long)s.msg_queue_full);
+    if (s.http_requests > 0) {
+        ESP_LOGI(TAG, "HTTP: %lu requests, %lu failed, %lu bytes",
+                 (unsigned long)s.http_requests, (unsigned long)s.http_failed, (unsigned long)s.http_bytes);
+    }
+}
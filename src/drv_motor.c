@@ -3,15 +3,21 @@
  * @brief BLDC Motor & ESC Driver Implementation
  */
 
+#include <stddef.h>
 #include "drv_motor.h"
 #include "driver/ledc.h"
 #include "esp_log.h"
+#include "sys_dlog.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "app_config.h" 
 
 static const char *TAG = "DRV_MOTOR";
 
+// Last commanded values (read by EMI compensation / telemetry)
+static volatile uint16_t last_left_raw = MOTOR_IDLE_RAW;
+static volatile uint16_t last_right_raw = MOTOR_IDLE_RAW;
+
 // --- HELPER FUNCTIONS ---
 
 /**
@@ -44,7 +50,7 @@ void motor_init(void) {
         .timer_num        = PWM_MOTOR_TIMER,
         .duty_resolution  = PWM_MOTOR_RESOLUTION,
         .freq_hz          = PWM_MOTOR_FREQ,
-        .clk_cfg          = LEDC_AUTO_CLK,
+        .clk_cfg          = LEDC_USE_XTAL_CLK,  // Pulse width independent of DFS
         .deconfigure      = false
     };
     ESP_ERROR_CHECK(ledc_timer_config(&timer_conf));
@@ -93,9 +99,25 @@ void motor_set_speed(uint16_t left_raw, uint16_t right_raw) {
 
     ledc_set_duty(PWM_MOTOR_MODE, LEDC_CHANNEL_1, duty_right);
     ledc_update_duty(PWM_MOTOR_MODE, LEDC_CHANNEL_1);
+
+    last_left_raw = (left_raw > MOTOR_SPEED_MAX_RAW) ? MOTOR_SPEED_MAX_RAW : left_raw;
+    last_right_raw = (right_raw > MOTOR_SPEED_MAX_RAW) ? MOTOR_SPEED_MAX_RAW : right_raw;
+}
+
+void motor_get_speed(uint16_t *left_raw, uint16_t *right_raw) {
+    if (left_raw != NULL) *left_raw = last_left_raw;
+    if (right_raw != NULL) *right_raw = last_right_raw;
 }
 
 void motor_stop_all(void) {
     motor_set_speed(MOTOR_IDLE_RAW, MOTOR_IDLE_RAW);
-    ESP_LOGW(TAG, "MOTORS EMERGENCY STOP!");
+    DLOGW(TAG, "MOTORS EMERGENCY STOP!");
+}
+
+void motor_disarm(void) {
+    ledc_stop(PWM_MOTOR_MODE, LEDC_CHANNEL_0, 0);
+    ledc_stop(PWM_MOTOR_MODE, LEDC_CHANNEL_1, 0);
+    last_left_raw = MOTOR_IDLE_RAW;
+    last_right_raw = MOTOR_IDLE_RAW;
+    ESP_LOGI(TAG, "Motors disarmed (PWM off)");
 }
\ No newline at end of file
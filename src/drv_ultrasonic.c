@@ -4,7 +4,6 @@
  */
 #include <stdint.h>
 #include <stdlib.h>
-#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "rom/ets_sys.h"
 #include "esp_log.h"
@@ -12,10 +11,58 @@
 #include "freertos/task.h"
 #include "app_config.h"
 #include "drv_ultrasonic.h"
+#include "sys_time.h"
+#include "sys_pm.h"
+#include "sys_param.h"
+#include "sys_health.h"
 
 static const char *TAG = "DRV_US";
 static bool is_initialized = false;
 
+static uint16_t measure_echo(gpio_num_t trig_pin, gpio_num_t echo_pin, int64_t *sample_time_us) {
+    // Generate trigger pulse 
+    gpio_set_level(trig_pin, 0);
+    ets_delay_us(2);
+    gpio_set_level(trig_pin, 1);
+    ets_delay_us(20); 
+    gpio_set_level(trig_pin, 0);
+
+    // Wait for echo pin to go HIGH
+    int64_t wait_start = systime_now_us();
+    while (gpio_get_level(echo_pin) == 0) {
+        if ((systime_now_us() - wait_start) > US_ECHO_WAIT_TIMEOUT_US) {
+            return US_ERROR_CODE; 
+        }
+    }
+
+    // Measure echo pulse width 
+    int64_t time_start = systime_now_us();
+    while (gpio_get_level(echo_pin) == 1) {
+        if ((systime_now_us() - time_start) > US_PULSE_TIMEOUT_US) {
+            return US_ERROR_CODE; 
+        }
+    }
+    int64_t time_end = systime_now_us();
+
+    // Calculate distance
+    uint32_t time = (uint32_t)(time_end - time_start);
+    uint32_t raw_distance = (time * 10) / 58;
+
+    // Sound hit the target halfway through the echo pulse
+    if (sample_time_us != NULL) *sample_time_us = time_start + (int64_t)(time / 2);
+
+    return (uint16_t)raw_distance;
+}
+
+static health_channel_t health_channel_of(gpio_num_t trig_pin) {
+    switch (trig_pin) {
+        case FRONT_ULTRASONIC_TRIG: return HEALTH_CH_US_FRONT;
+        case LEFT_ULTRASONIC_TRIG:  return HEALTH_CH_US_LEFT;
+        case RIGHT_ULTRASONIC_TRIG: return HEALTH_CH_US_RIGHT;
+        default:                    return HEALTH_CH_COUNT;     // Not monitored
+    }
+}
+
 esp_err_t ultrasonic_init(void) {
     is_initialized = false;
 
@@ -56,37 +103,25 @@ esp_err_t ultrasonic_init(void) {
 }
 
 uint16_t ultrasonic_measure(gpio_num_t trig_pin, gpio_num_t echo_pin) {
-    if (!is_initialized) return US_ERROR_CODE;
-
-    // Generate trigger pulse 
-    gpio_set_level(trig_pin, 0);
-    ets_delay_us(2);
-    gpio_set_level(trig_pin, 1);
-    ets_delay_us(20); 
-    gpio_set_level(trig_pin, 0);
+    return ultrasonic_measure_stamped(trig_pin, echo_pin, NULL);
+}
 
-    // Wait for echo pin to go HIGH
-    int64_t wait_start = esp_timer_get_time();
-    while (gpio_get_level(echo_pin) == 0) {
-        if ((esp_timer_get_time() - wait_start) > US_ECHO_WAIT_TIMEOUT_US) {
-            return US_ERROR_CODE; 
-        }
-    }
+uint16_t ultrasonic_measure_stamped(gpio_num_t trig_pin, gpio_num_t echo_pin, int64_t *sample_time_us) {
+    if (!is_initialized) return US_ERROR_CODE;
 
-    // Measure echo pulse width 
-    int64_t time_start = esp_timer_get_time();
-    while (gpio_get_level(echo_pin) == 1) {
-        if ((esp_timer_get_time() - time_start) > US_PULSE_TIMEOUT_US) {
-            return US_ERROR_CODE; 
-        }
-    }
-    int64_t time_end = esp_timer_get_time();
+    // Busy-wait polling: keep the CPU at full clock for the whole echo
+    int64_t t_us = 0;
+    syspm_acquire(SYSPM_LOCK_ULTRASONIC);
+    uint16_t distance = measure_echo(trig_pin, echo_pin, &t_us);
+    syspm_release(SYSPM_LOCK_ULTRASONIC);
 
-    // Calculate distance
-    uint32_t time = (uint32_t)(time_end - time_start);
-    uint32_t raw_distance = (time * 10) / 58;
+    // Raw reading, before the filter hides timeouts and spikes
+    health_channel_t ch = health_channel_of(trig_pin);
+    if (distance == US_ERROR_CODE) health_dropout(ch);
+    else health_sample(ch, (float)distance, t_us);
 
-    return (uint16_t)raw_distance;
+    if (sample_time_us != NULL && distance != US_ERROR_CODE) *sample_time_us = t_us;
+    return distance;
 }
 
 uint16_t ultrasonic_filter_apply(uint16_t raw_distance, ultrasonic_filter_t *filter) {
@@ -125,7 +160,7 @@ uint16_t ultrasonic_filter_apply(uint16_t raw_distance, ultrasonic_filter_t *fil
     // Check for "Jump Closer"
     // New object detected or distance decreased significantly
     // Update immediately for safety
-    if (diff < -FILTER_SPIKE_THRESHOLD_MM){
+    if (diff < -sysparam.us_spike_mm){
         filter->last_valid_value = raw_distance;
         filter->error_count = 0;
         return filter->last_valid_value;
@@ -134,11 +169,11 @@ uint16_t ultrasonic_filter_apply(uint16_t raw_distance, ultrasonic_filter_t *fil
     // Check for "Jump Further" 
     // Distance increased significantly
     // Verify multiple times
-    if (diff > FILTER_SPIKE_THRESHOLD_MM) {
+    if (diff > sysparam.us_spike_mm) {
         filter->error_count++;
         
         // Only accept the new "far" value if it persists
-        if (filter->error_count >= FILTER_SPIKE_TOLERANCE){
+        if (filter->error_count >= sysparam.us_spike_tol){
             filter->last_valid_value = raw_distance;
             filter->error_count = 0;
             return filter->last_valid_value;
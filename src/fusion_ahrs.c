@@ -0,0 +1,481 @@
+/**
+ * @file fusion_ahrs.c
+ * @brief Madgwick / Mahony AHRS Implementation
+ * @details
+ * Based on the reference implementations by S. Madgwick and R. Mahony,
+ * restructured for the ESP32-S3 FPU:
+ * - 1/sqrt(x) via bit-trick seed + Newton refinement (mul/madd only).
+ * - No divides in the update path.
+ * - Hot functions placed in IRAM to avoid flash cache misses at 500Hz+.
+ */
+
+#include "fusion_ahrs.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#define AHRS_HOT            IRAM_ATTR
+#define AHRS_CYCLES()       ((uint32_t)esp_cpu_get_cycle_count())
+#else
+#define AHRS_HOT
+#define AHRS_CYCLES()       0U
+#endif
+
+// PRIVATE TYPES
+
+/**
+ * @brief Working copy of the filter state
+ * @note Copied to a local variable so the compiler keeps it in FPU registers
+ * for the whole batch instead of reloading through the object pointer.
+ */
+typedef struct {
+    float q0, q1, q2, q3;
+    float ifb_x, ifb_y, ifb_z;
+} ahrs_state_t;
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief Fast inverse square root
+ * @note Improved magic constant (J. Kadlec) + 1 extra Newton step.
+ * Relative error < 1e-6, cheaper than sqrtf() + divide on the S3.
+ */
+static inline float inv_sqrt(float x) {
+    union {
+        float f;
+        uint32_t i;
+    } conv = { .f = x };
+
+    conv.i = 0x5F1FFFF9U - (conv.i >> 1);
+    conv.f *= 0.703952253f * (2.38924456f - x * conv.f * conv.f);
+    conv.f *= 1.5f - 0.5f * x * conv.f * conv.f;
+    return conv.f;
+}
+
+static inline void normalize_quat(ahrs_state_t *st) {
+    float recip = inv_sqrt(st->q0 * st->q0 + st->q1 * st->q1 + st->q2 * st->q2 + st->q3 * st->q3);
+    st->q0 *= recip;
+    st->q1 *= recip;
+    st->q2 *= recip;
+    st->q3 *= recip;
+}
+
+/**
+ * @brief Madgwick 6-DOF step (Gyro + Accel)
+ */
+static inline void madgwick_imu(ahrs_state_t *st, float beta, float gx, float gy, float gz,
+                                float ax, float ay, float az, float dt) {
+    float q0 = st->q0, q1 = st->q1, q2 = st->q2, q3 = st->q3;
+
+    // Rate of change of quaternion from gyroscope
+    float qdot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qdot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qdot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qdot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    // Accel feedback only if measurement is valid (avoid NaN)
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+        float recip = inv_sqrt(ax * ax + ay * ay + az * az);
+        ax *= recip;
+        ay *= recip;
+        az *= recip;
+
+        float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+        float _4q0 = 4.0f * q0, _4q1 = 4.0f * q1, _4q2 = 4.0f * q2;
+        float _8q1 = 8.0f * q1, _8q2 = 8.0f * q2;
+        float q0q0 = q0 * q0, q1q1 = q1 * q1, q2q2 = q2 * q2, q3q3 = q3 * q3;
+
+        // Gradient descent corrective step
+        float s0 = _4q0 * q2q2 + _2q2 * ax + _4q0 * q1q1 - _2q1 * ay;
+        float s1 = _4q1 * q3q3 - _2q3 * ax + 4.0f * q0q0 * q1 - _2q0 * ay - _4q1
+                   + _8q1 * q1q1 + _8q1 * q2q2 + _4q1 * az;
+        float s2 = 4.0f * q0q0 * q2 + _2q0 * ax + _4q2 * q3q3 - _2q3 * ay - _4q2
+                   + _8q2 * q1q1 + _8q2 * q2q2 + _4q2 * az;
+        float s3 = 4.0f * q1q1 * q3 - _2q1 * ax + 4.0f * q2q2 * q3 - _2q2 * ay;
+
+        float s_norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+        if (s_norm > 0.0f) {
+            recip = beta * inv_sqrt(s_norm);
+            qdot0 -= recip * s0;
+            qdot1 -= recip * s1;
+            qdot2 -= recip * s2;
+            qdot3 -= recip * s3;
+        }
+    }
+
+    // Integrate
+    st->q0 = q0 + qdot0 * dt;
+    st->q1 = q1 + qdot1 * dt;
+    st->q2 = q2 + qdot2 * dt;
+    st->q3 = q3 + qdot3 * dt;
+    normalize_quat(st);
+}
+
+/**
+ * @brief Madgwick 9-DOF step (Gyro + Accel + Mag)
+ */
+static inline void madgwick_marg(ahrs_state_t *st, float beta, const ahrs_sample_t *s, float dt) {
+    float q0 = st->q0, q1 = st->q1, q2 = st->q2, q3 = st->q3;
+    float gx = s->gx, gy = s->gy, gz = s->gz;
+    float ax = s->ax, ay = s->ay, az = s->az;
+    float mx = s->mx, my = s->my, mz = s->mz;
+
+    // Invalid accel -> no usable reference at all, integrate gyro only
+    if ((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f)) {
+        madgwick_imu(st, 0.0f, gx, gy, gz, 0.0f, 0.0f, 0.0f, dt);
+        return;
+    }
+
+    float qdot0 = 0.5f * (-q1 * gx - q2 * gy - q3 * gz);
+    float qdot1 = 0.5f * (q0 * gx + q2 * gz - q3 * gy);
+    float qdot2 = 0.5f * (q0 * gy - q1 * gz + q3 * gx);
+    float qdot3 = 0.5f * (q0 * gz + q1 * gy - q2 * gx);
+
+    float recip = inv_sqrt(ax * ax + ay * ay + az * az);
+    ax *= recip;
+    ay *= recip;
+    az *= recip;
+
+    recip = inv_sqrt(mx * mx + my * my + mz * mz);
+    mx *= recip;
+    my *= recip;
+    mz *= recip;
+
+    // Auxiliary variables to avoid repeated arithmetic
+    float _2q0mx = 2.0f * q0 * mx, _2q0my = 2.0f * q0 * my, _2q0mz = 2.0f * q0 * mz;
+    float _2q1mx = 2.0f * q1 * mx;
+    float _2q0 = 2.0f * q0, _2q1 = 2.0f * q1, _2q2 = 2.0f * q2, _2q3 = 2.0f * q3;
+    float _2q0q2 = 2.0f * q0 * q2, _2q2q3 = 2.0f * q2 * q3;
+    float q0q0 = q0 * q0, q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+    float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+    float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+    // Reference direction of Earth's magnetic field
+    float hx = mx * q0q0 - _2q0my * q3 + _2q0mz * q2 + mx * q1q1 + _2q1 * my * q2
+               + _2q1 * mz * q3 - mx * q2q2 - mx * q3q3;
+    float hy = _2q0mx * q3 + my * q0q0 - _2q0mz * q1 + _2q1mx * q2 - my * q1q1
+               + my * q2q2 + _2q2 * mz * q3 - my * q3q3;
+    float h_sq = hx * hx + hy * hy;
+    float _2bx = h_sq * inv_sqrt(h_sq);
+    float _2bz = -_2q0mx * q2 + _2q0my * q1 + mz * q0q0 + _2q1mx * q3 - mz * q1q1
+                 + _2q2 * my * q3 - mz * q2q2 + mz * q3q3;
+    float _4bx = 2.0f * _2bx, _4bz = 2.0f * _2bz;
+
+    // Objective function terms (shared by all 4 gradient components)
+    float fa_x = 2.0f * q1q3 - _2q0q2 - ax;
+    float fa_y = 2.0f * q0q1 + _2q2q3 - ay;
+    float fa_z = 1.0f - 2.0f * q1q1 - 2.0f * q2q2 - az;
+    float fm_x = _2bx * (0.5f - q2q2 - q3q3) + _2bz * (q1q3 - q0q2) - mx;
+    float fm_y = _2bx * (q1q2 - q0q3) + _2bz * (q0q1 + q2q3) - my;
+    float fm_z = _2bx * (q0q2 + q1q3) + _2bz * (0.5f - q1q1 - q2q2) - mz;
+
+    // Gradient descent corrective step
+    float s0 = -_2q2 * fa_x + _2q1 * fa_y - _2bz * q2 * fm_x
+               + (-_2bx * q3 + _2bz * q1) * fm_y + _2bx * q2 * fm_z;
+    float s1 = _2q3 * fa_x + _2q0 * fa_y - 4.0f * q1 * fa_z + _2bz * q3 * fm_x
+               + (_2bx * q2 + _2bz * q0) * fm_y + (_2bx * q3 - _4bz * q1) * fm_z;
+    float s2 = -_2q0 * fa_x + _2q3 * fa_y - 4.0f * q2 * fa_z + (-_4bx * q2 - _2bz * q0) * fm_x
+               + (_2bx * q1 + _2bz * q3) * fm_y + (_2bx * q0 - _4bz * q2) * fm_z;
+    float s3 = _2q1 * fa_x + _2q2 * fa_y + (-_4bx * q3 + _2bz * q1) * fm_x
+               + (-_2bx * q0 + _2bz * q2) * fm_y + _2bx * q1 * fm_z;
+
+    float s_norm = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+    if (s_norm > 0.0f) {
+        recip = beta * inv_sqrt(s_norm);
+        qdot0 -= recip * s0;
+        qdot1 -= recip * s1;
+        qdot2 -= recip * s2;
+        qdot3 -= recip * s3;
+    }
+
+    st->q0 = q0 + qdot0 * dt;
+    st->q1 = q1 + qdot1 * dt;
+    st->q2 = q2 + qdot2 * dt;
+    st->q3 = q3 + qdot3 * dt;
+    normalize_quat(st);
+}
+
+/**
+ * @brief Mahony step (6-DOF or 9-DOF depending on mag availability)
+ */
+static inline void mahony_update(ahrs_state_t *st, float two_kp, float two_ki,
+                                 const ahrs_sample_t *s, float dt) {
+    float q0 = st->q0, q1 = st->q1, q2 = st->q2, q3 = st->q3;
+    float gx = s->gx, gy = s->gy, gz = s->gz;
+    float ax = s->ax, ay = s->ay, az = s->az;
+    float mx = s->mx, my = s->my, mz = s->mz;
+
+    if (!((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f))) {
+        float recip = inv_sqrt(ax * ax + ay * ay + az * az);
+        ax *= recip;
+        ay *= recip;
+        az *= recip;
+
+        float q0q1 = q0 * q1, q0q2 = q0 * q2, q0q3 = q0 * q3;
+        float q1q1 = q1 * q1, q1q2 = q1 * q2, q1q3 = q1 * q3;
+        float q2q2 = q2 * q2, q2q3 = q2 * q3, q3q3 = q3 * q3;
+
+        // Estimated direction of gravity (half)
+        float halfvx = q1q3 - q0q2;
+        float halfvy = q0q1 + q2q3;
+        float halfvz = q0 * q0 - 0.5f + q3q3;
+
+        // Error is cross product between estimated and measured gravity
+        float halfex = ay * halfvz - az * halfvy;
+        float halfey = az * halfvx - ax * halfvz;
+        float halfez = ax * halfvy - ay * halfvx;
+
+        if (!((mx == 0.0f) && (my == 0.0f) && (mz == 0.0f))) {
+            recip = inv_sqrt(mx * mx + my * my + mz * mz);
+            mx *= recip;
+            my *= recip;
+            mz *= recip;
+
+            // Reference direction of Earth's magnetic field
+            float hx = 2.0f * (mx * (0.5f - q2q2 - q3q3) + my * (q1q2 - q0q3) + mz * (q1q3 + q0q2));
+            float hy = 2.0f * (mx * (q1q2 + q0q3) + my * (0.5f - q1q1 - q3q3) + mz * (q2q3 - q0q1));
+            float h_sq = hx * hx + hy * hy;
+            float bx = h_sq * inv_sqrt(h_sq);
+            float bz = 2.0f * (mx * (q1q3 - q0q2) + my * (q2q3 + q0q1) + mz * (0.5f - q1q1 - q2q2));
+
+            // Estimated direction of magnetic field (half)
+            float halfwx = bx * (0.5f - q2q2 - q3q3) + bz * (q1q3 - q0q2);
+            float halfwy = bx * (q1q2 - q0q3) + bz * (q0q1 + q2q3);
+            float halfwz = bx * (q0q2 + q1q3) + bz * (0.5f - q1q1 - q2q2);
+
+            halfex += my * halfwz - mz * halfwy;
+            halfey += mz * halfwx - mx * halfwz;
+            halfez += mx * halfwy - my * halfwx;
+        }
+
+        // Integral feedback (gyro bias)
+        if (two_ki > 0.0f) {
+            st->ifb_x += two_ki * halfex * dt;
+            st->ifb_y += two_ki * halfey * dt;
+            st->ifb_z += two_ki * halfez * dt;
+            gx += st->ifb_x;
+            gy += st->ifb_y;
+            gz += st->ifb_z;
+        } else {
+            st->ifb_x = 0.0f;
+            st->ifb_y = 0.0f;
+            st->ifb_z = 0.0f;
+        }
+
+        // Proportional feedback
+        gx += two_kp * halfex;
+        gy += two_kp * halfey;
+        gz += two_kp * halfez;
+    }
+
+    // Integrate rate of change of quaternion
+    float half_dt = 0.5f * dt;
+    gx *= half_dt;
+    gy *= half_dt;
+    gz *= half_dt;
+    st->q0 = q0 + (-q1 * gx - q2 * gy - q3 * gz);
+    st->q1 = q1 + (q0 * gx + q2 * gz - q3 * gy);
+    st->q2 = q2 + (q0 * gy - q1 * gz + q3 * gx);
+    st->q3 = q3 + (q0 * gz + q1 * gy - q2 * gx);
+    normalize_quat(st);
+}
+
+static inline void step(const ahrs_t *ahrs, ahrs_state_t *st, const ahrs_sample_t *s, float dt) {
+    if (ahrs->algo == AHRS_ALGO_MAHONY) {
+        mahony_update(st, ahrs->two_kp, ahrs->two_ki, s, dt);
+    } else if ((s->mx == 0.0f) && (s->my == 0.0f) && (s->mz == 0.0f)) {
+        madgwick_imu(st, ahrs->beta, s->gx, s->gy, s->gz, s->ax, s->ay, s->az, dt);
+    } else {
+        madgwick_marg(st, ahrs->beta, s, dt);
+    }
+}
+
+static inline void load_state(const ahrs_t *ahrs, ahrs_state_t *st) {
+    st->q0 = ahrs->q0;
+    st->q1 = ahrs->q1;
+    st->q2 = ahrs->q2;
+    st->q3 = ahrs->q3;
+    st->ifb_x = ahrs->integral_fb_x;
+    st->ifb_y = ahrs->integral_fb_y;
+    st->ifb_z = ahrs->integral_fb_z;
+}
+
+static inline void store_state(ahrs_t *ahrs, const ahrs_state_t *st) {
+    ahrs->q0 = st->q0;
+    ahrs->q1 = st->q1;
+    ahrs->q2 = st->q2;
+    ahrs->q3 = st->q3;
+    ahrs->integral_fb_x = st->ifb_x;
+    ahrs->integral_fb_y = st->ifb_y;
+    ahrs->integral_fb_z = st->ifb_z;
+}
+
+static inline void record_cost(ahrs_stats_t *stats, uint32_t cycles, uint32_t count) {
+    uint32_t per_sample = cycles / count;
+    stats->update_count += count;
+    stats->last_cycles = per_sample;
+    stats->total_cycles += cycles;
+    if (per_sample > stats->max_cycles) {
+        stats->max_cycles = per_sample;
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void ahrs_init(ahrs_t *ahrs, ahrs_algo_t algo) {
+    ahrs->algo = algo;
+    ahrs->beta = AHRS_MADGWICK_BETA;
+    ahrs->two_kp = 2.0f * AHRS_MAHONY_KP;
+    ahrs->two_ki = 2.0f * AHRS_MAHONY_KI;
+    ahrs_reset(ahrs);
+}
+
+void ahrs_reset(ahrs_t *ahrs) {
+    ahrs->q0 = 1.0f;
+    ahrs->q1 = 0.0f;
+    ahrs->q2 = 0.0f;
+    ahrs->q3 = 0.0f;
+    ahrs->integral_fb_x = 0.0f;
+    ahrs->integral_fb_y = 0.0f;
+    ahrs->integral_fb_z = 0.0f;
+    memset(&ahrs->stats, 0, sizeof(ahrs->stats));
+}
+
+void ahrs_align(ahrs_t *ahrs, float ax, float ay, float az,
+                float mx, float my, float mz) {
+    if ((ax == 0.0f) && (ay == 0.0f) && (az == 0.0f)) return;
+
+    // Earth "Up" axis expressed in body frame
+    float recip = inv_sqrt(ax * ax + ay * ay + az * az);
+    float ux = ax * recip, uy = ay * recip, uz = az * recip;
+
+    // Earth "North" axis: mag projected onto horizontal plane.
+    // Without mag, use body X projected (heading = 0).
+    float nx = 1.0f, ny = 0.0f, nz = 0.0f;
+    if (!((mx == 0.0f) && (my == 0.0f) && (mz == 0.0f))) {
+        nx = mx;
+        ny = my;
+        nz = mz;
+    }
+    float dot = nx * ux + ny * uy + nz * uz;
+    nx -= dot * ux;
+    ny -= dot * uy;
+    nz -= dot * uz;
+    float n_sq = nx * nx + ny * ny + nz * nz;
+    if (n_sq <= 0.0f) return;
+    recip = inv_sqrt(n_sq);
+    nx *= recip;
+    ny *= recip;
+    nz *= recip;
+
+    // Earth "West" axis = Up x North
+    float wx = uy * nz - uz * ny;
+    float wy = uz * nx - ux * nz;
+    float wz = ux * ny - uy * nx;
+
+    // Rows of R (earth <- body) are N, W, U. Convert to quaternion (Shepperd).
+    float r00 = nx, r01 = ny, r02 = nz;
+    float r10 = wx, r11 = wy, r12 = wz;
+    float r20 = ux, r21 = uy, r22 = uz;
+    float trace = r00 + r11 + r22;
+    ahrs_state_t st = {0};
+
+    if (trace > 0.0f) {
+        float s = 2.0f * sqrtf(trace + 1.0f);
+        st.q0 = 0.25f * s;
+        st.q1 = (r21 - r12) / s;
+        st.q2 = (r02 - r20) / s;
+        st.q3 = (r10 - r01) / s;
+    } else if ((r00 > r11) && (r00 > r22)) {
+        float s = 2.0f * sqrtf(1.0f + r00 - r11 - r22);
+        st.q0 = (r21 - r12) / s;
+        st.q1 = 0.25f * s;
+        st.q2 = (r01 + r10) / s;
+        st.q3 = (r02 + r20) / s;
+    } else if (r11 > r22) {
+        float s = 2.0f * sqrtf(1.0f + r11 - r00 - r22);
+        st.q0 = (r02 - r20) / s;
+        st.q1 = (r01 + r10) / s;
+        st.q2 = 0.25f * s;
+        st.q3 = (r12 + r21) / s;
+    } else {
+        float s = 2.0f * sqrtf(1.0f + r22 - r00 - r11);
+        st.q0 = (r10 - r01) / s;
+        st.q1 = (r02 + r20) / s;
+        st.q2 = (r12 + r21) / s;
+        st.q3 = 0.25f * s;
+    }
+    normalize_quat(&st);
+
+    ahrs->q0 = st.q0;
+    ahrs->q1 = st.q1;
+    ahrs->q2 = st.q2;
+    ahrs->q3 = st.q3;
+}
+
+AHRS_HOT void ahrs_update(ahrs_t *ahrs, const ahrs_sample_t *s, float dt) {
+    uint32_t t_start = AHRS_CYCLES();
+
+    ahrs_state_t st;
+    load_state(ahrs, &st);
+    step(ahrs, &st, s, dt);
+    store_state(ahrs, &st);
+
+    record_cost(&ahrs->stats, AHRS_CYCLES() - t_start, 1);
+}
+
+AHRS_HOT void ahrs_update_batch(ahrs_t *ahrs, const ahrs_sample_t *samples, size_t count, float dt) {
+    if (samples == NULL || count == 0) return;
+
+    uint32_t t_start = AHRS_CYCLES();
+
+    ahrs_state_t st;
+    load_state(ahrs, &st);
+    for (size_t i = 0; i < count; i++) {
+        step(ahrs, &st, &samples[i], dt);
+    }
+    store_state(ahrs, &st);
+
+    record_cost(&ahrs->stats, AHRS_CYCLES() - t_start, (uint32_t)count);
+}
+
+void ahrs_get_euler(const ahrs_t *ahrs, float *roll, float *pitch, float *yaw) {
+    float q0 = ahrs->q0, q1 = ahrs->q1, q2 = ahrs->q2, q3 = ahrs->q3;
+
+    if (roll != NULL) {
+        *roll = atan2f(q0 * q1 + q2 * q3, 0.5f - q1 * q1 - q2 * q2) * AHRS_RAD_TO_DEG;
+    }
+    if (pitch != NULL) {
+        float sinp = -2.0f * (q1 * q3 - q0 * q2);
+        if (sinp > 1.0f) sinp = 1.0f;
+        if (sinp < -1.0f) sinp = -1.0f;
+        *pitch = asinf(sinp) * AHRS_RAD_TO_DEG;
+    }
+    if (yaw != NULL) {
+        // Quaternion yaw is counter-clockwise (towards West); compass heading is clockwise
+        float heading = -atan2f(q1 * q2 + q0 * q3, 0.5f - q2 * q2 - q3 * q3) * AHRS_RAD_TO_DEG;
+        if (heading < 0.0f) heading += 360.0f;
+        *yaw = heading;
+    }
+}
+
+void ahrs_body_to_earth(const ahrs_t *ahrs, const float body[3], float earth[3]) {
+    float q0 = ahrs->q0, q1 = ahrs->q1, q2 = ahrs->q2, q3 = ahrs->q3;
+    float x = body[0], y = body[1], z = body[2];
+
+    earth[0] = (1.0f - 2.0f * (q2 * q2 + q3 * q3)) * x + 2.0f * (q1 * q2 - q0 * q3) * y
+               + 2.0f * (q1 * q3 + q0 * q2) * z;
+    earth[1] = 2.0f * (q1 * q2 + q0 * q3) * x + (1.0f - 2.0f * (q1 * q1 + q3 * q3)) * y
+               + 2.0f * (q2 * q3 - q0 * q1) * z;
+    earth[2] = 2.0f * (q1 * q3 - q0 * q2) * x + 2.0f * (q2 * q3 + q0 * q1) * y
+               + (1.0f - 2.0f * (q1 * q1 + q2 * q2)) * z;
+}
+
+float ahrs_get_cpu_load_pct(const ahrs_t *ahrs, float rate_hz, uint32_t cpu_mhz) {
+    if (ahrs->stats.update_count == 0 || cpu_mhz == 0) return 0.0f;
+
+    float avg_cycles = (float)ahrs->stats.total_cycles / (float)ahrs->stats.update_count;
+    return avg_cycles * rate_hz / ((float)cpu_mhz * 1e6f) * 100.0f;
+}
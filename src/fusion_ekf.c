@@ -0,0 +1,237 @@
+/**
+ * @file fusion_ekf.c
+ * @brief GPS/IMU Error-State Kalman Filter Implementation
+ * @details
+ * Per-axis model (constant acceleration input, constant bias):
+ *   p' = p + v*dt + 0.5*(a - b)*dt^2
+ *   v' = v + (a - b)*dt
+ *   b' = b
+ * Error-state transition F = [1 dt -dt^2/2; 0 1 -dt; 0 0 1].
+ *
+ * F*P*F' is expanded by hand on the 6 unique covariance terms (~30 flops
+ * instead of 2 dense 3x3 products), and H is a unit row for both GPS
+ * measurements, so the Kalman gain is a covariance column over a scalar.
+ */
+
+#include "fusion_ekf.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#define EKF_HOT             IRAM_ATTR
+#define EKF_CYCLES()        ((uint32_t)esp_cpu_get_cycle_count())
+#else
+#define EKF_HOT
+#define EKF_CYCLES()        0U
+#endif
+
+#define EKF_DEG_E5_TO_RAD   (3.14159265f / 180.0f * 1e-5f)
+
+// --- HELPER FUNCTIONS ---
+
+static inline void record_cycles(uint32_t cycles, uint32_t *count, uint32_t *last, uint32_t *max) {
+    (*count)++;
+    *last = cycles;
+    if (cycles > *max) *max = cycles;
+}
+
+static void reset_cov(ekf_cov3_t *P) {
+    memset(P, 0, sizeof(*P));
+    P->pp = EKF_INIT_POS_STD * EKF_INIT_POS_STD;
+    P->vv = EKF_INIT_VEL_STD * EKF_INIT_VEL_STD;
+    P->bb = EKF_INIT_BIAS_STD * EKF_INIT_BIAS_STD;
+}
+
+/**
+ * @brief Propagate one axis: nominal state + P = F*P*F' + Q
+ */
+static inline void predict_axis(ekf_axis_t *ax, float accel, float dt, float q_accel, float q_bias) {
+    float h = 0.5f * dt * dt;
+    float a = accel - ax->bias;
+
+    ax->pos += ax->vel * dt + a * h;
+    ax->vel += a * dt;
+
+    ekf_cov3_t *P = &ax->P;
+
+    // Rows of F*P
+    float r0_0 = P->pp + dt * P->pv - h * P->pb;
+    float r0_1 = P->pv + dt * P->vv - h * P->vb;
+    float r0_2 = P->pb + dt * P->vb - h * P->bb;
+    float r1_1 = P->vv - dt * P->vb;
+    float r1_2 = P->vb - dt * P->bb;
+
+    // (F*P)*F' (upper triangle) + discrete white-noise acceleration Q
+    float qh = q_accel * h;
+    P->pp = r0_0 + dt * r0_1 - h * r0_2 + qh * h;
+    P->pv = r0_1 - dt * r0_2 + qh * dt;
+    P->pb = r0_2;
+    P->vv = r1_1 - dt * r1_2 + q_accel * dt * dt;
+    P->vb = r1_2;
+    P->bb += q_bias * dt;
+}
+
+/**
+ * @brief Scalar update on state index k (0 = pos, 1 = vel)
+ * @details With H = e_k: S = P_kk + R, K = P(:,k)/S, P -= K*P(k,:).
+ * @return false if the innovation fails the gate (state untouched)
+ */
+static bool update_axis(ekf_axis_t *ax, int k, float z, float r) {
+    ekf_cov3_t *P = &ax->P;
+
+    // Column k of P
+    float c0 = (k == 0) ? P->pp : P->pv;
+    float c1 = (k == 0) ? P->pv : P->vv;
+    float c2 = (k == 0) ? P->pb : P->vb;
+
+    float s = ((k == 0) ? c0 : c1) + r;
+    float y = z - ((k == 0) ? ax->pos : ax->vel);
+    if (y * y > EKF_GATE_SIGMA * EKF_GATE_SIGMA * s) return false;
+
+    float inv_s = 1.0f / s;
+    float k0 = c0 * inv_s, k1 = c1 * inv_s, k2 = c2 * inv_s;
+
+    // Inject error state into nominal state (error state resets to 0)
+    ax->pos += k0 * y;
+    ax->vel += k1 * y;
+    ax->bias += k2 * y;
+
+    P->pp -= k0 * c0;
+    P->pv -= k0 * c1;
+    P->pb -= k0 * c2;
+    P->vv -= k1 * c1;
+    P->vb -= k1 * c2;
+    P->bb -= k2 * c2;
+    return true;
+}
+
+static bool update_pair(ekf_t *ekf, int k, float z_e, float z_n, float std) {
+    uint32_t t_start = EKF_CYCLES();
+    float r = std * std;
+
+    bool ok_e = update_axis(&ekf->axis[0], k, z_e, r);
+    bool ok_n = update_axis(&ekf->axis[1], k, z_n, r);
+
+    ekf_stats_t *st = &ekf->stats;
+    record_cycles(EKF_CYCLES() - t_start, &st->update_count, &st->update_last_cycles, &st->update_max_cycles);
+    if (!ok_e || !ok_n) st->gps_rejects++;
+    return ok_e && ok_n;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void ekf_init(ekf_t *ekf) {
+    memset(ekf, 0, sizeof(*ekf));
+    ekf->q_accel = EKF_ACCEL_NOISE * EKF_ACCEL_NOISE;
+    ekf->q_bias = EKF_BIAS_NOISE * EKF_BIAS_NOISE;
+    reset_cov(&ekf->axis[0].P);
+    reset_cov(&ekf->axis[1].P);
+}
+
+void ekf_reset(ekf_t *ekf, float east_m, float north_m, float ve, float vn) {
+    ekf->axis[0].pos = east_m;
+    ekf->axis[0].vel = ve;
+    ekf->axis[0].bias = 0.0f;
+    ekf->axis[1].pos = north_m;
+    ekf->axis[1].vel = vn;
+    ekf->axis[1].bias = 0.0f;
+    reset_cov(&ekf->axis[0].P);
+    reset_cov(&ekf->axis[1].P);
+    ekf->reject_run = 0;
+    ekf->is_initialized = true;
+}
+
+EKF_HOT void ekf_predict(ekf_t *ekf, float ae, float an, float dt) {
+    if (!ekf->is_initialized || dt <= 0.0f) return;
+    uint32_t t_start = EKF_CYCLES();
+
+    predict_axis(&ekf->axis[0], ae, dt, ekf->q_accel, ekf->q_bias);
+    predict_axis(&ekf->axis[1], an, dt, ekf->q_accel, ekf->q_bias);
+
+    ekf_stats_t *st = &ekf->stats;
+    record_cycles(EKF_CYCLES() - t_start, &st->predict_count, &st->predict_last_cycles, &st->predict_max_cycles);
+}
+
+EKF_HOT void ekf_predict_body(ekf_t *ekf, const ahrs_t *ahrs, const float accel[3], float dt) {
+    float earth[3];
+    ahrs_body_to_earth(ahrs, accel, earth);
+
+    // AHRS earth frame is North-West-Up
+    ekf_predict(ekf, -earth[1], earth[0], dt);
+}
+
+bool ekf_update_position(ekf_t *ekf, float east_m, float north_m, float std_m) {
+    if (!ekf->is_initialized) return false;
+    return update_pair(ekf, 0, east_m, north_m, std_m);
+}
+
+bool ekf_update_velocity(ekf_t *ekf, float ve, float vn, float std_m_s) {
+    if (!ekf->is_initialized) return false;
+    return update_pair(ekf, 1, ve, vn, std_m_s);
+}
+
+bool ekf_update_gps(ekf_t *ekf, const gps_fix_t *fix) {
+    if (fix->fix_type < GPS_FIX_2D) return false;
+
+    if (!ekf->origin.is_valid) {
+        nav_geo_set_origin(&ekf->origin, fix->lat_e7, fix->lon_e7);
+    }
+
+    float east, north;
+    nav_geo_project(&ekf->origin, fix->lat_e7, fix->lon_e7, &east, &north);
+
+    float ve, vn;
+    float pos_std, vel_std;
+    if (fix->from_ubx) {
+        ve = (float)fix->vel_e_mm_s * 1e-3f;
+        vn = (float)fix->vel_n_mm_s * 1e-3f;
+        pos_std = fmaxf((float)fix->h_acc_mm * 1e-3f, EKF_GPS_POS_STD_MIN);
+        vel_std = fmaxf((float)fix->s_acc_mm_s * 1e-3f, EKF_GPS_VEL_STD_MIN);
+    } else {
+        float speed = (float)fix->ground_speed_mm_s * 1e-3f;
+        float course = (float)fix->course_e5 * EKF_DEG_E5_TO_RAD;
+        ve = speed * sinf(course);
+        vn = speed * cosf(course);
+        pos_std = EKF_GPS_POS_STD_NMEA;
+        vel_std = EKF_GPS_VEL_STD_NMEA;
+    }
+
+    if (!ekf->is_initialized) {
+        ekf_reset(ekf, east, north, ve, vn);
+        ekf->last_gps_us = fix->rx_time_us;
+        return true;
+    }
+
+    // Velocity first: it is what the integrated IMU drifts in
+    bool ok = ekf_update_velocity(ekf, ve, vn, vel_std);
+    ok = ekf_update_position(ekf, east, north, pos_std) && ok;
+
+    if (ok) {
+        ekf->reject_run = 0;
+        ekf->last_gps_us = fix->rx_time_us;
+    } else if (++ekf->reject_run >= EKF_MAX_REJECTS) {
+        // Filter has diverged (e.g. long dropout): trust GPS again
+        ekf_reset(ekf, east, north, ve, vn);
+        ekf->last_gps_us = fix->rx_time_us;
+        ekf->stats.gps_reseeds++;
+        ok = true;
+    }
+    return ok;
+}
+
+void ekf_get_state(const ekf_t *ekf, float *east_m, float *north_m, float *ve, float *vn) {
+    if (east_m != NULL) *east_m = ekf->axis[0].pos;
+    if (north_m != NULL) *north_m = ekf->axis[1].pos;
+    if (ve != NULL) *ve = ekf->axis[0].vel;
+    if (vn != NULL) *vn = ekf->axis[1].vel;
+}
+
+float ekf_get_pos_std(const ekf_t *ekf) {
+    return sqrtf(ekf->axis[0].P.pp + ekf->axis[1].P.pp);
+}
+
+bool ekf_is_gps_aided(const ekf_t *ekf, int64_t now_us) {
+    return ekf->is_initialized && (now_us - ekf->last_gps_us) < EKF_GPS_TIMEOUT_US;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file fusion_heave.c
+ * @brief Heave Compensation Implementation (pure C, no IDF dependencies)
+ * @details
+ * Per IMU sample one add (and one slot publish every 10 ms); per load-cell
+ * read a mean over ~10 slots and one divide. Slots are published seqlock
+ * style with GCC __atomic builtins, which map to plain loads/stores plus
+ * memw barriers on the ESP32-S3.
+ */
+
+#include "fusion_heave.h"
+#include <string.h>
+
+// --- HELPER FUNCTIONS ---
+
+static void publish_slot(heave_t *h) {
+    if (h->cur_n == 0) return;
+
+    uint32_t i = (uint32_t)h->cur_id % HEAVE_SLOTS;
+    float fz = h->cur_sum / (float)h->cur_n;
+
+    __atomic_store_n(&h->slot_id[i], -1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store(&h->slot_fz[i], &fz, __ATOMIC_RELAXED);
+    __atomic_store_n(&h->slot_id[i], h->cur_id, __ATOMIC_RELEASE);
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void heave_init(heave_t *h) {
+    memset(h, 0, sizeof(*h));
+    for (int i = 0; i < HEAVE_SLOTS; i++) h->slot_id[i] = -1;
+    h->cur_id = -1;
+}
+
+void heave_add(heave_t *h, int64_t t_us, float fz) {
+    int32_t id = (int32_t)(t_us / HEAVE_SLOT_US);
+
+    if (id != h->cur_id) {
+        publish_slot(h);
+        h->cur_id = id;
+        h->cur_sum = 0.0f;
+        h->cur_n = 0;
+    }
+    h->cur_sum += fz;
+    h->cur_n++;
+    h->samples++;
+}
+
+void heave_add_batch(heave_t *h, const imu_sample_t *samples, size_t count) {
+    for (size_t i = 0; i < count; i++) heave_add(h, samples[i].timestamp_us, samples[i].az);
+}
+
+bool heave_factor(const heave_t *h, int64_t from_us, int64_t to_us, float *k) {
+    if (to_us <= from_us || from_us < 0) return false;
+
+    int32_t first = (int32_t)(from_us / HEAVE_SLOT_US);
+    int32_t last = (int32_t)((to_us - 1) / HEAVE_SLOT_US);
+    if (last - first >= HEAVE_SLOTS) first = last - HEAVE_SLOTS + 1;
+
+    float sum = 0.0f;
+    int32_t n = 0;
+    for (int32_t id = first; id <= last; id++) {
+        uint32_t i = (uint32_t)id % HEAVE_SLOTS;
+        float fz;
+
+        if (__atomic_load_n(&h->slot_id[i], __ATOMIC_ACQUIRE) != id) continue;
+        __atomic_load(&h->slot_fz[i], &fz, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&h->slot_id[i], __ATOMIC_RELAXED) != id) continue;
+
+        sum += fz;
+        n++;
+    }
+
+    // Slots at the end of the window may still be in the IMU FIFO
+    if ((float)n < HEAVE_MIN_COVERAGE * (float)(last - first + 1)) return false;
+
+    float factor = sum / ((float)n * IMU_GRAVITY_MS2);
+    if (factor < HEAVE_K_MIN || factor > HEAVE_K_MAX) return false;
+
+    *k = factor;
+    return true;
+}
+
+int32_t heave_compensate(int32_t weight, float k, int32_t deadload) {
+    return (int32_t)((float)(weight + deadload) / k) - deadload;
+}
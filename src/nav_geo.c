@@ -0,0 +1,41 @@
+/**
+ * @file nav_geo.c
+ * @brief Local Tangent Plane (ENU) Projection Implementation
+ */
+
+#include "nav_geo.h"
+#include <math.h>
+
+#define E7_TO_RAD   (M_PI / 180.0 * 1e-7)
+
+void nav_geo_set_origin(nav_origin_t *origin, int32_t lat_e7, int32_t lon_e7) {
+    double phi = (double)lat_e7 * E7_TO_RAD;
+    double s = sin(phi);
+    double w = 1.0 - NAV_WGS84_E2 * s * s;
+
+    // Meridional (M) and prime vertical (N) radii of curvature
+    double r_m = NAV_WGS84_A * (1.0 - NAV_WGS84_E2) / (w * sqrt(w));
+    double r_n = NAV_WGS84_A / sqrt(w);
+
+    origin->lat0_e7 = lat_e7;
+    origin->lon0_e7 = lon_e7;
+    origin->m_per_e7_lat = (float)(r_m * E7_TO_RAD);
+    origin->m_per_e7_lon = (float)(r_n * cos(phi) * E7_TO_RAD);
+    origin->is_valid = true;
+}
+
+void nav_geo_project(const nav_origin_t *origin, int32_t lat_e7, int32_t lon_e7,
+                     float *east_m, float *north_m) {
+    // Differences stay exact in int32 (no catastrophic cancellation in float)
+    int32_t d_lat = lat_e7 - origin->lat0_e7;
+    int32_t d_lon = lon_e7 - origin->lon0_e7;
+
+    *north_m = (float)d_lat * origin->m_per_e7_lat;
+    *east_m = (float)d_lon * origin->m_per_e7_lon;
+}
+
+void nav_geo_unproject(const nav_origin_t *origin, float east_m, float north_m,
+                       int32_t *lat_e7, int32_t *lon_e7) {
+    *lat_e7 = origin->lat0_e7 + (int32_t)lrintf(north_m / origin->m_per_e7_lat);
+    *lon_e7 = origin->lon0_e7 + (int32_t)lrintf(east_m / origin->m_per_e7_lon);
+}
@@ -0,0 +1,207 @@
+/**
+ * @file nav_waypoint.c
+ * @brief Waypoint Navigator & Geofence Implementation
+ */
+
+#include "nav_waypoint.h"
+#include <math.h>
+#include <string.h>
+
+#define NAV_RAD_TO_DEG      57.29577951f
+
+// --- HELPER FUNCTIONS ---
+
+static void build_leg(nav_leg_t *leg, nav_enu_t from, nav_enu_t to) {
+    float de = to.e - from.e;
+    float dn = to.n - from.n;
+    float len = sqrtf(de * de + dn * dn);
+
+    leg->from = from;
+    leg->to = to;
+    leg->length_m = len;
+    if (len > 1e-3f) {
+        leg->ue = de / len;
+        leg->un = dn / len;
+    } else {
+        leg->ue = 0.0f;
+        leg->un = 1.0f;
+    }
+    leg->bearing_deg = nav_bearing_deg(de, dn);
+}
+
+/**
+ * @brief Crossing-number point-in-polygon test
+ */
+static bool polygon_contains(const nav_fence_t *f, float e, float n) {
+    bool inside = false;
+    for (uint8_t i = 0, j = f->count - 1; i < f->count; j = i++) {
+        const nav_enu_t *a = &f->verts[i];
+        const nav_enu_t *b = &f->verts[j];
+        if ((a->n > n) != (b->n > n)) {
+            float e_cross = a->e + (n - a->n) * (b->e - a->e) / (b->n - a->n);
+            if (e < e_cross) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+/**
+ * @brief Segment / axis-aligned box overlap (Liang-Barsky clip)
+ */
+static bool segment_hits_box(nav_enu_t a, nav_enu_t b, float e0, float n0, float e1, float n1) {
+    float t0 = 0.0f, t1 = 1.0f;
+    float d[2] = { b.e - a.e, b.n - a.n };
+    float p0[2] = { a.e, a.n };
+    float lo[2] = { e0, n0 };
+    float hi[2] = { e1, n1 };
+
+    for (int k = 0; k < 2; k++) {
+        if (fabsf(d[k]) < 1e-9f) {
+            if (p0[k] < lo[k] || p0[k] > hi[k]) return false;
+            continue;
+        }
+        float ta = (lo[k] - p0[k]) / d[k];
+        float tb = (hi[k] - p0[k]) / d[k];
+        if (ta > tb) { float tmp = ta; ta = tb; tb = tmp; }
+        if (ta > t0) t0 = ta;
+        if (tb < t1) t1 = tb;
+        if (t0 > t1) return false;
+    }
+    return true;
+}
+
+static void build_fence_index(nav_fence_t *f) {
+    float max_e = f->verts[0].e, max_n = f->verts[0].n;
+    f->min_e = max_e;
+    f->min_n = max_n;
+    for (uint8_t i = 1; i < f->count; i++) {
+        if (f->verts[i].e < f->min_e) f->min_e = f->verts[i].e;
+        if (f->verts[i].n < f->min_n) f->min_n = f->verts[i].n;
+        if (f->verts[i].e > max_e) max_e = f->verts[i].e;
+        if (f->verts[i].n > max_n) max_n = f->verts[i].n;
+    }
+
+    float cell_e = fmaxf((max_e - f->min_e) / NAV_FENCE_GRID, 1e-3f);
+    float cell_n = fmaxf((max_n - f->min_n) / NAV_FENCE_GRID, 1e-3f);
+    f->inv_cell_e = 1.0f / cell_e;
+    f->inv_cell_n = 1.0f / cell_n;
+
+    for (int row = 0; row < NAV_FENCE_GRID; row++) {
+        for (int col = 0; col < NAV_FENCE_GRID; col++) {
+            float e0 = f->min_e + col * cell_e, e1 = e0 + cell_e;
+            float n0 = f->min_n + row * cell_n, n1 = n0 + cell_n;
+
+            uint8_t cls = NAV_CELL_OUT;
+            for (uint8_t i = 0, j = f->count - 1; i < f->count; j = i++) {
+                if (segment_hits_box(f->verts[j], f->verts[i], e0, n0, e1, n1)) {
+                    cls = NAV_CELL_EDGE;
+                    break;
+                }
+            }
+            // No edge inside the cell: the whole cell shares its centre's class
+            if (cls != NAV_CELL_EDGE) {
+                cls = polygon_contains(f, 0.5f * (e0 + e1), 0.5f * (n0 + n1)) ? NAV_CELL_IN : NAV_CELL_OUT;
+            }
+            f->cells[row * NAV_FENCE_GRID + col] = cls;
+        }
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+float nav_bearing_deg(float de, float dn) {
+    float b = atan2f(de, dn) * NAV_RAD_TO_DEG;
+    return (b < 0.0f) ? b + 360.0f : b;
+}
+
+void nav_mission_init(nav_mission_t *m, int32_t lat_e7, int32_t lon_e7) {
+    memset(m, 0, sizeof(*m));
+    nav_geo_set_origin(&m->origin, lat_e7, lon_e7);
+    m->accept_radius_m = NAV_ACCEPT_RADIUS_M;
+}
+
+bool nav_mission_add_waypoint(nav_mission_t *m, int32_t lat_e7, int32_t lon_e7) {
+    if (m->leg_count >= NAV_MAX_WAYPOINTS) return false;
+
+    nav_enu_t to = nav_mission_project(m, lat_e7, lon_e7);
+    nav_enu_t from = (m->leg_count == 0) ? m->home : m->legs[m->leg_count - 1].to;
+    build_leg(&m->legs[m->leg_count], from, to);
+    m->leg_count++;
+    return true;
+}
+
+bool nav_mission_set_fence(nav_mission_t *m, const int32_t *lat_e7, const int32_t *lon_e7, uint8_t count) {
+    if (count < 3 || count > NAV_MAX_FENCE_VERTS) return false;
+
+    nav_fence_t *f = &m->fence;
+    f->count = count;
+    for (uint8_t i = 0; i < count; i++) {
+        f->verts[i] = nav_mission_project(m, lat_e7[i], lon_e7[i]);
+    }
+    build_fence_index(f);
+    m->has_fence = true;
+    return true;
+}
+
+void nav_mission_return_home(nav_mission_t *m, nav_enu_t pos) {
+    build_leg(&m->legs[0], pos, m->home);
+    m->leg_count = 1;
+    m->active_leg = 0;
+}
+
+nav_enu_t nav_mission_project(const nav_mission_t *m, int32_t lat_e7, int32_t lon_e7) {
+    nav_enu_t p;
+    nav_geo_project(&m->origin, lat_e7, lon_e7, &p.e, &p.n);
+    return p;
+}
+
+void nav_update(nav_mission_t *m, nav_enu_t pos, nav_status_t *out) {
+    out->wp_reached = false;
+    out->inside_fence = m->has_fence ? nav_fence_contains(&m->fence, pos) : true;
+
+    if (m->active_leg >= m->leg_count) {
+        out->mission_done = true;
+        out->leg = m->active_leg;
+        out->dist_to_wp_m = 0.0f;
+        out->cross_track_m = 0.0f;
+        out->along_track_m = 0.0f;
+        return;
+    }
+
+    const nav_leg_t *leg = &m->legs[m->active_leg];
+    float de = leg->to.e - pos.e;
+    float dn = leg->to.n - pos.n;
+    float dist = sqrtf(de * de + dn * dn);
+
+    // Position relative to leg start, in leg coordinates
+    float pe = pos.e - leg->from.e;
+    float pn = pos.n - leg->from.n;
+    float along = pe * leg->ue + pn * leg->un;
+    float cross = pe * leg->un - pn * leg->ue;
+
+    // Reached: inside acceptance radius, or passed the perpendicular at the waypoint
+    if (dist < m->accept_radius_m || along >= leg->length_m) {
+        m->active_leg++;
+        out->wp_reached = true;
+    }
+
+    out->leg = m->active_leg;
+    out->mission_done = (m->active_leg >= m->leg_count);
+    out->dist_to_wp_m = dist;
+    out->bearing_to_wp_deg = nav_bearing_deg(de, dn);
+    out->leg_bearing_deg = leg->bearing_deg;
+    out->cross_track_m = cross;
+    out->along_track_m = along;
+}
+
+bool nav_fence_contains(const nav_fence_t *f, nav_enu_t p) {
+    float ce = (p.e - f->min_e) * f->inv_cell_e;
+    float cn = (p.n - f->min_n) * f->inv_cell_n;
+
+    // Outside bounding box
+    if (ce < 0.0f || cn < 0.0f || ce >= NAV_FENCE_GRID || cn >= NAV_FENCE_GRID) return false;
+
+    uint8_t cls = f->cells[(int)cn * NAV_FENCE_GRID + (int)ce];
+    if (cls == NAV_CELL_EDGE) return polygon_contains(f, p.e, p.n);
+    return cls == NAV_CELL_IN;
+}
@@ -0,0 +1,268 @@
+/**
+ * @file sys_blackbox.c
+ * @brief Black-Box Recorder Implementation (producer, RTC pre-trigger, flush task)
+ * @details
+ * bbox_record() is the only producer: it packs the frame, mirrors it into
+ * the RTC ring and puts it in the lock-free RAM ring. The bbox task
+ * (lowest application priority) is the only consumer and the only code
+ * touching flash. With CONFIG_SPI_FLASH_YIELD_DURING_ERASE the 4KB erase
+ * is split into slices so higher priority tasks keep running in between.
+ *
+ * PRETRIG frames overlap the last blocks flushed before the crash; a
+ * decoder keeps only those newer than the last FRAME of that session.
+ */
+
+#include <string.h>
+#include "sys_blackbox.h"
+#include "sys_mem.h"
+#include "sys_param.h"
+#include "sys_time.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "BLACKBOX";
+
+_Static_assert(MEM_TASK_BYTES(BBOX_TASK_STACK) <= MEM_BUDGET_BBOX,
+               "bbox_task over the MEM_BUDGET_TABLE entry");
+
+#define RTC_RING_MAGIC          0x52544342  // "BCTR"
+
+/**
+ * @brief Pre-trigger frames in RTC slow memory (not cleared by a reset)
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t next;                          // Slot written next
+    uint32_t count;
+    uint8_t len[BBOX_RTC_SLOTS];            // 0 while a slot is being written
+    uint8_t data[BBOX_RTC_SLOTS][BBOX_FRAME_MAX];
+} rtc_ring_t;
+
+// PRIVATE STATIC VARIABLES
+static RTC_NOINIT_ATTR rtc_ring_t rtc_ring;
+
+static const esp_partition_t *partition = NULL;
+static bbox_store_t store;
+static bbox_ring_t ring;
+static uint8_t ring_buf[BBOX_RAM_BYTES];
+static TaskHandle_t task_handle = NULL;
+static volatile bool flush_requested = false;
+static bool is_initialized = false;
+
+// Producer-owned
+static int64_t last_record_us = 0;
+static uint64_t record_cycles_sum = 0;
+static bbox_stats_t stats;
+
+// --- HELPER FUNCTIONS ---
+
+static bool part_read(void *ctx, uint32_t addr, void *buf, size_t len) {
+    return esp_partition_read(partition, addr, buf, len) == ESP_OK;
+}
+
+static bool part_write(void *ctx, uint32_t addr, const void *buf, size_t len) {
+    return esp_partition_write(partition, addr, buf, len) == ESP_OK;
+}
+
+static bool part_erase(void *ctx, uint32_t addr, size_t len) {
+    return esp_partition_erase_range(partition, addr, len) == ESP_OK;
+}
+
+static bool reset_was_crash(esp_reset_reason_t r) {
+    return r == ESP_RST_PANIC || r == ESP_RST_INT_WDT || r == ESP_RST_TASK_WDT ||
+           r == ESP_RST_WDT || r == ESP_RST_BROWNOUT;
+}
+
+static bool rtc_ring_valid(void) {
+    return rtc_ring.magic == RTC_RING_MAGIC && rtc_ring.next < BBOX_RTC_SLOTS &&
+           rtc_ring.count <= BBOX_RTC_SLOTS;
+}
+
+static void rtc_ring_reset(void) {
+    memset(rtc_ring.len, 0, sizeof(rtc_ring.len));
+    rtc_ring.next = 0;
+    rtc_ring.count = 0;
+    rtc_ring.magic = RTC_RING_MAGIC;
+}
+
+static void rtc_ring_put(const uint8_t *rec, size_t len) {
+    uint32_t slot = rtc_ring.next;
+    rtc_ring.len[slot] = 0;
+    memcpy(rtc_ring.data[slot], rec, len);
+    rtc_ring.len[slot] = (uint8_t)len;
+    rtc_ring.next = (slot + 1) % BBOX_RTC_SLOTS;
+    if (rtc_ring.count < BBOX_RTC_SLOTS) rtc_ring.count++;
+}
+
+/**
+ * @brief Copy the previous boot's RTC frames to flash as PRETRIG records
+ * @return Frames saved
+ */
+static uint32_t save_pretrig(void) {
+    uint32_t saved = 0;
+    uint32_t slot = (rtc_ring.next + BBOX_RTC_SLOTS - rtc_ring.count) % BBOX_RTC_SLOTS;
+
+    for (uint32_t i = 0; i < rtc_ring.count; i++, slot = (slot + 1) % BBOX_RTC_SLOTS) {
+        uint8_t *rec = rtc_ring.data[slot];
+        size_t len = rtc_ring.len[slot];
+        if (len == 0 || rec[0] != BBOX_TAG_FRAME || bbox_record_size(rec) != len) continue;   // Torn slot
+
+        rec[0] = BBOX_TAG_PRETRIG;
+        bbox_store_add(&store, rec, len);
+        saved++;
+    }
+    return saved;
+}
+
+static void write_session(esp_reset_reason_t reason, uint32_t pretrig) {
+    uint8_t rec[8] = {
+        BBOX_TAG_SESSION, (uint8_t)reason, (uint8_t)sysparam.bbox_channels, (uint8_t)sysparam.bbox_rate_hz,
+        (uint8_t)pretrig, (uint8_t)(pretrig >> 8), (uint8_t)(pretrig >> 16), (uint8_t)(pretrig >> 24),
+    };
+    bbox_store_add(&store, rec, sizeof(rec));
+}
+
+static void bbox_task(void *arg) {
+    uint8_t rec[BBOX_FRAME_MAX];
+    int64_t block_start_us = 0;
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(BBOX_POLL_MS));
+
+        int64_t t0 = esp_timer_get_time();
+        uint32_t seq0 = store.next_seq;
+        size_t len;
+
+        while ((len = bbox_ring_get(&ring, rec)) > 0) {
+            if (store.used == BBOX_BLOCK_HDR_BYTES) block_start_us = t0;
+            bbox_store_add(&store, rec, len);
+        }
+
+        bool stale = store.used > BBOX_BLOCK_HDR_BYTES &&
+                     (t0 - block_start_us) > BBOX_BLOCK_MAX_AGE_MS * 1000LL;
+        if (flush_requested || stale) {
+            flush_requested = false;
+            bbox_store_flush(&store);
+        }
+
+        // Only count passes that reached flash
+        if (store.next_seq != seq0) {
+            stats.flash_busy_us += (uint64_t)(esp_timer_get_time() - t0);
+            stats.blocks += store.next_seq - seq0;
+        }
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t bbox_init(void) {
+    if (is_initialized) return ESP_OK;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, BBOX_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition '%s' not found", BBOX_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    flog_flash_t io = {
+        .read = part_read,
+        .write = part_write,
+        .erase = part_erase,
+        .ctx = NULL,
+        .size = partition->size,
+    };
+    if (!bbox_store_mount(&store, &io)) {
+        ESP_LOGE(TAG, "Mount failed");
+        return ESP_FAIL;
+    }
+
+    // Crash evidence first, written out before anything new is recorded
+    esp_reset_reason_t reason = esp_reset_reason();
+    uint32_t pretrig = 0;
+    if (reset_was_crash(reason) && rtc_ring_valid()) {
+        pretrig = save_pretrig();
+        bbox_store_flush(&store);
+        ESP_LOGW(TAG, "Reset reason %d: %lu pre-trigger frames saved", reason, (unsigned long)pretrig);
+    }
+    stats.pretrig = pretrig;
+    rtc_ring_reset();
+    write_session(reason, pretrig);
+
+    bbox_ring_init(&ring, ring_buf, sizeof(ring_buf));
+    last_record_us = 0;
+
+    task_handle = mem_task_create(MEM_SUB_BBOX, bbox_task, "bbox_task", BBOX_TASK_STACK, NULL,
+                                  BBOX_TASK_PRIORITY, BBOX_TASK_CORE);
+    if (task_handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    is_initialized = true;
+    ESP_LOGI(TAG, "Recording to %u blocks from block %lu (seq %lu)",
+             (unsigned)store.block_count, (unsigned long)store.next_block, (unsigned long)store.next_seq);
+    return ESP_OK;
+}
+
+bool bbox_record(const bbox_frame_t *f) {
+    if (!is_initialized || f == NULL) return false;
+
+    uint32_t c0 = esp_cpu_get_cycle_count();
+
+    // Rate limit with 25% jitter allowance, so a loop at exactly the rate is not halved
+    int64_t now = systime_now_us();
+    int64_t period = 1000000 / sysparam.bbox_rate_hz;
+    if (now - last_record_us < period - period / 4) return false;
+    last_record_us = now;
+
+    uint8_t rec[BBOX_FRAME_MAX];
+    size_t len = bbox_pack(BBOX_TAG_FRAME, (uint8_t)sysparam.bbox_channels, (uint32_t)(now / 1000), f, rec);
+    rtc_ring_put(rec, len);
+    bool ok = bbox_ring_put(&ring, rec, len);
+
+    uint32_t used = bbox_ring_used(&ring);
+    if (used > stats.ring_peak) stats.ring_peak = used;
+    if (ok) stats.recorded++;
+    else stats.dropped++;
+
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    record_cycles_sum += cycles;
+    if (cycles > stats.record_cycles_max) stats.record_cycles_max = cycles;
+    return ok;
+}
+
+void bbox_flush(void) {
+    if (task_handle == NULL) return;
+    flush_requested = true;
+    xTaskNotifyGive(task_handle);
+}
+
+void bbox_get_stats(bbox_stats_t *out) {
+    if (out == NULL) return;
+
+    *out = stats;
+    uint32_t n = stats.recorded + stats.dropped;
+    out->record_cycles_avg = n ? (uint32_t)(record_cycles_sum / n) : 0;
+    out->erases = store.erases;
+    out->flash_errors = store.flash_errors;
+}
+
+void bbox_log_stats(void) {
+    bbox_stats_t s;
+    bbox_get_stats(&s);
+
+    float uptime_s = (float)esp_timer_get_time() / 1e6f;
+    float busy_pct = uptime_s > 0 ? (float)s.flash_busy_us / 1e4f / uptime_s : 0.0f;
+
+    ESP_LOGI(TAG, "Frames %lu (dropped %lu, pre-trigger %lu) | blocks %lu erases %lu flash_err %lu",
+             (unsigned long)s.recorded, (unsigned long)s.dropped, (unsigned long)s.pretrig,
+             (unsigned long)s.blocks, (unsigned long)s.erases, (unsigned long)s.flash_errors);
+    ESP_LOGI(TAG, "record() %lu cycles avg / %lu max | task flash time %.2f%% | RAM ring peak %lu/%u B",
+             (unsigned long)s.record_cycles_avg, (unsigned long)s.record_cycles_max, busy_pct,
+             (unsigned long)s.ring_peak, (unsigned)BBOX_RAM_BYTES);
+}
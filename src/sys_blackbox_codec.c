@@ -0,0 +1,202 @@
+/**
+ * @file sys_blackbox_codec.c
+ * @brief Black-Box Record Encoding, SPSC Ring and Block Store (pure C, no IDF dependencies)
+ */
+
+#include <string.h>
+#include "sys_blackbox.h"
+
+#define BLOCKS_PER_SECTOR       (BBOX_SECTOR_SIZE / BBOX_BLOCK_BYTES)
+#define SESSION_BYTES           8
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+    uint16_t used;              // Payload bytes after the header
+    uint16_t crc;
+} block_hdr_t;
+
+_Static_assert(sizeof(block_hdr_t) == BBOX_BLOCK_HDR_BYTES, "block header layout");
+_Static_assert(BBOX_FRAME_MAX <= 255, "ring length prefix is one byte");
+
+// --- HELPER FUNCTIONS ---
+
+static uint16_t crc16(const uint8_t *p, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int i = 0; i < 8; i++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t v) {
+    p = put16(p, (uint16_t)v);
+    return put16(p, (uint16_t)(v >> 16));
+}
+
+static bool write_block(bbox_store_t *st) {
+    uint32_t addr = st->next_block * BBOX_BLOCK_BYTES;
+    bool ok = true;
+
+    if (st->next_block % BLOCKS_PER_SECTOR == 0) {
+        ok = st->flash.erase(st->flash.ctx, addr, BBOX_SECTOR_SIZE);
+        st->erases++;
+    }
+
+    block_hdr_t h = {
+        .magic = BBOX_MAGIC,
+        .seq = st->next_seq,
+        .used = (uint16_t)(st->used - BBOX_BLOCK_HDR_BYTES),
+        .crc = crc16(st->block + BBOX_BLOCK_HDR_BYTES, st->used - BBOX_BLOCK_HDR_BYTES),
+    };
+    memcpy(st->block, &h, sizeof(h));
+    memset(st->block + st->used, 0xFF, BBOX_BLOCK_BYTES - st->used);
+
+    if (ok) ok = st->flash.write(st->flash.ctx, addr, st->block, BBOX_BLOCK_BYTES);
+    if (!ok) st->flash_errors++;
+
+    // On error the block is dropped, never retried in place
+    st->next_block = (st->next_block + 1) % st->block_count;
+    st->next_seq++;
+    st->used = BBOX_BLOCK_HDR_BYTES;
+    return ok;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+size_t bbox_frame_size(uint8_t mask) {
+    size_t n = BBOX_FRAME_HDR_BYTES;
+    if (mask & BBOX_CH_MOTOR)   n += 4;
+    if (mask & BBOX_CH_DIST)    n += 6;
+    if (mask & BBOX_CH_LOAD)    n += 14;
+    if (mask & BBOX_CH_BATT)    n += 2;
+    if (mask & BBOX_CH_MISSION) n += 1;
+    return n;
+}
+
+size_t bbox_pack(uint8_t tag, uint8_t mask, uint32_t time_ms, const bbox_frame_t *f, uint8_t *out) {
+    uint8_t *p = out;
+    mask &= BBOX_CH_ALL;
+
+    *p++ = tag;
+    *p++ = mask;
+    p = put32(p, time_ms);
+    if (mask & BBOX_CH_MOTOR) {
+        p = put16(p, f->motor_left);
+        p = put16(p, f->motor_right);
+    }
+    if (mask & BBOX_CH_DIST) {
+        for (int i = 0; i < 3; i++) p = put16(p, f->dist_mm[i]);
+    }
+    if (mask & BBOX_CH_LOAD) {
+        for (int i = 0; i < 3; i++) p = put32(p, (uint32_t)f->load[i]);
+        p = put16(p, f->flags);
+    }
+    if (mask & BBOX_CH_BATT) p = put16(p, f->batt_mv);
+    if (mask & BBOX_CH_MISSION) *p++ = f->mission;
+    return (size_t)(p - out);
+}
+
+size_t bbox_record_size(const uint8_t *rec) {
+    switch (rec[0]) {
+        case BBOX_TAG_FRAME:
+        case BBOX_TAG_PRETRIG:
+            return bbox_frame_size(rec[1]);
+        case BBOX_TAG_SESSION:
+            return SESSION_BYTES;
+        default:
+            return 0;
+    }
+}
+
+void bbox_ring_init(bbox_ring_t *r, uint8_t *buf, uint32_t size) {
+    r->buf = buf;
+    r->size = size;
+    r->head = 0;
+    r->tail = 0;
+}
+
+bool bbox_ring_put(bbox_ring_t *r, const uint8_t *rec, size_t len) {
+    uint32_t head = r->head;
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if (len == 0 || len > BBOX_FRAME_MAX || r->size - (head - tail) < len + 1) return false;
+
+    uint32_t mask = r->size - 1;
+    r->buf[head & mask] = (uint8_t)len;
+    for (size_t i = 0; i < len; i++) r->buf[(head + 1 + i) & mask] = rec[i];
+
+    // Publish after the data
+    __atomic_store_n(&r->head, head + 1 + (uint32_t)len, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t bbox_ring_get(bbox_ring_t *r, uint8_t *out) {
+    uint32_t tail = r->tail;
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    if (head == tail) return 0;
+
+    uint32_t mask = r->size - 1;
+    size_t len = r->buf[tail & mask];
+    for (size_t i = 0; i < len; i++) out[i] = r->buf[(tail + 1 + i) & mask];
+
+    __atomic_store_n(&r->tail, tail + 1 + (uint32_t)len, __ATOMIC_RELEASE);
+    return len;
+}
+
+uint32_t bbox_ring_used(const bbox_ring_t *r) {
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+bool bbox_store_mount(bbox_store_t *st, const flog_flash_t *flash) {
+    memset(st, 0, sizeof(*st));
+    st->flash = *flash;
+    st->block_count = flash->size / BBOX_BLOCK_BYTES;
+    st->used = BBOX_BLOCK_HDR_BYTES;
+    if (st->block_count < BLOCKS_PER_SECTOR * 2 || flash->size % BBOX_SECTOR_SIZE != 0) return false;
+
+    bool found = false;
+    uint32_t newest = 0;
+    uint32_t newest_seq = 0;
+    for (uint32_t b = 0; b < st->block_count; b++) {
+        block_hdr_t h;
+        if (!flash->read(flash->ctx, b * BBOX_BLOCK_BYTES, &h, sizeof(h))) return false;
+        if (h.magic != BBOX_MAGIC || h.used > BBOX_BLOCK_BYTES - BBOX_BLOCK_HDR_BYTES) continue;
+        if (!found || (int32_t)(h.seq - newest_seq) > 0) {
+            found = true;
+            newest = b;
+            newest_seq = h.seq;
+        }
+    }
+
+    // Resume on a fresh sector: a block torn by a reset is never programmed over
+    if (found) {
+        st->next_seq = newest_seq + 1;
+        uint32_t sector = newest / BLOCKS_PER_SECTOR + 1;
+        st->next_block = (sector * BLOCKS_PER_SECTOR) % st->block_count;
+    }
+    return true;
+}
+
+bool bbox_store_add(bbox_store_t *st, const uint8_t *rec, size_t len) {
+    if (len == 0 || len > BBOX_BLOCK_BYTES - BBOX_BLOCK_HDR_BYTES) return false;
+
+    bool ok = true;
+    if (st->used + len > BBOX_BLOCK_BYTES) ok = write_block(st);
+    memcpy(st->block + st->used, rec, len);
+    st->used += (uint16_t)len;
+    return ok;
+}
+
+bool bbox_store_flush(bbox_store_t *st) {
+    if (st->used == BBOX_BLOCK_HDR_BYTES) return true;
+    return write_block(st);
+}
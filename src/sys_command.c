@@ -0,0 +1,229 @@
+/**
+ * @file sys_command.c
+ * @brief Remote Command Channel & Link-Loss Watchdog Implementation
+ * @details
+ * Messages are parsed in the modem driver's RX callback (modem task).
+ * STOP/ABORT act right there: ctrl_heading_stop() then motor_stop_all(),
+ * so the latency is UART -> modem task -> LEDC, independent of how busy
+ * the application loop is. The watchdog is a 1s esp_timer.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include "sys_command.h"
+#include "sys_mem.h"
+#include "sys_mission.h"
+#include "sys_param.h"
+#include "sys_ota.h"
+#include "drv_modem.h"
+#include "drv_motor.h"
+#include "ctrl_heading.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/queue.h"
+
+static const char *TAG = "COMMAND";
+
+_Static_assert(MEM_QUEUE_BYTES(CMD_QUEUE_LEN, sizeof(cmd_t)) <= MEM_BUDGET_CMD,
+               "command queue over the MEM_BUDGET_TABLE entry");
+
+// PRIVATE STATIC VARIABLES
+static QueueHandle_t cmd_queue = NULL;
+static esp_timer_handle_t wd_timer = NULL;
+static cmd_t rx_cmd;                        // Modem task only
+static char param_reply[SYSPARAM_COUNT * SYSPARAM_TEXT_MAX];   // Modem task only (PARAM and OTA replies)
+
+static portMUX_TYPE cmd_mux = portMUX_INITIALIZER_UNLOCKED;
+static cmd_link_cb_t link_cb = NULL;
+static void *link_ctx = NULL;
+static int64_t last_rx_us = 0;              // Under cmd_mux (modem task writes, esp_timer task reads)
+static volatile bool link_up = true;        // Changed under cmd_mux
+static cmd_stats_t stats;
+
+// --- HELPER FUNCTIONS ---
+
+static bool mission_underway(mission_state_t s) {
+    return s == MISSION_DISPATCH || s == MISSION_COURSE_LOCK || s == MISSION_FINE_APPROACH;
+}
+
+static void notify_link(bool up) {
+    portENTER_CRITICAL(&cmd_mux);
+    cmd_link_cb_t cb = link_cb;
+    void *ctx = link_ctx;
+    portEXIT_CRITICAL(&cmd_mux);
+
+    if (cb != NULL) cb(up, ctx);
+}
+
+static void emergency_stop(const cmd_t *cmd) {
+    ctrl_heading_stop();
+    motor_stop_all();
+
+    uint32_t latency = (uint32_t)(esp_timer_get_time() - cmd->rx_time_us);
+    stats.stop_latency_last_us = latency;
+    if (latency > stats.stop_latency_max_us) stats.stop_latency_max_us = latency;
+    stats.emergency++;
+
+    if (cmd->type == CMD_ABORT) mission_set_state(MISSION_STANDBY);
+    ESP_LOGW(TAG, "%s executed in %lu us", cmd->type == CMD_ABORT ? "ABORT" : "STOP", (unsigned long)latency);
+}
+
+static bool is_param(cmd_type_t type) {
+    return type == CMD_PARAM_GET || type == CMD_PARAM_SET || type == CMD_PARAM_RESET;
+}
+
+static void handle_param(const cmd_t *cmd) {
+    size_t len = 0;
+
+    if (cmd->type == CMD_PARAM_RESET) {
+        esp_err_t err = sysparam_reset();
+        len = (size_t)snprintf(param_reply, sizeof(param_reply), "RESET %s", esp_err_to_name(err));
+    } else if (cmd->type == CMD_PARAM_SET) {
+        esp_err_t err = sysparam_set((sysparam_id_t)cmd->param_id, cmd->param_value);
+        if (err == ESP_ERR_INVALID_ARG) {
+            const sysparam_desc_t *d = sysparam_desc((sysparam_id_t)cmd->param_id);
+            len = (size_t)snprintf(param_reply, sizeof(param_reply), "ERR %s range %g..%g",
+                                   d->name, (double)d->min, (double)d->max);
+        } else {
+            len = sysparam_format((sysparam_id_t)cmd->param_id, param_reply, sizeof(param_reply));
+            if (err != ESP_OK) ESP_LOGW(TAG, "Parameter not persisted: %s", esp_err_to_name(err));
+            else ESP_LOGI(TAG, "Set %s", param_reply);
+        }
+    } else if (cmd->param_id < SYSPARAM_COUNT) {
+        len = sysparam_format((sysparam_id_t)cmd->param_id, param_reply, sizeof(param_reply));
+    } else {
+        for (int i = 0; i < SYSPARAM_COUNT; i++) {
+            if (len > 0) param_reply[len++] = '\n';
+            len += sysparam_format((sysparam_id_t)i, param_reply + len, sizeof(param_reply) - len);
+        }
+    }
+
+    if (len > sizeof(param_reply) - 1) len = sizeof(param_reply) - 1;
+    modem_mqtt_publish(SYSPARAM_REPLY_TOPIC, (const uint8_t *)param_reply, len, 1);
+}
+
+static void handle_ota(const cmd_t *cmd) {
+    esp_err_t err = ota_start(cmd->url);
+    int len = snprintf(param_reply, sizeof(param_reply), "%s %s",
+                       err == ESP_OK ? "START" : "REFUSED", err == ESP_OK ? cmd->url : esp_err_to_name(err));
+    if (len > 0) modem_mqtt_publish(OTA_STATUS_TOPIC, (const uint8_t *)param_reply, (size_t)len, 1);
+    ESP_LOGI(TAG, "OTA %s: %s", cmd->url, esp_err_to_name(err));
+}
+
+static void on_mqtt_rx(const char *topic, const uint8_t *payload, size_t len, void *ctx) {
+    if (strcmp(topic, CMD_TOPIC) != 0) return;
+
+    if (!cmd_parse(payload, len, &rx_cmd)) {
+        stats.parse_errors++;
+        return;
+    }
+    rx_cmd.rx_time_us = modem_mqtt_rx_time_us();
+    stats.received++;
+
+    // Emergency path: no queue, no waiting on the application
+    if (cmd_is_emergency(rx_cmd.type)) {
+        emergency_stop(&rx_cmd);
+    }
+
+    // Any valid command proves the link
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&cmd_mux);
+    last_rx_us = now;
+    bool restored = !link_up;
+    link_up = true;
+    portEXIT_CRITICAL(&cmd_mux);
+    if (restored) {
+        ESP_LOGI(TAG, "Link restored");
+        notify_link(true);
+    }
+
+    if (is_param(rx_cmd.type)) {
+        handle_param(&rx_cmd);
+        return;
+    }
+    if (rx_cmd.type == CMD_OTA) {
+        handle_ota(&rx_cmd);
+        return;
+    }
+    if (rx_cmd.type == CMD_HEARTBEAT || cmd_is_emergency(rx_cmd.type)) return;
+
+    BaseType_t ok = (rx_cmd.type == CMD_WAYPOINTS)
+                  ? xQueueSendToBack(cmd_queue, &rx_cmd, 0)
+                  : xQueueSendToFront(cmd_queue, &rx_cmd, 0);
+    if (ok != pdTRUE) {
+        stats.queue_full++;
+        ESP_LOGW(TAG, "Command queue full, type %d dropped", rx_cmd.type);
+    }
+}
+
+static void watchdog_cb(void *arg) {
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&cmd_mux);
+    int64_t silent_ms = (now - last_rx_us) / 1000;
+    bool lost = link_up && silent_ms >= CMD_LINK_TIMEOUT_MS;
+    if (lost) link_up = false;
+    portEXIT_CRITICAL(&cmd_mux);
+    if (!lost) return;
+
+    stats.link_losses++;
+    ESP_LOGW(TAG, "No command for %lld ms: link lost", (long long)silent_ms);
+
+    if (mission_underway(mission_get_state())) {
+        mission_set_state(MISSION_RTH);
+    }
+    notify_link(false);
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t cmd_init(void) {
+    if (cmd_queue != NULL) return ESP_OK;
+
+    cmd_queue = mem_queue_create(MEM_SUB_CMD, CMD_QUEUE_LEN, sizeof(cmd_t));
+    if (cmd_queue == NULL) return ESP_ERR_NO_MEM;
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&cmd_mux);
+    last_rx_us = now;
+    portEXIT_CRITICAL(&cmd_mux);
+    modem_mqtt_set_rx_callback(on_mqtt_rx, NULL);
+    if (!modem_mqtt_subscribe(CMD_TOPIC, 1)) return ESP_FAIL;
+
+    const esp_timer_create_args_t args = {
+        .callback = watchdog_cb,
+        .name = "cmd_wd",
+    };
+    esp_err_t err = esp_timer_create(&args, &wd_timer);
+    if (err != ESP_OK) return err;
+    return esp_timer_start_periodic(wd_timer, CMD_WATCHDOG_PERIOD_MS * 1000ULL);
+}
+
+bool cmd_receive(cmd_t *out, uint32_t wait_ms) {
+    if (cmd_queue == NULL || out == NULL) return false;
+    return xQueueReceive(cmd_queue, out, pdMS_TO_TICKS(wait_ms)) == pdTRUE;
+}
+
+void cmd_set_link_callback(cmd_link_cb_t cb, void *ctx) {
+    portENTER_CRITICAL(&cmd_mux);
+    link_ctx = ctx;
+    link_cb = cb;
+    portEXIT_CRITICAL(&cmd_mux);
+}
+
+bool cmd_link_is_up(void) {
+    return link_up;
+}
+
+void cmd_get_stats(cmd_stats_t *out) {
+    if (out == NULL) return;
+    *out = stats;
+}
+
+void cmd_log_stats(void) {
+    cmd_stats_t s = stats;
+    ESP_LOGI(TAG, "rx=%lu err=%lu emergency=%lu qfull=%lu link_losses=%lu | STOP latency last=%lu max=%lu us",
+             (unsigned long)s.received, (unsigned long)s.parse_errors, (unsigned long)s.emergency,
+             (unsigned long)s.queue_full, (unsigned long)s.link_losses,
+             (unsigned long)s.stop_latency_last_us, (unsigned long)s.stop_latency_max_us);
+}
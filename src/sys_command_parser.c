@@ -0,0 +1,147 @@
+/**
+ * @file sys_command_parser.c
+ * @brief Command Message Parser (pure C, no IDF dependencies)
+ */
+
+#include <string.h>
+#include "sys_command.h"
+#include "sys_param.h"
+
+#define CMD_LAT_MAX_E7      900000000L
+#define CMD_LON_MAX_E7      1800000000L
+
+// --- HELPER FUNCTIONS ---
+
+static bool word_is(const uint8_t *p, size_t len, const char *word) {
+    size_t n = strlen(word);
+    return len == n && memcmp(p, word, n) == 0;
+}
+
+/**
+ * @brief Parse a signed decimal integer, advancing *p
+ */
+static bool parse_int(const uint8_t **p, const uint8_t *end, int64_t limit, int32_t *out) {
+    const uint8_t *s = *p;
+    bool neg = false;
+    int64_t v = 0;
+
+    if (s < end && (*s == '-' || *s == '+')) {
+        neg = (*s == '-');
+        s++;
+    }
+    if (s >= end || *s < '0' || *s > '9') return false;
+    while (s < end && *s >= '0' && *s <= '9') {
+        v = v * 10 + (*s - '0');
+        if (v > limit) return false;
+        s++;
+    }
+    *out = (int32_t)(neg ? -v : v);
+    *p = s;
+    return true;
+}
+
+static bool parse_waypoints(const uint8_t *p, const uint8_t *end, cmd_t *out) {
+    out->wp_count = 0;
+    while (p < end) {
+        if (out->wp_count >= CMD_MAX_WAYPOINTS) return false;
+        int32_t lat, lon;
+        if (!parse_int(&p, end, CMD_LAT_MAX_E7, &lat)) return false;
+        if (p >= end || *p++ != ',') return false;
+        if (!parse_int(&p, end, CMD_LON_MAX_E7, &lon)) return false;
+
+        out->lat_e7[out->wp_count] = lat;
+        out->lon_e7[out->wp_count] = lon;
+        out->wp_count++;
+
+        if (p < end && *p != ';') return false;
+        if (p < end) p++;
+    }
+    return out->wp_count > 0;
+}
+
+/**
+ * @brief "GET [name]" / "SET name value" / "RESET"
+ */
+static bool parse_param(const uint8_t *p, const uint8_t *end, cmd_t *out) {
+    size_t len = (size_t)(end - p);
+    out->param_id = SYSPARAM_COUNT;
+
+    if (word_is(p, len, "RESET")) { out->type = CMD_PARAM_RESET; return true; }
+    if (word_is(p, len, "GET"))   { out->type = CMD_PARAM_GET;   return true; }
+
+    bool set;
+    if (len > 4 && memcmp(p, "GET ", 4) == 0)      set = false;
+    else if (len > 4 && memcmp(p, "SET ", 4) == 0) set = true;
+    else return false;
+    p += 4;
+
+    const uint8_t *name = p;
+    while (p < end && *p != ' ') p++;
+    sysparam_id_t id = sysparam_find((const char *)name, (size_t)(p - name));
+    if (id == SYSPARAM_COUNT) return false;
+    out->param_id = (uint8_t)id;
+
+    if (!set) {
+        if (p != end) return false;
+        out->type = CMD_PARAM_GET;
+        return true;
+    }
+    if (p >= end) return false;
+    p++;
+    if (!sysparam_parse(id, (const char *)p, (size_t)(end - p), &out->param_value)) return false;
+    out->type = CMD_PARAM_SET;
+    return true;
+}
+
+/**
+ * @brief "OTA <url>": one printable token, no spaces
+ */
+static bool parse_url(const uint8_t *p, const uint8_t *end, cmd_t *out) {
+    size_t len = (size_t)(end - p);
+    if (len == 0 || len >= CMD_URL_MAX) return false;
+    for (size_t i = 0; i < len; i++) {
+        if (p[i] <= ' ' || p[i] > '~') return false;
+    }
+    memcpy(out->url, p, len);
+    out->url[len] = '\0';
+    out->type = CMD_OTA;
+    return true;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+bool cmd_is_emergency(cmd_type_t type) {
+    return type == CMD_STOP || type == CMD_ABORT;
+}
+
+bool cmd_parse(const uint8_t *data, size_t len, cmd_t *out) {
+    out->type = CMD_NONE;
+    out->wp_count = 0;
+
+    // Trim trailing whitespace (terminal clients append CR/LF)
+    while (len > 0 && (data[len - 1] == '\r' || data[len - 1] == '\n' || data[len - 1] == ' ')) len--;
+    if (len == 0) return false;
+
+    // Emergency commands first: decided on the first bytes, nothing else parsed
+    if (word_is(data, len, "STOP"))  { out->type = CMD_STOP;  return true; }
+    if (word_is(data, len, "ABORT")) { out->type = CMD_ABORT; return true; }
+
+    if (word_is(data, len, "HB"))    { out->type = CMD_HEARTBEAT; return true; }
+    if (word_is(data, len, "RTH"))   { out->type = CMD_RTH;   return true; }
+    if (word_is(data, len, "WAKE"))  { out->type = CMD_WAKE;  return true; }
+
+    if (len > 3 && memcmp(data, "WP ", 3) == 0) {
+        if (!parse_waypoints(data + 3, data + len, out)) return false;
+        out->type = CMD_WAYPOINTS;
+        return true;
+    }
+
+    if (len > 6 && memcmp(data, "PARAM ", 6) == 0) {
+        return parse_param(data + 6, data + len, out);
+    }
+
+    if (len > 4 && memcmp(data, "OTA ", 4) == 0) {
+        return parse_url(data + 4, data + len, out);
+    }
+    return false;
+}
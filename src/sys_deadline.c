@@ -0,0 +1,185 @@
+/**
+ * @file sys_deadline.c
+ * @brief Deadline Monitor (registration, esp_timer clock, hung poll)
+ * @details
+ * Trackers live in a static table indexed by dl_id_t; begin/end take the
+ * low word of esp_timer_get_time() and update the tracker under one
+ * spinlock. Escalation callbacks run after the lock is released. The hung
+ * poll is an esp_timer that only runs while a task with an escalation
+ * callback is started (count-only tasks such as telemetry see their late
+ * iteration at dl_end()), so standby is not woken every DL_POLL_PERIOD_MS.
+ */
+
+#include "sys_deadline.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "DEADLINE";
+
+// PRIVATE STATIC VARIABLES
+static dl_track_t tracks[DL_MAX_TASKS];
+static bool active[DL_MAX_TASKS];
+static uint8_t track_count = 0;
+static uint8_t polled_count = 0;           // Started tasks with an escalation callback
+static esp_timer_handle_t poll_timer = NULL;
+
+static portMUX_TYPE dl_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// --- HELPER FUNCTIONS ---
+
+static void notify(dl_id_t id, bool escalated, bool hung) {
+    const dl_config_t *cfg = &tracks[id].cfg;
+    if (escalated) {
+        ESP_LOGW(TAG, "%s: %s, escalating", cfg->name, hung ? "iteration hung" : "repeated deadline misses");
+    } else {
+        ESP_LOGI(TAG, "%s: back on time, escalation cleared", cfg->name);
+    }
+    if (cfg->on_escalate != NULL) cfg->on_escalate(id, escalated, cfg->ctx);
+}
+
+static void poll_cb(void *arg) {
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    for (dl_id_t id = 0; id < track_count; id++) {
+        if (tracks[id].cfg.on_escalate == NULL) continue;
+        portENTER_CRITICAL(&dl_mux);
+        bool hung = active[id] && dl_track_poll(&tracks[id], now);
+        portEXIT_CRITICAL(&dl_mux);
+        if (hung) notify(id, true, true);
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t dl_register(const dl_config_t *cfg, dl_id_t *out) {
+    if (cfg == NULL || out == NULL || cfg->period_us == 0 || cfg->budget_us > cfg->period_us ||
+        cfg->period_us > INT32_MAX / DL_HUNG_PERIODS) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (poll_timer == NULL) {
+        const esp_timer_create_args_t args = {
+            .callback = poll_cb,
+            .name = "dl_poll",
+            .skip_unhandled_events = true,
+        };
+        esp_err_t err = esp_timer_create(&args, &poll_timer);
+        if (err != ESP_OK) return err;
+    }
+
+    portENTER_CRITICAL(&dl_mux);
+    if (track_count >= DL_MAX_TASKS) {
+        portEXIT_CRITICAL(&dl_mux);
+        return ESP_ERR_NO_MEM;
+    }
+    dl_id_t id = track_count;
+    dl_track_init(&tracks[id], cfg);
+    active[id] = false;
+    track_count++;
+    portEXIT_CRITICAL(&dl_mux);
+
+    *out = id;
+    ESP_LOGI(TAG, "%s: period %lu us, budget %lu us", cfg->name, (unsigned long)cfg->period_us,
+             (unsigned long)cfg->budget_us);
+    return ESP_OK;
+}
+
+void dl_start(dl_id_t id) {
+    if (id >= track_count) return;
+
+    bool polled = tracks[id].cfg.on_escalate != NULL;
+    portENTER_CRITICAL(&dl_mux);
+    bool first = polled && !active[id] && polled_count++ == 0;
+    dl_track_restart(&tracks[id]);
+    active[id] = true;
+    portEXIT_CRITICAL(&dl_mux);
+
+    if (first) esp_timer_start_periodic(poll_timer, DL_POLL_PERIOD_MS * 1000ULL);
+}
+
+void dl_stop(dl_id_t id) {
+    if (id >= track_count) return;
+
+    bool polled = tracks[id].cfg.on_escalate != NULL;
+    portENTER_CRITICAL(&dl_mux);
+    bool last = polled && active[id] && --polled_count == 0;
+    active[id] = false;
+    tracks[id].in_iteration = false;
+    portEXIT_CRITICAL(&dl_mux);
+
+    if (last) esp_timer_stop(poll_timer);
+}
+
+void dl_begin(dl_id_t id) {
+    if (id >= track_count) return;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&dl_mux);
+    if (active[id]) dl_track_begin(&tracks[id], now);
+    portEXIT_CRITICAL(&dl_mux);
+}
+
+void dl_end(dl_id_t id) {
+    if (id >= track_count) return;
+    uint32_t now = (uint32_t)esp_timer_get_time();
+
+    portENTER_CRITICAL(&dl_mux);
+    bool changed = active[id] && dl_track_end(&tracks[id], now);
+    bool escalated = tracks[id].stats.escalated;
+    portEXIT_CRITICAL(&dl_mux);
+
+    if (changed) notify(id, escalated, false);
+}
+
+bool dl_is_escalated(dl_id_t id) {
+    if (id >= track_count) return false;
+    return tracks[id].stats.escalated;
+}
+
+void dl_get_stats(dl_id_t id, dl_stats_t *out) {
+    if (id >= track_count || out == NULL) return;
+    portENTER_CRITICAL(&dl_mux);
+    *out = tracks[id].stats;
+    portEXIT_CRITICAL(&dl_mux);
+}
+
+uint32_t dl_measure_cost(void) {
+    static const dl_config_t cfg = { .name = "bench", .period_us = 1000000, .budget_us = 1000000 };
+    dl_track_t scratch;
+    dl_track_init(&scratch, &cfg);
+
+    // Same work as dl_begin() + dl_end(), on a tracker nobody else sees
+    uint32_t t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < DL_BENCH_CALLS; i++) {
+        uint32_t now = (uint32_t)esp_timer_get_time();
+        portENTER_CRITICAL(&dl_mux);
+        dl_track_begin(&scratch, now);
+        portEXIT_CRITICAL(&dl_mux);
+
+        now = (uint32_t)esp_timer_get_time();
+        portENTER_CRITICAL(&dl_mux);
+        dl_track_end(&scratch, now);
+        portEXIT_CRITICAL(&dl_mux);
+    }
+    uint32_t t1 = esp_cpu_get_cycle_count();
+    return (t1 - t0) / DL_BENCH_CALLS;
+}
+
+void dl_log_stats(void) {
+    for (dl_id_t id = 0; id < track_count; id++) {
+        dl_stats_t s;
+        dl_get_stats(id, &s);
+        const dl_config_t *cfg = &tracks[id].cfg;
+
+        ESP_LOGI(TAG, "%-10s %lu it | WCET %lu / %lu us (last %lu) | overruns %lu, misses %lu, skipped %lu"
+                 " | late max %lu us", cfg->name, (unsigned long)s.iterations, (unsigned long)s.exec_max_us,
+                 (unsigned long)cfg->budget_us, (unsigned long)s.exec_last_us, (unsigned long)s.overruns,
+                 (unsigned long)s.misses, (unsigned long)s.skipped, (unsigned long)s.start_late_max_us);
+        if (s.escalations > 0 || s.escalated) {
+            ESP_LOGW(TAG, "%-10s escalations %lu (hung %lu)%s", cfg->name, (unsigned long)s.escalations,
+                     (unsigned long)s.hung, s.escalated ? ", ESCALATED now" : "");
+        }
+    }
+}
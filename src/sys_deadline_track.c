@@ -0,0 +1,119 @@
+/**
+ * @file sys_deadline_track.c
+ * @brief Deadline Tracker (pure C, no IDF dependencies)
+ * @details
+ * Timestamps are 32-bit microseconds; every comparison is a signed
+ * difference, so the ~71 min wrap of the low word is harmless. The miss
+ * history is a shift register: the window count is updated with the bit
+ * entering and the bit leaving, O(1) per iteration.
+ */
+
+#include <string.h>
+#include "sys_deadline.h"
+
+_Static_assert(DL_WINDOW >= 1 && DL_WINDOW <= 64, "DL_WINDOW must fit the 64-bit history");
+_Static_assert(DL_WINDOW_MISSES <= DL_WINDOW, "DL_WINDOW_MISSES larger than the window");
+_Static_assert(DL_ESCALATE_CONSECUTIVE < 255 && DL_RECOVER_CLEAN < 255, "counters are 8-bit");
+
+#define DL_WINDOW_MASK  (DL_WINDOW == 64 ? ~0ULL : (1ULL << DL_WINDOW) - 1)
+
+// --- HELPER FUNCTIONS ---
+
+static void escalate(dl_track_t *t) {
+    t->stats.escalated = true;
+    t->stats.escalations++;
+    t->clean = 0;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void dl_track_init(dl_track_t *t, const dl_config_t *cfg) {
+    memset(t, 0, sizeof(*t));
+    t->cfg = *cfg;
+}
+
+void dl_track_restart(dl_track_t *t) {
+    bool escalated = t->stats.escalated;
+    uint32_t escalations = t->stats.escalations;
+
+    memset(&t->stats, 0, sizeof(t->stats));
+    t->stats.escalated = escalated;
+    t->stats.escalations = escalations;
+    t->history = 0;
+    t->has_release = false;
+    t->in_iteration = false;
+}
+
+void dl_track_begin(dl_track_t *t, uint32_t now_us) {
+    if (!t->has_release) {
+        t->release_us = now_us;         // First iteration defines the phase
+        t->has_release = true;
+    }
+
+    int32_t late = (int32_t)(now_us - t->release_us);
+    if (late >= (int32_t)t->cfg.period_us) {
+        // Woke a whole period (or more) late: those releases are lost
+        uint32_t skip = (uint32_t)late / t->cfg.period_us;
+        t->stats.skipped += skip;
+        t->release_us += skip * t->cfg.period_us;
+        late -= (int32_t)(skip * t->cfg.period_us);
+    }
+    if (late > 0 && (uint32_t)late > t->stats.start_late_max_us) t->stats.start_late_max_us = (uint32_t)late;
+
+    t->start_us = now_us;
+    t->in_iteration = true;
+}
+
+bool dl_track_end(dl_track_t *t, uint32_t now_us) {
+    if (!t->in_iteration) return false;
+    t->in_iteration = false;
+
+    uint32_t exec = now_us - t->start_us;
+    bool miss = (int32_t)(now_us - (t->release_us + t->cfg.period_us)) > 0;
+
+    t->stats.iterations++;
+    t->stats.exec_last_us = exec;
+    if (exec > t->stats.exec_max_us) t->stats.exec_max_us = exec;
+    if (exec > t->cfg.budget_us) t->stats.overruns++;
+    t->release_us += t->cfg.period_us;
+
+    // Sliding window: bit entering minus bit leaving
+    uint8_t leaving = (uint8_t)((t->history >> (DL_WINDOW - 1)) & 1);
+    t->history = ((t->history << 1) | miss) & DL_WINDOW_MASK;
+    t->stats.window_misses = (uint8_t)(t->stats.window_misses + miss - leaving);
+
+    if (miss) {
+        t->stats.misses++;
+        if (t->stats.consecutive < 255) t->stats.consecutive++;
+    } else {
+        t->stats.consecutive = 0;
+    }
+
+    if (!t->stats.escalated) {
+        if (t->stats.consecutive >= DL_ESCALATE_CONSECUTIVE || t->stats.window_misses >= DL_WINDOW_MISSES) {
+            escalate(t);
+            return true;
+        }
+        return false;
+    }
+
+    // Escalated: recover after a clean run (window cleared, or it would re-trip)
+    t->clean = miss ? 0 : (uint8_t)(t->clean + 1);
+    if (t->clean >= DL_RECOVER_CLEAN) {
+        t->stats.escalated = false;
+        t->stats.window_misses = 0;
+        t->history = 0;
+        t->clean = 0;
+        return true;
+    }
+    return false;
+}
+
+bool dl_track_poll(dl_track_t *t, uint32_t now_us) {
+    if (!t->in_iteration || t->stats.escalated) return false;
+    if ((int32_t)(now_us - t->start_us) < (int32_t)(DL_HUNG_PERIODS * t->cfg.period_us)) return false;
+
+    t->stats.hung++;
+    escalate(t);
+    return true;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file sys_dlog.c
+ * @brief Deferred Binary Logging Implementation (per-core rings, drain task)
+ * @details
+ * dlog_write() copies words only: no vsnprintf, no console lock, no UART
+ * wait. The caller's core selects the ring; interrupts on that core are
+ * masked while the entry is reserved and copied (~20 words), which also
+ * covers a DLOG from an ISR preempting a task on the same core. The dlog
+ * task is the only consumer of both rings.
+ */
+
+#include <stdio.h>
+#include "sys_dlog.h"
+#include "sys_mem.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "DLOG";
+
+_Static_assert(MEM_TASK_BYTES(DLOG_TASK_STACK) <= MEM_BUDGET_DLOG,
+               "dlog_task over the MEM_BUDGET_TABLE entry");
+
+#define DLOG_BENCH_MSG          "Status: %.2fV (%.1f%%) raw %d"
+
+// PRIVATE STATIC VARIABLES
+static uint32_t ring_buf[DLOG_CORES][DLOG_RING_WORDS];
+static dlog_ring_t rings[DLOG_CORES] = {
+    { .buf = ring_buf[0], .size = DLOG_RING_WORDS },
+    { .buf = ring_buf[1], .size = DLOG_RING_WORDS },
+};
+
+static dlog_sink_fn_t sink_fn = NULL;
+static void *sink_ctx = NULL;
+static TaskHandle_t task_handle = NULL;
+
+// Per core, written under the core's interrupt mask
+static uint32_t written[DLOG_CORES];
+static uint32_t dropped[DLOG_CORES];
+static uint32_t ring_peak[DLOG_CORES];
+
+static uint32_t frames = 0;
+static uint32_t dlog_cycles = 0;
+static uint32_t esplog_cycles = 0;
+
+// --- HELPER FUNCTIONS ---
+
+static void console_sink(const uint8_t *frame, size_t len, void *ctx) {
+    fwrite(frame, 1, len, stdout);
+}
+
+static void dlog_task(void *arg) {
+    uint32_t w[DLOG_ENTRY_MAX_WORDS];
+    uint8_t frame[DLOG_FRAME_MAX];
+
+    while (1) {
+        bool any = false;
+        for (int core = 0; core < DLOG_CORES; core++) {
+            size_t n;
+            while ((n = dlog_ring_get(&rings[core], w)) > 0) {
+                size_t len = dlog_frame((uint8_t)core, w, n, frame);
+                dlog_sink_fn_t fn = sink_fn;
+                if (fn != NULL) fn(frame, len, sink_ctx);
+                frames++;
+                any = true;
+            }
+        }
+        if (any && sink_fn == console_sink) fflush(stdout);
+        vTaskDelay(pdMS_TO_TICKS(DLOG_DRAIN_MS));
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void dlog_write(uint32_t meta, const char *tag, const char *fmt, ...) {
+    uint32_t w[DLOG_ENTRY_MAX_WORDS];
+    va_list ap;
+
+    va_start(ap, fmt);
+    size_t n = dlog_encode(w, meta, tag, fmt, (uint32_t)esp_timer_get_time(), ap);
+    va_end(ap);
+
+    UBaseType_t irq = portSET_INTERRUPT_MASK_FROM_ISR();
+    int core = esp_cpu_get_core_id();
+    dlog_ring_t *r = &rings[core];
+
+    if (dlog_ring_put(r, w, n)) written[core]++;
+    else dropped[core]++;
+
+    uint32_t used = r->head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if (used > ring_peak[core]) ring_peak[core] = used;
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(irq);
+}
+
+esp_err_t dlog_init(void) {
+    if (task_handle != NULL) return ESP_OK;
+
+    if (sink_fn == NULL) sink_fn = console_sink;
+    task_handle = mem_task_create(MEM_SUB_DLOG, dlog_task, "dlog_task", DLOG_TASK_STACK, NULL,
+                                  DLOG_TASK_PRIORITY, DLOG_TASK_CORE);
+    if (task_handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    ESP_LOGI(TAG, "Deferred log: %u words/core, decode with tools/dlog_decode.py", (unsigned)DLOG_RING_WORDS);
+    return ESP_OK;
+}
+
+void dlog_set_sink(dlog_sink_fn_t sink, void *ctx) {
+    sink_ctx = ctx;
+    sink_fn = sink ? sink : console_sink;
+}
+
+void dlog_measure_cost(void) {
+    float volts = 7.84f;
+    float pct = 61.5f;
+    int raw = 2731;
+    uint32_t t0, t1;
+
+    // Warm the caches for both paths first
+    DLOGI(TAG, DLOG_BENCH_MSG, volts, pct, raw);
+    ESP_LOGI(TAG, DLOG_BENCH_MSG, volts, pct, raw);
+
+    t0 = esp_cpu_get_cycle_count();
+    DLOGI(TAG, DLOG_BENCH_MSG, volts, pct, raw);
+    t1 = esp_cpu_get_cycle_count();
+    dlog_cycles = t1 - t0;
+
+    t0 = esp_cpu_get_cycle_count();
+    ESP_LOGI(TAG, DLOG_BENCH_MSG, volts, pct, raw);
+    t1 = esp_cpu_get_cycle_count();
+    esplog_cycles = t1 - t0;
+}
+
+void dlog_get_stats(dlog_stats_t *out) {
+    if (out == NULL) return;
+
+    for (int core = 0; core < DLOG_CORES; core++) {
+        out->written[core] = written[core];
+        out->dropped[core] = dropped[core];
+        out->ring_peak[core] = ring_peak[core];
+    }
+    out->frames = frames;
+    out->dlog_cycles = dlog_cycles;
+    out->esplog_cycles = esplog_cycles;
+}
+
+void dlog_log_stats(void) {
+    dlog_stats_t s;
+    dlog_get_stats(&s);
+
+    ESP_LOGI(TAG, "Entries core0 %lu (dropped %lu, peak %lu/%u) | core1 %lu (dropped %lu, peak %lu/%u) | frames %lu",
+             (unsigned long)s.written[0], (unsigned long)s.dropped[0], (unsigned long)s.ring_peak[0], (unsigned)DLOG_RING_WORDS,
+             (unsigned long)s.written[1], (unsigned long)s.dropped[1], (unsigned long)s.ring_peak[1], (unsigned)DLOG_RING_WORDS,
+             (unsigned long)s.frames);
+    if (s.dlog_cycles > 0) {
+        ESP_LOGI(TAG, "Call cost: DLOGI %lu cycles, ESP_LOGI %lu cycles (same message)",
+                 (unsigned long)s.dlog_cycles, (unsigned long)s.esplog_cycles);
+    }
+}
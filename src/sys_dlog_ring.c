@@ -0,0 +1,111 @@
+/**
+ * @file sys_dlog_ring.c
+ * @brief Deferred Log Entry Encoding, Word Ring and Frame Encoding (pure C, no IDF dependencies)
+ */
+
+#include <string.h>
+#include "sys_dlog.h"
+
+#define META_DROP_SHIFT         24
+#define META_DROP_MAX           255
+#define META_KEEP               0x00FFFFFFu
+
+_Static_assert(DLOG_ENTRY_MAX_WORDS <= 255, "frame length is one byte");
+_Static_assert((DLOG_RING_WORDS & (DLOG_RING_WORDS - 1)) == 0, "ring size must be a power of 2");
+
+// --- PUBLIC FUNCTIONS ---
+
+size_t dlog_encode(uint32_t *w, uint32_t meta, const char *tag, const char *fmt, uint32_t time_us, va_list ap) {
+    uint32_t nargs = (meta >> 16) & 0x0F;
+    size_t n = DLOG_HDR_WORDS;
+
+    w[0] = (uint32_t)(uintptr_t)fmt;
+    w[1] = (uint32_t)(uintptr_t)tag;
+    w[2] = time_us;
+    w[3] = meta & META_KEEP;
+
+    for (uint32_t i = 0; i < nargs && i < DLOG_MAX_ARGS; i++) {
+        switch ((meta >> (2 * i)) & 3) {
+            case DLOG_T_FLOAT: {
+                float f = (float)va_arg(ap, double);
+                memcpy(&w[n++], &f, sizeof(f));
+                break;
+            }
+            case DLOG_T_STR:
+                w[n++] = (uint32_t)(uintptr_t)va_arg(ap, const char *);
+                break;
+            case DLOG_T_INT64: {
+                uint64_t v = va_arg(ap, unsigned long long);
+                w[n++] = (uint32_t)v;
+                w[n++] = (uint32_t)(v >> 32);
+                break;
+            }
+            default:
+                w[n++] = va_arg(ap, unsigned int);
+                break;
+        }
+    }
+    return n;
+}
+
+void dlog_ring_init(dlog_ring_t *r, uint32_t *buf, uint32_t size_words) {
+    r->buf = buf;
+    r->size = size_words;
+    r->head = 0;
+    r->tail = 0;
+    r->dropped = 0;
+}
+
+bool dlog_ring_put(dlog_ring_t *r, uint32_t *w, size_t n) {
+    uint32_t head = r->head;
+    uint32_t tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+    if (r->size - (head - tail) < n + 1) {
+        r->dropped++;
+        return false;
+    }
+
+    uint32_t drops = r->dropped > META_DROP_MAX ? META_DROP_MAX : r->dropped;
+    w[3] = (w[3] & META_KEEP) | (drops << META_DROP_SHIFT);
+    r->dropped = 0;
+
+    // Length word, then the entry
+    uint32_t mask = r->size - 1;
+    r->buf[head & mask] = (uint32_t)n;
+    for (size_t i = 0; i < n; i++) r->buf[(head + 1 + i) & mask] = w[i];
+
+    __atomic_store_n(&r->head, head + 1 + (uint32_t)n, __ATOMIC_RELEASE);
+    return true;
+}
+
+size_t dlog_ring_get(dlog_ring_t *r, uint32_t *w) {
+    uint32_t tail = r->tail;
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    if (head == tail) return 0;
+
+    uint32_t mask = r->size - 1;
+    size_t n = r->buf[tail & mask];
+    if (n > DLOG_ENTRY_MAX_WORDS) n = DLOG_ENTRY_MAX_WORDS;
+    for (size_t i = 0; i < n; i++) w[i] = r->buf[(tail + 1 + i) & mask];
+
+    __atomic_store_n(&r->tail, tail + 1 + r->buf[tail & mask], __ATOMIC_RELEASE);
+    return n;
+}
+
+size_t dlog_frame(uint8_t core, const uint32_t *w, size_t n, uint8_t *out) {
+    uint8_t *p = out;
+    *p++ = DLOG_SYNC0;
+    *p++ = DLOG_SYNC1;
+    *p++ = core;
+    *p++ = (uint8_t)n;
+    for (size_t i = 0; i < n; i++) {
+        *p++ = (uint8_t)w[i];
+        *p++ = (uint8_t)(w[i] >> 8);
+        *p++ = (uint8_t)(w[i] >> 16);
+        *p++ = (uint8_t)(w[i] >> 24);
+    }
+
+    uint8_t x = 0;
+    for (uint8_t *q = out + 2; q < p; q++) x ^= *q;
+    *p++ = x;
+    return (size_t)(p - out);
+}
@@ -0,0 +1,216 @@
+/**
+ * @file sys_flashlog.c
+ * @brief Store-and-Forward Log Task (partition binding, staging, drain)
+ * @details
+ * Producers copy records into a no-split RAM ring buffer and return. The
+ * flashlog task (lowest application priority) writes them to flash and,
+ * every FLOG_DRAIN_INTERVAL_MS, offers the oldest stored record to the
+ * drain hook. The record is consumed when the sender confirms it
+ * (flashlog_drain_done), never on hand-over. Sector erases run in this task only; with
+ * CONFIG_SPI_FLASH_YIELD_DURING_ERASE the erase is split into 20ms slices
+ * so higher priority tasks keep running in between.
+ */
+
+#include "sys_flashlog.h"
+#include "sys_mem.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/ringbuf.h"
+
+static const char *TAG = "FLASHLOG";
+
+_Static_assert(MEM_TASK_BYTES(FLOG_TASK_STACK) + MEM_ALIGN_UP(FLOG_STAGING_BYTES) +
+               MEM_ALIGN_UP(sizeof(StaticRingbuffer_t)) <= MEM_BUDGET_FLOG,
+               "flashlog_task and staging ring over the MEM_BUDGET_TABLE entry");
+
+/**
+ * @brief Record handed to the drain hook
+ */
+typedef enum {
+    DRAIN_IDLE = 0,
+    DRAIN_SENT,                 // Waiting for flashlog_drain_done()
+    DRAIN_ACKED,
+    DRAIN_NACKED,
+} drain_state_t;
+
+// PRIVATE STATIC VARIABLES
+static const esp_partition_t *partition = NULL;
+static flog_t flog;
+static RingbufHandle_t staging = NULL;
+static uint8_t drain_buf[FLOG_MAX_RECORD];
+
+static portMUX_TYPE flog_mux = portMUX_INITIALIZER_UNLOCKED;
+static flog_send_fn_t drain_fn = NULL;
+static void *drain_ctx = NULL;
+static volatile uint32_t staged = 0;
+static uint32_t staging_full = 0;
+static volatile drain_state_t drain_state = DRAIN_IDLE;
+static int64_t drain_sent_us = 0;
+static uint32_t drain_retries = 0;      // Failed or unanswered sends
+
+// --- HELPER FUNCTIONS ---
+
+static bool part_read(void *ctx, uint32_t addr, void *buf, size_t len) {
+    return esp_partition_read(partition, addr, buf, len) == ESP_OK;
+}
+
+static bool part_write(void *ctx, uint32_t addr, const void *buf, size_t len) {
+    return esp_partition_write(partition, addr, buf, len) == ESP_OK;
+}
+
+static bool part_erase(void *ctx, uint32_t addr, size_t len) {
+    return esp_partition_erase_range(partition, addr, len) == ESP_OK;
+}
+
+static void drain_one(int64_t now_us) {
+    portENTER_CRITICAL(&flog_mux);
+    flog_send_fn_t fn = drain_fn;
+    void *ctx = drain_ctx;
+    drain_state_t state = drain_state;
+    if (state == DRAIN_SENT && now_us - drain_sent_us >= FLOG_ACK_TIMEOUT_MS * 1000LL) {
+        state = DRAIN_NACKED;       // Never answered: treat as failed
+    }
+    if (state != DRAIN_SENT) drain_state = DRAIN_IDLE;
+    portEXIT_CRITICAL(&flog_mux);
+
+    if (state == DRAIN_SENT) return;            // Still in flight
+    if (state == DRAIN_NACKED) {
+        drain_retries++;
+        return;                                 // Same record next interval
+    }
+    if (state == DRAIN_ACKED) flog_consume(&flog);  // No-op if a full ring dropped it meanwhile
+
+    if (fn == NULL || flog.pending == 0) return;
+
+    size_t len = flog_peek(&flog, drain_buf, sizeof(drain_buf));
+    if (len == 0) return;
+
+    portENTER_CRITICAL(&flog_mux);
+    drain_state = DRAIN_SENT;       // Before the hook: it may confirm synchronously
+    drain_sent_us = now_us;
+    portEXIT_CRITICAL(&flog_mux);
+
+    if (!fn(drain_buf, len, ctx)) {
+        portENTER_CRITICAL(&flog_mux);
+        drain_state = DRAIN_IDLE;
+        portEXIT_CRITICAL(&flog_mux);
+    }
+}
+
+static void flashlog_task(void *arg) {
+    int64_t next_drain_us = esp_timer_get_time();
+
+    while (1) {
+        size_t size;
+        void *item = xRingbufferReceive(staging, &size, pdMS_TO_TICKS(FLOG_DRAIN_INTERVAL_MS));
+        if (item != NULL) {
+            if (!flog_append(&flog, item, size)) {
+                ESP_LOGW(TAG, "Append failed (%u bytes)", (unsigned)size);
+            }
+            vRingbufferReturnItem(staging, item);
+            portENTER_CRITICAL(&flog_mux);
+            staged--;
+            portEXIT_CRITICAL(&flog_mux);
+        }
+
+        int64_t now = esp_timer_get_time();
+        if (now >= next_drain_us) {
+            next_drain_us = now + FLOG_DRAIN_INTERVAL_MS * 1000LL;
+            drain_one(now);
+        }
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t flashlog_init(void) {
+    if (staging != NULL) return ESP_OK;
+
+    partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, FLOG_PARTITION_LABEL);
+    if (partition == NULL) {
+        ESP_LOGE(TAG, "Partition '%s' not found", FLOG_PARTITION_LABEL);
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    flog_flash_t io = {
+        .read = part_read,
+        .write = part_write,
+        .erase = part_erase,
+        .ctx = NULL,
+        .size = partition->size,
+    };
+    int64_t t0 = esp_timer_get_time();
+    if (!flog_mount(&flog, &io)) {
+        ESP_LOGE(TAG, "Mount failed");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Mounted %u sectors in %lu us: %lu records pending, %lu corrupt",
+             flog.sector_count, (unsigned long)(esp_timer_get_time() - t0),
+             (unsigned long)flog.pending, (unsigned long)flog.stats.corrupt);
+
+    StaticRingbuffer_t *rb = mem_alloc(MEM_SUB_FLOG, sizeof(StaticRingbuffer_t));
+    uint8_t *rb_mem = rb ? mem_alloc(MEM_SUB_FLOG, FLOG_STAGING_BYTES) : NULL;
+    if (rb_mem == NULL) return ESP_ERR_NO_MEM;
+    staging = xRingbufferCreateStatic(FLOG_STAGING_BYTES, RINGBUF_TYPE_NOSPLIT, rb_mem, rb);
+
+    if (mem_task_create(MEM_SUB_FLOG, flashlog_task, "flashlog_task", FLOG_TASK_STACK, NULL,
+                        FLOG_TASK_PRIORITY, FLOG_TASK_CORE) == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
+
+bool flashlog_push(const void *data, size_t len) {
+    if (staging == NULL || len == 0 || len > FLOG_MAX_RECORD) return false;
+
+    // Count first: the flashlog task may receive (and decrement) before Send returns
+    portENTER_CRITICAL(&flog_mux);
+    staged++;
+    portEXIT_CRITICAL(&flog_mux);
+
+    if (xRingbufferSend(staging, data, len, 0) != pdTRUE) {
+        portENTER_CRITICAL(&flog_mux);
+        staged--;
+        staging_full++;
+        portEXIT_CRITICAL(&flog_mux);
+        return false;
+    }
+    return true;
+}
+
+void flashlog_set_drain(flog_send_fn_t send, void *ctx) {
+    portENTER_CRITICAL(&flog_mux);
+    drain_ctx = ctx;
+    drain_fn = send;
+    portEXIT_CRITICAL(&flog_mux);
+}
+
+void flashlog_drain_done(bool ok) {
+    portENTER_CRITICAL(&flog_mux);
+    if (drain_state == DRAIN_SENT) drain_state = ok ? DRAIN_ACKED : DRAIN_NACKED;
+    portEXIT_CRITICAL(&flog_mux);
+}
+
+bool flashlog_has_backlog(void) {
+    return staging != NULL && (staged > 0 || flog.pending > 0);
+}
+
+void flashlog_get_stats(flog_stats_t *out, uint32_t *pending) {
+    if (out != NULL) *out = flog.stats;
+    if (pending != NULL) *pending = flog.pending;
+}
+
+void flashlog_log_stats(void) {
+    flog_stats_t s = flog.stats;
+
+    ESP_LOGI(TAG, "pending=%lu staged=%lu | appended=%lu consumed=%lu dropped=%lu corrupt=%lu",
+             (unsigned long)flog.pending, (unsigned long)staged,
+             (unsigned long)s.appended, (unsigned long)s.consumed,
+             (unsigned long)s.dropped, (unsigned long)s.corrupt);
+    ESP_LOGI(TAG, "erases=%lu (%.1f per sector) flash_err=%lu staging_full=%lu drain_retries=%lu",
+             (unsigned long)s.erases, flog.sector_count ? (float)s.erases / flog.sector_count : 0.0f,
+             (unsigned long)s.flash_errors, (unsigned long)staging_full, (unsigned long)drain_retries);
+}
@@ -0,0 +1,297 @@
+/**
+ * @file sys_flashlog_ring.c
+ * @brief Flash Record Ring (pure C, flash access through flog_flash_t)
+ */
+
+#include <string.h>
+#include "sys_flashlog.h"
+
+#define FLOG_STATE_PENDING      0xFF
+#define FLOG_STATE_CONSUMED     0x00
+#define FLOG_ERASED_LEN         0xFFFF
+
+typedef struct {
+    uint32_t magic;
+    uint32_t seq;
+} sector_hdr_t;
+
+typedef struct {
+    uint16_t len;
+    uint16_t crc;
+    uint8_t state;
+    uint8_t pad[3];
+} record_hdr_t;
+
+_Static_assert(sizeof(sector_hdr_t) == FLOG_SECTOR_HDR_BYTES, "sector header size");
+_Static_assert(sizeof(record_hdr_t) == FLOG_RECORD_HDR_BYTES, "record header size");
+
+// --- HELPER FUNCTIONS ---
+
+static inline uint32_t align4(uint32_t n) {
+    return (n + 3u) & ~3u;
+}
+
+static inline uint32_t sector_addr(uint16_t sector) {
+    return (uint32_t)sector * FLOG_SECTOR_SIZE;
+}
+
+static inline uint16_t next_sector(const flog_t *log, uint16_t sector) {
+    return (uint16_t)((sector + 1) % log->sector_count);
+}
+
+/**
+ * @brief CRC-16/CCITT-FALSE
+ */
+static uint16_t crc16(const uint8_t *p, size_t len) {
+    uint16_t crc = 0xFFFF;
+    while (len--) {
+        crc ^= (uint16_t)(*p++) << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static bool flash_read(flog_t *log, uint32_t addr, void *buf, size_t len) {
+    log->stats.reads++;
+    if (log->flash.read(log->flash.ctx, addr, buf, len)) return true;
+    log->stats.flash_errors++;
+    return false;
+}
+
+static bool flash_write(flog_t *log, uint32_t addr, const void *buf, size_t len) {
+    if (log->flash.write(log->flash.ctx, addr, buf, len)) return true;
+    log->stats.flash_errors++;
+    return false;
+}
+
+static bool flash_erase_sector(flog_t *log, uint16_t sector) {
+    log->stats.erases++;
+    if (log->flash.erase(log->flash.ctx, sector_addr(sector), FLOG_SECTOR_SIZE)) return true;
+    log->stats.flash_errors++;
+    return false;
+}
+
+static bool record_hdr_valid(const record_hdr_t *h, uint32_t off) {
+    return h->len != 0 && h->len <= FLOG_MAX_RECORD &&
+           off + FLOG_RECORD_HDR_BYTES + h->len <= FLOG_SECTOR_SIZE;
+}
+
+/**
+ * @brief Walk the records of a sector
+ * @param pending   Output number of pending records from `off` on
+ * @param last_off  Output offset of the last record (UINT32_MAX if none)
+ * @return Offset after the last valid record (FLOG_SECTOR_SIZE if a bad header was hit)
+ */
+static uint32_t walk_sector(flog_t *log, uint16_t sector, uint32_t off, uint32_t *pending, uint32_t *last_off) {
+    record_hdr_t h;
+    *pending = 0;
+    *last_off = UINT32_MAX;
+
+    while (off + FLOG_RECORD_HDR_BYTES <= FLOG_SECTOR_SIZE) {
+        if (!flash_read(log, sector_addr(sector) + off, &h, sizeof(h))) return FLOG_SECTOR_SIZE;
+        if (h.len == FLOG_ERASED_LEN) return off;
+        if (!record_hdr_valid(&h, off)) return FLOG_SECTOR_SIZE;
+
+        if (h.state == FLOG_STATE_PENDING) (*pending)++;
+        *last_off = off;
+        off += FLOG_RECORD_HDR_BYTES + align4(h.len);
+    }
+    return off;
+}
+
+static bool record_crc_ok(flog_t *log, uint16_t sector, uint32_t off) {
+    static uint8_t buf[FLOG_MAX_RECORD];
+    record_hdr_t h;
+
+    if (!flash_read(log, sector_addr(sector) + off, &h, sizeof(h))) return false;
+    if (!flash_read(log, sector_addr(sector) + off + FLOG_RECORD_HDR_BYTES, buf, h.len)) return false;
+    return crc16(buf, h.len) == h.crc;
+}
+
+/**
+ * @brief Make `sector` the head: erase if needed, write its header
+ */
+static bool open_sector(flog_t *log, uint16_t sector) {
+    sector_hdr_t sh;
+
+    if (!flash_read(log, sector_addr(sector), &sh, sizeof(sh))) return false;
+    if (sh.magic != 0xFFFFFFFF || sh.seq != 0xFFFFFFFF) {
+        if (!flash_erase_sector(log, sector)) return false;
+    }
+
+    sh.magic = FLOG_MAGIC;
+    sh.seq = log->next_seq++;
+    log->head_sector = sector;
+    log->head_off = FLOG_SECTOR_SIZE;       // Sealed until the header is written
+    if (!flash_write(log, sector_addr(sector), &sh, sizeof(sh))) return false;
+    log->head_off = FLOG_SECTOR_HDR_BYTES;
+    return true;
+}
+
+/**
+ * @brief Ring full: erase the oldest sector, counting its pending records as dropped
+ */
+static void drop_tail_sector(flog_t *log) {
+    uint32_t pending, last;
+    walk_sector(log, log->tail_sector, log->tail_off, &pending, &last);
+
+    log->stats.dropped += pending;
+    log->pending -= (pending <= log->pending) ? pending : log->pending;
+    flash_erase_sector(log, log->tail_sector);
+    log->tail_sector = next_sector(log, log->tail_sector);
+    log->tail_off = FLOG_SECTOR_HDR_BYTES;
+    log->peek_len = 0;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+bool flog_mount(flog_t *log, const flog_flash_t *flash) {
+    memset(log, 0, sizeof(*log));
+    log->flash = *flash;
+    if (flash->size % FLOG_SECTOR_SIZE != 0 || flash->size / FLOG_SECTOR_SIZE < 2) return false;
+    log->sector_count = (uint16_t)(flash->size / FLOG_SECTOR_SIZE);
+
+    // 1. Sector headers: newest = head, oldest = tail
+    bool any = false;
+    uint32_t min_seq = UINT32_MAX, max_seq = 0;
+    for (uint16_t s = 0; s < log->sector_count; s++) {
+        sector_hdr_t sh;
+        if (!flash_read(log, sector_addr(s), &sh, sizeof(sh))) return false;
+
+        if (sh.magic == FLOG_MAGIC) {
+            any = true;
+            if (sh.seq >= max_seq) { max_seq = sh.seq; log->head_sector = s; }
+            if (sh.seq < min_seq) { min_seq = sh.seq; log->tail_sector = s; }
+        } else if (sh.magic != 0xFFFFFFFF || sh.seq != 0xFFFFFFFF) {
+            // Foreign data or torn header write
+            if (!flash_erase_sector(log, s)) return false;
+        }
+    }
+
+    if (!any) {
+        log->next_seq = 1;
+        log->tail_sector = 0;
+        log->tail_off = FLOG_SECTOR_HDR_BYTES;
+        return open_sector(log, 0);
+    }
+    log->next_seq = max_seq + 1;
+
+    // 2. Head sector: find the write offset. Only the last record can be torn.
+    uint32_t pending, last;
+    log->head_off = walk_sector(log, log->head_sector, FLOG_SECTOR_HDR_BYTES, &pending, &last);
+    if (last != UINT32_MAX && !record_crc_ok(log, log->head_sector, last)) {
+        log->stats.corrupt++;
+        log->head_off = FLOG_SECTOR_SIZE;   // Seal: the torn area is not erased
+    }
+
+    // 3. Pending records, tail to head
+    uint16_t s = log->tail_sector;
+    while (1) {
+        sector_hdr_t sh;
+        if (flash_read(log, sector_addr(s), &sh, sizeof(sh)) && sh.magic == FLOG_MAGIC) {
+            walk_sector(log, s, FLOG_SECTOR_HDR_BYTES, &pending, &last);
+            log->pending += pending;
+        }
+        if (s == log->head_sector) break;
+        s = next_sector(log, s);
+    }
+
+    // 4. Drain from the start of the tail sector (flog_peek skips consumed records)
+    log->tail_off = FLOG_SECTOR_HDR_BYTES;
+    return true;
+}
+
+bool flog_append(flog_t *log, const void *data, size_t len) {
+    if (len == 0 || len > FLOG_MAX_RECORD) return false;
+    uint32_t need = FLOG_RECORD_HDR_BYTES + align4((uint32_t)len);
+
+    if (log->head_off + need > FLOG_SECTOR_SIZE) {
+        uint16_t next = next_sector(log, log->head_sector);
+        if (next == log->tail_sector) drop_tail_sector(log);
+        if (log->tail_sector == log->head_sector && log->tail_off >= log->head_off) {
+            // Everything drained: tail follows the head
+            log->tail_sector = next;
+            log->tail_off = FLOG_SECTOR_HDR_BYTES;
+        }
+        if (!open_sector(log, next)) return false;
+    }
+
+    record_hdr_t h = {
+        .len = (uint16_t)len,
+        .crc = crc16((const uint8_t *)data, len),
+        .state = FLOG_STATE_PENDING,
+        .pad = { 0xFF, 0xFF, 0xFF },
+    };
+    uint32_t addr = sector_addr(log->head_sector) + log->head_off;
+
+    // Header first: a torn payload then fails its CRC
+    if (!flash_write(log, addr, &h, sizeof(h)) ||
+        !flash_write(log, addr + FLOG_RECORD_HDR_BYTES, data, len)) {
+        log->head_off = FLOG_SECTOR_SIZE;
+        return false;
+    }
+
+    log->head_off += need;
+    log->pending++;
+    log->stats.appended++;
+    return true;
+}
+
+size_t flog_peek(flog_t *log, void *buf, size_t cap) {
+    record_hdr_t h;
+    log->peek_len = 0;
+
+    while (1) {
+        bool at_head = (log->tail_sector == log->head_sector);
+        if (at_head && log->tail_off >= log->head_off) return 0;
+
+        uint32_t addr = sector_addr(log->tail_sector) + log->tail_off;
+        bool have = (log->tail_off + FLOG_RECORD_HDR_BYTES <= FLOG_SECTOR_SIZE) &&
+                    flash_read(log, addr, &h, sizeof(h)) &&
+                    h.len != FLOG_ERASED_LEN && record_hdr_valid(&h, log->tail_off);
+
+        if (!have) {
+            // End of this sector
+            if (at_head) return 0;
+            sector_hdr_t sh;
+            if (flash_read(log, sector_addr(log->tail_sector), &sh, sizeof(sh)) && sh.magic == FLOG_MAGIC) {
+                flash_erase_sector(log, log->tail_sector);  // Fully drained
+            }
+            log->tail_sector = next_sector(log, log->tail_sector);
+            log->tail_off = FLOG_SECTOR_HDR_BYTES;
+            continue;
+        }
+
+        uint32_t size = FLOG_RECORD_HDR_BYTES + align4(h.len);
+        if (h.state != FLOG_STATE_PENDING) {
+            log->tail_off += size;
+            continue;
+        }
+
+        if (h.len > cap || !flash_read(log, addr + FLOG_RECORD_HDR_BYTES, buf, h.len) ||
+            crc16((const uint8_t *)buf, h.len) != h.crc) {
+            log->stats.corrupt++;
+            if (log->pending > 0) log->pending--;
+            log->tail_off += size;
+            continue;
+        }
+
+        log->peek_len = h.len;
+        return h.len;
+    }
+}
+
+void flog_consume(flog_t *log) {
+    if (log->peek_len == 0) return;
+
+    uint8_t state = FLOG_STATE_CONSUMED;
+    uint32_t addr = sector_addr(log->tail_sector) + log->tail_off + offsetof(record_hdr_t, state);
+    flash_write(log, addr, &state, 1);
+
+    log->tail_off += FLOG_RECORD_HDR_BYTES + align4(log->peek_len);
+    log->peek_len = 0;
+    if (log->pending > 0) log->pending--;
+    log->stats.consumed++;
+}
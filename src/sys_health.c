@@ -0,0 +1,130 @@
+/**
+ * @file sys_health.c
+ * @brief Sensor Health Engine Implementation (channel table, thresholds, reporting)
+ * @details
+ * Each channel is written only by the task that reads that sensor, so
+ * updates take no lock. The status byte is read by other tasks as is;
+ * a statistics snapshot may mix two consecutive samples.
+ * Status changes are logged through the deferred log, since they happen
+ * in the sensor read path.
+ */
+
+#include "sys_health.h"
+#include "sys_dlog.h"
+#include "esp_cpu.h"
+#include "esp_log.h"
+
+static const char *TAG = "HEALTH";
+
+static const health_cfg_t *const channel_cfg[HEALTH_CH_COUNT] = {
+    [HEALTH_CH_LC_FRONT] = &health_cfg_loadcell,
+    [HEALTH_CH_LC_LEFT]  = &health_cfg_loadcell,
+    [HEALTH_CH_LC_RIGHT] = &health_cfg_loadcell,
+    [HEALTH_CH_US_FRONT] = &health_cfg_ultrasonic,
+    [HEALTH_CH_US_LEFT]  = &health_cfg_ultrasonic,
+    [HEALTH_CH_US_RIGHT] = &health_cfg_ultrasonic,
+    [HEALTH_CH_BATT]     = &health_cfg_battery,
+};
+
+static const char *const channel_names[HEALTH_CH_COUNT] = {
+    "LC_FRONT", "LC_LEFT", "LC_RIGHT", "US_FRONT", "US_LEFT", "US_RIGHT", "BATT",
+};
+
+static const char *const status_names[] = { "OK", "DEGRADED", "FAILED" };
+
+// PRIVATE STATIC VARIABLES
+static health_chan_t chans[HEALTH_CH_COUNT];
+static uint32_t transitions[HEALTH_CH_COUNT];
+static uint32_t cycles_max[HEALTH_CH_COUNT];
+static uint64_t cycles_sum[HEALTH_CH_COUNT];
+
+// --- HELPER FUNCTIONS ---
+
+static void account(health_channel_t ch, uint8_t before, uint32_t c0) {
+    uint32_t cycles = esp_cpu_get_cycle_count() - c0;
+    cycles_sum[ch] += cycles;
+    if (cycles > cycles_max[ch]) cycles_max[ch] = cycles;
+
+    uint8_t after = chans[ch].status;
+    if (after != before) {
+        transitions[ch]++;
+        DLOGW(TAG, "%s: %s -> %s (cause 0x%02x)", channel_names[ch], status_names[before],
+              status_names[after], chans[ch].cause);
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t health_init(void) {
+    for (int ch = 0; ch < HEALTH_CH_COUNT; ch++) {
+        health_chan_reset(&chans[ch]);
+        transitions[ch] = 0;
+        cycles_max[ch] = 0;
+        cycles_sum[ch] = 0;
+    }
+    ESP_LOGI(TAG, "%d channels, block %d samples", HEALTH_CH_COUNT, HEALTH_BLOCK_LEN);
+    return ESP_OK;
+}
+
+void health_sample(health_channel_t ch, float x, int64_t t_us) {
+    if ((unsigned)ch >= HEALTH_CH_COUNT) return;
+
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    uint8_t before = chans[ch].status;
+    health_chan_sample(&chans[ch], channel_cfg[ch], x, t_us);
+    account(ch, before, c0);
+}
+
+void health_dropout(health_channel_t ch) {
+    if ((unsigned)ch >= HEALTH_CH_COUNT) return;
+
+    uint32_t c0 = esp_cpu_get_cycle_count();
+    uint8_t before = chans[ch].status;
+    health_chan_dropout(&chans[ch], channel_cfg[ch]);
+    account(ch, before, c0);
+}
+
+health_status_t health_get_status(health_channel_t ch) {
+    if ((unsigned)ch >= HEALTH_CH_COUNT) return HEALTH_FAILED;
+    return (health_status_t)chans[ch].status;
+}
+
+health_status_t health_worst(uint32_t mask) {
+    uint8_t worst = HEALTH_OK;
+    for (int ch = 0; ch < HEALTH_CH_COUNT; ch++) {
+        if ((mask & (1u << ch)) && chans[ch].status > worst) worst = chans[ch].status;
+    }
+    return (health_status_t)worst;
+}
+
+uint16_t health_pack(void) {
+    uint16_t packed = 0;
+    for (int ch = 0; ch < HEALTH_CH_COUNT; ch++) {
+        packed |= (uint16_t)((chans[ch].status & 3u) << (2 * ch));
+    }
+    return packed;
+}
+
+void health_get_stats(health_channel_t ch, health_stats_t *out) {
+    if (out == NULL || (unsigned)ch >= HEALTH_CH_COUNT) return;
+
+    out->chan = chans[ch];
+    out->transitions = transitions[ch];
+    out->update_cycles_max = cycles_max[ch];
+    uint32_t n = chans[ch].samples + chans[ch].dropouts;
+    out->update_cycles_avg = n ? (uint32_t)(cycles_sum[ch] / n) : 0;
+}
+
+void health_log_stats(void) {
+    for (int ch = 0; ch < HEALTH_CH_COUNT; ch++) {
+        health_stats_t s;
+        health_get_stats((health_channel_t)ch, &s);
+        if (s.chan.samples + s.chan.dropouts == 0) continue;
+
+        ESP_LOGI(TAG, "%-8s %-8s cause 0x%02x | mean %.2f sd %.2f | n %lu drop %lu rate %lu | %lu cyc avg / %lu max",
+                 channel_names[ch], status_names[s.chan.status], s.chan.cause,
+                 s.chan.block_mean, health_chan_stddev(&s.chan),
+                 (unsigned long)s.chan.samples, (unsigned long)s.chan.dropouts, (unsigned long)s.chan.rate_faults,
+                 (unsigned long)s.update_cycles_avg, (unsigned long)s.update_cycles_max);
+    }
+}
@@ -0,0 +1,160 @@
+/**
+ * @file sys_health_stats.c
+ * @brief Sensor Health Detectors (pure C, no IDF dependencies)
+ * @details
+ * Per sample: one Welford step (no division, 1/n comes from a constant
+ * table), one |dx| for the stuck and rate detectors, two EMA updates and
+ * the classification, all in single precision for the ESP32-S3 FPU.
+ */
+
+#include <math.h>
+#include <string.h>
+#include "sys_health.h"
+
+#define EMA_W                   (1.0f / (float)(1 << HEALTH_EMA_SHIFT))
+
+// 1/n for n = 0..32, folded at compile time
+#define INV4(n)                 1.0f / (n), 1.0f / ((n) + 1), 1.0f / ((n) + 2), 1.0f / ((n) + 3)
+#define INV16(n)                INV4(n), INV4((n) + 4), INV4((n) + 8), INV4((n) + 12)
+
+static const float inv_n[HEALTH_BLOCK_LEN + 1] = { 0.0f, INV16(1), INV16(17) };
+
+_Static_assert(HEALTH_BLOCK_LEN == 32, "inv_n table covers 1..32");
+
+/**
+ * @brief Default thresholds per sensor type
+ * @details
+ * - HX711: a live converter never repeats a 24-bit value for long and its
+ *   noise is several counts; disconnected DOUT shows up as read timeouts.
+ *   No ceiling: loading the cell is a legitimate variance change.
+ * - JSN-SR04T: 1 mm steps repeat on a still target, so stuck needs a long
+ *   run; blind-zone jumps are expected now and then, hence the rate EMA.
+ * - Battery: the voltage is legitimately constant; check noise and jumps.
+ */
+const health_cfg_t health_cfg_loadcell = {
+    .stuck_eps = 0.0f,      .stuck_degraded = 8,    .stuck_failed = 25,
+    .var_min = 1.0f,        .var_max = 0.0f,
+    .max_rate = 2.0e7f,     .rate_degraded = 0.10f, .rate_failed = 0.50f,
+    .drop_degraded = 0.10f, .drop_failed = 0.50f,
+};
+
+const health_cfg_t health_cfg_ultrasonic = {
+    .stuck_eps = 0.0f,      .stuck_degraded = 50,   .stuck_failed = 200,
+    .var_min = 0.01f,       .var_max = 0.0f,
+    .max_rate = 20000.0f,   .rate_degraded = 0.20f, .rate_failed = 0.60f,
+    .drop_degraded = 0.20f, .drop_failed = 0.60f,
+};
+
+const health_cfg_t health_cfg_battery = {
+    .stuck_eps = 0.0f,      .stuck_degraded = 0,    .stuck_failed = 0,
+    .var_min = 0.0f,        .var_max = 0.25f,
+    .max_rate = 2.0f,       .rate_degraded = 0.10f, .rate_failed = 0.50f,
+    .drop_degraded = 0.10f, .drop_failed = 0.50f,
+};
+
+// --- HELPER FUNCTIONS ---
+
+static uint8_t max_level(uint8_t a, uint8_t b) {
+    return a > b ? a : b;
+}
+
+/**
+ * @brief Level of an EMA fraction detector (leaves DEGRADED at half the entry threshold)
+ */
+static uint8_t ema_level(float v, float deg, float fail, uint8_t prev_cause, uint8_t bit, uint8_t *cause) {
+    if (deg <= 0.0f) return HEALTH_OK;
+
+    float enter = (prev_cause & bit) ? deg * 0.5f : deg;
+    if (v <= enter) return HEALTH_OK;
+
+    *cause |= bit;
+    return (fail > 0.0f && v > fail) ? HEALTH_FAILED : HEALTH_DEGRADED;
+}
+
+static health_status_t classify(health_chan_t *c, const health_cfg_t *cfg) {
+    uint8_t level = HEALTH_OK;
+    uint8_t cause = 0;
+
+    if (cfg->stuck_degraded > 0 && c->stuck_run >= cfg->stuck_degraded) {
+        cause |= HEALTH_CAUSE_STUCK;
+        bool failed = cfg->stuck_failed > 0 && c->stuck_run >= cfg->stuck_failed;
+        level = max_level(level, failed ? HEALTH_FAILED : HEALTH_DEGRADED);
+    }
+
+    if (c->block_valid) {
+        if (cfg->var_min > 0.0f && c->block_var < cfg->var_min) {
+            cause |= HEALTH_CAUSE_FLAT;
+            level = max_level(level, HEALTH_DEGRADED);
+        }
+        if (cfg->var_max > 0.0f && c->block_var > cfg->var_max) {
+            cause |= HEALTH_CAUSE_NOISY;
+            level = max_level(level, HEALTH_DEGRADED);
+        }
+    }
+
+    level = max_level(level, ema_level(c->rate_ema, cfg->rate_degraded, cfg->rate_failed,
+                                       c->cause, HEALTH_CAUSE_RATE, &cause));
+    level = max_level(level, ema_level(c->drop_ema, cfg->drop_degraded, cfg->drop_failed,
+                                       c->cause, HEALTH_CAUSE_DROPOUT, &cause));
+
+    c->cause = cause;
+    c->status = level;
+    return (health_status_t)level;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void health_chan_reset(health_chan_t *c) {
+    memset(c, 0, sizeof(*c));
+}
+
+health_status_t health_chan_sample(health_chan_t *c, const health_cfg_t *cfg, float x, int64_t t_us) {
+    c->samples++;
+
+    // Welford step; the block variance is published when the block completes
+    float delta = x - c->mean;
+    c->n++;
+    c->mean += delta * inv_n[c->n];
+    c->m2 += delta * (x - c->mean);
+    if (c->n == HEALTH_BLOCK_LEN) {
+        c->block_mean = c->mean;
+        c->block_var = c->m2 * inv_n[HEALTH_BLOCK_LEN - 1];
+        c->block_valid = true;
+        c->n = 0;
+        c->mean = 0.0f;
+        c->m2 = 0.0f;
+    }
+
+    float rate_hit = 0.0f;
+    if (c->has_prev) {
+        float dx = fabsf(x - c->prev);
+
+        if (dx <= cfg->stuck_eps) {
+            if (c->stuck_run < UINT16_MAX) c->stuck_run++;
+        } else {
+            c->stuck_run = 0;
+        }
+
+        if (cfg->max_rate > 0.0f && dx > cfg->max_rate * (float)(t_us - c->prev_us) * 1e-6f) {
+            rate_hit = 1.0f;
+            c->rate_faults++;
+        }
+    }
+    c->rate_ema += (rate_hit - c->rate_ema) * EMA_W;
+    c->drop_ema -= c->drop_ema * EMA_W;
+
+    c->prev = x;
+    c->prev_us = t_us;
+    c->has_prev = true;
+    return classify(c, cfg);
+}
+
+health_status_t health_chan_dropout(health_chan_t *c, const health_cfg_t *cfg) {
+    c->dropouts++;
+    c->drop_ema += (1.0f - c->drop_ema) * EMA_W;
+    return classify(c, cfg);
+}
+
+float health_chan_stddev(const health_chan_t *c) {
+    return c->block_valid ? sqrtf(c->block_var) : 0.0f;
+}
@@ -0,0 +1,218 @@
+/**
+ * @file sys_ident.c
+ * @brief System Identification Mode Implementation
+ * @details
+ * Capture runs in a periodic esp_timer callback (esp_timer task, highest
+ * application priority), so it is not delayed by mission/logging tasks.
+ * Each callback derives its slot from the elapsed time rather than counting
+ * calls, so a late callback shows up as a dropped slot instead of silently
+ * stretching the time axis.
+ */
+
+#include <stdio.h>
+#include <math.h>
+#include "sys_ident.h"
+#include "drv_motor.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "app_config.h"
+
+static const char *TAG = "SYS_IDENT";
+
+// PRIVATE STATIC VARIABLES
+static sysid_sample_t samples[SYSID_MAX_SAMPLES];
+static esp_timer_handle_t capture_timer = NULL;
+static sysid_script_t script;
+static sysid_sources_t sources;
+
+static portMUX_TYPE sysid_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile bool is_running = false;
+static uint32_t sample_count = 0;
+static uint32_t dropped = 0;
+static uint32_t interval_max_us = 0;
+static int64_t start_us = 0;
+static int64_t last_us = 0;
+static int64_t end_us = 0;
+static int32_t last_slot = -1;
+
+// --- HELPER FUNCTIONS ---
+
+static inline uint16_t clamp_raw(int32_t v) {
+    if (v < 0) return 0;
+    if (v > MOTOR_SPEED_MAX_RAW) return MOTOR_SPEED_MAX_RAW;
+    return (uint16_t)v;
+}
+
+static inline int16_t quantize(float v, float unit) {
+    float q = v / unit;
+    if (q > 32767.0f) return 32767;
+    if (q < -32768.0f) return -32768;
+    return (int16_t)lrintf(q);
+}
+
+static void finish(int64_t now_us) {
+    esp_timer_stop(capture_timer);
+    motor_set_speed(MOTOR_IDLE_RAW, MOTOR_IDLE_RAW);
+
+    portENTER_CRITICAL(&sysid_mux);
+    end_us = now_us;
+    is_running = false;
+    portEXIT_CRITICAL(&sysid_mux);
+}
+
+static void capture_cb(void *arg) {
+    if (!is_running) return;
+
+    int64_t now = esp_timer_get_time();
+    int64_t elapsed = now - start_us;
+    float t_s = (float)elapsed * 1e-6f;
+
+    if (t_s >= script.duration_s || sample_count >= SYSID_MAX_SAMPLES) {
+        finish(now);
+        ESP_LOGI(TAG, "Capture done: %lu samples, %lu dropped",
+                 (unsigned long)sample_count, (unsigned long)dropped);
+        return;
+    }
+
+    // Slot from wall time: a late callback leaves a gap instead of skewing time
+    int32_t slot = (int32_t)((elapsed + SYSID_PERIOD_US / 2) / SYSID_PERIOD_US);
+    if (slot <= last_slot) return;
+    if (last_slot >= 0) {
+        dropped += (uint32_t)(slot - last_slot - 1);
+        uint32_t interval = (uint32_t)(now - last_us);
+        if (interval > interval_max_us) interval_max_us = interval;
+    }
+    last_slot = slot;
+    last_us = now;
+
+    uint16_t left, right;
+    sysid_excitation(&script, t_s, &left, &right);
+    motor_set_speed(left, right);
+
+    sysid_sample_t *s = &samples[sample_count];
+    s->slot = (uint16_t)slot;
+    s->left_raw = left;
+    s->right_raw = right;
+    s->yaw_rate = quantize(sources.yaw_rate_dps ? sources.yaw_rate_dps(sources.ctx) : 0.0f, SYSID_YAW_UNIT_DPS);
+    s->thrust = quantize(sources.thrust_g ? sources.thrust_g(sources.ctx) : 0.0f, SYSID_THRUST_UNIT_G);
+    sample_count++;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void sysid_excitation(const sysid_script_t *sc, float t_s, uint16_t *left_raw, uint16_t *right_raw) {
+    float e = 0.0f;
+    float t_ex = t_s - sc->settle_s;
+    float t_len = sc->duration_s - sc->settle_s;
+    float amp = (sc->amplitude_raw > SYSID_MAX_AMPLITUDE_RAW) ? SYSID_MAX_AMPLITUDE_RAW : sc->amplitude_raw;
+
+    if (t_ex >= 0.0f && t_len > 0.0f) {
+        if (sc->signal == SYSID_SIGNAL_STEP) {
+            // Step up, then back down: both edges are usable for the fit
+            e = (t_ex < 0.5f * t_len) ? amp : 0.0f;
+        } else {
+            // Linear chirp: phase = 2*pi*(f0*t + (f1-f0)*t^2 / (2*T))
+            float k = (sc->f1_hz - sc->f0_hz) / t_len;
+            float phase = 6.2831853f * (sc->f0_hz * t_ex + 0.5f * k * t_ex * t_ex);
+            e = amp * sinf(phase);
+        }
+    }
+
+    int32_t base = sc->base_raw;
+    int32_t de = (int32_t)lrintf(e);
+    if (sc->axis == SYSID_AXIS_THRUST) {
+        *left_raw = clamp_raw(base + de);
+        *right_raw = clamp_raw(base + de);
+    } else {
+        *left_raw = clamp_raw(base + de);
+        *right_raw = clamp_raw(base - de);
+    }
+}
+
+esp_err_t sysid_start(const sysid_script_t *sc, const sysid_sources_t *src) {
+    if (is_running) return ESP_ERR_INVALID_STATE;
+    if (sc == NULL || src == NULL) return ESP_ERR_INVALID_ARG;
+    if (sc->duration_s <= sc->settle_s || sc->duration_s > SYSID_MAX_DURATION_S) return ESP_ERR_INVALID_ARG;
+    if (sc->base_raw > MOTOR_SPEED_MAX_RAW) return ESP_ERR_INVALID_ARG;
+    if (sc->signal == SYSID_SIGNAL_CHIRP && (sc->f0_hz <= 0.0f || sc->f1_hz <= sc->f0_hz ||
+                                             sc->f1_hz > SYSID_RATE_HZ / 4)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+
+    if (capture_timer == NULL) {
+        esp_timer_create_args_t args = {
+            .callback = capture_cb,
+            .dispatch_method = ESP_TIMER_TASK,
+            .name = "sysid",
+            .skip_unhandled_events = true,
+        };
+        esp_err_t err = esp_timer_create(&args, &capture_timer);
+        if (err != ESP_OK) return err;
+    }
+
+    script = *sc;
+    sources = *src;
+    sample_count = 0;
+    dropped = 0;
+    interval_max_us = 0;
+    last_slot = -1;
+    start_us = esp_timer_get_time();
+    end_us = 0;
+    is_running = true;
+
+    ESP_LOGI(TAG, "Start: %s %s, base %u, amp %u, %.1fs @ %d Hz",
+             sc->signal == SYSID_SIGNAL_STEP ? "step" : "chirp",
+             sc->axis == SYSID_AXIS_THRUST ? "thrust" : "yaw",
+             sc->base_raw, sc->amplitude_raw, sc->duration_s, SYSID_RATE_HZ);
+
+    esp_err_t err = esp_timer_start_periodic(capture_timer, SYSID_PERIOD_US);
+    if (err != ESP_OK) is_running = false;
+    return err;
+}
+
+void sysid_abort(void) {
+    if (!is_running) return;
+    finish(esp_timer_get_time());
+    ESP_LOGW(TAG, "Capture aborted after %lu samples", (unsigned long)sample_count);
+}
+
+void sysid_get_stats(sysid_stats_t *out) {
+    if (out == NULL) return;
+
+    portENTER_CRITICAL(&sysid_mux);
+    out->samples = sample_count;
+    out->dropped = dropped;
+    out->interval_max_us = interval_max_us;
+    out->is_running = is_running;
+    int64_t elapsed = (is_running ? last_us : end_us) - start_us;
+    portEXIT_CRITICAL(&sysid_mux);
+
+    out->achieved_rate_hz = (elapsed > 0) ? (float)out->samples * 1e6f / (float)elapsed : 0.0f;
+}
+
+const sysid_sample_t *sysid_get_samples(uint32_t *count) {
+    if (is_running) return NULL;
+    if (count != NULL) *count = sample_count;
+    return samples;
+}
+
+void sysid_dump(void) {
+    if (is_running) return;
+
+    sysid_stats_t st;
+    sysid_get_stats(&st);
+
+    printf("#SYSID rate=%d signal=%d axis=%d base=%u amp=%u settle=%.3f duration=%.3f f0=%.3f f1=%.3f "
+           "samples=%lu dropped=%lu achieved=%.1f\n",
+           SYSID_RATE_HZ, script.signal, script.axis, script.base_raw, script.amplitude_raw,
+           script.settle_s, script.duration_s, script.f0_hz, script.f1_hz,
+           (unsigned long)st.samples, (unsigned long)st.dropped, st.achieved_rate_hz);
+
+    for (uint32_t i = 0; i < sample_count; i++) {
+        const sysid_sample_t *s = &samples[i];
+        printf("%u,%u,%u,%.1f,%.0f\n", s->slot, s->left_raw, s->right_raw,
+               s->yaw_rate * SYSID_YAW_UNIT_DPS, s->thrust * SYSID_THRUST_UNIT_G);
+    }
+    printf("#END\n");
+}
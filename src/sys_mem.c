@@ -0,0 +1,245 @@
+/**
+ * @file sys_mem.c
+ * @brief Static Memory Budget (arena region, FreeRTOS static objects, heap lock)
+ * @details
+ * The region is one .bss array in internal RAM (task stacks must not be in
+ * PSRAM), split in MEM_BUDGET_TABLE order on first use. Arena and pool
+ * updates run under one spinlock; they are rare (init) or O(1) (pools).
+ * The heap hook runs inside every heap_caps_malloc(), possibly from an
+ * ISR, so it only counts and copies a few words.
+ */
+
+#include "sys_mem.h"
+#include <string.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_heap_caps.h"
+#include "esp_system.h"
+#include "esp_attr.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+
+static const char *TAG = "SYS_MEM";
+
+_Static_assert(sizeof(StaticTask_t) <= MEM_TASK_OVERHEAD, "MEM_TASK_OVERHEAD too small");
+_Static_assert(sizeof(StaticQueue_t) <= MEM_QUEUE_OVERHEAD, "MEM_QUEUE_OVERHEAD too small");
+
+// PRIVATE STATIC VARIABLES
+static uint8_t region[MEM_REGION_BYTES] __attribute__((aligned(MEM_ALIGN)));
+static mem_arena_t arenas[MEM_SUB_COUNT];
+static mem_pool_t *pools[MEM_MAX_POOLS];
+static uint8_t pool_count = 0;
+static bool is_initialized = false;
+
+static portMUX_TYPE mem_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Heap lock (written by the hook under mem_mux)
+static volatile bool heap_locked = false;
+static uint32_t heap_at_lock = 0;
+static TaskHandle_t exempt[MEM_MAX_EXEMPT];
+static uint32_t locked_allocs = 0;
+static uint32_t locked_bytes = 0;
+static uint32_t exempt_allocs = 0;
+static mem_heap_event_t heap_log[MEM_HEAP_LOG_MAX];
+
+// --- HELPER FUNCTIONS ---
+
+static void *arena_alloc(mem_sub_t sub, size_t size) {
+    if ((unsigned)sub >= MEM_SUB_COUNT) return NULL;
+    mem_init();
+
+    portENTER_CRITICAL(&mem_mux);
+    void *p = mem_arena_alloc(&arenas[sub], size);
+    portEXIT_CRITICAL(&mem_mux);
+
+    if (p == NULL) {
+        ESP_LOGE(TAG, "%s: %u B over budget (%lu / %lu used)", mem_sub_name(sub), (unsigned)size,
+                 (unsigned long)arenas[sub].used, (unsigned long)arenas[sub].size);
+    }
+    return p;
+}
+
+#ifdef CONFIG_HEAP_USE_HOOKS
+/**
+ * @brief Heap allocation hook (CONFIG_HEAP_USE_HOOKS)
+ */
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps) {
+    if (!heap_locked || ptr == NULL) return;
+
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL_SAFE(&mem_mux);
+    bool is_exempt = false;
+    for (int i = 0; i < MEM_MAX_EXEMPT; i++) {
+        if (exempt[i] == task) is_exempt = true;
+    }
+    if (is_exempt) {
+        exempt_allocs++;
+    } else {
+        if (locked_allocs < MEM_HEAP_LOG_MAX) {
+            heap_log[locked_allocs] = (mem_heap_event_t){
+                .size = (uint32_t)size, .caps = caps, .task = task, .time_us = esp_timer_get_time(),
+            };
+        }
+        locked_allocs++;
+        locked_bytes += (uint32_t)size;
+    }
+    portEXIT_CRITICAL_SAFE(&mem_mux);
+}
+#endif
+
+// --- PUBLIC FUNCTIONS ---
+
+void mem_init(void) {
+    portENTER_CRITICAL(&mem_mux);
+    if (!is_initialized) {
+        uint8_t *base = region;
+        for (int s = 0; s < MEM_SUB_COUNT; s++) {
+            mem_arena_init(&arenas[s], base, mem_sub_budget((mem_sub_t)s));
+            base += mem_sub_budget((mem_sub_t)s);
+        }
+        is_initialized = true;
+    }
+    portEXIT_CRITICAL(&mem_mux);
+}
+
+void *mem_alloc(mem_sub_t sub, size_t size) {
+    return arena_alloc(sub, size);
+}
+
+void *mem_task_create(mem_sub_t sub, void (*fn)(void *), const char *name, uint32_t stack_bytes,
+                      void *arg, uint32_t priority, int core) {
+    StaticTask_t *tcb = arena_alloc(sub, sizeof(StaticTask_t));
+    StackType_t *stack = tcb ? arena_alloc(sub, stack_bytes) : NULL;
+    if (stack == NULL) return NULL;
+
+    // ESP-IDF: stack depth in bytes
+    return xTaskCreateStaticPinnedToCore(fn, name, stack_bytes, arg, priority, stack, tcb, core);
+}
+
+void *mem_queue_create(mem_sub_t sub, uint32_t len, uint32_t item_size) {
+    StaticQueue_t *q = arena_alloc(sub, sizeof(StaticQueue_t));
+    uint8_t *storage = q ? arena_alloc(sub, (size_t)len * item_size) : NULL;
+    if (storage == NULL) return NULL;
+
+    return xQueueCreateStatic(len, item_size, storage, q);
+}
+
+mem_pool_t *mem_pool_create(mem_sub_t sub, const char *name, size_t block_size, uint16_t count) {
+    mem_pool_t *p = arena_alloc(sub, sizeof(mem_pool_t));
+    void *storage = p ? arena_alloc(sub, MEM_ALIGN_UP(block_size) * count) : NULL;
+    if (storage == NULL || !mem_pool_init(p, name, storage, block_size, count)) return NULL;
+
+    portENTER_CRITICAL(&mem_mux);
+    if (pool_count < MEM_MAX_POOLS) pools[pool_count++] = p;
+    portEXIT_CRITICAL(&mem_mux);
+    return p;
+}
+
+void *mem_pool_alloc(mem_pool_t *p) {
+    portENTER_CRITICAL_SAFE(&mem_mux);
+    void *b = mem_pool_take(p);
+    portEXIT_CRITICAL_SAFE(&mem_mux);
+    return b;
+}
+
+void mem_pool_free(mem_pool_t *p, void *ptr) {
+    if (ptr == NULL) return;
+    portENTER_CRITICAL_SAFE(&mem_mux);
+    mem_pool_give(p, ptr);
+    portEXIT_CRITICAL_SAFE(&mem_mux);
+}
+
+void mem_heap_lock(void) {
+    heap_at_lock = (uint32_t)esp_get_free_heap_size();
+    heap_locked = true;
+#ifdef CONFIG_HEAP_USE_HOOKS
+    ESP_LOGI(TAG, "Heap locked at %lu B free", (unsigned long)heap_at_lock);
+#else
+    ESP_LOGW(TAG, "Heap locked at %lu B free (no CONFIG_HEAP_USE_HOOKS: drift check only)",
+             (unsigned long)heap_at_lock);
+#endif
+}
+
+esp_err_t mem_heap_exempt(bool on) {
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    esp_err_t err = on ? ESP_ERR_NO_MEM : ESP_OK;
+
+    portENTER_CRITICAL(&mem_mux);
+    for (int i = 0; i < MEM_MAX_EXEMPT; i++) {
+        if (exempt[i] == self) {
+            if (!on) exempt[i] = NULL;
+            err = ESP_OK;
+            break;
+        }
+    }
+    for (int i = 0; on && err != ESP_OK && i < MEM_MAX_EXEMPT; i++) {
+        if (exempt[i] == NULL) {
+            exempt[i] = self;
+            err = ESP_OK;
+        }
+    }
+    portEXIT_CRITICAL(&mem_mux);
+    return err;
+}
+
+void mem_get_stats(mem_stats_t *out) {
+    portENTER_CRITICAL(&mem_mux);
+    memcpy(out->arenas, arenas, sizeof(arenas));
+    out->pool_count = pool_count;
+    out->heap_locked = heap_locked;
+    out->heap_at_lock = heap_at_lock;
+    out->locked_allocs = locked_allocs;
+    out->locked_bytes = locked_bytes;
+    out->exempt_allocs = exempt_allocs;
+    portEXIT_CRITICAL(&mem_mux);
+}
+
+void mem_log_report(void) {
+    mem_stats_t s;
+    mem_get_stats(&s);
+
+    uint32_t used = 0;
+    ESP_LOGI(TAG, "Arena region %u B:", (unsigned)MEM_REGION_BYTES);
+    for (int i = 0; i < MEM_SUB_COUNT; i++) {
+        const mem_arena_t *a = &s.arenas[i];
+        used += a->used;
+        ESP_LOGI(TAG, "  %-10s %5lu / %5lu B (%3lu%%)%s", mem_sub_name((mem_sub_t)i), (unsigned long)a->used,
+                 (unsigned long)a->size, (unsigned long)(a->size ? 100 * a->used / a->size : 0),
+                 a->failed ? "  OVER BUDGET" : "");
+    }
+    ESP_LOGI(TAG, "  total      %5lu / %5u B", (unsigned long)used, (unsigned)MEM_REGION_BYTES);
+
+    for (int i = 0; i < s.pool_count; i++) {
+        const mem_pool_t *p = pools[i];
+        ESP_LOGI(TAG, "Pool %-10s %lu B x %u | in use %u, peak %u | empty %lu, bad free %lu", p->name,
+                 (unsigned long)p->block_size, p->count, p->in_use, p->peak, (unsigned long)p->failed,
+                 (unsigned long)p->bad_give);
+    }
+
+    // Fragmentation of what is left on the heap (IDF drivers, exempt work)
+    size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    size_t largest = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+    ESP_LOGI(TAG, "Heap: %u B free, largest block %u B (fragmentation %u%%), min free ever %u B",
+             (unsigned)free_heap, (unsigned)largest,
+             (unsigned)(free_heap ? 100 - 100 * largest / free_heap : 0),
+             (unsigned)heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT));
+
+    if (!s.heap_locked) {
+        ESP_LOGI(TAG, "Heap not locked (init)");
+        return;
+    }
+    int32_t drift = (int32_t)s.heap_at_lock - (int32_t)esp_get_free_heap_size();
+    if (s.locked_allocs == 0 && drift <= 0) {
+        ESP_LOGI(TAG, "Heap locked: no allocations since init (%lu exempt)", (unsigned long)s.exempt_allocs);
+        return;
+    }
+    ESP_LOGW(TAG, "Heap locked: %lu allocations (%lu B) since init, %ld B less free, %lu exempt",
+             (unsigned long)s.locked_allocs, (unsigned long)s.locked_bytes, (long)drift,
+             (unsigned long)s.exempt_allocs);
+    for (uint32_t i = 0; i < s.locked_allocs && i < MEM_HEAP_LOG_MAX; i++) {
+        const mem_heap_event_t *e = &heap_log[i];
+        ESP_LOGW(TAG, "  %lu B caps 0x%lx in %s at %lld ms", (unsigned long)e->size, (unsigned long)e->caps,
+                 e->task ? pcTaskGetName((TaskHandle_t)e->task) : "?", (long long)(e->time_us / 1000));
+    }
+}
@@ -0,0 +1,99 @@
+/**
+ * @file sys_mem_pool.c
+ * @brief Arenas and Fixed-Block Pools (pure C, no IDF dependencies)
+ * @details
+ * Arena: bump pointer, MEM_ALIGN aligned, zeroed, never freed. Pool: free
+ * list threaded through the free blocks themselves, so take and give are
+ * a pointer swap and the pool needs no side table. A give is checked
+ * against the pool range and block grid before it is linked.
+ */
+
+#include <string.h>
+#include "sys_mem.h"
+
+static const char *const sub_names[MEM_SUB_COUNT] = {
+#define MEM_SUB_NAME(id, name, bytes) name,
+    MEM_BUDGET_TABLE(MEM_SUB_NAME)
+#undef MEM_SUB_NAME
+};
+
+static const uint32_t sub_budgets[MEM_SUB_COUNT] = {
+#define MEM_SUB_BUDGET(id, name, bytes) MEM_BUDGET_##id,
+    MEM_BUDGET_TABLE(MEM_SUB_BUDGET)
+#undef MEM_SUB_BUDGET
+};
+
+_Static_assert((MEM_ALIGN & (MEM_ALIGN - 1)) == 0, "MEM_ALIGN must be a power of 2");
+_Static_assert(MEM_ALIGN >= sizeof(void *), "pool blocks hold the free-list link");
+_Static_assert(sizeof(mem_pool_t) <= MEM_POOL_OVERHEAD, "MEM_POOL_OVERHEAD too small");
+
+// --- PUBLIC FUNCTIONS ---
+
+const char *mem_sub_name(mem_sub_t sub) {
+    return (unsigned)sub < MEM_SUB_COUNT ? sub_names[sub] : "?";
+}
+
+uint32_t mem_sub_budget(mem_sub_t sub) {
+    return (unsigned)sub < MEM_SUB_COUNT ? sub_budgets[sub] : 0;
+}
+
+void mem_arena_init(mem_arena_t *a, void *base, size_t size) {
+    a->base = base;
+    a->size = (uint32_t)size;
+    a->used = 0;
+    a->failed = 0;
+}
+
+void *mem_arena_alloc(mem_arena_t *a, size_t size) {
+    size_t n = MEM_ALIGN_UP(size);
+    if (size == 0 || n > a->size - a->used) {
+        a->failed++;
+        return NULL;
+    }
+    void *p = a->base + a->used;
+    a->used += (uint32_t)n;
+    memset(p, 0, n);
+    return p;
+}
+
+bool mem_pool_init(mem_pool_t *p, const char *name, void *storage, size_t block_size, uint16_t count) {
+    memset(p, 0, sizeof(*p));
+    if (block_size == 0 || count == 0 || storage == NULL) return false;
+
+    p->name = name;
+    p->mem = storage;
+    p->block_size = (uint32_t)MEM_ALIGN_UP(block_size);
+    p->count = count;
+
+    // Link in address order: the first take returns the first block
+    for (uint16_t i = count; i-- > 0;) {
+        void **blk = (void **)(p->mem + (size_t)i * p->block_size);
+        *blk = p->free_list;
+        p->free_list = blk;
+    }
+    return true;
+}
+
+void *mem_pool_take(mem_pool_t *p) {
+    void **blk = p->free_list;
+    if (blk == NULL) {
+        p->failed++;
+        return NULL;
+    }
+    p->free_list = *blk;
+    if (++p->in_use > p->peak) p->peak = p->in_use;
+    return blk;
+}
+
+bool mem_pool_give(mem_pool_t *p, void *ptr) {
+    uint8_t *b = ptr;
+    uintptr_t off = (uintptr_t)b - (uintptr_t)p->mem;   // Wraps for b < mem
+    if (off >= (uintptr_t)p->count * p->block_size || off % p->block_size != 0 || p->in_use == 0) {
+        p->bad_give++;
+        return false;
+    }
+    *(void **)b = p->free_list;
+    p->free_list = b;
+    p->in_use--;
+    return true;
+}
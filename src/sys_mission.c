@@ -0,0 +1,38 @@
+/**
+ * @file sys_mission.c
+ * @brief Mission State Implementation
+ */
+
+#include "sys_mission.h"
+#include "sys_pm.h"
+#include "esp_log.h"
+
+static const char *TAG = "MISSION";
+
+// PRIVATE STATIC VARIABLES
+static volatile mission_state_t current_state = MISSION_STANDBY;
+
+static const char *const state_names[MISSION_STATE_COUNT] = {
+    "STANDBY", "DISPATCH", "COURSE_LOCK", "FINE_APPROACH", "RESCUE", "RTH",
+};
+
+// --- PUBLIC FUNCTIONS ---
+
+mission_state_t mission_get_state(void) {
+    return current_state;
+}
+
+void mission_set_state(mission_state_t state) {
+    if (state >= MISSION_STATE_COUNT) return;
+
+    mission_state_t prev = current_state;
+    current_state = state;
+    if (prev != state) {
+        ESP_LOGI(TAG, "%s -> %s", state_names[prev], state_names[state]);
+        syspm_on_mission_state(state);
+    }
+}
+
+const char *mission_state_name(mission_state_t state) {
+    return (state < MISSION_STATE_COUNT) ? state_names[state] : "?";
+}
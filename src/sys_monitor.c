@@ -6,6 +6,8 @@
 #include "sys_monitor.h"
 #include <stdio.h>
 #include "esp_log.h"
+#include "sys_dlog.h"
+#include "sys_mem.h"
 #include "esp_heap_caps.h"
 #include "esp_system.h"
 
@@ -30,19 +32,27 @@ void sys_mon_check_memory(void) {
     float used_pct = (float)used_heap * 100.0f / total_heap;
 
     // Diagnostic Report
-    ESP_LOGI(TAG, "========== MEMORY DIAGNOSTICS ==========");
-    ESP_LOGI(TAG, "Total Heap:    %6u B  (%u KB)", total_heap, total_heap / 1024);
-    ESP_LOGI(TAG, "Current Used:  %6u B  (%.1f%%)", used_heap, used_pct);
-    ESP_LOGI(TAG, "Current Free:  %6u B", free_heap);
+    DLOGI(TAG, "========== MEMORY DIAGNOSTICS ==========");
+    DLOGI(TAG, "Total Heap:    %6u B  (%u KB)", total_heap, total_heap / 1024);
+    DLOGI(TAG, "Current Used:  %6u B  (%.1f%%)", used_heap, used_pct);
+    DLOGI(TAG, "Current Free:  %6u B", free_heap);
     
     // Highlight the Watermark
-    ESP_LOGI(TAG, "Min Free Ever: %6u B  (Watermark)", min_free_heap); 
+    DLOGI(TAG, "Min Free Ever: %6u B  (Watermark)", min_free_heap); 
 
     // Warning Logic
     // Cảnh báo rò rỉ bộ nhớ hoặc thiếu RAM
     if (min_free_heap < 10000) { // Threshold: 10KB
-        ESP_LOGW(TAG, "WARNING: Low Memory Watermark! Check for leaks.");
+        DLOGW(TAG, "WARNING: Low Memory Watermark! Check for leaks.");
     }
 
-    ESP_LOGI(TAG, "========================================");
+    // Runtime must not allocate once init is done (sys_mem.h)
+    mem_stats_t mem;
+    mem_get_stats(&mem);
+    if (mem.heap_locked && mem.locked_allocs > 0) {
+        DLOGW(TAG, "WARNING: %u heap allocations (%u B) after init, see mem_log_report()",
+              mem.locked_allocs, mem.locked_bytes);
+    }
+
+    DLOGI(TAG, "========================================");
 }
\ No newline at end of file
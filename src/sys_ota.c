@@ -0,0 +1,383 @@
+/**
+ * @file sys_ota.c
+ * @brief Delta Firmware Update Task (HTTP ranges, esp_ota slots, signature, self-test)
+ * @details
+ * The OTA task alternates: fetch one OTA_RANGE_BYTES range into the range
+ * buffer (modem task fills it), then feed it to the patch applier, which
+ * reads the running slot and writes the inactive one through esp_ota. A
+ * failed range is retried from the same offset; the applier only ever
+ * sees each byte once. esp_ota_begin() with OTA_WITH_SEQUENTIAL_WRITES
+ * erases sector by sector as the image grows, so the flash busy time is
+ * spread over the download instead of one long erase up front.
+ *
+ * The signature is ECDSA P-256 (mbedtls) over the SHA-256 of the signed
+ * header, against OTA_SIGN_PUBKEY compiled into the image.
+ *
+ * Probation: with CONFIG_BOOTLOADER_APP_ROLLBACK_ENABLE the first boot of
+ * a new image is PENDING_VERIFY. A 1 s timer polls the checks and marks
+ * the image valid once all passed, or invalid (rollback and reboot) after
+ * OTA_SELFTEST_TIMEOUT_MS. Motors are disarmed before any reboot.
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include "sys_ota.h"
+#include "sys_mem.h"
+#include "sys_health.h"
+#include "sys_mission.h"
+#include "drv_modem.h"
+#include "drv_motor.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "mbedtls/ecdsa.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "OTA";
+
+_Static_assert(MEM_TASK_BYTES(OTA_TASK_STACK) <= MEM_BUDGET_OTA,
+               "ota_task over the MEM_BUDGET_TABLE entry");
+
+// PRIVATE STATIC VARIABLES
+static TaskHandle_t ota_task_handle = NULL;
+static esp_timer_handle_t selftest_timer = NULL;
+static const esp_partition_t *running = NULL;
+static const esp_partition_t *target = NULL;
+static esp_ota_handle_t ota_handle = 0;
+
+static portMUX_TYPE ota_mux = portMUX_INITIALIZER_UNLOCKED;
+static volatile ota_state_t state = OTA_STATE_IDLE;
+static char url[OTA_URL_MAX];
+static ota_patch_t patch;                   // OTA task only
+static char status_msg[96];                 // OTA task only
+
+// Range transfer (filled by the modem task, read by the OTA task after the notification)
+static uint8_t range_buf[OTA_RANGE_BYTES];
+static volatile uint32_t range_seq = 0;     // Request id: late callbacks of an abandoned request are ignored
+static volatile int32_t range_status = 0;
+static volatile uint32_t range_len = 0;
+
+static volatile uint32_t checks_passed = 0;
+static int64_t selftest_deadline_us = 0;
+static ota_stats_t stats;
+
+// --- HELPER FUNCTIONS ---
+
+static void publish_status(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+static void publish_status(const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(status_msg, sizeof(status_msg), fmt, ap);
+    va_end(ap);
+    if (n < 0) return;
+    if ((size_t)n >= sizeof(status_msg)) n = sizeof(status_msg) - 1;
+
+    ESP_LOGI(TAG, "%s", status_msg);
+    modem_mqtt_publish(OTA_STATUS_TOPIC, (const uint8_t *)status_msg, (size_t)n, 1);
+}
+
+static bool standby(void) {
+    return mission_get_state() == MISSION_STANDBY;
+}
+
+static bool read_running(void *ctx, uint32_t addr, void *buf, size_t len) {
+    return esp_partition_read(running, addr, buf, len) == ESP_OK;
+}
+
+static bool write_target(void *ctx, const void *buf, size_t len) {
+    return esp_ota_write(ota_handle, buf, len) == ESP_OK;
+}
+
+static bool verify_signature(void *ctx, const uint8_t digest[OTA_HASH_BYTES], const uint8_t sig[OTA_SIG_BYTES]) {
+    static const uint8_t pubkey[OTA_PUBKEY_BYTES] = OTA_SIGN_PUBKEY;
+    mbedtls_ecp_group grp;
+    mbedtls_ecp_point q;
+    mbedtls_mpi r, s;
+
+    mbedtls_ecp_group_init(&grp);
+    mbedtls_ecp_point_init(&q);
+    mbedtls_mpi_init(&r);
+    mbedtls_mpi_init(&s);
+
+    bool ok = mbedtls_ecp_group_load(&grp, MBEDTLS_ECP_DP_SECP256R1) == 0 &&
+              mbedtls_ecp_point_read_binary(&grp, &q, pubkey, sizeof(pubkey)) == 0 &&
+              mbedtls_mpi_read_binary(&r, sig, OTA_SIG_BYTES / 2) == 0 &&
+              mbedtls_mpi_read_binary(&s, sig + OTA_SIG_BYTES / 2, OTA_SIG_BYTES / 2) == 0 &&
+              mbedtls_ecdsa_verify(&grp, digest, OTA_HASH_BYTES, &q, &r, &s) == 0;
+
+    mbedtls_mpi_free(&s);
+    mbedtls_mpi_free(&r);
+    mbedtls_ecp_point_free(&q);
+    mbedtls_ecp_group_free(&grp);
+    return ok;
+}
+
+static void on_range_data(const uint8_t *data, size_t len, size_t offset, void *ctx) {
+    if ((uint32_t)(uintptr_t)ctx != range_seq) return;
+    if (offset >= sizeof(range_buf)) return;
+    if (len > sizeof(range_buf) - offset) len = sizeof(range_buf) - offset;
+    memcpy(&range_buf[offset], data, len);
+}
+
+static void on_range_done(int32_t status, size_t len, void *ctx) {
+    if ((uint32_t)(uintptr_t)ctx != range_seq) return;
+    range_status = status;
+    range_len = (uint32_t)len;
+    xTaskNotifyGive(ota_task_handle);
+}
+
+/**
+ * @brief Fetch [offset, offset + len) into range_buf, with retries
+ * @return Bytes received, 0 on failure
+ */
+static uint32_t fetch_range(uint32_t offset, uint32_t len) {
+    for (int attempt = 0; attempt <= OTA_RANGE_RETRIES; attempt++) {
+        if (attempt > 0) stats.retries++;
+        if (!standby()) return 0;
+
+        uint32_t seq = range_seq + 1;
+        range_seq = seq;
+        range_len = 0;
+        ulTaskNotifyTake(pdTRUE, 0);
+        if (!modem_http_get_range(url, offset, len, on_range_data, on_range_done, (void *)(uintptr_t)seq)) {
+            vTaskDelay(pdMS_TO_TICKS(1000));    // Previous request still releasing the client
+            continue;
+        }
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(OTA_RANGE_TIMEOUT_MS)) == 0) {
+            ESP_LOGW(TAG, "Range %lu timed out", (unsigned long)offset);
+            continue;
+        }
+        if (range_status == 200 || range_status == 206) {
+            stats.ranges++;
+            return range_len;
+        }
+        ESP_LOGW(TAG, "Range %lu failed (%ld)", (unsigned long)offset, (long)range_status);
+    }
+    return 0;
+}
+
+/**
+ * @brief Download and apply; the target slot is only selected if everything verified
+ */
+static ota_patch_result_t run_update(void) {
+    const ota_patch_io_t io = {
+        .read_src = read_running,
+        .write_dst = write_target,
+        .verify_sig = verify_signature,
+        .ctx = NULL,
+        .src_limit = running->size,
+        .dst_limit = target->size,
+    };
+    ota_patch_init(&patch, &io);
+
+    uint32_t offset = 0;
+    uint32_t total = OTA_HDR_BYTES;     // Known once the header is in
+    int64_t flash_us = 0;
+
+    while (patch.result == OTA_PATCH_BUSY) {
+        if (offset >= total) return OTA_PATCH_ERR_FORMAT;      // Stream ended before END
+
+        uint32_t want = total - offset;
+        if (!ota_patch_header_ok(&patch) || want > OTA_RANGE_BYTES) want = OTA_RANGE_BYTES;
+        uint32_t got = fetch_range(offset, want);
+        if (got == 0) return OTA_PATCH_ERR_ABORTED;
+
+        int64_t t0 = esp_timer_get_time();
+        ota_patch_feed(&patch, range_buf, got);
+        flash_us += esp_timer_get_time() - t0;
+        offset += got;
+        stats.patch_bytes = offset;
+        stats.image_bytes = patch.out_done;
+        stats.flash_ms = (uint32_t)(flash_us / 1000);
+
+        if (ota_patch_header_ok(&patch)) {
+            if (total == OTA_HDR_BYTES) {
+                ESP_LOGI(TAG, "Patch %lu bytes: image %lu -> %lu bytes",
+                         (unsigned long)patch.hdr.body_size, (unsigned long)patch.hdr.src_size,
+                         (unsigned long)patch.hdr.dst_size);
+            }
+            total = OTA_HDR_BYTES + patch.hdr.body_size;
+        }
+    }
+    return patch.result;
+}
+
+static void ota_task(void *arg) {
+    // esp_ota and mbedtls allocate by design; not flagged by the heap lock
+    mem_heap_exempt(true);
+
+    while (1) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        if (state != OTA_STATE_DOWNLOADING) continue;
+
+        int64_t t0 = esp_timer_get_time();
+        stats.patch_bytes = 0;
+        stats.image_bytes = 0;
+        stats.ranges = 0;
+        stats.retries = 0;
+
+        target = esp_ota_get_next_update_partition(NULL);
+        esp_err_t err = (target != NULL) ? esp_ota_begin(target, OTA_WITH_SEQUENTIAL_WRITES, &ota_handle)
+                                         : ESP_ERR_NOT_FOUND;
+        if (err != ESP_OK) {
+            publish_status("FAILED begin %s", esp_err_to_name(err));
+            stats.last_result = OTA_PATCH_ERR_IO;
+            state = OTA_STATE_FAILED;
+            continue;
+        }
+
+        ota_patch_result_t res = run_update();
+        if (res == OTA_PATCH_DONE) {
+            err = esp_ota_end(ota_handle);      // Image format and its own SHA-256
+            if (err == ESP_OK && !standby()) res = OTA_PATCH_ERR_ABORTED;  // Mission started: keep the running image
+            if (err == ESP_OK && res == OTA_PATCH_DONE) err = esp_ota_set_boot_partition(target);
+        } else {
+            esp_ota_abort(ota_handle);
+        }
+        stats.last_result = res;
+        stats.duration_ms = (uint32_t)((esp_timer_get_time() - t0) / 1000);
+
+        if (res != OTA_PATCH_DONE || err != ESP_OK) {
+            publish_status("FAILED %s after %lu bytes",
+                           res != OTA_PATCH_DONE ? ota_patch_result_name(res) : esp_err_to_name(err),
+                           (unsigned long)stats.patch_bytes);
+            state = OTA_STATE_FAILED;
+            continue;
+        }
+
+        state = OTA_STATE_REBOOTING;
+        publish_status("DONE patch %lu bytes, image %lu bytes, %lu s (flash %lu ms), rebooting",
+                       (unsigned long)stats.patch_bytes, (unsigned long)stats.image_bytes,
+                       (unsigned long)(stats.duration_ms / 1000), (unsigned long)stats.flash_ms);
+        vTaskDelay(pdMS_TO_TICKS(OTA_REBOOT_DELAY_MS));
+        motor_disarm();
+        esp_restart();
+    }
+}
+
+/**
+ * @brief Probation checks (esp_timer task)
+ */
+static void selftest_cb(void *arg) {
+    uint32_t passed = checks_passed;
+
+    if (!(passed & OTA_CHECK_SENSORS)) {
+        bool ok = true;
+        for (int ch = 0; ch < HEALTH_CH_COUNT && ok; ch++) {
+            health_stats_t hs;
+            health_get_stats((health_channel_t)ch, &hs);
+            ok = hs.chan.samples >= HEALTH_BLOCK_LEN && hs.chan.status != HEALTH_FAILED;
+        }
+        if (ok) passed |= OTA_CHECK_SENSORS;
+    }
+    if (modem_mqtt_is_connected()) passed |= OTA_CHECK_LINK;
+
+    portENTER_CRITICAL(&ota_mux);
+    checks_passed |= passed;
+    passed = checks_passed;
+    portEXIT_CRITICAL(&ota_mux);
+
+    if ((passed & OTA_CHECKS_REQUIRED) == OTA_CHECKS_REQUIRED) {
+        esp_timer_stop(selftest_timer);
+        esp_ota_mark_app_valid_cancel_rollback();
+        state = OTA_STATE_IDLE;
+        ESP_LOGI(TAG, "Self-test passed, image confirmed");
+        return;
+    }
+    if (esp_timer_get_time() > selftest_deadline_us) {
+        ESP_LOGE(TAG, "Self-test timeout (checks 0x%lx of 0x%x): rolling back",
+                 (unsigned long)passed, OTA_CHECKS_REQUIRED);
+        motor_disarm();
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t ota_init(void) {
+    if (ota_task_handle != NULL) return ESP_OK;
+
+    running = esp_ota_get_running_partition();
+    if (running == NULL || esp_ota_get_next_update_partition(NULL) == NULL) {
+        ESP_LOGE(TAG, "No OTA slots in the partition table");
+        return ESP_ERR_NOT_FOUND;
+    }
+
+    esp_ota_img_states_t img_state;
+    if (esp_ota_get_state_partition(running, &img_state) == ESP_OK && img_state == ESP_OTA_IMG_PENDING_VERIFY) {
+        state = OTA_STATE_PROBATION;
+        selftest_deadline_us = esp_timer_get_time() + OTA_SELFTEST_TIMEOUT_MS * 1000LL;
+
+        const esp_timer_create_args_t args = {
+            .callback = selftest_cb,
+            .name = "ota_selftest",
+        };
+        esp_err_t err = esp_timer_create(&args, &selftest_timer);
+        if (err == ESP_OK) err = esp_timer_start_periodic(selftest_timer, OTA_SELFTEST_PERIOD_MS * 1000ULL);
+        if (err != ESP_OK) return err;
+        ESP_LOGW(TAG, "New image on probation (%s): self-test within %d s",
+                 running->label, OTA_SELFTEST_TIMEOUT_MS / 1000);
+    }
+
+    ota_task_handle = mem_task_create(MEM_SUB_OTA, ota_task, "ota_task", OTA_TASK_STACK, NULL,
+                                      OTA_TASK_PRIORITY, OTA_TASK_CORE);
+    if (ota_task_handle == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Running %s at 0x%lx", running->label, (unsigned long)running->address);
+    return ESP_OK;
+}
+
+esp_err_t ota_start(const char *patch_url) {
+    if (patch_url == NULL || strlen(patch_url) >= sizeof(url)) return ESP_ERR_INVALID_ARG;
+    if (ota_task_handle == NULL || !standby()) return ESP_ERR_INVALID_STATE;
+
+    portENTER_CRITICAL(&ota_mux);
+    bool busy = (state == OTA_STATE_DOWNLOADING || state == OTA_STATE_REBOOTING || state == OTA_STATE_PROBATION);
+    if (!busy) state = OTA_STATE_DOWNLOADING;
+    portEXIT_CRITICAL(&ota_mux);
+    if (busy) return ESP_ERR_INVALID_STATE;
+
+    strcpy(url, patch_url);
+    xTaskNotifyGive(ota_task_handle);
+    return ESP_OK;
+}
+
+void ota_selftest_report(ota_check_t check, bool passed) {
+    if (state != OTA_STATE_PROBATION) return;
+
+    if (!passed) {
+        ESP_LOGE(TAG, "Self-test check 0x%x failed: rolling back", check);
+        motor_disarm();
+        esp_ota_mark_app_invalid_rollback_and_reboot();
+        return;
+    }
+    portENTER_CRITICAL(&ota_mux);
+    checks_passed |= check;
+    portEXIT_CRITICAL(&ota_mux);
+}
+
+ota_state_t ota_get_state(void) {
+    return state;
+}
+
+void ota_get_stats(ota_stats_t *out) {
+    if (out == NULL) return;
+    *out = stats;
+    out->state = state;
+    out->checks_passed = checks_passed;
+}
+
+void ota_log_stats(void) {
+    ota_stats_t s;
+    ota_get_stats(&s);
+    ESP_LOGI(TAG, "state=%d last=%s patch=%lu image=%lu bytes ranges=%lu retries=%lu | %lu ms (flash %lu ms) checks=0x%lx",
+             s.state, ota_patch_result_name(s.last_result), (unsigned long)s.patch_bytes,
+             (unsigned long)s.image_bytes, (unsigned long)s.ranges, (unsigned long)s.retries,
+             (unsigned long)s.duration_ms, (unsigned long)s.flash_ms, (unsigned long)s.checks_passed);
+}
@@ -0,0 +1,473 @@
+/**
+ * @file sys_ota_patch.c
+ * @brief Streaming Patch Applier and SHA-256 (pure C, no IDF dependencies)
+ * @details
+ * Input can be split anywhere: varints and ADD/DATA payloads are consumed
+ * byte by byte across calls. COPY needs no input and runs to completion
+ * in the call that finishes its header. Source bytes are read straight
+ * into the output sector buffer (ADD adds in place), so the only RAM
+ * besides the header is that one sector. Every source access and every
+ * output byte is bounds-checked against the header sizes, so a malformed
+ * (or unsigned, on the host) patch can never read or write outside the
+ * slots.
+ */
+
+#include <string.h>
+#include "sys_ota.h"
+
+/**
+ * @brief Parser states
+ */
+enum {
+    ST_HEADER = 0,
+    ST_OP,
+    ST_LEN,
+    ST_DELTA,
+    ST_ADD,
+    ST_DATA,
+    ST_END,
+};
+
+enum {
+    OP_END = 0x00,
+    OP_COPY = 0x01,
+    OP_ADD = 0x02,
+    OP_DATA = 0x03,
+};
+
+static const uint32_t sha_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+// --- HELPER FUNCTIONS ---
+
+static uint32_t rotr(uint32_t x, int n) {
+    return (x >> n) | (x << (32 - n));
+}
+
+static void sha_block(ota_sha256_t *s, const uint8_t *b) {
+    uint32_t w[64];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t)b[4 * i] << 24) | ((uint32_t)b[4 * i + 1] << 16) |
+               ((uint32_t)b[4 * i + 2] << 8) | b[4 * i + 3];
+    }
+    for (int i = 16; i < 64; i++) {
+        uint32_t s0 = rotr(w[i - 15], 7) ^ rotr(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32_t s1 = rotr(w[i - 2], 17) ^ rotr(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32_t a = s->h[0], bb = s->h[1], c = s->h[2], d = s->h[3];
+    uint32_t e = s->h[4], f = s->h[5], g = s->h[6], h = s->h[7];
+    for (int i = 0; i < 64; i++) {
+        uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + sha_k[i] + w[i];
+        uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & bb) ^ (a & c) ^ (bb & c));
+        h = g;
+        g = f;
+        f = e;
+        e = d + t1;
+        d = c;
+        c = bb;
+        bb = a;
+        a = t1 + t2;
+    }
+    s->h[0] += a;
+    s->h[1] += bb;
+    s->h[2] += c;
+    s->h[3] += d;
+    s->h[4] += e;
+    s->h[5] += f;
+    s->h[6] += g;
+    s->h[7] += h;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static void fail(ota_patch_t *p, ota_patch_result_t r) {
+    if (p->result == OTA_PATCH_BUSY) p->result = r;
+}
+
+/**
+ * @brief Account n target bytes already placed at out[out_fill] (hashed, written per sector)
+ */
+static bool out_commit(ota_patch_t *p, uint32_t n) {
+    ota_sha256_update(&p->dst_sha, &p->out[p->out_fill], n);
+    p->out_done += n;
+    p->out_fill += (uint16_t)n;
+
+    if (p->out_fill == OTA_OUT_BYTES) {
+        p->stats.writes++;
+        if (!p->io.write_dst(p->io.ctx, p->out, OTA_OUT_BYTES)) {
+            fail(p, OTA_PATCH_ERR_IO);
+            return false;
+        }
+        p->out_fill = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Room for the next target piece (bounded by the sector buffer and dst_size)
+ * @return 0 and fails the patch if the target is already complete
+ */
+static uint32_t out_room(ota_patch_t *p, uint32_t want) {
+    uint32_t n = OTA_OUT_BYTES - p->out_fill;
+    if (n > want) n = want;
+    if (n > p->hdr.dst_size - p->out_done) {
+        fail(p, OTA_PATCH_ERR_FORMAT);
+        return 0;
+    }
+    return n;
+}
+
+static bool read_src(ota_patch_t *p, uint32_t addr, void *buf, size_t len) {
+    p->stats.src_reads++;
+    if (!p->io.read_src(p->io.ctx, addr, buf, len)) {
+        fail(p, OTA_PATCH_ERR_IO);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Header complete: sizes, signature, then the source image hash
+ */
+static void start_body(ota_patch_t *p) {
+    ota_patch_hdr_t *h = &p->hdr;
+    ota_patch_parse_header(p->hdr_raw, h);
+
+    if (h->magic != OTA_PATCH_MAGIC || h->format != OTA_PATCH_FORMAT ||
+        h->src_size > p->io.src_limit || h->dst_size == 0 || h->dst_size > p->io.dst_limit ||
+        h->body_size == 0) {
+        fail(p, OTA_PATCH_ERR_HEADER);
+        return;
+    }
+
+    uint8_t digest[OTA_HASH_BYTES];
+    ota_sha256_t sha;
+    ota_sha256_init(&sha);
+    ota_sha256_update(&sha, p->hdr_raw, OTA_HDR_SIGNED_BYTES);
+    ota_sha256_final(&sha, digest);
+    if (p->io.verify_sig != NULL && !p->io.verify_sig(p->io.ctx, digest, h->sig)) {
+        fail(p, OTA_PATCH_ERR_SIGNATURE);
+        return;
+    }
+
+    // The output buffer is still empty: use it for the source scan
+    ota_sha256_init(&sha);
+    for (uint32_t addr = 0; addr < h->src_size; addr += OTA_OUT_BYTES) {
+        uint32_t n = h->src_size - addr;
+        if (n > OTA_OUT_BYTES) n = OTA_OUT_BYTES;
+        if (!read_src(p, addr, p->out, n)) return;
+        ota_sha256_update(&sha, p->out, n);
+    }
+    ota_sha256_final(&sha, digest);
+    if (memcmp(digest, h->src_hash, OTA_HASH_BYTES) != 0) {
+        fail(p, OTA_PATCH_ERR_SOURCE);
+        return;
+    }
+    p->state = ST_OP;
+}
+
+/**
+ * @brief Accumulate a LEB128 byte
+ * @return true when the value is complete (in p->var)
+ */
+static bool varint_step(ota_patch_t *p, uint8_t b) {
+    if (p->var_shift > 28 || (p->var_shift == 28 && (b & 0x70))) {
+        fail(p, OTA_PATCH_ERR_FORMAT);
+        return false;
+    }
+    p->var |= (uint32_t)(b & 0x7F) << p->var_shift;
+    p->var_shift += 7;
+    return (b & 0x80) == 0;
+}
+
+static void varint_reset(ota_patch_t *p) {
+    p->var = 0;
+    p->var_shift = 0;
+}
+
+/**
+ * @brief Apply the source delta of a COPY / ADD and check the range
+ */
+static bool seek_src(ota_patch_t *p, uint32_t zigzag) {
+    int64_t delta = (zigzag & 1) ? -(int64_t)(zigzag >> 1) - 1 : (int64_t)(zigzag >> 1);
+    int64_t pos = (int64_t)p->src_pos + delta;
+    if (pos < 0 || pos + p->op_len > p->hdr.src_size) {
+        fail(p, OTA_PATCH_ERR_FORMAT);
+        return false;
+    }
+    p->src_pos = (uint32_t)pos;
+    return true;
+}
+
+/**
+ * @brief COPY: source read straight into the output buffer, one read per sector piece
+ */
+static void run_copy(ota_patch_t *p) {
+    while (p->op_len > 0 && p->result == OTA_PATCH_BUSY) {
+        uint32_t n = out_room(p, p->op_len);
+        if (n == 0) return;
+        if (!read_src(p, p->src_pos, &p->out[p->out_fill], n)) return;
+        p->src_pos += n;
+        p->op_len -= n;
+        p->stats.copy_bytes += n;
+        if (!out_commit(p, n)) return;
+    }
+}
+
+/**
+ * @brief Run the op stream over one input piece
+ * @return Bytes consumed
+ */
+static size_t run_body(ota_patch_t *p, const uint8_t *data, size_t len) {
+    size_t i = 0;
+
+    while (p->result == OTA_PATCH_BUSY) {
+        switch (p->state) {
+            case ST_OP:
+                if (i == len) return i;
+                p->op = data[i++];
+                p->stats.ops++;
+                varint_reset(p);
+                if (p->op == OP_END) {
+                    p->state = ST_END;
+                } else if (p->op == OP_COPY || p->op == OP_ADD || p->op == OP_DATA) {
+                    p->state = ST_LEN;
+                } else {
+                    fail(p, OTA_PATCH_ERR_FORMAT);
+                }
+                break;
+
+            case ST_LEN:
+                if (i == len) return i;
+                if (!varint_step(p, data[i++])) break;
+                p->op_len = p->var;
+                varint_reset(p);
+                if (p->op == OP_DATA) p->state = p->op_len ? ST_DATA : ST_OP;
+                else p->state = ST_DELTA;
+                break;
+
+            case ST_DELTA:
+                if (i == len) return i;
+                if (!varint_step(p, data[i++])) break;
+                if (!seek_src(p, p->var)) break;
+                if (p->op == OP_COPY) {
+                    run_copy(p);
+                    p->state = ST_OP;
+                } else {
+                    p->state = p->op_len ? ST_ADD : ST_OP;
+                }
+                break;
+
+            case ST_ADD: {
+                if (i == len) return i;
+                uint32_t want = p->op_len;
+                if (want > len - i) want = (uint32_t)(len - i);
+                uint32_t n = out_room(p, want);
+                if (n == 0) break;
+                uint8_t *o = &p->out[p->out_fill];
+                if (!read_src(p, p->src_pos, o, n)) break;
+                for (uint32_t k = 0; k < n; k++) o[k] += data[i + k];
+                i += n;
+                p->src_pos += n;
+                p->op_len -= n;
+                p->stats.add_bytes += n;
+                if (!out_commit(p, n)) break;
+                if (p->op_len == 0) p->state = ST_OP;
+                break;
+            }
+
+            case ST_DATA: {
+                if (i == len) return i;
+                uint32_t want = p->op_len;
+                if (want > len - i) want = (uint32_t)(len - i);
+                uint32_t n = out_room(p, want);
+                if (n == 0) break;
+                memcpy(&p->out[p->out_fill], &data[i], n);
+                i += n;
+                p->op_len -= n;
+                p->stats.data_bytes += n;
+                if (!out_commit(p, n)) break;
+                if (p->op_len == 0) p->state = ST_OP;
+                break;
+            }
+
+            case ST_END:
+                if (i < len) fail(p, OTA_PATCH_ERR_FORMAT);    // Data after END
+                return i;
+
+            default:
+                fail(p, OTA_PATCH_ERR_FORMAT);
+                break;
+        }
+    }
+    return i;
+}
+
+/**
+ * @brief END reached: flush the last sector, check sizes and hashes
+ */
+static void finish(ota_patch_t *p) {
+    if (p->out_fill > 0) {
+        p->stats.writes++;
+        if (!p->io.write_dst(p->io.ctx, p->out, p->out_fill)) {
+            fail(p, OTA_PATCH_ERR_IO);
+            return;
+        }
+        p->out_fill = 0;
+    }
+
+    uint8_t digest[OTA_HASH_BYTES];
+    if (p->body_done != p->hdr.body_size) {
+        fail(p, OTA_PATCH_ERR_FORMAT);
+        return;
+    }
+    ota_sha256_final(&p->body_sha, digest);
+    if (memcmp(digest, p->hdr.body_hash, OTA_HASH_BYTES) != 0) {
+        fail(p, OTA_PATCH_ERR_BODY_HASH);
+        return;
+    }
+    ota_sha256_final(&p->dst_sha, digest);
+    if (p->out_done != p->hdr.dst_size || memcmp(digest, p->hdr.dst_hash, OTA_HASH_BYTES) != 0) {
+        fail(p, OTA_PATCH_ERR_IMAGE_HASH);
+        return;
+    }
+    p->result = OTA_PATCH_DONE;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void ota_sha256_init(ota_sha256_t *s) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    memcpy(s->h, iv, sizeof(iv));
+    s->bytes = 0;
+    s->fill = 0;
+}
+
+void ota_sha256_update(ota_sha256_t *s, const void *data, size_t len) {
+    const uint8_t *d = data;
+    s->bytes += len;
+
+    if (s->fill > 0) {
+        size_t n = 64 - s->fill;
+        if (n > len) n = len;
+        memcpy(&s->block[s->fill], d, n);
+        s->fill += (uint8_t)n;
+        d += n;
+        len -= n;
+        if (s->fill < 64) return;
+        sha_block(s, s->block);
+        s->fill = 0;
+    }
+    while (len >= 64) {
+        sha_block(s, d);
+        d += 64;
+        len -= 64;
+    }
+    memcpy(s->block, d, len);
+    s->fill = (uint8_t)len;
+}
+
+void ota_sha256_final(ota_sha256_t *s, uint8_t out[OTA_HASH_BYTES]) {
+    uint64_t bits = s->bytes * 8;
+
+    s->block[s->fill++] = 0x80;
+    if (s->fill > 56) {
+        memset(&s->block[s->fill], 0, 64 - s->fill);
+        sha_block(s, s->block);
+        s->fill = 0;
+    }
+    memset(&s->block[s->fill], 0, 56 - s->fill);
+    for (int i = 0; i < 8; i++) s->block[56 + i] = (uint8_t)(bits >> (56 - 8 * i));
+    sha_block(s, s->block);
+
+    for (int i = 0; i < 8; i++) {
+        out[4 * i] = (uint8_t)(s->h[i] >> 24);
+        out[4 * i + 1] = (uint8_t)(s->h[i] >> 16);
+        out[4 * i + 2] = (uint8_t)(s->h[i] >> 8);
+        out[4 * i + 3] = (uint8_t)s->h[i];
+    }
+}
+
+void ota_patch_parse_header(const uint8_t raw[OTA_HDR_BYTES], ota_patch_hdr_t *out) {
+    out->magic = get32(&raw[0]);
+    out->format = get16(&raw[4]);
+    out->reserved = get16(&raw[6]);
+    out->src_size = get32(&raw[8]);
+    out->dst_size = get32(&raw[12]);
+    out->body_size = get32(&raw[16]);
+    memcpy(out->src_hash, &raw[20], OTA_HASH_BYTES);
+    memcpy(out->dst_hash, &raw[52], OTA_HASH_BYTES);
+    memcpy(out->body_hash, &raw[84], OTA_HASH_BYTES);
+    memcpy(out->sig, &raw[OTA_HDR_SIGNED_BYTES], OTA_SIG_BYTES);
+}
+
+void ota_patch_init(ota_patch_t *p, const ota_patch_io_t *io) {
+    memset(p, 0, sizeof(*p));
+    p->io = *io;
+    p->state = ST_HEADER;
+    p->result = OTA_PATCH_BUSY;
+    ota_sha256_init(&p->body_sha);
+    ota_sha256_init(&p->dst_sha);
+}
+
+ota_patch_result_t ota_patch_feed(ota_patch_t *p, const uint8_t *data, size_t len) {
+    if (p->state == ST_HEADER && p->result == OTA_PATCH_BUSY && len > 0) {
+        size_t n = OTA_HDR_BYTES - p->hdr_fill;
+        if (n > len) n = len;
+        memcpy(&p->hdr_raw[p->hdr_fill], data, n);
+        p->hdr_fill += (uint16_t)n;
+        data += n;
+        len -= n;
+        if (p->hdr_fill == OTA_HDR_BYTES) start_body(p);
+    }
+    if (p->result != OTA_PATCH_BUSY || p->state == ST_HEADER) return p->result;
+
+    size_t used = run_body(p, data, len);
+    if (used > p->hdr.body_size - p->body_done) {
+        fail(p, OTA_PATCH_ERR_FORMAT);
+        return p->result;
+    }
+    ota_sha256_update(&p->body_sha, data, used);
+    p->body_done += (uint32_t)used;
+
+    if (p->state == ST_END && p->result == OTA_PATCH_BUSY) finish(p);
+    return p->result;
+}
+
+bool ota_patch_header_ok(const ota_patch_t *p) {
+    return p->state != ST_HEADER;
+}
+
+const char *ota_patch_result_name(ota_patch_result_t r) {
+    switch (r) {
+        case OTA_PATCH_BUSY:            return "BUSY";
+        case OTA_PATCH_DONE:            return "DONE";
+        case OTA_PATCH_ERR_HEADER:      return "ERR_HEADER";
+        case OTA_PATCH_ERR_SIGNATURE:   return "ERR_SIGNATURE";
+        case OTA_PATCH_ERR_SOURCE:      return "ERR_SOURCE";
+        case OTA_PATCH_ERR_FORMAT:      return "ERR_FORMAT";
+        case OTA_PATCH_ERR_IO:          return "ERR_IO";
+        case OTA_PATCH_ERR_BODY_HASH:   return "ERR_BODY_HASH";
+        case OTA_PATCH_ERR_IMAGE_HASH:  return "ERR_IMAGE_HASH";
+        case OTA_PATCH_ERR_ABORTED:     return "ERR_ABORTED";
+        default:                        return "?";
+    }
+}
@@ -0,0 +1,113 @@
+/**
+ * @file sys_param.c
+ * @brief Parameter Registry NVS Persistence
+ * @details
+ * I32 values are stored with nvs_set_i32(), F32 values as their bit
+ * pattern with nvs_set_u32(). Loading goes through sysparam_apply(), so a
+ * stored value outside the current range is ignored.
+ */
+
+#include <string.h>
+#include "sys_param.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+#include "esp_log.h"
+
+static const char *TAG = "SYS_PARAM";
+
+// PRIVATE STATIC VARIABLES
+static nvs_handle_t nvs = 0;
+static bool is_initialized = false;
+
+// --- HELPER FUNCTIONS ---
+
+static esp_err_t nvs_ready(void) {
+    esp_err_t err = nvs_flash_init();
+    if (err == ESP_ERR_NVS_NO_FREE_PAGES || err == ESP_ERR_NVS_NEW_VERSION_FOUND) {
+        ESP_LOGW(TAG, "NVS partition unusable, erasing");
+        err = nvs_flash_erase();
+        if (err != ESP_OK) return err;
+        err = nvs_flash_init();
+    }
+    return err;
+}
+
+static bool load_one(sysparam_id_t id) {
+    const sysparam_desc_t *d = sysparam_desc(id);
+
+    if (d->type == SYSPARAM_TYPE_I32) {
+        int32_t v;
+        if (nvs_get_i32(nvs, d->name, &v) != ESP_OK) return false;
+        return sysparam_apply(id, (float)v);
+    }
+
+    uint32_t bits;
+    float v;
+    if (nvs_get_u32(nvs, d->name, &bits) != ESP_OK) return false;
+    memcpy(&v, &bits, sizeof(v));
+    return sysparam_apply(id, v);
+}
+
+static esp_err_t save_one(sysparam_id_t id) {
+    const sysparam_desc_t *d = sysparam_desc(id);
+
+    if (d->type == SYSPARAM_TYPE_I32) {
+        return nvs_set_i32(nvs, d->name, (int32_t)sysparam_value(id));
+    }
+    float v = sysparam_value(id);
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    return nvs_set_u32(nvs, d->name, bits);
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t sysparam_init(void) {
+    if (is_initialized) return ESP_OK;
+
+    sysparam_reset_defaults();
+
+    esp_err_t err = nvs_ready();
+    if (err != ESP_OK) return err;
+    err = nvs_open(SYSPARAM_NVS_NAMESPACE, NVS_READWRITE, &nvs);
+    if (err != ESP_OK) return err;
+
+    int loaded = 0;
+    for (int i = 0; i < SYSPARAM_COUNT; i++) {
+        if (load_one((sysparam_id_t)i)) loaded++;
+    }
+
+    is_initialized = true;
+    ESP_LOGI(TAG, "%d/%d parameters loaded from NVS", loaded, SYSPARAM_COUNT);
+    return ESP_OK;
+}
+
+esp_err_t sysparam_set(sysparam_id_t id, float value) {
+    if (!sysparam_apply(id, value)) return ESP_ERR_INVALID_ARG;
+    if (!is_initialized) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t err = save_one(id);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "%s applied but not saved (%s)", sysparam_desc(id)->name, esp_err_to_name(err));
+    }
+    return err;
+}
+
+esp_err_t sysparam_reset(void) {
+    sysparam_reset_defaults();
+    if (!is_initialized) return ESP_ERR_INVALID_STATE;
+
+    esp_err_t err = nvs_erase_all(nvs);
+    if (err == ESP_OK) err = nvs_commit(nvs);
+    return err;
+}
+
+void sysparam_log(void) {
+    char line[SYSPARAM_TEXT_MAX];
+    for (int i = 0; i < SYSPARAM_COUNT; i++) {
+        if (sysparam_format((sysparam_id_t)i, line, sizeof(line)) > 0) {
+            ESP_LOGI(TAG, "%s", line);
+        }
+    }
+}
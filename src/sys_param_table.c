@@ -0,0 +1,99 @@
+/**
+ * @file sys_param_table.c
+ * @brief Parameter Descriptors & Value Helpers (pure C, no IDF dependencies)
+ */
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sys_param.h"
+
+sysparam_values_t sysparam = {
+#define SYSPARAM_X_INIT(id, name, type, def, min, max)  .name = def,
+    SYSPARAM_TABLE(SYSPARAM_X_INIT)
+#undef SYSPARAM_X_INIT
+};
+
+static const sysparam_desc_t descs[SYSPARAM_COUNT] = {
+#define SYSPARAM_X_DESC(id, name, type, def, min, max) \
+    [SYSPARAM_##id] = { #name, SYSPARAM_TYPE_##type, offsetof(sysparam_values_t, name), def, min, max },
+    SYSPARAM_TABLE(SYSPARAM_X_DESC)
+#undef SYSPARAM_X_DESC
+};
+
+// Names double as NVS keys
+#define SYSPARAM_X_KEYLEN(id, name, type, def, min, max) \
+    _Static_assert(sizeof(#name) <= SYSPARAM_NAME_MAX, "parameter name too long for NVS: " #name);
+SYSPARAM_TABLE(SYSPARAM_X_KEYLEN)
+#undef SYSPARAM_X_KEYLEN
+
+// --- HELPER FUNCTIONS ---
+
+static void *field(const sysparam_desc_t *d) {
+    return (uint8_t *)&sysparam + d->offset;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void sysparam_reset_defaults(void) {
+    for (int i = 0; i < SYSPARAM_COUNT; i++) sysparam_apply((sysparam_id_t)i, descs[i].def);
+}
+
+const sysparam_desc_t *sysparam_desc(sysparam_id_t id) {
+    return (id < SYSPARAM_COUNT) ? &descs[id] : NULL;
+}
+
+sysparam_id_t sysparam_find(const char *name, size_t len) {
+    for (int i = 0; i < SYSPARAM_COUNT; i++) {
+        if (strlen(descs[i].name) == len && memcmp(descs[i].name, name, len) == 0) return (sysparam_id_t)i;
+    }
+    return SYSPARAM_COUNT;
+}
+
+bool sysparam_apply(sysparam_id_t id, float value) {
+    const sysparam_desc_t *d = sysparam_desc(id);
+    if (d == NULL || !(value >= d->min && value <= d->max)) return false;     // Also rejects NaN
+
+    // Single aligned 32-bit store
+    if (d->type == SYSPARAM_TYPE_I32) {
+        *(volatile int32_t *)field(d) = (int32_t)lroundf(value);
+    } else {
+        *(volatile float *)field(d) = value;
+    }
+    return true;
+}
+
+float sysparam_value(sysparam_id_t id) {
+    const sysparam_desc_t *d = sysparam_desc(id);
+    if (d == NULL) return 0.0f;
+    return (d->type == SYSPARAM_TYPE_I32) ? (float)*(const int32_t *)field(d) : *(const float *)field(d);
+}
+
+bool sysparam_parse(sysparam_id_t id, const char *text, size_t len, float *out) {
+    const sysparam_desc_t *d = sysparam_desc(id);
+    char buf[SYSPARAM_TEXT_MAX];
+    if (d == NULL || len == 0 || len >= sizeof(buf)) return false;
+
+    memcpy(buf, text, len);
+    buf[len] = '\0';
+
+    char *end;
+    if (d->type == SYSPARAM_TYPE_I32) {
+        long v = strtol(buf, &end, 10);
+        *out = (float)v;
+    } else {
+        *out = strtof(buf, &end);
+    }
+    return *end == '\0';
+}
+
+size_t sysparam_format(sysparam_id_t id, char *buf, size_t size) {
+    const sysparam_desc_t *d = sysparam_desc(id);
+    if (d == NULL || buf == NULL) return 0;
+
+    int n = (d->type == SYSPARAM_TYPE_I32)
+          ? snprintf(buf, size, "%s=%ld", d->name, (long)*(const int32_t *)field(d))
+          : snprintf(buf, size, "%s=%g", d->name, (double)*(const float *)field(d));
+    return (n > 0 && (size_t)n < size) ? (size_t)n : 0;
+}
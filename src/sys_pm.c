@@ -0,0 +1,195 @@
+/**
+ * @file sys_pm.c
+ * @brief DFS Profiles & Subsystem PM Locks Implementation
+ */
+
+#include "sys_pm.h"
+#include "esp_pm.h"
+#include "esp_private/esp_clk.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+
+static const char *TAG = "SYS_PM";
+
+/**
+ * @brief DFS profile of one mission state
+ */
+typedef struct {
+    uint16_t max_mhz;
+    uint16_t min_mhz;
+} pm_profile_t;
+
+static const pm_profile_t profiles[MISSION_STATE_COUNT] = {
+    [MISSION_STANDBY]       = { SYSPM_STANDBY_MAX_MHZ, SYSPM_STANDBY_MIN_MHZ },
+    [MISSION_DISPATCH]      = { SYSPM_ACTIVE_MAX_MHZ,  SYSPM_ACTIVE_MIN_MHZ },
+    [MISSION_COURSE_LOCK]   = { SYSPM_ACTIVE_MAX_MHZ,  SYSPM_ACTIVE_MIN_MHZ },
+    [MISSION_FINE_APPROACH] = { SYSPM_ACTIVE_MAX_MHZ,  SYSPM_ACTIVE_MIN_MHZ },
+    [MISSION_RESCUE]        = { SYSPM_RESCUE_MAX_MHZ,  SYSPM_RESCUE_MIN_MHZ },
+    [MISSION_RTH]           = { SYSPM_ACTIVE_MAX_MHZ,  SYSPM_ACTIVE_MIN_MHZ },
+};
+
+static const struct {
+    esp_pm_lock_type_t type;
+    const char *name;
+} lock_defs[SYSPM_LOCK_COUNT] = {
+    [SYSPM_LOCK_CTRL]       = { ESP_PM_CPU_FREQ_MAX, "frd_ctrl" },
+    [SYSPM_LOCK_MODEM]      = { ESP_PM_APB_FREQ_MAX, "frd_modem" },
+    [SYSPM_LOCK_ULTRASONIC] = { ESP_PM_CPU_FREQ_MAX, "frd_us" },
+    [SYSPM_LOCK_LOADCELL]   = { ESP_PM_CPU_FREQ_MAX, "frd_hx711" },
+};
+
+static const char *const level_names[SYSPM_LEVEL_COUNT] = { "max", "apb", "min" };
+
+// PRIVATE STATIC VARIABLES
+static portMUX_TYPE pm_mux = portMUX_INITIALIZER_UNLOCKED;
+static esp_pm_lock_handle_t handles[SYSPM_LOCK_COUNT];
+static uint16_t holds[SYSPM_LOCK_COUNT];
+static int64_t held_since[SYSPM_LOCK_COUNT];
+static mission_state_t pm_state = MISSION_STANDBY;
+static int64_t last_account_us = 0;
+static syspm_stats_t stats;
+static bool is_initialized = false;
+
+// --- HELPER FUNCTIONS ---
+
+static syspm_level_t current_level(void) {
+    bool apb = false;
+    for (int i = 0; i < SYSPM_LOCK_COUNT; i++) {
+        if (holds[i] == 0) continue;
+        if (lock_defs[i].type == ESP_PM_CPU_FREQ_MAX) return SYSPM_LEVEL_MAX;
+        apb = true;
+    }
+    return apb ? SYSPM_LEVEL_APB : SYSPM_LEVEL_MIN;
+}
+
+/**
+ * @brief Charge the time since the last transition to the current state/level
+ * @note Call with pm_mux held
+ */
+static void account(int64_t now) {
+    stats.time_us[pm_state][current_level()] += (uint64_t)(now - last_account_us);
+    last_account_us = now;
+}
+
+static esp_err_t apply_profile(mission_state_t state) {
+    esp_pm_config_t cfg = {
+        .max_freq_mhz = profiles[state].max_mhz,
+        .min_freq_mhz = profiles[state].min_mhz,
+        .light_sleep_enable = false,    // STANDBY uses forced light sleep (sys_standby)
+    };
+    return esp_pm_configure(&cfg);
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t syspm_init(void) {
+    if (is_initialized) return ESP_OK;
+
+    for (int i = 0; i < SYSPM_LOCK_COUNT; i++) {
+        esp_err_t err = esp_pm_lock_create(lock_defs[i].type, 0, lock_defs[i].name, &handles[i]);
+        if (err != ESP_OK) return err;
+    }
+
+    pm_state = mission_get_state();
+    esp_err_t err = apply_profile(pm_state);
+    if (err != ESP_OK) return err;
+
+    last_account_us = esp_timer_get_time();
+    is_initialized = true;
+    ESP_LOGI(TAG, "DFS on: %s %u-%u MHz", mission_state_name(pm_state),
+             profiles[pm_state].min_mhz, profiles[pm_state].max_mhz);
+    return ESP_OK;
+}
+
+void syspm_acquire(syspm_lock_t lock) {
+    if (!is_initialized || lock >= SYSPM_LOCK_COUNT) return;
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&pm_mux);
+    account(now);
+    if (holds[lock]++ == 0) held_since[lock] = now;
+    stats.locks[lock].acquires++;
+    uint16_t expect_mhz = profiles[pm_state].max_mhz;
+    portEXIT_CRITICAL(&pm_mux);
+
+    // Frequency switch happens inside the acquire
+    esp_pm_lock_acquire(handles[lock]);
+
+    if (lock_defs[lock].type == ESP_PM_CPU_FREQ_MAX) {
+        bool miss = (esp_clk_cpu_freq() / 1000000) < expect_mhz;
+        portENTER_CRITICAL(&pm_mux);
+        stats.freq_checks++;
+        if (miss) stats.freq_misses++;
+        portEXIT_CRITICAL(&pm_mux);
+    }
+}
+
+void syspm_release(syspm_lock_t lock) {
+    if (!is_initialized || lock >= SYSPM_LOCK_COUNT) return;
+
+    int64_t now = esp_timer_get_time();
+    portENTER_CRITICAL(&pm_mux);
+    if (holds[lock] == 0) {
+        portEXIT_CRITICAL(&pm_mux);
+        return;
+    }
+    account(now);
+    if (--holds[lock] == 0) {
+        uint32_t held = (uint32_t)(now - held_since[lock]);
+        stats.locks[lock].held_us += held;
+        if (held > stats.locks[lock].held_max_us) stats.locks[lock].held_max_us = held;
+    }
+    portEXIT_CRITICAL(&pm_mux);
+
+    esp_pm_lock_release(handles[lock]);
+}
+
+void syspm_on_mission_state(mission_state_t state) {
+    if (!is_initialized || state >= MISSION_STATE_COUNT) return;
+
+    portENTER_CRITICAL(&pm_mux);
+    account(esp_timer_get_time());
+    bool changed = (profiles[state].max_mhz != profiles[pm_state].max_mhz ||
+                    profiles[state].min_mhz != profiles[pm_state].min_mhz);
+    pm_state = state;
+    portEXIT_CRITICAL(&pm_mux);
+
+    if (changed && apply_profile(state) != ESP_OK) {
+        stats.profile_errors++;
+        ESP_LOGE(TAG, "DFS profile for %s rejected", mission_state_name(state));
+    }
+}
+
+void syspm_get_stats(syspm_stats_t *out) {
+    if (out == NULL) return;
+
+    portENTER_CRITICAL(&pm_mux);
+    if (is_initialized) account(esp_timer_get_time());
+    *out = stats;
+    portEXIT_CRITICAL(&pm_mux);
+}
+
+void syspm_log_stats(void) {
+    static syspm_stats_t s;     // ~250 bytes, keep it off the caller's stack
+    syspm_get_stats(&s);
+
+    for (int st = 0; st < MISSION_STATE_COUNT; st++) {
+        uint64_t total = 0;
+        for (int l = 0; l < SYSPM_LEVEL_COUNT; l++) total += s.time_us[st][l];
+        if (total == 0) continue;
+
+        ESP_LOGI(TAG, "%-13s %7lu s | %s %3u MHz %5.1f%% | %s %3u MHz %5.1f%% | %s %3u MHz %5.1f%%",
+                 mission_state_name(st), (unsigned long)(total / 1000000),
+                 level_names[SYSPM_LEVEL_MAX], profiles[st].max_mhz, 100.0 * s.time_us[st][SYSPM_LEVEL_MAX] / total,
+                 level_names[SYSPM_LEVEL_APB], SYSPM_APB_MHZ, 100.0 * s.time_us[st][SYSPM_LEVEL_APB] / total,
+                 level_names[SYSPM_LEVEL_MIN], profiles[st].min_mhz, 100.0 * s.time_us[st][SYSPM_LEVEL_MIN] / total);
+    }
+    for (int i = 0; i < SYSPM_LOCK_COUNT; i++) {
+        ESP_LOGI(TAG, "Lock %-10s acquires %lu | held %lu ms (max %lu us)",
+                 lock_defs[i].name, (unsigned long)s.locks[i].acquires,
+                 (unsigned long)(s.locks[i].held_us / 1000), (unsigned long)s.locks[i].held_max_us);
+    }
+    ESP_LOGI(TAG, "Full-speed checks %lu, misses %lu | profile errors %lu",
+             (unsigned long)s.freq_checks, (unsigned long)s.freq_misses, (unsigned long)s.profile_errors);
+}
@@ -0,0 +1,295 @@
+/**
+ * @file sys_standby.c
+ * @brief Low-Power STANDBY Implementation
+ * @details
+ * The ULP program is built at runtime with the ULP FSM macros (no extra
+ * toolchain step). It averages 4 ADC1 samples of the battery divider,
+ * stores the result in RTC slow memory and wakes the CPU below a
+ * threshold. After each battery wake the threshold moves one level down
+ * (MIN -> CRIT -> never), so a flat battery cannot cause a wake storm.
+ */
+
+#include <string.h>
+#include "sys_standby.h"
+#include "cal_battery.h"
+#include "drv_modem.h"
+#include "drv_motor.h"
+#include "drv_ultrasonic.h"
+#include "ctrl_heading.h"
+#include "sys_time.h"
+#include "sys_param.h"
+#include "ulp.h"
+#include "ulp_adc.h"
+#include "soc/soc.h"
+#include "driver/gpio.h"
+#include "esp_sleep.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "app_config.h"
+
+#ifndef RTC_SLOW_MEM
+#define RTC_SLOW_MEM            ((uint32_t *)SOC_RTC_DATA_LOW)
+#endif
+
+static const char *TAG = "STANDBY";
+
+// PRIVATE CONFIGURATION
+#define ULP_PROG_ADDR           0           // Words into RTC slow memory
+#define ULP_VAR_BATT_RAW        96          // Word written by the ULP (inside the reserved 512B)
+#define ULP_ADC_FULL_MV         1250        // ADC_ATTEN_DB_2_5, uncalibrated
+#define ULP_ADC_FULL_RAW        4095
+
+/**
+ * @brief Battery wake levels, stepped down after each battery wake
+ */
+typedef enum {
+    LEVEL_MIN = 0,
+    LEVEL_CRIT,
+    LEVEL_NONE,                 // Keep sampling, never wake
+} batt_level_t;
+
+// PRIVATE STATIC VARIABLES
+static loadcell_t *cells[STANDBY_MAX_LOADCELLS];
+static size_t cell_count = 0;
+static bool is_initialized = false;
+static bool in_standby = false;
+static batt_level_t batt_level = LEVEL_MIN;
+static int64_t enter_us = 0;
+static int64_t last_wake_us = 0;
+static standby_stats_t stats;
+
+// --- HELPER FUNCTIONS ---
+
+static uint16_t volts_to_raw(float volts) {
+    float mv = volts * 1000.0f / sysparam.batt_div_ratio;
+    return (uint16_t)(mv * ULP_ADC_FULL_RAW / ULP_ADC_FULL_MV);
+}
+
+static esp_err_t ulp_load(batt_level_t level) {
+    uint16_t threshold = 0;                         // R0 < 0 never true
+    if (level == LEVEL_MIN) threshold = volts_to_raw(BATTERY_MIN_V);
+    if (level == LEVEL_CRIT) threshold = volts_to_raw(BATTERY_CRIT_V);
+
+    const ulp_insn_t program[] = {
+        I_ADC(R1, 0, ADC_CHANNEL),
+        I_ADC(R2, 0, ADC_CHANNEL),
+        I_ADDR(R1, R1, R2),
+        I_ADC(R2, 0, ADC_CHANNEL),
+        I_ADDR(R1, R1, R2),
+        I_ADC(R2, 0, ADC_CHANNEL),
+        I_ADDR(R1, R1, R2),
+        I_RSHI(R0, R1, 2),                          // Average of 4
+        I_MOVI(R3, ULP_VAR_BATT_RAW),
+        I_ST(R0, R3, 0),
+        M_BL(1, threshold),
+        I_HALT(),
+        M_LABEL(1),
+        I_WAKE(),
+        I_HALT(),
+    };
+    // Let a running program reach HALT before overwriting it
+    ulp_timer_stop();
+    vTaskDelay(pdMS_TO_TICKS(10));
+
+    size_t size = sizeof(program) / sizeof(ulp_insn_t);
+    esp_err_t err = ulp_process_macros_and_load(ULP_PROG_ADDR, program, &size);
+    if (err != ESP_OK) return err;
+    return ulp_run(ULP_PROG_ADDR);
+}
+
+static esp_err_t ulp_start(void) {
+    ulp_adc_cfg_t cfg = {
+        .adc_n = ADC_UNIT,
+        .channel = ADC_CHANNEL,
+        .atten = ADC_ATTEN,
+        .width = ADC_BITWIDTH_DEFAULT,
+        .ulp_mode = ADC_ULP_MODE_FSM,
+    };
+    esp_err_t err = ulp_adc_init(&cfg);
+    if (err != ESP_OK) return err;
+
+    RTC_SLOW_MEM[ULP_VAR_BATT_RAW] = 0;
+    err = ulp_set_wakeup_period(0, STANDBY_ULP_PERIOD_MS * 1000);
+    if (err != ESP_OK) return err;
+    return ulp_load(batt_level);
+}
+
+static void ulp_stop(void) {
+    ulp_timer_stop();
+    ulp_adc_deinit();
+}
+
+static void wait_ri_released(void) {
+    int64_t start = systime_now_us();
+    while (gpio_get_level(PIN_MODEM_RI) == 0 &&
+           systime_now_us() - start < STANDBY_RI_RELEASE_MS * 1000LL) {
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void record_latency(uint32_t us, uint32_t *last, uint32_t *max) {
+    *last = us;
+    if (us > *max) *max = us;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t standby_init(loadcell_t *const *loadcells, size_t count) {
+    if (count > STANDBY_MAX_LOADCELLS || (count > 0 && loadcells == NULL)) return ESP_ERR_INVALID_ARG;
+
+    for (size_t i = 0; i < count; i++) cells[i] = loadcells[i];
+    cell_count = count;
+
+    gpio_config_t conf_ri = {
+        .pin_bit_mask = (1ULL << PIN_MODEM_RI),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_ENABLE,
+        .pull_down_en = GPIO_PULLDOWN_DISABLE,
+        .intr_type = GPIO_INTR_DISABLE,
+    };
+    esp_err_t err = gpio_config(&conf_ri);
+    if (err != ESP_OK) return err;
+
+    is_initialized = true;
+    return ESP_OK;
+}
+
+esp_err_t standby_enter(void) {
+    if (!is_initialized || in_standby) return ESP_ERR_INVALID_STATE;
+
+    // Thrust off first
+    ctrl_heading_stop();
+    motor_disarm();
+
+    for (size_t i = 0; i < cell_count; i++) loadcell_power_down(cells[i]);
+
+    gpio_set_level(FRONT_ULTRASONIC_TRIG, 0);
+    gpio_set_level(LEFT_ULTRASONIC_TRIG, 0);
+    gpio_set_level(RIGHT_ULTRASONIC_TRIG, 0);
+    gpio_hold_en(FRONT_ULTRASONIC_TRIG);
+    gpio_hold_en(LEFT_ULTRASONIC_TRIG);
+    gpio_hold_en(RIGHT_ULTRASONIC_TRIG);
+
+    // Battery ADC -> ULP
+    battery_deinit();
+    batt_level = LEVEL_MIN;
+    esp_err_t err = ulp_start();
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "ULP start failed (%s), battery unwatched", esp_err_to_name(err));
+    }
+
+    if (!modem_set_low_power(true)) {
+        ESP_LOGW(TAG, "Modem busy, staying in full-power mode");
+    }
+
+    esp_sleep_enable_ulp_wakeup();
+    gpio_wakeup_enable(PIN_MODEM_RI, GPIO_INTR_LOW_LEVEL);
+    esp_sleep_enable_gpio_wakeup();
+
+    in_standby = true;
+    enter_us = systime_now_us();
+    ESP_LOGI(TAG, "Entered standby");
+    return ESP_OK;
+}
+
+standby_wake_t standby_sleep(uint32_t max_ms) {
+    if (!in_standby) return STANDBY_WAKE_OTHER;
+
+    // A held-low RI would wake us straight away
+    wait_ri_released();
+
+    esp_sleep_enable_timer_wakeup((uint64_t)max_ms * 1000ULL);
+    modem_sleep(true);
+
+    int64_t t_sleep = systime_now_us();
+    esp_light_sleep_start();
+    int64_t t_wake = systime_now_us();
+
+    esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+    modem_sleep(false);
+
+    stats.sleeps++;
+    stats.asleep_us += (uint64_t)(t_wake - t_sleep);
+    stats.battery_raw = (uint16_t)(RTC_SLOW_MEM[ULP_VAR_BATT_RAW] & 0xFFFF);
+    record_latency((uint32_t)(systime_now_us() - t_wake),
+                   &stats.wake_latency_last_us, &stats.wake_latency_max_us);
+    last_wake_us = t_wake;
+
+    switch (cause) {
+        case ESP_SLEEP_WAKEUP_TIMER:
+            stats.wakes_timer++;
+            return STANDBY_WAKE_TIMER;
+        case ESP_SLEEP_WAKEUP_GPIO:
+            stats.wakes_modem++;
+            return STANDBY_WAKE_MODEM;
+        case ESP_SLEEP_WAKEUP_ULP:
+            stats.wakes_battery++;
+            if (batt_level < LEVEL_NONE) batt_level++;
+            ulp_load(batt_level);
+            ESP_LOGW(TAG, "Battery low in standby: %lu mV", (unsigned long)standby_battery_mv());
+            return STANDBY_WAKE_BATTERY;
+        default:
+            return STANDBY_WAKE_OTHER;
+    }
+}
+
+esp_err_t standby_exit(void) {
+    if (!in_standby) return ESP_ERR_INVALID_STATE;
+
+    esp_sleep_disable_wakeup_source(ESP_SLEEP_WAKEUP_ALL);
+    gpio_wakeup_disable(PIN_MODEM_RI);
+
+    modem_set_low_power(false);
+
+    ulp_stop();
+    battery_init();
+
+    gpio_hold_dis(FRONT_ULTRASONIC_TRIG);
+    gpio_hold_dis(LEFT_ULTRASONIC_TRIG);
+    gpio_hold_dis(RIGHT_ULTRASONIC_TRIG);
+    ultrasonic_init();
+
+    // PWM back at idle: ESCs re-arm while the load cells settle
+    motor_stop_all();
+
+    for (size_t i = 0; i < cell_count; i++) loadcell_power_up(cells[i]);
+    vTaskDelay(pdMS_TO_TICKS(STANDBY_LC_SETTLE_MS));
+    for (size_t i = 0; i < cell_count; i++) loadcell_read_raw(cells[i]);   // Discard first conversion
+
+    int64_t now = systime_now_us();
+    if (last_wake_us != 0) {
+        record_latency((uint32_t)(now - last_wake_us),
+                       &stats.wake_to_ready_last_us, &stats.wake_to_ready_max_us);
+    }
+    stats.standby_us += (uint64_t)(now - enter_us);
+    in_standby = false;
+    last_wake_us = 0;
+
+    ESP_LOGI(TAG, "Ready %lu ms after wake", (unsigned long)(stats.wake_to_ready_last_us / 1000));
+    return ESP_OK;
+}
+
+uint32_t standby_battery_mv(void) {
+    uint32_t raw = stats.battery_raw;
+    return (uint32_t)((float)(raw * ULP_ADC_FULL_MV / ULP_ADC_FULL_RAW) * sysparam.batt_div_ratio);
+}
+
+void standby_get_stats(standby_stats_t *out) {
+    if (out == NULL) return;
+    *out = stats;
+}
+
+void standby_log_stats(void) {
+    standby_stats_t s = stats;
+    if (in_standby) s.standby_us += (uint64_t)(systime_now_us() - enter_us);
+    float asleep_pct = (s.standby_us > 0) ? (float)s.asleep_us * 100.0f / (float)s.standby_us : 0.0f;
+
+    ESP_LOGI(TAG, "Sleeps: %lu (timer %lu, modem %lu, battery %lu) | Asleep %.1f%% of standby",
+             (unsigned long)s.sleeps, (unsigned long)s.wakes_timer, (unsigned long)s.wakes_modem,
+             (unsigned long)s.wakes_battery, asleep_pct);
+    ESP_LOGI(TAG, "Wake -> modem %lu us (max %lu) | Wake -> ready %lu ms (max %lu) | ULP batt %lu mV",
+             (unsigned long)s.wake_latency_last_us, (unsigned long)s.wake_latency_max_us,
+             (unsigned long)(s.wake_to_ready_last_us / 1000), (unsigned long)(s.wake_to_ready_max_us / 1000),
+             (unsigned long)standby_battery_mv());
+}
@@ -0,0 +1,155 @@
+/**
+ * @file sys_telemetry.c
+ * @brief Telemetry Task (sampling, batching, MQTT publish)
+ * @details
+ * A low-priority task samples at the configured rate and appends frames to
+ * the current batch. The batch is published (QoS 0, payload copied by the
+ * modem driver) when it holds TLM_BATCH_MAX_FRAMES, is older than
+ * TLM_BATCH_MAX_AGE_MS or runs out of space. Publishing never waits: while
+ * the link is down (or older batches are still stored) batches go to the
+ * flash log and are replayed in order, QoS 1, once the link is back.
+ */
+
+#include <string.h>
+#include "sys_telemetry.h"
+#include "sys_mem.h"
+#include "sys_mission.h"
+#include "sys_health.h"
+#include "drv_modem.h"
+#include "sys_flashlog.h"
+#include "sys_deadline.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+static const char *TAG = "TELEMETRY";
+
+_Static_assert(MEM_TASK_BYTES(TLM_TASK_STACK) <= MEM_BUDGET_TLM,
+               "tlm_task over the MEM_BUDGET_TABLE entry");
+
+// PRIVATE STATIC VARIABLES
+static tlm_encoder_t encoder;
+static tlm_fill_cb_t fill_cb = NULL;
+static void *fill_ctx = NULL;
+static uint16_t period_ms = 1000;
+static bool is_running = false;
+static dl_id_t dl_id;
+static tlm_stats_t stats;
+
+// --- HELPER FUNCTIONS ---
+
+/**
+ * @brief Replayed batch confirmed (PUBACK) or failed: consume or retry it
+ */
+static void on_replay_done(bool ok, void *ctx) {
+    if (ok) {
+        stats.replayed_batches++;
+        stats.bytes += (uintptr_t)ctx;
+    }
+    flashlog_drain_done(ok);
+}
+
+/**
+ * @brief Flash log drain hook: replay a stored batch (QoS 1)
+ */
+static bool replay_batch(const uint8_t *data, size_t len, void *ctx) {
+    if (!modem_mqtt_is_connected()) return false;
+    return modem_mqtt_publish_cb(TLM_TOPIC, data, len, 1, on_replay_done, (void *)(uintptr_t)len);
+}
+
+static void publish_batch(void) {
+    size_t len;
+    const uint8_t *data = tlm_encoder_data(&encoder, &len);
+    if (len == 0) return;
+
+    // Live only when nothing older is waiting, so the broker sees batches in order
+    if (!flashlog_has_backlog() && modem_mqtt_publish(TLM_TOPIC, data, len, 0)) {
+        stats.batches++;
+        stats.bytes += len;
+    } else if (flashlog_push(data, len)) {
+        stats.stored_batches++;
+    } else {
+        stats.dropped_batches++;
+    }
+    stats.last_batch_bytes = len;
+    stats.last_batch_frames = encoder.count;
+    tlm_encoder_reset(&encoder);
+}
+
+static void tlm_task(void *arg) {
+    TickType_t last_wake = xTaskGetTickCount();
+    tlm_state_t s;
+
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(period_ms));
+        dl_begin(dl_id);
+
+        memset(&s, 0, sizeof(s));
+        fill_cb(&s, fill_ctx);
+        s.time_ms = (uint32_t)(esp_timer_get_time() / 1000);
+        s.mission = (uint8_t)mission_get_state();
+        s.health = health_pack();
+
+        if (!tlm_encoder_add(&encoder, &s)) {
+            publish_batch();
+            tlm_encoder_add(&encoder, &s);
+        }
+        stats.frames++;
+
+        if (encoder.count >= TLM_BATCH_MAX_FRAMES ||
+            s.time_ms - encoder.first_ms + period_ms >= TLM_BATCH_MAX_AGE_MS) {
+            publish_batch();
+        }
+        dl_end(dl_id);
+    }
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t tlm_start(uint16_t rate_hz, tlm_fill_cb_t fill, void *ctx) {
+    if (fill == NULL || rate_hz == 0 || rate_hz > 50) return ESP_ERR_INVALID_ARG;
+    if (is_running) return ESP_ERR_INVALID_STATE;
+
+    fill_cb = fill;
+    fill_ctx = ctx;
+    period_ms = 1000 / rate_hz;
+    tlm_encoder_reset(&encoder);
+    memset(&stats, 0, sizeof(stats));
+    flashlog_set_drain(replay_batch, NULL);
+
+    // Count only: a late frame is not a safety issue, the flash log absorbs it
+    const dl_config_t dl_cfg = {
+        .name = "telemetry",
+        .period_us = period_ms * 1000UL,
+        .budget_us = period_ms * 500UL,
+    };
+    esp_err_t err = dl_register(&dl_cfg, &dl_id);
+    if (err != ESP_OK) return err;
+    dl_start(dl_id);
+
+    if (mem_task_create(MEM_SUB_TLM, tlm_task, "tlm_task", TLM_TASK_STACK, NULL,
+                        TLM_TASK_PRIORITY, TLM_TASK_CORE) == NULL) {
+        return ESP_ERR_NO_MEM;
+    }
+
+    is_running = true;
+    ESP_LOGI(TAG, "Telemetry @ %u Hz, schema v%d, %d fields", rate_hz, TLM_SCHEMA_VERSION, TLM_FIELD_COUNT);
+    return ESP_OK;
+}
+
+void tlm_get_stats(tlm_stats_t *out) {
+    if (out == NULL) return;
+    *out = stats;
+}
+
+void tlm_log_stats(void) {
+    tlm_stats_t s = stats;
+    uint32_t per_frame = s.frames ? s.bytes / s.frames : 0;
+
+    ESP_LOGI(TAG, "frames=%lu batches=%lu stored=%lu replayed=%lu dropped=%lu bytes=%lu (~%lu B/frame) last=%lu B/%u frames",
+             (unsigned long)s.frames, (unsigned long)s.batches, (unsigned long)s.stored_batches,
+             (unsigned long)s.replayed_batches, (unsigned long)s.dropped_batches,
+             (unsigned long)s.bytes, (unsigned long)per_frame,
+             (unsigned long)s.last_batch_bytes, s.last_batch_frames);
+}
@@ -0,0 +1,77 @@
+/**
+ * @file sys_telemetry_codec.c
+ * @brief Telemetry Batch Encoder (pure C, no IDF dependencies)
+ */
+
+#include <string.h>
+#include "sys_telemetry.h"
+
+// --- HELPER FUNCTIONS ---
+
+static void flatten(const tlm_state_t *s, int32_t *out) {
+    int i = 0;
+#define TLM_FLATTEN_FIELD(name, type, unit) out[i++] = (int32_t)s->name;
+    TLM_FIELDS(TLM_FLATTEN_FIELD)
+#undef TLM_FLATTEN_FIELD
+}
+
+static inline uint32_t zigzag(int32_t v) {
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline size_t put_varint(uint8_t *p, uint32_t v) {
+    size_t n = 0;
+    while (v >= 0x80) {
+        p[n++] = (uint8_t)(v | 0x80);
+        v >>= 7;
+    }
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void tlm_encoder_reset(tlm_encoder_t *enc) {
+    memset(enc->prev, 0, sizeof(enc->prev));
+    enc->buf[0] = TLM_MAGIC;
+    enc->buf[1] = TLM_SCHEMA_VERSION;
+    enc->buf[2] = 0;
+    enc->len = TLM_BATCH_HEADER_BYTES;
+    enc->count = 0;
+    enc->first_ms = 0;
+}
+
+bool tlm_encoder_add(tlm_encoder_t *enc, const tlm_state_t *s) {
+    if (enc->count >= TLM_BATCH_MAX_FRAMES) return false;
+    if (enc->len + TLM_FRAME_MAX_BYTES > sizeof(enc->buf)) return false;
+
+    int32_t cur[TLM_FIELD_COUNT];
+    uint32_t delta[TLM_FIELD_COUNT];
+    uint32_t mask = 0;
+    flatten(s, cur);
+
+    for (int i = 0; i < TLM_FIELD_COUNT; i++) {
+        // Wrapping difference: uint32 fields (time) round-trip through int32
+        int32_t d = (int32_t)((uint32_t)cur[i] - (uint32_t)enc->prev[i]);
+        delta[i] = zigzag(d);
+        if (d != 0) mask |= 1u << i;
+    }
+
+    uint8_t *p = &enc->buf[enc->len];
+    size_t n = put_varint(p, mask);
+    for (int i = 0; i < TLM_FIELD_COUNT; i++) {
+        if (mask & (1u << i)) n += put_varint(p + n, delta[i]);
+    }
+
+    if (enc->count == 0) enc->first_ms = s->time_ms;
+    memcpy(enc->prev, cur, sizeof(cur));
+    enc->len += n;
+    enc->count++;
+    enc->buf[2] = enc->count;
+    return true;
+}
+
+const uint8_t *tlm_encoder_data(const tlm_encoder_t *enc, size_t *len) {
+    *len = (enc->count > 0) ? enc->len : 0;
+    return enc->buf;
+}
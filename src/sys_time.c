@@ -0,0 +1,192 @@
+/**
+ * @file sys_time.c
+ * @brief Timebase Implementation (PPS capture, UTC pairing, read-cost bench)
+ * @details
+ * The local clock is esp_timer (SYSTIMER): 64-bit, common to both cores and
+ * independent of the CPU frequency. The Xtensa CCOUNT register is cheaper to
+ * read but is per-core, wraps every ~27 s at 160 MHz and changes rate with
+ * DFS, so it is only used here to measure the read cost.
+ */
+
+#include "sys_time.h"
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/FreeRTOS.h"
+#include "app_config.h"
+
+static const char *TAG = "SYS_TIME";
+
+// PRIVATE STATIC VARIABLES
+static portMUX_TYPE time_mux = portMUX_INITIALIZER_UNLOCKED;
+static systime_servo_t servo;
+static volatile int64_t pps_last_us = 0;
+static volatile uint32_t pps_count = 0;
+static uint32_t pps_used = 0;               // pps_count of the last paired edge
+static systime_stats_t stats;
+static bool is_initialized = false;
+
+// --- HELPER FUNCTIONS ---
+
+static void IRAM_ATTR pps_isr_handler(void *arg) {
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&time_mux);
+    pps_last_us = now;
+    pps_count++;
+    portEXIT_CRITICAL_ISR(&time_mux);
+}
+
+static uint32_t cycles_per_call(uint32_t start, uint32_t end) {
+    return (end - start) / SYSTIME_BENCH_CALLS;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+esp_err_t systime_init(void) {
+    if (is_initialized) return ESP_OK;
+
+    systime_servo_reset(&servo);
+
+    gpio_config_t conf_pps = {
+        .pin_bit_mask = (1ULL << PIN_GPS_PPS),
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = GPIO_PULLUP_DISABLE,
+        .pull_down_en = GPIO_PULLDOWN_ENABLE,
+        .intr_type = GPIO_INTR_POSEDGE,
+    };
+    esp_err_t err = gpio_config(&conf_pps);
+    if (err != ESP_OK) return err;
+
+    err = gpio_install_isr_service(ESP_INTR_FLAG_IRAM);
+    if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) return err;   // Already installed is fine
+    err = gpio_isr_handler_add(PIN_GPS_PPS, pps_isr_handler, NULL);
+    if (err != ESP_OK) return err;
+
+    is_initialized = true;
+    ESP_LOGI(TAG, "PPS capture on GPIO%d", PIN_GPS_PPS);
+    return ESP_OK;
+}
+
+int64_t IRAM_ATTR systime_now_us(void) {
+    return esp_timer_get_time();
+}
+
+bool systime_to_utc_us(int64_t local_us, int64_t *utc_us) {
+    if (utc_us == NULL) return false;
+
+    portENTER_CRITICAL(&time_mux);
+    bool ok = systime_servo_to_utc(&servo, local_us, utc_us);
+    portEXIT_CRITICAL(&time_mux);
+    return ok;
+}
+
+void systime_on_gps_fix(const gps_fix_t *fix) {
+    if (!is_initialized || fix == NULL || !fix->time_valid) return;
+
+    // Epoch of this solution; only whole-second epochs coincide with a PPS edge
+    int64_t epoch_us = systime_civil_to_unix(fix->year, fix->month, fix->day,
+                                             fix->hour, fix->min, fix->sec) * 1000000LL
+                     + fix->nano / 1000;
+    int64_t utc_s = (epoch_us + 500000) / 1000000;
+    int64_t frac_us = epoch_us - utc_s * 1000000LL;
+    if (frac_us > SYSTIME_PAIR_FRACTION_US || frac_us < -SYSTIME_PAIR_FRACTION_US) return;
+
+    portENTER_CRITICAL(&time_mux);
+    int64_t edge_us = pps_last_us;
+    uint32_t edge = pps_count;
+    portEXIT_CRITICAL(&time_mux);
+
+    // The edge must be new and precede the message by less than a second
+    int64_t age_us = fix->rx_time_us - edge_us;
+    if (edge == pps_used || age_us < 0 || age_us > SYSTIME_PAIR_WINDOW_US) return;
+    pps_used = edge;
+
+    portENTER_CRITICAL(&time_mux);
+    systime_state_t before = servo.state;
+    bool ok = systime_servo_update(&servo, edge_us, utc_s);
+    systime_state_t after = servo.state;
+    int32_t err_ns = servo.error_ns;
+    stats.pairs++;
+    if (after == SYSTIME_LOCKED) {
+        int32_t mag = err_ns < 0 ? -err_ns : err_ns;
+        if (mag > stats.error_max_ns) stats.error_max_ns = mag;
+    }
+    portEXIT_CRITICAL(&time_mux);
+
+    if (!ok) {
+        ESP_LOGW(TAG, "PPS edge rejected (UTC %lld)", (long long)utc_s);
+    } else if (after != before && (after == SYSTIME_LOCKED || before == SYSTIME_LOCKED)) {
+        ESP_LOGI(TAG, "%s (error %ld ns)", after == SYSTIME_LOCKED ? "Locked to PPS" : "Lock lost", (long)err_ns);
+    }
+}
+
+bool systime_is_synced(void) {
+    portENTER_CRITICAL(&time_mux);
+    systime_servo_check(&servo, esp_timer_get_time());
+    bool synced = (servo.state == SYSTIME_LOCKED);
+    portEXIT_CRITICAL(&time_mux);
+    return synced;
+}
+
+void systime_measure_read_cost(void) {
+    volatile int64_t sink;
+    int64_t utc;
+    uint32_t t0, t1;
+
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < SYSTIME_BENCH_CALLS; i++) sink = esp_cpu_get_cycle_count();
+    t1 = esp_cpu_get_cycle_count();
+    uint32_t ccount = cycles_per_call(t0, t1);
+
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < SYSTIME_BENCH_CALLS; i++) sink = systime_now_us();
+    t1 = esp_cpu_get_cycle_count();
+    uint32_t read = cycles_per_call(t0, t1);
+
+    int64_t now = systime_now_us();
+    t0 = esp_cpu_get_cycle_count();
+    for (int i = 0; i < SYSTIME_BENCH_CALLS; i++) {
+        systime_to_utc_us(now + i, &utc);
+        sink = utc;
+    }
+    t1 = esp_cpu_get_cycle_count();
+    uint32_t conv = cycles_per_call(t0, t1);
+    (void)sink;
+
+    portENTER_CRITICAL(&time_mux);
+    stats.ccount_cycles = ccount;
+    stats.read_cycles = read;
+    stats.utc_cycles = conv;
+    portEXIT_CRITICAL(&time_mux);
+}
+
+void systime_get_stats(systime_stats_t *out) {
+    if (out == NULL) return;
+
+    portENTER_CRITICAL(&time_mux);
+    systime_servo_check(&servo, esp_timer_get_time());
+    *out = stats;
+    out->state = servo.state;
+    out->pps_edges = pps_count;
+    out->steps = servo.steps;
+    out->rejected = servo.rejected;
+    out->error_ns = servo.error_ns;
+    out->drift_ppb = servo.drift_ppb;
+    portEXIT_CRITICAL(&time_mux);
+}
+
+void systime_log_stats(void) {
+    static const char *state_names[] = { "UNSYNCED", "FREQ_EST", "TRACKING", "LOCKED", "HOLDOVER" };
+    systime_stats_t s;
+    systime_get_stats(&s);
+
+    ESP_LOGI(TAG, "%s | PPS %lu paired %lu | err %ld ns (max %ld) | drift %ld ppb | steps %lu rejected %lu",
+             state_names[s.state], (unsigned long)s.pps_edges, (unsigned long)s.pairs,
+             (long)s.error_ns, (long)s.error_max_ns, (long)s.drift_ppb,
+             (unsigned long)s.steps, (unsigned long)s.rejected);
+    ESP_LOGI(TAG, "Read cost (cycles): ccount %lu | now_us %lu | to_utc %lu",
+             (unsigned long)s.ccount_cycles, (unsigned long)s.read_cycles, (unsigned long)s.utc_cycles);
+}
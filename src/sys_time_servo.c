@@ -0,0 +1,162 @@
+/**
+ * @file sys_time_servo.c
+ * @brief PPS Clock Servo (pure C, no IDF dependencies)
+ * @details
+ * Per accepted edge: error e = mapping(edge) - UTC(edge).
+ *   drift -= KI * e / interval      (integral term, ppb)
+ *   slew   = -KP * e                (proportional term, spread over 1 s)
+ * The new anchor is the mapping's own value at the edge, so UTC never jumps
+ * unless |e| exceeds SYSTIME_STEP_THRESHOLD_US.
+ */
+
+#include <stdlib.h>
+#include "sys_time.h"
+
+#define NS_PER_US       1000LL
+#define NS_PER_S        1000000000LL
+#define US_PER_S        1000000LL
+
+// --- HELPER FUNCTIONS ---
+
+static int32_t clamp_ppb(int64_t v) {
+    if (v > SYSTIME_MAX_DRIFT_PPB) return SYSTIME_MAX_DRIFT_PPB;
+    if (v < -SYSTIME_MAX_DRIFT_PPB) return -SYSTIME_MAX_DRIFT_PPB;
+    return (int32_t)v;
+}
+
+static int64_t map_ns(const systime_servo_t *s, int64_t local_us) {
+    int64_t dt = local_us - s->anchor_local_us;
+    int64_t ns = s->anchor_utc_ns + dt * NS_PER_US + dt * s->drift_ppb / 1000000;
+    if (dt >= US_PER_S) {
+        ns += s->slew_ns;
+    } else if (dt > 0) {
+        ns += (int64_t)s->slew_ns * dt / US_PER_S;
+    }
+    return ns;
+}
+
+static void restart(systime_servo_t *s, int64_t local_us, int64_t utc_ns) {
+    s->anchor_local_us = local_us;
+    s->anchor_utc_ns = utc_ns;
+    s->pps_utc_ns = utc_ns;
+    s->drift_ppb = 0;
+    s->slew_ns = 0;
+    s->error_ns = 0;
+    s->good_count = 0;
+    s->reject_count = 0;
+    s->state = SYSTIME_FREQ_EST;
+}
+
+/**
+ * @brief Check that the edge is a whole number of seconds after the last one
+ */
+static bool interval_ok(const systime_servo_t *s, int64_t dl_us, int64_t du_s) {
+    if (du_s < 1) return false;
+    int64_t expect_us = du_s * US_PER_S - du_s * s->drift_ppb / 1000;
+    return llabs(dl_us - expect_us) <= SYSTIME_PPS_TOLERANCE_US;
+}
+
+// --- PUBLIC FUNCTIONS ---
+
+void systime_servo_reset(systime_servo_t *s) {
+    *s = (systime_servo_t){0};
+    s->state = SYSTIME_UNSYNCED;
+}
+
+bool systime_servo_update(systime_servo_t *s, int64_t local_us, int64_t utc_s) {
+    int64_t utc_ns = utc_s * NS_PER_S;
+
+    if (s->state == SYSTIME_UNSYNCED) {
+        restart(s, local_us, utc_ns);
+        s->updates++;
+        return true;
+    }
+
+    int64_t dl_us = local_us - s->anchor_local_us;
+    int64_t du_s = (utc_ns - s->pps_utc_ns) / NS_PER_S;
+
+    if (s->state == SYSTIME_FREQ_EST) {
+        // Drift unknown yet, so a gap can exceed the tolerance: just start over
+        if (!interval_ok(s, dl_us, du_s)) {
+            restart(s, local_us, utc_ns);
+            return false;
+        }
+        int64_t true_ns = du_s * NS_PER_S;
+        s->drift_ppb = clamp_ppb((true_ns - dl_us * NS_PER_US) * 1000000 / dl_us);
+        s->anchor_local_us = local_us;
+        s->anchor_utc_ns = utc_ns;
+        s->pps_utc_ns = utc_ns;
+        s->state = SYSTIME_TRACKING;
+        s->updates++;
+        return true;
+    }
+
+    // Holdover may have lasted longer than the drift can be trusted: let the step decide
+    if (!interval_ok(s, dl_us, du_s) && (s->state != SYSTIME_HOLDOVER || du_s < 1)) {
+        s->rejected++;
+        if (++s->reject_count >= SYSTIME_MAX_REJECTS) {
+            restart(s, local_us, utc_ns);
+        }
+        return false;
+    }
+
+    int64_t predicted = map_ns(s, local_us);
+    int64_t err = predicted - utc_ns;
+
+    if (llabs(err) > SYSTIME_STEP_THRESHOLD_US * NS_PER_US) {
+        s->anchor_utc_ns = utc_ns;
+        s->slew_ns = 0;
+        s->steps++;
+        s->good_count = 0;
+        s->state = SYSTIME_TRACKING;
+        s->error_ns = (err > INT32_MAX) ? INT32_MAX : (err < -INT32_MAX) ? -INT32_MAX : (int32_t)err;
+    } else {
+        s->drift_ppb = clamp_ppb(s->drift_ppb - (int64_t)(SYSTIME_SERVO_KI * (float)err) / (du_s > 0 ? du_s : 1));
+        s->slew_ns = (int32_t)(-SYSTIME_SERVO_KP * (float)err);
+        s->anchor_utc_ns = predicted;
+        s->error_ns = (int32_t)err;
+
+        if (llabs(err) < SYSTIME_LOCK_THRESHOLD_NS) {
+            if (s->good_count < SYSTIME_LOCK_COUNT) s->good_count++;
+            if (s->good_count >= SYSTIME_LOCK_COUNT) s->state = SYSTIME_LOCKED;
+            else if (s->state == SYSTIME_HOLDOVER) s->state = SYSTIME_TRACKING;
+        } else {
+            s->good_count = 0;
+            s->state = SYSTIME_TRACKING;
+        }
+    }
+
+    s->anchor_local_us = local_us;
+    s->pps_utc_ns = utc_ns;
+    s->reject_count = 0;
+    s->updates++;
+    return true;
+}
+
+void systime_servo_check(systime_servo_t *s, int64_t local_us) {
+    if (s->state != SYSTIME_TRACKING && s->state != SYSTIME_LOCKED) return;
+    if (local_us - s->anchor_local_us > SYSTIME_HOLDOVER_S * US_PER_S) {
+        s->state = SYSTIME_HOLDOVER;
+        s->good_count = 0;
+    }
+}
+
+bool systime_servo_to_utc(const systime_servo_t *s, int64_t local_us, int64_t *utc_us) {
+    if (s->state == SYSTIME_UNSYNCED) return false;
+    *utc_us = map_ns(s, local_us) / NS_PER_US;
+    return true;
+}
+
+int64_t systime_civil_to_unix(uint16_t year, uint8_t month, uint8_t day,
+                              uint8_t hour, uint8_t min, uint8_t sec) {
+    // Days from 1970-01-01 (proleptic Gregorian, March-based year)
+    int64_t y = (int64_t)year - (month <= 2);
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t mp = (month + 9) % 12;
+    int64_t doy = (153 * mp + 2) / 5 + day - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    int64_t days = era * 146097 + doe - 719468;
+
+    return days * 86400 + hour * 3600 + min * 60 + sec;
+}
@@ -0,0 +1,426 @@
+/**
+ * @file ahrs_sim.c
+ * @brief Host test of the AHRS on synthetic IMU data
+ * @details
+ * Integrates a true attitude at 500 Hz (double precision, 10 sub-steps):
+ * +-12 deg roll and +-8 deg pitch wave motion while the craft turns
+ * through 360 deg. Gyro, accel and mag are synthesised from it in the
+ * Madgwick conventions (NWU earth, 60 deg magnetic dip) with white noise.
+ * For Madgwick and Mahony it checks:
+ * - ahrs_align() at rest: attitude within 1 deg, heading within 1 deg;
+ * - 9-DOF attitude error and 6-DOF tilt error (heading free to drift)
+ *   after alignment, rms / max: noise only < 0.5 / 1 deg; with a
+ *   0.17 deg/s gyro bias < 1.5 / 2 deg; with 0.05 g wave surge/sway,
+ *   which the accel reads as up to 2.9 deg of tilt, < 3 / 5 deg;
+ * - 9-DOF convergence from a 90 deg heading error: < 3 deg within 40 s;
+ * - ahrs_update_batch() gives the same attitude as single updates;
+ * - ahrs_get_euler() heading matches the true compass heading;
+ * then reports ns and TSC ticks per sample (9-DOF single and batch, 6-DOF).
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude tools/ahrs_sim.c src/fusion_ahrs.c -lm -o ahrs_sim
+ *   ./ahrs_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "fusion_ahrs.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define RATE_HZ         500
+#define DT              (1.0 / RATE_HZ)
+#define SUBSTEPS        10
+#define RUN_S           120
+#define SETTLE_S        5           // Skipped before the error statistics
+#define DIP_DEG         60.0
+#define GYRO_NOISE      0.005       // rad/s (1 sigma)
+#define GYRO_BIAS_Z     0.003       // rad/s (~0.17 deg/s), bias scenario
+#define ACCEL_NOISE     0.02        // g
+#define WAVE_ACCEL      0.05        // g, wave scenario (tilt disturbance atan(0.05) = 2.9 deg)
+#define MAG_NOISE       0.01        // Field units (|B| = 1)
+#define BATCH_LEN       32
+#define BENCH_UPDATES   (1 << 22)
+
+#define DEG             (M_PI / 180.0)
+
+/**
+ * @brief True motion (body -> earth quaternion, double precision)
+ */
+typedef struct {
+    double q[4];
+    double t;
+    double w[3];                // Body rates over the last step (rad/s)
+} sim_truth_t;
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+static double bias_z = 0.0;         // Current scenario
+static double wave_g = 0.0;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double gauss(void) {
+    // Sum of 4 uniforms: close enough to normal for sensor noise
+    double s = 0.0;
+    for (int i = 0; i < 4; i++) s += rnd() / 16777216.0;
+    return (s - 2.0) * 1.7320508;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void quat_mul(const double a[4], const double b[4], double out[4]) {
+    out[0] = a[0] * b[0] - a[1] * b[1] - a[2] * b[2] - a[3] * b[3];
+    out[1] = a[0] * b[1] + a[1] * b[0] + a[2] * b[3] - a[3] * b[2];
+    out[2] = a[0] * b[2] - a[1] * b[3] + a[2] * b[0] + a[3] * b[1];
+    out[3] = a[0] * b[3] + a[1] * b[2] - a[2] * b[1] + a[3] * b[0];
+}
+
+static void quat_from_euler(double roll, double pitch, double yaw, double q[4]) {
+    double cr = cos(roll / 2), sr = sin(roll / 2);
+    double cp = cos(pitch / 2), sp = sin(pitch / 2);
+    double cy = cos(yaw / 2), sy = sin(yaw / 2);
+    q[0] = cr * cp * cy + sr * sp * sy;
+    q[1] = sr * cp * cy - cr * sp * sy;
+    q[2] = cr * sp * cy + sr * cp * sy;
+    q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+/**
+ * @brief Earth vector into the body frame (R^T v)
+ */
+static void earth_to_body(const double q[4], const double e[3], double b[3]) {
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    b[0] = (1 - 2 * (q2 * q2 + q3 * q3)) * e[0] + 2 * (q1 * q2 + q0 * q3) * e[1] + 2 * (q1 * q3 - q0 * q2) * e[2];
+    b[1] = 2 * (q1 * q2 - q0 * q3) * e[0] + (1 - 2 * (q1 * q1 + q3 * q3)) * e[1] + 2 * (q2 * q3 + q0 * q1) * e[2];
+    b[2] = 2 * (q1 * q3 + q0 * q2) * e[0] + 2 * (q2 * q3 - q0 * q1) * e[1] + (1 - 2 * (q1 * q1 + q2 * q2)) * e[2];
+}
+
+/**
+ * @brief True attitude at time t: waves on a steady turn
+ */
+static void truth_attitude(double t, double heading0, double q[4]) {
+    double roll = 12.0 * DEG * sin(2 * M_PI * t / 4.1);
+    double pitch = 8.0 * DEG * sin(2 * M_PI * t / 5.3 + 1.0);
+    double yaw = heading0 + 2 * M_PI * t / 60.0;       // 6 deg/s, one turn a minute
+    quat_from_euler(roll, pitch, yaw, q);
+}
+
+/**
+ * @brief Advance the truth one sample; body rates from the quaternion difference
+ */
+static void truth_step(sim_truth_t *tr, double heading0) {
+    double w_sum[3] = {0, 0, 0};
+    double q_prev[4], q_next[4], q_inv[4], dq[4];
+
+    truth_attitude(tr->t, heading0, q_prev);
+    for (int k = 0; k < SUBSTEPS; k++) {
+        double h = DT / SUBSTEPS;
+        truth_attitude(tr->t + h, heading0, q_next);
+        // dq = q_prev^-1 * q_next = (1, w * h / 2) to first order
+        q_inv[0] = q_prev[0];
+        q_inv[1] = -q_prev[1];
+        q_inv[2] = -q_prev[2];
+        q_inv[3] = -q_prev[3];
+        quat_mul(q_inv, q_next, dq);
+        double sgn = dq[0] < 0 ? -1.0 : 1.0;
+        for (int i = 0; i < 3; i++) w_sum[i] += 2.0 * sgn * dq[i + 1] / h;
+        memcpy(q_prev, q_next, sizeof(q_prev));
+        tr->t += h;
+    }
+    memcpy(tr->q, q_prev, sizeof(tr->q));
+    for (int i = 0; i < 3; i++) tr->w[i] = w_sum[i] / SUBSTEPS;
+}
+
+/**
+ * @brief Sensor sample for the current truth
+ */
+static void make_sample(const sim_truth_t *tr, bool with_mag, bool noisy, ahrs_sample_t *s) {
+    static const double up[3] = {0, 0, 1};
+    double mag_e[3] = {cos(DIP_DEG * DEG), 0, -sin(DIP_DEG * DEG)};
+    double a[3], m[3];
+    double n = noisy ? 1.0 : 0.0;
+
+    earth_to_body(tr->q, up, a);
+    earth_to_body(tr->q, mag_e, m);
+
+    // Wave surge / sway: horizontal earth accelerations, zero mean
+    double wave_e[3] = {wave_g * sin(2 * M_PI * tr->t / 3.7), wave_g * cos(2 * M_PI * tr->t / 4.9), 0};
+    double wave_b[3];
+    earth_to_body(tr->q, wave_e, wave_b);
+
+    s->gx = (float)(tr->w[0] + n * GYRO_NOISE * gauss());
+    s->gy = (float)(tr->w[1] + n * GYRO_NOISE * gauss());
+    s->gz = (float)(tr->w[2] + n * (GYRO_NOISE * gauss() + bias_z));
+    s->ax = (float)(a[0] + n * (wave_b[0] + ACCEL_NOISE * gauss()));
+    s->ay = (float)(a[1] + n * (wave_b[1] + ACCEL_NOISE * gauss()));
+    s->az = (float)(a[2] + n * (wave_b[2] + ACCEL_NOISE * gauss()));
+    if (with_mag) {
+        s->mx = (float)(m[0] + n * MAG_NOISE * gauss());
+        s->my = (float)(m[1] + n * MAG_NOISE * gauss());
+        s->mz = (float)(m[2] + n * MAG_NOISE * gauss());
+    } else {
+        s->mx = s->my = s->mz = 0.0f;
+    }
+}
+
+/**
+ * @brief Angle between true and estimated attitude (deg)
+ * @note atan2 of the error quaternion: acos(dot) would read the ~1e-6
+ *       norm error of the float quaternion as a fraction of a degree.
+ */
+static double attitude_error_deg(const ahrs_t *a, const double q[4]) {
+    double qt_inv[4] = {q[0], -q[1], -q[2], -q[3]};
+    double qe[4] = {a->q0, a->q1, a->q2, a->q3};
+    double d[4];
+    quat_mul(qt_inv, qe, d);
+    return 2.0 * atan2(sqrt(d[1] * d[1] + d[2] * d[2] + d[3] * d[3]), fabs(d[0])) / DEG;
+}
+
+/**
+ * @brief Angle between true and estimated earth "up" in the body frame (deg)
+ */
+static double tilt_error_deg(const ahrs_t *a, const double q[4]) {
+    static const double up[3] = {0, 0, 1};
+    double qe[4] = {a->q0, a->q1, a->q2, a->q3};
+    double ut[3], ue[3];
+    earth_to_body(q, up, ut);
+    earth_to_body(qe, up, ue);
+    double dot = ut[0] * ue[0] + ut[1] * ue[1] + ut[2] * ue[2];
+    double norm = sqrt(ue[0] * ue[0] + ue[1] * ue[1] + ue[2] * ue[2]);
+    dot /= norm;
+    if (dot > 1.0) dot = 1.0;
+    return acos(dot) / DEG;
+}
+
+static const char *algo_name(ahrs_algo_t algo) {
+    return algo == AHRS_ALGO_MADGWICK ? "Madgwick" : "Mahony";
+}
+
+/**
+ * @brief Run RUN_S seconds, return error statistics after SETTLE_S
+ */
+static void run(ahrs_t *a, double heading0, bool with_mag, bool tilt_only, double *rms, double *max) {
+    sim_truth_t tr = { .t = 0.0 };
+    ahrs_sample_t s;
+    double sum2 = 0.0;
+    int n = 0;
+
+    *max = 0.0;
+    for (int i = 0; i < RUN_S * RATE_HZ; i++) {
+        truth_step(&tr, heading0);
+        make_sample(&tr, with_mag, true, &s);
+        ahrs_update(a, &s, (float)DT);
+        if (tr.t < SETTLE_S) continue;
+
+        double e = tilt_only ? tilt_error_deg(a, tr.q) : attitude_error_deg(a, tr.q);
+        sum2 += e * e;
+        if (e > *max) *max = e;
+        n++;
+    }
+    *rms = sqrt(sum2 / n);
+}
+
+/**
+ * @brief Aligned filter on the true attitude at t = 0
+ */
+static void align_at_start(ahrs_t *a, ahrs_algo_t algo, double heading0, bool with_mag) {
+    sim_truth_t tr = { .t = 0.0 };
+    ahrs_sample_t s;
+
+    truth_attitude(0.0, heading0, tr.q);
+    make_sample(&tr, with_mag, false, &s);
+    ahrs_init(a, algo);
+    ahrs_align(a, s.ax, s.ay, s.az, s.mx, s.my, s.mz);
+}
+
+// --- SCENARIOS ---
+
+static void test_align(ahrs_algo_t algo) {
+    ahrs_t a;
+    char what[80];
+    double worst = 0.0, worst_hdg = 0.0;
+
+    for (int h = 0; h < 360; h += 15) {
+        double heading0 = h * DEG;
+        double q[4];
+        align_at_start(&a, algo, heading0, true);
+        truth_attitude(0.0, heading0, q);
+        double e = attitude_error_deg(&a, q);
+        if (e > worst) worst = e;
+
+        // Level, pure yaw: compass heading is clockwise, quaternion yaw counter-clockwise
+        sim_truth_t tr = { .t = 0.0 };
+        ahrs_sample_t s;
+        quat_from_euler(0.0, 0.0, heading0, tr.q);
+        make_sample(&tr, true, false, &s);
+        ahrs_align(&a, s.ax, s.ay, s.az, s.mx, s.my, s.mz);
+        float yaw;
+        ahrs_get_euler(&a, NULL, NULL, &yaw);
+        double expect = fmod(360.0 - h, 360.0);
+        double d = fabs(fmod(yaw - expect + 540.0, 360.0) - 180.0);
+        if (d > worst_hdg) worst_hdg = d;
+    }
+    snprintf(what, sizeof(what), "%s: align error max %.3f deg (< 1), 24 headings", algo_name(algo), worst);
+    check(what, worst < 1.0);
+    snprintf(what, sizeof(what), "%s: euler heading vs compass max %.3f deg (< 1)", algo_name(algo), worst_hdg);
+    check(what, worst_hdg < 1.0);
+}
+
+/**
+ * @brief 9-DOF attitude and 6-DOF tilt error for the current scenario
+ */
+static void track(ahrs_algo_t algo, const char *label, double rms_max, double max_max) {
+    ahrs_t a;
+    double rms, max;
+    char what[80];
+
+    align_at_start(&a, algo, 40.0 * DEG, true);
+    run(&a, 40.0 * DEG, true, false, &rms, &max);
+    snprintf(what, sizeof(what), "%s 9-DOF attitude: rms %.2f max %.2f deg", label, rms, max);
+    check(what, rms < rms_max && max < max_max);
+
+    align_at_start(&a, algo, 40.0 * DEG, false);
+    run(&a, 40.0 * DEG, false, true, &rms, &max);
+    snprintf(what, sizeof(what), "%s 6-DOF tilt:     rms %.2f max %.2f deg", label, rms, max);
+    check(what, rms < rms_max && max < max_max);
+}
+
+static void test_tracking(ahrs_algo_t algo) {
+    track(algo, "noise only:", 0.5, 1.0);
+
+    bias_z = GYRO_BIAS_Z;               // Mahony KI = 0 and Madgwick have no bias state
+    track(algo, "gyro bias: ", 1.5, 2.0);
+    bias_z = 0.0;
+
+    wave_g = WAVE_ACCEL;                // Accel sees the waves as tilt: bounded, not removed
+    track(algo, "waves:     ", 3.0, 5.0);
+    wave_g = 0.0;
+}
+
+static void test_convergence(ahrs_algo_t algo) {
+    ahrs_t a;
+    sim_truth_t tr = { .t = 0.0 };
+    ahrs_sample_t s;
+    double settled_at = -1.0;
+    char what[80];
+
+    // Aligned 90 deg off in heading
+    align_at_start(&a, algo, 130.0 * DEG, true);
+    for (int i = 0; i < 60 * RATE_HZ; i++) {
+        truth_step(&tr, 40.0 * DEG);
+        make_sample(&tr, true, true, &s);
+        ahrs_update(&a, &s, (float)DT);
+        double e = attitude_error_deg(&a, tr.q);
+        if (e < 3.0 && settled_at < 0.0) settled_at = tr.t;
+        if (e >= 3.0) settled_at = -1.0;
+    }
+    snprintf(what, sizeof(what), "%s: 90 deg heading error below 3 deg after %.1f s", algo_name(algo), settled_at);
+    check(what, settled_at >= 0.0 && settled_at < 40.0);
+}
+
+static void test_batch(ahrs_algo_t algo) {
+    ahrs_t single, batch;
+    sim_truth_t tr = { .t = 0.0 };
+    ahrs_sample_t buf[BATCH_LEN];
+    double worst = 0.0;
+    char what[80];
+
+    align_at_start(&single, algo, 0.0, true);
+    batch = single;
+    for (int k = 0; k < 200; k++) {
+        for (int i = 0; i < BATCH_LEN; i++) {
+            truth_step(&tr, 0.0);
+            make_sample(&tr, (i & 1) == 0, true, &buf[i]);      // Mag at half rate
+            ahrs_update(&single, &buf[i], (float)DT);
+        }
+        ahrs_update_batch(&batch, buf, BATCH_LEN, (float)DT);
+        double q[4] = {single.q0, single.q1, single.q2, single.q3};
+        double e = attitude_error_deg(&batch, q);
+        if (e > worst) worst = e;
+    }
+    snprintf(what, sizeof(what), "%s: batch vs single updates max %.4f deg", algo_name(algo), worst);
+    check(what, worst < 0.01);
+}
+
+static void bench(ahrs_algo_t algo) {
+    static ahrs_sample_t buf[1024];
+    sim_truth_t tr = { .t = 0.0 };
+    ahrs_t a;
+    const char *label[3] = {"9-DOF", "9-DOF batch", "6-DOF"};
+
+    for (int i = 0; i < 1024; i++) {
+        truth_step(&tr, 0.0);
+        make_sample(&tr, true, true, &buf[i]);
+    }
+
+    for (int mode = 0; mode < 3; mode++) {
+        align_at_start(&a, algo, 0.0, true);
+        if (mode == 2) {
+            for (int i = 0; i < 1024; i++) buf[i].mx = buf[i].my = buf[i].mz = 0.0f;
+        }
+        double t0 = now_ns();
+#ifdef HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        if (mode == 1) {
+            for (int i = 0; i < BENCH_UPDATES; i += BATCH_LEN) {
+                ahrs_update_batch(&a, &buf[i & 1023], BATCH_LEN, (float)DT);
+            }
+        } else {
+            for (int i = 0; i < BENCH_UPDATES; i++) ahrs_update(&a, &buf[i & 1023], (float)DT);
+        }
+#ifdef HAVE_TSC
+        uint64_t c1 = __rdtsc();
+#endif
+        double ns = (now_ns() - t0) / BENCH_UPDATES;
+#ifdef HAVE_TSC
+        printf("  %-8s %-11s %6.2f ns  %6.1f TSC ticks\n", algo_name(algo), label[mode], ns,
+               (double)(c1 - c0) / BENCH_UPDATES);
+#else
+        printf("  %-8s %-11s %6.2f ns\n", algo_name(algo), label[mode], ns);
+#endif
+    }
+}
+
+int main(void) {
+    static const ahrs_algo_t algos[2] = {AHRS_ALGO_MADGWICK, AHRS_ALGO_MAHONY};
+
+    for (int k = 0; k < 2; k++) {
+        printf("%s:\n", algo_name(algos[k]));
+        test_align(algos[k]);
+        test_tracking(algos[k]);
+        test_convergence(algos[k]);
+        test_batch(algos[k]);
+        printf("\n");
+    }
+
+    printf("Cost per sample (%d updates, host):\n", BENCH_UPDATES);
+    bench(AHRS_ALGO_MADGWICK);
+    bench(AHRS_ALGO_MAHONY);
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
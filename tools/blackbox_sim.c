@@ -0,0 +1,227 @@
+/**
+ * @file blackbox_sim.c
+ * @brief Host simulation of the black-box recorder: producer cost and sustainable rate
+ * @details
+ * Runs src/sys_blackbox_codec.c (record packing, SPSC ring, block store)
+ * against a RAM NOR flash model and reports:
+ * - producer cost: bbox_pack() + bbox_ring_put() per frame (host ns);
+ * - for a sweep of record rates, frames dropped because the RAM ring
+ *   filled while the bbox task was busy in flash, and the task's flash duty;
+ * - the highest rate with no drop (maximum sustainable record rate);
+ * - remount after the run: resume point and record framing of every block.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/blackbox_sim.c src/sys_blackbox_codec.c -o blackbox_sim
+ *   ./blackbox_sim
+ *
+ * Flash timings are typical 25Q-series figures (page program 0.7ms per
+ * 256B, sector erase 45ms). The task is assumed to get the CPU at every
+ * poll; on target the bbox_log_stats() figures are the reference.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sys_blackbox.h"
+
+#define SIM_PART_SIZE       0x10000     // Matches "bbox" in partitions.csv
+#define SIM_PROG_PAGE_US    700.0
+#define SIM_ERASE_US        45000.0
+#define SIM_DURATION_S      120
+#define SIM_POLL_US         (BBOX_POLL_MS * 1000.0)
+
+static uint8_t flash[SIM_PART_SIZE];
+static double flash_busy_us;            // Cost of the current flash call(s)
+
+// --- FLASH MODEL ---
+
+static bool sim_read(void *ctx, uint32_t addr, void *buf, size_t len) {
+    (void)ctx;
+    memcpy(buf, flash + addr, len);
+    return true;
+}
+
+static bool sim_write(void *ctx, uint32_t addr, const void *buf, size_t len) {
+    (void)ctx;
+    const uint8_t *src = buf;
+    for (size_t i = 0; i < len; i++) flash[addr + i] &= src[i];      // NOR: program clears bits
+    flash_busy_us += SIM_PROG_PAGE_US * (double)((len + 255) / 256);
+    return true;
+}
+
+static bool sim_erase(void *ctx, uint32_t addr, size_t len) {
+    (void)ctx;
+    memset(flash + addr, 0xFF, len);
+    flash_busy_us += SIM_ERASE_US * (double)(len / BBOX_SECTOR_SIZE);
+    return true;
+}
+
+static const flog_flash_t sim_io = {
+    .read = sim_read,
+    .write = sim_write,
+    .erase = sim_erase,
+    .ctx = NULL,
+    .size = SIM_PART_SIZE,
+};
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_frame(bbox_frame_t *f, uint32_t i) {
+    f->motor_left = (uint16_t)(800 + i % 200);
+    f->motor_right = (uint16_t)(820 + i % 180);
+    for (int k = 0; k < 3; k++) {
+        f->dist_mm[k] = (uint16_t)(1000 + (i * (k + 3)) % 2000);
+        f->load[k] = (int32_t)((i * 37 + k) % 9000);
+    }
+    f->flags = (uint16_t)(i & 7);
+    f->batt_mv = (uint16_t)(8200 - i / 1000);
+    f->mission = (uint8_t)(i / 3000 % 6);
+}
+
+static double producer_cost_ns(uint8_t mask) {
+    static uint8_t buf[BBOX_RAM_BYTES];
+    bbox_ring_t ring;
+    bbox_frame_t f;
+    uint8_t rec[BBOX_FRAME_MAX];
+    const uint32_t n = 2000000;
+
+    bbox_ring_init(&ring, buf, sizeof(buf));
+    make_frame(&f, 1);
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < n; i++) {
+        size_t len = bbox_pack(BBOX_TAG_FRAME, mask, i, &f, rec);
+        if (!bbox_ring_put(&ring, rec, len)) {
+            while (bbox_ring_get(&ring, rec) > 0) {}
+        }
+    }
+    return (now_ns() - t0) / n;
+}
+
+typedef struct {
+    uint32_t produced;
+    uint32_t dropped;
+    uint32_t blocks;
+    uint32_t ring_peak;
+    double duty;                // Flash busy fraction of the bbox task
+} sim_result_t;
+
+/**
+ * @brief Event simulation: producer at rate_hz, bbox task polling every BBOX_POLL_MS
+ */
+static sim_result_t simulate(double rate_hz, uint8_t mask) {
+    static uint8_t buf[BBOX_RAM_BYTES];
+    static bbox_store_t store;
+    bbox_ring_t ring;
+    bbox_frame_t f;
+    uint8_t rec[BBOX_FRAME_MAX];
+    sim_result_t res = { 0 };
+
+    memset(flash, 0xFF, sizeof(flash));
+    bbox_store_mount(&store, &sim_io);
+    bbox_ring_init(&ring, buf, sizeof(buf));
+
+    const double end_us = SIM_DURATION_S * 1e6;
+    const double period_us = 1e6 / rate_hz;
+    double next_frame_us = 0.0;
+    double task_us = SIM_POLL_US;
+    double busy_total = 0.0;
+    uint32_t seq0 = store.next_seq;
+
+    while (task_us < end_us) {
+        // One task pass: drain, each flash write advances the task clock
+        while (task_us < end_us) {
+            while (next_frame_us <= task_us) {
+                make_frame(&f, res.produced);
+                size_t len = bbox_pack(BBOX_TAG_FRAME, mask, (uint32_t)(next_frame_us / 1000), &f, rec);
+                if (!bbox_ring_put(&ring, rec, len)) res.dropped++;
+                uint32_t used = bbox_ring_used(&ring);
+                if (used > res.ring_peak) res.ring_peak = used;
+                res.produced++;
+                next_frame_us += period_us;
+            }
+            size_t len = bbox_ring_get(&ring, rec);
+            if (len == 0) break;
+
+            flash_busy_us = 0.0;
+            bbox_store_add(&store, rec, len);
+            task_us += flash_busy_us;
+            busy_total += flash_busy_us;
+        }
+        task_us += SIM_POLL_US;
+    }
+
+    res.blocks = store.next_seq - seq0;
+    res.duty = busy_total / end_us;
+    return res;
+}
+
+/**
+ * @brief Remount the flash and walk every valid block record by record
+ */
+static int check_remount(void) {
+    bbox_store_t st;
+    if (!bbox_store_mount(&st, &sim_io)) return 1;
+
+    uint32_t valid = 0, bad = 0, records = 0;
+    for (uint32_t b = 0; b < st.block_count; b++) {
+        const uint8_t *blk = flash + b * BBOX_BLOCK_BYTES;
+        uint32_t magic, seq;
+        uint16_t used;
+        memcpy(&magic, blk, 4);
+        memcpy(&seq, blk + 4, 4);
+        memcpy(&used, blk + 8, 2);
+        if (magic != BBOX_MAGIC) continue;
+
+        const uint8_t *p = blk + BBOX_BLOCK_HDR_BYTES;
+        const uint8_t *end = p + used;
+        bool ok = true;
+        while (p < end) {
+            size_t n = bbox_record_size(p);
+            if (n == 0 || p + n > end) { ok = false; break; }
+            p += n;
+            records++;
+        }
+        if (ok) valid++;
+        else bad++;
+    }
+
+    printf("Remount: next block %lu (sector boundary: %s), next seq %lu | %lu blocks, %lu records, %lu bad\n",
+           (unsigned long)st.next_block, st.next_block % (BBOX_SECTOR_SIZE / BBOX_BLOCK_BYTES) == 0 ? "yes" : "NO",
+           (unsigned long)st.next_seq, (unsigned long)valid, (unsigned long)records, (unsigned long)bad);
+    return bad == 0 && st.next_block % (BBOX_SECTOR_SIZE / BBOX_BLOCK_BYTES) == 0 ? 0 : 1;
+}
+
+int main(void) {
+    printf("Frame size: %u bytes (all channels), %u bytes (motor+mission)\n",
+           (unsigned)bbox_frame_size(BBOX_CH_ALL), (unsigned)bbox_frame_size(BBOX_CH_MOTOR | BBOX_CH_MISSION));
+    printf("Producer cost (pack + ring put): %.1f ns all channels, %.1f ns motor+mission (host)\n\n",
+           producer_cost_ns(BBOX_CH_ALL), producer_cost_ns(BBOX_CH_MOTOR | BBOX_CH_MISSION));
+
+    static const double rates[] = { 50, 100, 200, 400, 800, 1200, 1600, 2000, 2200, 2500 };
+    double max_ok = 0.0;
+
+    printf("  rate Hz |  KB/s | blocks | dropped | ring peak | flash duty | history in partition\n");
+    for (size_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        sim_result_t r = simulate(rates[i], BBOX_CH_ALL);
+        double kbs = rates[i] * bbox_frame_size(BBOX_CH_ALL) / 1024.0;
+        printf("  %7.0f | %5.1f | %6lu | %7lu | %5lu B   | %8.1f%%  | %6.0f s\n",
+               rates[i], kbs, (unsigned long)r.blocks, (unsigned long)r.dropped,
+               (unsigned long)r.ring_peak, 100.0 * r.duty,
+               (SIM_PART_SIZE - BBOX_SECTOR_SIZE) / 1024.0 / kbs * (BBOX_BLOCK_BYTES - BBOX_BLOCK_HDR_BYTES) / BBOX_BLOCK_BYTES);
+        if (r.dropped == 0) max_ok = rates[i];
+    }
+    printf("\nMaximum sustainable rate without drops (all channels): %.0f Hz (BBOX_MAX_RATE_HZ %d)\n\n",
+           max_ok, BBOX_MAX_RATE_HZ);
+
+    int rc = check_remount();
+    printf("%s\n", rc == 0 ? "OK" : "FAILED");
+    return rc;
+}
@@ -0,0 +1,308 @@
+/**
+ * @file ctrl_sim.c
+ * @brief Host closed-loop test of the heading / speed control law
+ * @details
+ * Runs src/ctrl_heading_law.c at CTRL_PERIOD_US against a simple plant:
+ * - yaw: first-order Nomoto model T*r' + r = K(v)*u + d (the model
+ *   tools/sysid_fit.py fits), u = (left - right) / 2 raw, rudder authority
+ *   K growing with speed like the default gain schedule assumes, d a
+ *   constant yaw disturbance (wind on the superstructure);
+ * - surge: first-order v' = (Ks*(base - idle) - v) / Ts;
+ * heading read back with noise, plant integrated at 1 kHz. Checks:
+ * - 90 deg turn at cruise: settling time and overshoot;
+ * - turn across North takes the short way;
+ * - constant disturbance: integrator removes the steady-state error;
+ * - 180 deg reversal (differential saturated): anti-windup bounds overshoot;
+ * - speed step: tracking error and saturation of the common throttle;
+ * - speed 0, disabled or invalid measurement: both motors at idle;
+ * then reports ns and TSC ticks per ctrl_law_step().
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/ctrl_sim.c src/ctrl_heading_law.c -lm -o ctrl_sim
+ *   ./ctrl_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "ctrl_heading.h"
+#include "drv_motor.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define DT_S            (CTRL_PERIOD_US * 1e-6f)
+#define PLANT_SUBSTEPS  20          // 1 kHz plant integration
+#define YAW_K0          0.02f       // deg/s per raw at rest
+#define YAW_K_SPEED     1.5f        // K(v) = K0 * (1 + v / YAW_K_SPEED)
+#define YAW_T_S         0.8f
+#define SURGE_K         (1.0f / 600.0f) // m/s per raw above idle (= 1 / CTRL_SPD_FF)
+#define SURGE_T_S       2.0f
+#define HDG_NOISE_DEG   0.3f
+#define BENCH_STEPS     (1 << 22)
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static float gauss(float sigma) {
+    float u1 = ((rnd() >> 8) + 1) / 16777217.0f, u2 = (rnd() >> 8) / 16777216.0f;
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static float wrap360(float a) {
+    while (a >= 360.0f) a -= 360.0f;
+    while (a < 0.0f) a += 360.0f;
+    return a;
+}
+
+/**
+ * @brief Plant + controller
+ */
+typedef struct {
+    ctrl_law_t law;
+    float psi;                  // Heading (deg)
+    float r;                    // Yaw rate (deg/s)
+    float v;                    // Speed (m/s)
+    float dist;                 // Yaw disturbance (deg/s equivalent)
+    uint16_t left, right;
+    float t;
+} sim_t;
+
+static void sim_init(sim_t *s, float psi, float v) {
+    ctrl_law_init(&s->law);
+    s->psi = psi;
+    s->r = 0.0f;
+    s->v = v;
+    s->dist = 0.0f;
+    s->left = s->right = MOTOR_IDLE_RAW;
+    s->t = 0.0f;
+}
+
+static void sim_step(sim_t *s, const ctrl_setpoint_t *sp) {
+    ctrl_measurement_t meas = {
+        .heading_deg = wrap360(s->psi + gauss(HDG_NOISE_DEG)),
+        .speed_m_s = s->v,
+        .is_valid = true,
+    };
+    ctrl_law_step(&s->law, &meas, sp, DT_S, &s->left, &s->right);
+
+    float u = ((float)s->left - (float)s->right) * 0.5f;
+    float base = ((float)s->left + (float)s->right) * 0.5f - (float)MOTOR_IDLE_RAW;
+    float k = YAW_K0 * (1.0f + s->v / YAW_K_SPEED);
+    float h = DT_S / PLANT_SUBSTEPS;
+    for (int i = 0; i < PLANT_SUBSTEPS; i++) {
+        s->r += h * (k * u + s->dist - s->r) / YAW_T_S;
+        s->psi = wrap360(s->psi + h * s->r);
+        s->v += h * (SURGE_K * base - s->v) / SURGE_T_S;
+        if (s->v < 0.0f) s->v = 0.0f;
+    }
+    s->t += DT_S;
+}
+
+/**
+ * @brief Step response of the heading loop
+ */
+typedef struct {
+    float settle_s;             // Last time |error| > band
+    float overshoot_deg;        // Past the target, in the turn direction
+    float final_err_deg;        // Mean |error| over the last 5 s
+    float min_psi, max_psi;     // Range swept (unwrapped from the start)
+} resp_t;
+
+static resp_t run_turn(sim_t *s, const ctrl_setpoint_t *sp, float duration_s, float band_deg) {
+    resp_t r = { 0 };
+    float start = s->psi, turn = ctrl_wrap_deg(sp->heading_deg - start);
+    float sum = 0.0f;
+    int n = 0;
+    float t0 = s->t;
+
+    r.min_psi = r.max_psi = 0.0f;
+    while (s->t - t0 < duration_s) {
+        sim_step(s, sp);
+        float err = ctrl_wrap_deg(sp->heading_deg - s->psi);
+        float moved = ctrl_wrap_deg(s->psi - start);
+        if (moved < r.min_psi) r.min_psi = moved;
+        if (moved > r.max_psi) r.max_psi = moved;
+        if (fabsf(err) > band_deg) r.settle_s = s->t - t0;
+        float past = (turn >= 0.0f) ? -err : err;
+        if (past > r.overshoot_deg) r.overshoot_deg = past;
+        if (s->t - t0 > duration_s - 5.0f) {
+            sum += fabsf(err);
+            n++;
+        }
+    }
+    r.final_err_deg = n ? sum / n : 0.0f;
+    return r;
+}
+
+static void settle_speed(sim_t *s, float speed, float hdg) {
+    ctrl_setpoint_t sp = { .heading_deg = hdg, .speed_m_s = speed, .enabled = true };
+    for (int i = 0; i < (int)(20.0f / DT_S); i++) sim_step(s, &sp);
+}
+
+// --- SCENARIOS ---
+
+static void test_turn(void) {
+    sim_t s;
+    sim_init(&s, 0.0f, 0.0f);
+    settle_speed(&s, 2.0f, 0.0f);
+
+    ctrl_setpoint_t sp = { .heading_deg = 90.0f, .speed_m_s = 2.0f, .enabled = true };
+    resp_t r = run_turn(&s, &sp, 30.0f, 2.0f);
+    printf("90 deg turn at 2 m/s (K=%.3f deg/s/raw, T=%.1f s)\n", YAW_K0 * (1.0f + 2.0f / YAW_K_SPEED), YAW_T_S);
+    printf("  settle (2 deg) %.2f s, overshoot %.2f deg, final |err| %.2f deg\n",
+           r.settle_s, r.overshoot_deg, r.final_err_deg);
+    check("settles within 2 deg in < 6 s", r.settle_s < 6.0f);
+    check("overshoot < 10 deg", r.overshoot_deg < 10.0f);
+    check("final error < 1 deg (noise 0.3 deg)", r.final_err_deg < 1.0f);
+
+    sim_init(&s, 350.0f, 0.0f);
+    settle_speed(&s, 2.0f, 350.0f);
+    sp.heading_deg = 20.0f;
+    r = run_turn(&s, &sp, 20.0f, 2.0f);
+    printf("\n350 -> 20 deg across North\n");
+    printf("  swept %.1f..%.1f deg from the start\n", r.min_psi, r.max_psi);
+    check("short way (clockwise, never back past -5 deg)", r.min_psi > -5.0f && r.max_psi < 40.0f);
+    check("settles within 2 deg in < 6 s", r.settle_s < 6.0f);
+}
+
+static void test_disturbance(void) {
+    sim_t s;
+    sim_init(&s, 45.0f, 0.0f);
+    settle_speed(&s, 3.0f, 45.0f);
+    s.dist = 8.0f;              // 8 deg/s of yaw if uncorrected
+
+    ctrl_setpoint_t sp = { .heading_deg = 45.0f, .speed_m_s = 3.0f, .enabled = true };
+    resp_t r = run_turn(&s, &sp, 40.0f, 1.0f);
+    printf("\nConstant yaw disturbance (8 deg/s) at 3 m/s\n");
+    printf("  peak deviation %.2f deg, final |err| %.2f deg, integrator %.0f raw\n",
+           fmaxf(r.max_psi, -r.min_psi), r.final_err_deg, s.law.hdg_i);
+    check("integrator removes steady-state error (< 0.5 deg)", r.final_err_deg < 0.5f);
+    check("peak deviation < 10 deg", fmaxf(r.max_psi, -r.min_psi) < 10.0f);
+}
+
+static void test_reversal(void) {
+    sim_t s;
+    sim_init(&s, 0.0f, 0.0f);
+    settle_speed(&s, 1.0f, 0.0f);
+
+    ctrl_setpoint_t sp = { .heading_deg = 179.0f, .speed_m_s = 1.0f, .enabled = true };
+    uint32_t sat = 0;
+    float t0 = s.t;
+    resp_t r = { 0 };
+    while (s.t - t0 < 1.0f) {      // First second: differential must hit the limit
+        sim_step(&s, &sp);
+        if (s.law.hdg_sat) sat++;
+    }
+    r = run_turn(&s, &sp, 30.0f, 2.0f);
+    printf("\n179 deg reversal at 1 m/s (differential limit %d raw)\n", CTRL_DIFF_MAX_RAW);
+    printf("  saturated %lu periods in the first second, overshoot %.2f deg, settle %.2f s\n",
+           (unsigned long)sat, r.overshoot_deg, r.settle_s + 1.0f);
+    check("differential saturates", sat > 0);
+    check("anti-windup: overshoot < 15 deg", r.overshoot_deg < 15.0f);
+    check("integrator within its clamp", fabsf(s.law.hdg_i) <= CTRL_HDG_I_MAX);
+}
+
+static void test_speed(void) {
+    sim_t s;
+    sim_init(&s, 0.0f, 0.0f);
+    ctrl_setpoint_t sp = { .heading_deg = 0.0f, .speed_m_s = 4.0f, .enabled = true };
+    float t90 = -1.0f;
+    while (s.t < 30.0f) {
+        sim_step(&s, &sp);
+        if (t90 < 0.0f && s.v >= 0.9f * sp.speed_m_s) t90 = s.t;
+    }
+    printf("\nSpeed step 0 -> 4 m/s\n");
+    printf("  90%% at %.2f s, final %.3f m/s, base %.0f raw\n", t90, s.v, s.law.u_base);
+    check("reaches 90% in < 8 s", t90 > 0.0f && t90 < 8.0f);
+    check("final speed within 2%", fabsf(s.v - sp.speed_m_s) < 0.02f * sp.speed_m_s);
+    check("common throttle within CTRL_BASE_MAX_RAW", s.law.u_base <= CTRL_BASE_MAX_RAW);
+}
+
+static void test_idle(void) {
+    sim_t s;
+    sim_init(&s, 0.0f, 0.0f);
+    settle_speed(&s, 2.0f, 0.0f);
+    printf("\nIdle outputs\n");
+
+    ctrl_setpoint_t sp = { .heading_deg = 120.0f, .speed_m_s = 0.0f, .enabled = true };
+    sim_step(&s, &sp);
+    check("speed 0 with a heading error: both idle", s.left == MOTOR_IDLE_RAW && s.right == MOTOR_IDLE_RAW);
+    check("speed 0 clears integrators", s.law.hdg_i == 0.0f && s.law.spd_i == 0.0f);
+
+    sp.speed_m_s = 2.0f;
+    sp.enabled = false;
+    sim_step(&s, &sp);
+    check("disabled: both idle", s.left == MOTOR_IDLE_RAW && s.right == MOTOR_IDLE_RAW);
+
+    sp.enabled = true;
+    ctrl_measurement_t bad = { .heading_deg = 0.0f, .speed_m_s = 2.0f, .is_valid = false };
+    ctrl_law_step(&s.law, &bad, &sp, DT_S, &s.left, &s.right);
+    check("invalid measurement: both idle", s.left == MOTOR_IDLE_RAW && s.right == MOTOR_IDLE_RAW);
+}
+
+static void bench(void) {
+    ctrl_law_t law;
+    ctrl_law_init(&law);
+    ctrl_setpoint_t sp = { .heading_deg = 90.0f, .speed_m_s = 2.0f, .enabled = true };
+    ctrl_measurement_t meas = { .heading_deg = 0.0f, .speed_m_s = 1.5f, .is_valid = true };
+    volatile uint32_t sink = 0;
+    uint16_t l, r;
+
+    double t0 = now_ns();
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int i = 0; i < BENCH_STEPS; i++) {
+        meas.heading_deg = (float)(i & 1023) * 0.35f;
+        ctrl_law_step(&law, &meas, &sp, DT_S, &l, &r);
+        sink += l;
+    }
+#ifdef HAVE_TSC
+    uint64_t c1 = __rdtsc();
+#endif
+    double ns = (now_ns() - t0) / BENCH_STEPS;
+
+    printf("\nCost per ctrl_law_step() (%d steps, host):\n", BENCH_STEPS);
+#ifdef HAVE_TSC
+    printf("  %6.2f ns  %6.1f TSC ticks\n", ns, (double)(c1 - c0) / BENCH_STEPS);
+#else
+    printf("  %6.2f ns\n", ns);
+#endif
+    (void)sink;
+}
+
+int main(void) {
+    test_turn();
+    test_disturbance();
+    test_reversal();
+    test_speed();
+    test_idle();
+    bench();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,316 @@
+/**
+ * @file deadline_sim.c
+ * @brief Host test of the deadline tracker with synthetic overruns
+ * @details
+ * Runs src/sys_deadline_track.c on a virtual microsecond clock with the
+ * control loop timing (20 ms period, 5 ms budget) and checks:
+ * - nominal jittered loop: no overrun, no miss, WCET = longest iteration;
+ * - one overrun inside the period: counted, not a miss;
+ * - one iteration past its deadline: one miss, no escalation;
+ * - DL_ESCALATE_CONSECUTIVE misses in a row: escalation on the last one,
+ *   recovery after exactly DL_RECOVER_CLEAN on-time iterations;
+ * - sparse misses: escalation once DL_WINDOW_MISSES fall in the window,
+ *   none when they are spread wider;
+ * - hung iteration: escalated by the poll after DL_HUNG_PERIODS, lost
+ *   periods counted as skipped when the task comes back;
+ * - late start: whole periods skipped, release phase kept;
+ * - 32-bit microsecond wrap in the middle of a run;
+ * - restart: counters cleared, escalation kept;
+ * then reports ns and TSC ticks per begin/end pair.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/deadline_sim.c src/sys_deadline_track.c -o deadline_sim
+ *   ./deadline_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "sys_deadline.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define PERIOD_US       20000       // CTRL_PERIOD_US
+#define BUDGET_US       5000        // CTRL_BUDGET_US
+#define BENCH_PAIRS     (1 << 24)
+
+static const dl_config_t cfg = { .name = "ctrl", .period_us = PERIOD_US, .budget_us = BUDGET_US };
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) % n;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+/**
+ * @brief Virtual loop: tracks the nominal release like the GPTimer does
+ */
+typedef struct {
+    dl_track_t t;
+    uint32_t release;           // Next nominal release
+    uint32_t now;               // Virtual clock (end of the last iteration)
+    int changes;                // Escalation state changes reported by end()
+} sim_t;
+
+static void sim_init(sim_t *s, uint32_t start_us) {
+    dl_track_init(&s->t, &cfg);
+    s->release = start_us;
+    s->now = start_us;
+    s->changes = 0;
+}
+
+/**
+ * @brief One iteration: wakes at the next release (or now, if still busy)
+ * @return true if end() changed the escalation state
+ */
+static bool sim_iter(sim_t *s, uint32_t wake_us, uint32_t exec_us) {
+    // Releases that passed while busy are lost (timer notifications collapse)
+    while ((int32_t)(s->now - s->release) >= PERIOD_US) s->release += PERIOD_US;
+    uint32_t start = (int32_t)(s->now - s->release) > 0 ? s->now : s->release;
+    start += wake_us;
+
+    dl_track_begin(&s->t, start);
+    s->now = start + exec_us;
+    bool changed = dl_track_end(&s->t, s->now);
+    if (changed) s->changes++;
+    s->release += PERIOD_US;
+    return changed;
+}
+
+static void sim_nominal(sim_t *s, int n) {
+    for (int i = 0; i < n; i++) sim_iter(s, rnd(200), 1000 + rnd(2000));
+}
+
+// --- SCENARIOS ---
+
+static void test_nominal(void) {
+    sim_t s;
+    sim_init(&s, 1000);
+    uint32_t wcet = 0;
+    for (int i = 0; i < 10000; i++) {
+        uint32_t exec = 1000 + rnd(3000);
+        if (exec > wcet) wcet = exec;
+        sim_iter(&s, rnd(200), exec);
+    }
+    const dl_stats_t *st = &s.t.stats;
+    printf("Nominal (10000 iterations, exec 1-4 ms, wake jitter < 200 us)\n");
+    check("no overrun, no miss, no skip", st->overruns == 0 && st->misses == 0 && st->skipped == 0);
+    check("WCET = longest iteration", st->exec_max_us == wcet);
+    check("start lateness = wake jitter", st->start_late_max_us < 200);
+    check("never escalated", st->escalations == 0 && !st->escalated);
+}
+
+static void test_single(void) {
+    sim_t s;
+    sim_init(&s, 1000);
+    printf("\nSingle overrun (8 ms) and single miss (25 ms)\n");
+    sim_nominal(&s, 100);
+    sim_iter(&s, 0, 8000);
+    check("8 ms: overrun, not a miss", s.t.stats.overruns == 1 && s.t.stats.misses == 0);
+    sim_nominal(&s, 100);
+    sim_iter(&s, 0, 25000);
+    check("25 ms: miss, WCET 25 ms", s.t.stats.misses == 1 && s.t.stats.exec_max_us == 25000);
+    sim_nominal(&s, 100);
+    check("late next start absorbed, no skip", s.t.stats.skipped == 0 && s.t.stats.misses == 1);
+    check("no escalation", s.changes == 0 && !s.t.stats.escalated);
+}
+
+static void test_burst(void) {
+    sim_t s;
+    sim_init(&s, 1000);
+    printf("\nBurst: %d misses in a row, then recovery\n", DL_ESCALATE_CONSECUTIVE);
+    sim_nominal(&s, 100);
+
+    bool early = false;
+    for (int i = 0; i < DL_ESCALATE_CONSECUTIVE - 1; i++) early |= sim_iter(&s, 0, 21000);
+    bool esc = sim_iter(&s, 0, 21000);
+    check("escalates on the last miss of the run, not before", !early && esc && s.t.stats.escalated);
+    check("one escalation, consecutive count", s.t.stats.escalations == 1 &&
+          s.t.stats.consecutive == DL_ESCALATE_CONSECUTIVE);
+
+    // The task catches up (short iterations) and must stay clean for the whole recovery run
+    bool recovered = false;
+    int n = 0;
+    while (!recovered && n < 10 * DL_RECOVER_CLEAN) {
+        recovered = sim_iter(&s, 0, 1500);
+        n++;
+    }
+    printf("  recovered after %d on-time iterations\n", n);
+    check("recovery after exactly DL_RECOVER_CLEAN clean iterations", recovered && n == DL_RECOVER_CLEAN);
+    check("window cleared on recovery", s.t.stats.window_misses == 0 && !s.t.stats.escalated);
+
+    // A miss during the recovery run restarts it
+    sim_init(&s, 1000);
+    for (int i = 0; i < DL_ESCALATE_CONSECUTIVE; i++) sim_iter(&s, 0, 21000);
+    sim_nominal(&s, DL_RECOVER_CLEAN - 1);
+    sim_iter(&s, 0, 21000);
+    sim_nominal(&s, DL_RECOVER_CLEAN - 1);
+    check("a miss while escalated restarts the recovery run", s.t.stats.escalated);
+    sim_nominal(&s, 1);
+    check("... and it completes afterwards", !s.t.stats.escalated && s.changes == 2);
+}
+
+static void test_window(void) {
+    printf("\nSparse misses: window of %d, limit %d\n", DL_WINDOW, DL_WINDOW_MISSES);
+
+    // Every 10th iteration misses: the limit falls inside one window
+    sim_t s;
+    sim_init(&s, 1000);
+    int at = -1;
+    for (int i = 0; i < 200 && at < 0; i++) {
+        bool miss = i % 10 == 0;
+        if (sim_iter(&s, 0, miss ? 21000 : 1500)) at = i;
+    }
+    printf("  1 in 10: escalated at iteration %d (consecutive %u)\n", at, s.t.stats.consecutive);
+    check("1 in 10 escalates on the limit-th miss", at == 10 * (DL_WINDOW_MISSES - 1));
+
+    // Spread wider than the window: never more than the limit - 1 inside it
+    int spread = DL_WINDOW / (DL_WINDOW_MISSES - 1) + 1;
+    sim_init(&s, 1000);
+    uint8_t peak = 0;
+    for (int i = 0; i < 5000; i++) {
+        sim_iter(&s, 0, i % spread == 0 ? 21000 : 1500);
+        if (s.t.stats.window_misses > peak) peak = s.t.stats.window_misses;
+    }
+    printf("  1 in %d: %lu misses, window peak %u\n", spread, (unsigned long)s.t.stats.misses, peak);
+    check("spread misses never escalate", s.t.stats.escalations == 0 && peak == DL_WINDOW_MISSES - 1);
+}
+
+static void test_hung(void) {
+    sim_t s;
+    sim_init(&s, 1000);
+    printf("\nHung iteration (blocked for 7 periods)\n");
+    sim_iter(&s, 0, 1500);                          // No wake jitter: tracker phase = sim phase
+    sim_nominal(&s, 99);
+
+    while ((int32_t)(s.now - s.release) >= 0) s.release += PERIOD_US;
+    uint32_t start = s.release;
+    dl_track_begin(&s.t, start);
+    bool early = false;
+    for (uint32_t dt = 0; dt < (DL_HUNG_PERIODS * PERIOD_US); dt += DL_POLL_PERIOD_MS * 1000) {
+        early |= dl_track_poll(&s.t, start + dt);
+    }
+    bool esc = dl_track_poll(&s.t, start + DL_HUNG_PERIODS * PERIOD_US);
+    bool again = dl_track_poll(&s.t, start + (DL_HUNG_PERIODS + 1) * PERIOD_US);
+    check("poll escalates at DL_HUNG_PERIODS, once", !early && esc && !again);
+    check("counted as hung", s.t.stats.hung == 1 && s.t.stats.escalations == 1);
+
+    s.now = start + 7 * PERIOD_US;
+    dl_track_end(&s.t, s.now);
+    s.release += PERIOD_US;
+    check("the hung iteration is a miss", s.t.stats.misses == 1 && s.t.stats.exec_max_us == 7 * PERIOD_US);
+    sim_iter(&s, 0, 1500);
+    printf("  skipped %lu periods\n", (unsigned long)s.t.stats.skipped);
+    check("lost releases counted as skipped", s.t.stats.skipped == 6);
+    sim_nominal(&s, DL_RECOVER_CLEAN);
+    check("recovers like a burst", !s.t.stats.escalated);
+}
+
+static void test_late_start(void) {
+    dl_track_t t;
+    dl_track_init(&t, &cfg);
+    printf("\nLate start (2.5 periods after the release)\n");
+
+    dl_track_begin(&t, 0);
+    dl_track_end(&t, 1000);                         // Next release at 20000
+    dl_track_begin(&t, 20000 + 2 * PERIOD_US + PERIOD_US / 2);
+    dl_track_end(&t, 20000 + 2 * PERIOD_US + PERIOD_US / 2 + 1000);
+    check("2 periods skipped, 0.5 period late", t.stats.skipped == 2 && t.stats.start_late_max_us == PERIOD_US / 2);
+    check("on time inside its own period: no miss", t.stats.misses == 0);
+
+    dl_track_begin(&t, 80000);                      // Phase kept: release 80000
+    dl_track_end(&t, 81000);
+    check("release phase kept", t.stats.skipped == 2 && t.stats.start_late_max_us == PERIOD_US / 2);
+}
+
+static void test_wrap(void) {
+    sim_t s;
+    uint32_t start = UINT32_MAX - 50 * PERIOD_US + 1;
+    sim_init(&s, start);
+    printf("\nMicrosecond wrap (start at 0x%08lx)\n", (unsigned long)start);
+    sim_nominal(&s, 100);
+    sim_iter(&s, 0, 25000);
+    sim_nominal(&s, 100);
+    check("clock wrapped during the run", s.now < start);
+    check("exactly the one miss, no skip", s.t.stats.misses == 1 && s.t.stats.skipped == 0);
+    check("WCET across the wrap", s.t.stats.exec_max_us == 25000);
+}
+
+static void test_restart(void) {
+    sim_t s;
+    sim_init(&s, 1000);
+    printf("\nRestart while escalated\n");
+    for (int i = 0; i < DL_ESCALATE_CONSECUTIVE; i++) sim_iter(&s, 0, 21000);
+    dl_track_restart(&s.t);
+    check("counters cleared", s.t.stats.iterations == 0 && s.t.stats.misses == 0 && s.t.stats.exec_max_us == 0);
+    check("escalation kept", s.t.stats.escalated && s.t.stats.escalations == 1);
+
+    s.release = s.now + 3 * PERIOD_US + 777;        // New phase after the pause
+    sim_nominal(&s, DL_RECOVER_CLEAN);
+    check("new phase: no skip, recovered", s.t.stats.skipped == 0 && !s.t.stats.escalated);
+}
+
+static void bench(void) {
+    dl_track_t t;
+    dl_track_init(&t, &cfg);
+    volatile uint32_t sink = 0;
+    uint32_t now = 0;
+
+    double t0 = now_ns();
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int i = 0; i < BENCH_PAIRS; i++) {
+        dl_track_begin(&t, now);
+        now += 1000 + (i & 7) * 300;
+        sink += dl_track_end(&t, now);
+        now += PERIOD_US - 1000;
+    }
+#ifdef HAVE_TSC
+    uint64_t c1 = __rdtsc();
+#endif
+    double ns = (now_ns() - t0) / BENCH_PAIRS;
+
+    printf("\nCost per begin/end pair (%d pairs, host, tracker only):\n", BENCH_PAIRS);
+#ifdef HAVE_TSC
+    printf("  %6.2f ns  %6.1f TSC ticks\n", ns, (double)(c1 - c0) / BENCH_PAIRS);
+#else
+    printf("  %6.2f ns\n", ns);
+#endif
+    (void)sink;
+}
+
+int main(void) {
+    test_nominal();
+    test_single();
+    test_burst();
+    test_window();
+    test_hung();
+    test_late_start();
+    test_wrap();
+    test_restart();
+    bench();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
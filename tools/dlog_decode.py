@@ -0,0 +1,221 @@
+#!/usr/bin/env python3
+"""
+Decode sys_dlog deferred log frames back into text.
+
+Usage:
+    pio device monitor --raw | tee run.bin     # or any raw capture of the console
+    python3 tools/dlog_decode.py .pio/build/<env>/firmware.elf run.bin [--us]
+
+The capture may mix plain ESP_LOG text and binary dlog frames; text is
+passed through and frames are printed in the ESP_LOG layout:
+
+    I (12345) BATTERY: Status: 7.84V (61.5%)
+
+Frame (see include/sys_dlog.h):
+    0x1E 0xD1 core nwords word[nwords] (little-endian) xor8(core..last word)
+    word[0] fmt address   word[1] tag address   word[2] time_us (low 32 bits)
+    word[3] types(16) | nargs << 16 | level << 20 | dropped << 24
+
+Format strings and tags are read from the loaded sections of the ELF the
+firmware was built from (it must be the exact same build). No third-party
+module is needed: the ELF reader below handles ELF32 and ELF64.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+SYNC = b"\x1e\xd1"
+HDR_WORDS = 4
+MAX_WORDS = 4 + 2 * 6
+
+T_INT, T_FLOAT, T_STR, T_INT64 = 0, 1, 2, 3
+LEVELS = {1: "E", 2: "W", 3: "I", 4: "D"}
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+SPEC = re.compile(r"%([-+ #0]*)(\d*|\*)(\.\d+)?(hh|h|ll|l|z|j|t|L)?([diouxXeEfFgGcsp%])")
+
+
+class Elf:
+    """Address -> bytes for the allocated sections of an ELF file."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            data = f.read()
+        if data[:4] != b"\x7fELF":
+            raise ValueError(f"{path}: not an ELF file")
+        is64 = data[4] == 2
+        end = "<" if data[5] == 1 else ">"
+        if is64:
+            shoff, = struct.unpack_from(end + "Q", data, 0x28)
+            shentsize, shnum = struct.unpack_from(end + "HH", data, 0x3A)
+            sh_fmt = end + "IIQQQQIIQQ"
+        else:
+            shoff, = struct.unpack_from(end + "I", data, 0x20)
+            shentsize, shnum = struct.unpack_from(end + "HH", data, 0x2E)
+            sh_fmt = end + "IIIIIIIIII"
+
+        self.sections = []
+        for i in range(shnum):
+            f = struct.unpack_from(sh_fmt, data, shoff + i * shentsize)
+            sh_type, flags, addr, offset, size = f[1], f[2], f[3], f[4], f[5]
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and size > 0:
+                self.sections.append((addr, size, data[offset:offset + size]))
+
+    def cstring(self, addr):
+        for base, size, blob in self.sections:
+            # Host builds (the bench) only keep the low 32 bits of addresses
+            off = addr - (base & 0xFFFFFFFF)
+            if 0 <= off < size:
+                end = blob.find(b"\0", off)
+                return blob[off:end if end >= 0 else size].decode("utf-8", "replace")
+        return None
+
+
+def format_entry(elf, fmt, types, args):
+    """printf-style formatting with the argument types recorded by the target."""
+    out = []
+    pos = 0
+    ai = 0
+    for m in SPEC.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, _, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if ai >= len(args):
+            out.append(m.group(0))
+            continue
+        t, v = types[ai], args[ai]
+        ai += 1
+        spec = "%" + flags + width + (prec or "")
+        bits = 64 if t == T_INT64 else 32
+        if conv in "di":
+            if v >= 1 << (bits - 1):
+                v -= 1 << bits
+            out.append((spec + "d") % v)
+        elif conv in "ouxX":
+            out.append((spec + conv) % v)
+        elif conv == "c":
+            out.append((spec + "c") % chr(v & 0xFF))
+        elif conv == "p":
+            out.append("0x%x" % v)
+        elif conv == "s":
+            s = elf.cstring(v) if t == T_STR else None
+            out.append((spec + "s") % (s if s is not None else "<0x%08x>" % v))
+        else:
+            if t == T_FLOAT:
+                v = struct.unpack("<f", struct.pack("<I", v))[0]
+            out.append((spec + conv) % v)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class Decoder:
+    def __init__(self, elf, show_us):
+        self.elf = elf
+        self.show_us = show_us
+        self.last_us = None
+        self.frames = 0
+        self.bad = 0
+        self.dropped = 0
+
+    def unwrap(self, t32):
+        if self.last_us is None:
+            self.last_us = t32
+            return t32
+        # Signed distance to the newest time seen: handles the 71 min wrap
+        # and the slight reordering between the two cores' rings
+        delta = (t32 - self.last_us) & 0xFFFFFFFF
+        if delta >= 1 << 31:
+            delta -= 1 << 32
+        t = self.last_us + delta
+        self.last_us = max(self.last_us, t)
+        return t
+
+    def entry(self, core, w):
+        meta = w[3]
+        nargs = (meta >> 16) & 0x0F
+        level = (meta >> 20) & 0x0F
+        drops = meta >> 24
+        types = [(meta >> (2 * i)) & 3 for i in range(nargs)]
+
+        args = []
+        i = HDR_WORDS
+        for t in types:
+            if i + (2 if t == T_INT64 else 1) > len(w):
+                break
+            if t == T_INT64:
+                args.append(w[i] | (w[i + 1] << 32))
+                i += 2
+            else:
+                args.append(w[i])
+                i += 1
+
+        fmt = self.elf.cstring(w[0])
+        tag = self.elf.cstring(w[1]) or "?"
+        text = format_entry(self.elf, fmt, types, args) if fmt is not None else \
+            "<unknown format 0x%08x> %s" % (w[0], " ".join("0x%x" % a for a in args))
+
+        t = self.unwrap(w[2])
+        stamp = "%d" % t if self.show_us else "%d" % (t // 1000)
+        lines = []
+        if drops:
+            self.dropped += drops
+            lines.append("W (%s) DLOG: core %d: %d%s entries lost" % (stamp, core, drops, "+" if drops == 255 else ""))
+        lines.append("%s (%s) %s: %s" % (LEVELS.get(level, "?"), stamp, tag, text))
+        return lines
+
+    def run(self, data, write):
+        i = 0
+        text_start = 0
+        n = len(data)
+        while i < n:
+            j = data.find(SYNC, i)
+            if j < 0 or j + 4 > n:
+                break
+            nwords = data[j + 3]
+            flen = 4 + 4 * nwords + 1
+            ok = HDR_WORDS <= nwords <= MAX_WORDS and j + flen <= n
+            if ok:
+                x = 0
+                for b in data[j + 2:j + flen - 1]:
+                    x ^= b
+                ok = x == data[j + flen - 1]
+            if not ok:
+                if j + flen <= n:
+                    self.bad += 1
+                i = j + 1
+                continue
+
+            write(data[text_start:j].decode("utf-8", "replace"))
+            words = struct.unpack_from("<%dI" % nwords, data, j + 4)
+            for line in self.entry(data[j + 2], words):
+                write(line + "\n")
+            self.frames += 1
+            i = text_start = j + flen
+        write(data[text_start:].decode("utf-8", "replace"))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("elf", help="firmware ELF of the running build")
+    ap.add_argument("capture", help="raw console capture ('-' for stdin)")
+    ap.add_argument("--us", action="store_true", help="print timestamps in microseconds")
+    args = ap.parse_args()
+
+    elf = Elf(args.elf)
+    data = sys.stdin.buffer.read() if args.capture == "-" else open(args.capture, "rb").read()
+
+    dec = Decoder(elf, args.us)
+    dec.run(data, sys.stdout.write)
+    print("# %d frames decoded, %d rejected, %d entries lost on target" % (dec.frames, dec.bad, dec.dropped),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,414 @@
+/**
+ * @file ekf_sim.c
+ * @brief Host test of the GPS/IMU error-state EKF on simulated trajectories
+ * @details
+ * A rescue run in local ENU (start at 47.3977 N, 8.5456 E): 10 s at rest,
+ * accelerate to 8 m/s, straight leg, 180 deg turn at 6 deg/s, straight
+ * leg, stop. Horizontal acceleration is fed to ekf_predict() at 100 Hz
+ * with 0.3 m/s^2 white noise and a body-frame bias that rotates with the
+ * heading. GPS fixes are built from the truth with gps_fix_t fields
+ * (lat/lon e7) and applied through ekf_update_gps(). Checks:
+ * - UBX 10 Hz (0.8 m / 0.08 m/s noise): position and velocity error rms
+ *   below the raw GPS error, errors inside 3 sigma of the reported std;
+ * - 15 s GPS dropouts: drift < 3 m on a straight leg and < 15 m in the
+ *   turn (the earth-frame bias state cannot follow the rotating body
+ *   bias), always inside 3 sigma of the reported std;
+ *   ekf_is_gps_aided() drops, error recovers within 2 s;
+ * - single 60 m multipath outlier: gated, estimate not pulled;
+ * - persistent 40 m jump: re-seeded after EKF_MAX_REJECTS fixes;
+ * - NMEA 1 Hz (speed/course, no hAcc): position error below raw GPS;
+ * - ekf_predict_body() maps an AHRS heading of East onto the East axis;
+ * then reports ns and TSC ticks per ekf_predict() and ekf_update_gps().
+ * On target the same steps are timed in ekf_t.stats (CPU cycles).
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/ekf_sim.c src/fusion_ekf.c src/fusion_ahrs.c src/nav_geo.c -lm -o ekf_sim
+ *   ./ekf_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "fusion_ekf.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define IMU_HZ          100
+#define DT              (1.0 / IMU_HZ)
+#define RUN_S           140.0
+#define SETTLE_S        15.0        // Skipped before the error statistics
+#define ORIGIN_LAT_E7   473977000
+#define ORIGIN_LON_E7   85456000
+#define ACCEL_NOISE     0.3         // m/s^2 (1 sigma)
+#define BIAS_FWD        0.10        // m/s^2, body frame
+#define BIAS_RIGHT      (-0.06)
+#define DROPOUT_S       15.0
+#define BENCH_STEPS     (1 << 22)
+
+#define DEG             (M_PI / 180.0)
+
+/**
+ * @brief True craft state (ENU, heading clockwise from North)
+ */
+typedef struct {
+    double t;
+    double e, n;
+    double speed;
+    double heading;             // rad
+    double ae, an;              // Earth-frame acceleration over the last step
+} sim_truth_t;
+
+/**
+ * @brief GPS behaviour of a scenario
+ */
+typedef struct {
+    const char *name;
+    int rate_hz;
+    bool ubx;                   // false = NMEA (speed/course, no accuracy)
+    double pos_noise_m;         // 1 sigma per axis
+    double vel_noise_m_s;
+    double dropout_from_s;      // [from, to) without fixes
+    double dropout_to_s;
+    double outlier_at_s;        // Single fix offset 60 m East (0 = none)
+    double jump_from_s;         // All fixes offset 40 m North from here (0 = none)
+} sim_gps_t;
+
+/**
+ * @brief Error statistics of a run
+ */
+typedef struct {
+    double pos_sq, vel_sq, gps_sq;
+    int n, gps_n;
+    int outside_3sigma;
+    double drop_max_err;        // Worst position error during the dropout
+    bool drop_inside_3sigma;    // Dropout errors inside 3 sigma
+    bool aided_during_drop;     // ekf_is_gps_aided() true 2 s into the dropout
+    double recover_err;         // Position error 2 s after GPS returns
+    double outlier_err;         // Position error right after the outlier
+} sim_stats_t;
+
+static nav_origin_t truth_origin;
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double gauss(void) {
+    // Sum of 4 uniforms: close enough to normal for sensor noise
+    double s = 0.0;
+    for (int i = 0; i < 4; i++) s += rnd() / 16777216.0;
+    return (s - 2.0) * 1.7320508;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+/**
+ * @brief Along-track acceleration and turn rate of the mission profile
+ */
+static void profile(double t, double *accel, double *rate) {
+    *accel = 0.0;
+    *rate = 0.0;
+    if (t >= 10.0 && t < 20.0) *accel = 0.8;            // 0 -> 8 m/s
+    if (t >= 60.0 && t < 90.0) *rate = 6.0 * DEG;       // 180 deg turn to starboard
+    if (t >= 120.0 && t < 130.0) *accel = -0.8;         // Stop
+}
+
+static void truth_step(sim_truth_t *tr) {
+    double accel, rate;
+    profile(tr->t, &accel, &rate);
+
+    // Midpoint integration of speed / heading / position
+    double ve0 = tr->speed * sin(tr->heading), vn0 = tr->speed * cos(tr->heading);
+    double speed_m = tr->speed + 0.5 * accel * DT;
+    double hdg_m = tr->heading + 0.5 * rate * DT;
+    tr->e += speed_m * sin(hdg_m) * DT;
+    tr->n += speed_m * cos(hdg_m) * DT;
+    tr->speed += accel * DT;
+    tr->heading += rate * DT;
+    tr->t += DT;
+
+    tr->ae = (tr->speed * sin(tr->heading) - ve0) / DT;
+    tr->an = (tr->speed * cos(tr->heading) - vn0) / DT;
+}
+
+/**
+ * @brief GPS fix from the truth (noise added in metres before projection)
+ */
+static void make_fix(const sim_truth_t *tr, const sim_gps_t *g, double de, double dn, gps_fix_t *fix) {
+    memset(fix, 0, sizeof(*fix));
+    nav_geo_unproject(&truth_origin, (float)(tr->e + de), (float)(tr->n + dn), &fix->lat_e7, &fix->lon_e7);
+    fix->rx_time_us = (int64_t)llround(tr->t * 1e6);
+    fix->fix_type = GPS_FIX_3D;
+    fix->num_sv = 12;
+    fix->from_ubx = g->ubx;
+
+    double ve = tr->speed * sin(tr->heading) + g->vel_noise_m_s * gauss();
+    double vn = tr->speed * cos(tr->heading) + g->vel_noise_m_s * gauss();
+    if (g->ubx) {
+        fix->vel_e_mm_s = (int32_t)lround(ve * 1e3);
+        fix->vel_n_mm_s = (int32_t)lround(vn * 1e3);
+        fix->h_acc_mm = (uint32_t)lround(g->pos_noise_m * 1.5e3);
+        fix->s_acc_mm_s = (uint32_t)lround(g->vel_noise_m_s * 1.5e3);
+    } else {
+        double course = atan2(ve, vn) / DEG;
+        if (course < 0.0) course += 360.0;
+        fix->ground_speed_mm_s = (int32_t)lround(sqrt(ve * ve + vn * vn) * 1e3);
+        fix->course_e5 = (int32_t)lround(course * 1e5);
+    }
+}
+
+/**
+ * @brief Fly the profile with one GPS behaviour
+ */
+static sim_stats_t run(const sim_gps_t *g, ekf_t *ekf) {
+    sim_truth_t tr = { .t = 0.0, .heading = 30.0 * DEG };
+    sim_stats_t st;
+    memset(&st, 0, sizeof(st));
+    st.drop_inside_3sigma = true;
+    st.recover_err = -1.0;
+    st.outlier_err = -1.0;
+
+    ekf_init(ekf);
+    const int steps = (int)(RUN_S * IMU_HZ);
+    const int gps_every = IMU_HZ / g->rate_hz;
+
+    for (int k = 1; k <= steps; k++) {
+        truth_step(&tr);
+
+        // IMU: earth-frame acceleration + rotating body bias + noise
+        double s = sin(tr.heading), c = cos(tr.heading);
+        double be = BIAS_FWD * s + BIAS_RIGHT * c;
+        double bn = BIAS_FWD * c - BIAS_RIGHT * s;
+        ekf_predict(ekf, (float)(tr.ae + be + ACCEL_NOISE * gauss()),
+                    (float)(tr.an + bn + ACCEL_NOISE * gauss()), (float)DT);
+
+        bool in_drop = tr.t >= g->dropout_from_s && tr.t < g->dropout_to_s;
+        if (k % gps_every == 0 && !in_drop) {
+            double de = g->pos_noise_m * gauss(), dn = g->pos_noise_m * gauss();
+            bool outlier = g->outlier_at_s > 0.0 && fabs(tr.t - g->outlier_at_s) < 0.5 * DT;
+            if (outlier) de += 60.0;
+            if (g->jump_from_s > 0.0 && tr.t >= g->jump_from_s) dn += 40.0;
+
+            gps_fix_t fix;
+            make_fix(&tr, g, de, dn, &fix);
+            ekf_update_gps(ekf, &fix);
+
+            if (tr.t >= SETTLE_S && !outlier) {
+                st.gps_sq += de * de + dn * dn;
+                st.gps_n++;
+            }
+        }
+        if (!ekf->is_initialized) continue;
+
+        // Truth in the filter's frame (origin = first fix)
+        int32_t lat, lon;
+        float te, tn, e, n, ve, vn;
+        nav_geo_unproject(&truth_origin, (float)tr.e, (float)tr.n, &lat, &lon);
+        nav_geo_project(&ekf->origin, lat, lon, &te, &tn);
+        ekf_get_state(ekf, &e, &n, &ve, &vn);
+        double ex = e - te, ey = n - tn;
+        double err = sqrt(ex * ex + ey * ey);
+        double evx = ve - tr.speed * sin(tr.heading), evy = vn - tr.speed * cos(tr.heading);
+        double sx = sqrt(ekf->axis[0].P.pp), sy = sqrt(ekf->axis[1].P.pp);
+
+        if (in_drop) {
+            if (err > st.drop_max_err) st.drop_max_err = err;
+            if (fabs(ex) > 3.0 * sx || fabs(ey) > 3.0 * sy) st.drop_inside_3sigma = false;
+            if (fabs(tr.t - (g->dropout_from_s + 2.5)) < 0.5 * DT) {
+                st.aided_during_drop = ekf_is_gps_aided(ekf, (int64_t)llround(tr.t * 1e6));
+            }
+            continue;
+        }
+        if (g->dropout_to_s > 0.0 && fabs(tr.t - (g->dropout_to_s + 2.0)) < 0.5 * DT) st.recover_err = err;
+        if (g->outlier_at_s > 0.0 && fabs(tr.t - (g->outlier_at_s + 0.05)) < 0.5 * DT) st.outlier_err = err;
+        if (g->jump_from_s > 0.0 && tr.t >= g->jump_from_s) continue;
+
+        if (tr.t >= SETTLE_S) {
+            st.pos_sq += err * err;
+            st.vel_sq += evx * evx + evy * evy;
+            if (fabs(ex) > 3.0 * sx || fabs(ey) > 3.0 * sy) st.outside_3sigma++;
+            st.n++;
+        }
+    }
+    return st;
+}
+
+static void report_accuracy(const sim_gps_t *g, const sim_stats_t *st, double max_pos_ratio) {
+    char what[96];
+    double pos = sqrt(st->pos_sq / st->n), gps = sqrt(st->gps_sq / st->gps_n);
+    double vel = sqrt(st->vel_sq / st->n);
+
+    snprintf(what, sizeof(what), "%s: position rms %.2f m (raw GPS %.2f m)", g->name, pos, gps);
+    check(what, pos < max_pos_ratio * gps);
+    snprintf(what, sizeof(what), "%s: velocity rms %.3f m/s", g->name, vel);
+    check(what, vel < (g->ubx ? 0.15 : 0.5));
+    snprintf(what, sizeof(what), "%s: %.1f%% of errors inside 3 sigma", g->name,
+             100.0 * (st->n - st->outside_3sigma) / st->n);
+    check(what, st->outside_3sigma < st->n / 50);
+}
+
+// --- SCENARIOS ---
+
+static void test_ubx(void) {
+    printf("\nUBX 10 Hz\n");
+    sim_gps_t g = { .name = "UBX 10 Hz", .rate_hz = 10, .ubx = true, .pos_noise_m = 0.8, .vel_noise_m_s = 0.08 };
+    ekf_t ekf;
+    sim_stats_t st = run(&g, &ekf);
+    report_accuracy(&g, &st, 0.6);
+    check("no rejects, no re-seed", ekf.stats.gps_rejects == 0 && ekf.stats.gps_reseeds == 0);
+}
+
+static void dropout(double from_s, double max_drift_m) {
+    sim_gps_t g = { .name = "dropout", .rate_hz = 10, .ubx = true, .pos_noise_m = 0.8, .vel_noise_m_s = 0.08,
+                    .dropout_from_s = from_s, .dropout_to_s = from_s + DROPOUT_S };
+    ekf_t ekf;
+    sim_stats_t st = run(&g, &ekf);
+    char what[96];
+
+    snprintf(what, sizeof(what), "%.0f s dead reckoning: max drift %.2f m", DROPOUT_S, st.drop_max_err);
+    check(what, st.drop_max_err < max_drift_m);
+    check("drift inside 3 sigma of the reported std", st.drop_inside_3sigma);
+    check("ekf_is_gps_aided() false 2.5 s into the dropout", !st.aided_during_drop);
+    snprintf(what, sizeof(what), "2 s after GPS returns: error %.2f m", st.recover_err);
+    check(what, st.recover_err >= 0.0 && st.recover_err < 1.5);
+    check("recovered without re-seed", ekf.stats.gps_reseeds == 0);
+}
+
+static void test_dropout(void) {
+    printf("\nGPS dropout 30..45 s (straight leg)\n");
+    dropout(30.0, 3.0);
+
+    // The bias state is earth-frame: a body bias turning through 90 deg
+    // changes by ~0.16 m/s^2, about 9 m of drift over the dropout
+    printf("\nGPS dropout 65..80 s (mid-turn)\n");
+    dropout(65.0, 15.0);
+}
+
+static void test_outliers(void) {
+    printf("\nOutliers\n");
+    char what[96];
+    ekf_t ekf;
+
+    sim_gps_t g = { .name = "outlier", .rate_hz = 10, .ubx = true, .pos_noise_m = 0.8, .vel_noise_m_s = 0.08,
+                    .outlier_at_s = 50.0 };
+    sim_stats_t st = run(&g, &ekf);
+    snprintf(what, sizeof(what), "60 m multipath fix gated: error after it %.2f m", st.outlier_err);
+    check(what, ekf.stats.gps_rejects == 1 && st.outlier_err >= 0.0 && st.outlier_err < 2.0);
+
+    sim_gps_t j = { .name = "jump", .rate_hz = 10, .ubx = true, .pos_noise_m = 0.8, .vel_noise_m_s = 0.08,
+                    .jump_from_s = 100.0 };
+    run(&j, &ekf);
+    snprintf(what, sizeof(what), "persistent 40 m jump: %lu rejects, %lu re-seed",
+             (unsigned long)ekf.stats.gps_rejects, (unsigned long)ekf.stats.gps_reseeds);
+    check(what, ekf.stats.gps_reseeds == 1 && ekf.stats.gps_rejects >= EKF_MAX_REJECTS);
+}
+
+static void test_nmea(void) {
+    printf("\nNMEA 1 Hz\n");
+    sim_gps_t g = { .name = "NMEA 1 Hz", .rate_hz = 1, .ubx = false, .pos_noise_m = 2.0, .vel_noise_m_s = 0.1 };
+    ekf_t ekf;
+    sim_stats_t st = run(&g, &ekf);
+    report_accuracy(&g, &st, 0.8);
+}
+
+static void test_predict_body(void) {
+    printf("\nBody-frame prediction\n");
+    ekf_t ekf;
+    ahrs_t ahrs;
+    ekf_init(&ekf);
+    ekf_reset(&ekf, 0.0f, 0.0f, 0.0f, 0.0f);
+    ahrs_init(&ahrs, AHRS_ALGO_MADGWICK);
+
+    // Level, nose East: NWU yaw -90 deg
+    ahrs.q0 = (float)cos(-45.0 * DEG);
+    ahrs.q1 = 0.0f;
+    ahrs.q2 = 0.0f;
+    ahrs.q3 = (float)sin(-45.0 * DEG);
+
+    const float accel[3] = { 1.0f, 0.0f, 9.81f };   // 1 m/s^2 forward
+    for (int i = 0; i < IMU_HZ; i++) ekf_predict_body(&ekf, &ahrs, accel, (float)DT);
+
+    float ve, vn;
+    ekf_get_state(&ekf, NULL, NULL, &ve, &vn);
+    char what[96];
+    snprintf(what, sizeof(what), "1 s at 1 m/s^2 heading East: ve %.3f, vn %.3f m/s", ve, vn);
+    check(what, fabsf(ve - 1.0f) < 1e-3f && fabsf(vn) < 1e-3f);
+}
+
+static void bench(void) {
+    ekf_t ekf;
+    static float acc[1024][2];
+    static gps_fix_t fixes[64];
+    sim_gps_t g = { .name = "bench", .rate_hz = 10, .ubx = true, .pos_noise_m = 0.8, .vel_noise_m_s = 0.08 };
+    sim_truth_t tr = { .t = 0.0 };
+
+    for (int i = 0; i < 1024; i++) {
+        acc[i][0] = (float)(ACCEL_NOISE * gauss());
+        acc[i][1] = (float)(ACCEL_NOISE * gauss());
+    }
+    for (int i = 0; i < 64; i++) make_fix(&tr, &g, 0.8 * gauss(), 0.8 * gauss(), &fixes[i]);
+
+    printf("\nCost per step (host):\n");
+    const char *label[2] = {"ekf_predict", "ekf_update_gps"};
+    for (int mode = 0; mode < 2; mode++) {
+        ekf_init(&ekf);
+        ekf_update_gps(&ekf, &fixes[0]);
+        double t0 = now_ns();
+#ifdef HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        for (int i = 0; i < BENCH_STEPS; i++) {
+            if (mode == 0) {
+                ekf_predict(&ekf, acc[i & 1023][0], acc[i & 1023][1], (float)DT);
+            } else {
+                ekf_update_gps(&ekf, &fixes[i & 63]);
+                ekf.axis[0].P.pp = ekf.axis[1].P.pp = 1.0f;     // Keep the gain non-trivial
+            }
+        }
+#ifdef HAVE_TSC
+        uint64_t c1 = __rdtsc();
+#endif
+        double ns = (now_ns() - t0) / BENCH_STEPS;
+#ifdef HAVE_TSC
+        printf("  %-16s %6.2f ns  %6.1f TSC ticks\n", label[mode], ns, (double)(c1 - c0) / BENCH_STEPS);
+#else
+        printf("  %-16s %6.2f ns\n", label[mode], ns);
+#endif
+    }
+}
+
+int main(void) {
+    nav_geo_set_origin(&truth_origin, ORIGIN_LAT_E7, ORIGIN_LON_E7);
+
+    printf("GPS/IMU EKF test (%.0f s run, IMU %d Hz)\n", RUN_S, IMU_HZ);
+    test_ubx();
+    test_dropout();
+    test_outliers();
+    test_nmea();
+    test_predict_body();
+    bench();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
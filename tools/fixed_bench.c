@@ -0,0 +1,229 @@
+/**
+ * @file fixed_bench.c
+ * @brief Host check and benchmark of the fixed-point sensor conversions against the float path
+ * @details
+ * Runs src/cal_fixed.c next to copies of the float formulas of
+ * loadcell_get_weight() and battery_get_voltage() and checks the error bounds:
+ * - load cell: |fixed - float| <= 1 unit over the whole 24-bit range for a
+ *   set of scale factors (integer, fractional, negative); exact for
+ *   integer scales;
+ * - battery: instant voltage within 1 uV of the exact value, filtered
+ *   voltage within the rounding dead band (0.5 / alpha uV) plus 1 uV of
+ *   a double-precision EMA with the same (Q16) alpha, over noisy discharge
+ *   runs with several alphas; the deviation from a float-alpha EMA, which
+ *   also includes the alpha quantization, is reported alongside;
+ * then reports ns and TSC ticks per conversion for both paths.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/fixed_bench.c src/cal_fixed.c -lm -o fixed_bench
+ *   ./fixed_bench
+ *
+ * Host timings favour float (fast hardware divide); on the ESP32-S3 the
+ * float divide is the expensive step. Returns non-zero if a bound fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "cal_fixed.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define BENCH_CONVERSIONS   (1 << 24)
+#define BATT_SAMPLES        200000
+
+static uint32_t rng_state = 12345;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static float gauss(float sigma) {
+    float u1 = ((rnd() >> 8) + 1) / 16777217.0f, u2 = (rnd() >> 8) / 16777216.0f;
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+// Float path of loadcell_get_weight()
+__attribute__((noinline)) static int32_t lc_float(int32_t diff, float scale) {
+    return (int32_t)((float)diff / scale);
+}
+
+__attribute__((noinline)) static int32_t lc_fixed(int32_t diff, const fx_recip_t *r) {
+    return fx_recip_apply(r, diff);
+}
+
+// --- LOAD CELL ---
+
+static int check_loadcell(void) {
+    static const float scales[] = { 1.0f, 7.0f, 21.7f, 96.35f, 420.5f, 2280.0f, -37.25f, 0.75f };
+    int failures = 0;
+
+    printf("Load cell: (raw - offset) / scale over the 24-bit range (HX711 diff up to +-2^24)\n");
+    printf("  scale     | max |err| | mismatches vs float\n");
+    for (size_t s = 0; s < sizeof(scales) / sizeof(scales[0]); s++) {
+        fx_recip_t r;
+        if (!fx_recip_init(&r, scales[s])) {
+            printf("  %9.3f | init failed\n", scales[s]);
+            failures++;
+            continue;
+        }
+
+        int32_t max_err = 0;
+        uint32_t mism = 0, n = 0;
+        bool integer = scales[s] == floorf(scales[s]);
+        for (int32_t d = -(1 << 24); d <= (1 << 24); d += 7, n++) {
+            int32_t a = lc_fixed(d, &r);
+            int32_t b = lc_float(d, scales[s]);
+            int32_t e = abs(a - b);
+            if (e > max_err) max_err = e;
+            if (e) mism++;
+            if (integer && a != d / (int32_t)scales[s]) failures++;
+        }
+        if (max_err > 1) failures++;
+        printf("  %9.3f | %9ld | %lu / %lu\n", scales[s], (long)max_err, (unsigned long)mism, (unsigned long)n);
+    }
+    return failures;
+}
+
+// --- BATTERY ---
+
+static int check_battery(void) {
+    static const float alphas[] = { 0.001f, 0.05f, 0.3f, 1.0f };
+    const float ratio = 7.6766f;        // batt_div_ratio default
+    int failures = 0;
+
+    printf("\nBattery: mV * batt_div_ratio, then EMA (uV state, %d samples per run)\n", BATT_SAMPLES);
+    printf("  alpha  | instant max err | filtered max err | bound       | vs float alpha\n");
+    for (size_t a = 0; a < sizeof(alphas) / sizeof(alphas[0]); a++) {
+        int32_t ratio_uv_q16 = fx_q16_from_float(ratio * 1000.0f);
+        int32_t alpha_q16 = fx_q16_from_float(alphas[a]);
+
+        double alpha_eff = (double)alpha_q16 / FX_Q16_ONE;
+
+        int32_t y_fx = 0;
+        double y_ref = 0.0, y_flt = 0.0;
+        double max_inst = 0.0, max_filt = 0.0, max_flt = 0.0;
+        for (int i = 0; i < BATT_SAMPLES; i++) {
+            // 8.4 V -> 6.6 V discharge with motor sag and ADC noise, in GPIO mV
+            float v = 8.4f - 1.8f * (float)i / BATT_SAMPLES - ((i / 500) % 7 == 0 ? 0.4f : 0.0f);
+            int32_t mv = (int32_t)lroundf(v / ratio * 1000.0f + gauss(3.0f));
+
+            int32_t inst = fx_mul_q16(mv, ratio_uv_q16);
+            double exact = (double)mv * (double)ratio * 1000.0;
+            double e = fabs(inst - exact);
+            if (e > max_inst) max_inst = e;
+
+            if (y_fx == 0) {
+                y_fx = inst;
+                y_ref = exact;
+                y_flt = exact;
+            } else {
+                y_fx = fx_ema_q16(y_fx, inst, alpha_q16);
+                y_ref += alpha_eff * (exact - y_ref);
+                y_flt += (double)alphas[a] * (exact - y_flt);
+            }
+            e = fabs(y_fx - y_ref);
+            if (e > max_filt) max_filt = e;
+            e = fabs(y_fx - y_flt);
+            if (e > max_flt) max_flt = e;
+        }
+
+        double bound = 0.5 / alpha_eff + 1.0;
+        bool ok = max_inst <= 1.0 && max_filt <= bound;
+        if (!ok) failures++;
+        printf("  %6.3f | %10.2f uV | %11.2f uV | %8.1f uV %s | %9.1f uV\n", alphas[a], max_inst, max_filt,
+               bound, ok ? "ok" : "EXCEEDED", max_flt);
+    }
+    return failures;
+}
+
+// --- COST ---
+
+__attribute__((noinline)) static float batt_float(int32_t mv, float ratio, float alpha, float y) {
+    float x = (float)mv * ratio / 1000.0f;
+    return alpha * x + (1.0f - alpha) * y;
+}
+
+__attribute__((noinline)) static int32_t batt_fixed(int32_t mv, int32_t ratio_q16, int32_t alpha_q16, int32_t y) {
+    return fx_ema_q16(y, fx_mul_q16(mv, ratio_q16), alpha_q16);
+}
+
+static void report(const char *name, double ns, uint64_t ticks) {
+#ifdef HAVE_TSC
+    printf("  %-22s %6.2f ns  %6.1f TSC ticks\n", name, ns, (double)ticks / BENCH_CONVERSIONS);
+#else
+    (void)ticks;
+    printf("  %-22s %6.2f ns\n", name, ns);
+#endif
+}
+
+static uint64_t ticks_now(void) {
+#ifdef HAVE_TSC
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static void bench_cost(void) {
+    static int32_t in[4096];
+    for (int i = 0; i < 4096; i++) in[i] = (int32_t)(rnd() >> 8) - (1 << 23);
+
+    fx_recip_t r;
+    fx_recip_init(&r, 21.7f);
+    volatile int32_t isink = 0;
+    volatile float fsink = 0.0f;
+
+    printf("\nCost per conversion (%d conversions, host):\n", BENCH_CONVERSIONS);
+
+    uint64_t c0 = ticks_now();
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CONVERSIONS; i++) isink += lc_float(in[i & 4095], 21.7f);
+    report("load cell, float", (now_ns() - t0) / BENCH_CONVERSIONS, ticks_now() - c0);
+
+    c0 = ticks_now();
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CONVERSIONS; i++) isink += lc_fixed(in[i & 4095], &r);
+    report("load cell, fixed", (now_ns() - t0) / BENCH_CONVERSIONS, ticks_now() - c0);
+
+    float y = 8.0f;
+    c0 = ticks_now();
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CONVERSIONS; i++) y = batt_float(1000 + (in[i & 4095] & 63), 7.6766f, 0.05f, y);
+    report("battery, float", (now_ns() - t0) / BENCH_CONVERSIONS, ticks_now() - c0);
+    fsink = y;
+
+    int32_t ratio_q16 = fx_q16_from_float(7676.6f), alpha_q16 = fx_q16_from_float(0.05f);
+    int32_t yq = 8000000;
+    c0 = ticks_now();
+    t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_CONVERSIONS; i++) yq = batt_fixed(1000 + (in[i & 4095] & 63), ratio_q16, alpha_q16, yq);
+    report("battery, fixed", (now_ns() - t0) / BENCH_CONVERSIONS, ticks_now() - c0);
+    isink += yq;
+
+    (void)isink;
+    (void)fsink;
+}
+
+int main(void) {
+    int failures = check_loadcell();
+    failures += check_battery();
+    bench_cost();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,304 @@
+/**
+ * @file flashlog_sim.c
+ * @brief Host simulation of the store-and-forward flash log
+ * @details
+ * Runs src/sys_flashlog_ring.c against a file-backed NOR flash model
+ * (program can only clear bits, erase sets a 4KB sector to 0xFF) and
+ * reports throughput, wear, mount time and recovery after power cuts.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/flashlog_sim.c src/sys_flashlog_ring.c -o flashlog_sim
+ *   ./flashlog_sim [flash.bin]
+ *
+ * Timings use typical ESP32-S3 / 25Q-series figures (page program 0.7ms per
+ * 256B, sector erase 45ms, reads 40MB/s + 15us per call), so the numbers
+ * are estimates of on-target cost, not host speed.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sys_flashlog.h"
+
+#define SIM_PART_SIZE       0x20000     // Matches "tlmlog" in partitions.csv (128 KB)
+#define SIM_RECORD_MAX      (500 + FLOG_RECORD_HDR_BYTES)   // make_record() worst case
+// Unacked records the ring holds without dropping (open + partly drained sector spare)
+#define SIM_RING_RECORDS    ((SIM_PART_SIZE / FLOG_SECTOR_SIZE - 2) * \
+                             ((FLOG_SECTOR_SIZE - FLOG_SECTOR_HDR_BYTES) / SIM_RECORD_MAX))
+#define SIM_READ_CALL_US    15.0
+#define SIM_READ_BYTE_US    0.025
+#define SIM_PROG_PAGE_US    700.0
+#define SIM_ERASE_US        45000.0
+
+typedef struct {
+    FILE *f;
+    double busy_us;             // Modelled flash time
+    long cut_after_bytes;       // Power cut: stop programming after N bytes (-1 = off)
+    uint32_t *erase_count;      // Per sector
+} sim_flash_t;
+
+static uint32_t erase_count[SIM_PART_SIZE / FLOG_SECTOR_SIZE];
+
+// --- FLASH MODEL ---
+
+static bool sim_read(void *ctx, uint32_t addr, void *buf, size_t len) {
+    sim_flash_t *s = ctx;
+    s->busy_us += SIM_READ_CALL_US + SIM_READ_BYTE_US * len;
+    fseek(s->f, addr, SEEK_SET);
+    return fread(buf, 1, len, s->f) == len;
+}
+
+static bool sim_write(void *ctx, uint32_t addr, const void *buf, size_t len) {
+    sim_flash_t *s = ctx;
+    uint8_t cur[FLOG_MAX_RECORD + 16];
+    const uint8_t *in = buf;
+
+    if (s->cut_after_bytes == 0) return false;
+    size_t n = len;
+    if (s->cut_after_bytes > 0 && (long)n > s->cut_after_bytes) n = (size_t)s->cut_after_bytes;
+
+    fseek(s->f, addr, SEEK_SET);
+    if (fread(cur, 1, n, s->f) != n) return false;
+    for (size_t i = 0; i < n; i++) cur[i] &= in[i];     // NOR: 1 -> 0 only
+    fseek(s->f, addr, SEEK_SET);
+    fwrite(cur, 1, n, s->f);
+
+    s->busy_us += SIM_PROG_PAGE_US * ((len + 255) / 256);
+    if (s->cut_after_bytes > 0) {
+        s->cut_after_bytes -= (long)n;
+        if (s->cut_after_bytes == 0) return false;
+    }
+    return n == len;
+}
+
+static bool sim_erase(void *ctx, uint32_t addr, size_t len) {
+    sim_flash_t *s = ctx;
+    static uint8_t ff[FLOG_SECTOR_SIZE];
+    (void)len;                              // Always one whole sector
+    if (s->cut_after_bytes == 0) return false;
+    memset(ff, 0xFF, sizeof(ff));
+    fseek(s->f, addr, SEEK_SET);
+    fwrite(ff, 1, FLOG_SECTOR_SIZE, s->f);
+    s->busy_us += SIM_ERASE_US;
+    s->erase_count[addr / FLOG_SECTOR_SIZE]++;
+    return true;
+}
+
+// --- HELPERS ---
+
+/**
+ * @brief Telemetry-like record: sequence number + filler of realistic size
+ */
+static size_t make_record(uint8_t *buf, uint32_t seq) {
+    size_t len = 380 + (seq * 37) % 120;    // 10Hz batches are 380-500 bytes
+    memcpy(buf, &seq, 4);
+    for (size_t i = 4; i < len; i++) buf[i] = (uint8_t)(seq * 31 + i);
+    return len;
+}
+
+static bool check_record(const uint8_t *buf, size_t len, uint32_t *seq) {
+    memcpy(seq, buf, 4);
+    if (len != 380 + (*seq * 37) % 120) return false;
+    for (size_t i = 4; i < len; i++) {
+        if (buf[i] != (uint8_t)(*seq * 31 + i)) return false;
+    }
+    return true;
+}
+
+static flog_flash_t io_for(sim_flash_t *s) {
+    flog_flash_t io = { sim_read, sim_write, sim_erase, s, SIM_PART_SIZE };
+    return io;
+}
+
+static void wipe(sim_flash_t *s) {
+    static uint8_t junk[SIM_PART_SIZE];
+    for (size_t i = 0; i < sizeof(junk); i++) junk[i] = (uint8_t)rand();     // Fresh partition with garbage
+    fseek(s->f, 0, SEEK_SET);
+    fwrite(junk, 1, sizeof(junk), s->f);
+    memset(erase_count, 0, sizeof(erase_count));
+}
+
+// --- SCENARIOS ---
+
+static void bench_throughput(sim_flash_t *s) {
+    flog_t log;
+    uint8_t buf[FLOG_MAX_RECORD];
+    flog_flash_t io = io_for(s);
+
+    wipe(s);
+    flog_mount(&log, &io);
+    s->busy_us = 0;
+
+    uint32_t n = 2000, bytes = 0;
+    for (uint32_t i = 0; i < n; i++) {
+        size_t len = make_record(buf, i);
+        flog_append(&log, buf, len);
+        bytes += len;
+    }
+    double t = s->busy_us / 1e6;
+    printf("[throughput] %u records, %u KB: %.2f s flash time -> %.0f records/s, %.1f KB/s sustained\n",
+           n, bytes / 1024, t, n / t, bytes / 1024.0 / t);
+    printf("             10Hz telemetry needs ~0.4 records/s (161 B/s): %.2f%% flash duty\n",
+           100.0 * 161.0 / (bytes / t));
+}
+
+static void bench_outage(sim_flash_t *s, double outage_s) {
+    flog_t log;
+    uint8_t buf[FLOG_MAX_RECORD];
+    flog_flash_t io = io_for(s);
+
+    wipe(s);
+    flog_mount(&log, &io);
+
+    // 10Hz telemetry: one ~440B batch every 2.75s
+    uint32_t produced = (uint32_t)(outage_s / 2.75);
+    for (uint32_t i = 0; i < produced; i++) {
+        size_t len = make_record(buf, i);
+        flog_append(&log, buf, len);
+    }
+
+    // Link back: drain one record per FLOG_DRAIN_INTERVAL_MS, producer continues
+    double t = 0, next_prod = 2.75;
+    uint32_t seq = produced, expect = log.stats.dropped, bad = 0;
+    s->busy_us = 0;
+    while (log.pending > 0) {
+        size_t len = flog_peek(&log, buf, sizeof(buf));
+        if (len == 0) break;
+        uint32_t got;
+        if (!check_record(buf, len, &got) || got != expect) bad++;
+        expect = got + 1;
+        flog_consume(&log);
+
+        t += FLOG_DRAIN_INTERVAL_MS / 1000.0;
+        if (t >= next_prod) {
+            len = make_record(buf, seq++);
+            flog_append(&log, buf, len);
+            next_prod += 2.75;
+        }
+    }
+    printf("[outage %4.0f min] stored %u, dropped %u (ring full), drained in %.0f s, order errors %u, flash busy %.1f s\n",
+           outage_s / 60, produced, log.stats.dropped, t, bad, s->busy_us / 1e6);
+}
+
+static void bench_mount(sim_flash_t *s) {
+    flog_t log;
+    uint8_t buf[FLOG_MAX_RECORD];
+    flog_flash_t io = io_for(s);
+
+    wipe(s);
+    flog_mount(&log, &io);
+    for (uint32_t i = 0; log.stats.dropped == 0; i++) {
+        flog_append(&log, buf, make_record(buf, i));
+    }
+
+    s->busy_us = 0;
+    flog_mount(&log, &io);
+    printf("[mount] full partition: %u pending, %u reads, ~%.1f ms\n",
+           log.pending, log.stats.reads, s->busy_us / 1000.0);
+}
+
+static void bench_power_cut(sim_flash_t *s, int trials) {
+    uint8_t buf[FLOG_MAX_RECORD];
+    flog_flash_t io = io_for(s);
+    int lost_total = 0, dup_total = 0, bad_total = 0, fail = 0, full_total = 0;
+    double mount_max_ms = 0;
+
+    for (int trial = 0; trial < trials; trial++) {
+        flog_t log;
+        wipe(s);
+        s->cut_after_bytes = -1;
+        flog_mount(&log, &io);
+
+        // Random history: appends with partial draining, backlog within ring capacity
+        // (ring-full drops are by design, bench_outage() covers them)
+        uint32_t seq = 0, acked = 0;
+        int steps = 200 + rand() % 800;
+        for (int k = 0; k < steps; k++) {
+            if (rand() % 3 && seq - acked < SIM_RING_RECORDS) {
+                flog_append(&log, buf, make_record(buf, seq++));
+            } else if (flog_peek(&log, buf, sizeof(buf)) > 0) {
+                flog_consume(&log);
+                acked++;
+            }
+        }
+
+        full_total += (int)log.stats.dropped;
+
+        // Power cut in the middle of the next append (header, payload or sector open)
+        s->cut_after_bytes = rand() % 520;
+        flog_append(&log, buf, make_record(buf, seq));
+        s->cut_after_bytes = -1;
+
+        // Reboot
+        s->busy_us = 0;
+        if (!flog_mount(&log, &io)) { fail++; continue; }
+        if (s->busy_us / 1000.0 > mount_max_ms) mount_max_ms = s->busy_us / 1000.0;
+
+        // Everything not acked (except the torn record) must come back once, in order
+        uint32_t expect = acked, got;
+        size_t len;
+        int lost = 0, dup = 0, bad = 0;
+        while ((len = flog_peek(&log, buf, sizeof(buf))) > 0) {
+            if (!check_record(buf, len, &got)) { bad++; flog_consume(&log); continue; }
+            if (got < expect) dup++;
+            else if (got > expect) lost += (int)(got - expect);
+            expect = got + 1;
+            flog_consume(&log);
+        }
+        if (expect < seq) lost += (int)(seq - expect);
+        lost_total += lost;
+        dup_total += dup;
+        bad_total += bad;
+
+        // Log must stay writable after recovery
+        if (!flog_append(&log, buf, make_record(buf, 1))) fail++;
+    }
+    printf("[power cut] %d trials (backlog <= %d records): lost %d, duplicated %d, corrupt delivered %d, unusable %d,"
+           " ring full %d, mount max %.1f ms\n",
+           trials, SIM_RING_RECORDS, lost_total, dup_total, bad_total, fail, full_total, mount_max_ms);
+}
+
+static void bench_wear(sim_flash_t *s, double hours) {
+    flog_t log;
+    uint8_t buf[FLOG_MAX_RECORD];
+    flog_flash_t io = io_for(s);
+
+    wipe(s);
+    flog_mount(&log, &io);
+    memset(erase_count, 0, sizeof(erase_count));
+
+    // Continuous outage logging at 10Hz telemetry, draining never happens
+    uint32_t n = (uint32_t)(hours * 3600 / 2.75);
+    for (uint32_t i = 0; i < n; i++) flog_append(&log, buf, make_record(buf, i));
+
+    uint32_t lo = UINT32_MAX, hi = 0;
+    for (size_t i = 0; i < SIM_PART_SIZE / FLOG_SECTOR_SIZE; i++) {
+        if (erase_count[i] < lo) lo = erase_count[i];
+        if (erase_count[i] > hi) hi = erase_count[i];
+    }
+    double per_hour = hi / hours;
+    printf("[wear] %.0f h offline @10Hz: erases per sector %u..%u (%.2f/h) -> 100k cycles last %.0f h of logging\n",
+           hours, lo, hi, per_hour, 100000.0 / per_hour);
+}
+
+int main(int argc, char **argv) {
+    const char *path = (argc > 1) ? argv[1] : "flashlog_sim.bin";
+    sim_flash_t s = { .f = fopen(path, "w+b"), .cut_after_bytes = -1, .erase_count = erase_count };
+    if (s.f == NULL) {
+        perror(path);
+        return 1;
+    }
+    srand(1);
+
+    bench_throughput(&s);
+    bench_outage(&s, 60);
+    bench_outage(&s, 30 * 60);
+    bench_outage(&s, 3 * 3600);
+    bench_mount(&s);
+    bench_power_cut(&s, 500);
+    bench_wear(&s, 100);
+
+    fclose(s.f);
+    return 0;
+}
@@ -0,0 +1,566 @@
+/**
+ * @file gps_parser_sim.c
+ * @brief Host test of the streaming GPS parser on a canned NMEA stream
+ * @details
+ * Feeds src/drv_gps_parser.c a recorded NMEA stream in the NEO-M8N
+ * fallback output order (GGA, GSA, GSV, RMC, VTG, GLL per 1 Hz epoch,
+ * 6 epochs) and compares every published fix field by field against the
+ * expected solution (lat/lon e7, UTC time and date, height, satellites,
+ * speed, course). Checks:
+ * - whole stream, random chunk splits and byte-by-byte feeding decode the
+ *   same fixes (sentences and checksums split across reads), stamped with
+ *   the time of the RMC's last byte;
+ * - corrupted RMC: checksum error counted, that epoch is not published;
+ * - corrupted GGA: the RMC is still published, GGA-only fields keep the
+ *   previous verified epoch (never the corrupted values);
+ * - truncated sentence cut by the next '$': dropped, and that '$' starts
+ *   the following sentence;
+ * - non-hex checksum digit: counted as a checksum error;
+ * - binary line noise between sentences and missing CR/LF: no lost fixes;
+ * - RMC status V with empty position: published as no fix;
+ * - southern / western hemisphere signs;
+ * - false UBX syncs: 0xB5 0x62 right before '$', a header with a 64 KB
+ *   length and lone 0xB5 bytes cost no NMEA sentence; NAV-PVT frames
+ *   interleaved with NMEA are both decoded.
+ * Then reports parser throughput on a 10 Hz NAV-PVT + 1 Hz NMEA log fed
+ * in GPS_READ_CHUNK reads, and the cost of one NAV-PVT frame / NMEA epoch
+ * (the latency from the frame's last byte to the fix callback).
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/gps_parser_sim.c src/drv_gps_parser.c -o gps_parser_sim
+ *   ./gps_parser_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "drv_gps.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define EPOCH_LINES     10          // Sentences per epoch in CANNED
+#define IDX_GGA         0
+#define IDX_RMC         7
+#define MAX_FIXES       32
+#define STREAM_MAX      16384
+#define BENCH_SECONDS   60          // Length of the benchmark log
+#define BENCH_PASSES    50
+#define BENCH_FRAMES    20000
+
+/**
+ * @brief Expected solution of one epoch
+ */
+typedef struct {
+    int32_t lat_e7, lon_e7;
+    uint8_t hour, min, sec;
+    int32_t height_mm;
+    uint8_t num_sv;
+    int32_t speed_mm_s;
+    int32_t course_e5;
+} sim_epoch_t;
+
+// Recorded stream (UTC 2026-10-18 11:22:33, ~3.5 kn heading ~48 deg)
+static const char *const CANNED[] = {
+    "$GNGGA,112233.00,4723.86452,N,00832.73564,E,1,09,0.92,408.3,M,47.4,M,,*4D\r\n",
+    "$GNGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.61,0.92,1.32*16\r\n",
+    "$GNGSA,A,3,66,67,76,,,,,,,,,,1.61,0.92,1.32*11\r\n",
+    "$GPGSV,3,1,11,02,32,054,38,05,61,283,41,12,23,311,36,13,47,082,40*77\r\n",
+    "$GPGSV,3,2,11,15,55,143,44,18,14,248,31,25,08,195,27,29,31,108,39*77\r\n",
+    "$GPGSV,3,3,11,20,05,040,,24,02,321,,31,01,150,*49\r\n",
+    "$GLGSV,1,1,03,66,38,061,35,67,71,310,40,76,22,287,33*51\r\n",
+    "$GNRMC,112233.00,A,4723.86452,N,00832.73564,E,3.514,47.25,181026,,,A*4E\r\n",
+    "$GNVTG,47.25,T,,M,3.514,N,6.508,K,A*1F\r\n",
+    "$GNGLL,4723.86452,N,00832.73564,E,112233.00,A,A*72\r\n",
+    "$GNGGA,112234.00,4723.86633,N,00832.73830,E,1,10,0.92,408.4,M,47.4,M,,*4C\r\n",
+    "$GNGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.61,0.92,1.32*16\r\n",
+    "$GNGSA,A,3,66,67,76,,,,,,,,,,1.61,0.92,1.32*11\r\n",
+    "$GPGSV,3,1,11,02,32,054,38,05,61,283,41,12,23,311,36,13,47,082,40*77\r\n",
+    "$GPGSV,3,2,11,15,55,143,44,18,14,248,31,25,08,195,27,29,31,108,39*77\r\n",
+    "$GPGSV,3,3,11,20,05,040,,24,02,321,,31,01,150,*49\r\n",
+    "$GLGSV,1,1,03,66,38,061,35,67,71,310,40,76,22,287,33*51\r\n",
+    "$GNRMC,112234.00,A,4723.86633,N,00832.73830,E,3.524,47.75,181026,,,A*46\r\n",
+    "$GNVTG,47.75,T,,M,3.524,N,6.526,K,A*15\r\n",
+    "$GNGLL,4723.86633,N,00832.73830,E,112234.00,A,A*7C\r\n",
+    "$GNGGA,112235.00,4723.86813,N,00832.74096,E,1,11,0.92,408.5,M,47.4,M,,*42\r\n",
+    "$GNGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.61,0.92,1.32*16\r\n",
+    "$GNGSA,A,3,66,67,76,,,,,,,,,,1.61,0.92,1.32*11\r\n",
+    "$GPGSV,3,1,11,02,32,054,38,05,61,283,41,12,23,311,36,13,47,082,40*77\r\n",
+    "$GPGSV,3,2,11,15,55,143,44,18,14,248,31,25,08,195,27,29,31,108,39*77\r\n",
+    "$GPGSV,3,3,11,20,05,040,,24,02,321,,31,01,150,*49\r\n",
+    "$GLGSV,1,1,03,66,38,061,35,67,71,310,40,76,22,287,33*51\r\n",
+    "$GNRMC,112235.00,A,4723.86813,N,00832.74096,E,3.534,48.25,181026,,,A*43\r\n",
+    "$GNVTG,48.25,T,,M,3.534,N,6.545,K,A*1B\r\n",
+    "$GNGLL,4723.86813,N,00832.74096,E,112235.00,A,A*72\r\n",
+    "$GNGGA,112236.00,4723.86994,N,00832.74361,E,1,09,0.92,408.6,M,47.4,M,,*4E\r\n",
+    "$GNGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.61,0.92,1.32*16\r\n",
+    "$GNGSA,A,3,66,67,76,,,,,,,,,,1.61,0.92,1.32*11\r\n",
+    "$GPGSV,3,1,11,02,32,054,38,05,61,283,41,12,23,311,36,13,47,082,40*77\r\n",
+    "$GPGSV,3,2,11,15,55,143,44,18,14,248,31,25,08,195,27,29,31,108,39*77\r\n",
+    "$GPGSV,3,3,11,20,05,040,,24,02,321,,31,01,150,*49\r\n",
+    "$GLGSV,1,1,03,66,38,061,35,67,71,310,40,76,22,287,33*51\r\n",
+    "$GNRMC,112236.00,A,4723.86994,N,00832.74361,E,3.544,48.75,181026,,,A*47\r\n",
+    "$GNVTG,48.75,T,,M,3.544,N,6.563,K,A*1D\r\n",
+    "$GNGLL,4723.86994,N,00832.74361,E,112236.00,A,A*74\r\n",
+    "$GNGGA,112237.00,4723.87174,N,00832.74627,E,1,10,0.92,408.7,M,47.4,M,,*46\r\n",
+    "$GNGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.61,0.92,1.32*16\r\n",
+    "$GNGSA,A,3,66,67,76,,,,,,,,,,1.61,0.92,1.32*11\r\n",
+    "$GPGSV,3,1,11,02,32,054,38,05,61,283,41,12,23,311,36,13,47,082,40*77\r\n",
+    "$GPGSV,3,2,11,15,55,143,44,18,14,248,31,25,08,195,27,29,31,108,39*77\r\n",
+    "$GPGSV,3,3,11,20,05,040,,24,02,321,,31,01,150,*49\r\n",
+    "$GLGSV,1,1,03,66,38,061,35,67,71,310,40,76,22,287,33*51\r\n",
+    "$GNRMC,112237.00,A,4723.87174,N,00832.74627,E,3.554,49.25,181026,,,A*43\r\n",
+    "$GNVTG,49.25,T,,M,3.554,N,6.582,K,A*17\r\n",
+    "$GNGLL,4723.87174,N,00832.74627,E,112237.00,A,A*75\r\n",
+    "$GNGGA,112238.00,4723.87355,N,00832.74893,E,1,11,0.92,408.8,M,47.4,M,,*47\r\n",
+    "$GNGSA,A,3,02,05,12,13,15,18,25,29,,,,,1.61,0.92,1.32*16\r\n",
+    "$GNGSA,A,3,66,67,76,,,,,,,,,,1.61,0.92,1.32*11\r\n",
+    "$GPGSV,3,1,11,02,32,054,38,05,61,283,41,12,23,311,36,13,47,082,40*77\r\n",
+    "$GPGSV,3,2,11,15,55,143,44,18,14,248,31,25,08,195,27,29,31,108,39*77\r\n",
+    "$GPGSV,3,3,11,20,05,040,,24,02,321,,31,01,150,*49\r\n",
+    "$GLGSV,1,1,03,66,38,061,35,67,71,310,40,76,22,287,33*51\r\n",
+    "$GNRMC,112238.00,A,4723.87355,N,00832.74893,E,3.564,49.75,181026,,,A*4A\r\n",
+    "$GNVTG,49.75,T,,M,3.564,N,6.601,K,A*19\r\n",
+    "$GNGLL,4723.87355,N,00832.74893,E,112238.00,A,A*7A\r\n",
+};
+static const sim_epoch_t EXPECT[] = {
+    { 473977420, 85455940, 11, 22, 33, 408300, 9, 1807, 4725000 },
+    { 473977721, 85456383, 11, 22, 34, 408400, 10, 1812, 4775000 },
+    { 473978021, 85456826, 11, 22, 35, 408500, 11, 1818, 4825000 },
+    { 473978323, 85457268, 11, 22, 36, 408600, 9, 1823, 4875000 },
+    { 473978623, 85457711, 11, 22, 37, 408700, 10, 1828, 4925000 },
+    { 473978925, 85458155, 11, 22, 38, 408800, 11, 1833, 4975000 },
+};
+
+#define EPOCHS          (int)(sizeof(EXPECT) / sizeof(EXPECT[0]))
+#define LINES           (EPOCHS * EPOCH_LINES)
+
+static gps_fix_t fixes[MAX_FIXES];
+static int fix_count = 0;
+static uint8_t stream[STREAM_MAX];
+static size_t rmc_end[EPOCHS];      // Offset of the last byte of each RMC
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// --- HELPERS ---
+
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) % n;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void on_fix(const gps_fix_t *fix, void *ctx) {
+    (void)ctx;
+    if (fix_count < MAX_FIXES) fixes[fix_count] = *fix;
+    fix_count++;
+}
+
+/**
+ * @brief Append "$<body>*XX\r\n" with a valid checksum
+ */
+static size_t nmea_make(const char *body, uint8_t *out) {
+    uint8_t ck = 0;
+    for (const char *c = body; *c; c++) ck ^= (uint8_t)*c;
+    return (size_t)sprintf((char *)out, "$%s*%02X\r\n", body, ck);
+}
+
+/**
+ * @brief Assemble the canned stream
+ * @param replace_idx Sentence to replace (-1 = none)
+ * @param replacement Replacement text
+ * @param noise       Insert binary noise between sentences
+ * @param strip_crlf  Drop the CR/LF terminators
+ */
+static size_t build(int replace_idx, const char *replacement, bool noise, bool strip_crlf) {
+    size_t n = 0;
+    for (int i = 0; i < LINES; i++) {
+        const char *s = (i == replace_idx) ? replacement : CANNED[i];
+        size_t l = strlen(s);
+        if (strip_crlf && l >= 2 && s[l - 2] == '\r') l -= 2;
+        memcpy(&stream[n], s, l);
+        n += l;
+        if (i % EPOCH_LINES == IDX_RMC) {
+            rmc_end[i / EPOCH_LINES] = n - (strip_crlf ? 1 : 3);
+        }
+
+        if (noise) {
+            // No '$' and no UBX sync byte: anything else a noisy line may carry
+            uint32_t k = rnd(8);
+            for (uint32_t j = 0; j < k; j++) {
+                uint8_t b = (uint8_t)rnd(256);
+                stream[n++] = (b == '$' || b == UBX_SYNC1) ? 0x00 : b;
+            }
+        }
+    }
+    return n;
+}
+
+/**
+ * @brief Canned stream with @p ins inserted before sentences of one slot (-1 = every sentence)
+ */
+static size_t build_with(const uint8_t *ins, size_t ins_len, int slot) {
+    size_t n = 0;
+    for (int i = 0; i < LINES; i++) {
+        if (slot < 0 || i % EPOCH_LINES == slot) {
+            memcpy(&stream[n], ins, ins_len);
+            n += ins_len;
+        }
+        size_t l = strlen(CANNED[i]);
+        memcpy(&stream[n], CANNED[i], l);
+        n += l;
+    }
+    return n;
+}
+
+static void wr_u32(uint8_t *p, uint32_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+    p[2] = (uint8_t)(v >> 16);
+    p[3] = (uint8_t)(v >> 24);
+}
+
+/**
+ * @brief NAV-PVT frame for an epoch (3D fix, date/time valid)
+ */
+static size_t nav_pvt_frame(const sim_epoch_t *e, uint32_t itow_ms, uint8_t *out, size_t out_size) {
+    uint8_t pl[UBX_NAV_PVT_LEN];
+    memset(pl, 0, sizeof(pl));
+    wr_u32(&pl[0], itow_ms);
+    pl[4] = (uint8_t)(2026 & 0xFF);
+    pl[5] = (uint8_t)(2026 >> 8);
+    pl[6] = 10;
+    pl[7] = 18;
+    pl[8] = e->hour;
+    pl[9] = e->min;
+    pl[10] = e->sec;
+    pl[11] = 0x07;
+    pl[20] = 3;
+    pl[21] = 0x01;
+    pl[23] = e->num_sv;
+    wr_u32(&pl[24], (uint32_t)e->lon_e7);
+    wr_u32(&pl[28], (uint32_t)e->lat_e7);
+    wr_u32(&pl[36], (uint32_t)e->height_mm);
+    wr_u32(&pl[60], (uint32_t)e->speed_mm_s);
+    wr_u32(&pl[64], (uint32_t)e->course_e5);
+    return gps_ubx_build(UBX_CLASS_NAV, UBX_NAV_PVT, pl, sizeof(pl), out, out_size);
+}
+
+/**
+ * @brief Feed in chunks of 1..max_chunk bytes (0 = whole buffer), stamped with the chunk's last offset
+ */
+static gps_parser_stats_t run(const uint8_t *data, size_t len, uint32_t max_chunk) {
+    static gps_parser_t p;
+    gps_parser_init(&p, on_fix, NULL);
+    fix_count = 0;
+
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n = max_chunk ? 1 + rnd(max_chunk) : len;
+        if (n > len - pos) n = len - pos;
+        gps_parser_feed(&p, &data[pos], n, (int64_t)(pos + n - 1));
+        pos += n;
+    }
+    return p.stats;
+}
+
+/**
+ * @brief Compare a fix with an epoch (GGA-only fields taken from @p gga)
+ */
+static bool fix_matches(const gps_fix_t *f, const sim_epoch_t *e, const sim_epoch_t *gga) {
+    return f->lat_e7 == e->lat_e7 && f->lon_e7 == e->lon_e7 &&
+           f->hour == e->hour && f->min == e->min && f->sec == e->sec && f->nano == 0 &&
+           f->year == 2026 && f->month == 10 && f->day == 18 && f->time_valid &&
+           f->ground_speed_mm_s == e->speed_mm_s && f->course_e5 == e->course_e5 &&
+           f->height_msl_mm == gga->height_mm && f->num_sv == gga->num_sv &&
+           f->fix_type == GPS_FIX_3D && !f->from_ubx;
+}
+
+static bool all_epochs_match(void) {
+    if (fix_count != EPOCHS) return false;
+    for (int i = 0; i < EPOCHS; i++) {
+        if (!fix_matches(&fixes[i], &EXPECT[i], &EXPECT[i])) return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Copy of a canned sentence with one character changed
+ */
+static const char *corrupt(int idx, size_t at, char c) {
+    static char line[128];
+    strncpy(line, CANNED[idx], sizeof(line) - 1);
+    line[at] = c;
+    return line;
+}
+
+// --- SCENARIOS ---
+
+static void test_whole_stream(void) {
+    printf("\nWhole stream\n");
+    size_t len = build(-1, NULL, false, false);
+    gps_parser_stats_t st = run(stream, len, 0);
+
+    char what[96];
+    snprintf(what, sizeof(what), "%d fixes, all fields match the recording", EPOCHS);
+    check(what, all_epochs_match());
+    check("no checksum errors, GGA + RMC verified per epoch",
+          st.checksum_errors == 0 && st.nmea_sentences == 2u * EPOCHS && st.fixes == (uint32_t)EPOCHS);
+    check("byte count", st.bytes == len);
+}
+
+static void test_split(void) {
+    printf("\nSplit reads\n");
+    size_t len = build(-1, NULL, false, false);
+
+    bool ok = true;
+    for (int trial = 0; trial < 200 && ok; trial++) {
+        gps_parser_stats_t st = run(stream, len, 1 + rnd(64));
+        ok = all_epochs_match() && st.checksum_errors == 0;
+    }
+    check("200 random chunkings (1..64 bytes) decode identically", ok);
+
+    run(stream, len, 1);
+    ok = all_epochs_match();
+    for (int i = 0; i < EPOCHS && ok; i++) {
+        ok = fixes[i].rx_time_us == (int64_t)rmc_end[i];
+    }
+    check("byte-by-byte: identical, stamped at the RMC's last byte", ok);
+}
+
+static void test_corrupted(void) {
+    printf("\nCorrupted sentences\n");
+
+    // Latitude digit of epoch 2's RMC flipped: checksum must catch it
+    int idx = 2 * EPOCH_LINES + IDX_RMC;
+    size_t len = build(idx, corrupt(idx, 22, '9'), false, false);
+    gps_parser_stats_t st = run(stream, len, 1 + rnd(32));
+    bool ok = st.checksum_errors == 1 && fix_count == EPOCHS - 1;
+    for (int i = 0, e = 0; ok && i < fix_count; i++, e++) {
+        if (e == 2) e++;
+        ok = fix_matches(&fixes[i], &EXPECT[e], &EXPECT[e]);
+    }
+    check("corrupted RMC: 1 checksum error, epoch dropped", ok);
+
+    // Satellite count of epoch 3's GGA altered: RMC still closes the epoch
+    idx = 3 * EPOCH_LINES + IDX_GGA;
+    len = build(idx, corrupt(idx, 47, '7'), false, false);
+    st = run(stream, len, 1 + rnd(32));
+    ok = st.checksum_errors == 1 && all_epochs_match() == false && fix_count == EPOCHS &&
+         fix_matches(&fixes[3], &EXPECT[3], &EXPECT[2]);
+    check("corrupted GGA: RMC published with previous GGA fields", ok);
+
+    // Checksum digit that is not hex
+    idx = 1 * EPOCH_LINES + IDX_RMC;
+    char bad[128];
+    strncpy(bad, CANNED[idx], sizeof(bad) - 1);
+    bad[sizeof(bad) - 1] = '\0';
+    char *star = strchr(bad, '*');
+    star[2] = 'G';
+    len = build(idx, bad, false, false);
+    st = run(stream, len, 1 + rnd(32));
+    check("non-hex checksum digit: rejected as checksum error",
+          st.checksum_errors == 1 && fix_count == EPOCHS - 1 && fixes[1].sec == EXPECT[2].sec);
+
+    // Epoch 4's RMC cut mid-field (receiver reset / UART overrun)
+    idx = 4 * EPOCH_LINES + IDX_RMC;
+    char cut[128];
+    snprintf(cut, sizeof(cut), "%.40s", CANNED[idx]);
+    len = build(idx, cut, false, false);
+    st = run(stream, len, 1 + rnd(32));
+    check("truncated RMC: dropped silently, next epochs intact",
+          st.checksum_errors == 0 && fix_count == EPOCHS - 1 &&
+          fix_matches(&fixes[4], &EXPECT[5], &EXPECT[5]));
+
+    // Epoch 3's GLL replaced by a cut GGA right before epoch 4's GGA: the '$' must start the GGA
+    idx = 3 * EPOCH_LINES + EPOCH_LINES - 1;
+    snprintf(cut, sizeof(cut), "%.30s", CANNED[3 * EPOCH_LINES + IDX_GGA]);
+    len = build(idx, cut, false, false);
+    st = run(stream, len, 1 + rnd(32));
+    check("truncated sentence: following '$' starts the next one",
+          st.checksum_errors == 0 && all_epochs_match());
+}
+
+static void test_noise(void) {
+    printf("\nLine noise\n");
+
+    bool ok = true;
+    for (int trial = 0; trial < 50 && ok; trial++) {
+        size_t len = build(-1, NULL, true, false);
+        run(stream, len, 1 + rnd(64));
+        ok = all_epochs_match();
+    }
+    check("binary noise between sentences: all epochs decoded", ok);
+
+    size_t len = build(-1, NULL, false, true);
+    gps_parser_stats_t st = run(stream, len, 1 + rnd(32));
+    check("no CR/LF between sentences: all epochs decoded", all_epochs_match() && st.checksum_errors == 0);
+}
+
+static void test_no_fix_and_hemispheres(void) {
+    printf("\nNo fix / hemispheres\n");
+    size_t n = 0;
+    n += nmea_make("GNGGA,010203.00,3351.12345,S,15112.34567,W,1,08,1.10,12.5,M,21.0,M,,", &stream[n]);
+    n += nmea_make("GNRMC,010203.00,A,3351.12345,S,15112.34567,W,0.000,,181026,,,A,V", &stream[n]);
+    n += nmea_make("GNGGA,010204.00,,,,,0,00,99.99,,,,,,", &stream[n]);
+    n += nmea_make("GNRMC,010204.00,V,,,,,,,181026,,,N,V", &stream[n]);
+
+    run(stream, n, 1 + rnd(16));
+    check("two fixes published", fix_count == 2);
+    if (fix_count != 2) return;
+
+    check("S/W: lat -33.8520575, lon -151.2057611",
+          fixes[0].lat_e7 == -338520575 && fixes[0].lon_e7 == -1512057611 &&
+          fixes[0].fix_type == GPS_FIX_3D && fixes[0].num_sv == 8 && fixes[0].height_msl_mm == 12500);
+    check("status V: published as no fix, time still valid",
+          fixes[1].fix_type == GPS_FIX_NONE && fixes[1].num_sv == 0 &&
+          fixes[1].sec == 4 && fixes[1].time_valid);
+}
+
+static void test_false_sync(void) {
+    printf("\nFalse UBX sync\n");
+
+    // 0xB5 0x62 glued to the '$': "$GNG" read as class/id/length 0x474E
+    static const uint8_t sync[] = { UBX_SYNC1, UBX_SYNC2 };
+    size_t len = build_with(sync, sizeof(sync), IDX_GGA);
+    gps_parser_stats_t st = run(stream, len, 1 + rnd(32));
+    check("0xB5 0x62 before each GGA: all epochs decoded",
+          all_epochs_match() && st.ubx_resyncs == (uint32_t)EPOCHS);
+
+    // Complete header with a 64 KB length (would swallow the rest of the log)
+    static const uint8_t hdr[] = { UBX_SYNC1, UBX_SYNC2, UBX_CLASS_NAV, UBX_NAV_PVT, 0xFF, 0xFF };
+    len = build_with(hdr, sizeof(hdr), IDX_RMC);
+    st = run(stream, len, 1 + rnd(32));
+    check("64 KB length before each RMC: rejected, all epochs decoded",
+          all_epochs_match() && st.ubx_resyncs == (uint32_t)EPOCHS && st.checksum_errors == 0);
+
+    static const uint8_t lone[] = { UBX_SYNC1 };
+    len = build_with(lone, sizeof(lone), -1);
+    run(stream, len, 1 + rnd(32));
+    check("lone 0xB5 before every sentence: all epochs decoded", all_epochs_match());
+
+    // NAV-PVT after each NMEA epoch (receiver switching to UBX mid-stream)
+    size_t n = 0;
+    for (int e = 0; e < EPOCHS; e++) {
+        for (int i = 0; i < EPOCH_LINES; i++) {
+            size_t l = strlen(CANNED[e * EPOCH_LINES + i]);
+            memcpy(&stream[n], CANNED[e * EPOCH_LINES + i], l);
+            n += l;
+        }
+        n += nav_pvt_frame(&EXPECT[e], 1000u * (uint32_t)e, &stream[n], STREAM_MAX - n);
+    }
+    st = run(stream, n, 1 + rnd(32));
+    bool ok = fix_count == 2 * EPOCHS && st.ubx_frames == (uint32_t)EPOCHS;
+    for (int e = 0; ok && e < EPOCHS; e++) {
+        const gps_fix_t *u = &fixes[2 * e + 1];
+        ok = fix_matches(&fixes[2 * e], &EXPECT[e], &EXPECT[e]) &&
+             u->from_ubx && u->lat_e7 == EXPECT[e].lat_e7 && u->lon_e7 == EXPECT[e].lon_e7 &&
+             u->itow_ms == 1000u * (uint32_t)e && u->fix_type == GPS_FIX_3D && u->time_valid;
+    }
+    check("NAV-PVT interleaved with NMEA: both decoded", ok);
+}
+
+static void bench(void) {
+    // 10 Hz NAV-PVT plus the canned NMEA epochs at 1 Hz (worst case: receiver
+    // left NMEA on after switching to UBX)
+    static uint8_t log_buf[BENCH_SECONDS * (10 * (UBX_NAV_PVT_LEN + 8) + 1024)];
+    size_t n = 0;
+    int expect_fixes = 0;
+    for (int sec = 0; sec < BENCH_SECONDS; sec++) {
+        const int e = sec % EPOCHS;
+        for (int k = 0; k < 10; k++) {
+            n += nav_pvt_frame(&EXPECT[e], 1000u * (uint32_t)sec + 100u * (uint32_t)k,
+                               &log_buf[n], sizeof(log_buf) - n);
+        }
+        for (int i = 0; i < EPOCH_LINES; i++) {
+            size_t l = strlen(CANNED[e * EPOCH_LINES + i]);
+            memcpy(&log_buf[n], CANNED[e * EPOCH_LINES + i], l);
+            n += l;
+        }
+        expect_fixes += 11;
+    }
+
+    static gps_parser_t p;
+    double t0 = now_ns();
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        gps_parser_init(&p, on_fix, NULL);
+        fix_count = 0;
+        for (size_t pos = 0; pos < n; pos += GPS_READ_CHUNK) {
+            size_t l = (n - pos < GPS_READ_CHUNK) ? n - pos : GPS_READ_CHUNK;
+            gps_parser_feed(&p, &log_buf[pos], l, (int64_t)pos);
+        }
+    }
+#ifdef HAVE_TSC
+    uint64_t c1 = __rdtsc();
+#endif
+    double total_ns = now_ns() - t0;
+    double bytes = (double)n * BENCH_PASSES;
+
+    printf("\nThroughput (%d s log, %zu bytes, %d-byte reads, host):\n", BENCH_SECONDS, n, GPS_READ_CHUNK);
+    printf("  %.1f MB/s, %.2f ns/byte (UART at %d baud: %d B/s)\n",
+           bytes / total_ns * 1e3, total_ns / bytes, GPS_BAUD_RUN, GPS_BAUD_RUN / 10);
+#ifdef HAVE_TSC
+    printf("  %6.2f ns  %6.1f TSC ticks per byte\n", total_ns / bytes, (double)(c1 - c0) / bytes);
+#endif
+    check("benchmark log: every fix decoded", fix_count == expect_fixes && p.stats.checksum_errors == 0);
+
+    // Cost of a whole message = last byte -> callback latency for a message read at once
+    uint8_t frame[UBX_NAV_PVT_LEN + 8];
+    size_t fl = nav_pvt_frame(&EXPECT[0], 0, frame, sizeof(frame));
+    size_t el = build(-1, NULL, false, false) / EPOCHS;
+    const char *label[2] = {"NAV-PVT frame", "NMEA epoch"};
+    for (int mode = 0; mode < 2; mode++) {
+        const uint8_t *data = (mode == 0) ? frame : stream;
+        size_t len = (mode == 0) ? fl : el;
+        gps_parser_init(&p, on_fix, NULL);
+        fix_count = 0;
+        t0 = now_ns();
+#ifdef HAVE_TSC
+        c0 = __rdtsc();
+#endif
+        for (int i = 0; i < BENCH_FRAMES; i++) gps_parser_feed(&p, data, len, i);
+#ifdef HAVE_TSC
+        c1 = __rdtsc();
+#endif
+        double ns = (now_ns() - t0) / BENCH_FRAMES;
+#ifdef HAVE_TSC
+        printf("  %-14s %4zu B  %8.2f ns  %8.1f TSC ticks\n", label[mode], len, ns,
+               (double)(c1 - c0) / BENCH_FRAMES);
+#else
+        printf("  %-14s %4zu B  %8.2f ns\n", label[mode], len, ns);
+#endif
+    }
+}
+
+int main(void) {
+    printf("GPS parser canned-stream test\n");
+
+    test_whole_stream();
+    test_split();
+    test_corrupted();
+    test_noise();
+    test_no_fix_and_hemispheres();
+    test_false_sync();
+    bench();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,190 @@
+/**
+ * @file health_bench.c
+ * @brief Host benchmark and fault-injection run of the sensor health detectors
+ * @details
+ * Runs src/sys_health_stats.c with the default thresholds and reports:
+ * - cost per sample (host ns and TSC ticks) for each sensor type;
+ * - for synthetic signals: clean runs (must stay OK) and injected faults
+ *   (stuck HX711, HX711 timeouts, frozen echo, blind-zone spikes, noisy
+ *   battery connector), with the samples it took to reach DEGRADED and FAILED.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/health_bench.c src/sys_health_stats.c -lm -o health_bench
+ *   ./health_bench
+ *
+ * On target, health_log_stats() prints the measured cycles per update.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "sys_health.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define BENCH_SAMPLES       10000000
+#define SCENARIO_SAMPLES    2000
+#define FAULT_AT            1000
+
+static uint32_t rng_state = 12345;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static float frand(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 16777216.0f;
+}
+
+static float gauss(float sigma) {
+    float u1 = frand() + 1e-7f, u2 = frand();
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+typedef struct {
+    const char *name;
+    const health_cfg_t *cfg;
+    uint32_t period_us;
+    float base;
+    float noise;
+    bool integer;               // Driver delivers whole counts / mm
+} sensor_t;
+
+static const sensor_t sensors[] = {
+    { "HX711 (raw counts)",  &health_cfg_loadcell,   100000,  120000.0f, 25.0f, true  },
+    { "JSN-SR04T (mm)",      &health_cfg_ultrasonic, 60000,   1800.0f,   1.2f,  true  },
+    { "Battery (V)",         &health_cfg_battery,    1000000, 7.8f,      0.01f, false },
+};
+
+/**
+ * @brief Cost per sample, signal precomputed so only the detector is timed
+ */
+static void bench_cost(const sensor_t *s) {
+    static float x[4096];
+    for (int i = 0; i < 4096; i++) x[i] = s->base + gauss(s->noise);
+
+    health_chan_t c;
+    health_chan_reset(&c);
+    volatile uint8_t sink = 0;
+    int64_t t = 0;
+
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    double t0 = now_ns();
+    for (uint32_t i = 0; i < BENCH_SAMPLES; i++) {
+        t += s->period_us;
+        sink ^= health_chan_sample(&c, s->cfg, x[i & 4095], t);
+    }
+    double ns = (now_ns() - t0) / BENCH_SAMPLES;
+#ifdef HAVE_TSC
+    double ticks = (double)(__rdtsc() - c0) / BENCH_SAMPLES;
+    printf("  %-20s %6.2f ns  %6.1f TSC ticks per sample\n", s->name, ns, ticks);
+#else
+    printf("  %-20s %6.2f ns per sample\n", s->name, ns);
+#endif
+    (void)sink;
+}
+
+typedef enum {
+    F_NONE, F_STUCK, F_DROPOUT, F_ZERO, F_SPIKES, F_NOISY, F_LOAD_STEP,
+} fault_t;
+
+typedef struct {
+    const char *name;
+    int sensor;
+    fault_t fault;
+    bool expect_fault;
+} scenario_t;
+
+static const scenario_t scenarios[] = {
+    { "HX711 clean",                 0, F_NONE,      false },
+    { "HX711 person boards (steps)", 0, F_LOAD_STEP, false },
+    { "HX711 stuck value",           0, F_STUCK,     true  },
+    { "HX711 stuck at zero",         0, F_ZERO,      true  },
+    { "HX711 30% timeouts",          0, F_DROPOUT,   true  },
+    { "Echo clean",                  1, F_NONE,      false },
+    { "Echo frozen",                 1, F_STUCK,     true  },
+    { "Echo 35% blind-zone spikes",  1, F_SPIKES,    true  },
+    { "Echo 30% no echo",            1, F_DROPOUT,   true  },
+    { "Battery clean",               2, F_NONE,      false },
+    { "Battery loose connector",     2, F_NOISY,     true  },
+};
+
+/**
+ * @brief Run a scenario; returns 0 if the outcome matches the expectation
+ */
+static int run_scenario(const scenario_t *sc) {
+    const sensor_t *s = &sensors[sc->sensor];
+    health_chan_t c;
+    health_chan_reset(&c);
+
+    int64_t t = 0;
+    int first_deg = -1, first_fail = -1;
+    int pre_fault_alarms = 0;
+    float frozen = 0.0f;
+
+    for (int i = 0; i < SCENARIO_SAMPLES; i++) {
+        t += s->period_us;
+        float x = s->base + gauss(s->noise);
+        bool faulty = i >= FAULT_AT;
+        health_status_t st;
+
+        if (sc->fault == F_LOAD_STEP) {
+            // 75 kg person in 4 steps, then rocking on the deck
+            int step = i / 250;
+            x += (step > 4 ? 4 : step) * 400000.0f + (i > 1000 ? 20000.0f * sinf(i * 0.3f) : 0.0f);
+        }
+        if (i == FAULT_AT) frozen = x;
+
+        if (faulty && sc->fault == F_DROPOUT && frand() < 0.30f) {
+            st = health_chan_dropout(&c, s->cfg);
+        } else {
+            if (faulty && sc->fault == F_STUCK) x = frozen;
+            if (faulty && sc->fault == F_ZERO) x = 0.0f;
+            if (faulty && sc->fault == F_SPIKES && frand() < 0.35f) x = 4500.0f;
+            if (faulty && sc->fault == F_NOISY) x += gauss(1.0f);
+            if (s->integer) x = roundf(x);
+            st = health_chan_sample(&c, s->cfg, x, t);
+        }
+
+        if (!faulty && st != HEALTH_OK) pre_fault_alarms++;
+        if (faulty && st >= HEALTH_DEGRADED && first_deg < 0) first_deg = i - FAULT_AT;
+        if (faulty && st >= HEALTH_FAILED && first_fail < 0) first_fail = i - FAULT_AT;
+    }
+
+    char deg[16] = "-", fail[16] = "-";
+    if (first_deg >= 0) snprintf(deg, sizeof(deg), "%d", first_deg);
+    if (first_fail >= 0) snprintf(fail, sizeof(fail), "%d", first_fail);
+
+    bool ok = pre_fault_alarms == 0 && (sc->expect_fault ? first_deg >= 0 : first_deg < 0);
+    printf("  %-28s | %-8s | 0x%02x  | %8s | %6s | %s\n", sc->name,
+           c.status == HEALTH_OK ? "OK" : c.status == HEALTH_DEGRADED ? "DEGRADED" : "FAILED",
+           c.cause, deg, fail, ok ? "ok" : (pre_fault_alarms ? "FALSE ALARM" : "MISSED"));
+    return ok ? 0 : 1;
+}
+
+int main(void) {
+    printf("Cost per sample (%d samples, host):\n", BENCH_SAMPLES);
+    for (size_t i = 0; i < sizeof(sensors) / sizeof(sensors[0]); i++) bench_cost(&sensors[i]);
+    printf("State per channel: %u bytes\n\n", (unsigned)sizeof(health_chan_t));
+
+    printf("Fault injection at sample %d (latency in samples after the fault):\n", FAULT_AT);
+    printf("  %-28s | final    | cause | degraded | failed | result\n", "scenario");
+    int failures = 0;
+    for (size_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) failures += run_scenario(&scenarios[i]);
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
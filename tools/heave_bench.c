@@ -0,0 +1,316 @@
+/**
+ * @file heave_bench.c
+ * @brief Host replay of human detection on a heaving deck, with and without IMU compensation
+ * @details
+ * Synthesizes one side load cell (HX711 at 10 SPS, averaging over each
+ * conversion) and the IMU Z accel (1 kHz, noise and bias) on a hull in
+ * waves (three swell components plus random slams), then runs the
+ * detection logic of drv_loadcell.c with src/fusion_heave.c:
+ *
+ * - legacy:     10-sample moving average, lc_detect_req confirmations
+ * - fast raw:   3-sample mean without compensation, lc_detect_fast
+ * - fast comp:  3-sample mean of compensated weights, lc_detect_fast
+ *               (falls back to legacy without a heave factor, as on target)
+ *
+ * Reported per sea state: false detections per hour on an empty deck, and
+ * the latency from the start of boarding to detection (median, p95, misses).
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/heave_bench.c src/fusion_heave.c -lm -o heave_bench
+ *   ./heave_bench
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "fusion_heave.h"
+
+// Defaults of sys_param.h
+#define HUMAN_TRIG          8000
+#define HUMAN_REL           6000
+#define DETECT_REQ          5
+#define DETECT_FAST         2
+
+#define LEGACY_WINDOW       10              // FILTER_BUFFER_SIZE
+#define FAST_WINDOW         3               // LC_FAST_WINDOW
+
+#define IMU_PERIOD_US       1000
+#define LC_PERIOD_US        100000
+#define IMU_LAG_US          10000           // IMU FIFO drained every 10 samples
+#define FP_HOURS            2
+#define TRIALS              300
+#define BOARD_RAMP_S        0.8f            // Person shifts weight onto the cell
+#define MISS_AFTER_S        10.0f
+
+static const char *const mode_names[] = { "legacy", "fast raw", "fast comp" };
+enum { MODE_LEGACY, MODE_FAST_RAW, MODE_FAST_COMP, MODE_COUNT };
+
+typedef struct {
+    const char *name;
+    float swell_g;                  // Amplitude of each swell component (g)
+    float slam_g;                   // Slam peak (g), 0 = none
+    float slam_every_s;             // Mean interval between slams
+    int32_t deadload;               // Platform load tared at rest (g)
+    int32_t person;                 // Load the person puts on this cell (g)
+} sea_t;
+
+static const sea_t seas[] = {
+    { "calm, 3 kg platform",            0.03f, 0.0f, 0.0f,  3000, 20000 },
+    { "moderate, 3 kg platform",        0.12f, 0.5f, 8.0f,  3000, 20000 },
+    { "rough, 3 kg platform",           0.22f, 0.9f, 5.0f,  3000, 20000 },
+    { "rough, 10 kg platform",          0.22f, 0.9f, 5.0f,  10000, 20000 },
+    { "rough, 10 kg, light (12 kg)",    0.22f, 0.9f, 5.0f,  10000, 12000 },
+    { "storm, 15 kg platform",          0.30f, 1.2f, 4.0f,  15000, 20000 },
+};
+
+static uint32_t rng_state = 12345;
+
+// --- HELPERS ---
+
+static float frand(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (float)(rng_state >> 8) / 16777216.0f;
+}
+
+static float gauss(float sigma) {
+    float u1 = frand() + 1e-7f, u2 = frand();
+    return sigma * sqrtf(-2.0f * logf(u1)) * cosf(6.2831853f * u2);
+}
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/**
+ * @brief Hull vertical acceleration (g): swell components plus half-sine slams
+ */
+typedef struct {
+    const sea_t *sea;
+    float phase[3];
+    double next_slam_s;
+    double slam_start_s;
+    float slam_peak;
+    float imu_bias;
+} motion_t;
+
+static const float swell_hz[3] = { 0.32f, 0.51f, 0.83f };
+
+static void motion_init(motion_t *m, const sea_t *sea) {
+    m->sea = sea;
+    for (int i = 0; i < 3; i++) m->phase[i] = 6.2831853f * frand();
+    m->next_slam_s = sea->slam_g > 0.0f ? sea->slam_every_s * 2.0f * frand() : 1e30;
+    m->slam_start_s = -1.0;
+    m->slam_peak = 0.0f;
+    m->imu_bias = gauss(0.01f);
+}
+
+static float motion_accel_g(motion_t *m, double t_s) {
+    float a = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        float w = 6.2831853f * swell_hz[i];
+        a += m->sea->swell_g * sinf(w * (float)t_s + m->phase[i]);
+    }
+
+    if (t_s >= m->next_slam_s) {
+        m->slam_start_s = t_s;
+        m->slam_peak = m->sea->slam_g * (0.5f + frand());
+        m->next_slam_s = t_s + m->sea->slam_every_s * 2.0f * frand();
+    }
+    double ts = t_s - m->slam_start_s;
+    if (m->slam_start_s >= 0.0 && ts < 0.08) a += m->slam_peak * sinf(3.1415927f * (float)(ts / 0.08));
+    return a;
+}
+
+/**
+ * @brief Detection state of one cell, mirrors drv_loadcell.c
+ */
+typedef struct {
+    int32_t filter[LEGACY_WINDOW];
+    uint8_t head, count;
+    int32_t comp[FAST_WINDOW];
+    uint8_t comp_head, comp_count;
+    uint8_t stable;
+    bool detected;
+} det_t;
+
+static int32_t mean_of(const int32_t *buf, int n) {
+    int32_t sum = 0;
+    for (int i = 0; i < n; i++) sum += buf[i];
+    return sum / n;
+}
+
+static void det_update(det_t *d, int mode, int32_t w, const heave_t *h, int64_t t_us, int32_t deadload) {
+    d->filter[d->head] = w;
+    d->head = (d->head + 1) % LEGACY_WINDOW;
+    if (d->count < LEGACY_WINDOW) d->count++;
+
+    int32_t level = 0;
+    int32_t required = DETECT_REQ;
+    float k;
+
+    if (mode == MODE_FAST_RAW) {
+        d->comp[d->comp_head] = w;
+        d->comp_head = (d->comp_head + 1) % FAST_WINDOW;
+        if (d->comp_count < FAST_WINDOW) d->comp_count++;
+    } else if (mode == MODE_FAST_COMP && heave_factor(h, t_us - HEAVE_LC_WINDOW_US, t_us, &k)) {
+        d->comp[d->comp_head] = heave_compensate(w, k, deadload);
+        d->comp_head = (d->comp_head + 1) % FAST_WINDOW;
+        if (d->comp_count < FAST_WINDOW) d->comp_count++;
+    } else {
+        d->comp_count = 0;
+    }
+
+    if (mode != MODE_LEGACY && d->comp_count == FAST_WINDOW) {
+        level = mean_of(d->comp, FAST_WINDOW);
+        required = DETECT_FAST;
+    } else {
+        level = mean_of(d->filter, d->count);
+    }
+
+    if (level >= HUMAN_TRIG) {
+        if (++d->stable > required) d->stable = required;
+        if (d->stable >= required) d->detected = true;
+    } else if (level <= HUMAN_REL) {
+        if (d->stable > 0) d->stable--;
+        if (d->stable == 0) d->detected = false;
+    }
+}
+
+/**
+ * @brief Replay one run of all modes on the same signals
+ * @param board_s   Boarding start (s), < 0 = empty deck
+ * @param rises     Out: rising edges of the detection flag per mode
+ * @param first_s   Out: first detection time per mode (-1 = none)
+ */
+static void replay(const sea_t *sea, double dur_s, double board_s, int rises[MODE_COUNT], double first_s[MODE_COUNT]) {
+    static heave_t heave;
+    heave_init(&heave);
+    motion_t m;
+    motion_init(&m, sea);
+
+    det_t det[MODE_COUNT];
+    memset(det, 0, sizeof(det));
+    for (int i = 0; i < MODE_COUNT; i++) {
+        rises[i] = 0;
+        first_s[i] = -1.0;
+    }
+
+    // IMU samples are fed IMU_LAG_US late, like one FIFO drain
+    static float pending[IMU_LAG_US / IMU_PERIOD_US];
+    const int lag = IMU_LAG_US / IMU_PERIOD_US;
+    double conv_sum = 0.0;
+    int conv_n = 0;
+    int64_t n_imu = (int64_t)(dur_s * 1e6 / IMU_PERIOD_US);
+
+    for (int64_t i = 0; i < n_imu; i++) {
+        int64_t t_us = i * IMU_PERIOD_US;
+        double t_s = t_us * 1e-6;
+        float a = motion_accel_g(&m, t_s);
+
+        if (i >= lag) heave_add(&heave, t_us - IMU_LAG_US, pending[i % lag]);
+        pending[i % lag] = IMU_GRAVITY_MS2 * (1.0f + a + m.imu_bias) + gauss(0.08f);
+
+        // Load on the cell, tared at rest
+        float person = 0.0f;
+        if (board_s >= 0.0 && t_s >= board_s) {
+            float r = (float)((t_s - board_s) / BOARD_RAMP_S);
+            person = sea->person * (r > 1.0f ? 1.0f : r);
+        }
+        conv_sum += (sea->deadload + person) * (1.0f + a) - sea->deadload;
+        conv_n++;
+
+        if ((t_us + IMU_PERIOD_US) % LC_PERIOD_US != 0) continue;
+
+        // Read (and stamped) up to 2 ms after the conversion ends: DOUT poll + bit-bang
+        int64_t t_read = t_us + IMU_PERIOD_US + (int64_t)(frand() * 2000.0f);
+        int32_t w = (int32_t)lroundf((float)(conv_sum / conv_n) + gauss(30.0f));
+        conv_sum = 0.0;
+        conv_n = 0;
+
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            bool before = det[mode].detected;
+            det_update(&det[mode], mode, w, &heave, t_read, sea->deadload);
+            if (det[mode].detected && !before) {
+                rises[mode]++;
+                if (first_s[mode] < 0.0) first_s[mode] = t_read * 1e-6;
+            }
+        }
+    }
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void run_sea(const sea_t *sea) {
+    int rises[MODE_COUNT];
+    double first[MODE_COUNT];
+    replay(sea, FP_HOURS * 3600.0, -1.0, rises, first);
+    int fp[MODE_COUNT];
+    memcpy(fp, rises, sizeof(fp));
+
+    static double lat[MODE_COUNT][TRIALS];
+    int n_lat[MODE_COUNT] = { 0 }, misses[MODE_COUNT] = { 0 };
+    for (int t = 0; t < TRIALS; t++) {
+        double board = 5.0 + 10.0 * frand();
+        replay(sea, board + MISS_AFTER_S, board, rises, first);
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            if (first[mode] < 0.0) misses[mode]++;
+            else if (first[mode] < board) continue;         // Already a false positive
+            else lat[mode][n_lat[mode]++] = first[mode] - board;
+        }
+    }
+
+    printf("%s\n", sea->name);
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        qsort(lat[mode], n_lat[mode], sizeof(double), cmp_double);
+        double med = n_lat[mode] ? lat[mode][n_lat[mode] / 2] : 0.0;
+        double p95 = n_lat[mode] ? lat[mode][(n_lat[mode] * 95) / 100] : 0.0;
+        printf("  %-10s | %7.1f /h | %6.2f s | %6.2f s | %3d/%d\n", mode_names[mode],
+               fp[mode] / (double)FP_HOURS, med, p95, misses[mode], TRIALS);
+    }
+}
+
+/**
+ * @brief Cost of the IMU feed and of one factor lookup
+ */
+static void bench_cost(void) {
+    static heave_t h;
+    heave_init(&h);
+    volatile float sink = 0.0f;
+    const int n = 10000000;
+
+    double t0 = now_ns();
+    for (int i = 0; i < n; i++) heave_add(&h, (int64_t)i * IMU_PERIOD_US, IMU_GRAVITY_MS2 + (float)(i & 15) * 0.01f);
+    double add_ns = (now_ns() - t0) / n;
+
+    const int m = 1000000;
+    int64_t end = (int64_t)n * IMU_PERIOD_US - 2 * HEAVE_SLOT_US;
+    float k = 0.0f;
+    t0 = now_ns();
+    for (int i = 0; i < m; i++) {
+        heave_factor(&h, end - HEAVE_LC_WINDOW_US - (i & 7), end - (i & 7), &k);
+        sink += k;
+    }
+    double factor_ns = (now_ns() - t0) / m;
+
+    printf("Cost (host): heave_add %.2f ns per IMU sample, heave_factor %.1f ns per read\n", add_ns, factor_ns);
+    printf("State: %u bytes\n\n", (unsigned)sizeof(heave_t));
+    (void)sink;
+}
+
+int main(void) {
+    bench_cost();
+
+    printf("Empty deck %d h, %d boardings (trigger %d g, release %d g, req %d, fast %d)\n",
+           FP_HOURS, TRIALS, HUMAN_TRIG, HUMAN_REL, DETECT_REQ, DETECT_FAST);
+    printf("  %-10s | false pos | latency  | p95      | misses\n", "mode");
+    for (size_t i = 0; i < sizeof(seas) / sizeof(seas[0]); i++) run_sea(&seas[i]);
+    return 0;
+}
@@ -0,0 +1,255 @@
+/**
+ * @file imu_fifo_sim.c
+ * @brief Host test of the MPU-9250 FIFO packet parser and scaling
+ * @details
+ * Feeds canned FIFO and AK8963 byte streams (as read from FIFO_R_W and
+ * EXT_SENS_DATA_00) to the pure helpers of src/drv_imu_fifo.c. Checks:
+ * - a burst of whole packets decodes to the expected SI values
+ *   (big-endian, ACCEL_XOUT_H .. GYRO_ZOUT_L order, negative values);
+ * - a trailing partial packet is held back (not parsed, not timestamped);
+ * - max_out clamps the output to the oldest packets, which keep their
+ *   own time slots;
+ * - timestamps are back-dated from the DRDY time of the newest packet at
+ *   1 kHz, for bursts of 1 .. IMU_FIFO_MAX_PACKETS packets;
+ * - accel / gyro scale for every FS setting against the datasheet
+ *   sensitivities (16384..2048 LSB/g, 131..16.4 LSB/dps, within 0.15%);
+ * - magnetometer: ST2 HOFL rejects the sample, the AK8963 axes are
+ *   remapped to the chip frame (mx = hy, my = hx, mz = -hz) and the ASA
+ *   fuse values apply the datasheet sensitivity adjustment per axis.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/imu_fifo_sim.c src/drv_imu_fifo.c -lm -o imu_fifo_sim
+ *   ./imu_fifo_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "drv_imu.h"
+
+#define T_DRDY_US       1234567890LL    // DRDY edge of the newest packet
+#define SCALE_TOL       0.0015f         // Relative, FS vs datasheet LSB/unit
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// Three packets at +-8 g / +-1000 dps, then 5 bytes of a fourth
+static const uint8_t CANNED_FIFO[] = {
+    // ax=0 ay=0 az=+4096 (1 g) | gx=0 gy=0 gz=+328 (~10 dps)
+    0x00, 0x00, 0x00, 0x00, 0x10, 0x00,   0x00, 0x00, 0x00, 0x00, 0x01, 0x48,
+    // ax=-4096 ay=+2048 az=+4096 | gx=-32768 gy=+32767 gz=-1
+    0xF0, 0x00, 0x08, 0x00, 0x10, 0x00,   0x80, 0x00, 0x7F, 0xFF, 0xFF, 0xFF,
+    // ax=+1 ay=-1 az=+4095 | gx=+3277 gy=-3277 gz=0
+    0x00, 0x01, 0xFF, 0xFF, 0x0F, 0xFF,   0x0C, 0xCD, 0xF3, 0x33, 0x00, 0x00,
+    // Partial: FIFO_COUNT read while the fourth packet was being written
+    0x00, 0x00, 0x00, 0x00, 0x10,
+};
+
+// Raw LSB expected for the three whole packets: ax ay az gx gy gz
+static const int16_t CANNED_RAW[3][6] = {
+    {     0,    0, 4096,      0,     0,  328 },
+    { -4096, 2048, 4096, -32768, 32767,   -1 },
+    {     1,   -1, 4095,   3277, -3277,    0 },
+};
+
+// AK8963 block: HXL HXH HYL HYH HZL HZH ST2 (little-endian)
+static const uint8_t CANNED_MAG[IMU_MAG_RAW_SIZE] = {
+    0x2C, 0x01,     // hx = +300 LSB
+    0x38, 0xFF,     // hy = -200 LSB
+    0xE8, 0x03,     // hz = +1000 LSB
+    0x10,           // ST2: BITM (16-bit), no overflow
+};
+
+// --- HELPERS ---
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static int near(float a, float b, float tol) {
+    return fabsf(a - b) <= tol;
+}
+
+static int sample_matches(const imu_sample_t *s, const int16_t raw[6], const imu_scale_t *sc) {
+    float tol = 1e-6f;
+    return near(s->ax, raw[0] * sc->accel_scale, tol) && near(s->ay, raw[1] * sc->accel_scale, tol) &&
+           near(s->az, raw[2] * sc->accel_scale, tol) && near(s->gx, raw[3] * sc->gyro_scale, tol) &&
+           near(s->gy, raw[4] * sc->gyro_scale, tol) && near(s->gz, raw[5] * sc->gyro_scale, tol);
+}
+
+static void put_packet(uint8_t *p, const int16_t raw[6]) {
+    for (int i = 0; i < 6; i++) {
+        p[2 * i] = (uint8_t)((uint16_t)raw[i] >> 8);
+        p[2 * i + 1] = (uint8_t)raw[i];
+    }
+}
+
+// --- SCENARIOS ---
+
+static void scenario_canned_burst(void) {
+    imu_scale_t sc;
+    imu_sample_t out[8];
+    printf("\nCanned FIFO burst (+-%d g, +-%d dps)\n", IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS);
+    imu_scale_init(&sc, IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS, NULL);
+
+    // Whole packets only
+    size_t n = imu_fifo_parse(CANNED_FIFO, 3 * IMU_FIFO_PACKET_SIZE, &sc, T_DRDY_US,
+                              IMU_SAMPLE_PERIOD_US, out, 8);
+    int ok = (n == 3);
+    for (size_t i = 0; ok && i < n; i++) ok = sample_matches(&out[i], CANNED_RAW[i], &sc);
+    check("3 whole packets decode to the expected values", ok);
+    check("1 g on Z reads 9.80665 m/s^2", near(out[0].az, IMU_GRAVITY_MS2, 1e-4f));
+    check("gz 328 LSB reads 10.0 dps", near(out[0].gz / IMU_DEG_TO_RAD, 10.0f, 0.01f));
+    check("full-scale negative gyro reads -1000 dps",
+          near(out[1].gx / IMU_DEG_TO_RAD, -(float)IMU_GYRO_FS_DPS, 1e-3f));
+
+    // Trailing partial packet held back
+    memset(out, 0, sizeof(out));
+    n = imu_fifo_parse(CANNED_FIFO, sizeof(CANNED_FIFO), &sc, T_DRDY_US,
+                       IMU_SAMPLE_PERIOD_US, out, 8);
+    ok = (n == 3) && sample_matches(&out[2], CANNED_RAW[2], &sc) && out[3].timestamp_us == 0;
+    check("trailing 5-byte partial packet not parsed", ok);
+    check("newest whole packet carries the DRDY time", n == 3 && out[2].timestamp_us == T_DRDY_US);
+
+    // max_out clamp: oldest packets, in their own slots
+    memset(out, 0, sizeof(out));
+    n = imu_fifo_parse(CANNED_FIFO, 3 * IMU_FIFO_PACKET_SIZE, &sc, T_DRDY_US,
+                       IMU_SAMPLE_PERIOD_US, out, 2);
+    ok = (n == 2) && sample_matches(&out[0], CANNED_RAW[0], &sc) &&
+         sample_matches(&out[1], CANNED_RAW[1], &sc) && out[2].timestamp_us == 0;
+    check("max_out = 2 returns the 2 oldest packets only", ok);
+    ok = (n == 2) && out[0].timestamp_us == T_DRDY_US - 2 * IMU_SAMPLE_PERIOD_US &&
+         out[1].timestamp_us == T_DRDY_US - IMU_SAMPLE_PERIOD_US;
+    check("clamped packets keep their DRDY slots", ok);
+
+    n = imu_fifo_parse(CANNED_FIFO, IMU_FIFO_PACKET_SIZE - 1, &sc, T_DRDY_US,
+                       IMU_SAMPLE_PERIOD_US, out, 8);
+    check("less than one packet returns 0", n == 0);
+    n = imu_fifo_parse(CANNED_FIFO, sizeof(CANNED_FIFO), &sc, T_DRDY_US,
+                       IMU_SAMPLE_PERIOD_US, out, 0);
+    check("max_out = 0 returns 0", n == 0);
+}
+
+static void scenario_timestamps(void) {
+    static uint8_t fifo[IMU_FIFO_MAX_PACKETS * IMU_FIFO_PACKET_SIZE];
+    static int16_t raw[IMU_FIFO_MAX_PACKETS][6];
+    imu_sample_t out[IMU_FIFO_MAX_PACKETS];
+    imu_scale_t sc;
+    printf("\nDRDY back-dating at %d Hz\n", IMU_SAMPLE_RATE_HZ);
+    imu_scale_init(&sc, IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS, NULL);
+
+    for (int k = 0; k < IMU_FIFO_MAX_PACKETS; k++) {
+        for (int i = 0; i < 6; i++) raw[k][i] = (int16_t)(rnd() & 0xFFFF);
+        put_packet(&fifo[k * IMU_FIFO_PACKET_SIZE], raw[k]);
+    }
+
+    int values_ok = 1, times_ok = 1;
+    for (size_t packets = 1; packets <= IMU_FIFO_MAX_PACKETS; packets++) {
+        int64_t t_newest = T_DRDY_US + (int64_t)packets * 7;
+        size_t n = imu_fifo_parse(fifo, packets * IMU_FIFO_PACKET_SIZE, &sc, t_newest,
+                                  IMU_SAMPLE_PERIOD_US, out, IMU_FIFO_MAX_PACKETS);
+        if (n != packets) {
+            values_ok = times_ok = 0;
+            continue;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if (!sample_matches(&out[i], raw[i], &sc)) values_ok = 0;
+            int64_t want = t_newest - (int64_t)(n - 1 - i) * IMU_SAMPLE_PERIOD_US;
+            if (out[i].timestamp_us != want) times_ok = 0;
+        }
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "bursts of 1..%d random packets decode exactly", IMU_FIFO_MAX_PACKETS);
+    check(what, values_ok);
+    snprintf(what, sizeof(what), "sample i stamped t_newest - (n-1-i) * %d us", IMU_SAMPLE_PERIOD_US);
+    check(what, times_ok);
+}
+
+static void scenario_full_scale(void) {
+    static const uint8_t ACCEL_FS[] = { 2, 4, 8, 16 };
+    static const float ACCEL_LSB_G[] = { 16384.0f, 8192.0f, 4096.0f, 2048.0f };
+    static const uint16_t GYRO_FS[] = { 250, 500, 1000, 2000 };
+    static const float GYRO_LSB_DPS[] = { 131.0f, 65.5f, 32.8f, 16.4f };
+    char what[96];
+    printf("\nFull-scale settings vs datasheet sensitivity\n");
+
+    for (int k = 0; k < 4; k++) {
+        imu_scale_t sc;
+        imu_sample_t out;
+        uint8_t pkt[IMU_FIFO_PACKET_SIZE];
+        imu_scale_init(&sc, ACCEL_FS[k], GYRO_FS[k], NULL);
+
+        // 1 g on X and 100 dps on Z at the datasheet sensitivity
+        int16_t raw[6] = { (int16_t)ACCEL_LSB_G[k], 0, 0, 0, 0, (int16_t)lroundf(100.0f * GYRO_LSB_DPS[k]) };
+        put_packet(pkt, raw);
+        imu_fifo_parse(pkt, sizeof(pkt), &sc, T_DRDY_US, IMU_SAMPLE_PERIOD_US, &out, 1);
+
+        float g = out.ax / IMU_GRAVITY_MS2;
+        snprintf(what, sizeof(what), "+-%2u g: %5.0f LSB reads %.5f g", ACCEL_FS[k], ACCEL_LSB_G[k], g);
+        check(what, fabsf(g - 1.0f) <= SCALE_TOL);
+
+        float dps = out.gz / IMU_DEG_TO_RAD;
+        snprintf(what, sizeof(what), "+-%4u dps: %5d LSB reads %.3f dps", GYRO_FS[k], raw[5], dps);
+        check(what, fabsf(dps - 100.0f) <= 100.0f * SCALE_TOL);
+    }
+}
+
+static void scenario_mag(void) {
+    imu_scale_t sc;
+    imu_mag_sample_t m;
+    uint8_t raw[IMU_MAG_RAW_SIZE];
+    printf("\nAK8963 block\n");
+
+    imu_scale_init(&sc, IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS, NULL);
+    bool ok = imu_mag_parse(CANNED_MAG, &sc, &m);
+    check("valid block accepted", ok && !m.overflow);
+    check("mx = hy (-200 LSB = -30.0 uT)", near(m.mx, -30.0f, 1e-4f));
+    check("my = hx (+300 LSB = +45.0 uT)", near(m.my, 45.0f, 1e-4f));
+    check("mz = -hz (+1000 LSB = -150.0 uT)", near(m.mz, -150.0f, 1e-4f));
+
+    memcpy(raw, CANNED_MAG, sizeof(raw));
+    raw[6] |= 0x08;
+    ok = imu_mag_parse(raw, &sc, &m);
+    check("ST2 HOFL rejects the sample and sets overflow", !ok && m.overflow);
+    raw[6] = 0x00;
+    check("ST2 = 0 (no HOFL) accepted", imu_mag_parse(raw, &sc, &m));
+
+    // ASA: Hadj = H * ((ASA - 128) * 0.5 / 128 + 1); 128 = 1.0, 0 = 0.5, 255 = ~1.496
+    static const uint8_t ASA[3] = { 176, 128, 64 };
+    imu_scale_init(&sc, IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS, ASA);
+    ok = near(sc.mag_scale[0], IMU_MAG_UT_PER_LSB * 1.1875f, 1e-6f) &&
+         near(sc.mag_scale[1], IMU_MAG_UT_PER_LSB, 1e-6f) &&
+         near(sc.mag_scale[2], IMU_MAG_UT_PER_LSB * 0.75f, 1e-6f);
+    check("ASA 176/128/64 scales by 1.1875/1.0/0.75", ok);
+    imu_mag_parse(CANNED_MAG, &sc, &m);
+    ok = near(m.my, 45.0f * 1.1875f, 1e-4f) && near(m.mx, -30.0f, 1e-4f) &&
+         near(m.mz, -150.0f * 0.75f, 1e-4f);
+    check("adjustment follows the sensor axis through the remap", ok);
+
+    static const uint8_t ASA_EDGE[3] = { 0, 255, 128 };
+    imu_scale_init(&sc, IMU_ACCEL_FS_G, IMU_GYRO_FS_DPS, ASA_EDGE);
+    ok = near(sc.mag_scale[0], IMU_MAG_UT_PER_LSB * 0.5f, 1e-6f) &&
+         near(sc.mag_scale[1], IMU_MAG_UT_PER_LSB * (1.0f + 127.0f / 256.0f), 1e-6f);
+    check("ASA 0 / 255 scale by 0.5 / 1.496", ok);
+}
+
+int main(void) {
+    printf("MPU-9250 FIFO parser: %d-byte packets, %d per FIFO\n",
+           IMU_FIFO_PACKET_SIZE, IMU_FIFO_MAX_PACKETS);
+    scenario_canned_burst();
+    scenario_timestamps();
+    scenario_full_scale();
+    scenario_mag();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
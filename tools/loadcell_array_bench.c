@@ -0,0 +1,217 @@
+/**
+ * @file loadcell_array_bench.c
+ * @brief Host benchmark: load-cell array engine vs the per-struct detection code
+ * @details
+ * Runs the same weight streams through
+ * - per-struct: one loadcell_t-like struct per cell, moving average
+ *   re-summed every sample and the hysteresis step, as logic_detect_human()
+ *   did for its two cells before the array engine;
+ * - array: lc_array_update() from src/drv_loadcell_array.c (no heave factor);
+ * for 2, 3 and 8 cells. Checks that both give the same detection state on
+ * every tick (no failed reads: those are handled differently by design),
+ * then reports ns per tick and per cell, and the combined total weight /
+ * centre of load of a boarding on the 3-cell layout.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/loadcell_array_bench.c src/drv_loadcell_array.c src/fusion_heave.c -o loadcell_array_bench
+ *   ./loadcell_array_bench
+ *
+ * Host timings are only meaningful relative to each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "drv_loadcell.h"
+
+// Defaults of sys_param.h
+#define HUMAN_TRIG          8000
+#define HUMAN_REL           6000
+#define DETECT_REQ          5
+
+#define INPUT_TICKS         4096
+#define BENCH_TICKS         (1 << 20)
+#define BENCH_ROUNDS        7
+
+static uint32_t rng_state = 12345;
+
+static int32_t input[INPUT_TICKS][LC_ARRAY_MAX];
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+/**
+ * @brief Per-cell streams: noise and waves, with people stepping on and off
+ */
+static void make_input(void) {
+    for (int c = 0; c < LC_ARRAY_MAX; c++) {
+        int32_t load = 0;
+        for (int t = 0; t < INPUT_TICKS; t++) {
+            if (rnd() % 200 == 0) load = load ? 0 : 15000 + (int32_t)(rnd() % 30000);
+            int32_t wave = (int32_t)(rnd() % 4001) - 2000;
+            input[t][c] = load + wave + (int32_t)(rnd() % 61) - 30;
+        }
+    }
+}
+
+// --- PER-STRUCT REFERENCE (pre-array drv_loadcell.c) ---
+
+typedef struct {
+    int32_t filter_buffer[FILTER_BUFFER_SIZE];
+    uint8_t buffer_head;
+    bool is_buffer_full;
+    uint8_t stable_counter;
+    bool is_human_detected;
+} ref_cell_t;
+
+static int32_t ref_smooth(ref_cell_t *s, int32_t w) {
+    s->filter_buffer[s->buffer_head] = w;
+    s->buffer_head++;
+    if (s->buffer_head >= FILTER_BUFFER_SIZE) {
+        s->is_buffer_full = true;
+        s->buffer_head = 0;
+    }
+    uint8_t count = s->is_buffer_full ? FILTER_BUFFER_SIZE : s->buffer_head;
+    if (count == 0) return w;
+
+    int32_t sum = 0;
+    for (int i = 0; i < count; i++) sum += s->filter_buffer[i];
+    return sum / count;
+}
+
+static void ref_step(ref_cell_t *s, int32_t smooth) {
+    if (smooth >= HUMAN_TRIG) {
+        s->stable_counter++;
+        if (s->stable_counter > DETECT_REQ) s->stable_counter = DETECT_REQ;
+        if (s->stable_counter >= DETECT_REQ) s->is_human_detected = true;
+    } else if (smooth <= HUMAN_REL) {
+        if (s->stable_counter > 0) s->stable_counter--;
+        if (s->stable_counter == 0) s->is_human_detected = false;
+    }
+}
+
+__attribute__((noinline)) static void ref_tick(ref_cell_t *cells, int n, const int32_t *w) {
+    for (int i = 0; i < n; i++) ref_step(&cells[i], ref_smooth(&cells[i], w[i]));
+}
+
+// --- RUNS ---
+
+static void array_setup(lc_array_t *arr, int n) {
+    lc_array_init(arr, (uint8_t)n);
+    arr->detect_req = DETECT_REQ;
+    arr->detect_fast = DETECT_REQ;
+    for (int i = 0; i < n; i++) {
+        lc_cell_cfg_t cfg = { .trig = HUMAN_TRIG, .rel = HUMAN_REL, .deadload = 0,
+                              .x_m = 0.4f * (float)(i / 2), .y_m = (i & 1) ? -0.3f : 0.3f };
+        lc_array_set_cell(arr, (uint8_t)i, &cfg);
+    }
+}
+
+/**
+ * @brief Same input through both; returns the number of mismatching ticks
+ */
+static int check(int n) {
+    static ref_cell_t ref[LC_ARRAY_MAX];
+    static lc_array_t arr;
+    memset(ref, 0, sizeof(ref));
+    array_setup(&arr, n);
+
+    int mismatches = 0;
+    for (int t = 0; t < 4 * INPUT_TICKS; t++) {
+        const int32_t *w = input[t % INPUT_TICKS];
+        ref_tick(ref, n, w);
+        lc_array_update(&arr, w, NULL);
+        for (int i = 0; i < n; i++) {
+            bool det = (arr.detected_mask >> i) & 1u;
+            if (det != ref[i].is_human_detected || arr.stable[i] != ref[i].stable_counter) {
+                mismatches++;
+                break;
+            }
+        }
+    }
+    return mismatches;
+}
+
+static void bench(int n) {
+    static ref_cell_t ref[LC_ARRAY_MAX];
+    static lc_array_t arr;
+    volatile uint32_t sink = 0;
+    double ref_ns = 1e30, arr_ns = 1e30;
+
+    // Best of BENCH_ROUNDS, alternating, to damp host scheduling noise
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        memset(ref, 0, sizeof(ref));
+        array_setup(&arr, n);
+
+        double t0 = now_ns();
+        for (uint32_t t = 0; t < BENCH_TICKS; t++) {
+            ref_tick(ref, n, input[t % INPUT_TICKS]);
+            sink += ref[0].stable_counter;
+        }
+        double ns = (now_ns() - t0) / BENCH_TICKS;
+        if (ns < ref_ns) ref_ns = ns;
+
+        t0 = now_ns();
+        for (uint32_t t = 0; t < BENCH_TICKS; t++) {
+            lc_array_update(&arr, input[t % INPUT_TICKS], NULL);
+            sink += arr.detected_mask;
+        }
+        ns = (now_ns() - t0) / BENCH_TICKS;
+        if (ns < arr_ns) arr_ns = ns;
+    }
+
+    int mism = check(n);
+    printf("  %d cells | %7.1f ns (%5.1f/cell) | %7.1f ns (%5.1f/cell) | %5.2fx | %s\n", n,
+           ref_ns, ref_ns / n, arr_ns, arr_ns / n, ref_ns / arr_ns, mism ? "MISMATCH" : "identical");
+    (void)sink;
+}
+
+static void demo_boarding(void) {
+    static lc_array_t arr;
+    static const float pos[3][2] = { { 0.6f, 0.0f }, { 0.0f, LC_SIDE_ARM_M }, { 0.0f, -LC_SIDE_ARM_M } };
+    array_setup(&arr, 3);
+    for (int i = 0; i < 3; i++) {
+        lc_cell_cfg_t cfg = { .trig = HUMAN_TRIG, .rel = HUMAN_REL, .deadload = 0, .x_m = pos[i][0], .y_m = pos[i][1] };
+        lc_array_set_cell(&arr, (uint8_t)i, &cfg);
+    }
+
+    // A person climbs over the left side, then shifts towards the bow
+    int32_t w[3] = { 0, 0, 0 };
+    printf("\n3-cell boarding (front x=0.6, left y=+%.2f, right y=-%.2f):\n", LC_SIDE_ARM_M, LC_SIDE_ARM_M);
+    printf("  tick | weights (g)          | total | CoL x, y (m) | detected\n");
+    for (int t = 0; t < 30; t++) {
+        w[1] = t < 5 ? 0 : t < 15 ? (t - 4) * 4000 : 40000;
+        w[2] = t < 15 ? 0 : t < 20 ? (t - 14) * 2000 : 10000;
+        w[0] = t < 20 ? 0 : 20000;
+        lc_array_update(&arr, w, NULL);
+        if (t % 3 == 2) {
+            printf("  %4d | %6ld %6ld %6ld | %5ld | %5.2f, %5.2f | 0x%lx\n", t, (long)w[0], (long)w[1], (long)w[2],
+                   (long)arr.total, arr.col_x_m, arr.col_y_m, (unsigned long)arr.detected_mask);
+        }
+    }
+}
+
+int main(void) {
+    make_input();
+    printf("Per tick, %d ticks (host):\n", BENCH_TICKS);
+    printf("  cells   | per-struct              | array                   | speedup | detection\n");
+    bench(2);
+    bench(3);
+    bench(8);
+    printf("State: %u bytes per lc_array_t (%d cells max)\n", (unsigned)sizeof(lc_array_t), LC_ARRAY_MAX);
+
+    demo_boarding();
+    return 0;
+}
@@ -0,0 +1,430 @@
+/**
+ * @file magcal_sim.c
+ * @brief Host test of the magnetometer calibration on synthetic distorted data
+ * @details
+ * Synthesises raw magnetometer readings from a true attitude (NWU earth,
+ * 48 uT field, 63 deg dip) distorted by a hard-iron offset, a symmetric
+ * soft-iron matrix, a motor-current offset that grows as |command|^1.5
+ * per motor (not bilinear, so the table has a real interpolation
+ * residual) and 0.3 uT white noise. Heading error is the tilt-compensated
+ * magcal_heading_deg() minus the true compass heading over 72 headings at
+ * 0 and +-15 deg of roll/pitch. Checks:
+ * - bench tumble (random full-sphere attitudes): fit accepted, hard iron
+ *   within 1 uT, residual heading error max < 1 deg (raw: tens of deg);
+ * - on-water coverage (full turns in waves): no fit with +-15 deg waves
+ *   (Z offset not observable), max < 1.5 deg with +-30 deg waves;
+ * - throttle table learned on a bench step sequence: heading error with motors
+ *   running max < 1.5 deg, against tens of deg with iron correction only;
+ * - forgetting: a 10 uT hard-iron change is tracked within 3 windows;
+ * then reports ns per magcal_add_sample(), magcal_solve() and
+ * magcal_correct() + magcal_heading_deg().
+ *
+ * Soft iron is modelled symmetric: a rotation part of the distortion is
+ * not observable by an ellipsoid fit and would remain as a heading bias.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/magcal_sim.c src/cal_magnetometer.c -lm -o magcal_sim
+ *   ./magcal_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "cal_magnetometer.h"
+#include "app_config.h"
+#include "drv_motor.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define FIELD_UT        48.0
+#define DIP_DEG         63.0
+#define MAG_NOISE_UT    0.3         // 1 sigma per axis
+#define CAL_SAMPLES     3000
+#define EMI_STEPS       (2 * MAGCAL_THR_BINS - 1)
+#define EMI_SAMPLES     4000
+#define BENCH_UPDATES   (1 << 20)
+#define BENCH_SOLVES    (1 << 14)
+
+#define DEG             (M_PI / 180.0)
+
+/**
+ * @brief Sensor distortion applied to the true body field
+ */
+typedef struct {
+    double hard[3];             // uT
+    double soft[3][3];          // Symmetric
+    double emi_left[3];         // uT at full left command
+    double emi_right[3];        // uT at full right command
+} sim_sensor_t;
+
+static sim_sensor_t sensor = {
+    .hard = { 22.0, -14.0, 35.0 },
+    .soft = {
+        { 1.15, 0.08, -0.04 },
+        { 0.08, 0.92, 0.05 },
+        { -0.04, 0.05, 1.05 },
+    },
+    .emi_left = { 6.0, -2.0, 9.0 },
+    .emi_right = { -5.0, -3.0, 8.0 },
+};
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * (rnd() / 16777216.0);
+}
+
+static double gauss(void) {
+    // Sum of 4 uniforms: close enough to normal for sensor noise
+    double s = 0.0;
+    for (int i = 0; i < 4; i++) s += rnd() / 16777216.0;
+    return (s - 2.0) * 1.7320508;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void quat_from_euler(double roll, double pitch, double yaw, double q[4]) {
+    double cr = cos(roll / 2), sr = sin(roll / 2);
+    double cp = cos(pitch / 2), sp = sin(pitch / 2);
+    double cy = cos(yaw / 2), sy = sin(yaw / 2);
+    q[0] = cr * cp * cy + sr * sp * sy;
+    q[1] = sr * cp * cy - cr * sp * sy;
+    q[2] = cr * sp * cy + sr * cp * sy;
+    q[3] = cr * cp * sy - sr * sp * cy;
+}
+
+/**
+ * @brief Earth vector into the body frame (R^T v)
+ */
+static void earth_to_body(const double q[4], const double e[3], double b[3]) {
+    double q0 = q[0], q1 = q[1], q2 = q[2], q3 = q[3];
+    b[0] = (1 - 2 * (q2 * q2 + q3 * q3)) * e[0] + 2 * (q1 * q2 + q0 * q3) * e[1] + 2 * (q1 * q3 - q0 * q2) * e[2];
+    b[1] = 2 * (q1 * q2 - q0 * q3) * e[0] + (1 - 2 * (q1 * q1 + q3 * q3)) * e[1] + 2 * (q2 * q3 + q0 * q1) * e[2];
+    b[2] = 2 * (q1 * q3 + q0 * q2) * e[0] + 2 * (q2 * q3 - q0 * q1) * e[1] + (1 - 2 * (q1 * q1 + q2 * q2)) * e[2];
+}
+
+/**
+ * @brief Motor field offset: grows as (|cmd - idle| / full)^1.5 per motor
+ */
+static void emi_field(uint16_t left_raw, uint16_t right_raw, double out[3]) {
+    const double full = (double)(MOTOR_SPEED_MAX_RAW - MOTOR_IDLE_RAW);
+    double l = fabs((double)left_raw - MOTOR_IDLE_RAW) / full;
+    double r = fabs((double)right_raw - MOTOR_IDLE_RAW) / full;
+    if (l > 1.0) l = 1.0;
+    if (r > 1.0) r = 1.0;
+    l = pow(l, 1.5);
+    r = pow(r, 1.5);
+    for (int i = 0; i < 3; i++) out[i] = l * sensor.emi_left[i] + r * sensor.emi_right[i];
+}
+
+/**
+ * @brief Raw reading, true accel (Up) and true compass heading for an attitude
+ */
+static void sense(double roll, double pitch, double yaw, uint16_t left_raw, uint16_t right_raw, bool noise,
+                  float raw[3], float accel[3], double *heading_deg) {
+    static const double up[3] = { 0.0, 0.0, 1.0 };
+    const double earth[3] = { FIELD_UT * cos(DIP_DEG * DEG), 0.0, -FIELD_UT * sin(DIP_DEG * DEG) };
+    double q[4], m[3], a[3], emi[3];
+
+    quat_from_euler(roll, pitch, yaw, q);
+    earth_to_body(q, earth, m);
+    earth_to_body(q, up, a);
+    emi_field(left_raw, right_raw, emi);
+
+    for (int i = 0; i < 3; i++) {
+        double v = sensor.soft[i][0] * m[0] + sensor.soft[i][1] * m[1] + sensor.soft[i][2] * m[2];
+        v += sensor.hard[i] + emi[i];
+        if (noise) v += MAG_NOISE_UT * gauss();
+        raw[i] = (float)v;
+        accel[i] = (float)a[i];
+    }
+
+    // NWU yaw is counter-clockwise, compass heading clockwise
+    double h = fmod(-yaw / DEG, 360.0);
+    *heading_deg = (h < 0.0) ? h + 360.0 : h;
+}
+
+static double wrap180(double d) {
+    while (d > 180.0) d -= 360.0;
+    while (d < -180.0) d += 360.0;
+    return d;
+}
+
+/**
+ * @brief Random full-sphere attitude
+ */
+static void random_attitude(double *roll, double *pitch, double *yaw) {
+    *roll = uniform(-M_PI, M_PI);
+    *pitch = asin(uniform(-1.0, 1.0));
+    *yaw = uniform(-M_PI, M_PI);
+}
+
+/**
+ * @brief Heading error over 72 headings x 5 tilts at fixed commands
+ * @param cal       Calibration (NULL = raw readings, no correction)
+ * @param use_table true = magcal_correct(), false = iron only
+ */
+static void heading_error(const magcal_t *cal, bool use_table, uint16_t left_raw, uint16_t right_raw,
+                          double *rms, double *max) {
+    static const double tilt[5][2] = { {0, 0}, {15, 0}, {-15, 0}, {0, 15}, {0, -15} };
+    double sum = 0.0, worst = 0.0;
+    int n = 0;
+
+    for (int t = 0; t < 5; t++) {
+        for (int k = 0; k < 72; k++) {
+            float raw[3], accel[3], mag[3];
+            double truth;
+            sense(tilt[t][0] * DEG, tilt[t][1] * DEG, k * 5.0 * DEG, left_raw, right_raw, false,
+                  raw, accel, &truth);
+
+            if (cal == NULL) {
+                memcpy(mag, raw, sizeof(mag));
+            } else if (use_table) {
+                magcal_correct(cal, raw, left_raw, right_raw, mag);
+            } else {
+                magcal_apply_iron(cal, raw, mag);
+            }
+
+            double e = fabs(wrap180(magcal_heading_deg(mag, accel) - truth));
+            sum += e * e;
+            if (e > worst) worst = e;
+            n++;
+        }
+    }
+    *rms = sqrt(sum / n);
+    *max = worst;
+}
+
+static void bench_calibrate(magcal_t *cal) {
+    magcal_init(cal);
+    for (int i = 0; i < CAL_SAMPLES; i++) {
+        double roll, pitch, yaw, h;
+        float raw[3], accel[3];
+        random_attitude(&roll, &pitch, &yaw);
+        sense(roll, pitch, yaw, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, true, raw, accel, &h);
+        magcal_add_sample(cal, raw);
+    }
+}
+
+// --- SCENARIOS ---
+
+static void test_formula(void) {
+    printf("\nHeading formula\n");
+    sim_sensor_t saved = sensor;
+    memset(&sensor, 0, sizeof(sensor));
+    sensor.soft[0][0] = sensor.soft[1][1] = sensor.soft[2][2] = 1.0;
+
+    double rms, max;
+    heading_error(NULL, false, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, &rms, &max);
+    sensor = saved;
+
+    char what[96];
+    snprintf(what, sizeof(what), "undistorted field: max error %.4f deg", max);
+    check(what, max < 0.01);
+}
+
+static void test_bench_tumble(magcal_t *cal) {
+    printf("\nBench tumble (%d samples, full sphere)\n", CAL_SAMPLES);
+    char what[96];
+    double rms, max;
+
+    heading_error(NULL, false, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, &rms, &max);
+    printf("  uncalibrated: rms %.1f deg, max %.1f deg\n", rms, max);
+
+    bench_calibrate(cal);
+    check("fit accepted", cal->is_valid);
+
+    double off_err = 0.0;
+    for (int i = 0; i < 3; i++) {
+        double e = fabs(cal->offset[i] - sensor.hard[i]);
+        if (e > off_err) off_err = e;
+    }
+    snprintf(what, sizeof(what), "hard iron error %.2f uT, field %.1f uT", off_err, cal->field_ut);
+    check(what, off_err < 1.0);
+
+    heading_error(cal, false, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, &rms, &max);
+    snprintf(what, sizeof(what), "residual heading error rms %.2f / max %.2f deg", rms, max);
+    check(what, max < 1.0);
+}
+
+static void on_water(magcal_t *cal, double wave_deg) {
+    magcal_init(cal);
+    for (int i = 0; i < CAL_SAMPLES; i++) {
+        double t = i * 0.1;
+        double roll = wave_deg * DEG * sin(2 * M_PI * t / 4.1);
+        double pitch = wave_deg * DEG * sin(2 * M_PI * t / 5.3 + 1.0);
+        double yaw = 2 * M_PI * t / 60.0;
+        double h;
+        float raw[3], accel[3];
+        sense(roll, pitch, yaw, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, true, raw, accel, &h);
+        magcal_add_sample(cal, raw);
+    }
+}
+
+static void test_on_water(void) {
+    printf("\nOn-water coverage (%d samples, full turns in waves)\n", CAL_SAMPLES);
+    magcal_t cal;
+    char what[96];
+
+    // Z hard iron is only observable through tilt: small waves must not give a fit
+    on_water(&cal, 15.0);
+    check("+-15 deg waves: too little excitation, no fit", !cal.is_valid);
+
+    on_water(&cal, 30.0);
+    double rms, max;
+    heading_error(&cal, false, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, &rms, &max);
+    snprintf(what, sizeof(what), "+-30 deg waves: rms %.2f / max %.2f deg", rms, max);
+    check(what, cal.is_valid && max < 1.5);
+}
+
+static void test_throttle(magcal_t *cal) {
+    const int step = (MOTOR_SPEED_MAX_RAW - MOTOR_IDLE_RAW) / (2 * (MAGCAL_THR_BINS - 1));
+    printf("\nThrottle EMI table (bench, %d x %d command steps of %d, %d samples)\n",
+           EMI_STEPS, EMI_STEPS, step, EMI_SAMPLES);
+
+    // Bench: craft held still at random headings, reference snapshot at idle,
+    // both motors stepped through bin nodes and midpoints in random order
+    // (a row-by-row sweep would leave each cell biased by its last neighbour)
+    for (int i = 0; i < EMI_SAMPLES; i++) {
+        double roll = 0.0, pitch = 0.0, yaw = uniform(-M_PI, M_PI), h;
+        int sl = (rnd() & 1) ? 1 : -1, sr = (rnd() & 1) ? 1 : -1;
+        uint16_t l = (uint16_t)(MOTOR_IDLE_RAW + sl * (int)(rnd() % EMI_STEPS) * step);
+        uint16_t r = (uint16_t)(MOTOR_IDLE_RAW + sr * (int)(rnd() % EMI_STEPS) * step);
+        float raw[3], idle[3], accel[3], corrected[3], reference[3];
+
+        uint32_t seed = rng_state;
+        sense(roll, pitch, yaw, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, true, idle, accel, &h);
+        rng_state = seed;
+        sense(roll, pitch, yaw, l, r, true, raw, accel, &h);
+
+        magcal_apply_iron(cal, raw, corrected);
+        magcal_apply_iron(cal, idle, reference);
+        magcal_learn_throttle(cal, corrected, reference, l, r);
+    }
+
+    static const uint16_t cmds[][2] = {
+        { 7500, 7500 }, { 10000, 10000 }, { 10000, 5000 }, { 2500, 8750 }, { 0, 0 }, { 6250, 9000 },
+    };
+    double worst_iron = 0.0, worst_table = 0.0, rms_table = 0.0;
+    for (size_t c = 0; c < sizeof(cmds) / sizeof(cmds[0]); c++) {
+        double rms, max;
+        heading_error(cal, false, cmds[c][0], cmds[c][1], &rms, &max);
+        if (max > worst_iron) worst_iron = max;
+        heading_error(cal, true, cmds[c][0], cmds[c][1], &rms, &max);
+        if (max > worst_table) worst_table = max;
+        if (rms > rms_table) rms_table = rms;
+    }
+    printf("  iron correction only: max %.1f deg\n", worst_iron);
+
+    char what[96];
+    snprintf(what, sizeof(what), "with throttle table: rms %.2f / max %.2f deg", rms_table, worst_table);
+    check(what, worst_table < 1.5 && worst_table < worst_iron / 3.0);
+}
+
+static void test_forgetting(void) {
+    printf("\nForgetting (hard iron +10 uT on X)\n");
+    magcal_t cal;
+    bench_calibrate(&cal);
+
+    sensor.hard[0] += 10.0;
+    for (int i = 0; i < 3 * MAGCAL_WINDOW; i++) {
+        double roll, pitch, yaw, h;
+        float raw[3], accel[3];
+        random_attitude(&roll, &pitch, &yaw);
+        sense(roll, pitch, yaw, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, true, raw, accel, &h);
+        magcal_add_sample(&cal, raw);
+    }
+
+    double rms, max;
+    heading_error(&cal, false, MOTOR_IDLE_RAW, MOTOR_IDLE_RAW, &rms, &max);
+    sensor.hard[0] -= 10.0;
+
+    char what[96];
+    snprintf(what, sizeof(what), "after %d samples: offset X %.1f uT, max error %.2f deg",
+             3 * MAGCAL_WINDOW, cal.offset[0], max);
+    check(what, max < 1.5);
+}
+
+static void bench(const magcal_t *fitted) {
+    static float buf[1024][3];
+    static float acc[1024][3];
+    for (int i = 0; i < 1024; i++) {
+        double roll, pitch, yaw, h;
+        random_attitude(&roll, &pitch, &yaw);
+        sense(roll, pitch, yaw, 8000, 7000, true, buf[i], acc[i], &h);
+    }
+
+    printf("\nCost (host):\n");
+    const char *label[3] = {"add_sample", "solve", "correct+heading"};
+    const int runs[3] = { BENCH_UPDATES, BENCH_SOLVES, BENCH_UPDATES };
+    volatile float sink = 0.0f;
+
+    for (int mode = 0; mode < 3; mode++) {
+        magcal_t cal = *fitted;
+        cal.since_solve = 0;
+        double t0 = now_ns();
+#ifdef HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        for (int i = 0; i < runs[mode]; i++) {
+            if (mode == 0) {
+                magcal_add_sample(&cal, buf[i & 1023]);
+            } else if (mode == 1) {
+                magcal_solve(&cal);
+            } else {
+                float out[3];
+                magcal_correct(&cal, buf[i & 1023], 8000, 7000, out);
+                sink += magcal_heading_deg(out, acc[i & 1023]);
+            }
+        }
+#ifdef HAVE_TSC
+        uint64_t c1 = __rdtsc();
+#endif
+        double ns = (now_ns() - t0) / runs[mode];
+#ifdef HAVE_TSC
+        printf("  %-16s %8.2f ns  %8.1f TSC ticks\n", label[mode], ns, (double)(c1 - c0) / runs[mode]);
+#else
+        printf("  %-16s %8.2f ns\n", label[mode], ns);
+#endif
+    }
+    (void)sink;
+}
+
+int main(void) {
+    static magcal_t cal;
+
+    printf("Magnetometer calibration test\n");
+    test_formula();
+    test_bench_tumble(&cal);
+    test_on_water();
+    test_throttle(&cal);
+    test_forgetting();
+    bench(&cal);
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
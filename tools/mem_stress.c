@@ -0,0 +1,399 @@
+/**
+ * @file mem_stress.c
+ * @brief Host stress test of the block pools against a general-purpose heap
+ * @details
+ * Prints the MEM_BUDGET_TABLE (the build-time budget report), checks the
+ * pool and arena edge cases of src/sys_mem_pool.c, then replays one
+ * synthetic standby (10 ms steps, several hours) of short-lived buffers:
+ * AT lines, log entries, telemetry frames and MQTT publishes, plus a few
+ * long-lived session buffers that pin holes in a heap. The same
+ * request sequence goes to:
+ * - a best-fit, coalescing heap model over a fixed region (what the IDF
+ *   TLSF heap approximates), sized like the pools plus one 8 KB buffer;
+ * - fixed-block pools (64/128/256/1152 B classes) in the same RAM, with
+ *   the 8 KB buffer static;
+ * - the host malloc(), for latency only (no size limit).
+ * Reported: refused requests, heap fragmentation (1 - largest free block /
+ * free bytes) and whether an 8 KB buffer (OTA range, TLS record) could
+ * still be allocated, sampled every second, and ns per alloc+free.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/mem_stress.c src/sys_mem_pool.c -o mem_stress
+ *   ./mem_stress [steps]
+ *
+ * Host timings: the shape (pools constant, heap search growing with the
+ * free list) carries over to the target, the absolute numbers do not.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sys_mem.h"
+
+#define STRESS_STEPS        2000000     // 10 ms each: 5.5 h of standby
+#define STRESS_SAMPLE_STEPS 100         // Fragmentation sample every second
+#define STRESS_BIG_BYTES    8192
+#define STRESS_MAX_LIVE     512
+#define HEAP_MAX_EXTENTS    1024
+#define LAT_BUCKETS         4096        // 1 ns histogram buckets
+
+typedef enum { ALLOC_HEAP = 0, ALLOC_POOL, ALLOC_MALLOC, ALLOC_COUNT } alloc_kind_t;
+
+static const char *const alloc_names[ALLOC_COUNT] = { "heap model", "pools", "host malloc" };
+
+/**
+ * @brief Request class: arrival probability per step, size and lifetime ranges
+ */
+typedef struct {
+    const char *name;
+    float p;
+    uint16_t min_size, max_size;
+    uint16_t min_life, max_life;
+} req_class_t;
+
+static const req_class_t classes[] = {
+    { "AT line",   0.50f,  16,  128,  1,   3 },
+    { "log entry", 0.30f,  24,   96,  1,  40 },
+    { "telemetry", 0.10f,  48,  220,  1, 100 },
+    { "MQTT pub",  0.02f, 100, 1100, 10, 300 },
+    { "session",   0.0002f, 32, 200, 3000, 60000 },    // Long-lived: pins holes
+};
+#define NUM_CLASSES (sizeof(classes) / sizeof(classes[0]))
+
+static const struct { uint16_t block; uint16_t count; } pool_cfg[] = {
+    { 64, 24 }, { 128, 32 }, { 256, 24 }, { 1152, 12 },
+};
+#define NUM_POOLS (sizeof(pool_cfg) / sizeof(pool_cfg[0]))
+
+typedef struct {
+    void *ptr;
+    uint32_t size;
+    uint32_t expire;
+    int8_t pool;
+} live_t;
+
+static uint32_t rng_state;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static uint32_t rnd_range(uint32_t lo, uint32_t hi) {
+    return lo + (rnd() >> 8) % (hi - lo + 1);
+}
+
+static float rnd_unit(void) {
+    return (rnd() >> 8) / 16777216.0f;
+}
+
+// --- HEAP MODEL ---
+
+/**
+ * @brief Best-fit allocator over one region: sorted free extents, coalesced on free
+ */
+typedef struct {
+    uint8_t *base;
+    uint32_t size;
+    uint32_t off[HEAP_MAX_EXTENTS];
+    uint32_t len[HEAP_MAX_EXTENTS];
+    uint32_t n;
+    uint32_t used;
+} heap_model_t;
+
+#define HEAP_HDR    8                   // Block header (size), like TLSF's
+#define HEAP_GRAIN  8
+
+static void heap_init(heap_model_t *h, void *base, uint32_t size) {
+    h->base = base;
+    h->size = size;
+    h->off[0] = 0;
+    h->len[0] = size;
+    h->n = 1;
+    h->used = 0;
+}
+
+static void *heap_alloc(heap_model_t *h, uint32_t size) {
+    uint32_t need = (size + HEAP_HDR + HEAP_GRAIN - 1) & ~(uint32_t)(HEAP_GRAIN - 1);
+    int best = -1;
+    for (uint32_t i = 0; i < h->n; i++) {
+        if (h->len[i] >= need && (best < 0 || h->len[i] < h->len[best])) best = (int)i;
+    }
+    if (best < 0) return NULL;
+
+    uint32_t at = h->off[best];
+    if (h->len[best] - need < HEAP_HDR + HEAP_GRAIN) {
+        need = h->len[best];            // Remainder too small to track: hand it out
+        memmove(&h->off[best], &h->off[best + 1], (h->n - best - 1) * sizeof(uint32_t));
+        memmove(&h->len[best], &h->len[best + 1], (h->n - best - 1) * sizeof(uint32_t));
+        h->n--;
+    } else {
+        h->off[best] += need;
+        h->len[best] -= need;
+    }
+    memcpy(h->base + at, &need, sizeof(need));
+    h->used += need;
+    return h->base + at + HEAP_HDR;
+}
+
+static void heap_free(heap_model_t *h, void *ptr) {
+    uint32_t at = (uint32_t)((uint8_t *)ptr - h->base) - HEAP_HDR, len;
+    memcpy(&len, h->base + at, sizeof(len));
+    h->used -= len;
+
+    // Insertion point (extents sorted by offset)
+    uint32_t lo = 0, hi = h->n;
+    while (lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if (h->off[mid] < at) lo = mid + 1;
+        else hi = mid;
+    }
+    bool prev = lo > 0 && h->off[lo - 1] + h->len[lo - 1] == at;
+    bool next = lo < h->n && at + len == h->off[lo];
+    if (prev && next) {
+        h->len[lo - 1] += len + h->len[lo];
+        memmove(&h->off[lo], &h->off[lo + 1], (h->n - lo - 1) * sizeof(uint32_t));
+        memmove(&h->len[lo], &h->len[lo + 1], (h->n - lo - 1) * sizeof(uint32_t));
+        h->n--;
+    } else if (prev) {
+        h->len[lo - 1] += len;
+    } else if (next) {
+        h->off[lo] = at;
+        h->len[lo] += len;
+    } else {
+        memmove(&h->off[lo + 1], &h->off[lo], (h->n - lo) * sizeof(uint32_t));
+        memmove(&h->len[lo + 1], &h->len[lo], (h->n - lo) * sizeof(uint32_t));
+        h->off[lo] = at;
+        h->len[lo] = len;
+        h->n++;
+    }
+}
+
+static uint32_t heap_largest(const heap_model_t *h) {
+    uint32_t m = 0;
+    for (uint32_t i = 0; i < h->n; i++) {
+        if (h->len[i] > m) m = h->len[i];
+    }
+    return m > HEAP_HDR ? m - HEAP_HDR : 0;
+}
+
+// --- UNIT CHECKS ---
+
+static int check_pool_arena(void) {
+    static uint8_t mem[4096] __attribute__((aligned(MEM_ALIGN)));
+    int failures = 0;
+    mem_arena_t a;
+    mem_pool_t p;
+
+    mem_arena_init(&a, mem, sizeof(mem));
+    uint8_t *x = mem_arena_alloc(&a, 1);
+    uint8_t *y = mem_arena_alloc(&a, 100);
+    if (x != mem || y != mem + MEM_ALIGN || a.used != MEM_ALIGN + MEM_ALIGN_UP(100)) failures++;
+    if (mem_arena_alloc(&a, sizeof(mem)) != NULL || a.failed != 1) failures++;
+
+    void *storage = mem_arena_alloc(&a, MEM_ALIGN_UP(40) * 4);
+    if (!mem_pool_init(&p, "t", storage, 40, 4) || p.block_size != MEM_ALIGN_UP(40)) failures++;
+    void *b[5];
+    for (int i = 0; i < 5; i++) b[i] = mem_pool_take(&p);
+    if (b[0] != storage || b[3] == NULL || b[4] != NULL || p.failed != 1 || p.peak != 4) failures++;
+    for (int i = 0; i < 4; i++) {
+        if (((uintptr_t)b[i] & (MEM_ALIGN - 1)) != 0) failures++;
+    }
+    if (mem_pool_give(&p, (uint8_t *)b[1] + 1) || mem_pool_give(&p, mem) || p.bad_give != 2) failures++;
+    for (int i = 0; i < 4; i++) {
+        if (!mem_pool_give(&p, b[i])) failures++;
+    }
+    if (mem_pool_give(&p, b[0]) || p.in_use != 0) failures++;    // More gives than takes
+    if (mem_pool_take(&p) != b[3]) failures++;                  // LIFO reuse
+
+    printf("Pool / arena checks: %s\n", failures ? "FAILED" : "ok");
+    return failures;
+}
+
+static void print_budgets(void) {
+    printf("Memory budget (MEM_BUDGET_TABLE):\n");
+    for (int s = 0; s < MEM_SUB_COUNT; s++) {
+        printf("  %-10s %6lu B\n", mem_sub_name((mem_sub_t)s), (unsigned long)mem_sub_budget((mem_sub_t)s));
+    }
+    printf("  %-10s %6u B static (.bss), no task stack or queue on the heap\n\n", "region", (unsigned)MEM_REGION_BYTES);
+}
+
+// --- STRESS ---
+
+typedef struct {
+    uint64_t requests;
+    uint64_t refused;
+    double frag_sum;
+    double frag_max;
+    uint32_t samples;
+    uint32_t big_failed;        // Samples where STRESS_BIG_BYTES did not fit
+    uint32_t largest_min;       // Smallest largest-free-block seen
+    uint32_t peak_bytes;
+    uint32_t lat[LAT_BUCKETS];  // alloc + free pairs
+    double ns_total;
+    uint64_t timed;
+} result_t;
+
+static void record_lat(result_t *r, double ns) {
+    uint32_t b = ns < 0 ? 0 : ns >= LAT_BUCKETS - 1 ? LAT_BUCKETS - 1 : (uint32_t)ns;
+    r->lat[b]++;
+    r->ns_total += ns;
+    r->timed++;
+}
+
+static uint32_t percentile(const result_t *r, double q) {
+    uint64_t want = (uint64_t)(q * r->timed), acc = 0;
+    for (uint32_t i = 0; i < LAT_BUCKETS; i++) {
+        acc += r->lat[i];
+        if (acc > want) return i;
+    }
+    return LAT_BUCKETS;
+}
+
+static int pool_for(uint32_t size) {
+    for (size_t i = 0; i < NUM_POOLS; i++) {
+        if (size <= pool_cfg[i].block) return (int)i;
+    }
+    return -1;
+}
+
+static void run(alloc_kind_t kind, uint32_t steps, result_t *r) {
+    static live_t live[STRESS_MAX_LIVE];
+    static uint8_t region[64 * 1024] __attribute__((aligned(MEM_ALIGN)));
+    static heap_model_t heap;
+    static mem_pool_t pools[NUM_POOLS];
+    uint32_t n_live = 0, pool_bytes = 0;
+
+    memset(r, 0, sizeof(*r));
+    r->largest_min = UINT32_MAX;
+    rng_state = 12345;
+
+    for (size_t i = 0; i < NUM_POOLS; i++) {
+        mem_pool_init(&pools[i], "p", region + pool_bytes, pool_cfg[i].block, pool_cfg[i].count);
+        pool_bytes += MEM_ALIGN_UP(pool_cfg[i].block) * pool_cfg[i].count;
+    }
+    heap_init(&heap, region, pool_bytes + STRESS_BIG_BYTES);
+
+    for (uint32_t step = 0; step < steps; step++) {
+        // Expire
+        for (uint32_t i = 0; i < n_live;) {
+            if (live[i].expire > step) {
+                i++;
+                continue;
+            }
+            double t0 = now_ns();
+            if (kind == ALLOC_HEAP) heap_free(&heap, live[i].ptr);
+            else if (kind == ALLOC_POOL) mem_pool_give(&pools[live[i].pool], live[i].ptr);
+            else free(live[i].ptr);
+            record_lat(r, now_ns() - t0);
+            live[i] = live[--n_live];
+        }
+
+        // Arrivals
+        for (size_t c = 0; c < NUM_CLASSES; c++) {
+            if (rnd_unit() >= classes[c].p) continue;
+            uint32_t size = rnd_range(classes[c].min_size, classes[c].max_size);
+            uint32_t life = rnd_range(classes[c].min_life, classes[c].max_life);
+            r->requests++;
+            if (n_live == STRESS_MAX_LIVE) {
+                r->refused++;
+                continue;
+            }
+
+            void *ptr = NULL;
+            int pool = pool_for(size);
+            double t0 = now_ns();
+            if (kind == ALLOC_HEAP) ptr = heap_alloc(&heap, size);
+            else if (kind == ALLOC_POOL) ptr = mem_pool_take(&pools[pool]);
+            else ptr = malloc(size);
+            record_lat(r, now_ns() - t0);
+
+            if (ptr == NULL) {
+                r->refused++;
+                continue;
+            }
+            memset(ptr, (int)c, size < 16 ? size : 16);
+            live[n_live++] = (live_t){ .ptr = ptr, .size = size, .expire = step + life, .pool = (int8_t)pool };
+        }
+
+        // Fragmentation sample
+        if (kind == ALLOC_HEAP && step % STRESS_SAMPLE_STEPS == 0) {
+            uint32_t free_b = heap.size - heap.used, largest = heap_largest(&heap);
+            double frag = free_b ? 1.0 - (double)largest / free_b : 0.0;
+            r->frag_sum += frag;
+            if (frag > r->frag_max) r->frag_max = frag;
+            if (largest < STRESS_BIG_BYTES) r->big_failed++;
+            if (largest < r->largest_min) r->largest_min = largest;
+            if (heap.used > r->peak_bytes) r->peak_bytes = heap.used;
+            r->samples++;
+        } else if (kind == ALLOC_POOL && step % STRESS_SAMPLE_STEPS == 0) {
+            r->samples++;
+        }
+    }
+
+    // Drain
+    for (uint32_t i = 0; i < n_live; i++) {
+        if (kind == ALLOC_HEAP) heap_free(&heap, live[i].ptr);
+        else if (kind == ALLOC_POOL) mem_pool_give(&pools[live[i].pool], live[i].ptr);
+        else free(live[i].ptr);
+    }
+    if (kind == ALLOC_HEAP && (heap.used != 0 || heap.n != 1)) {
+        printf("  heap model: %u B / %u extents left after drain\n", heap.used, heap.n);
+        r->refused = UINT64_MAX;
+    }
+    if (kind == ALLOC_POOL) {
+        for (size_t i = 0; i < NUM_POOLS; i++) {
+            printf("  pool %4u B x %2u: peak %2u in use, empty on %lu takes\n", pool_cfg[i].block,
+                   pool_cfg[i].count, pools[i].peak, (unsigned long)pools[i].failed);
+            if (pools[i].in_use != 0 || pools[i].bad_give != 0) r->refused = UINT64_MAX;
+        }
+        r->peak_bytes = pool_bytes;
+    }
+}
+
+int main(int argc, char **argv) {
+    uint32_t steps = argc > 1 ? (uint32_t)strtoul(argv[1], NULL, 0) : STRESS_STEPS;
+    int failures = 0;
+    static result_t res[ALLOC_COUNT];
+
+    print_budgets();
+    failures += check_pool_arena();
+
+    printf("\nStandby stress: %lu steps of 10 ms (%.1f h)\n", (unsigned long)steps, steps / 360000.0);
+    for (int k = 0; k < ALLOC_COUNT; k++) {
+        run((alloc_kind_t)k, steps, &res[k]);
+        if (res[k].refused == UINT64_MAX) failures++;
+    }
+
+    printf("\n  %-12s | requests  | refused  | frag avg / max   | 8 KB fails | ns avg  p50  p99.9 p99.99\n", "");
+    for (int k = 0; k < ALLOC_COUNT; k++) {
+        result_t *r = &res[k];
+        char frag[32] = "-", big[16] = "-";
+        if (k == ALLOC_HEAP) {
+            snprintf(frag, sizeof(frag), "%5.1f%% / %5.1f%%", 100.0 * r->frag_sum / r->samples, 100.0 * r->frag_max);
+            snprintf(big, sizeof(big), "%u/%u", r->big_failed, r->samples);
+        } else if (k == ALLOC_POOL) {
+            snprintf(frag, sizeof(frag), "0 (fixed blocks)");
+            snprintf(big, sizeof(big), "0 (static)");
+        }
+        printf("  %-12s | %9llu | %8llu | %-16s | %-10s | %6.1f %4u %6u %6u\n", alloc_names[k],
+               (unsigned long long)r->requests, (unsigned long long)r->refused, frag, big,
+               r->ns_total / r->timed, percentile(r, 0.5), percentile(r, 0.999), percentile(r, 0.9999));
+    }
+    printf("  heap model: largest free block never below %u B\n", res[ALLOC_HEAP].largest_min);
+    printf("  (heap model and pools share %u B: pools + one %d B buffer; timings include ~20 ns clock overhead)\n",
+           (unsigned)res[ALLOC_POOL].peak_bytes + STRESS_BIG_BYTES, STRESS_BIG_BYTES);
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
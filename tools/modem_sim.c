@@ -0,0 +1,442 @@
+/**
+ * @file modem_sim.c
+ * @brief Host test of the AT engine against a scripted fake modem
+ * @details
+ * Runs src/at_engine.c on a virtual microsecond clock. The fake modem sits
+ * behind the UART write hook: it parses the command lines the engine sends
+ * and answers after its processing delay plus the 115200 baud wire time of
+ * both directions (~87 us per byte). Checks:
+ * - 2000 mixed commands (queries, errors, '>' payloads, publishes that
+ *   complete on +CMQTTPUB after OK) with random URCs interleaved: every
+ *   command completes with the expected result, every URC is dispatched;
+ * - a 300-byte +CMQTTRXPAYLOAD block wrapping the RX ring in raw mode;
+ * - late OK and late ERROR after a timeout: dropped during the resync,
+ *   the next command completes on its own answer;
+ * - a lost sync reply: the marker is sent again;
+ * then reports throughput (commands/s) and latency on the virtual clock,
+ * and ns / TSC ticks per tokenized line on the host.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude tools/modem_sim.c src/at_engine.c -o modem_sim
+ *   ./modem_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "at_engine.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define BYTE_US         87          // 115200 8N1
+#define STEP_US         500         // Modem task poll granularity
+#define MAX_EVENTS      64
+#define EVENT_MAX_LEN   400
+#define MIXED_CMDS      2000
+#define RX_BLOCK_LEN    300
+#define BENCH_LINES     (1 << 20)
+
+/**
+ * @brief Bytes the fake modem will put on the wire at a given time
+ */
+typedef struct {
+    int64_t at_us;
+    uint16_t len;
+    uint8_t data[EVENT_MAX_LEN];
+} sim_event_t;
+
+/**
+ * @brief Fake modem
+ */
+typedef struct {
+    char line[AT_CMD_MAX_LEN + 8];
+    size_t line_len;
+    size_t payload_left;        // '>' sent, waiting for this many bytes
+    sim_event_t ev[MAX_EVENTS];
+    int ev_count;
+    int64_t now;                // Virtual clock
+    int64_t late_us;            // Answer the next command this late (0 = normal)
+    const char *late_result;    // ... with this final result
+    bool drop_sync;             // Swallow the next AT_SYNC_CMD
+    uint32_t sync_seen;
+} sim_modem_t;
+
+/**
+ * @brief Per-command expectation
+ */
+typedef struct {
+    at_result_t expect;
+    int done;                   // Completions (must end at 1)
+    bool ok;                    // Result as expected
+    int lines;                  // Matched response lines
+} sim_cmd_t;
+
+static sim_modem_t modem;
+static at_engine_t eng;
+static uint32_t rng_state = 12345;
+static int failures = 0;
+static uint32_t urcs_seen = 0;
+static uint32_t raw_bytes = 0;
+static bool raw_ok = true;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) % n;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+/**
+ * @brief Queue modem output `delay_us` after the command arrived, behind anything already queued
+ */
+static void modem_say(int64_t delay_us, const void *data, size_t len) {
+    if (modem.ev_count >= MAX_EVENTS || len > EVENT_MAX_LEN) return;
+
+    int64_t at = modem.now + delay_us;
+    if (modem.ev_count > 0) {
+        const sim_event_t *last = &modem.ev[modem.ev_count - 1];
+        int64_t busy = last->at_us + (int64_t)last->len * BYTE_US;
+        if (at < busy) at = busy;
+    }
+    sim_event_t *e = &modem.ev[modem.ev_count++];
+    e->at_us = at;
+    e->len = (uint16_t)len;
+    memcpy(e->data, data, len);
+}
+
+static void modem_says(int64_t delay_us, const char *text) {
+    modem_say(delay_us, text, strlen(text));
+}
+
+static void modem_command(const char *cmd) {
+    // Command bytes have crossed the wire before the modem sees the line
+    int64_t wire = (int64_t)(strlen(cmd) + 1) * BYTE_US;
+    int64_t proc = wire + 2000 + rnd(8000);
+
+    if (strcmp(cmd, AT_SYNC_CMD) == 0) {
+        modem.sync_seen++;
+        if (modem.drop_sync) {
+            modem.drop_sync = false;
+            return;
+        }
+        modem_says(proc, "\r\n" AT_SYNC_REPLY "\r\n\r\nOK\r\n");
+        return;
+    }
+    if (modem.late_us > 0) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "\r\n%s\r\n", modem.late_result);
+        modem_says(modem.late_us, buf);
+        modem.late_us = 0;
+        return;
+    }
+    if (strcmp(cmd, "AT+CSQ") == 0) {
+        modem_says(proc, "\r\n+CSQ: 20,99\r\n\r\nOK\r\n");
+    } else if (strcmp(cmd, "AT+FAIL") == 0) {
+        modem_says(proc, "\r\n+CME ERROR: 3\r\n");
+    } else if (strncmp(cmd, "AT+CMQTTPAYLOAD=0,", 18) == 0) {
+        int n = 0;
+        sscanf(cmd + 18, "%d", &n);
+        modem.payload_left = (size_t)n;
+        modem_says(proc, "\r\n>");
+    } else if (strncmp(cmd, "AT+CMQTTPUB=", 12) == 0) {
+        modem_says(proc, "\r\nOK\r\n");
+        modem_says(20000 + rnd(60000), "\r\n+CMQTTPUB: 0,0\r\n");    // PUBACK round trip
+    } else {
+        modem_says(proc, "\r\nOK\r\n");
+    }
+}
+
+static size_t modem_write(const uint8_t *data, size_t len, void *io_ctx) {
+    (void)io_ctx;
+    for (size_t i = 0; i < len; i++) {
+        if (modem.payload_left > 0) {
+            if (--modem.payload_left == 0) modem_says(2000, "\r\nOK\r\n");
+            continue;
+        }
+        if (data[i] == '\r') {
+            modem.line[modem.line_len] = '\0';
+            modem_command(modem.line);
+            modem.line_len = 0;
+        } else if (modem.line_len < sizeof(modem.line) - 1) {
+            modem.line[modem.line_len++] = (char)data[i];
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Advance the virtual clock: deliver due bytes, poll the engine
+ */
+static void run_until(int64_t end_us) {
+    while (modem.now < end_us) {
+        modem.now += STEP_US;
+        int n = 0;
+        while (n < modem.ev_count && modem.ev[n].at_us <= modem.now) {
+            at_engine_feed(&eng, modem.ev[n].data, modem.ev[n].len);
+            n++;
+        }
+        if (n > 0) {
+            memmove(&modem.ev[0], &modem.ev[n], (size_t)(modem.ev_count - n) * sizeof(sim_event_t));
+            modem.ev_count -= n;
+        }
+        at_engine_poll(&eng, modem.now);
+    }
+}
+
+static bool run_until_idle(int64_t limit_us) {
+    int64_t end = modem.now + limit_us;
+    while (modem.now < end) {
+        run_until(modem.now + STEP_US);
+        if (!at_engine_busy(&eng) && modem.ev_count == 0) return true;
+    }
+    return false;
+}
+
+static void on_done(at_result_t result, void *ctx) {
+    sim_cmd_t *c = ctx;
+    c->done++;
+    c->ok = (result == c->expect);
+}
+
+static void on_line(const at_span_t *line, void *ctx) {
+    (void)line;
+    ((sim_cmd_t *)ctx)->lines++;
+}
+
+static void on_urc(const at_span_t *line, void *ctx) {
+    (void)line;
+    (void)ctx;
+    urcs_seen++;
+}
+
+static void on_raw(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx) {
+    (void)total;
+    (void)ctx;
+    for (size_t i = 0; i < len; i++) {
+        if (data[i] != (uint8_t)(offset + i)) raw_ok = false;
+    }
+    raw_bytes += (uint32_t)len;
+}
+
+static void on_rx_payload(const at_span_t *line, void *ctx) {
+    int32_t len;
+    (void)ctx;
+    if (at_span_get_int(line, 1, &len)) at_engine_expect_raw(&eng, (size_t)len, on_raw, NULL);
+}
+
+static void sim_reset(void) {
+    memset(&modem, 0, sizeof(modem));
+    at_engine_init(&eng, modem_write, NULL);
+    at_engine_register_urc(&eng, "+CREG:", on_urc, NULL);
+    at_engine_register_urc(&eng, "+CMQTTRXPAYLOAD:", on_rx_payload, NULL);
+}
+
+static bool submit(sim_cmd_t *c, const char *text, at_result_t expect) {
+    at_cmd_t cmd = {0};
+    strncpy(cmd.cmd, text, sizeof(cmd.cmd) - 1);
+    cmd.on_done = on_done;
+    cmd.ctx = c;
+    memset(c, 0, sizeof(*c));
+    c->expect = expect;
+    return at_engine_submit(&eng, &cmd);
+}
+
+// --- SCENARIOS ---
+
+static void test_mixed(void) {
+    static sim_cmd_t cmds[MIXED_CMDS];
+    static uint8_t payload[200];
+    uint32_t urcs_sent = 0;
+    int next = 0;
+
+    printf("Mixed traffic, %d commands with URCs:\n", MIXED_CMDS);
+    sim_reset();
+    for (size_t i = 0; i < sizeof(payload); i++) payload[i] = (uint8_t)('a' + i % 26);
+
+    int64_t t0 = modem.now;
+    while (next < MIXED_CMDS || at_engine_busy(&eng)) {
+        // Keep the queue topped up like the modem task does
+        while (next < MIXED_CMDS && eng.q_count < AT_CMD_QUEUE_LEN) {
+            sim_cmd_t *c = &cmds[next];
+            at_cmd_t cmd = {0};
+            memset(c, 0, sizeof(*c));
+            c->expect = AT_RESULT_OK;
+            cmd.on_done = on_done;
+            cmd.on_line = on_line;
+            cmd.ctx = c;
+
+            switch (rnd(4)) {
+                case 0:
+                    strcpy(cmd.cmd, "AT+CSQ");
+                    cmd.match = "+CSQ:";
+                    break;
+                case 1:
+                    strcpy(cmd.cmd, "AT+FAIL");
+                    c->expect = AT_RESULT_ERROR;
+                    break;
+                case 2:
+                    snprintf(cmd.cmd, sizeof(cmd.cmd), "AT+CMQTTPAYLOAD=0,%u", (unsigned)sizeof(payload));
+                    cmd.data = payload;
+                    cmd.data_len = sizeof(payload);
+                    break;
+                default:
+                    strcpy(cmd.cmd, "AT+CMQTTPUB=0,1,60");
+                    cmd.done_prefix = "+CMQTTPUB:";
+                    cmd.timeout_ms = 10000;
+                    break;
+            }
+            at_engine_submit(&eng, &cmd);
+            next++;
+        }
+        if (rnd(40) == 0) {
+            modem_says(rnd(3000), "\r\n+CREG: 1\r\n");
+            urcs_sent++;
+        }
+        run_until(modem.now + STEP_US);
+        if (modem.now - t0 > 3600LL * 1000000) break;
+    }
+    run_until_idle(1000000);
+    double secs = (modem.now - t0) * 1e-6;
+
+    int once = 1, expected = 1, csq = 1;
+    for (int i = 0; i < MIXED_CMDS; i++) {
+        if (cmds[i].done != 1) once = 0;
+        if (!cmds[i].ok) expected = 0;
+    }
+    for (int i = 0; i < MIXED_CMDS; i++) {
+        if (cmds[i].lines > 1) csq = 0;
+    }
+    const at_stats_t *s = &eng.stats;
+
+    check("every command completed exactly once", once);
+    check("every result as scripted (OK / ERROR)", expected);
+    check("+CSQ response passed to on_line once", csq);
+    check("every URC dispatched", urcs_seen == urcs_sent);
+    check("no timeout, no resync, no RX overflow", s->cmds_timeout == 0 && s->resyncs == 0 && s->rx_overflows == 0);
+    check("no unhandled line", s->unhandled == 0);
+
+    uint32_t done = s->cmds_ok + s->cmds_error;
+    printf("  %u commands in %.1f s virtual: %.1f cmd/s, %u URCs, %u RX bytes\n", (unsigned)done, secs,
+           done / secs, (unsigned)urcs_sent, (unsigned)s->rx_bytes);
+    printf("  latency mean %.1f ms, max %.1f ms (115200 baud, 2-10 ms modem, PUBACK 20-80 ms)\n",
+           s->latency_total_us / 1000.0 / done, s->latency_max_us / 1000.0);
+}
+
+static void test_raw_block(void) {
+    uint8_t block[RX_BLOCK_LEN];
+    char head[48];
+
+    printf("\nRaw block across the ring wrap:\n");
+    sim_reset();
+    for (int i = 0; i < RX_BLOCK_LEN; i++) block[i] = (uint8_t)i;
+
+    // Park the ring indices just short of the wrap
+    eng.head = eng.tail = eng.scan = AT_RX_RING_SIZE - 100;
+    raw_bytes = 0;
+    raw_ok = true;
+
+    snprintf(head, sizeof(head), "\r\n+CMQTTRXPAYLOAD: 0,%d\r\n", RX_BLOCK_LEN);
+    modem_says(1000, head);
+    modem_say(1000, block, sizeof(block));
+    modem_says(1000, "\r\n+CREG: 1\r\n");
+    urcs_seen = 0;
+    run_until(modem.now + 100000);
+
+    check("all block bytes delivered, in order", raw_bytes == RX_BLOCK_LEN && raw_ok);
+    check("line after the block tokenized again", urcs_seen == 1);
+}
+
+static void test_late_result(const char *result) {
+    sim_cmd_t a, b, c;
+    char what[64];
+
+    printf("\nLate %s after a timeout:\n", result);
+    sim_reset();
+
+    // A is answered 1.2 s late, after its 1 s timeout and after B has been queued
+    modem.late_us = 1200000;
+    modem.late_result = result;
+    submit(&a, "AT+SLOW", AT_RESULT_TIMEOUT);
+    submit(&b, "AT+FAIL", AT_RESULT_ERROR);
+    submit(&c, "AT+CSQ", AT_RESULT_OK);
+    bool idle = run_until_idle(5000000);
+
+    check("A timed out once", a.done == 1 && a.ok);
+    snprintf(what, sizeof(what), "late %s dropped (stale_results = 1)", result);
+    check(what, eng.stats.stale_results == 1);
+    check("B completed on its own answer (ERROR)", b.done == 1 && b.ok);
+    check("C completed on its own answer (OK)", c.done == 1 && c.ok);
+    check("one sync marker, engine idle", eng.stats.resyncs == 1 && modem.sync_seen == 1 && idle);
+}
+
+static void test_lost_sync(void) {
+    sim_cmd_t a, b;
+
+    printf("\nSync reply lost:\n");
+    sim_reset();
+    modem.late_us = 1500000;
+    modem.late_result = "OK";
+    modem.drop_sync = true;
+    submit(&a, "AT+SLOW", AT_RESULT_TIMEOUT);
+    submit(&b, "AT+CSQ", AT_RESULT_OK);
+    bool idle = run_until_idle(5000000);
+
+    check("marker sent again after AT_SYNC_TIMEOUT_MS", eng.stats.resyncs == 2 && modem.sync_seen == 2);
+    check("late OK dropped, B completed on its own answer", eng.stats.stale_results == 1 && b.done == 1 && b.ok);
+    check("engine idle", idle);
+}
+
+static void bench_lines(void) {
+    static const char text[] = "\r\n+CREG: 1\r\n";
+    const size_t n = sizeof(text) - 1;
+
+    sim_reset();
+    double t0 = now_ns();
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int i = 0; i < BENCH_LINES; i++) {
+        at_engine_feed(&eng, (const uint8_t *)text, n);
+        at_engine_poll(&eng, 0);
+    }
+#ifdef HAVE_TSC
+    uint64_t c1 = __rdtsc();
+#endif
+    double ns = (now_ns() - t0) / BENCH_LINES;
+
+    printf("\nCost per URC line, feed + tokenize + dispatch (%d lines, host):\n", BENCH_LINES);
+#ifdef HAVE_TSC
+    printf("  %6.2f ns  %6.1f TSC ticks\n", ns, (double)(c1 - c0) / BENCH_LINES);
+#else
+    printf("  %6.2f ns\n", ns);
+#endif
+}
+
+int main(void) {
+    test_mixed();
+    test_raw_block();
+    test_late_result("OK");
+    test_late_result("ERROR");
+    test_lost_sync();
+    bench_lines();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
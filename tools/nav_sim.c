@@ -0,0 +1,426 @@
+/**
+ * @file nav_sim.c
+ * @brief Host test and benchmark of the ENU waypoint navigator vs haversine
+ * @details
+ * Mission around 47.3977 N, 8.5456 E (home = origin). Accuracy reference:
+ * WGS84 geodesics in double precision (Vincenty inverse). Cost baseline:
+ * the spherical formulas a naive navigator would evaluate every tick in
+ * double (haversine distance, initial bearing, great-circle cross-track,
+ * crossing-number fence on lat/lon). Checks:
+ * - distance / bearing / cross-track of nav_update() against the
+ *   reference for random positions within 2 km (mission scale) and
+ *   10 km of home: distance < 0.05% / 0.2%, bearing < 0.05 / 0.15 deg,
+ *   cross-track < 1 / 25 m (a straight ENU leg is not a geodesic);
+ * - nav_geo_project() / nav_geo_unproject() round trip within 1e-7 deg;
+ * - leg sequencing: a craft steered along the legs reaches every
+ *   waypoint in order, return-to-home replaces the route;
+ * - geofence grid index agrees with the plain crossing-number test on
+ *   random points (concave polygon, points near edges included);
+ * then reports ns and TSC ticks per tick for nav_update() (+ fence) and
+ * for the naive haversine / bearing / cross-track / lat-lon fence tick.
+ * The S3 has no double FPU, so the target ratio is larger than on the host.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude tools/nav_sim.c src/nav_waypoint.c src/nav_geo.c -lm -o nav_sim
+ *   ./nav_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "nav_waypoint.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define HOME_LAT_E7     473977000
+#define HOME_LON_E7     85456000
+#define EARTH_R_M       6371008.8   // Mean radius for the spherical baseline
+#define ACCURACY_PTS    20000
+#define FENCE_PTS       200000
+#define BENCH_TICKS     (1 << 21)
+
+#define DEG             (M_PI / 180.0)
+#define E7              1e-7
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// Route and fence (lat, lon e7): ~1.5 km loop and a concave fence around it
+static const int32_t ROUTE[][2] = {
+    { 473997000, 85456000 }, { 474040000, 85510000 }, { 474010000, 85590000 },
+    { 473960000, 85560000 }, { 473940000, 85480000 },
+};
+static const int32_t FENCE[][2] = {
+    { 473900000, 85400000 }, { 474080000, 85400000 }, { 474080000, 85520000 },
+    { 474030000, 85540000 }, { 474080000, 85650000 }, { 473900000, 85650000 },
+};
+
+#define ROUTE_LEN       (int)(sizeof(ROUTE) / sizeof(ROUTE[0]))
+#define FENCE_LEN       (int)(sizeof(FENCE) / sizeof(FENCE[0]))
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double uniform(double lo, double hi) {
+    return lo + (hi - lo) * (rnd() / 16777216.0);
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static double wrap180(double d) {
+    while (d > 180.0) d -= 360.0;
+    while (d < -180.0) d += 360.0;
+    return d;
+}
+
+/**
+ * @brief Great-circle distance (m)
+ */
+static double haversine_m(double lat1, double lon1, double lat2, double lon2) {
+    double dlat = (lat2 - lat1) * DEG, dlon = (lon2 - lon1) * DEG;
+    double a = sin(dlat / 2) * sin(dlat / 2) + cos(lat1 * DEG) * cos(lat2 * DEG) * sin(dlon / 2) * sin(dlon / 2);
+    return 2.0 * EARTH_R_M * atan2(sqrt(a), sqrt(1.0 - a));
+}
+
+/**
+ * @brief Initial great-circle bearing (deg, 0..360)
+ */
+static double bearing_deg(double lat1, double lon1, double lat2, double lon2) {
+    double p1 = lat1 * DEG, p2 = lat2 * DEG, dl = (lon2 - lon1) * DEG;
+    double b = atan2(sin(dl) * cos(p2), cos(p1) * sin(p2) - sin(p1) * cos(p2) * cos(dl)) / DEG;
+    return (b < 0.0) ? b + 360.0 : b;
+}
+
+/**
+ * @brief Great-circle cross-track distance of p from the path a -> b (m, + = right)
+ */
+static double cross_track_m(double lat_a, double lon_a, double lat_b, double lon_b, double lat_p, double lon_p) {
+    double d13 = haversine_m(lat_a, lon_a, lat_p, lon_p) / EARTH_R_M;
+    double t13 = bearing_deg(lat_a, lon_a, lat_p, lon_p) * DEG;
+    double t12 = bearing_deg(lat_a, lon_a, lat_b, lon_b) * DEG;
+    return asin(sin(d13) * sin(t13 - t12)) * EARTH_R_M;
+}
+
+/**
+ * @brief WGS84 geodesic distance and initial azimuth (Vincenty inverse)
+ */
+static void vincenty(double lat1, double lon1, double lat2, double lon2, double *dist_m, double *az_deg) {
+    const double a = NAV_WGS84_A, f = 1.0 / 298.257223563, b = a * (1.0 - f);
+    double L = (lon2 - lon1) * DEG;
+    double U1 = atan((1.0 - f) * tan(lat1 * DEG)), U2 = atan((1.0 - f) * tan(lat2 * DEG));
+    double sU1 = sin(U1), cU1 = cos(U1), sU2 = sin(U2), cU2 = cos(U2);
+    double lambda = L, sin_s = 0.0, cos_s = 1.0, sigma = 0.0, cos2a = 1.0, cos2sm = 0.0;
+
+    for (int it = 0; it < 100; it++) {
+        double sl = sin(lambda), cl = cos(lambda);
+        sin_s = sqrt((cU2 * sl) * (cU2 * sl) + (cU1 * sU2 - sU1 * cU2 * cl) * (cU1 * sU2 - sU1 * cU2 * cl));
+        if (sin_s == 0.0) break;
+        cos_s = sU1 * sU2 + cU1 * cU2 * cl;
+        sigma = atan2(sin_s, cos_s);
+        double sin_a = cU1 * cU2 * sl / sin_s;
+        cos2a = 1.0 - sin_a * sin_a;
+        cos2sm = (cos2a != 0.0) ? cos_s - 2.0 * sU1 * sU2 / cos2a : 0.0;
+        double C = f / 16.0 * cos2a * (4.0 + f * (4.0 - 3.0 * cos2a));
+        double prev = lambda;
+        lambda = L + (1.0 - C) * f * sin_a *
+                 (sigma + C * sin_s * (cos2sm + C * cos_s * (-1.0 + 2.0 * cos2sm * cos2sm)));
+        if (fabs(lambda - prev) < 1e-13) break;
+    }
+
+    double u2 = cos2a * (a * a - b * b) / (b * b);
+    double A = 1.0 + u2 / 16384.0 * (4096.0 + u2 * (-768.0 + u2 * (320.0 - 175.0 * u2)));
+    double B = u2 / 1024.0 * (256.0 + u2 * (-128.0 + u2 * (74.0 - 47.0 * u2)));
+    double ds = B * sin_s * (cos2sm + B / 4.0 * (cos_s * (-1.0 + 2.0 * cos2sm * cos2sm) -
+                B / 6.0 * cos2sm * (-3.0 + 4.0 * sin_s * sin_s) * (-3.0 + 4.0 * cos2sm * cos2sm)));
+    *dist_m = b * A * (sigma - ds);
+
+    double az = atan2(cU2 * sin(lambda), cU1 * sU2 - sU1 * cU2 * cos(lambda)) / DEG;
+    *az_deg = (az < 0.0) ? az + 360.0 : az;
+}
+
+/**
+ * @brief Crossing-number test directly on lat/lon (naive fence)
+ */
+static bool fence_latlon(double lat, double lon) {
+    bool inside = false;
+    for (int i = 0, j = FENCE_LEN - 1; i < FENCE_LEN; j = i++) {
+        double ai = FENCE[i][0] * E7, bi = FENCE[i][1] * E7;
+        double aj = FENCE[j][0] * E7, bj = FENCE[j][1] * E7;
+        if ((ai > lat) != (aj > lat)) {
+            double x = bi + (lat - ai) * (bj - bi) / (aj - ai);
+            if (lon < x) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+/**
+ * @brief Crossing-number test on the projected fence (no grid)
+ */
+static bool fence_plain(const nav_fence_t *f, nav_enu_t p) {
+    bool inside = false;
+    for (int i = 0, j = f->count - 1; i < f->count; j = i++) {
+        const nav_enu_t *a = &f->verts[i], *b = &f->verts[j];
+        if ((a->n > p.n) != (b->n > p.n)) {
+            float x = a->e + (p.n - a->n) * (b->e - a->e) / (b->n - a->n);
+            if (p.e < x) inside = !inside;
+        }
+    }
+    return inside;
+}
+
+static void load_mission(nav_mission_t *m) {
+    int32_t lat[FENCE_LEN], lon[FENCE_LEN];
+    nav_mission_init(m, HOME_LAT_E7, HOME_LON_E7);
+    for (int i = 0; i < ROUTE_LEN; i++) nav_mission_add_waypoint(m, ROUTE[i][0], ROUTE[i][1]);
+    for (int i = 0; i < FENCE_LEN; i++) {
+        lat[i] = FENCE[i][0];
+        lon[i] = FENCE[i][1];
+    }
+    nav_mission_set_fence(m, lat, lon, FENCE_LEN);
+}
+
+/**
+ * @brief Random point within radius_m of home (lat/lon e7)
+ */
+static void random_point(double radius_m, int32_t *lat_e7, int32_t *lon_e7) {
+    double r = radius_m * sqrt(uniform(0.0, 1.0)), a = uniform(0.0, 2 * M_PI);
+    double dlat = r * cos(a) / EARTH_R_M / DEG;
+    double dlon = r * sin(a) / (EARTH_R_M * cos(HOME_LAT_E7 * E7 * DEG)) / DEG;
+    *lat_e7 = HOME_LAT_E7 + (int32_t)lround(dlat / E7);
+    *lon_e7 = HOME_LON_E7 + (int32_t)lround(dlon / E7);
+}
+
+// --- SCENARIOS ---
+
+static void accuracy(double radius_m, double max_rel, double max_brg, double max_xt) {
+    nav_mission_t m;
+    double rel = 0.0, brg = 0.0, xt = 0.0;
+    char what[96];
+
+    for (int i = 0; i < ACCURACY_PTS; i++) {
+        int32_t tlat, tlon, plat, plon;
+        random_point(radius_m, &tlat, &tlon);
+        random_point(radius_m, &plat, &plon);
+
+        // Single leg home -> target, position p
+        nav_mission_init(&m, HOME_LAT_E7, HOME_LON_E7);
+        nav_mission_add_waypoint(&m, tlat, tlon);
+        m.accept_radius_m = 0.0f;
+        nav_status_t st;
+        nav_update(&m, nav_mission_project(&m, plat, plon), &st);
+
+        double ref_d, ref_b, d13, az13, d12, az12;
+        vincenty(plat * E7, plon * E7, tlat * E7, tlon * E7, &ref_d, &ref_b);
+        if (ref_d < 50.0) continue;     // Bearing ill-defined at short range
+
+        // Cross-track: geodesic home -> p against home -> target (planar at these ranges)
+        vincenty(HOME_LAT_E7 * E7, HOME_LON_E7 * E7, plat * E7, plon * E7, &d13, &az13);
+        vincenty(HOME_LAT_E7 * E7, HOME_LON_E7 * E7, tlat * E7, tlon * E7, &d12, &az12);
+        double ref_x = d13 * sin((az13 - az12) * DEG);
+
+        double e = fabs(st.dist_to_wp_m - ref_d) / ref_d;
+        if (e > rel) rel = e;
+        e = fabs(wrap180(st.bearing_to_wp_deg - ref_b));
+        if (e > brg) brg = e;
+        e = fabs(st.cross_track_m - ref_x);
+        if (e > xt) xt = e;
+    }
+
+    snprintf(what, sizeof(what), "%5.0f m: distance error max %.3f%%", radius_m, rel * 100.0);
+    check(what, rel < max_rel);
+    snprintf(what, sizeof(what), "%5.0f m: bearing error max %.3f deg", radius_m, brg);
+    check(what, brg < max_brg);
+    snprintf(what, sizeof(what), "%5.0f m: cross-track error max %.2f m", radius_m, xt);
+    check(what, xt < max_xt);
+}
+
+static void test_accuracy(void) {
+    printf("\nENU vs WGS84 geodesic reference (%d random legs)\n", ACCURACY_PTS);
+    // Longitude scale is frozen at home: errors grow with the square of the range
+    accuracy(2000.0, 0.0005, 0.05, 1.0);
+    accuracy(10000.0, 0.002, 0.15, 25.0);
+
+    nav_origin_t o;
+    nav_geo_set_origin(&o, HOME_LAT_E7, HOME_LON_E7);
+    int32_t worst = 0;
+    for (int i = 0; i < ACCURACY_PTS; i++) {
+        int32_t lat, lon, lat2, lon2;
+        float e, n;
+        random_point(5000.0, &lat, &lon);
+        nav_geo_project(&o, lat, lon, &e, &n);
+        nav_geo_unproject(&o, e, n, &lat2, &lon2);
+        int32_t d = abs(lat2 - lat) > abs(lon2 - lon) ? abs(lat2 - lat) : abs(lon2 - lon);
+        if (d > worst) worst = d;
+    }
+    char what[96];
+    snprintf(what, sizeof(what), "project/unproject round trip within 5 km: %ld e-7 deg", (long)worst);
+    check(what, worst <= 1);
+}
+
+static void test_sequencing(void) {
+    printf("\nLeg sequencing\n");
+    nav_mission_t m;
+    load_mission(&m);
+
+    // Point-mass craft at 6 m/s steering to the active waypoint (10 Hz)
+    nav_enu_t pos = { 0.0f, 0.0f };
+    nav_status_t st;
+    int reached[NAV_MAX_WAYPOINTS] = { 0 };
+    int order_ok = 1, ticks = 0, fence_breach = 0;
+    float max_xt = 0.0f;
+
+    for (ticks = 0; ticks < 20000; ticks++) {
+        nav_update(&m, pos, &st);
+        if (!st.inside_fence) fence_breach++;
+        if (st.wp_reached) {
+            int leg = st.leg - 1;
+            if (leg < 0 || reached[leg]) order_ok = 0;
+            for (int k = 0; k < leg; k++) if (!reached[k]) order_ok = 0;
+            if (leg >= 0) reached[leg] = 1;
+        }
+        if (st.mission_done) break;
+        if (fabsf(st.cross_track_m) > max_xt) max_xt = fabsf(st.cross_track_m);
+
+        float b = st.bearing_to_wp_deg * (float)DEG;
+        pos.e += 0.6f * sinf(b);
+        pos.n += 0.6f * cosf(b);
+    }
+
+    int all = 1;
+    for (int k = 0; k < ROUTE_LEN; k++) all &= reached[k];
+    char what[96];
+    snprintf(what, sizeof(what), "%d waypoints reached in order in %.0f s", ROUTE_LEN, ticks * 0.1);
+    check(what, all && order_ok && st.mission_done);
+    // Each leg starts where the previous waypoint was accepted (up to the radius off its line)
+    snprintf(what, sizeof(what), "cross-track while steering to the waypoint: max %.2f m", max_xt);
+    check(what, max_xt < NAV_ACCEPT_RADIUS_M);
+    check("route stays inside the fence", fence_breach == 0);
+
+    nav_mission_return_home(&m, pos);
+    nav_update(&m, pos, &st);
+    float d = sqrtf(pos.e * pos.e + pos.n * pos.n);
+    check("return home: single leg, distance to home",
+          m.leg_count == 1 && st.leg == 0 && !st.mission_done && fabsf(st.dist_to_wp_m - d) < 0.01f);
+}
+
+static void test_fence(void) {
+    printf("\nGeofence grid index (%d random points)\n", FENCE_PTS);
+    nav_mission_t m;
+    load_mission(&m);
+    const nav_fence_t *f = &m.fence;
+
+    int mismatch = 0, edge = 0, inside = 0;
+    float span_e = 1.2f * (f->verts[4].e - f->min_e);
+    float span_n = 1.2f * (f->verts[1].n - f->min_n);
+    for (int i = 0; i < FENCE_PTS; i++) {
+        nav_enu_t p;
+        if (i & 1) {
+            // Near a random edge
+            int k = (int)(rnd() % f->count);
+            const nav_enu_t *a = &f->verts[k], *b = &f->verts[(k + 1) % f->count];
+            float t = (float)uniform(0.0, 1.0);
+            p.e = a->e + t * (b->e - a->e) + (float)uniform(-2.0, 2.0);
+            p.n = a->n + t * (b->n - a->n) + (float)uniform(-2.0, 2.0);
+        } else {
+            p.e = f->min_e - 0.1f * span_e + (float)uniform(0.0, span_e);
+            p.n = f->min_n - 0.1f * span_n + (float)uniform(0.0, span_n);
+        }
+        bool got = nav_fence_contains(f, p);
+        if (got != fence_plain(f, p)) mismatch++;
+        if (got) inside++;
+    }
+    for (int c = 0; c < NAV_FENCE_GRID * NAV_FENCE_GRID; c++) edge += (f->cells[c] == NAV_CELL_EDGE);
+
+    char what[96];
+    snprintf(what, sizeof(what), "grid vs plain test: %d mismatches (%d inside)", mismatch, inside);
+    check(what, mismatch == 0);
+    printf("  EDGE cells needing the exact test: %d of %d\n", edge, NAV_FENCE_GRID * NAV_FENCE_GRID);
+}
+
+static void bench(void) {
+    static int32_t pts[1024][2];
+    static nav_enu_t enu[1024];
+    nav_mission_t m;
+    load_mission(&m);
+    for (int i = 0; i < 1024; i++) {
+        random_point(1500.0, &pts[i][0], &pts[i][1]);
+        enu[i] = nav_mission_project(&m, pts[i][0], pts[i][1]);
+    }
+
+    printf("\nCost per navigation tick (host):\n");
+    const char *label[4] = {"ENU nav_update", "ENU + fence", "ENU + project", "haversine naive"};
+    volatile double sink = 0.0;
+    double ns_enu = 0.0, ns_naive = 0.0;
+
+    for (int mode = 0; mode < 4; mode++) {
+        m.has_fence = (mode != 0);
+        const double lat_a = HOME_LAT_E7 * E7, lon_a = HOME_LON_E7 * E7;
+        const double lat_b = ROUTE[0][0] * E7, lon_b = ROUTE[0][1] * E7;
+        double t0 = now_ns();
+#ifdef HAVE_TSC
+        uint64_t c0 = __rdtsc();
+#endif
+        for (int i = 0; i < BENCH_TICKS; i++) {
+            nav_status_t st;
+            const int k = i & 1023;
+            if (mode < 3) {
+                m.active_leg = 0;
+                nav_enu_t p = (mode == 2) ? nav_mission_project(&m, pts[k][0], pts[k][1]) : enu[k];
+                nav_update(&m, p, &st);
+                sink += st.dist_to_wp_m + st.cross_track_m + st.bearing_to_wp_deg + st.inside_fence;
+            } else {
+                double lat = pts[k][0] * E7, lon = pts[k][1] * E7;
+                sink += haversine_m(lat, lon, lat_b, lon_b) + bearing_deg(lat, lon, lat_b, lon_b) +
+                        cross_track_m(lat_a, lon_a, lat_b, lon_b, lat, lon) + fence_latlon(lat, lon);
+            }
+        }
+#ifdef HAVE_TSC
+        uint64_t c1 = __rdtsc();
+#endif
+        double ns = (now_ns() - t0) / BENCH_TICKS;
+        if (mode == 2) ns_enu = ns;
+        if (mode == 3) ns_naive = ns;
+#ifdef HAVE_TSC
+        printf("  %-16s %7.2f ns  %7.1f TSC ticks\n", label[mode], ns, (double)(c1 - c0) / BENCH_TICKS);
+#else
+        printf("  %-16s %7.2f ns\n", label[mode], ns);
+#endif
+    }
+    (void)sink;
+
+    char what[96];
+    snprintf(what, sizeof(what), "ENU tick (project + update + fence) %.1fx cheaper", ns_naive / ns_enu);
+    check(what, ns_enu < ns_naive);
+}
+
+int main(void) {
+    printf("Waypoint navigator test (home %.4f N, %.4f E)\n", HOME_LAT_E7 * E7, HOME_LON_E7 * E7);
+    test_accuracy();
+    test_sequencing();
+    test_fence();
+    bench();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,388 @@
+#!/usr/bin/env python3
+"""
+Make signed firmware patches for sys_ota (delta OTA over LTE).
+
+Usage:
+    python3 tools/ota_mkpatch.py keygen ota_key.hex --header include/sys_ota_key.h
+    python3 tools/ota_mkpatch.py diff old.bin new.bin update.patch --key ota_key.hex
+    python3 tools/ota_mkpatch.py full new.bin update.patch --key ota_key.hex
+    python3 tools/ota_mkpatch.py info update.patch [--key ota_key.hex]
+
+old.bin must be the exact image running on the craft (the .bin of that
+build, as written to its slot); the craft checks its SHA-256 before
+applying anything. Upload the patch to any HTTP(S) server that honours
+Range requests and send "OTA <url>" on the command topic.
+
+keygen writes the private key (hex scalar, keep it off the craft) and the
+public key as include/sys_ota_key.h, which sys_ota.h picks up. Without a
+key, patches are unsigned: fine for tools/ota_patch_sim.c, refused by the
+craft.
+
+Patch format: see include/sys_ota.h. Ops are found bsdiff-style: seeds of
+SEED_LEN bytes indexed every SEED_STEP source bytes, extended forwards and
+backwards while more than half of the bytes match; a region is coded as
+COPY for runs that match exactly and ADD (byte differences) for the rest,
+which keeps relocated code (same instructions, shifted addresses) cheap.
+Unmatched target bytes become DATA. No third-party module is needed:
+SHA-256 comes from hashlib, ECDSA P-256 is implemented below.
+"""
+
+import argparse
+import hashlib
+import hmac
+import secrets
+import struct
+import sys
+
+MAGIC = 0x50445246
+FORMAT = 1
+HDR_SIGNED = 116
+SIG_BYTES = 64
+
+OP_END, OP_COPY, OP_ADD, OP_DATA = 0, 1, 2, 3
+
+SEED_LEN = 12
+SEED_STEP = 4
+MIN_SCORE = 16          # 2 * matches - length of a region worth an op
+GIVE_UP = 64            # Stop extending once the score fell this far below its best
+ZERO_RUN = 6            # Exact runs at least this long inside a region become COPY
+
+# --- ECDSA P-256 ---
+
+P = 0xFFFFFFFF00000001000000000000000000000000FFFFFFFFFFFFFFFFFFFFFFFF
+A = P - 3
+N = 0xFFFFFFFF00000000FFFFFFFFFFFFFFFFBCE6FAADA7179E84F3B9CAC2FC632551
+G = (0x6B17D1F2E12C4247F8BCE6E563A440F277037D812DEB33A0F4A13945D898C296,
+     0x4FE342E2FE1A7F9B8EE7EB4A7C0F9E162BCE33576B315ECECBB6406837BF51F5)
+
+
+def ec_add(p1, p2):
+    if p1 is None:
+        return p2
+    if p2 is None:
+        return p1
+    (x1, y1), (x2, y2) = p1, p2
+    if x1 == x2:
+        if (y1 + y2) % P == 0:
+            return None
+        lam = (3 * x1 * x1 + A) * pow(2 * y1, -1, P) % P
+    else:
+        lam = (y2 - y1) * pow(x2 - x1, -1, P) % P
+    x3 = (lam * lam - x1 - x2) % P
+    return x3, (lam * (x1 - x3) - y1) % P
+
+
+def ec_mul(k, pt):
+    acc = None
+    while k:
+        if k & 1:
+            acc = ec_add(acc, pt)
+        pt = ec_add(pt, pt)
+        k >>= 1
+    return acc
+
+
+def rfc6979_k(d, z):
+    """Deterministic nonce (RFC 6979, HMAC-SHA256)"""
+    x = d.to_bytes(32, "big")
+    h = (z % N).to_bytes(32, "big")
+    v, k = b"\x01" * 32, b"\x00" * 32
+    k = hmac.new(k, v + b"\x00" + x + h, hashlib.sha256).digest()
+    v = hmac.new(k, v, hashlib.sha256).digest()
+    k = hmac.new(k, v + b"\x01" + x + h, hashlib.sha256).digest()
+    v = hmac.new(k, v, hashlib.sha256).digest()
+    while True:
+        v = hmac.new(k, v, hashlib.sha256).digest()
+        cand = int.from_bytes(v, "big")
+        if 1 <= cand < N:
+            return cand
+        k = hmac.new(k, v + b"\x00", hashlib.sha256).digest()
+        v = hmac.new(k, v, hashlib.sha256).digest()
+
+
+def ecdsa_sign(d, digest):
+    z = int.from_bytes(digest, "big")
+    while True:
+        k = rfc6979_k(d, z)
+        r = ec_mul(k, G)[0] % N
+        s = pow(k, -1, N) * (z + r * d) % N
+        if r and s:
+            return r.to_bytes(32, "big") + s.to_bytes(32, "big")
+
+
+def ecdsa_verify(q, digest, sig):
+    r, s = int.from_bytes(sig[:32], "big"), int.from_bytes(sig[32:], "big")
+    if not (1 <= r < N and 1 <= s < N):
+        return False
+    z = int.from_bytes(digest, "big")
+    w = pow(s, -1, N)
+    pt = ec_add(ec_mul(z * w % N, G), ec_mul(r * w % N, q))
+    return pt is not None and pt[0] % N == r
+
+
+def load_key(path):
+    with open(path) as f:
+        d = int(f.read().strip(), 16)
+    if not 1 <= d < N:
+        sys.exit(f"{path}: not a P-256 private key")
+    return d
+
+
+# --- OP STREAM ---
+
+def uvar(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7F
+        v >>= 7
+        if v:
+            out.append(b | 0x80)
+        else:
+            out.append(b)
+            return out
+
+
+def svar(v):
+    return uvar((v << 1) if v >= 0 else ((-v - 1) << 1) | 1)
+
+
+def extend(old, new, t, c, limit, step):
+    """Length of the best fuzzy match from (t, c) going in direction step (+1/-1)"""
+    i = s = best = best_len = 0
+    while i < limit:
+        if step > 0 and i + 32 <= limit and new[t + i:t + i + 32] == old[c + i:c + i + 32]:
+            i += 32
+            s += 32
+        else:
+            j = i if step > 0 else -1 - i
+            if new[t + j] == old[c + j]:
+                s += 1
+            i += 1
+        score = 2 * s - i
+        if score > best:
+            best, best_len = score, i
+        elif score < best - GIVE_UP:
+            break
+    return best_len, best
+
+
+def find_regions(old, new):
+    """Greedy list of (dst_start, length, src_start) fuzzy matches"""
+    index = {}
+    for s in range(0, len(old) - SEED_LEN + 1, SEED_STEP):
+        index.setdefault(old[s:s + SEED_LEN], s)
+
+    regions = []
+    t, lit, shift = 0, 0, None
+    while t + SEED_LEN <= len(new):
+        cands = []
+        if shift is not None and 0 <= t + shift <= len(old) - 4 and new[t:t + 4] == old[t + shift:t + shift + 4]:
+            cands.append(t + shift)
+        s = index.get(new[t:t + SEED_LEN])
+        if s is not None and s - t != shift:
+            cands.append(s)
+
+        best = None
+        for c in cands:
+            length, score = extend(old, new, t, c, min(len(new) - t, len(old) - c), 1)
+            if score >= MIN_SCORE and (best is None or score > best[2]):
+                best = (c, length, score)
+        if best is None:
+            t += 1
+            continue
+
+        c, length, _ = best
+        back, _ = extend(old, new, t, c, min(t - lit, c), -1)
+        t0, c0 = t - back, c - back
+        regions.append((t0, length + back, c0))
+        t = lit = t0 + length + back
+        shift = c0 - t0
+    return regions
+
+
+def encode(old, new, regions):
+    body = bytearray()
+    pos = 0
+    t = 0
+
+    def data(a, b):
+        while a < b:
+            n = min(b - a, 1 << 20)
+            body.extend(bytes([OP_DATA]) + uvar(n) + new[a:a + n])
+            a += n
+
+    for t0, length, c0 in regions:
+        data(t, t0)
+        diff = bytes((new[t0 + i] - old[c0 + i]) & 0xFF for i in range(length))
+        i = 0
+        while i < length:
+            # Exact run -> COPY, else ADD up to the next exact run of ZERO_RUN bytes
+            j = i
+            while j < length and diff[j] == 0:
+                j += 1
+            if j - i >= ZERO_RUN or (j == length and j > i):
+                op, end = OP_COPY, j
+            else:
+                end = j
+                zeros = 0
+                while end < length:
+                    zeros = zeros + 1 if diff[end] == 0 else 0
+                    if zeros >= ZERO_RUN:
+                        end -= ZERO_RUN - 1
+                        break
+                    end += 1
+                op = OP_ADD
+            body.extend(bytes([op]) + uvar(end - i) + svar(c0 + i - pos))
+            if op == OP_ADD:
+                body.extend(diff[i:end])
+            pos = c0 + end
+            i = end
+        t = t0 + length
+    data(t, len(new))
+    body.append(OP_END)
+    return bytes(body)
+
+
+def build(old, new, body, key):
+    hdr = struct.pack("<IHHIII", MAGIC, FORMAT, 0, len(old), len(new), len(body))
+    hdr += hashlib.sha256(old).digest() + hashlib.sha256(new).digest() + hashlib.sha256(body).digest()
+    assert len(hdr) == HDR_SIGNED
+    sig = ecdsa_sign(key, hashlib.sha256(hdr).digest()) if key else bytes(SIG_BYTES)
+    return hdr + sig + body
+
+
+def apply(old, patch):
+    """Reference applier (checks the generator)"""
+    magic, fmt, _, src_size, dst_size, body_size = struct.unpack_from("<IHHIII", patch)
+    body = patch[HDR_SIGNED + SIG_BYTES:]
+    out = bytearray()
+    i = pos = 0
+
+    def rd():
+        nonlocal i
+        v = shift = 0
+        while True:
+            b = body[i]
+            i += 1
+            v |= (b & 0x7F) << shift
+            shift += 7
+            if not b & 0x80:
+                return v
+
+    while True:
+        op = body[i]
+        i += 1
+        if op == OP_END:
+            break
+        n = rd()
+        if op == OP_DATA:
+            out += body[i:i + n]
+            i += n
+            continue
+        z = rd()
+        pos += (z >> 1) if not z & 1 else -(z >> 1) - 1
+        if op == OP_COPY:
+            out += old[pos:pos + n]
+        else:
+            out += bytes((old[pos + k] + body[i + k]) & 0xFF for k in range(n))
+            i += n
+        pos += n
+    return bytes(out)
+
+
+# --- COMMANDS ---
+
+def cmd_keygen(args):
+    d = secrets.randbelow(N - 1) + 1
+    q = ec_mul(d, G)
+    with open(args.key, "w") as f:
+        f.write(f"{d:064x}\n")
+    pub = b"\x04" + q[0].to_bytes(32, "big") + q[1].to_bytes(32, "big")
+    rows = [", ".join(f"0x{b:02x}" for b in pub[i:i + 13]) for i in range(0, len(pub), 13)]
+    text = ("/**\n * @file sys_ota_key.h\n * @brief OTA patch signing public key (generated by tools/ota_mkpatch.py keygen)\n */\n\n"
+            "#ifndef SYS_OTA_KEY_H\n#define SYS_OTA_KEY_H\n\n#define OTA_SIGN_PUBKEY { \\\n    "
+            + ", \\\n    ".join(rows) + " \\\n}\n\n#endif // SYS_OTA_KEY_H\n")
+    if args.header:
+        with open(args.header, "w") as f:
+            f.write(text)
+        print(f"private key -> {args.key}, public key -> {args.header}")
+    else:
+        print(f"private key -> {args.key}\n\n{text}")
+
+
+def write_patch(args, old, new, body):
+    key = load_key(args.key) if args.key else None
+    patch = build(old, new, body, key)
+    if apply(old, patch) != new:
+        sys.exit("internal error: patch does not reproduce the new image")
+    with open(args.patch, "wb") as f:
+        f.write(patch)
+    print(f"{args.patch}: {len(patch)} bytes ({100.0 * len(patch) / len(new):.1f}% of the {len(new)} byte image)"
+          f"{'' if key else ', UNSIGNED'}")
+
+
+def cmd_diff(args):
+    old = open(args.old, "rb").read()
+    new = open(args.new, "rb").read()
+    regions = find_regions(old, new)
+    matched = sum(r[1] for r in regions)
+    print(f"{len(regions)} regions, {100.0 * matched / max(len(new), 1):.1f}% of the new image matched")
+    write_patch(args, old, new, encode(old, new, regions))
+
+
+def cmd_full(args):
+    new = open(args.new, "rb").read()
+    write_patch(args, b"", new, encode(b"", new, []))
+
+
+def cmd_info(args):
+    patch = open(args.patch, "rb").read()
+    magic, fmt, _, src_size, dst_size, body_size = struct.unpack_from("<IHHIII", patch)
+    hashes = [patch[20 + 32 * i:52 + 32 * i].hex() for i in range(3)]
+    print(f"magic {magic:08x} format {fmt} | source {src_size} -> image {dst_size} bytes, body {body_size} bytes")
+    for name, h in zip(("source", "image", "body"), hashes):
+        print(f"  {name:6s} sha256 {h}")
+    ok = len(patch) == HDR_SIGNED + SIG_BYTES + body_size and \
+        hashlib.sha256(patch[HDR_SIGNED + SIG_BYTES:]).hexdigest() == hashes[2]
+    print(f"  body   {'ok' if ok else 'MISMATCH'}")
+    if args.key:
+        q = ec_mul(load_key(args.key), G)
+        sig_ok = ecdsa_verify(q, hashlib.sha256(patch[:HDR_SIGNED]).digest(), patch[HDR_SIGNED:HDR_SIGNED + SIG_BYTES])
+        print(f"  signature {'ok' if sig_ok else 'INVALID'}")
+        ok = ok and sig_ok
+    return 0 if ok else 1
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    sub = ap.add_subparsers(dest="cmd", required=True)
+
+    p = sub.add_parser("keygen", help="new signing key")
+    p.add_argument("key")
+    p.add_argument("--header", help="write the public key header here (include/sys_ota_key.h)")
+    p.set_defaults(fn=cmd_keygen)
+
+    p = sub.add_parser("diff", help="patch from the running image to a new one")
+    p.add_argument("old")
+    p.add_argument("new")
+    p.add_argument("patch")
+    p.add_argument("--key")
+    p.set_defaults(fn=cmd_diff)
+
+    p = sub.add_parser("full", help="full image in patch format (any running image)")
+    p.add_argument("new")
+    p.add_argument("patch")
+    p.add_argument("--key")
+    p.set_defaults(fn=cmd_full)
+
+    p = sub.add_parser("info", help="print and check a patch")
+    p.add_argument("patch")
+    p.add_argument("--key", help="also check the signature")
+    p.set_defaults(fn=cmd_info)
+
+    args = ap.parse_args()
+    sys.exit(args.fn(args) or 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,277 @@
+/**
+ * @file ota_patch_sim.c
+ * @brief Host test of the delta OTA applier against file-backed OTA slots
+ * @details
+ * Runs src/sys_ota_patch.c the way sys_ota.c does: the running image is
+ * read from a file-backed slot, the patch is fed in OTA_RANGE_BYTES pieces
+ * (one HTTP range each) and the new image is written sequentially into a
+ * second file-backed slot. Then:
+ * - checks the target slot against new.bin, also with random feed splits;
+ * - reports patch size against the image, op mix, applier RAM, host apply
+ *   throughput and the modelled on-target flash time;
+ * - checks that a flipped body byte, a flipped header byte, a different
+ *   running image, a truncated patch and bytes after END are all refused.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/ota_patch_sim.c src/sys_ota_patch.c -o ota_patch_sim
+ *   python3 tools/ota_mkpatch.py diff old.bin new.bin update.patch
+ *   ./ota_patch_sim old.bin new.bin update.patch [slot.bin]
+ *
+ * The ECDSA signature is not checked here (verify_sig = NULL; the target
+ * uses mbedtls, "ota_mkpatch.py info --key" checks it on the host). Flash
+ * timings are the flashlog_sim.c figures (reads 40MB/s + 15us per call,
+ * page program 0.7ms per 256B, sector erase 45ms), with esp_ota_write()
+ * erasing each sector before its first write.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sys_ota.h"
+
+#define SIM_SLOT_SIZE       0xE0000     // Matches "ota_0" / "ota_1" in partitions.csv
+#define SIM_SECTOR          4096
+#define SIM_READ_CALL_US    15.0
+#define SIM_READ_BYTE_US    0.025
+#define SIM_PROG_PAGE_US    700.0
+#define SIM_ERASE_US        45000.0
+#define SIM_LTE_BYTES_S     20000.0     // Effective A7682S HTTP download rate (Cat-1, incl. AT overhead)
+#define SIM_RANDOM_RUNS     4
+
+typedef struct {
+    FILE *src;                  // Running slot
+    FILE *dst;                  // Target slot
+    uint32_t dst_pos;
+    double busy_us;             // Modelled flash time
+} sim_slots_t;
+
+static uint32_t rng_state = 12345;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state;
+}
+
+static uint8_t *load(const char *path, size_t *len) {
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        perror(path);
+        exit(2);
+    }
+    fseek(f, 0, SEEK_END);
+    *len = (size_t)ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t *buf = malloc(*len + 1);
+    if (!buf || fread(buf, 1, *len, f) != *len) {
+        fprintf(stderr, "%s: read failed\n", path);
+        exit(2);
+    }
+    fclose(f);
+    return buf;
+}
+
+// Slot file holding img followed by erased flash
+static FILE *make_slot(const char *path, const uint8_t *img, size_t len) {
+    FILE *f = path ? fopen(path, "w+b") : tmpfile();
+    static uint8_t ff[SIM_SECTOR];
+    if (!f) {
+        perror(path ? path : "tmpfile");
+        exit(2);
+    }
+    memset(ff, 0xFF, sizeof(ff));
+    for (uint32_t a = 0; a < SIM_SLOT_SIZE; a += SIM_SECTOR) fwrite(ff, 1, SIM_SECTOR, f);
+    fseek(f, 0, SEEK_SET);
+    fwrite(img, 1, len, f);
+    fflush(f);
+    return f;
+}
+
+// --- FLASH MODEL ---
+
+static bool sim_read(void *ctx, uint32_t addr, void *buf, size_t len) {
+    sim_slots_t *s = ctx;
+    s->busy_us += SIM_READ_CALL_US + SIM_READ_BYTE_US * len;
+    fseek(s->src, addr, SEEK_SET);
+    return fread(buf, 1, len, s->src) == len;
+}
+
+static bool sim_write(void *ctx, const void *buf, size_t len) {
+    sim_slots_t *s = ctx;
+    if (s->dst_pos + len > SIM_SLOT_SIZE) return false;
+
+    uint32_t first = (s->dst_pos + SIM_SECTOR - 1) / SIM_SECTOR;
+    uint32_t end = (uint32_t)((s->dst_pos + len + SIM_SECTOR - 1) / SIM_SECTOR);
+    s->busy_us += SIM_ERASE_US * (end - first) + SIM_PROG_PAGE_US * ((len + 255) / 256);
+
+    fseek(s->dst, s->dst_pos, SEEK_SET);
+    if (fwrite(buf, 1, len, s->dst) != len) return false;
+    s->dst_pos += (uint32_t)len;
+    return true;
+}
+
+// --- APPLY ---
+
+typedef struct {
+    ota_patch_result_t result;
+    double host_ns;
+    double flash_us;
+    ota_patch_stats_t stats;
+    bool match;                 // Target slot == new image
+} run_t;
+
+/**
+ * @param split 0 = OTA_RANGE_BYTES pieces, else random pieces of 1..split bytes
+ */
+static run_t apply(FILE *src, const uint8_t *patch, size_t patch_len, const uint8_t *img, size_t img_len,
+                   size_t split, const char *slot_path) {
+    static ota_patch_t p;
+    sim_slots_t slots = { .src = src, .dst = make_slot(slot_path, NULL, 0) };
+    ota_patch_io_t io = {
+        .read_src = sim_read,
+        .write_dst = sim_write,
+        .verify_sig = NULL,
+        .ctx = &slots,
+        .src_limit = SIM_SLOT_SIZE,
+        .dst_limit = SIM_SLOT_SIZE,
+    };
+    run_t r = { 0 };
+
+    ota_patch_init(&p, &io);
+    double t0 = now_ns();
+    size_t off = 0;
+    ota_patch_result_t res = OTA_PATCH_BUSY;
+    while (off < patch_len && res == OTA_PATCH_BUSY) {
+        size_t n = split ? 1 + rnd() % split : OTA_RANGE_BYTES;
+        if (n > patch_len - off) n = patch_len - off;
+        res = ota_patch_feed(&p, patch + off, n);
+        off += n;
+    }
+    r.host_ns = now_ns() - t0;
+    r.result = res;
+    r.flash_us = slots.busy_us;
+    r.stats = p.stats;
+
+    if (res == OTA_PATCH_DONE && slots.dst_pos == img_len) {
+        uint8_t *back = malloc(img_len + 1);
+        fseek(slots.dst, 0, SEEK_SET);
+        r.match = fread(back, 1, img_len, slots.dst) == img_len && memcmp(back, img, img_len) == 0;
+        free(back);
+    }
+    fclose(slots.dst);
+    return r;
+}
+
+// --- TAMPER ---
+
+static int expect_refused(const char *what, FILE *src, const uint8_t *patch, size_t len, const uint8_t *img,
+                          size_t img_len) {
+    run_t r = apply(src, patch, len, img, img_len, 0, NULL);
+    bool ok = r.result != OTA_PATCH_DONE;
+    printf("  %-28s -> %-16s %s\n", what, ota_patch_result_name(r.result), ok ? "ok" : "ACCEPTED");
+    return ok ? 0 : 1;
+}
+
+static int check_tamper(FILE *src, const uint8_t *old, size_t old_len, const uint8_t *patch, size_t patch_len,
+                        const uint8_t *img, size_t img_len) {
+    int failures = 0;
+    uint8_t *bad = malloc(patch_len + 16);
+
+    printf("\nTampered input (must not reach DONE):\n");
+
+    memcpy(bad, patch, patch_len);
+    bad[OTA_HDR_BYTES + (patch_len - OTA_HDR_BYTES) / 2] ^= 0x01;
+    failures += expect_refused("body byte flipped", src, bad, patch_len, img, img_len);
+
+    memcpy(bad, patch, patch_len);
+    bad[52] ^= 0x80;    // dst_hash (the signature would catch it on target)
+    failures += expect_refused("image hash flipped", src, bad, patch_len, img, img_len);
+
+    failures += expect_refused("truncated by 1 byte", src, patch, patch_len - 1, img, img_len);
+
+    memcpy(bad, patch, patch_len);
+    bad[patch_len] = 0x00;
+    failures += expect_refused("byte after END", src, bad, patch_len + 1, img, img_len);
+
+    if (old_len > 0) {
+        uint8_t *other = malloc(old_len);
+        memcpy(other, old, old_len);
+        other[old_len / 3] ^= 0x10;
+        FILE *src2 = make_slot(NULL, other, old_len);
+        failures += expect_refused("different running image", src2, patch, patch_len, img, img_len);
+        fclose(src2);
+        free(other);
+    }
+
+    free(bad);
+    return failures;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 4) {
+        fprintf(stderr, "usage: %s old.bin new.bin update.patch [slot.bin]\n", argv[0]);
+        return 2;
+    }
+
+    size_t old_len, img_len, patch_len;
+    uint8_t *old = load(argv[1], &old_len);
+    uint8_t *img = load(argv[2], &img_len);
+    uint8_t *patch = load(argv[3], &patch_len);
+    if (old_len > SIM_SLOT_SIZE || img_len > SIM_SLOT_SIZE) {
+        fprintf(stderr, "image larger than the %u byte slot\n", SIM_SLOT_SIZE);
+        return 2;
+    }
+    if (patch_len <= OTA_HDR_BYTES) {
+        fprintf(stderr, "%s: too short for a patch\n", argv[3]);
+        return 2;
+    }
+
+    FILE *src = make_slot(NULL, old, old_len);
+    int failures = 0;
+
+    run_t r = apply(src, patch, patch_len, img, img_len, 0, argc > 4 ? argv[4] : NULL);
+    if (r.result != OTA_PATCH_DONE || !r.match) failures++;
+
+    ota_patch_stats_t *st = &r.stats;
+    double dl_s = patch_len / SIM_LTE_BYTES_S, full_s = (img_len + OTA_HDR_BYTES) / SIM_LTE_BYTES_S;
+    printf("Apply (%d byte ranges): %s, target slot %s\n", OTA_RANGE_BYTES, ota_patch_result_name(r.result),
+           r.match ? "matches new image" : "MISMATCH");
+    printf("  image           %8zu bytes (running image %zu bytes)\n", img_len, old_len);
+    printf("  patch           %8zu bytes = %.1f%% of the image\n", patch_len, 100.0 * patch_len / img_len);
+    printf("  ops             %8lu  (copy %lu, add %lu, data %lu bytes)\n", (unsigned long)st->ops,
+           (unsigned long)st->copy_bytes, (unsigned long)st->add_bytes, (unsigned long)st->data_bytes);
+    printf("  flash calls     %8lu reads, %lu writes\n", (unsigned long)st->src_reads, (unsigned long)st->writes);
+    printf("  applier RAM     %8zu bytes (ota_patch_t) + %d byte range buffer\n", sizeof(ota_patch_t),
+           OTA_RANGE_BYTES);
+    printf("  host apply      %8.1f ms = %.1f MB/s of image\n", r.host_ns / 1e6, img_len / (r.host_ns / 1e3));
+    printf("  target flash    %8.1f ms (modelled: source hash + reads, erase, program)\n", r.flash_us / 1e3);
+    printf("  LTE download    %8.1f s at %.0f kB/s (full image: %.1f s)\n", dl_s, SIM_LTE_BYTES_S / 1e3, full_s);
+
+    printf("\nRandom feed splits:\n");
+    static const size_t splits[SIM_RANDOM_RUNS] = { 1, 17, 300, 5000 };
+    for (int i = 0; i < SIM_RANDOM_RUNS; i++) {
+        run_t rr = apply(src, patch, patch_len, img, img_len, splits[i], NULL);
+        bool ok = rr.result == OTA_PATCH_DONE && rr.match;
+        if (!ok) failures++;
+        printf("  1..%-5zu bytes per feed -> %s %s\n", splits[i], ota_patch_result_name(rr.result),
+               ok ? "ok" : "FAILED");
+    }
+
+    failures += check_tamper(src, old, old_len, patch, patch_len, img, img_len);
+
+    fclose(src);
+    free(old);
+    free(img);
+    free(patch);
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
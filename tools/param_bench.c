@@ -0,0 +1,179 @@
+/**
+ * @file param_bench.c
+ * @brief Host check: runtime parameters vs compile-time macros on the filter hot paths
+ * @details
+ * Runs copies of the ultrasonic spike filter and the load-cell hysteresis
+ * step twice over the same input, once with the old #define thresholds
+ * and once reading `sysparam` (defined in src/sys_param_table.c, a
+ * separate translation unit, so the compiler cannot fold the values). It
+ * checks that both produce identical output with default parameters,
+ * that a sysparam_apply() takes effect on the next sample, and reports
+ * ns per sample, plus the cost of a by-name lookup for comparison.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/param_bench.c src/sys_param_table.c -lm -o param_bench
+ *   ./param_bench
+ *
+ * Host timings are only meaningful relative to each other.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "sys_param.h"
+
+// Pre-registry values
+#define OLD_SPIKE_MM            500
+#define OLD_SPIKE_TOL           5
+#define OLD_HUMAN_TRIG          8000
+#define OLD_HUMAN_REL           6000
+#define OLD_DETECT_REQ          5
+
+#define BENCH_SAMPLES           (1 << 16)
+#define BENCH_ROUNDS            200
+
+typedef struct {
+    uint16_t last_valid_value;
+    uint8_t error_count;
+} us_filter_t;
+
+typedef struct {
+    uint8_t stable_counter;
+    bool is_human_detected;
+} lc_state_t;
+
+static uint16_t us_input[BENCH_SAMPLES];
+static int32_t lc_input[BENCH_SAMPLES];
+
+// --- KERNELS (same logic as drv_ultrasonic.c / drv_loadcell.c) ---
+
+#define US_FILTER_BODY(SPIKE_MM, SPIKE_TOL) \
+    int16_t diff = (int16_t)raw - (int16_t)f->last_valid_value; \
+    if (diff < -(SPIKE_MM)) { f->last_valid_value = raw; f->error_count = 0; return raw; } \
+    if (diff > (SPIKE_MM)) { \
+        f->error_count++; \
+        if (f->error_count >= (SPIKE_TOL)) { f->last_valid_value = raw; f->error_count = 0; return raw; } \
+        return f->last_valid_value; \
+    } \
+    f->last_valid_value = raw; f->error_count = 0; \
+    return raw;
+
+#define LC_STEP_BODY(TRIG, REL, REQ) \
+    if (w >= (TRIG)) { \
+        s->stable_counter++; \
+        if (s->stable_counter > (REQ)) s->stable_counter = (REQ); \
+        if (s->stable_counter >= (REQ)) s->is_human_detected = true; \
+    } else if (w <= (REL)) { \
+        if (s->stable_counter > 0) s->stable_counter--; \
+        if (s->stable_counter == 0) s->is_human_detected = false; \
+    }
+
+__attribute__((noinline)) static uint16_t us_filter_macro(uint16_t raw, us_filter_t *f) {
+    US_FILTER_BODY(OLD_SPIKE_MM, OLD_SPIKE_TOL)
+}
+
+__attribute__((noinline)) static uint16_t us_filter_param(uint16_t raw, us_filter_t *f) {
+    US_FILTER_BODY(sysparam.us_spike_mm, sysparam.us_spike_tol)
+}
+
+__attribute__((noinline)) static uint16_t us_filter_lookup(uint16_t raw, us_filter_t *f) {
+    US_FILTER_BODY(sysparam_value(sysparam_find("us_spike_mm", 11)),
+                   sysparam_value(sysparam_find("us_spike_tol", 12)))
+}
+
+__attribute__((noinline)) static void lc_step_macro(int32_t w, lc_state_t *s) {
+    LC_STEP_BODY(OLD_HUMAN_TRIG, OLD_HUMAN_REL, OLD_DETECT_REQ)
+}
+
+__attribute__((noinline)) static void lc_step_param(int32_t w, lc_state_t *s) {
+    LC_STEP_BODY(sysparam.lc_human_trig, sysparam.lc_human_rel, sysparam.lc_detect_req)
+}
+
+// --- HARNESS ---
+
+typedef uint16_t (*us_fn_t)(uint16_t, us_filter_t *);
+typedef void (*lc_fn_t)(int32_t, lc_state_t *);
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t run_us(us_fn_t fn, int rounds, double *ns_per) {
+    uint32_t sum = 0;
+    double t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        us_filter_t f = { 1000, 0 };
+        for (int i = 0; i < BENCH_SAMPLES; i++) sum = sum * 31 + fn(us_input[i], &f);
+    }
+    *ns_per = (now_ns() - t0) / ((double)rounds * BENCH_SAMPLES);
+    return sum;
+}
+
+static uint32_t run_lc(lc_fn_t fn, int rounds, double *ns_per) {
+    uint32_t sum = 0;
+    double t0 = now_ns();
+    for (int r = 0; r < rounds; r++) {
+        lc_state_t s = { 0, false };
+        for (int i = 0; i < BENCH_SAMPLES; i++) {
+            fn(lc_input[i], &s);
+            sum = sum * 31 + s.stable_counter + (s.is_human_detected ? 1000u : 0u);
+        }
+    }
+    *ns_per = (now_ns() - t0) / ((double)rounds * BENCH_SAMPLES);
+    return sum;
+}
+
+static void make_input(void) {
+    srand(42);
+    uint16_t d = 1500;
+    int32_t w = 0;
+    for (int i = 0; i < BENCH_SAMPLES; i++) {
+        // Slow drift with occasional spikes / boarding events
+        d = (uint16_t)(d + (rand() % 41) - 20);
+        if (d < 250 || d > 5000) d = 1500;
+        us_input[i] = (rand() % 16 == 0) ? (uint16_t)(d + 600 + rand() % 2000) : d;
+
+        if (rand() % 512 == 0) w = (w > 7000) ? 0 : 9000;
+        lc_input[i] = w + (rand() % 3001) - 1500;
+    }
+}
+
+int main(void) {
+    double ns_macro, ns_param, ns_lookup;
+    int fails = 0;
+
+    sysparam_reset_defaults();
+    make_input();
+
+    // Warm-up, then measure
+    run_us(us_filter_macro, 5, &ns_macro);
+    uint32_t us_m = run_us(us_filter_macro, BENCH_ROUNDS, &ns_macro);
+    uint32_t us_p = run_us(us_filter_param, BENCH_ROUNDS, &ns_param);
+    uint32_t us_l = run_us(us_filter_lookup, BENCH_ROUNDS / 10, &ns_lookup);
+    printf("Ultrasonic filter  macro %6.2f ns | sysparam %6.2f ns (%+5.1f%%) | by name %7.2f ns\n",
+           ns_macro, ns_param, 100.0 * (ns_param - ns_macro) / ns_macro, ns_lookup);
+    if (us_m != us_p) { printf("  FAIL: outputs differ (macro vs sysparam)\n"); fails++; }
+    (void)us_l;
+
+    run_lc(lc_step_macro, 5, &ns_macro);
+    uint32_t lc_m = run_lc(lc_step_macro, BENCH_ROUNDS, &ns_macro);
+    uint32_t lc_p = run_lc(lc_step_param, BENCH_ROUNDS, &ns_param);
+    printf("Load-cell step     macro %6.2f ns | sysparam %6.2f ns (%+5.1f%%)\n",
+           ns_macro, ns_param, 100.0 * (ns_param - ns_macro) / ns_macro);
+    if (lc_m != lc_p) { printf("  FAIL: outputs differ (macro vs sysparam)\n"); fails++; }
+
+    // A changed value is used on the next sample
+    us_filter_t f = { 1000, 0 };
+    if (us_filter_param(1400, &f) != 1400) fails++;
+    sysparam_apply(SYSPARAM_US_SPIKE_MM, 200.0f);
+    if (us_filter_param(1800, &f) != 1400) { printf("  FAIL: new spike threshold not applied\n"); fails++; }
+    if (sysparam_apply(SYSPARAM_US_SPIKE_MM, 10.0f)) { printf("  FAIL: out-of-range value accepted\n"); fails++; }
+    if (sysparam.us_spike_mm != 200) { printf("  FAIL: rejected value changed sysparam\n"); fails++; }
+
+    printf("%s\n", fails == 0 ? "OK" : "FAILED");
+    return fails == 0 ? 0 : 1;
+}
@@ -0,0 +1,353 @@
+/**
+ * @file stop_sim.c
+ * @brief Host test of the STOP latency through a fake broker
+ * @details
+ * Runs the real AT engine (src/at_engine.c) and command parser
+ * (src/sys_command_parser.c) on a virtual microsecond clock with:
+ * - the modem UART at 115200 baud, one shared wire for every modem output;
+ * - the IDF driver wake-up rule: MODEM_RX_FULL_THRESH bytes in the FIFO or
+ *   MODEM_RX_TIMEOUT_SYMBOLS of idle line, then up to 300 us of preemption
+ *   before the modem task runs (plus its MODEM_POLL_MS poll);
+ * - 2 Hz telemetry publishes (TOPIC / PAYLOAD with '>' prompts, PUB with
+ *   the +CMQTTPUB completion) keeping the engine busy;
+ * - the fake broker sending STOP as the +CMQTTRXSTART ... +CMQTTRXEND
+ *   block, assembled like drv_modem.c does, with a random HB or WP message
+ *   in between.
+ * Checks that every STOP is parsed and executed, that other commands are
+ * not, and that no telemetry publish fails, then reports the latency from
+ * the first URC byte on the wire and from +CMQTTRXSTART tokenized to the
+ * stop (the emergency path itself is a function call in the modem task).
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/stop_sim.c src/at_engine.c src/sys_command_parser.c \
+ *       src/sys_param_table.c -lm -o stop_sim
+ *   ./stop_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "at_engine.h"
+#include "drv_modem.h"
+#include "sys_command.h"
+
+#define BYTE_US         87          // 115200 8N1
+#define STEP_US         10
+#define WIRE_MAX        8192        // Bytes on the wire not yet read (power of 2)
+#define PREEMPT_MAX_US  300
+#define TLM_PERIOD_US   500000      // 2 Hz publishes
+#define TLM_PAYLOAD     420
+#define STOP_MESSAGES   1000
+#define CMD_GAP_US      700000      // Mean time between broker messages
+
+/**
+ * @brief Modem UART output: byte values with their arrival time
+ */
+typedef struct {
+    uint8_t data[WIRE_MAX];
+    int64_t at_us[WIRE_MAX];
+    uint32_t head;              // Next byte to put on the wire
+    uint32_t tail;              // Next byte for the modem task
+    int64_t free_us;            // Wire idle from here
+} sim_wire_t;
+
+/**
+ * @brief Fake modem (command side)
+ */
+typedef struct {
+    char line[AT_CMD_MAX_LEN + 8];
+    size_t line_len;
+    size_t data_left;           // '>' sent, waiting for this many bytes
+    int64_t now;
+} sim_modem_t;
+
+/**
+ * @brief Latency accumulator
+ */
+typedef struct {
+    double sum;
+    uint32_t max;
+    uint32_t n;
+} sim_lat_t;
+
+static sim_wire_t wire;
+static sim_modem_t modem;
+static at_engine_t eng;
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// MQTT RX assembly (as in drv_modem.c)
+static char rx_topic[MODEM_MQTT_TOPIC_MAX];
+static uint8_t rx_payload[MODEM_MQTT_PAYLOAD_MAX];
+static size_t rx_payload_len;
+static int64_t rx_start_us;
+
+static int64_t stop_first_byte_us;  // First byte of the pending STOP block
+static uint32_t stops_sent, stops_done, others_sent, others_done, wrong;
+static uint32_t pubs_ok, pubs_failed;
+static sim_lat_t lat_wire, lat_urc;
+
+// --- HELPERS ---
+
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) % n;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void lat_add(sim_lat_t *l, int64_t us) {
+    l->sum += (double)us;
+    if ((uint32_t)us > l->max) l->max = (uint32_t)us;
+    l->n++;
+}
+
+/**
+ * @brief Modem output: serialized on the wire after `delay_us`
+ * @return Arrival time of the first byte
+ */
+static int64_t wire_send(int64_t delay_us, const void *data, size_t len) {
+    const uint8_t *p = data;
+    int64_t t = modem.now + delay_us;
+    if (t < wire.free_us) t = wire.free_us;
+    int64_t first = t + BYTE_US;
+
+    for (size_t i = 0; i < len; i++) {
+        t += BYTE_US;
+        wire.data[wire.head & (WIRE_MAX - 1)] = p[i];
+        wire.at_us[wire.head & (WIRE_MAX - 1)] = t;
+        wire.head++;
+    }
+    wire.free_us = t;
+    return first;
+}
+
+static void wire_say(int64_t delay_us, const char *text) {
+    wire_send(delay_us, text, strlen(text));
+}
+
+static void modem_command(const char *cmd) {
+    int64_t proc = (int64_t)(strlen(cmd) + 1) * BYTE_US + 1000 + rnd(3000);
+    int n;
+
+    if (sscanf(cmd, "AT+CMQTTTOPIC=0,%d", &n) == 1 || sscanf(cmd, "AT+CMQTTPAYLOAD=0,%d", &n) == 1) {
+        modem.data_left = (size_t)n;
+        wire_say(proc, "\r\n>");
+    } else if (strncmp(cmd, "AT+CMQTTPUB=", 12) == 0) {
+        wire_say(proc, "\r\nOK\r\n");
+        wire_say(30000 + rnd(70000), "\r\n+CMQTTPUB: 0,0\r\n");
+    } else {
+        wire_say(proc, "\r\nOK\r\n");
+    }
+}
+
+static size_t modem_write(const uint8_t *data, size_t len, void *io_ctx) {
+    (void)io_ctx;
+    for (size_t i = 0; i < len; i++) {
+        if (modem.data_left > 0) {
+            if (--modem.data_left == 0) wire_say(1000, "\r\nOK\r\n");
+            continue;
+        }
+        if (data[i] == '\r') {
+            modem.line[modem.line_len] = '\0';
+            modem_command(modem.line);
+            modem.line_len = 0;
+        } else if (modem.line_len < sizeof(modem.line) - 1) {
+            modem.line[modem.line_len++] = (char)data[i];
+        }
+    }
+    return len;
+}
+
+/**
+ * @brief Broker message as the modem reports it
+ * @return Arrival time of its first byte
+ */
+static int64_t broker_send(const char *topic, const char *payload) {
+    char buf[256];
+    size_t tl = strlen(topic), pl = strlen(payload);
+    int n = snprintf(buf, sizeof(buf),
+                     "\r\n+CMQTTRXSTART: 0,%u,%u\r\n+CMQTTRXTOPIC: 0,%u\r\n%s\r\n"
+                     "+CMQTTRXPAYLOAD: 0,%u\r\n%s\r\n+CMQTTRXEND: 0\r\n",
+                     (unsigned)tl, (unsigned)pl, (unsigned)tl, topic, (unsigned)pl, payload);
+    return wire_send(0, buf, (size_t)n);
+}
+
+static void on_topic_chunk(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx) {
+    (void)total;
+    (void)ctx;
+    if (offset + len > sizeof(rx_topic) - 1) return;
+    memcpy(&rx_topic[offset], data, len);
+    rx_topic[offset + len] = '\0';
+}
+
+static void on_payload_chunk(const uint8_t *data, size_t len, size_t offset, size_t total, void *ctx) {
+    (void)offset;
+    (void)total;
+    (void)ctx;
+    if (rx_payload_len + len > sizeof(rx_payload)) return;
+    memcpy(&rx_payload[rx_payload_len], data, len);
+    rx_payload_len += len;
+}
+
+static void on_rx_start(const at_span_t *line, void *ctx) {
+    (void)line;
+    (void)ctx;
+    rx_start_us = modem.now;
+    rx_topic[0] = '\0';
+    rx_payload_len = 0;
+}
+
+static void on_rx_topic(const at_span_t *line, void *ctx) {
+    int32_t len;
+    (void)ctx;
+    if (at_span_get_int(line, 1, &len) && len > 0) at_engine_expect_raw(&eng, (size_t)len, on_topic_chunk, NULL);
+}
+
+static void on_rx_payload(const at_span_t *line, void *ctx) {
+    int32_t len;
+    (void)ctx;
+    if (at_span_get_int(line, 1, &len) && len > 0) at_engine_expect_raw(&eng, (size_t)len, on_payload_chunk, NULL);
+}
+
+/**
+ * @brief sys_command.c on_mqtt_rx(): parse, STOP executes right here
+ */
+static void on_rx_end(const at_span_t *line, void *ctx) {
+    cmd_t cmd;
+    (void)line;
+    (void)ctx;
+
+    if (strcmp(rx_topic, CMD_TOPIC) != 0 || !cmd_parse(rx_payload, rx_payload_len, &cmd)) {
+        wrong++;
+        return;
+    }
+    if (cmd_is_emergency(cmd.type)) {
+        if (stop_first_byte_us == 0) {
+            wrong++;
+            return;
+        }
+        stops_done++;
+        lat_add(&lat_wire, modem.now - stop_first_byte_us);
+        lat_add(&lat_urc, modem.now - rx_start_us);
+        stop_first_byte_us = 0;
+    } else {
+        others_done++;
+    }
+}
+
+static void on_pub_done(at_result_t result, void *ctx) {
+    (void)ctx;
+    if (result == AT_RESULT_OK) pubs_ok++;
+    else pubs_failed++;
+}
+
+static void submit_data(const char *fmt, size_t len, const uint8_t *data) {
+    at_cmd_t c = {0};
+    snprintf(c.cmd, sizeof(c.cmd), fmt, (unsigned)len);
+    c.data = data;
+    c.data_len = (uint16_t)len;
+    at_engine_submit(&eng, &c);
+}
+
+/**
+ * @brief drv_modem.c queue_publish()
+ */
+static void publish(void) {
+    static const char topic[] = "frd/tlm";
+    static uint8_t payload[TLM_PAYLOAD];
+    at_cmd_t c = {0};
+
+    submit_data("AT+CMQTTTOPIC=0,%u", sizeof(topic) - 1, (const uint8_t *)topic);
+    submit_data("AT+CMQTTPAYLOAD=0,%u", sizeof(payload), payload);
+    strcpy(c.cmd, "AT+CMQTTPUB=0,1,60");
+    c.done_prefix = "+CMQTTPUB:";
+    c.timeout_ms = MODEM_MQTT_PUB_TIMEOUT_MS;
+    c.on_done = on_pub_done;
+    at_engine_submit(&eng, &c);
+}
+
+static void task_run(void) {
+    while (wire.tail != wire.head && wire.at_us[wire.tail & (WIRE_MAX - 1)] <= modem.now) {
+        at_engine_feed(&eng, &wire.data[wire.tail & (WIRE_MAX - 1)], 1);
+        wire.tail++;
+    }
+    at_engine_poll(&eng, modem.now);
+}
+
+// --- SCENARIOS ---
+
+static void test_stop_latency(void) {
+    static const char *const others[] = { "HB", "WP 473977000,85451000;473980000,85460000" };
+    int64_t next_tlm = 0, next_msg = CMD_GAP_US, next_poll = 0, wake_at = -1;
+
+    printf("STOP through the fake broker, %d messages, 2 Hz telemetry:\n", STOP_MESSAGES);
+    at_engine_init(&eng, modem_write, NULL);
+    at_engine_register_urc(&eng, "+CMQTTRXSTART:", on_rx_start, NULL);
+    at_engine_register_urc(&eng, "+CMQTTRXTOPIC:", on_rx_topic, NULL);
+    at_engine_register_urc(&eng, "+CMQTTRXPAYLOAD:", on_rx_payload, NULL);
+    at_engine_register_urc(&eng, "+CMQTTRXEND:", on_rx_end, NULL);
+
+    while (stops_sent < STOP_MESSAGES || stop_first_byte_us != 0) {
+        modem.now += STEP_US;
+
+        if (modem.now >= next_tlm) {
+            next_tlm += TLM_PERIOD_US;
+            publish();
+            task_run();                 // Message queue wakes the task
+        }
+        if (modem.now >= next_msg && stop_first_byte_us == 0 && stops_sent < STOP_MESSAGES) {
+            next_msg = modem.now + CMD_GAP_US / 2 + rnd(CMD_GAP_US);
+            if (rnd(4) == 0) {
+                broker_send(CMD_TOPIC, others[rnd(2)]);
+                others_sent++;
+            } else {
+                stop_first_byte_us = broker_send(CMD_TOPIC, "STOP");
+                stops_sent++;
+            }
+        }
+
+        // UART driver: FIFO threshold or RX idle timeout, then scheduling delay
+        uint32_t fifo = 0;
+        int64_t last = 0;
+        for (uint32_t i = wire.tail; i != wire.head && wire.at_us[i & (WIRE_MAX - 1)] <= modem.now; i++) {
+            fifo++;
+            last = wire.at_us[i & (WIRE_MAX - 1)];
+        }
+        bool idle = fifo > 0 && modem.now - last >= MODEM_RX_TIMEOUT_SYMBOLS * BYTE_US;
+        if (wake_at < 0 && (fifo >= MODEM_RX_FULL_THRESH || idle)) wake_at = modem.now + rnd(PREEMPT_MAX_US);
+
+        if ((wake_at >= 0 && modem.now >= wake_at) || modem.now >= next_poll) {
+            task_run();
+            wake_at = -1;
+            next_poll = modem.now + MODEM_POLL_MS * 1000;
+        }
+    }
+    // Let the last publishes finish
+    for (int64_t end = modem.now + 1000000; modem.now < end; modem.now += STEP_US) task_run();
+
+    check("every STOP parsed and executed", stops_done == STOP_MESSAGES);
+    check("HB / WP parsed, not executed as STOP", others_done == others_sent);
+    check("no stray or unparsed message", wrong == 0);
+    check("no telemetry publish failed", pubs_failed == 0 && pubs_ok > 0);
+    check("no RX overflow, no timeout", eng.stats.rx_overflows == 0 && eng.stats.cmds_timeout == 0);
+
+    printf("  first URC byte on the UART -> stop: avg %5.2f ms, max %5.2f ms\n",
+           lat_wire.sum / lat_wire.n / 1000.0, lat_wire.max / 1000.0);
+    printf("  +CMQTTRXSTART tokenized    -> stop: avg %5.2f ms, max %5.2f ms\n",
+           lat_urc.sum / lat_urc.n / 1000.0, lat_urc.max / 1000.0);
+    printf("  %u publishes, %u other commands, %.0f s virtual\n", (unsigned)pubs_ok, (unsigned)others_sent,
+           modem.now * 1e-6);
+}
+
+int main(void) {
+    test_stop_latency();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
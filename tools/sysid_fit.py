@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+"""
+Fit plant models to a sys_ident capture and suggest controller gains.
+
+Usage:
+    pio device monitor | tee run.log      # then trigger sysid_dump() on the device
+    python3 tools/sysid_fit.py run.log [--wn 0.8] [--zeta 0.8]
+
+Input is the console text produced by sysid_dump(): a "#SYSID key=value ..."
+header, "slot,left,right,yaw_dps,thrust_g" rows and "#END". Other log lines
+are ignored, so a raw monitor log can be passed directly.
+
+Models (least squares on the uniform slot grid, dead time by search):
+  1st order: y[k+1] = a*y[k] + b*u[k-d] + c           -> K, tau, delay
+  2nd order: y[k+1] = a1*y[k] + a2*y[k-1]
+                      + b1*u[k-d] + b2*u[k-d-1] + c  -> K, wn, zeta, delay
+
+Input u is the common command (left+right)/2 for the thrust axis and the
+differential (left-right)/2 for the yaw axis; output is thrust (g) or yaw
+rate (deg/s). For yaw, the first-order fit is the Nomoto model
+T*r' + r = K*u and heading PID gains are suggested in the units used by
+ctrl_heading.h (raw per deg, raw per deg*s, raw per deg/s).
+"""
+
+import argparse
+import math
+import sys
+
+import numpy as np
+
+MAX_DELAY_S = 0.5
+
+
+def parse_log(path):
+    header, rows = None, []
+    with open(path, "r", errors="replace") as f:
+        for line in f:
+            line = line.strip()
+            if line.startswith("#SYSID"):
+                header = dict(kv.split("=", 1) for kv in line.split()[1:])
+                rows = []
+            elif line.startswith("#END"):
+                if header is not None:
+                    break
+            elif header is not None:
+                parts = line.split(",")
+                if len(parts) != 5:
+                    continue
+                try:
+                    rows.append([float(p) for p in parts])
+                except ValueError:
+                    continue
+    if header is None or not rows:
+        sys.exit("no #SYSID capture found in %s" % path)
+    return header, np.array(rows)
+
+
+def resample(data, rate):
+    """Interpolate dropped slots onto a uniform grid."""
+    slot = data[:, 0]
+    grid = np.arange(slot[0], slot[-1] + 1)
+    out = np.column_stack([grid] + [np.interp(grid, slot, data[:, i]) for i in range(1, 5)])
+    return out, grid / rate
+
+
+def lstsq(phi, y):
+    theta, *_ = np.linalg.lstsq(phi, y, rcond=None)
+    resid = y - phi @ theta
+    fit = 1.0 - np.var(resid) / max(np.var(y), 1e-12)
+    return theta, fit
+
+
+def fit_first_order(u, y, dt):
+    best = None
+    for d in range(int(MAX_DELAY_S / dt) + 1):
+        n = len(y) - 1 - d
+        if n < 10:
+            break
+        phi = np.column_stack([y[d:d + n], u[:n], np.ones(n)])
+        theta, fit = lstsq(phi, y[d + 1:d + 1 + n])
+        if best is None or fit > best[1]:
+            best = (theta, fit, d)
+    (a, b, _), fit, d = best
+    if not 0.0 < a < 1.0:
+        return None
+    return {"K": b / (1.0 - a), "tau": -dt / math.log(a), "delay": d * dt, "fit": fit}
+
+
+def fit_second_order(u, y, dt):
+    best = None
+    for d in range(int(MAX_DELAY_S / dt) + 1):
+        n = len(y) - 2 - d
+        if n < 10:
+            break
+        phi = np.column_stack([y[d + 1:d + 1 + n], y[d:d + n], u[1:1 + n], u[:n], np.ones(n)])
+        theta, fit = lstsq(phi, y[d + 2:d + 2 + n])
+        if best is None or fit > best[1]:
+            best = (theta, fit, d)
+    (a1, a2, b1, b2, _), fit, d = best
+    den = 1.0 - a1 - a2
+    if abs(den) < 1e-9:
+        return None
+    # Discrete poles -> continuous natural frequency / damping
+    poles = np.roots([1.0, -a1, -a2])
+    if np.any(np.abs(poles) >= 1.0) or np.any(np.abs(poles) < 1e-9):
+        return None
+    s = np.log(poles.astype(complex)) / dt
+    wn = float(np.sqrt(np.real(s[0] * s[1])))
+    zeta = float(-np.real(s[0] + s[1]) / (2.0 * wn)) if wn > 0 else float("nan")
+    return {"K": (b1 + b2) / den, "wn": wn, "zeta": zeta, "delay": d * dt, "fit": fit}
+
+
+def suggest_heading_gains(K, T, wn, zeta):
+    """Pole placement for heading on the Nomoto model (psi'' = (K*u - psi')/T)."""
+    kp = wn * wn * T / K
+    kd = max((2.0 * zeta * wn * T - 1.0) / K, 0.0)
+    ki = kp * wn / 10.0
+    return kp, ki, kd
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("log", help="console log containing a sysid_dump() capture")
+    ap.add_argument("--wn", type=float, default=0.8, help="desired heading loop natural frequency (rad/s)")
+    ap.add_argument("--zeta", type=float, default=0.8, help="desired heading loop damping")
+    args = ap.parse_args()
+
+    header, data = parse_log(args.log)
+    rate = float(header["rate"])
+    dt = 1.0 / rate
+    yaw_axis = int(header["axis"]) == 1
+
+    print("Capture: %s samples, %s dropped, achieved %s Hz (nominal %g Hz)"
+          % (header["samples"], header["dropped"], header["achieved"], rate))
+
+    grid, _ = resample(data, rate)
+    left, right = grid[:, 1], grid[:, 2]
+    if yaw_axis:
+        u, y, name, unit = (left - right) / 2.0, grid[:, 3], "yaw rate", "deg/s"
+    else:
+        u, y, name, unit = (left + right) / 2.0, grid[:, 4], "thrust", "g"
+    u = u - u[0]
+
+    fo = fit_first_order(u, y, dt)
+    so = fit_second_order(u, y, dt)
+
+    print("\nInput: %s command (raw), output: %s (%s)" % ("differential" if yaw_axis else "common", name, unit))
+    if fo:
+        print("1st order: K=%.4g %s/raw  tau=%.3f s  delay=%.3f s  1-step fit=%.1f%%"
+              % (fo["K"], unit, fo["tau"], fo["delay"], 100 * fo["fit"]))
+    else:
+        print("1st order: no stable fit")
+    if so:
+        print("2nd order: K=%.4g %s/raw  wn=%.3f rad/s  zeta=%.3f  delay=%.3f s  1-step fit=%.1f%%"
+              % (so["K"], unit, so["wn"], so["zeta"], so["delay"], 100 * so["fit"]))
+    else:
+        print("2nd order: no stable fit")
+
+    if yaw_axis and fo and fo["K"] > 0:
+        kp, ki, kd = suggest_heading_gains(fo["K"], fo["tau"], args.wn, args.zeta)
+        print("\nSuggested heading gains at base=%s (wn=%.2f rad/s, zeta=%.2f):" % (header["base"], args.wn, args.zeta))
+        print("    { <speed_m_s>, %.1ff, %.2ff, %.1ff },   // ctrl_gains_t: kp, ki, kd" % (kp, ki, kd))
+        if fo["delay"] > 0 and args.wn * fo["delay"] > 0.3:
+            print("    warning: wn*delay = %.2f, reduce --wn for phase margin" % (args.wn * fo["delay"]))
+    elif not yaw_axis and fo:
+        print("\nThrust loop: %.3g g per raw step, time constant %.2f s" % (fo["K"], fo["tau"]))
+        print("    speed loop bandwidth should stay below %.2f rad/s" % (1.0 / (2.0 * fo["tau"] + fo["delay"])))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,359 @@
+/**
+ * @file systime_sim.c
+ * @brief Host test of the PPS clock servo, plus UTC conversion cost
+ * @details
+ * Runs src/sys_time_servo.c against a simulated crystal: the local clock
+ * runs at (1 + drift) of true time, quantised to 1 us, and every PPS edge
+ * (a whole true second) is captured with the ISR latency added. Checks:
+ * - +-40 ppm crystal: locked within 6 s, drift estimate within 0.5 ppm;
+ * - 25 ppm with random-walk wander and 0-8 us ISR latency for 10 min:
+ *   mid-second UTC error rms < 10 us, max < 25 us, no step;
+ * - a glitch edge (+300 ms) every ~97 s: rejected, lock kept;
+ * - a mispaired second (UTC off by one): rejected, SYSTIME_MAX_REJECTS in
+ *   a row restart the servo;
+ * - PPS lost 60 s / 10 min: holdover state, error < 100 us / < 1 ms,
+ *   locked again after the edges come back;
+ * - 200k conversions across anchor updates: UTC never goes backwards;
+ * - a sample stamped before the first edge converts within 20 us once
+ *   locked;
+ * - systime_civil_to_unix() against known dates;
+ * then reports ns and TSC ticks per systime_servo_to_utc() (the work
+ * systime_to_utc_us() does inside its critical section) next to
+ * clock_gettime() for reference. On target, systime_measure_read_cost()
+ * gives the cycle counts.
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/systime_sim.c src/sys_time_servo.c -lm -o systime_sim
+ *   ./systime_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include "sys_time.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#endif
+
+#define UTC_START_S     1792367000LL    // 2026-10-18, any whole second works
+#define BOOT_OFFSET_US  12345678LL      // Local clock at true t = 0
+#define BENCH_CALLS     (1 << 24)
+
+/**
+ * @brief Simulated local oscillator
+ */
+typedef struct {
+    double drift_ppm;           // Local runs fast (+) vs true time
+    double wander_ppm;          // Random-walk step per second
+    double local_us;            // Local clock at the current true second
+    int64_t t_s;                // True seconds since start
+    uint32_t latency_max_us;    // ISR latency 0..max
+} sim_clock_t;
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+// --- HELPERS ---
+
+static double now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static uint32_t rnd(uint32_t n) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return (rng_state >> 8) % n;
+}
+
+static double rnd_sym(void) {
+    return (double)rnd(20001) / 10000.0 - 1.0;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void clock_init(sim_clock_t *c, double drift_ppm, double wander_ppm, uint32_t latency_max_us) {
+    c->drift_ppm = drift_ppm;
+    c->wander_ppm = wander_ppm;
+    c->local_us = (double)BOOT_OFFSET_US;
+    c->t_s = 0;
+    c->latency_max_us = latency_max_us;
+}
+
+/**
+ * @brief Local time at true second t_s + frac (quantised like esp_timer)
+ */
+static int64_t clock_local_at(const sim_clock_t *c, double frac_s) {
+    return (int64_t)floor(c->local_us + frac_s * 1e6 * (1.0 + c->drift_ppm * 1e-6));
+}
+
+/**
+ * @brief Advance one true second
+ */
+static void clock_tick(sim_clock_t *c) {
+    c->local_us += 1e6 * (1.0 + c->drift_ppm * 1e-6);
+    c->drift_ppm += c->wander_ppm * rnd_sym();
+    c->t_s++;
+}
+
+/**
+ * @brief PPS edge of the current second, captured by the ISR
+ */
+static int64_t clock_edge(const sim_clock_t *c) {
+    uint32_t lat = c->latency_max_us ? rnd(c->latency_max_us + 1) : 0;
+    return clock_local_at(c, 0.0) + lat;
+}
+
+/**
+ * @brief UTC error of the mapping at true second t_s + frac (us)
+ */
+static double utc_error_us(const systime_servo_t *s, const sim_clock_t *c, double frac_s) {
+    int64_t utc_us;
+    if (!systime_servo_to_utc(s, clock_local_at(c, frac_s), &utc_us)) return 1e9;
+    double truth_us = (double)(UTC_START_S + c->t_s) * 1e6 + frac_s * 1e6;
+    return (double)utc_us - truth_us;
+}
+
+/**
+ * @brief Feed edges until locked (or the limit)
+ * @return Seconds to lock, -1 if never
+ */
+static int run_to_lock(systime_servo_t *s, sim_clock_t *c, int limit_s) {
+    for (int i = 0; i < limit_s; i++) {
+        systime_servo_update(s, clock_edge(c), UTC_START_S + c->t_s);
+        if (s->state == SYSTIME_LOCKED) return i;
+        clock_tick(c);
+    }
+    return -1;
+}
+
+// --- SCENARIOS ---
+
+static void test_crystal(double ppm) {
+    systime_servo_t s;
+    sim_clock_t c;
+    char what[80];
+
+    systime_servo_reset(&s);
+    clock_init(&c, ppm, 0.0, 0);
+    int lock_s = run_to_lock(&s, &c, 60);
+    double drift_err_ppm = fabs(s.drift_ppb / 1000.0 + ppm / (1.0 + ppm * 1e-6));
+
+    snprintf(what, sizeof(what), "%+.0f ppm: locked after %d s (<= 6)", ppm, lock_s);
+    check(what, lock_s >= 0 && lock_s <= 6);
+    snprintf(what, sizeof(what), "%+.0f ppm: drift estimate off by %.3f ppm (< 0.5)", ppm, drift_err_ppm);
+    check(what, drift_err_ppm < 0.5);
+}
+
+static void test_wander_and_glitches(void) {
+    systime_servo_t s;
+    sim_clock_t c;
+    double sum2 = 0.0, max = 0.0;
+    int n = 0, glitches = 0, glitch_rejected = 0;
+    bool lock_kept = true;
+    char what[80];
+
+    printf("\n25 ppm + wander, 0-8 us ISR latency, 10 min, glitch every ~97 s:\n");
+    systime_servo_reset(&s);
+    clock_init(&c, 25.0, 0.02, 8);
+    run_to_lock(&s, &c, 60);
+    uint32_t steps = s.steps;
+
+    for (int i = 0; i < 600; i++) {
+        clock_tick(&c);
+        systime_servo_update(&s, clock_edge(&c), UTC_START_S + c.t_s);
+        if (s.state != SYSTIME_LOCKED) lock_kept = false;
+
+        if (i % 97 == 50) {
+            // Spurious edge 300 ms into the second, paired with the next UTC second
+            glitches++;
+            int64_t edge = clock_local_at(&c, 0.3);
+            if (!systime_servo_update(&s, edge, UTC_START_S + c.t_s + 1)) glitch_rejected++;
+        }
+
+        double e = utc_error_us(&s, &c, 0.5);
+        sum2 += e * e;
+        if (fabs(e) > max) max = fabs(e);
+        n++;
+    }
+    double rms = sqrt(sum2 / n);
+
+    snprintf(what, sizeof(what), "mid-second error rms %.2f us (< 10)", rms);
+    check(what, rms < 10.0);
+    snprintf(what, sizeof(what), "mid-second error max %.2f us (< 25)", max);
+    check(what, max < 25.0);
+    snprintf(what, sizeof(what), "%d glitch edges rejected, lock kept, no step", glitches);
+    check(what, glitch_rejected == glitches && lock_kept && s.steps == steps);
+}
+
+static void test_mispaired(void) {
+    systime_servo_t s;
+    sim_clock_t c;
+
+    printf("\nMispaired second:\n");
+    systime_servo_reset(&s);
+    clock_init(&c, -12.0, 0.0, 2);
+    run_to_lock(&s, &c, 60);
+
+    clock_tick(&c);
+    bool one = systime_servo_update(&s, clock_edge(&c), UTC_START_S + c.t_s + 1);
+    check("UTC one second off: rejected", !one && s.state == SYSTIME_LOCKED);
+
+    for (int i = 1; i < SYSTIME_MAX_REJECTS; i++) {
+        clock_tick(&c);
+        systime_servo_update(&s, clock_edge(&c), UTC_START_S + c.t_s + 1);
+    }
+    check("SYSTIME_MAX_REJECTS in a row: servo restarted", s.state == SYSTIME_FREQ_EST);
+
+    clock_tick(&c);
+    int lock_s = run_to_lock(&s, &c, 60);
+    check("locked again on correct pairs", lock_s >= 0);
+}
+
+static void test_holdover(int outage_s, double limit_us) {
+    systime_servo_t s;
+    sim_clock_t c;
+    char what[80];
+
+    systime_servo_reset(&s);
+    clock_init(&c, 25.0, 0.002, 4);
+    run_to_lock(&s, &c, 60);
+    for (int i = 0; i < 120; i++) {
+        clock_tick(&c);
+        systime_servo_update(&s, clock_edge(&c), UTC_START_S + c.t_s);
+    }
+
+    for (int i = 0; i < outage_s; i++) clock_tick(&c);
+    systime_servo_check(&s, clock_local_at(&c, 0.0));
+    double e = utc_error_us(&s, &c, 0.0);
+
+    snprintf(what, sizeof(what), "PPS lost %d s: holdover, error %.1f us (< %.0f)", outage_s, e, limit_us);
+    check(what, s.state == SYSTIME_HOLDOVER && fabs(e) < limit_us);
+
+    int lock_s = run_to_lock(&s, &c, 60);
+    snprintf(what, sizeof(what), "PPS back: locked again after %d s", lock_s);
+    check(what, lock_s >= 0);
+}
+
+static void test_monotonic(void) {
+    systime_servo_t s;
+    sim_clock_t c;
+    int64_t prev = INT64_MIN, utc;
+    uint32_t backwards = 0, conversions = 0;
+
+    printf("\nMonotonic mapping:\n");
+    systime_servo_reset(&s);
+    clock_init(&c, -38.0, 0.05, 8);
+    run_to_lock(&s, &c, 60);
+
+    // 1000 conversions per second, 200 s, anchor updated every second
+    for (int sec = 0; sec < 200; sec++) {
+        clock_tick(&c);
+        int64_t edge = clock_edge(&c);
+        for (int k = 0; k < 1000; k++) {     // Edge fed 5 ms late, as the NAV-PVT pairing does
+            int64_t local = clock_local_at(&c, k / 1000.0);
+            if (k == 5) systime_servo_update(&s, edge, UTC_START_S + c.t_s);
+            systime_servo_to_utc(&s, local, &utc);
+            if (utc < prev) backwards++;
+            prev = utc;
+            conversions++;
+        }
+    }
+    char what[80];
+    snprintf(what, sizeof(what), "%u conversions, UTC never goes backwards", (unsigned)conversions);
+    check(what, backwards == 0 && conversions >= 190000);
+}
+
+static void test_pre_lock_sample(void) {
+    systime_servo_t s;
+    sim_clock_t c;
+    int64_t utc;
+    char what[80];
+
+    systime_servo_reset(&s);
+    clock_init(&c, 33.0, 0.0, 3);
+    int64_t stamp = clock_local_at(&c, 0.25);      // Taken before the first edge is fed
+    int lock_s = run_to_lock(&s, &c, 60);
+
+    systime_servo_to_utc(&s, stamp, &utc);
+    double e = (double)utc - (double)UTC_START_S * 1e6 - 0.25e6;
+    snprintf(what, sizeof(what), "stamp %d s before the lock: error %.1f us (< 20)", lock_s, e);
+    check(what, lock_s >= 0 && fabs(e) < 20.0);
+}
+
+static void test_civil(void) {
+    printf("\nCivil time:\n");
+    check("1970-01-01 00:00:00 = 0", systime_civil_to_unix(1970, 1, 1, 0, 0, 0) == 0);
+    check("2000-01-01 00:00:00 = 946684800", systime_civil_to_unix(2000, 1, 1, 0, 0, 0) == 946684800LL);
+    check("2024-02-29 12:34:56 = 1709210096", systime_civil_to_unix(2024, 2, 29, 12, 34, 56) == 1709210096LL);
+    check("2026-10-18 23:59:59 = 1792367999", systime_civil_to_unix(2026, 10, 18, 23, 59, 59) == 1792367999LL);
+}
+
+static void bench_reads(void) {
+    systime_servo_t s;
+    sim_clock_t c;
+    volatile int64_t sink = 0;
+    int64_t utc;
+    struct timespec ts;
+
+    systime_servo_reset(&s);
+    clock_init(&c, 20.0, 0.0, 0);
+    run_to_lock(&s, &c, 60);
+    int64_t base = clock_local_at(&c, 0.0);
+
+    double t0 = now_ns();
+#ifdef HAVE_TSC
+    uint64_t c0 = __rdtsc();
+#endif
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        systime_servo_to_utc(&s, base + (i & 0xFFFFF), &utc);
+        sink = utc;
+    }
+#ifdef HAVE_TSC
+    uint64_t c1 = __rdtsc();
+#endif
+    double conv_ns = (now_ns() - t0) / BENCH_CALLS;
+
+    t0 = now_ns();
+    for (int i = 0; i < BENCH_CALLS; i++) {
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        sink = ts.tv_nsec;
+    }
+    double read_ns = (now_ns() - t0) / BENCH_CALLS;
+    (void)sink;
+
+    printf("\nRead cost (%d calls, host):\n", BENCH_CALLS);
+#ifdef HAVE_TSC
+    printf("  systime_servo_to_utc()      %6.2f ns  %6.1f TSC ticks\n", conv_ns, (double)(c1 - c0) / BENCH_CALLS);
+#else
+    printf("  systime_servo_to_utc()      %6.2f ns\n", conv_ns);
+#endif
+    printf("  clock_gettime() (reference) %6.2f ns\n", read_ns);
+}
+
+int main(void) {
+    printf("Crystal offset:\n");
+    test_crystal(40.0);
+    test_crystal(-40.0);
+    test_wander_and_glitches();
+    test_mispaired();
+    printf("\nHoldover:\n");
+    test_holdover(60, 100.0);
+    test_holdover(600, 1000.0);
+    test_monotonic();
+    printf("\nPre-lock stamp:\n");
+    test_pre_lock_sample();
+    test_civil();
+    bench_reads();
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}
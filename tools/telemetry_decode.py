@@ -0,0 +1,181 @@
+#!/usr/bin/env python3
+"""
+Decode sys_telemetry batches (MQTT payloads on topic frd/tlm).
+
+Usage:
+    mosquitto_sub -t frd/tlm -F %x > tlm.hex     # one hex payload per line
+    python3 tools/telemetry_decode.py tlm.hex [--csv] [--compare-json]
+
+    python3 tools/telemetry_decode.py --hex A70103...
+
+Each input line is one batch as hex. Output is one JSON object per frame,
+or CSV with --csv. --compare-json prints the binary size against the same
+frames serialized as compact JSON (the naive baseline).
+
+Wire format (see include/sys_telemetry.h):
+    batch := 0xA7 version count frame[count]
+    frame := varint(mask) varint(zigzag(delta)) for each bit set in mask
+The first frame of a batch is a keyframe (deltas against zero).
+"""
+
+import argparse
+import json
+import sys
+
+MAGIC = 0xA7
+
+# Must match TLM_FIELDS in include/sys_telemetry.h (wire order), per schema version
+SCHEMA_V1 = [
+    ("time_ms", "u32"),
+    ("mission", "u8"),
+    ("flags", "u16"),
+    ("batt_mv", "u16"),
+    ("batt_soc", "u8"),
+    ("load_front_g", "i32"),
+    ("load_left_g", "i32"),
+    ("load_right_g", "i32"),
+    ("dist_front_cm", "u16"),
+    ("dist_left_cm", "u16"),
+    ("dist_right_cm", "u16"),
+    ("lat_e7", "i32"),
+    ("lon_e7", "i32"),
+    ("heading_cdeg", "u16"),
+    ("speed_cm_s", "u16"),
+]
+
+SCHEMAS = {
+    1: SCHEMA_V1,
+    2: SCHEMA_V1 + [("health", "u16")],
+}
+
+# health_channel_t order (include/sys_health.h), 2 bits each
+HEALTH_CHANNELS = ["lc_front", "lc_left", "lc_right", "us_front", "us_left", "us_right", "batt"]
+HEALTH_STATUS = ["ok", "degraded", "failed", "?"]
+
+MISSION_STATES = ["STANDBY", "DISPATCH", "COURSE_LOCK", "FINE_APPROACH", "RESCUE", "RTH"]
+
+
+def read_varint(buf, pos):
+    value, shift = 0, 0
+    while True:
+        if pos >= len(buf):
+            raise ValueError("truncated varint")
+        b = buf[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if b < 0x80:
+            return value, pos
+        shift += 7
+        if shift > 35:
+            raise ValueError("varint too long")
+
+
+def unzigzag(v):
+    return (v >> 1) ^ -(v & 1)
+
+
+def to_type(v, kind):
+    v &= 0xFFFFFFFF
+    if kind == "i32" and v >= 0x80000000:
+        v -= 1 << 32
+    return v
+
+
+def decode_batch(buf):
+    if len(buf) < 3 or buf[0] != MAGIC:
+        raise ValueError("bad magic")
+    version, count = buf[1], buf[2]
+    if version not in SCHEMAS:
+        raise ValueError("unknown schema version %d" % version)
+    fields = SCHEMAS[version]
+
+    prev = [0] * len(fields)
+    frames = []
+    pos = 3
+    for _ in range(count):
+        mask, pos = read_varint(buf, pos)
+        cur = list(prev)
+        for i in range(len(fields)):
+            if mask & (1 << i):
+                d, pos = read_varint(buf, pos)
+                cur[i] = (prev[i] + unzigzag(d)) & 0xFFFFFFFF
+        prev = cur
+        fr = {name: to_type(v, kind) for (name, kind), v in zip(fields, cur)}
+        if "health" in fr:
+            for i, ch in enumerate(HEALTH_CHANNELS):
+                fr["health_" + ch] = HEALTH_STATUS[(fr["health"] >> (2 * i)) & 3]
+        frames.append(fr)
+    if pos != len(buf):
+        raise ValueError("%d trailing bytes" % (len(buf) - pos))
+    return frames
+
+
+def json_baseline(frame):
+    """Naive JSON a firmware would publish per sample (floats in natural units)."""
+    obj = {
+        "t": frame["time_ms"],
+        "state": MISSION_STATES[frame["mission"]] if frame["mission"] < len(MISSION_STATES) else frame["mission"],
+        "flags": frame["flags"],
+        "batt_v": round(frame["batt_mv"] / 1000.0, 2),
+        "soc": frame["batt_soc"],
+        "load": [frame["load_front_g"], frame["load_left_g"], frame["load_right_g"]],
+        "dist": [frame["dist_front_cm"], frame["dist_left_cm"], frame["dist_right_cm"]],
+        "lat": round(frame["lat_e7"] / 1e7, 7),
+        "lon": round(frame["lon_e7"] / 1e7, 7),
+        "hdg": round(frame["heading_cdeg"] / 100.0, 1),
+        "spd": round(frame["speed_cm_s"] / 100.0, 2),
+    }
+    return json.dumps(obj, separators=(",", ":"))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("file", nargs="?", help="file with one hex batch per line")
+    ap.add_argument("--hex", help="decode a single hex batch")
+    ap.add_argument("--csv", action="store_true", help="CSV output")
+    ap.add_argument("--compare-json", action="store_true", help="print size vs JSON baseline")
+    args = ap.parse_args()
+
+    if args.hex:
+        lines = [args.hex]
+    elif args.file:
+        with open(args.file) as f:
+            lines = f.read().split()
+    else:
+        lines = sys.stdin.read().split()
+
+    bin_bytes = json_bytes = n_frames = n_batches = 0
+    header_done = False
+    for line in lines:
+        try:
+            buf = bytes.fromhex(line.strip())
+            frames = decode_batch(buf)
+        except ValueError as e:
+            print("# skipped batch: %s" % e, file=sys.stderr)
+            continue
+
+        n_batches += 1
+        n_frames += len(frames)
+        bin_bytes += len(buf)
+        for fr in frames:
+            json_bytes += len(json_baseline(fr))
+            if args.compare_json:
+                continue
+            if args.csv:
+                if not header_done:
+                    print(",".join(fr.keys()))
+                    header_done = True
+                print(",".join(str(v) for v in fr.values()))
+            else:
+                print(json.dumps(fr))
+
+    if args.compare_json and n_frames:
+        print("batches=%d frames=%d" % (n_batches, n_frames))
+        print("binary : %6d bytes (%.1f B/frame, %.1f frames/batch)"
+              % (bin_bytes, bin_bytes / n_frames, n_frames / n_batches))
+        print("json   : %6d bytes (%.1f B/frame, one publish per frame)" % (json_bytes, json_bytes / n_frames))
+        print("ratio  : %.1fx smaller" % (json_bytes / bin_bytes))
+
+
+if __name__ == "__main__":
+    main()
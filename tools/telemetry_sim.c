@@ -0,0 +1,304 @@
+/**
+ * @file telemetry_sim.c
+ * @brief Host test of the telemetry batch encoder on a simulated 10 min cruise
+ * @details
+ * Drives tlm_encoder_*() with the same batching rule as the telemetry task
+ * (publish at TLM_BATCH_MAX_FRAMES or TLM_BATCH_MAX_AGE_MS, or when the
+ * next frame does not fit) over a 10 min cruise: dispatch, course lock at
+ * ~4 m/s with EKF position and heading noise, fine approach, a 40 s rescue
+ * with a person on the load cells, return home. The battery sags under
+ * throttle and the ultrasonic sensors see the bank on the way back.
+ * Checks, at 1 Hz and 10 Hz:
+ * - every batch decodes on its own and reproduces every frame exactly;
+ * - every batch fits TLM_BATCH_MAX_BYTES;
+ * - the binary stream is at least 6x smaller than the JSON baseline;
+ * then reports payload bytes/s and publishes/min for both. The JSON
+ * baseline is json_baseline() in tools/telemetry_decode.py (one compact
+ * JSON publish per sample).
+ *
+ * Build & run (from the repo root):
+ *   gcc -O2 -Iinclude -Itools/host tools/telemetry_sim.c src/sys_telemetry_codec.c -lm -o telemetry_sim
+ *   ./telemetry_sim
+ *
+ * Returns non-zero if a check fails.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "sys_telemetry.h"
+
+#define CRUISE_S        600
+#define HOME_LAT_E7     473977000
+#define HOME_LON_E7     85456000
+#define M_PER_DEG_LAT   111195.0
+#define MIN_RATIO       6.0
+
+static uint32_t rng_state = 12345;
+static int failures = 0;
+
+static const char *const MISSION_STATES[] = {
+    "STANDBY", "DISPATCH", "COURSE_LOCK", "FINE_APPROACH", "RESCUE", "RTH",
+};
+
+typedef struct {
+    uint64_t bin_bytes;
+    uint64_t json_bytes;
+    uint32_t frames;
+    uint32_t batches;
+    uint32_t max_batch;
+    uint32_t mismatches;
+    uint32_t decode_errors;
+} run_stats_t;
+
+// --- HELPERS ---
+
+static uint32_t rnd(void) {
+    rng_state = rng_state * 1664525u + 1013904223u;
+    return rng_state >> 8;
+}
+
+static double uniform(void) { return (double)rnd() / (double)(1u << 24); }
+
+static double gauss(void) {
+    return (uniform() + uniform() + uniform() + uniform() - 2.0) * 1.7320508;
+}
+
+static void check(const char *what, int ok) {
+    printf("  %-58s %s\n", what, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static size_t get_varint(const uint8_t *p, size_t len, size_t pos, uint32_t *v) {
+    uint32_t value = 0;
+    for (int shift = 0; shift < 35 && pos < len; shift += 7) {
+        uint8_t b = p[pos++];
+        value |= (uint32_t)(b & 0x7F) << shift;
+        if (!(b & 0x80)) {
+            *v = value;
+            return pos;
+        }
+    }
+    return 0;
+}
+
+static void flatten(const tlm_state_t *s, int32_t *out) {
+    int i = 0;
+#define TLM_FLATTEN_FIELD(name, type, unit) out[i++] = (int32_t)s->name;
+    TLM_FIELDS(TLM_FLATTEN_FIELD)
+#undef TLM_FLATTEN_FIELD
+}
+
+/**
+ * @brief Decode one batch (mirror of decode_batch() in telemetry_decode.py)
+ * @return Frames decoded, -1 on a malformed batch
+ */
+static int decode_batch(const uint8_t *p, size_t len, int32_t out[][TLM_FIELD_COUNT]) {
+    if (len < TLM_BATCH_HEADER_BYTES || p[0] != TLM_MAGIC || p[1] != TLM_SCHEMA_VERSION) return -1;
+    int32_t prev[TLM_FIELD_COUNT] = { 0 };
+    size_t pos = TLM_BATCH_HEADER_BYTES;
+    for (int f = 0; f < p[2]; f++) {
+        uint32_t mask, d;
+        if ((pos = get_varint(p, len, pos, &mask)) == 0) return -1;
+        for (int i = 0; i < TLM_FIELD_COUNT; i++) {
+            if (mask & (1u << i)) {
+                if ((pos = get_varint(p, len, pos, &d)) == 0) return -1;
+                prev[i] = (int32_t)((uint32_t)prev[i] + ((d >> 1) ^ (0u - (d & 1))));
+            }
+        }
+        memcpy(out[f], prev, sizeof(prev));
+    }
+    return pos == len ? p[2] : -1;
+}
+
+// Python float repr of round(x, places): shortest digits, at least one decimal
+static int fmt_round(char *out, size_t n, double x, int places) {
+    int len = snprintf(out, n, "%.*f", places, x);
+    while (len > 2 && out[len - 1] == '0' && out[len - 2] != '.') out[--len] = '\0';
+    return len;
+}
+
+// Length of json_baseline() in tools/telemetry_decode.py for one frame
+static size_t json_len(const tlm_state_t *s) {
+    char batt[24], lat[24], lon[24], hdg[24], spd[24], buf[384];
+    fmt_round(batt, sizeof(batt), s->batt_mv / 1000.0, 2);
+    fmt_round(lat, sizeof(lat), s->lat_e7 / 1e7, 7);
+    fmt_round(lon, sizeof(lon), s->lon_e7 / 1e7, 7);
+    fmt_round(hdg, sizeof(hdg), s->heading_cdeg / 100.0, 1);
+    fmt_round(spd, sizeof(spd), s->speed_cm_s / 100.0, 2);
+    int len = snprintf(buf, sizeof(buf),
+                       "{\"t\":%u,\"state\":\"%s\",\"flags\":%u,\"batt_v\":%s,\"soc\":%u,"
+                       "\"load\":[%d,%d,%d],\"dist\":[%u,%u,%u],"
+                       "\"lat\":%s,\"lon\":%s,\"hdg\":%s,\"spd\":%s}",
+                       (unsigned)s->time_ms, MISSION_STATES[s->mission], (unsigned)s->flags,
+                       batt, (unsigned)s->batt_soc,
+                       (int)s->load_front_g, (int)s->load_left_g, (int)s->load_right_g,
+                       (unsigned)s->dist_front_cm, (unsigned)s->dist_left_cm,
+                       (unsigned)s->dist_right_cm, lat, lon, hdg, spd);
+    return (size_t)len;
+}
+
+// --- CRUISE MODEL ---
+
+typedef struct {
+    double east_m, north_m;     // True position from home
+    double heading_deg;
+    double speed_ms;
+    double batt_v;
+    double soc;
+    double person_g;            // Load carried after pickup
+} craft_t;
+
+/**
+ * @brief Advance the craft by dt and sample it like the fill callback would
+ * @details Phases: 0-10 s dispatch, to 280 s course lock outbound,
+ * to 320 s fine approach, to 360 s rescue, then return home.
+ */
+static void cruise_step(craft_t *c, double t, double dt, uint32_t boot_ms, tlm_state_t *s) {
+    uint8_t mission;
+    double target_speed, target_heading;
+
+    if (t < 10.0)       { mission = 1; target_speed = 0.0; target_heading = 35.0; }
+    else if (t < 280.0) { mission = 2; target_speed = 4.0; target_heading = 35.0; }
+    else if (t < 320.0) { mission = 3; target_speed = 0.8; target_heading = 50.0; }
+    else if (t < 360.0) { mission = 4; target_speed = 0.0; target_heading = 50.0; }
+    else                { mission = 5; target_speed = 3.5; target_heading = 217.0; }
+
+    // First-order response of speed and heading, wave-induced yaw wobble
+    double dh = fmod(target_heading - c->heading_deg + 540.0, 360.0) - 180.0;
+    c->heading_deg = fmod(c->heading_deg + dh * (1.0 - exp(-dt / 3.0)) + 360.0, 360.0);
+    c->speed_ms += (target_speed - c->speed_ms) * (1.0 - exp(-dt / 4.0));
+    double yaw = c->heading_deg + 2.0 * sin(t * 1.3);
+    c->east_m += c->speed_ms * sin(yaw * M_PI / 180.0) * dt;
+    c->north_m += c->speed_ms * cos(yaw * M_PI / 180.0) * dt;
+    if (t >= 330.0 && t < 360.0) c->person_g += (72000.0 - c->person_g) * (1.0 - exp(-dt / 2.0));
+
+    // Battery: ~40 A at cruise, internal resistance sag
+    double amps = 3.0 + 10.0 * c->speed_ms;
+    c->soc -= amps * dt / (3600.0 * 50.0) * 100.0;
+    c->batt_v = 14.2 + 2.6 * (c->soc / 100.0) - 0.012 * amps;
+
+    memset(s, 0, sizeof(*s));
+    s->time_ms = boot_ms + (uint32_t)(t * 1000.0) + (rnd() % 3);
+    s->mission = mission;
+    s->flags = TLM_FLAG_GPS_FIX | TLM_FLAG_GPS_AIDED | TLM_FLAG_IN_FENCE | TLM_FLAG_CTRL_RUNNING;
+    if (c->person_g > 5000.0) s->flags |= TLM_FLAG_HUMAN_LEFT;
+    s->batt_mv = (uint16_t)lround(c->batt_v * 1000.0 + 8.0 * gauss());
+    s->batt_soc = (uint8_t)lround(c->soc);
+
+    // Load cells: spray and slamming on the empty platform, split load after pickup
+    s->load_front_g = (int32_t)lround(0.2 * c->person_g + 40.0 * gauss());
+    s->load_left_g = (int32_t)lround(0.5 * c->person_g + 40.0 * gauss());
+    s->load_right_g = (int32_t)lround(0.3 * c->person_g + 40.0 * gauss());
+
+    // Ultrasonics: open water out of range, bank in view on the last 30 s
+    s->dist_front_cm = 0xFFFF;
+    s->dist_left_cm = 0xFFFF;
+    s->dist_right_cm = 0xFFFF;
+    if (t > CRUISE_S - 30.0) {
+        s->dist_front_cm = (uint16_t)lround(400.0 - 10.0 * (t - (CRUISE_S - 30.0)) + 3.0 * gauss());
+        s->dist_right_cm = (uint16_t)lround(250.0 + 3.0 * gauss());
+    }
+
+    // EKF output: 0.15 m position noise, 0.5 deg heading, 5 cm/s speed
+    double north = c->north_m + 0.15 * gauss();
+    double east = c->east_m + 0.15 * gauss();
+    s->lat_e7 = HOME_LAT_E7 + (int32_t)lround(north / M_PER_DEG_LAT * 1e7);
+    s->lon_e7 = HOME_LON_E7 + (int32_t)lround(east / (M_PER_DEG_LAT * cos(47.3977 * M_PI / 180.0)) * 1e7);
+    s->heading_cdeg = (uint16_t)(lround((yaw + 0.5 * gauss() + 360.0) * 100.0) % 36000);
+    double spd = c->speed_ms * 100.0 + 5.0 * gauss();
+    s->speed_cm_s = (uint16_t)(spd > 0.0 ? lround(spd) : 0);
+    s->health = 0;
+}
+
+// --- SCENARIOS ---
+
+static void publish(const tlm_encoder_t *enc, const tlm_state_t *sent, int n_sent, run_stats_t *st) {
+    static int32_t decoded[TLM_BATCH_MAX_FRAMES][TLM_FIELD_COUNT];
+    size_t len;
+    const uint8_t *data = tlm_encoder_data(enc, &len);
+    if (len == 0) return;
+
+    st->batches++;
+    st->bin_bytes += len;
+    if (len > st->max_batch) st->max_batch = (uint32_t)len;
+
+    int n = decode_batch(data, len, decoded);
+    if (n != n_sent) {
+        st->decode_errors++;
+        return;
+    }
+    for (int f = 0; f < n; f++) {
+        int32_t ref[TLM_FIELD_COUNT];
+        flatten(&sent[f], ref);
+        if (memcmp(ref, decoded[f], sizeof(ref)) != 0) st->mismatches++;
+    }
+}
+
+static run_stats_t run_cruise(uint16_t rate_hz) {
+    static tlm_state_t pending[TLM_BATCH_MAX_FRAMES];
+    run_stats_t st = { 0 };
+    craft_t craft = { .heading_deg = 35.0, .soc = 96.0 };
+    tlm_encoder_t enc;
+    uint32_t period_ms = 1000 / rate_hz;
+    uint32_t boot_ms = 41250;   // Mission starts a while after boot
+    int n_pending = 0;
+    tlm_state_t s;
+
+    tlm_encoder_reset(&enc);
+    for (uint32_t k = 0; k < (uint32_t)CRUISE_S * rate_hz; k++) {
+        cruise_step(&craft, k * period_ms / 1000.0, period_ms / 1000.0, boot_ms, &s);
+
+        // Same batching rule as telemetry_task() in src/sys_telemetry.c
+        if (!tlm_encoder_add(&enc, &s)) {
+            publish(&enc, pending, n_pending, &st);
+            tlm_encoder_reset(&enc);
+            n_pending = 0;
+            tlm_encoder_add(&enc, &s);
+        }
+        pending[n_pending++] = s;
+        st.frames++;
+        st.json_bytes += json_len(&s);
+
+        if (enc.count >= TLM_BATCH_MAX_FRAMES ||
+            s.time_ms - enc.first_ms + period_ms >= TLM_BATCH_MAX_AGE_MS) {
+            publish(&enc, pending, n_pending, &st);
+            tlm_encoder_reset(&enc);
+            n_pending = 0;
+        }
+    }
+    publish(&enc, pending, n_pending, &st);
+    return st;
+}
+
+static void scenario_cruise(uint16_t rate_hz) {
+    char what[96];
+    printf("\n10 min cruise @ %u Hz\n", rate_hz);
+    rng_state = 12345;
+    run_stats_t st = run_cruise(rate_hz);
+    double ratio = (double)st.json_bytes / (double)st.bin_bytes;
+
+    snprintf(what, sizeof(what), "%u frames in %u batches decode exactly", st.frames, st.batches);
+    check(what, st.decode_errors == 0 && st.mismatches == 0);
+    snprintf(what, sizeof(what), "largest batch %u B <= %d B", st.max_batch, TLM_BATCH_MAX_BYTES);
+    check(what, st.max_batch <= TLM_BATCH_MAX_BYTES);
+    snprintf(what, sizeof(what), "binary %.1fx smaller than JSON (>= %.0fx)", ratio, MIN_RATIO);
+    check(what, ratio >= MIN_RATIO);
+
+    printf("    binary : %7.1f B/s  %5.1f B/frame  %5.1f publishes/min\n",
+           (double)st.bin_bytes / CRUISE_S, (double)st.bin_bytes / st.frames,
+           st.batches * 60.0 / CRUISE_S);
+    printf("    json   : %7.1f B/s  %5.1f B/frame  %5.1f publishes/min\n",
+           (double)st.json_bytes / CRUISE_S, (double)st.json_bytes / st.frames,
+           st.frames * 60.0 / CRUISE_S);
+}
+
+int main(void) {
+    printf("Telemetry encoder: %d fields, schema v%d\n", TLM_FIELD_COUNT, TLM_SCHEMA_VERSION);
+    scenario_cruise(1);
+    scenario_cruise(10);
+
+    printf("\n%s\n", failures == 0 ? "OK" : "FAILED");
+    return failures == 0 ? 0 : 1;
+}